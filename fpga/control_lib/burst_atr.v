@@ -0,0 +1,92 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Automatic transmit/receive control of the lines of one frontend, from
+//! the bursts of its DSPs, as gpio_atr with the state stretched in time.
+//! TX is on lead ticks ahead of the time of a pending timed burst, while
+//! the TX DSP runs and for lag ticks after it stops. RX is on while an RX
+//! DSP runs. Each masked line takes its value for the {tx, rx} state from
+//! the table, the others follow manual.
+//!
+//! Registers:
+//!  BASE+0 [W-1:0] idle, [2W-1:W] rx, [3W-1:2W] tx, [4W-1:3W] full duplex
+//!         values, [5W-1:4W] the lines under the control of the bursts
+//!  BASE+1 [15:0] lead, [31:16] lag ticks
+
+module burst_atr
+  #(parameter BASE = 0,
+    parameter WIDTH = 2)
+   (input clk, input reset,
+    input set_stb, input [7:0] set_addr, input [31:0] set_data,
+    input [63:0] vita_time,
+    input tx_run, input tx_pending, input [63:0] tx_time,
+    input rx_run,
+    input [WIDTH-1:0] manual,
+    output reg [WIDTH-1:0] lines);
+
+   wire [5*WIDTH-1:0] atr_table;
+   wire [31:0] 	      timing;
+   setting_reg #(.my_addr(BASE+0), .width(5*WIDTH)) sr_table
+     (.clk(clk),.rst(reset),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(atr_table),.changed());
+
+   setting_reg #(.my_addr(BASE+1)) sr_timing
+     (.clk(clk),.rst(reset),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(timing),.changed());
+
+   wire [15:0] lead = timing[15:0];
+   wire [15:0] lag = timing[31:16];
+
+   // the pending time is one cycle behind lead_time, so is the compare
+   reg [63:0] lead_time;
+   reg 	      pending_d, lead_hit;
+   always @(posedge clk)
+     begin
+	lead_time <= tx_time - lead;
+	pending_d <= tx_pending;
+	lead_hit <= pending_d & tx_pending & (vita_time >= lead_time);
+     end
+
+   reg [15:0] lag_count;
+   always @(posedge clk)
+     if(reset)
+       lag_count <= 0;
+     else if(tx_run)
+       lag_count <= lag;
+     else if(lag_count != 0)
+       lag_count <= lag_count - 16'd1;
+
+   wire tx = tx_run | lead_hit | (lag_count != 0);
+   wire rx = rx_run;
+
+   reg [WIDTH-1:0] state_lines;
+   always @*
+     case({tx,rx})
+       2'b00: state_lines = atr_table[WIDTH-1:0];
+       2'b01: state_lines = atr_table[2*WIDTH-1:WIDTH];
+       2'b10: state_lines = atr_table[3*WIDTH-1:2*WIDTH];
+       2'b11: state_lines = atr_table[4*WIDTH-1:3*WIDTH];
+     endcase // case ({tx,rx})
+
+   wire [WIDTH-1:0] mask = atr_table[5*WIDTH-1:4*WIDTH];
+   always @(posedge clk)
+     if(reset)
+       lines <= manual;
+     else
+       lines <= (mask & state_lines) | (~mask & manual);
+
+endmodule // burst_atr
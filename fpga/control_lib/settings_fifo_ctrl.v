@@ -22,7 +22,10 @@ module settings_fifo_ctrl
         parameter XPORT_HDR = 1, //extra transport hdr line
         parameter PROT_DEST = 0, //protocol framer destination
         parameter PROT_HDR = 1, //needs a protocol header?
-        parameter ACK_SID = 0 //stream ID for packet ACK
+        parameter ACK_SID = 0, //stream ID for packet ACK, its low half carries the command fifo fill
+        parameter [15:0] SNAPSHOT_MASK = 0, //odd words whose peek latches the word below into snapshot
+        parameter ACK_PACK = 1, //results of up to this many commands of a packet share an ack packet (1 to 16)
+        parameter CMD_FIFO_SIZE = 4 //log2 of the command fifo lines, above 4 it goes to block RAM
     )
     (
         //clock and synchronous reset for all interfaces
@@ -61,6 +64,12 @@ module settings_fifo_ctrl
         input [31:0] word14,
         input [31:0] word15,
 
+        //upper half of a 64-bit pair, sampled with the lower half read last
+        output [31:0] snapshot,
+
+        //command fifo lines in [31:16], lines holding a command in [15:0]
+        output [31:0] queue_status,
+
         //debug output
         output [31:0] debug
     );
@@ -71,6 +80,7 @@ module settings_fifo_ctrl
     //------------------------------------------------------------------
     //-- The command fifo:
     //-- Stores an individual register access command per line.
+    //-- A deep one holds long schedules of timed commands.
     //------------------------------------------------------------------
     wire [63:0] in_command_ticks, out_command_ticks;
     wire [31:0] in_command_hdr, out_command_hdr;
@@ -79,13 +89,42 @@ module settings_fifo_ctrl
     wire command_fifo_full, command_fifo_empty;
     wire command_fifo_read, command_fifo_write;
 
-    shortfifo #(.WIDTH(129)) command_fifo (
-        .clk(clock), .rst(reset), .clear(clear),
-        .datain({in_command_ticks, in_command_hdr, in_command_data, in_command_has_time}),
-        .dataout({out_command_ticks, out_command_hdr, out_command_data, out_command_has_time}),
-        .write(command_fifo_write), .full(command_fifo_full), //input interface
-        .empty(command_fifo_empty), .read(command_fifo_read)  //output interface
-    );
+    //the block RAM fifo keeps two lines free
+    localparam [15:0] CMD_FIFO_LINES = (CMD_FIFO_SIZE > 4)? (1 << CMD_FIFO_SIZE) - 2 : 16;
+
+    generate
+    if (CMD_FIFO_SIZE > 4) begin
+        wire command_fifo_ready, command_fifo_valid;
+        axi_fifo #(.WIDTH(129), .SIZE(CMD_FIFO_SIZE)) command_fifo (
+            .clk(clock), .reset(reset), .clear(clear),
+            .i_tdata({in_command_ticks, in_command_hdr, in_command_data, in_command_has_time}),
+            .i_tvalid(command_fifo_write), .i_tready(command_fifo_ready), //input interface
+            .o_tdata({out_command_ticks, out_command_hdr, out_command_data, out_command_has_time}),
+            .o_tvalid(command_fifo_valid), .o_tready(command_fifo_read), //output interface
+            .space(), .occupied()
+        );
+        assign command_fifo_full = ~command_fifo_ready;
+        assign command_fifo_empty = ~command_fifo_valid;
+    end
+    else begin
+        shortfifo #(.WIDTH(129)) command_fifo (
+            .clk(clock), .rst(reset), .clear(clear),
+            .datain({in_command_ticks, in_command_hdr, in_command_data, in_command_has_time}),
+            .dataout({out_command_ticks, out_command_hdr, out_command_data, out_command_has_time}),
+            .write(command_fifo_write), .full(command_fifo_full), //input interface
+            .empty(command_fifo_empty), .read(command_fifo_read)  //output interface
+        );
+    end
+    endgenerate
+
+    //exact fill level for the host window, the fifo counters are diagnostics only
+    reg [15:0] command_fill;
+    assign queue_status = {CMD_FIFO_LINES, command_fill};
+    always @(posedge clock) begin
+        if (reset || clear) command_fill <= 0;
+        else if (command_fifo_write && ~command_fifo_read) command_fill <= command_fill + 1;
+        else if (command_fifo_read && ~command_fifo_write) command_fill <= command_fill - 1;
+    end
 
     //------------------------------------------------------------------
     //-- The result fifo:
@@ -104,9 +143,27 @@ module settings_fifo_ctrl
         .empty(result_fifo_empty), .read(result_fifo_read)  //output interface
     );
 
+    //------------------------------------------------------------------
+    //-- The ack fifo:
+    //-- Stores the number of results per ack packet, one line per packet.
+    //------------------------------------------------------------------
+    wire [4:0] in_ack_len, out_ack_len;
+    wire ack_fifo_full, ack_fifo_empty;
+    wire ack_fifo_read, ack_fifo_write;
+
+    shortfifo #(.WIDTH(5)) ack_fifo (
+        .clk(clock), .rst(reset), .clear(clear),
+        .datain(in_ack_len), .dataout(out_ack_len),
+        .write(ack_fifo_write), .full(ack_fifo_full), //input interface
+        .empty(ack_fifo_empty), .read(ack_fifo_read)  //output interface
+    );
+
     //------------------------------------------------------------------
     //-- Input state machine:
     //-- Read input packet and fill a command fifo entry.
+    //-- A packet may carry several (hdr, data) command pairs after the
+    //-- VITA header, they share its time. Their results are ack'd up to
+    //-- ACK_PACK at a time, so a burst of readbacks comes back together.
     //------------------------------------------------------------------
     localparam READ_LINE0     = 0;
     localparam VITA_HDR       = 1;
@@ -118,8 +175,8 @@ module settings_fifo_ctrl
     localparam VITA_TSF1      = 7;
     localparam READ_HDR       = 8;
     localparam READ_DATA      = 9;
-    localparam WAIT_EOF       = 10;
-    localparam STORE_CMD      = 11;
+    localparam STORE_CMD      = 10;
+    localparam CLOSE_ACK      = 11;
 
     localparam START_STATE = (XPORT_HDR)? READ_LINE0 : VITA_HDR;
 
@@ -133,9 +190,17 @@ module settings_fifo_ctrl
     wire has_tsi = in_data[23:22] != 0;
     wire has_tsf = in_data[21:20] != 0;
     reg has_sid_reg, has_cid_reg, has_tsi_reg, has_tsf_reg;
+    reg in_last_reg; //the stored command ends the packet
+    reg [4:0] ack_count; //commands stored since the last ack fifo entry
+
+    //the stored command closes its ack packet at the end of the input packet or ACK_PACK commands
+    wire ack_end = in_last_reg || (ack_count == ACK_PACK-1);
+    wire store_go = (in_state == STORE_CMD) && ~command_fifo_full && ~(ack_end && ack_fifo_full);
 
     assign in_ready = (in_state < STORE_CMD);
-    assign command_fifo_write  = (in_state == STORE_CMD);
+    assign command_fifo_write  = store_go;
+    assign ack_fifo_write = (store_go && ack_end) || (in_state == CLOSE_ACK && ack_count != 0 && ~ack_fifo_full);
+    assign in_ack_len = (in_state == CLOSE_ACK)? ack_count : ack_count + 1;
     assign in_command_ticks    = in_ticks_reg;
     assign in_command_data     = in_data_reg;
     assign in_command_hdr      = in_hdr_reg;
@@ -144,6 +209,7 @@ module settings_fifo_ctrl
     always @(posedge clock) begin
         if (reset) begin
             in_state <= START_STATE;
+            ack_count <= 0;
         end
         else begin
             case (in_state)
@@ -205,21 +271,25 @@ module settings_fifo_ctrl
             end
 
             READ_HDR: begin
-                if (reading) in_state <= READ_DATA;
+                //a dangling hdr without data is dropped, the acks before it still go out
+                if (reading) in_state <= (in_data[33])? CLOSE_ACK : READ_DATA;
                 in_hdr_reg <= in_data[31:0];
             end
 
             READ_DATA: begin
-                if (reading) in_state <= (in_data[33])? STORE_CMD : WAIT_EOF;
+                if (reading) in_state <= STORE_CMD;
                 in_data_reg <= in_data[31:0];
+                in_last_reg <= in_data[33];
             end
 
-            WAIT_EOF: begin
-                if (reading && in_data[33]) in_state <= STORE_CMD;
+            STORE_CMD: begin
+                if (store_go) in_state <= (in_last_reg)? START_STATE : READ_HDR;
+                if (store_go) ack_count <= (ack_end)? 0 : ack_count + 1;
             end
 
-            STORE_CMD: begin
-                if (~command_fifo_full) in_state <= START_STATE;
+            CLOSE_ACK: begin
+                if (ack_count == 0 || ~ack_fifo_full) in_state <= START_STATE;
+                if (ack_count == 0 || ~ack_fifo_full) ack_count <= 0;
             end
 
             endcase //in_state
@@ -323,9 +393,36 @@ module settings_fifo_ctrl
         endcase // case(addr_reg[3:0])
     end
 
+    //------------------------------------------------------------------
+    //-- 64-bit snapshot:
+    //-- The even word of a pair is sampled on the same clock as rb_data,
+    //-- a peek of an odd word in SNAPSHOT_MASK keeps it for a later peek.
+    //------------------------------------------------------------------
+    reg [31:0] rb_pair, snapshot_reg;
+    assign snapshot = snapshot_reg;
+
+    always @(posedge clock) begin
+        case (out_command_hdr[3:1])
+            0 : rb_pair <= word00;
+            1 : rb_pair <= word02;
+            2 : rb_pair <= word04;
+            3 : rb_pair <= word06;
+            4 : rb_pair <= word08;
+            5 : rb_pair <= word10;
+            6 : rb_pair <= word12;
+            7 : rb_pair <= word14;
+        endcase // case(addr_reg[3:1])
+    end
+
+    always @(posedge clock) begin
+        if (reset) snapshot_reg <= 0;
+        else if (action && ~poke && SNAPSHOT_MASK[command_hdr_reg[3:0]]) snapshot_reg <= rb_pair;
+    end
+
     //------------------------------------------------------------------
     //-- Output state machine:
-    //-- Read a command fifo entry, act on it, produce ack packet.
+    //-- Read the result fifo entries of an ack packet, produce the packet.
+    //-- A packet may stall between results while its commands execute.
     //------------------------------------------------------------------
     localparam WRITE_PROT_HDR = 0;
     localparam WRITE_VRT_HDR  = 1;
@@ -337,16 +434,25 @@ module settings_fifo_ctrl
     localparam WRITE_PKT_HDR = (PROT_HDR)? WRITE_PROT_HDR : WRITE_VRT_HDR;
 
     reg [2:0] out_state;
+    reg [4:0] out_results; //results written in the current packet
+    wire out_last = (out_results == out_ack_len - 1);
 
-    assign out_valid = ~result_fifo_empty;
-    assign result_fifo_read = out_data[33] && writing;
+    assign out_valid = ~result_fifo_empty && ~ack_fifo_empty;
+    assign result_fifo_read = (out_state == WRITE_RB_DATA) && writing;
+    assign ack_fifo_read = out_data[33] && writing;
 
     always @(posedge clock) begin
-        if (reset) begin
+        if (reset || clear) begin
             out_state <= WRITE_PKT_HDR;
+            out_results <= 0;
         end
         else if (writing && out_data[33]) begin
             out_state <= WRITE_PKT_HDR;
+            out_results <= 0;
+        end
+        else if (writing && out_state == WRITE_RB_DATA) begin
+            out_state <= WRITE_RB_HDR;
+            out_results <= out_results + 1;
         end
         else if (writing) begin
             out_state <= out_state + 1;
@@ -357,7 +463,7 @@ module settings_fifo_ctrl
     //-- assign to output fifo interface
     //------------------------------------------------------------------
     wire [31:0] prot_hdr;
-    assign prot_hdr[15:0] = 16; //bytes in proceeding vita packet
+    assign prot_hdr[15:0] = 8 + {out_ack_len, 3'b0}; //bytes in proceeding vita packet
     assign prot_hdr[16] = 1; //yes frame
     assign prot_hdr[18:17] = PROT_DEST;
     assign prot_hdr[31:19] = 0; //nothing
@@ -367,7 +473,7 @@ module settings_fifo_ctrl
         case (out_state)
             WRITE_PROT_HDR: out_data_int <= prot_hdr;
             WRITE_VRT_HDR:  out_data_int <= {12'b010100000000, out_result_hdr[19:16], 2'b0, prot_hdr[15:2]};
-            WRITE_VRT_SID:  out_data_int <= ACK_SID;
+            WRITE_VRT_SID:  out_data_int <= {ACK_SID[31:16], command_fill};
             WRITE_RB_HDR:   out_data_int <= out_result_hdr;
             WRITE_RB_DATA:  out_data_int <= out_result_data;
             default:        out_data_int <= 0;
@@ -375,7 +481,7 @@ module settings_fifo_ctrl
     end
 
     assign out_data[35:34] = 2'b0;
-    assign out_data[33] = (out_state == WRITE_RB_DATA);
+    assign out_data[33] = (out_state == WRITE_RB_DATA) && out_last;
     assign out_data[32] = (out_state == WRITE_PKT_HDR);
     assign out_data[31:0] = out_data_int;
 
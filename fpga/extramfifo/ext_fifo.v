@@ -60,6 +60,7 @@ module ext_fifo
      output src1_rdy_o,               // not EMPTY
      input dst1_rdy_i,                 // READ
      output [INT_WIDTH-1:0] dataout_1,
+     input [FIFO_DEPTH-1:0] split,       // RAM words owned by TX0, the rest go to TX1
      output reg [31:0] debug,
      output reg [31:0] debug2
      );
@@ -126,6 +127,7 @@ module ext_fifo
 	   .read_strobe_1(~almost_full2_spread_1),
 	   .capacity_1(capacity_1),
 	   .data_avail_1(data_avail_1),
+	   .split(split),
 	   .data_avail(data_avail),
 	   .capacity(capacity)
 	   );
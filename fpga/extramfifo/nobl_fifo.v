@@ -49,6 +49,7 @@ module nobl_fifo
 	input read_strobe_1,                    // Triggers a read, result in approximately 6 cycles.
 	output reg [FIFO_DEPTH-1:0] capacity_1,
 	output  data_avail_1,                    // Qulaifys read data available this cycle on read_data_1.
+	input [FIFO_DEPTH-1:0] split,          // TX0 owns [0, split), TX1 owns [split, top], applied on rst.
 `endif // !`ifdef LMS602D_FRONTEND
 	output  data_avail,                    // Qulaifys read data available this cycle on read_data.
 	output reg [FIFO_DEPTH-1:0] capacity
@@ -86,6 +87,16 @@ module nobl_fifo
    assign 	    read_dual_ch_1 = (read_strobe && read_strobe_1) ? ((queue_rd) ? read_one_ch_1 : 1'b0 ): read_one_ch_1;
    assign 	    read_1 = (data_avail_int && data_avail_int_1) ? read_dual_ch_1 : read_one_ch_1;
    assign 	    write_1 = write_strobe_1 && space_avail_1;
+
+   // Pointer advance for reads that are not stalled by a collision
+   wire rd_advance = ~(write | write_1 | read_1) && read;
+   wire rd_advance_1 = ~(write_1 | write | read) && read_1;
+
+   // Capacity of each region when empty (and one less), sized to FIFO_DEPTH
+   wire [FIFO_DEPTH-1:0] empty_cap = split - 1;
+   wire [FIFO_DEPTH-1:0] almost_empty_cap = split - 2;
+   wire [FIFO_DEPTH-1:0] empty_cap_1 = ~split;
+   wire [FIFO_DEPTH-1:0] almost_empty_cap_1 = ~split - 1;
 `endif // !`ifdef LMS602D_FRONTEND
 
    // When a read and write collision occur, supress the space_avail flag next cycle
@@ -121,15 +132,15 @@ module nobl_fifo
    always @(posedge clk)
      if (rst)
        begin
-	  capacity <= (1 << (FIFO_DEPTH-1)) - 1;
+	  capacity <= empty_cap;
 	  wr_pointer <= 0;
 	  rd_pointer <= 0;
 	  space_avail_out <= 1;
 	  data_avail_int <= 0;
      
-	  capacity_1 <= (1 << (FIFO_DEPTH-1)) - 1;
-	  wr_pointer_1 <= 0;
-	  rd_pointer_1 <= 0;
+	  capacity_1 <= empty_cap_1;
+	  wr_pointer_1 <= split;
+	  rd_pointer_1 <= split;
 	  space_avail_1_out <= 1;
 	  data_avail_int_1 <= 0;
      
@@ -144,22 +155,20 @@ module nobl_fifo
 	  // Capacity is already zero; Capacity is 1 and write is asserted (lookahead); both read and write are asserted (collision)
 	  space_avail_out <= ~((capacity == 0) || (read&&write) || ((capacity == 1) && write) );
 	  // Capacity has 1 cycle delay so look ahead here for corner case of read of last item in FIFO.
-	  data_avail_int <= ~((capacity == ((1 << (FIFO_DEPTH-1))-1))  || ((capacity == ((1 << (FIFO_DEPTH-1))-2)) && (~(write | write_1) && read))  );
-	  wr_pointer[FIFO_DEPTH-1] <= 1'b0;
-	  wr_pointer[FIFO_DEPTH-2:0] <= wr_pointer[FIFO_DEPTH-2:0] + write;
-	  rd_pointer[FIFO_DEPTH-1] <= 1'b0;
-	  rd_pointer[FIFO_DEPTH-2:0] <= rd_pointer[FIFO_DEPTH-2:0] + (~(write | write_1 | read_1) && read); 
+	  data_avail_int <= ~((capacity == empty_cap)  || ((capacity == almost_empty_cap) && (~(write | write_1) && read))  );
+	  // Pointers wrap at the end of the TX0 region
+	  wr_pointer <= (write && (wr_pointer == empty_cap)) ? 0 : wr_pointer + write;
+	  rd_pointer <= (rd_advance && (rd_pointer == empty_cap)) ? 0 : rd_pointer + rd_advance;
 	  capacity <= capacity - write + (~(write | write_1) && read) ;
    // TX 1
 	  // No space available if:
 	  // Capacity is already zero; Capacity is 1 and write is asserted (lookahead); both read and write are asserted (collision)
 	  space_avail_1_out <= ~((capacity_1 == 0) || (read_1&&write_1) || ((capacity_1 == 1) && write_1) );
 	  // Capacity has 1 cycle delay so look ahead here for corner case of read of last item in FIFO.
-	  data_avail_int_1 <= ~((capacity_1 == ((1 << (FIFO_DEPTH-1))-1))  || ((capacity_1 == ((1 << (FIFO_DEPTH-1))-2)) && (~(write_1 | write) && read_1))  );
-	  wr_pointer_1[FIFO_DEPTH-1] <= 1'b1;
-	  wr_pointer_1[FIFO_DEPTH-2:0] <= wr_pointer_1[FIFO_DEPTH-2:0] + write_1;
-	  rd_pointer_1[FIFO_DEPTH-1] <= 1'b1;
-	  rd_pointer_1[FIFO_DEPTH-2:0] <= rd_pointer_1[FIFO_DEPTH-2:0] + (~(write_1 | write | read) && read_1);
+	  data_avail_int_1 <= ~((capacity_1 == empty_cap_1)  || ((capacity_1 == almost_empty_cap_1) && (~(write_1 | write) && read_1))  );
+	  // Pointers wrap at the top of the RAM back to the start of the TX1 region
+	  wr_pointer_1 <= (write_1 && (&wr_pointer_1)) ? split : wr_pointer_1 + write_1;
+	  rd_pointer_1 <= (rd_advance_1 && (&rd_pointer_1)) ? split : rd_pointer_1 + rd_advance_1;
 	  capacity_1 <= capacity_1 - write_1 + (~(write | write_1) && read_1) ;
      
 	  if (write || write_1)
@@ -20,9 +20,17 @@
 // Read port is read-acknowledge
 // FIXME do we want to be able to interleave reads and writes?
 
+// With CHKSUM=1 a read started with ctrl[4] (IPv4 header) and/or ctrl[5] (UDP)
+// first sums the buffer, then sends it with the checksum fields filled in.
+// The buffer holds a firmware frame: the control word, the padded ethernet
+// header, a 20 byte IPv4 header from line 5 and the UDP header from line 10.
+// The UDP sum stops at the UDP length, the pad after it counts as zero.
+// status[7] tells the checksums are there.
+
 module buffer_int2
   #(parameter BASE = 0,
-    parameter BUF_SIZE = 9)
+    parameter BUF_SIZE = 9,
+    parameter CHKSUM = 0)
     (input clk, input rst,
      input set_stb, input [7:0] set_addr, input [31:0] set_data,
      output [31:0] status,
@@ -74,6 +82,10 @@ module buffer_int2
    localparam WRITING = 3'd3;
    localparam ERROR = 3'd4;
    localparam DONE = 3'd5;
+   localparam CSUM_READ = 3'd6;
+
+   reg [1:0] 	      rd_csum;
+   wire [1:0] 	      csum_req = ctrl[5:4] & {2{CHKSUM[0]}};
 
    // read state machine
    always @(posedge clk)
@@ -90,9 +102,19 @@ module buffer_int2
 	   if(go & read)
 	     begin
 		rd_addr <= 0;
-		rd_state <= PRE_READ;
+		rd_state <= (csum_req != 0) ? CSUM_READ : PRE_READ;
 		rd_length <= ctrl[31:16];
+		rd_csum <= csum_req;
+	     end
+
+	 CSUM_READ :  // the sums take the words a cycle later, up to the end of PRE_READ
+	   if(rd_addr_next == rd_length)
+	     begin
+		rd_addr <= 0;
+		rd_state <= PRE_READ;
 	     end
+	   else
+	     rd_addr <= rd_addr_next;
 	 
 	 PRE_READ :
 	   begin
@@ -146,6 +168,73 @@ module buffer_int2
 	     end // if (wr_ready_i)
        endcase // case(wr_state)
    
+   // the line at the RAM output, for the sums and the checksum fields
+   wire [31:0] 	      rd_line;
+   reg [15:0] 	      rd_line_addr;
+   reg 		      csum_valid;
+   always @(posedge clk)
+     begin
+	if(en)
+	  rd_line_addr <= rd_addr;
+	csum_valid <= (rd_state == CSUM_READ);
+     end
+
+   // one's complement sums, folded when done: 512 lines cannot overflow 32 bits
+   reg [31:0] 	      ip_acc, udp_acc;
+   reg [17:0] 	      udp_end;  // byte after the UDP payload
+   wire [17:0] 	      line_byte = {rd_line_addr, 2'b00};
+   wire [17:0] 	      line_left = udp_end - line_byte;
+   wire [31:0] 	      udp_data = (line_byte >= udp_end) ? 32'd0 :
+			(line_left == 18'd1) ? {rd_line[31:24], 24'd0} :
+			(line_left == 18'd2) ? {rd_line[31:16], 16'd0} :
+			(line_left == 18'd3) ? {rd_line[31:8], 8'd0} : rd_line;
+   always @(posedge clk)
+     if(rd_state == IDLE)
+       begin
+	  ip_acc <= 0;
+	  udp_acc <= 0;
+	  udp_end <= 0;
+       end
+     else if(csum_valid)
+       case(rd_line_addr)
+	 16'd5, 16'd6, 16'd8, 16'd9 :  // IPv4 header, the addresses are in the UDP pseudo header
+	   begin
+	      ip_acc <= ip_acc + rd_line[31:16] + rd_line[15:0];
+	      if(rd_line_addr[3])
+		udp_acc <= udp_acc + rd_line[31:16] + rd_line[15:0];
+	   end
+	 16'd7 :  // TTL, protocol and the checksum field
+	   begin
+	      ip_acc <= ip_acc + rd_line[31:16];
+	      udp_acc <= udp_acc + rd_line[23:16];
+	   end
+	 16'd10 :  // UDP ports
+	   udp_acc <= udp_acc + rd_line[31:16] + rd_line[15:0];
+	 16'd11 :  // UDP length, in the header and the pseudo header, and the checksum field
+	   begin
+	      udp_acc <= udp_acc + {rd_line[31:16], 1'b0};
+	      udp_end <= 18'd40 + rd_line[31:16];
+	   end
+	 default :
+	   if(rd_line_addr > 16'd11)
+	     udp_acc <= udp_acc + udp_data[31:16] + udp_data[15:0];
+       endcase // case (rd_line_addr)
+
+   reg [16:0] 	      ip_fold, udp_fold;
+   reg [15:0] 	      ip_chksum, udp_chksum;
+   always @(posedge clk)
+     begin
+	ip_fold <= ip_acc[31:16] + ip_acc[15:0];
+	udp_fold <= udp_acc[31:16] + udp_acc[15:0];
+	ip_chksum <= ~(ip_fold[15:0] + ip_fold[16]);
+	udp_chksum <= ~(udp_fold[15:0] + udp_fold[16]);
+     end
+
+   // settled long before line 7 leaves, a zero UDP checksum means none
+   assign rd_data_o[31:0] = (rd_csum[0] & (rd_line_addr == 16'd7)) ? {rd_line[31:16], ip_chksum} :
+			    (rd_csum[1] & (rd_line_addr == 16'd11)) ? {rd_line[31:16], (udp_chksum == 16'd0) ? 16'hffff : udp_chksum} :
+			    rd_line;
+
    assign     rd_data_o[35:32] = { rd_occ[1:0], rd_eop, rd_sop };
    assign     rd_ready_o = (rd_state == READING);
    
@@ -176,7 +265,7 @@ module buffer_int2
      (.clka(wb_clk_i),.ena(wb_stb_i),.wea(wb_we_i),
       .addra(wb_adr_i[BUF_SIZE+1:2]),.dia(wb_dat_i),.doa(),
       .clkb(clk),.enb(en),.web(1'b0),
-      .addrb(rd_addr[BUF_SIZE-1:0]),.dib(0),.dob(rd_data_o[31:0]));
+      .addrb(rd_addr[BUF_SIZE-1:0]),.dib(0),.dob(rd_line));
    
    always @(posedge wb_clk_i)
      if(wb_rst_i)
@@ -189,6 +278,6 @@ module buffer_int2
 	.out(ctrl),.changed(go));
    
    assign status = { wr_addr,
-		     8'b0,1'b0,rd_idle,rd_error,rd_done, 1'b0,wr_idle,wr_error,wr_done};
+		     8'b0,CHKSUM[0],rd_idle,rd_error,rd_done, 1'b0,wr_idle,wr_error,wr_done};
 
 endmodule // buffer_int2
@@ -17,13 +17,16 @@
 
 
 
+// LEN is the length field, the packet is LEN+4 bytes with the checksum
+
 module packet_generator
+  #(parameter LEN = 2000)
   (input clk, input reset, input clear,
    output reg [7:0] data_o, output sof_o, output eof_o,
    input [127:0] header,
    output src_rdy_o, input dst_rdy_i);
 
-   localparam len = 32'd2000;
+   localparam [31:0] len = LEN;
 
    reg [31:0] state;
    reg [31:0] seq;
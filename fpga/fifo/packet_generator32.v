@@ -18,6 +18,7 @@
 
 
 module packet_generator32
+  #(parameter LEN = 2000)
   (input clk, input reset, input clear,
    input [127:0] header,
    output [35:0] data_o, output src_rdy_o, input dst_rdy_i);
@@ -25,7 +26,7 @@ module packet_generator32
    wire [7:0] 	     ll_data;
    wire 	     ll_sof, ll_eof, ll_src_rdy, ll_dst_rdy_n;
    
-   packet_generator pkt_gen
+   packet_generator #(.LEN(LEN)) pkt_gen
      (.clk(clk), .reset(reset), .clear(clear),
       .data_o(ll_data), .sof_o(ll_sof), .eof_o(ll_eof),
       .header(header),
@@ -21,6 +21,8 @@
 //    Line 1 -- Length, 32 bits
 //    Line 2 -- Sequence number, 32 bits
 //    Last line -- CRC, 32 bits
+// The sequence numbers count up from 0 after a clear, a mismatch
+// resyncs to the number received.
 
 module packet_verifier
   (input clk, input reset, input clear,
@@ -45,8 +47,27 @@ module packet_verifier
    assign last_byte = src_rdy_i & dst_rdy_o & eof_i;
    assign dst_rdy_o = ~last_byte_d1;
 
-   // stubs for now
-   wire 	     match_seq = 1;
+   reg [15:0] 	     byte_cnt;
+   reg [31:0] 	     seq_in;
+   always @(posedge clk)
+     if(reset | clear)
+       byte_cnt <= 0;
+     else if(calc_crc)
+       byte_cnt <= eof_i ? 16'd0 : byte_cnt + 16'd1;
+
+   always @(posedge clk)
+     if(calc_crc & (byte_cnt[15:2] == 1))
+       seq_in <= {seq_in[23:0], data_i};
+
+   always @(posedge clk)
+     if(reset | clear)
+       seq_num <= 0;
+     else if(last_byte_d1)
+       seq_num <= seq_in + 1;
+
+   wire 	     match_seq = (seq_in == seq_num);
+
+   // stub for now
    wire 	     match_len = 1;
    
    always @(posedge clk)
@@ -72,7 +93,7 @@ module packet_verifier
 	    else if(~match_seq)
 	      seq_err <= seq_err + 1;
 	    else if(~match_len)
-	      seq_err <= len_err + 1;
+	      len_err <= len_err + 1;
 	 end
    
 endmodule // packet_verifier
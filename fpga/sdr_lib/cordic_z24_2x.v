@@ -0,0 +1,61 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! One cordic_z24 shared by two chains that run at half of clk.
+//! The inputs of the two chains take turns into the pipeline, and each
+//! output is held for the two clocks of a chain sample. The chains see
+//! about half the latency of their own CORDIC, in their clocks.
+
+module cordic_z24_2x
+  #(parameter bitwidth = 16)
+   (input clk, input rst,
+    input [bitwidth-1:0] a_xi, input [bitwidth-1:0] a_yi, input [23:0] a_zi,
+    output reg [bitwidth-1:0] a_xo, output reg [bitwidth-1:0] a_yo,
+    input [bitwidth-1:0] b_xi, input [bitwidth-1:0] b_yi, input [23:0] b_zi,
+    output reg [bitwidth-1:0] b_xo, output reg [bitwidth-1:0] b_yo);
+
+   // registers from the inputs to the outputs of cordic_z24
+   localparam LATENCY = 21;
+
+   reg 	      sel;
+   always @(posedge clk)
+     if(rst)
+       sel <= 0;
+     else
+       sel <= ~sel;
+
+   wire [bitwidth-1:0] xo, yo;
+   cordic_z24 #(.bitwidth(bitwidth)) cordic
+     (.clock(clk), .reset(rst), .enable(1'b1),
+      .xi(sel ? b_xi : a_xi), .yi(sel ? b_yi : a_yi), .zi(sel ? b_zi : a_zi),
+      .xo(xo), .yo(yo), .zo());
+
+   // the output of an input taken with sel low comes out LATENCY clocks later
+   wire       out_a = (LATENCY % 2 == 1) ? sel : ~sel;
+   always @(posedge clk)
+     if(out_a)
+       begin
+	  a_xo <= xo;
+	  a_yo <= yo;
+       end
+     else
+       begin
+	  b_xo <= xo;
+	  b_yo <= yo;
+       end
+
+endmodule // cordic_z24_2x
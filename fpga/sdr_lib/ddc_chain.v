@@ -20,17 +20,26 @@
 module ddc_chain
   #(
     parameter BASE = 0,
+    parameter FIR_BASE = 0,
     parameter DSPNO = 0,
-    parameter WIDTH = 24
+    parameter WIDTH = 24,
+    parameter SHARED_CORDIC = 0 // the CORDIC is outside, on the cordic_* ports
   )
   (input clk, input rst, input clr,
    input set_stb, input [7:0] set_addr, input [31:0] set_data,
    input set_stb_user, input [7:0] set_addr_user, input [31:0] set_data_user,
 
+   // Phase increment from the hop table, overrides BASE+0
+   input hop_stb, input [31:0] hop_phase_inc,
+
    // From RX frontend
    input [WIDTH-1:0] rx_fe_i,
    input [WIDTH-1:0] rx_fe_q,
 
+   // Shared CORDIC, 25 bits like the one inside
+   output [24:0] cordic_xi, output [24:0] cordic_yi, output [23:0] cordic_zi,
+   input [24:0] cordic_xo, input [24:0] cordic_yo,
+
    // To RX control
    output [31:0] sample,
    input run,
@@ -42,19 +51,26 @@ module ddc_chain
    localparam  zwidth = 24;
 
    wire ddc_enb;
-   wire [31:0] phase_inc;
+   wire [31:0] phase_inc_sr;
+   wire        phase_inc_changed;
+   reg [31:0]  phase_inc;
    reg [31:0]  phase;
 
    wire [17:0] scale_factor;
    wire [cwidth-1:0] i_cordic, q_cordic;
    wire [WIDTH-1:0] i_cordic_clip, q_cordic_clip;
    wire [WIDTH-1:0] i_cic, q_cic;
+   wire [WIDTH-1:0] i_cic2, q_cic2;
    wire [WIDTH-1:0] i_hb1, q_hb1;
    wire [WIDTH-1:0] i_hb2, q_hb2;
+   wire [WIDTH-1:0] i_frac, q_frac;
+   wire [WIDTH-1:0] i_fir, q_fir;
    
-   wire        strobe_cic, strobe_hb1, strobe_hb2;
-   wire        enable_hb1, enable_hb2;
+   wire        strobe_cic, strobe_cic2, strobe_hb1, strobe_hb2, strobe_frac, strobe_fir;
+   wire        enable_hb1, enable_hb2, enable_frac;
+   wire [30:0] frac_step;
    wire [7:0]  cic_decim_rate;
+   wire [2:0]  cic2_rate_m1;
 
    reg [WIDTH-1:0]  rx_fe_i_mux, rx_fe_q_mux;
    wire        realmode;
@@ -62,20 +78,33 @@ module ddc_chain
    
    setting_reg #(.my_addr(BASE+0)) sr_0
      (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
-      .in(set_data),.out(phase_inc),.changed());
+      .in(set_data),.out(phase_inc_sr),.changed(phase_inc_changed));
+
+   always @(posedge clk)
+     if(rst)
+       phase_inc <= 0;
+     else if(hop_stb)
+       phase_inc <= hop_phase_inc;
+     else if(phase_inc_changed)
+       phase_inc <= phase_inc_sr;
 
    setting_reg #(.my_addr(BASE+1), .width(18)) sr_1
      (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
       .in(set_data),.out(scale_factor),.changed());
 
-   setting_reg #(.my_addr(BASE+2), .width(10)) sr_2
+   // [12:10] second CIC rate - 1, zero bypasses it
+   setting_reg #(.my_addr(BASE+2), .width(13)) sr_2
      (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
-      .in(set_data),.out({enable_hb1, enable_hb2, cic_decim_rate}),.changed());
+      .in(set_data),.out({cic2_rate_m1, enable_hb1, enable_hb2, cic_decim_rate}),.changed());
 
    setting_reg #(.my_addr(BASE+3), .width(2)) sr_3
      (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
       .in(set_data),.out({realmode,swap_iq}),.changed());
 
+   setting_reg #(.my_addr(BASE+4)) sr_4
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out({enable_frac, frac_step}),.changed());
+
    // MUX so we can do realmode signals on either input
    
    always @(posedge clk)
@@ -106,10 +135,21 @@ module ddc_chain
    sign_extend #(.bits_in(WIDTH), .bits_out(cwidth)) sign_extend_cordic_q (.in(to_ddc_chain_q), .out(to_cordic_q));
 
    // CORDIC  24-bit I/O
-   cordic_z24 #(.bitwidth(cwidth))
-     cordic(.clock(clk), .reset(rst), .enable(ddc_enb),
-	    .xi(to_cordic_i),. yi(to_cordic_q), .zi(phase[31:32-zwidth]),
-	    .xo(i_cordic),.yo(q_cordic),.zo() );
+   assign cordic_xi = to_cordic_i;
+   assign cordic_yi = to_cordic_q;
+   assign cordic_zi = phase[31:32-zwidth];
+   generate
+      if(SHARED_CORDIC == 0)
+	cordic_z24 #(.bitwidth(cwidth))
+	  cordic(.clock(clk), .reset(rst), .enable(ddc_enb),
+		 .xi(to_cordic_i),. yi(to_cordic_q), .zi(phase[31:32-zwidth]),
+		 .xo(i_cordic),.yo(q_cordic),.zo() );
+      else
+	begin
+	   assign i_cordic = cordic_xo;
+	   assign q_cordic = cordic_yo;
+	end
+   endgenerate
 
    clip_reg #(.bits_in(cwidth), .bits_out(WIDTH)) clip_i
      (.clk(clk), .in(i_cordic), .strobe_in(1'b1), .out(i_cordic_clip));
@@ -130,17 +170,44 @@ module ddc_chain
 	      .rate(cic_decim_rate),.strobe_in(1'b1),.strobe_out(strobe_cic),
 	      .signal_in(q_cordic_clip),.signal_out(q_cic));
 
+   // Second CIC for the low rates, 2 to 8 past the first  24 bit I/O
+   // only shifts up to 12 bits, within its 3 bit rate
+   wire        enable_cic2 = (cic2_rate_m1 != 3'd0);
+   wire [7:0]  cic2_rate = {5'd0, cic2_rate_m1} + 8'd1;
+   wire        strobe_cic2_int;
+   wire [WIDTH-1:0] i_cic2_int, q_cic2_int;
+
+   cic_strober cic2_strober(.clock(clk),.reset(rst),.enable(ddc_enb & enable_cic2),.rate(cic2_rate),
+			    .strobe_fast(strobe_cic),.strobe_slow(strobe_cic2_int) );
+
+   cic_decim #(.bw(WIDTH), .log2_of_max_rate(3))
+     decim2_i (.clock(clk),.reset(rst),.enable(ddc_enb & enable_cic2),
+	       .rate(cic2_rate),.strobe_in(strobe_cic),.strobe_out(strobe_cic2_int),
+	       .signal_in(i_cic),.signal_out(i_cic2_int));
+
+   cic_decim #(.bw(WIDTH), .log2_of_max_rate(3))
+     decim2_q (.clock(clk),.reset(rst),.enable(ddc_enb & enable_cic2),
+	       .rate(cic2_rate),.strobe_in(strobe_cic),.strobe_out(strobe_cic2_int),
+	       .signal_in(q_cic),.signal_out(q_cic2_int));
+
+   assign strobe_cic2 = enable_cic2 ? strobe_cic2_int : strobe_cic;
+   assign i_cic2 = enable_cic2 ? i_cic2_int : i_cic;
+   assign q_cic2 = enable_cic2 ? q_cic2_int : q_cic;
+
    // First (small) halfband  24 bit I/O
    small_hb_dec #(.WIDTH(WIDTH)) small_hb_i
      (.clk(clk),.rst(rst),.bypass(~enable_hb1),.run(ddc_enb),
-      .stb_in(strobe_cic),.data_in(i_cic),.stb_out(strobe_hb1),.data_out(i_hb1));
+      .stb_in(strobe_cic2),.data_in(i_cic2),.stb_out(strobe_hb1),.data_out(i_hb1));
    
    small_hb_dec #(.WIDTH(WIDTH)) small_hb_q
      (.clk(clk),.rst(rst),.bypass(~enable_hb1),.run(ddc_enb),
-      .stb_in(strobe_cic),.data_in(q_cic),.stb_out(),.data_out(q_hb1));
+      .stb_in(strobe_cic2),.data_in(q_cic2),.stb_out(),.data_out(q_hb1));
 
    // Second (large) halfband  24 bit I/O
-   wire [8:0]  cpi_hb = enable_hb1 ? {cic_decim_rate,1'b0} : {1'b0,cic_decim_rate};
+   // past 511 clocks per input it runs as slow as it gets anyway
+   wire [11:0] cpi_cic = cic_decim_rate * cic2_rate;
+   wire [12:0] cpi_hb_full = enable_hb1 ? {cpi_cic,1'b0} : {1'b0,cpi_cic};
+   wire [8:0]  cpi_hb = (cpi_hb_full[12:9] != 0) ? 9'h1ff : cpi_hb_full[8:0];
    hb_dec #(.WIDTH(WIDTH)) hb_i
      (.clk(clk),.rst(rst),.bypass(~enable_hb2),.run(ddc_enb),.cpi(cpi_hb),
       .stb_in(strobe_hb1),.data_in(i_hb1),.stb_out(strobe_hb2),.data_out(i_hb2));
@@ -149,20 +216,33 @@ module ddc_chain
      (.clk(clk),.rst(rst),.bypass(~enable_hb2),.run(ddc_enb),.cpi(cpi_hb),
       .stb_in(strobe_hb1),.data_in(q_hb1),.stb_out(),.data_out(q_hb2));
 
+   // Fractional decimator for rates off the integer decimations  24 bit I/O
+   frac_dec #(.WIDTH(WIDTH)) frac_dec
+     (.clk(clk),.rst(rst),.bypass(~enable_frac),.run(ddc_enb),.step_frac(frac_step),
+      .stb_in(strobe_hb2),.i_in(i_hb2),.q_in(q_hb2),
+      .stb_out(strobe_frac),.i_out(i_frac),.q_out(q_frac));
+
+   // Programmable channel filter, also the CIC droop compensation  24 bit I/O
+   rx_fir #(.BASE(FIR_BASE), .WIDTH(WIDTH)) rx_fir
+     (.clk(clk),.rst(rst),.run(ddc_enb),
+      .set_stb(set_stb),.set_addr(set_addr),.set_data(set_data),
+      .stb_in(strobe_frac),.i_in(i_frac),.q_in(q_frac),
+      .stb_out(strobe_fir),.i_out(i_fir),.q_out(q_fir));
+
    //scalar operation (gain of 6 bits)
    wire [35:0] prod_i, prod_q;
 
    MULT18X18S mult_i
-     (.P(prod_i), .A(i_hb2[WIDTH-1:WIDTH-18]), .B(scale_factor), .C(clk), .CE(strobe_hb2), .R(rst) );
+     (.P(prod_i), .A(i_fir[WIDTH-1:WIDTH-18]), .B(scale_factor), .C(clk), .CE(strobe_fir), .R(rst) );
    MULT18X18S mult_q
-     (.P(prod_q), .A(q_hb2[WIDTH-1:WIDTH-18]), .B(scale_factor), .C(clk), .CE(strobe_hb2), .R(rst) );
+     (.P(prod_q), .A(q_fir[WIDTH-1:WIDTH-18]), .B(scale_factor), .C(clk), .CE(strobe_fir), .R(rst) );
 
    //pipeline for the multiplier (gain of 10 bits)
    reg [WIDTH-1:0] prod_reg_i, prod_reg_q;
    reg strobe_mult;
 
    always @(posedge clk) begin
-       strobe_mult <= strobe_hb2;
+       strobe_mult <= strobe_fir;
        prod_reg_i <= prod_i[33:34-WIDTH];
        prod_reg_q <= prod_q[33:34-WIDTH];
    end
@@ -185,6 +265,6 @@ module ddc_chain
     .ddc_out_sample(ddc_chain_out), .ddc_out_strobe(ddc_chain_stb), .ddc_out_enable(ddc_enb),
     .bb_sample(sample), .bb_strobe(strobe));
 
-   assign      debug = {enable_hb1, enable_hb2, run, strobe, strobe_cic, strobe_hb1, strobe_hb2};
+   assign      debug = {enable_cic2, strobe_cic2, enable_hb1, enable_hb2, enable_frac, run, strobe, strobe_cic, strobe_hb1, strobe_hb2, strobe_frac, strobe_fir};
    
 endmodule // ddc_chain
@@ -27,7 +27,7 @@ module ddc_chain_tb();
    reg [7:0] set_addr;
    reg [31:0] set_data;
    
-   ddc_chain #(.BASE(0)) ddc_chain
+   ddc_chain #(.BASE(0), .FIR_BASE(16)) ddc_chain
      (.clk(clk),.rst(rst),
       .set_stb(set_stb),.set_addr(set_addr),.set_data(set_data),
       .adc_i(adc_in), .adc_ovf_i(0),
@@ -32,12 +32,16 @@ module dspengine_16to8
     input [35:0] access_dat_i
     );
 
-   wire convert;
-   setting_reg #(.my_addr(BASE),.width(1)) sr_16to8
+   // [0] convert, [2] block floating point: the packet shares one exponent,
+   // its first payload word, and the 8 bit mantissas keep the weak signals
+   wire [2:0] format;
+   setting_reg #(.my_addr(BASE),.width(3)) sr_16to8
      (.clk(clk),.rst(reset),.strobe(set_stb),.addr(set_addr),
-      .in(set_data),.out(convert),.changed());
+      .in(set_data),.out(format),.changed());
+   wire 	 convert = format[0];
+   wire 	 bfp = format[2];
 
-   reg [2:0] 	 dsp_state;
+   reg [3:0] 	 dsp_state;
    localparam DSP_IDLE = 0;
    localparam DSP_PARSE_HEADER = 1;
    localparam DSP_CONVERT = 2;
@@ -46,6 +50,9 @@ module dspengine_16to8
    localparam DSP_WRITE_TRAILER = 5;
    localparam DSP_WRITE_HEADER = 6;
    localparam DSP_DONE = 7;
+   localparam DSP_SCAN = 8;
+   localparam DSP_SCAN_DRAIN = 9;
+   localparam DSP_WRITE_EXP = 10;
 
    // Parse VITA header
    wire 	 is_if_data = (access_dat_i[31:29] == 3'b000);
@@ -59,7 +66,8 @@ module dspengine_16to8
    
    wire [35:0] 	 prod_i, prod_q;
    wire [15:0] 	 scaled_i, scaled_q;
-   wire [7:0] 	 i8, q8;
+   wire [7:0] 	 i8, q8, clip_i8, clip_q8;
+   wire [3:0] 	 exponent;
    reg [7:0] 	 i8_reg, q8_reg;
    wire 	 stb_read, stb_clip, val_read, val_clip;
    wire 	 stb_out, stb_reg;
@@ -67,6 +75,8 @@ module dspengine_16to8
    
    reg [BUF_SIZE-1:0] read_adr, write_adr;
    reg 		      has_trailer_reg;
+   reg [3:0] 	      hdr_length_reg;
+   reg 		      bfp_reg;
    
    wire 	      last = (read_adr + 1) == (access_len - has_trailer_reg);
    wire 	      last_o, even_o;
@@ -94,18 +104,33 @@ module dspengine_16to8
 	 DSP_PARSE_HEADER :
 	   begin
 	      has_trailer_reg <= has_trailer;
+	      hdr_length_reg <= hdr_length;
+	      bfp_reg <= bfp;
 	      new_header[31:16] <= access_dat_i[31:16];
 	      new_header[15:0] <= access_len;
 	      length <= access_len;
 	      if(is_if_data & convert)
 		begin
 		   read_adr <= hdr_length;
-		   write_adr <= hdr_length;
-		   dsp_state <= DSP_CONVERT;
+		   write_adr <= hdr_length + bfp; // the exponent goes first
+		   dsp_state <= bfp ? DSP_SCAN : DSP_CONVERT;
 		end
 	      else
 		dsp_state <= DSP_WRITE_HEADER;
 	   end
+
+	 // First pass for the exponent: the peak magnitude of the packet
+	 DSP_SCAN :
+	   if(last)
+	     begin
+		read_adr <= hdr_length_reg;
+		dsp_state <= DSP_SCAN_DRAIN;
+	     end
+	   else
+	     read_adr <= read_adr + 1;
+
+	 DSP_SCAN_DRAIN :
+	   dsp_state <= DSP_CONVERT;
 	 
 	 DSP_CONVERT:
 	   begin
@@ -154,11 +179,14 @@ module dspengine_16to8
 
 	 DSP_WRITE_TRAILER :
 	   begin
-	      dsp_state <= DSP_WRITE_HEADER;
+	      dsp_state <= bfp_reg ? DSP_WRITE_EXP : DSP_WRITE_HEADER;
 	      write_adr <= 0;
 	      new_header[15:0] <= write_adr + 1;
 	   end
 
+	 DSP_WRITE_EXP :
+	   dsp_state <= DSP_WRITE_HEADER;
+
 	 DSP_WRITE_HEADER :
 	   dsp_state <= DSP_DONE;
 
@@ -177,20 +205,50 @@ module dspengine_16to8
 
    assign access_we = (dsp_state == DSP_WRITE_HEADER) | 
 		      (dsp_state == DSP_WRITE_TRAILER) |
+		      (dsp_state == DSP_WRITE_EXP) |
 		      stb_write;
 
    assign access_dat_o = (dsp_state == DSP_WRITE_HEADER) ? { 4'h1, new_header } :
 			 (dsp_state == DSP_WRITE_TRAILER) ? { 4'h2, new_trailer } :
+			 (dsp_state == DSP_WRITE_EXP) ? { 4'h0, 28'd0, exponent } :
 			 (last_o&~even_o) ? {4'h0, i8, q8, 16'd0 } :
 			 {4'h0, i8_reg, q8_reg, i8, q8 };
    
-   assign access_adr = (stb_write|(dsp_state == DSP_WRITE_HEADER)|(dsp_state == DSP_WRITE_TRAILER)) ? write_adr : read_adr;
+   assign access_adr = (dsp_state == DSP_WRITE_EXP) ? hdr_length_reg :
+		       (stb_write|(dsp_state == DSP_WRITE_HEADER)|(dsp_state == DSP_WRITE_TRAILER)) ? write_adr : read_adr;
       
    // DSP Pipeline
    
    wire [15:0] i16 = access_dat_i[31:16];
    wire [15:0] q16 = access_dat_i[15:0];
 
+   // The peak magnitude of the scanned samples, one's complement is enough
+   reg 	       scan_valid;
+   reg [14:0]  peak;
+   always @(posedge clk)
+     begin
+	scan_valid <= (dsp_state == DSP_SCAN);
+	if(dsp_state == DSP_PARSE_HEADER)
+	  peak <= 0;
+	else if(scan_valid)
+	  peak <= peak | (i16[15] ? ~i16[14:0] : i16[14:0]) | (q16[15] ? ~q16[14:0] : q16[14:0]);
+     end
+
+   // Smallest shift that fits the peak in 8 bits
+   assign exponent = peak[14] ? 4'd8 : peak[13] ? 4'd7 : peak[12] ? 4'd6 : peak[11] ? 4'd5 :
+		     peak[10] ? 4'd4 : peak[9] ? 4'd3 : peak[8] ? 4'd2 : peak[7] ? 4'd1 : 4'd0;
+
+   reg signed [15:0] bfp_i, bfp_q;
+   always @(posedge clk)
+     if(stb_clip)
+       begin
+	  bfp_i <= $signed(i16) >>> exponent;
+	  bfp_q <= $signed(q16) >>> exponent;
+       end
+
+   assign i8 = bfp_reg ? bfp_i[7:0] : clip_i8;
+   assign q8 = bfp_reg ? bfp_q[7:0] : clip_q8;
+
    pipectrl #(.STAGES(2), .TAGWIDTH(2)) pipectrl
      (.clk(clk), .reset(reset),
       .src_rdy_i(send_to_pipe), .dst_rdy_o(), // dst_rdy_o will always be 1 since dst_rdy_i is 1, below
@@ -203,9 +261,9 @@ module dspengine_16to8
        {i8_reg,q8_reg} <= {i8,q8};
 
    clip_reg #(.bits_in(16),.bits_out(8),.STROBED(1)) clip_i
-     (.clk(clk), .in(i16), .out(i8), .strobe_in(stb_clip), .strobe_out());
+     (.clk(clk), .in(i16), .out(clip_i8), .strobe_in(stb_clip), .strobe_out());
 
    clip_reg #(.bits_in(16),.bits_out(8),.STROBED(1)) clip_q
-     (.clk(clk), .in(q16), .out(q8), .strobe_in(stb_clip), .strobe_out());
+     (.clk(clk), .in(q16), .out(clip_q8), .strobe_in(stb_clip), .strobe_out());
 
 endmodule // dspengine_16to8
@@ -21,16 +21,24 @@ module duc_chain
   #(
     parameter BASE = 0,
     parameter DSPNO = 0,
-    parameter WIDTH = 24
+    parameter WIDTH = 24,
+    parameter SHARED_CORDIC = 0 // the CORDIC is outside, on the cordic_* ports
   )
   (input clk, input rst, input clr,
    input set_stb, input [7:0] set_addr, input [31:0] set_data,
    input set_stb_user, input [7:0] set_addr_user, input [31:0] set_data_user,
 
+   // Phase increment from the hop table, overrides BASE+0
+   input hop_stb, input [31:0] hop_phase_inc,
+
    // To TX frontend
    output [WIDTH-1:0] tx_fe_i,
    output [WIDTH-1:0] tx_fe_q,
 
+   // Shared CORDIC, WIDTH bits like the one inside
+   output [WIDTH-1:0] cordic_xi, output [WIDTH-1:0] cordic_yi, output [23:0] cordic_zi,
+   input [WIDTH-1:0] cordic_xo, input [WIDTH-1:0] cordic_yo,
+
    // From TX control
    input [31:0] sample,
    input run,
@@ -40,7 +48,9 @@ module duc_chain
 
    wire duc_enb;
    wire [17:0] scale_factor;
-   wire [31:0] phase_inc;
+   wire [31:0] phase_inc_sr;
+   wire        phase_inc_changed;
+   reg [31:0]  phase_inc;
    reg [31:0]  phase;
    wire [7:0]  interp_rate;
    wire [3:0]  tx_femux_a, tx_femux_b;
@@ -49,7 +59,15 @@ module duc_chain
    
    setting_reg #(.my_addr(BASE+0)) sr_0
      (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
-      .in(set_data),.out(phase_inc),.changed());
+      .in(set_data),.out(phase_inc_sr),.changed(phase_inc_changed));
+
+   always @(posedge clk)
+     if(rst)
+       phase_inc <= 0;
+     else if(hop_stb)
+       phase_inc <= hop_phase_inc;
+     else if(phase_inc_changed)
+       phase_inc <= phase_inc_sr;
 
    setting_reg #(.my_addr(BASE+1), .width(18)) sr_1
      (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
@@ -128,11 +146,22 @@ module duc_chain
 
    wire [cwidth-1:0] da_c, db_c;
    
-   cordic_z24 #(.bitwidth(cwidth))
-     cordic(.clock(clk), .reset(rst), .enable(duc_enb),
-	    .xi({i_interp,{(cwidth-18){1'b0}}}),.yi({q_interp,{(cwidth-18){1'b0}}}),
-	    .zi(phase[31:32-zwidth]),
-	    .xo(da_c),.yo(db_c),.zo() );
+   assign cordic_xi = {i_interp,{(cwidth-18){1'b0}}};
+   assign cordic_yi = {q_interp,{(cwidth-18){1'b0}}};
+   assign cordic_zi = phase[31:32-zwidth];
+   generate
+      if(SHARED_CORDIC == 0)
+	cordic_z24 #(.bitwidth(cwidth))
+	  cordic(.clock(clk), .reset(rst), .enable(duc_enb),
+		 .xi({i_interp,{(cwidth-18){1'b0}}}),.yi({q_interp,{(cwidth-18){1'b0}}}),
+		 .zi(phase[31:32-zwidth]),
+		 .xo(da_c),.yo(db_c),.zo() );
+      else
+	begin
+	   assign da_c = cordic_xo;
+	   assign db_c = cordic_yo;
+	end
+   endgenerate
    
    MULT18X18S MULT18X18S_inst 
      (.P(prod_i),    // 36-bit multiplier output
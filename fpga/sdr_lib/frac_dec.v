@@ -0,0 +1,108 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Fractional decimator: one output every 1+step_frac input samples (Q0.31),
+//! linearly interpolated between the two input samples around the output
+//! instant. Sits behind the halfbands, which already band-limit the signal.
+//! At most one output per input, so the output strobe keeps the input pacing.
+
+module frac_dec
+  #(parameter WIDTH = 24)
+   (input clk, input rst, input bypass, input run,
+    input [30:0] step_frac,
+    input stb_in, input [WIDTH-1:0] i_in, input [WIDTH-1:0] q_in,
+    output reg stb_out, output reg [WIDTH-1:0] i_out, output reg [WIDTH-1:0] q_out);
+
+   // position of the next output relative to the previous input, Q1.31
+   reg [31:0] 	     mu_acc;
+   reg 		     have_prev;
+   reg [WIDTH-1:0]   i_last, q_last;
+
+   // stage 1: interval endpoints and interpolation phase
+   reg 		     stb_1;
+   reg [WIDTH-1:0]   i_base_1, q_base_1;
+   reg [WIDTH:0]     i_diff_1, q_diff_1;
+   reg [16:0] 	     mu_1;
+
+   always @(posedge clk)
+     if(rst | ~run)
+       begin
+	  mu_acc <= 0;
+	  have_prev <= 0;
+	  stb_1 <= 0;
+       end
+     else
+       begin
+	  stb_1 <= 0;
+	  if(stb_in)
+	    begin
+	       i_last <= i_in;
+	       q_last <= q_in;
+	       i_base_1 <= i_last;
+	       q_base_1 <= q_last;
+	       i_diff_1 <= {i_in[WIDTH-1],i_in} - {i_last[WIDTH-1],i_last};
+	       q_diff_1 <= {q_in[WIDTH-1],q_in} - {q_last[WIDTH-1],q_last};
+	       mu_1 <= mu_acc[30:14];
+	       have_prev <= 1;
+	       if(mu_acc[31])
+		 mu_acc <= {1'b0,mu_acc[30:0]};   // output lies beyond this input
+	       else
+		 begin
+		    mu_acc <= mu_acc + {1'b0,step_frac};
+		    stb_1 <= have_prev;
+		 end
+	    end // if (stb_in)
+       end // else: !if(rst | ~run)
+
+   // stage 2: diff * mu, 18x18 signed with the multiplier output register
+   wire [35:0] i_prod, q_prod;
+   reg 	       stb_2;
+   reg [WIDTH-1:0] i_base_2, q_base_2;
+
+   MULT18X18S mult_i
+     (.P(i_prod), .A(i_diff_1[WIDTH:WIDTH-17]), .B({1'b0,mu_1}), .C(clk), .CE(1'b1), .R(rst) );
+   MULT18X18S mult_q
+     (.P(q_prod), .A(q_diff_1[WIDTH:WIDTH-17]), .B({1'b0,mu_1}), .C(clk), .CE(1'b1), .R(rst) );
+
+   always @(posedge clk)
+     begin
+	stb_2 <= stb_1;
+	i_base_2 <= i_base_1;
+	q_base_2 <= q_base_1;
+     end
+
+   // stage 3: base + diff*mu, stays between the two inputs so it cannot overflow
+   // the product is diff*mu scaled by 2^(17-(WIDTH-17)), realign it to the base
+   localparam SHIFT = 17 - (WIDTH-17);
+
+   always @(posedge clk)
+     if(rst)
+       stb_out <= 0;
+     else if(bypass)
+       begin
+	  stb_out <= stb_in;
+	  i_out <= i_in;
+	  q_out <= q_in;
+       end
+     else
+       begin
+	  stb_out <= stb_2;
+	  i_out <= i_base_2 + i_prod[WIDTH-1+SHIFT:SHIFT];
+	  q_out <= q_base_2 + q_prod[WIDTH-1+SHIFT:SHIFT];
+       end
+
+endmodule // frac_dec
@@ -0,0 +1,104 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Timed table of CORDIC phase increments for frequency hopping.
+//! Entries of (time, phase_inc) are pushed ahead of time, then the table
+//! is armed and steps to the next entry when the low 32 bits of the vita
+//! time reach the entry time. With a non-zero period the entry times after
+//! the first are ignored and the table steps every period ticks instead,
+//! a TDMA strobe without per-entry times. The compare is modulo 2^32, so
+//! every hop must be less than 2^31 ticks after the previous one.
+//!
+//! Registers:
+//!  BASE+0 control: [31] arm, [30] loop, [DEPTH-1:0] entry count, zero for
+//!         all 2^DEPTH. Writing it restarts at entry 0, disarming also
+//!         empties the table.
+//!  BASE+1 period in ticks, zero to use the entry times
+//!  BASE+2 time of the next entry pushed
+//!  BASE+3 phase increment, pushes the entry
+
+module hop_table
+  #(parameter BASE = 0,
+    parameter DEPTH = 6)
+   (input clk, input rst,
+    input set_stb, input [7:0] set_addr, input [31:0] set_data,
+    input [63:0] vita_time,
+    output reg hop, output reg [31:0] phase_inc);
+
+   wire [31:0] period, push_time;
+
+   setting_reg #(.my_addr(BASE+1)) sr_period
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(period),.changed());
+
+   setting_reg #(.my_addr(BASE+2)) sr_time
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(push_time),.changed());
+
+   wire        ctrl_stb = set_stb & (set_addr == BASE+0);
+   wire        push_stb = set_stb & (set_addr == BASE+3);
+
+   reg [31:0]  times [0:(1<<DEPTH)-1];
+   reg [31:0]  incs [0:(1<<DEPTH)-1];
+   reg [DEPTH-1:0] wr_addr, rd_addr, last;
+
+   always @(posedge clk)
+     if(push_stb)
+       begin
+	  times[wr_addr] <= push_time;
+	  incs[wr_addr] <= set_data;
+       end
+
+   reg 	       armed, loop;
+   reg [31:0]  due;
+   wire [31:0] ahead = vita_time[31:0] - due;
+   wire [DEPTH-1:0] rd_next = (rd_addr == last) ? 0 : rd_addr + 1;
+
+   always @(posedge clk)
+     if(rst)
+       begin
+	  armed <= 0;
+	  wr_addr <= 0;
+	  hop <= 0;
+       end
+     else
+       begin
+	  hop <= 0;
+	  if(push_stb)
+	    wr_addr <= wr_addr + 1;
+	  if(ctrl_stb)
+	    begin
+	       armed <= set_data[31];
+	       loop <= set_data[30];
+	       last <= set_data[DEPTH-1:0] - 1;
+	       rd_addr <= 0;
+	       due <= times[0];
+	       if(~set_data[31])
+		 wr_addr <= 0;
+	    end
+	  else if(armed & ~ahead[31])
+	    begin
+	       hop <= 1;
+	       phase_inc <= incs[rd_addr];
+	       due <= (period != 0) ? due + period : times[rd_next];
+	       rd_addr <= rd_next;
+	       if((rd_addr == last) & ~loop)
+		 armed <= 0;
+	    end
+       end
+
+endmodule // hop_table
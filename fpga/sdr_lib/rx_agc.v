@@ -0,0 +1,193 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! RX gain control of one LMS, the RXVGA2 code follows the power of an RX DSP.
+//! Every period cycles the averaged power of the source DSP is compared
+//! with the target window: above target_hi for attack evaluations in a row
+//! steps the code down, below target_lo for decay evaluations in a row
+//! steps it up, 3dB per code within [min, max]. A step writes the LMS
+//! register over the shared SPI master, the evaluations resume when the
+//! write is out. event_stb pulses when the SPI master is done with the
+//! write, with the power that caused it and event_word:
+//! [31:16] sequence of the changes, [8] UNIT, [4:0] the new code.
+//!
+//! Registers:
+//!  BASE+0 [0] enable, [2:1] source DSP, [7:3] min code, [12:8] max code,
+//!         [19:16] attack, [23:20] decay evaluations, zero counts as one
+//!  BASE+1 target_hi power, full scale 2^31
+//!  BASE+2 target_lo power
+//!  BASE+3 evaluation period in cycles
+//!  BASE+4 SPI control word of the LMS, as the settings SPI sources
+//!  BASE+5 [4:0] code, [7:5] other bits and [14:8] address of the register,
+//!         [31:16] SPI clock divider, a write loads the code
+//!
+//! status: [15] enabled, [6] a step is being written, [4:0] the code
+
+module rx_agc
+  #(parameter BASE = 0,
+    parameter UNIT = 0) // the LMS, 0 or 1
+   (input clk, input rst,
+    input set_stb, input [7:0] set_addr, input [31:0] set_data,
+    input [127:0] power_in, // the four RX DSPs, DSP0 in the low word
+
+    output [79:0] spi_config, output reg spi_valid, input spi_ready, input spi_idle,
+
+    output reg event_stb, output [31:0] event_word, output reg [31:0] event_power,
+    output [15:0] status);
+
+   wire [23:0] ctrl;
+   wire        ctrl_changed;
+   setting_reg #(.my_addr(BASE+0), .width(24)) sr_ctrl
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(ctrl),.changed(ctrl_changed));
+
+   wire [31:0] target_hi, target_lo, period, spi_ctrl, spi_reg;
+   wire        code_load;
+   setting_reg #(.my_addr(BASE+1)) sr_hi
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(target_hi),.changed());
+
+   setting_reg #(.my_addr(BASE+2)) sr_lo
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(target_lo),.changed());
+
+   setting_reg #(.my_addr(BASE+3)) sr_period
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(period),.changed());
+
+   setting_reg #(.my_addr(BASE+4)) sr_spi_ctrl
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(spi_ctrl),.changed());
+
+   setting_reg #(.my_addr(BASE+5)) sr_spi_reg
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(spi_reg),.changed(code_load));
+
+   wire       enable = ctrl[0];
+   wire [4:0] min_code = ctrl[7:3];
+   wire [4:0] max_code = ctrl[12:8];
+   wire [3:0] attack = (ctrl[19:16] == 0) ? 4'd1 : ctrl[19:16];
+   wire [3:0] decay = (ctrl[23:20] == 0) ? 4'd1 : ctrl[23:20];
+
+   reg [31:0] power;
+   always @(posedge clk)
+     case(ctrl[2:1])
+       2'd0 : power <= power_in[31:0];
+       2'd1 : power <= power_in[63:32];
+       2'd2 : power <= power_in[95:64];
+       2'd3 : power <= power_in[127:96];
+     endcase // case (ctrl[2:1])
+
+   localparam AGC_EVAL = 0;
+   localparam AGC_SPI = 1;
+   localparam AGC_WAIT = 2;
+
+   reg [1:0]  state;
+   reg [31:0] cycles;
+   reg [3:0]  over, under;
+   reg [4:0]  code;
+   reg [15:0] seq;
+
+   // the register write, left aligned 16 bits with the write flag
+   assign spi_config = {spi_reg[31:16], spi_ctrl, 1'b1, spi_reg[14:8], spi_reg[7:5], code, 16'd0};
+
+   always @(posedge clk)
+     if(rst)
+       begin
+	  state <= AGC_EVAL;
+	  cycles <= 0;
+	  over <= 0;
+	  under <= 0;
+	  code <= 0;
+	  seq <= 0;
+	  spi_valid <= 0;
+	  event_stb <= 0;
+       end
+     else
+       begin
+	  event_stb <= 0;
+	  if(code_load)
+	    code <= spi_reg[4:0];
+	  case(state)
+	    AGC_EVAL :
+	      if(~enable | ctrl_changed | code_load)
+		begin
+		   cycles <= 0;
+		   over <= 0;
+		   under <= 0;
+		end
+	      else if(cycles < period)
+		cycles <= cycles + 1;
+	      else
+		begin
+		   cycles <= 0;
+		   if((power > target_hi) & (code > min_code))
+		     begin
+			under <= 0;
+			if(over + 4'd1 >= attack)
+			  begin
+			     over <= 0;
+			     code <= code - 5'd1;
+			     event_power <= power;
+			     spi_valid <= 1;
+			     state <= AGC_SPI;
+			  end
+			else
+			  over <= over + 4'd1;
+		     end
+		   else if((power < target_lo) & (code < max_code))
+		     begin
+			over <= 0;
+			if(under + 4'd1 >= decay)
+			  begin
+			     under <= 0;
+			     code <= code + 5'd1;
+			     event_power <= power;
+			     spi_valid <= 1;
+			     state <= AGC_SPI;
+			  end
+			else
+			  under <= under + 4'd1;
+		     end
+		   else
+		     begin
+			over <= 0;
+			under <= 0;
+		     end
+		end
+	    AGC_SPI :
+	      if(spi_ready)
+		begin
+		   spi_valid <= 0;
+		   state <= AGC_WAIT;
+		end
+	    AGC_WAIT :
+	      if(spi_idle)
+		begin
+		   event_stb <= 1;
+		   seq <= seq + 16'd1;
+		   state <= AGC_EVAL;
+		end
+	    default :
+	      state <= AGC_EVAL;
+	  endcase // case (state)
+       end
+
+   assign event_word = {seq, 7'd0, UNIT[0], 3'd0, code};
+   assign status = {enable, 8'd0, state != AGC_EVAL, 1'b0, code};
+
+endmodule // rx_agc
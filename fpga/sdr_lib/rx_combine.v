@@ -0,0 +1,121 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Weighted sum of two baseband streams for receive diversity (MRC).
+//! out = wa*a + wb*b with complex weights, 1.0 is 2^14, clipped to 16 bits.
+//! The samples of b are held, each strobe of a takes the latest one: both
+//! DDCs run at the same rate, started together. Four multipliers serve the
+//! two weights in turn, the strobes of a must be at least 2 clocks apart.
+//! Disabled, a passes through.
+//!
+//! Registers:
+//!  BASE+0 {q[15:0], i[15:0]} next weight of a
+//!  BASE+1 {q[15:0], i[15:0]} next weight of b
+//!  BASE+2 [0] enable, a write takes both next weights at once
+
+module rx_combine
+  #(parameter BASE = 0)
+   (input clk, input rst,
+    input set_stb, input [7:0] set_addr, input [31:0] set_data,
+    input stb_a, input [31:0] sample_a,
+    input stb_b, input [31:0] sample_b,
+    output enable,
+    output stb_out, output [31:0] sample_out);
+
+   wire [31:0] wa_next, wb_next;
+   wire        commit;
+   setting_reg #(.my_addr(BASE+0)) sr_wa
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(wa_next),.changed());
+   setting_reg #(.my_addr(BASE+1)) sr_wb
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(wb_next),.changed());
+   setting_reg #(.my_addr(BASE+2), .width(1)) sr_enable
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(enable),.changed(commit));
+
+   // weights only change between samples, never within one sum
+   reg [31:0]  wa, wb;
+   always @(posedge clk)
+     if(rst)
+       begin
+	  wa <= 0;
+	  wb <= 0;
+       end
+     else if(commit)
+       begin
+	  wa <= wa_next;
+	  wb <= wb_next;
+       end
+
+   reg [31:0]  held_b;
+   always @(posedge clk)
+     if(stb_b)
+       held_b <= sample_b;
+
+   // s1: products of a on the multipliers, s2: those of b, s3: the sum
+   reg [31:0]  xa, xb;
+   reg [3:0]   stb_d;
+   always @(posedge clk)
+     begin
+	stb_d <= rst? 4'b0 : {stb_d[2:0], stb_a & enable};
+	if(stb_a)
+	  begin
+	     xa <= sample_a;
+	     xb <= stb_b? sample_b : held_b;
+	  end
+     end
+
+   wire [31:0] x = stb_d[0]? xa : xb;
+   wire [31:0] w = stb_d[0]? wa : wb;
+   wire [35:0] p_ii, p_qq, p_iq, p_qi;
+
+   MULT18X18S mult_ii
+     (.P(p_ii), .A({{2{x[31]}},x[31:16]}), .B({{2{w[15]}},w[15:0]}), .C(clk), .CE(1'b1), .R(rst) );
+   MULT18X18S mult_qq
+     (.P(p_qq), .A({{2{x[15]}},x[15:0]}), .B({{2{w[31]}},w[31:16]}), .C(clk), .CE(1'b1), .R(rst) );
+   MULT18X18S mult_iq
+     (.P(p_iq), .A({{2{x[31]}},x[31:16]}), .B({{2{w[31]}},w[31:16]}), .C(clk), .CE(1'b1), .R(rst) );
+   MULT18X18S mult_qi
+     (.P(p_qi), .A({{2{x[15]}},x[15:0]}), .B({{2{w[15]}},w[15:0]}), .C(clk), .CE(1'b1), .R(rst) );
+
+   // each product is at most 2^30, the sum of four fits 33 bits
+   wire [32:0] re = {p_ii[31],p_ii[31:0]} - {p_qq[31],p_qq[31:0]};
+   wire [32:0] im = {p_iq[31],p_iq[31:0]} + {p_qi[31],p_qi[31:0]};
+   reg [33:0]  acc_i, acc_q;
+   always @(posedge clk)
+     if(stb_d[1])
+       begin
+	  acc_i <= {re[32],re};
+	  acc_q <= {im[32],im};
+       end
+
+   wire [33:0] sum_i = acc_i + {re[32],re} + (1 << 13);
+   wire [33:0] sum_q = acc_q + {im[32],im} + (1 << 13);
+   wire [15:0] clip_i, clip_q;
+   clip #(.bits_in(20), .bits_out(16)) clip_re (.in(sum_i[33:14]), .out(clip_i));
+   clip #(.bits_in(20), .bits_out(16)) clip_im (.in(sum_q[33:14]), .out(clip_q));
+
+   reg [31:0]  sum;
+   always @(posedge clk)
+     if(stb_d[2])
+       sum <= {clip_i, clip_q};
+
+   assign stb_out = enable? stb_d[3] : stb_a;
+   assign sample_out = enable? sum : sample_a;
+
+endmodule // rx_combine
@@ -20,12 +20,14 @@
 module rx_dcoffset 
   #(parameter WIDTH=16,
     parameter ADDR=8'd0,
-    parameter alpha_shift=20)
+    parameter alpha_shift=20,
+    parameter SHIFT_ADDR=256)  // time constant register, out of range: fixed at 2^alpha_shift
    (input clk, input rst, 
     input set_stb, input [7:0] set_addr, input [31:0] set_data,
     input [WIDTH-1:0] in, output [WIDTH-1:0] out);
    
    wire 	      set_now = set_stb & (ADDR == set_addr);
+   wire 	      set_shift = set_stb & (SHIFT_ADDR == set_addr);
    
    reg 		      fixed;  // uses fixed offset
    wire [WIDTH-1:0]   fixed_dco;
@@ -34,6 +36,17 @@ module rx_dcoffset
    reg [int_width-1:0] integrator;
    wire [WIDTH-1:0]    quantized;
 
+   // tracking time constant of 2^shift samples, scales the integrator input
+   reg [4:0] 	       shift;
+   wire [4:0] 	       step_shift = (shift > alpha_shift) ? 5'd0 : alpha_shift - shift;
+   wire [int_width-1:0] step = {{(alpha_shift){out[WIDTH-1]}},out} << step_shift;
+
+   always @(posedge clk)
+     if(rst)
+       shift <= alpha_shift;
+     else if(set_shift)
+       shift <= set_data[4:0];
+
    always @(posedge clk)
      if(rst)
        begin
@@ -47,7 +60,7 @@ module rx_dcoffset
 	    integrator <= {set_data[29:0],{(int_width-30){1'b0}}};
        end
      else if(~fixed)
-       integrator <= integrator +  {{(alpha_shift){out[WIDTH-1]}},out};
+       integrator <= integrator + step;
 
    round_sd #(.WIDTH_IN(int_width),.WIDTH_OUT(WIDTH)) round_sd
      (.clk(clk), .reset(rst), .in(integrator), .strobe_in(1'b1), .out(quantized), .strobe_out());
@@ -0,0 +1,133 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Programmable FIR channel filter for I and Q, one multiply per clock.
+//! Up to 2^DEPTH taps of 18 bits, 1.0 is 2^16, the input is taken at its
+//! top 18 bits like the scaler after it. A sample takes the number of taps
+//! plus 4 clocks, the host keeps that within the clocks between strobes,
+//! a strobe while busy is dropped. With zero taps the filter is bypassed.
+//!
+//! Registers:
+//!  BASE+0 [DEPTH:0] number of taps, zero bypasses, restarts the tap load
+//!  BASE+1 [17:0] next tap, from the one applied to the newest sample
+
+module rx_fir
+  #(parameter BASE = 0,
+    parameter WIDTH = 24,
+    parameter DEPTH = 6)
+   (input clk, input rst, input run,
+    input set_stb, input [7:0] set_addr, input [31:0] set_data,
+    input stb_in, input [WIDTH-1:0] i_in, input [WIDTH-1:0] q_in,
+    output reg stb_out, output reg [WIDTH-1:0] i_out, output reg [WIDTH-1:0] q_out);
+
+   wire [DEPTH:0] num_taps;
+   wire 	  num_changed;
+   setting_reg #(.my_addr(BASE+0), .width(DEPTH+1)) sr_num
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(num_taps),.changed(num_changed));
+
+   wire 	  bypass = (num_taps == 0);
+   wire 	  tap_stb = set_stb & (set_addr == BASE+1);
+
+   reg [17:0] 	  taps [0:(1<<DEPTH)-1];
+   reg [DEPTH-1:0] ld_addr;
+
+   always @(posedge clk)
+     if(rst | num_changed)
+       ld_addr <= 0;
+     else if(tap_stb)
+       ld_addr <= ld_addr + 1;
+
+   always @(posedge clk)
+     if(tap_stb)
+       taps[ld_addr] <= set_data[17:0];
+
+   // delay line, the newest sample at wr_addr-1
+   reg [17:0] 	  line_i [0:(1<<DEPTH)-1];
+   reg [17:0] 	  line_q [0:(1<<DEPTH)-1];
+   reg [DEPTH-1:0] wr_addr, rd_addr, tap_addr;
+   reg [DEPTH:0]   left;
+   reg 		   busy;
+   wire 	   start = stb_in & run & ~bypass & ~busy;
+
+   always @(posedge clk)
+     if(start)
+       begin
+	  line_i[wr_addr] <= i_in[WIDTH-1:WIDTH-18];
+	  line_q[wr_addr] <= q_in[WIDTH-1:WIDTH-18];
+       end
+
+   always @(posedge clk)
+     if(rst | ~run)
+       begin
+	  busy <= 0;
+	  wr_addr <= 0;
+       end
+     else if(start)
+       begin
+	  busy <= 1;
+	  rd_addr <= wr_addr;
+	  tap_addr <= 0;
+	  left <= num_taps;
+	  wr_addr <= wr_addr + 1;
+       end
+     else if(busy)
+       begin
+	  rd_addr <= rd_addr - 1;
+	  tap_addr <= tap_addr + 1;
+	  left <= left - 1;
+	  if(left == 1)
+	    busy <= 0;
+       end
+
+   // multiply, then accumulate the products of one sample
+   wire [35:0] 	   prod_i, prod_q;
+   MULT18X18S mult_i
+     (.P(prod_i), .A(line_i[rd_addr]), .B(taps[tap_addr]), .C(clk), .CE(1'b1), .R(rst) );
+   MULT18X18S mult_q
+     (.P(prod_q), .A(line_q[rd_addr]), .B(taps[tap_addr]), .C(clk), .CE(1'b1), .R(rst) );
+
+   reg 		   prod_valid, prod_first, prod_last, acc_done;
+   reg [41:0] 	   acc_i, acc_q;
+   always @(posedge clk)
+     begin
+	prod_valid <= busy;
+	prod_first <= busy & (tap_addr == 0);
+	prod_last <= busy & (left == 1);
+	acc_done <= prod_valid & prod_last;
+	if(prod_valid)
+	  begin
+	     acc_i <= (prod_first ? 42'd0 : acc_i) + {{6{prod_i[35]}},prod_i};
+	     acc_q <= (prod_first ? 42'd0 : acc_q) + {{6{prod_q[35]}},prod_q};
+	  end
+     end
+
+   // back to WIDTH bits, the taps are 1.0 at 2^16 and the input lost WIDTH-18 bits
+   wire [WIDTH-1:0] fir_i, fir_q;
+   clip #(.bits_in(42-(16-(WIDTH-18))), .bits_out(WIDTH)) clip_i
+     (.in(acc_i[41:16-(WIDTH-18)]), .out(fir_i));
+   clip #(.bits_in(42-(16-(WIDTH-18))), .bits_out(WIDTH)) clip_q
+     (.in(acc_q[41:16-(WIDTH-18)]), .out(fir_q));
+
+   always @(posedge clk)
+     begin
+	stb_out <= bypass ? stb_in : acc_done;
+	i_out <= bypass ? i_in : fir_i;
+	q_out <= bypass ? q_in : fir_q;
+     end
+
+endmodule // rx_fir
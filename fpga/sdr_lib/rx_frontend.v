@@ -1,7 +1,8 @@
 
 module rx_frontend
   #(parameter BASE = 0,
-    parameter IQCOMP_EN = 1)
+    parameter IQCOMP_EN = 1,
+    parameter DC_SHIFT_ADDR = 256)  // dc tracking time constant, see rx_dcoffset
    (input clk, input rst,
     input set_stb, input [7:0] set_addr, input [31:0] set_data,
 
@@ -39,11 +40,11 @@ module rx_frontend
    generate
       if(IQCOMP_EN == 1)
 	begin
-	   rx_dcoffset #(.WIDTH(18),.ADDR(BASE+3)) rx_dcoffset_i
+	   rx_dcoffset #(.WIDTH(18),.ADDR(BASE+3),.SHIFT_ADDR(DC_SHIFT_ADDR)) rx_dcoffset_i
 	     (.clk(clk),.rst(rst),.set_stb(set_stb),.set_addr(set_addr),.set_data(set_data),
 	      .in({adc_i,2'b00}),.out(adc_i_ofs));
 	   
-	   rx_dcoffset #(.WIDTH(18),.ADDR(BASE+4)) rx_dcoffset_q
+	   rx_dcoffset #(.WIDTH(18),.ADDR(BASE+4),.SHIFT_ADDR(DC_SHIFT_ADDR)) rx_dcoffset_q
 	     (.clk(clk),.rst(rst),.set_stb(set_stb),.set_addr(set_addr),.set_data(set_data),
 	      .in({adc_q,2'b00}),.out(adc_q_ofs));
 	   
@@ -65,11 +66,11 @@ module rx_frontend
 	end // if (IQCOMP_EN == 1)
       else
 	begin
-	   rx_dcoffset #(.WIDTH(24),.ADDR(BASE+3)) rx_dcoffset_i
+	   rx_dcoffset #(.WIDTH(24),.ADDR(BASE+3),.SHIFT_ADDR(DC_SHIFT_ADDR)) rx_dcoffset_i
 	     (.clk(clk),.rst(rst),.set_stb(set_stb),.set_addr(set_addr),.set_data(set_data),
 	      .in({adc_i,8'b00}),.out(i_out));
 	   
-	   rx_dcoffset #(.WIDTH(24),.ADDR(BASE+4)) rx_dcoffset_q
+	   rx_dcoffset #(.WIDTH(24),.ADDR(BASE+4),.SHIFT_ADDR(DC_SHIFT_ADDR)) rx_dcoffset_q
 	     (.clk(clk),.rst(rst),.set_stb(set_stb),.set_addr(set_addr),.set_data(set_data),
 	      .in({adc_q,8'b00}),.out(q_out));
 	end // else: !if(IQCOMP_EN == 1)
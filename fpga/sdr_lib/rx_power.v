@@ -0,0 +1,56 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Averaged I^2+Q^2 of the baseband samples, for readback.
+//! Single pole average over 2^avg_shift samples, full scale is 2^31.
+
+module rx_power
+  (input clk, input rst, input clear,
+   input stb, input [31:0] sample,
+   input [3:0] avg_shift,
+   output [31:0] power);
+
+   wire [35:0] prod_i, prod_q;
+   reg [1:0]   stb_d;
+
+   MULT18X18S mult_i
+     (.P(prod_i), .A({{2{sample[31]}},sample[31:16]}), .B({{2{sample[31]}},sample[31:16]}), .C(clk), .CE(stb), .R(rst) );
+   MULT18X18S mult_q
+     (.P(prod_q), .A({{2{sample[15]}},sample[15:0]}), .B({{2{sample[15]}},sample[15:0]}), .C(clk), .CE(stb), .R(rst) );
+
+   // each square is at most 2^30, the sum fits 32 bits unsigned
+   reg [31:0]  mag_sq;
+   always @(posedge clk)
+     begin
+	stb_d <= {stb_d[0], stb};
+	if(stb_d[0])
+	  mag_sq <= prod_i[31:0] + prod_q[31:0];
+     end
+
+   // acc holds power * 2^avg_shift
+   reg [46:0]  acc;
+   wire [46:0] acc_scaled = acc >> avg_shift;
+
+   always @(posedge clk)
+     if(rst | clear)
+       acc <= 0;
+     else if(stb_d[1])
+       acc <= acc + mag_sq - acc_scaled;
+
+   assign power = acc_scaled[31:0];
+
+endmodule // rx_power
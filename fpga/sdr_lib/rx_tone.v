@@ -0,0 +1,154 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Single bin tone meter, for calibration without streaming.
+//! The baseband is mixed down by an NCO and averaged over 2^len_shift
+//! samples, the result is the power of the mean: one DFT bin.
+//! BASE+0 phase increment per sample, the bin at -phase_inc/2^32 of the rate
+//! BASE+1 [5] enable, [4:0] len_shift up to 20
+//! Any write restarts it: the first SETTLE samples are dropped so the
+//! filters flush, then a new result comes every 2^len_shift samples.
+//! power is {valid, I^2+Q^2 of the mean}, valid from the first result on,
+//! the CORDIC gain of 1.647/2 squared is in it, full scale is 2^31.
+//! enable keeps the DDC running while nothing streams.
+
+module rx_tone
+  #(parameter BASE = 0)
+  (input clk, input rst,
+   input set_stb, input [7:0] set_addr, input [31:0] set_data,
+   input stb, input [31:0] sample,
+   output enable,
+   output [31:0] power);
+
+   localparam SETTLE = 64;
+
+   wire [31:0] phase_inc;
+   wire [4:0]  len_shift_reg;
+   wire        changed_phase, changed_ctrl;
+   setting_reg #(.my_addr(BASE+0)) sr_phase_inc
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(phase_inc),.changed(changed_phase));
+
+   setting_reg #(.my_addr(BASE+1), .width(6)) sr_ctrl
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out({enable, len_shift_reg}),.changed(changed_ctrl));
+
+   wire        restart = rst | changed_phase | changed_ctrl | ~enable;
+   wire [4:0]  len_shift = (len_shift_reg > 5'd20) ? 5'd20 : len_shift_reg;
+
+   // NCO, the CORDIC rotates each sample by the phase
+   reg [31:0]  phase;
+   reg [17:0]  cordic_xi, cordic_yi;
+   reg [23:0]  cordic_zi;
+   always @(posedge clk)
+     if(restart)
+       phase <= 0;
+     else if(stb)
+       phase <= phase + phase_inc;
+
+   always @(posedge clk)
+     if(stb)
+       begin
+	  cordic_xi <= {{2{sample[31]}},sample[31:16]};
+	  cordic_yi <= {{2{sample[15]}},sample[15:0]};
+	  cordic_zi <= phase[31:8];
+       end
+
+   wire [17:0] mixed_i, mixed_q;
+   cordic_z24 #(.bitwidth(18)) cordic
+     (.clock(clk), .reset(rst), .enable(1'b1),
+      .xi(cordic_xi), .yi(cordic_yi), .zi(cordic_zi),
+      .xo(mixed_i), .yo(mixed_q), .zo() );
+
+   // input register, then the CORDIC input and its 20 stages
+   reg [21:0]  stb_d;
+   always @(posedge clk)
+     if(restart)
+       stb_d <= 0;
+     else
+       stb_d <= {stb_d[20:0], stb};
+   wire        mixed_stb = stb_d[21];
+
+   // acc sums up to 2^20 samples of 18 bits
+   reg signed [37:0] acc_i, acc_q;
+   reg [20:0]  count;
+   reg [6:0]   settle;
+   reg signed [17:0] mean_i, mean_q;
+   reg 	       done;
+
+   wire signed [37:0] sum_i = acc_i + {{20{mixed_i[17]}},mixed_i};
+   wire signed [37:0] sum_q = acc_q + {{20{mixed_q[17]}},mixed_q};
+   wire        last = (count == ((21'd1 << len_shift) - 21'd1));
+
+   always @(posedge clk)
+     if(restart)
+       begin
+	  acc_i <= 0; acc_q <= 0;
+	  count <= 0;
+	  settle <= 0;
+	  done <= 0;
+       end
+     else
+       begin
+	  done <= 0;
+	  if(mixed_stb)
+	    if(settle != SETTLE)
+	      settle <= settle + 7'd1;
+	    else if(last)
+	      begin
+		 // the mean of the bin, within the range of a sample
+		 mean_i <= sum_i >>> len_shift;
+		 mean_q <= sum_q >>> len_shift;
+		 acc_i <= 0; acc_q <= 0;
+		 count <= 0;
+		 done <= 1;
+	      end
+	    else
+	      begin
+		 acc_i <= sum_i;
+		 acc_q <= sum_q;
+		 count <= count + 21'd1;
+	      end
+       end
+
+   // power of the mean, latched a cycle after the squares
+   wire [35:0] sq_i, sq_q;
+   MULT18X18S mult_i
+     (.P(sq_i), .A(mean_i), .B(mean_i), .C(clk), .CE(done), .R(rst) );
+   MULT18X18S mult_q
+     (.P(sq_q), .A(mean_q), .B(mean_q), .C(clk), .CE(done), .R(rst) );
+
+   reg 	       done_d;
+   reg 	       valid;
+   reg [30:0]  power_reg;
+   wire [36:0] sq_sum = {1'b0, sq_i} + {1'b0, sq_q};
+
+   always @(posedge clk)
+     begin
+	done_d <= done & ~restart;
+	if(restart)
+	  valid <= 0;
+	else if(done_d)
+	  begin
+	     valid <= 1;
+	     power_reg <= (sq_sum[36:31] != 0) ? 31'h7fffffff : sq_sum[30:0];
+	  end
+     end
+
+   assign power = {valid, power_reg};
+
+endmodule // rx_tone
@@ -0,0 +1,138 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! GMSK modulator between vita_tx_control and the DUC.
+//! Each word from the deframer is [31:24] number of bits, up to 24, and
+//! [23:0] the bits, sent LSB first. The word is taken when the last bit of
+//! the one before is out, so the burst ends after its last symbol and not
+//! at the last strobe of the deframer. Every symbol lasts SPS samples.
+//! The phase step of each sample comes from a table the host loads, by the
+//! last three symbols and the sample in the symbol, so the table holds
+//! the pulse shape and the waveform lags the bits by the pulse length.
+//! The phase goes through a CORDIC for {I16,Q16}, which takes about 20
+//! clocks, so the samples must be at least 24 clocks apart.
+//!
+//! Registers:
+//!  BASE+0 [4:0] samples per symbol up to 16, zero passes the samples through,
+//!         [8] GSM differential encoding of the bits
+//!  BASE+1 [30:24] table entry {last three symbols, sample}, [23:0] phase
+//!         step, a full turn is 2^24
+
+module tx_gmsk
+  #(parameter BASE = 0)
+   (input clk, input rst,
+    input set_stb, input [7:0] set_addr, input [31:0] set_data,
+
+    // from vita_tx_control
+    input [31:0] word, input word_run, output word_stb,
+
+    // to the DUC, sample_stb asks for the next sample
+    input sample_stb, output [31:0] sample, output run);
+
+   wire [8:0] mode;
+   setting_reg #(.my_addr(BASE+0), .width(9)) sr_mode
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(mode),.changed());
+
+   wire [4:0] sps = mode[4:0];
+   wire       diff_enc = mode[8];
+   wire       enable = (sps != 0);
+   wire [3:0] last_j = sps - 5'd1;
+
+   reg [23:0] steps [0:127];
+   always @(posedge clk)
+     if(set_stb & (set_addr == BASE+1))
+       steps[set_data[30:24]] <= set_data[23:0];
+
+   // bits of the current word, the next word is fetched once they are out
+   reg [23:0] bits;
+   reg [4:0]  count;
+   reg 	      fetch, busy;
+   wire       need = enable & word_run & (count == 0) & ~fetch;
+   assign word_stb = enable ? need : sample_stb;
+
+   // the last three symbols, zero for +1, the newest in bit 0,
+   // a symbol comes in with the first sample of its period
+   reg [2:0]  syms;
+   reg [3:0]  j;
+   reg 	      prev_bit;
+   reg [23:0] phase;
+   wire       sym_start = sample_stb & busy & (j == 0);
+   wire       bit_in = bits[0] ^ (diff_enc & prev_bit);
+   wire [2:0] syms_now = (sym_start & (count != 0)) ? {syms[1:0], bit_in} : syms;
+
+   always @(posedge clk)
+     if(rst | ~enable)
+       begin
+	  fetch <= 0;
+	  count <= 0;
+	  busy <= 0;
+       end
+     else
+       begin
+	  fetch <= need;
+	  if(fetch)
+	    begin
+	       bits <= word[23:0];
+	       count <= (word[31:24] > 24) ? 5'd24 : word[28:24];
+	       busy <= busy | (word[31:24] != 0);
+	    end
+	  else if(sym_start)
+	    if(count != 0)
+	      begin
+		 bits <= bits >> 1;
+		 count <= count - 5'd1;
+	      end
+	    else
+	      busy <= 0; // out of bits, the burst is over or underran
+       end
+
+   always @(posedge clk)
+     if(rst | ~busy)
+       begin
+	  syms <= 0;
+	  j <= 0;
+	  prev_bit <= 1;
+	  phase <= 0;
+       end
+     else if(sample_stb)
+       begin
+	  phase <= phase + steps[{syms_now, j}];
+	  j <= (j == last_j) ? 4'd0 : j + 4'd1;
+	  syms <= syms_now;
+	  if(sym_start & (count != 0))
+	    prev_bit <= bits[0];
+       end
+
+   // constant envelope, 0.95 of full scale after the CORDIC gain of 1.647
+   wire [15:0] cos_out, sin_out;
+   cordic_z24 #(.bitwidth(16)) cordic
+     (.clock(clk), .reset(rst), .enable(1'b1),
+      .xi(16'd18903), .yi(16'd0), .zi(phase),
+      .xo(cos_out), .yo(sin_out), .zo());
+
+   reg [31:0] sample_held;
+   always @(posedge clk)
+     if(rst | ~busy)
+       sample_held <= 0;
+     else if(sample_stb)
+       sample_held <= {cos_out, sin_out};
+
+   assign sample = enable ? sample_held : word;
+   assign run = enable ? (word_run | busy) : word_run;
+
+endmodule // tx_gmsk
@@ -0,0 +1,97 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Power ramps at the edges of the TX bursts, before the DUC.
+//! The first len samples after run rises are scaled up by the gain table,
+//! entry 0 first. When run falls the last sample of the burst is held and
+//! scaled down by the table in reverse for len more samples, run stays
+//! high until the ramp is out. A burst that starts during a ramp down
+//! starts its ramp up from entry 0. The samples are registered on stb,
+//! so sample_o and run_o lag by one strobe.
+//!
+//! Registers:
+//!  BASE+0 [21:16] table entry, [15:0] gain, 65535 is unity
+//!  BASE+1 [6:0] ramp length in samples up to 64, zero passes the samples
+
+module tx_ramp
+  #(parameter BASE = 0)
+   (input clk, input rst,
+    input set_stb, input [7:0] set_addr, input [31:0] set_data,
+    input stb, input [31:0] sample, input run,
+    output reg [31:0] sample_o, output reg run_o);
+
+   wire [6:0] len_reg;
+   setting_reg #(.my_addr(BASE+1), .width(7)) sr_len
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(len_reg),.changed());
+
+   wire [6:0] len = (len_reg > 7'd64) ? 7'd64 : len_reg;
+
+   reg [15:0] gains [0:63];
+   always @(posedge clk)
+     if(set_stb & (set_addr == BASE+0))
+       gains[set_data[21:16]] <= set_data[15:0];
+
+   // up counts the samples of the burst up to len, down the ramp down left
+   reg [6:0]  up, down;
+   reg [31:0] held;
+   reg 	      run_d;
+   wire       rise = run & ~run_d;
+   wire       fall = ~run & run_d;
+   wire       ramp_up = run & (rise | (up < len));
+   wire       ramp_down = ~run & (fall | (down != 0));
+   wire [5:0] index = ramp_up ? (rise ? 6'd0 : up[5:0]) : (fall ? len - 7'd1 : down - 7'd1);
+   wire [31:0] in = ramp_down ? (fall ? sample_o : held) : sample;
+
+   wire signed [16:0] gain = {1'b0, gains[index]};
+   wire signed [32:0] prod_i = $signed(in[31:16]) * gain;
+   wire signed [32:0] prod_q = $signed(in[15:0]) * gain;
+
+   always @(posedge clk)
+     if(rst)
+       begin
+	  up <= 0;
+	  down <= 0;
+	  run_d <= 0;
+	  run_o <= 0;
+	  sample_o <= 0;
+       end
+     else if(stb)
+       begin
+	  run_d <= run;
+	  if(rise)
+	    up <= (len == 0) ? 7'd0 : 7'd1;
+	  else if(ramp_up)
+	    up <= up + 7'd1;
+	  if(run)
+	    down <= 0;
+	  else if(fall)
+	    begin
+	       down <= (len == 0) ? 7'd0 : len - 7'd1;
+	       held <= sample_o;
+	    end
+	  else if(down != 0)
+	    down <= down - 7'd1;
+
+	  run_o <= run | (ramp_down & (len != 0));
+	  if((len != 0) & (ramp_up | ramp_down))
+	    sample_o <= {prod_i[31:16], prod_q[31:16]};
+	  else
+	    sample_o <= sample;
+       end
+
+endmodule // tx_ramp
@@ -19,7 +19,8 @@
 module rxmac_to_ll8
   (input clk, input reset, input clear,
    input [7:0] rx_data, input rx_valid, input rx_error, input rx_ack,
-   output [7:0] ll_data, output ll_sof, output ll_eof, output ll_error, output ll_src_rdy, input ll_dst_rdy );
+   output [7:0] ll_data, output ll_sof, output ll_eof, output ll_error, output ll_src_rdy, input ll_dst_rdy,
+   output overrun );
 
    reg [2:0] xfer_state;
 
@@ -37,6 +38,9 @@ module rxmac_to_ll8
    assign ll_sof 	    = ((xfer_state==XFER_IDLE)|(xfer_state==XFER_ERROR)|(xfer_state==XFER_OVERRUN));
    assign ll_eof 	    = (rx_ack | (xfer_state==XFER_ERROR) | (xfer_state==XFER_OVERRUN));
    assign ll_error 	    = (xfer_state == XFER_ERROR)|(xfer_state==XFER_OVERRUN);
+
+   // One cycle when a frame is cut because the FIFO is full
+   assign overrun 	    = (xfer_state == XFER_ACTIVE) & ~rx_error & rx_valid & ~ll_dst_rdy;
    
    always @(posedge clk)
      if(reset | clear)
@@ -24,6 +24,7 @@ module simple_gemac
 
    // Flow Control Interface
    input pause_req, input [15:0] pause_time_req, input pause_respect_en,
+   output pause_rcvd, output [15:0] pause_quanta_rcvd,  // rx_clk domain
 
    // Settings
    input [47:0] ucast_addr, input [47:0] mcast_addr,
@@ -44,8 +45,7 @@ module simple_gemac
    reset_sync reset_sync_tx (.clk(tx_clk),.reset_in(reset),.reset_out(rst_txclk));
    reset_sync reset_sync_rx (.clk(rx_clk),.reset_in(reset),.reset_out(rst_rxclk));
 
-   wire [15:0] pause_quanta_rcvd;
-   wire        pause_rcvd, pause_apply, paused;
+   wire        pause_apply, paused;
    
    simple_gemac_tx simple_gemac_tx
      (.clk125(clk125),.reset(rst_txclk),
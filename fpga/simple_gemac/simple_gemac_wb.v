@@ -44,7 +44,9 @@ module simple_gemac_wb
    output pass_ucast, output pass_mcast, output pass_bcast,
    output pass_pause, output pass_all, 
    output pause_respect_en, output pause_request_en, 
-   output [15:0] pause_time, output [15:0] pause_thresh  );
+   output [15:0] pause_time, output [15:0] pause_thresh,
+   input pause_sent_stb, input pause_rcvd_stb, input [15:0] pause_quanta_rcvd,
+   input rx_frame_stb, input rx_error_stb, input rx_overrun_stb, input tx_frame_stb  );
 
    wire   acc 	  = wb_cyc & wb_stb;
    wire   wr_acc  = wb_cyc & wb_stb & wb_we;
@@ -159,9 +161,53 @@ module simple_gemac_wb
    wb_reg_pausethresh (.clk(wb_clk), .rst(wb_rst), .adr(wb_adr[7:2]), .wr_acc(wr_acc),
 		       .dat_i(wb_dat_i), .dat_o(pause_thresh) );
    
+   // PAUSE frame counters, read only
+   reg [31:0] pause_sent_cnt, pause_rcvd_cnt;
+   reg [15:0] pause_quanta_last;
+   always @(posedge wb_clk)
+     if(wb_rst)
+       begin
+	  pause_sent_cnt <= 0;
+	  pause_rcvd_cnt <= 0;
+	  pause_quanta_last <= 0;
+       end
+     else
+       begin
+	  if(pause_sent_stb)
+	    pause_sent_cnt <= pause_sent_cnt + 1;
+	  if(pause_rcvd_stb)
+	    begin
+	       pause_rcvd_cnt <= pause_rcvd_cnt + 1;
+	       pause_quanta_last <= pause_quanta_rcvd;
+	    end
+       end
+
+   // Frame counters, read only: good frames, CRC/length/GMII errors,
+   // frames cut by a full RX FIFO and frames sent
+   reg [31:0] rx_frame_cnt, rx_error_cnt, rx_overrun_cnt, tx_frame_cnt;
+   always @(posedge wb_clk)
+     if(wb_rst)
+       begin
+	  rx_frame_cnt <= 0;
+	  rx_error_cnt <= 0;
+	  rx_overrun_cnt <= 0;
+	  tx_frame_cnt <= 0;
+       end
+     else
+       begin
+	  if(rx_frame_stb)
+	    rx_frame_cnt <= rx_frame_cnt + 1;
+	  if(rx_error_stb)
+	    rx_error_cnt <= rx_error_cnt + 1;
+	  if(rx_overrun_stb)
+	    rx_overrun_cnt <= rx_overrun_cnt + 1;
+	  if(tx_frame_stb)
+	    tx_frame_cnt <= tx_frame_cnt + 1;
+       end
+
    always @(posedge wb_clk)
      case(wb_adr[7:2])
-       //0 : wb_dat_o <= misc_settings;
+       0 : wb_dat_o <= misc_settings;
        //1 : wb_dat_o <= ucast_addr[47:32];
        //2 : wb_dat_o <= ucast_addr[31:0];
        //3 : wb_dat_o <= mcast_addr[47:32];
@@ -172,8 +218,15 @@ module simple_gemac_wb
        8 : wb_dat_o <= MIICOMMAND;
        9 : wb_dat_o <= MIISTATUS;
        10: wb_dat_o <= MIIRX_DATA;
-       //11: wb_dat_o <= pause_time;
-       //12: wb_dat_o <= pause_thresh;
+       11: wb_dat_o <= pause_time;
+       12: wb_dat_o <= pause_thresh;
+       13: wb_dat_o <= pause_rcvd_cnt;
+       14: wb_dat_o <= pause_sent_cnt;
+       15: wb_dat_o <= pause_quanta_last;
+       16: wb_dat_o <= rx_frame_cnt;
+       17: wb_dat_o <= rx_error_cnt;
+       18: wb_dat_o <= rx_overrun_cnt;
+       19: wb_dat_o <= tx_frame_cnt;
      endcase // case (wb_adr[7:2])
    
 endmodule // simple_gemac_wb
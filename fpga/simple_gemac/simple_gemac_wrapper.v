@@ -48,6 +48,11 @@ module simple_gemac_wrapper
    wire 	  pause_req;
    wire 	  pause_request_en, pause_respect_en;
    wire [15:0] 	  pause_time, pause_thresh, pause_time_req, rx_fifo_space;
+   wire 	  pause_rcvd;
+   wire [15:0] 	  pause_quanta_rcvd;
+   wire 	  pause_sent_wb, pause_rcvd_wb;
+   wire 	  rx_overrun;
+   wire 	  rx_frame_wb, rx_error_wb, rx_overrun_wb, tx_frame_wb;
 
    wire [31:0] 	  debug_state;
       
@@ -63,6 +68,7 @@ module simple_gemac_wrapper
       .GMII_RX_ER(GMII_RX_ER), .GMII_RXD(GMII_RXD),
       .pause_req(RX_FLOW_CTRL ? pause_req : 1'b0), .pause_time_req(RX_FLOW_CTRL ? pause_time_req : 16'd0), 
       .pause_respect_en(pause_respect_en),
+      .pause_rcvd(pause_rcvd), .pause_quanta_rcvd(pause_quanta_rcvd),
       .ucast_addr(ucast_addr), .mcast_addr(mcast_addr),
       .pass_ucast(pass_ucast), .pass_mcast(pass_mcast), .pass_bcast(pass_bcast), 
       .pass_pause(pass_pause), .pass_all(pass_all),
@@ -82,7 +88,26 @@ module simple_gemac_wrapper
       .pass_ucast(pass_ucast), .pass_mcast(pass_mcast), .pass_bcast(pass_bcast), 
       .pass_pause(pass_pause), .pass_all(pass_all), 
       .pause_respect_en(pause_respect_en), .pause_request_en(pause_request_en),
-      .pause_time(pause_time), .pause_thresh(pause_thresh) );
+      .pause_time(pause_time), .pause_thresh(pause_thresh),
+      .pause_sent_stb(pause_sent_wb), .pause_rcvd_stb(pause_rcvd_wb), .pause_quanta_rcvd(pause_quanta_rcvd),
+      .rx_frame_stb(rx_frame_wb), .rx_error_stb(rx_error_wb), .rx_overrun_stb(rx_overrun_wb),
+      .tx_frame_stb(tx_frame_wb) );
+
+   // PAUSE frames for the counters, the quanta is stable well before its strobe
+   oneshot_2clk pause_sent_2clk
+     (.clk_in(tx_clk), .in(RX_FLOW_CTRL ? pause_req : 1'b0), .clk_out(wb_clk), .out(pause_sent_wb));
+   oneshot_2clk pause_rcvd_2clk
+     (.clk_in(rx_clk), .in(pause_rcvd), .clk_out(wb_clk), .out(pause_rcvd_wb));
+
+   // Frame counters, a minimum frame is long enough for each handshake
+   oneshot_2clk rx_frame_2clk
+     (.clk_in(rx_clk), .in(rx_ack), .clk_out(wb_clk), .out(rx_frame_wb));
+   oneshot_2clk rx_error_2clk
+     (.clk_in(rx_clk), .in(rx_error), .clk_out(wb_clk), .out(rx_error_wb));
+   oneshot_2clk rx_overrun_2clk
+     (.clk_in(rx_clk), .in(rx_overrun), .clk_out(wb_clk), .out(rx_overrun_wb));
+   oneshot_2clk tx_frame_2clk
+     (.clk_in(tx_clk), .in(tx_ack), .clk_out(wb_clk), .out(tx_frame_wb));
 
    // RX FIFO Chain
    wire 	  rx_ll_sof, rx_ll_eof, rx_ll_src_rdy, rx_ll_dst_rdy;
@@ -97,7 +122,7 @@ module simple_gemac_wrapper
      (.clk(rx_clk), .reset(rx_reset), .clear(0),
       .rx_data(rx_data), .rx_valid(rx_valid), .rx_error(rx_error), .rx_ack(rx_ack),
       .ll_data(rx_ll_data), .ll_sof(rx_ll_sof), .ll_eof(rx_ll_eof), .ll_error(),  // error also encoded in sof/eof
-      .ll_src_rdy(rx_ll_src_rdy), .ll_dst_rdy(rx_ll_dst_rdy));
+      .ll_src_rdy(rx_ll_src_rdy), .ll_dst_rdy(rx_ll_dst_rdy), .overrun(rx_overrun));
 
    ll8_to_fifo19 ll8_to_fifo19
      (.clk(rx_clk), .reset(rx_reset), .clear(0),
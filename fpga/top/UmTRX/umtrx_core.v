@@ -143,33 +143,88 @@ module umtrx_core
 
    localparam SR_RX_FRONT0 =  20;   // 5
    localparam SR_RX_FRONT1 =  25;   // 5
-   localparam SR_RX_CTRL0 =  30;   // 9
-   localparam SR_RX_DSP0  =  40;   // 7
-   localparam SR_RX_CTRL1 =  50;   // 9
-   localparam SR_RX_DSP1  =  60;   // 7
-   localparam SR_RX_CTRL2 =  70;   // 9
-   localparam SR_RX_DSP2  =  80;   // 7
-   localparam SR_RX_CTRL3 =  90;   // 9
-   localparam SR_RX_DSP3  =  100;   // 7
+   localparam SR_RX_CTRL0 =  30;   // 10
+   localparam SR_RX_DSP0  =  40;   // 10
+   localparam SR_RX_CTRL1 =  50;   // 10
+   localparam SR_RX_DSP1  =  60;   // 10
+   localparam SR_RX_CTRL2 =  70;   // 10
+   localparam SR_RX_DSP2  =  80;   // 10
+   localparam SR_RX_CTRL3 =  90;   // 10
+   localparam SR_RX_DSP3  =  100;   // 10
 
    localparam SR_TX_FRONT0 = 110;   // ?
-   localparam SR_TX_CTRL0  = 126;   // 6
-   localparam SR_TX_DSP0   = 135;   // 5
+   localparam SR_TX_CTRL0  = 126;   // 7
+   localparam SR_TX_DSP0   = 135;   // 9
    localparam SR_TX_FRONT1 = 145;   // ?
-   localparam SR_TX_CTRL1  = 161;   // 6
-   localparam SR_TX_DSP1   = 170;   // 5
+   localparam SR_TX_CTRL1  = 161;   // 7
+   localparam SR_TX_DSP1   = 170;   // 9
 
    localparam SR_DIVSW    = 180;   // 2
    localparam SR_RX_FE_SW = 183;   // 1
    localparam SR_TX_FE_SW = 184;   // 1
    localparam SR_SPI_CORE = 185;   // 3
+   localparam SR_SRAM_SPLIT = 188; // 1
+   localparam SR_RX_FE_DC0 = 189;  // 1
+   localparam SR_RX_FE_DC1 = 190;  // 1
+   localparam SR_TX_LOOP = 191;    // 1
+   localparam SR_LOOPBACK = 192;   // 1
+   localparam SR_LINK_TEST = 193;  // 1
+   localparam SR_RX_GATE0 = 194;   // 4
+   localparam SR_RX_GATE1 = 198;   // 4
+   localparam SR_RX_GATE2 = 202;   // 4
+   localparam SR_RX_GATE3 = 206;   // 4
+   localparam SR_RX_FIR0 = 210;    // 2
+   localparam SR_RX_FIR1 = 212;    // 2
+   localparam SR_RX_FIR2 = 214;    // 2
+   localparam SR_RX_FIR3 = 216;    // 2
+   localparam SR_TX_MOD0 = 218;    // 2
+   localparam SR_TX_MOD1 = 220;    // 2
+   localparam SR_RX_COMBINE0 = 222; // 3, DSP1 combines DSP0
+   localparam SR_RX_COMBINE1 = 225; // 3, DSP3 combines DSP2
+   localparam SR_RX_TONE0 = 228;   // 2
+   localparam SR_RX_TONE1 = 230;   // 2
+   localparam SR_RX_TONE2 = 232;   // 2
+   localparam SR_RX_TONE3 = 234;   // 2
+   localparam SR_TX_RAMP0 = 236;   // 2
+   localparam SR_TX_RAMP1 = 238;   // 2
+   localparam SR_RX_AGC0 = 240;    // 6, LMS1
+   localparam SR_RX_AGC1 = 246;    // 6, LMS2
+   localparam SR_ATR0 = 252;       // 2, LMS1
+   localparam SR_ATR1 = 254;       // 2, LMS2
    
    // FIFO Sizes, 9 = 512 lines, 10 = 1024, 11 = 2048
    // all (most?) are 36 bits wide, so 9 is 1 BRAM, 10 is 2, 11 is 4 BRAMs
+   // An RX packet must fit one half of the double buffer, JUMBO_FRAMES sizes it for 8 KB frames
+`ifdef RX_FIFOSIZE
+   localparam DSP_RX_FIFOSIZE = `RX_FIFOSIZE;
+`elsif JUMBO_FRAMES
+   localparam DSP_RX_FIFOSIZE = 11;
+`else
    localparam DSP_RX_FIFOSIZE = 9;
+`endif
    localparam DSP_TX_FIFOSIZE = 9;
+   // RX stream command fifos of 254 lines, 96 bits wide: 3 BRAMs each
+   localparam DSP_RX_CMD_FIFOSIZE = 8;
+
+   // The external SRAM buffers RX0 and RX1 instead of TX0 and TX1 with RX_EXT_FIFO defined,
+   // and always in builds without TX where it is unused otherwise
+`ifdef RX_EXT_FIFO
+   localparam RX_SRAM = 1;
+`else
+   localparam RX_SRAM = (`NUMDUC == 0);
+`endif
    localparam ETH_TX_FIFOSIZE = 9;
    localparam ETH_RX_FIFOSIZE = 11;
+
+   // With SHARE_DSP the two chains of a pair take turns on one CORDIC
+   // at the dsp clock, twice the sample rate, so 4 DDC and 2 DUC fit
+`ifdef SHARE_DSP
+   localparam SHARE_DSP = 1;
+`else
+   localparam SHARE_DSP = 0;
+`endif
+   // A tone meter per RX DSP, a CORDIC and two multipliers each: not in the full SHARE_DSP image
+   localparam RX_TONE = !SHARE_DSP;
    
    wire [7:0] 	set_addr, set_addr_dsp, set_addr_sys, set_addr_fe, set_addr_udp_wb, set_addr_udp_sys;
    wire [31:0] 	set_data, set_data_dsp, set_data_sys, set_data_fe, set_data_udp_wb, set_data_udp_sys;
@@ -376,6 +431,16 @@ module umtrx_core
    wire [35:0] 	 dsp_rx0_data, dsp_rx1_data;
    wire [35:0] 	 dsp_rx2_data, dsp_rx3_data;
 
+   // RX0/RX1 chain outputs, to the router directly or through the SRAM
+   wire [35:0] 	 rx0_vita_data, rx1_vita_data;
+   wire 	 rx0_vita_valid, rx0_vita_ready;
+   wire 	 rx1_vita_valid, rx1_vita_ready;
+
+   // external SRAM fifo streams
+   wire [35:0] 	 sram_in0_data, sram_in1_data, sram0_data, sram1_data;
+   wire 	 sram_in0_valid, sram_in0_ready, sram_in1_valid, sram_in1_ready;
+   wire 	 sram0_valid, sram0_ready, sram1_valid, sram1_ready;
+
    wire [35:0] 	 err_tx0_data;
    wire 	 err_tx0_valid, err_tx0_ready;
    wire [35:0] 	 err_tx1_data;
@@ -385,6 +450,11 @@ module umtrx_core
    wire resp_valid, ctrl_valid;
    wire resp_ready, ctrl_ready;
 
+   // router DSP0 ports, through the link test
+   wire [35:0] 	 link_rx0_data, link_tx0_data;
+   wire 	 link_rx0_valid, link_rx0_ready;
+   wire 	 link_tx0_valid, link_tx0_ready;
+
     umtrx_router #(.BUF_SIZE(9), .CTRL_BASE(SR_BUF_POOL)) router
     (
         .wb_clk_i(wb_clk),.wb_rst_i(wb_rst),
@@ -402,7 +472,7 @@ module umtrx_core
         .eth_out_data(eth_tx_data), .eth_out_valid(eth_tx_valid), .eth_out_ready(eth_tx_ready),
 
         .ctrl_inp_data(resp_data), .ctrl_inp_valid(resp_valid), .ctrl_inp_ready(resp_ready),
-        .dsp0_inp_data(dsp_rx0_data), .dsp0_inp_valid(dsp_rx0_valid), .dsp0_inp_ready(dsp_rx0_ready),
+        .dsp0_inp_data(link_rx0_data), .dsp0_inp_valid(link_rx0_valid), .dsp0_inp_ready(link_rx0_ready),
         .dsp1_inp_data(dsp_rx1_data), .dsp1_inp_valid(dsp_rx1_valid), .dsp1_inp_ready(dsp_rx1_ready),
         .dsp2_inp_data(dsp_rx2_data), .dsp2_inp_valid(dsp_rx2_valid), .dsp2_inp_ready(dsp_rx2_ready),
         .dsp3_inp_data(dsp_rx3_data), .dsp3_inp_valid(dsp_rx3_valid), .dsp3_inp_ready(dsp_rx3_ready),
@@ -410,27 +480,41 @@ module umtrx_core
         .err1_inp_data(err_tx1_data), .err1_inp_valid(err_tx1_valid), .err1_inp_ready(err_tx1_ready),
 
         .ctrl_out_data(ctrl_data), .ctrl_out_valid(ctrl_valid), .ctrl_out_ready(ctrl_ready),
-        .dsp0_out_data(dsp_tx0_data), .dsp0_out_valid(dsp_tx0_valid), .dsp0_out_ready(dsp_tx0_ready),
+        .dsp0_out_data(link_tx0_data), .dsp0_out_valid(link_tx0_valid), .dsp0_out_ready(link_tx0_ready),
         .dsp1_out_data(dsp_tx1_data), .dsp1_out_valid(dsp_tx1_valid), .dsp1_out_ready(dsp_tx1_ready)
     );
 
+   // link test on the RX0 destination and the TX0 SID, read back on the buffer pool status
+   wire [31:0] link_sent, link_total, link_crc_err, link_seq_err;
+
+    umtrx_link_test #(.BASE(SR_LINK_TEST), .PORT_SEL(4)) link_test
+    (
+        .clk(sys_clk), .rst(sys_rst),
+        .set_stb(set_stb_sys), .set_addr(set_addr_sys), .set_data(set_data_sys),
+        .rx_i_data(dsp_rx0_data), .rx_i_valid(dsp_rx0_valid), .rx_i_ready(dsp_rx0_ready),
+        .rx_o_data(link_rx0_data), .rx_o_valid(link_rx0_valid), .rx_o_ready(link_rx0_ready),
+        .tx_i_data(link_tx0_data), .tx_i_valid(link_tx0_valid), .tx_i_ready(link_tx0_ready),
+        .tx_o_data(dsp_tx0_data), .tx_o_valid(dsp_tx0_valid), .tx_o_ready(dsp_tx0_ready),
+        .sent(link_sent), .total(link_total), .crc_err(link_crc_err), .seq_err(link_seq_err)
+    );
+
    // /////////////////////////////////////////////////////////////////////////
    // SPI -- Slave #2
     reg [31:0] spi_readback0;
     reg [31:0] spi_readback1;
     wire spi_ready;
 
-    wire [0:0] AXIS_SPI_CONFIG_tdest;
+    wire [1:0] AXIS_SPI_CONFIG_tdest;
     wire [79:0] AXIS_SPI_CONFIG_tdata;
     wire AXIS_SPI_CONFIG_tvalid;
     wire AXIS_SPI_CONFIG_tready;
 
-    wire [0:0] AXIS_SPI_READBACK_tdest;
+    wire [1:0] AXIS_SPI_READBACK_tdest;
     wire [31:0] AXIS_SPI_READBACK_tdata;
     wire AXIS_SPI_READBACK_tvalid;
     wire AXIS_SPI_READBACK_tready;
 
-    axis_spi_core #(.DESTW(1), .WIDTH(5), .DEBUG(0)) axis_shared_spi(
+    axis_spi_core #(.DESTW(2), .WIDTH(5), .DEBUG(0)) axis_shared_spi(
         .clock(dsp_clk), .reset(dsp_rst),
 
         .CONFIG_tdest(AXIS_SPI_CONFIG_tdest),
@@ -467,11 +551,26 @@ module umtrx_core
             .out(spi_config[i][79:64]),.changed());
     end endgenerate
 
-    //assign config bus from setting register sources
-    //Note: the triggers are exclusive (settings fifo cross clock)
-    assign AXIS_SPI_CONFIG_tdest = (spi_trigger[0])?1'b0:1'b1;
-    assign AXIS_SPI_CONFIG_tdata = (spi_trigger[0])?spi_config[0]:spi_config[1];
-    assign AXIS_SPI_CONFIG_tvalid = (spi_trigger != 0);
+    //the RX AGCs write the LMS gains on dest 2 and 3, see rx_agc below
+    wire [79:0] agc_spi_config [0:1];
+    wire [0:1] agc_spi_valid;
+
+    //assign config bus from setting register sources, then the AGCs
+    //Note: the triggers are exclusive (settings fifo cross clock),
+    //a trigger while the core is busy waits in spi_pending
+    reg [0:1] spi_pending;
+    wire [0:1] spi_waiting = spi_pending | spi_trigger;
+    assign AXIS_SPI_CONFIG_tdest = (spi_waiting[0])? 2'd0 : (spi_waiting[1])? 2'd1 : (agc_spi_valid[0])? 2'd2 : 2'd3;
+    assign AXIS_SPI_CONFIG_tdata = (spi_waiting[0])? spi_config[0] : (spi_waiting[1])? spi_config[1] :
+        (agc_spi_valid[0])? agc_spi_config[0] : agc_spi_config[1];
+    assign AXIS_SPI_CONFIG_tvalid = (spi_waiting != 0) || (agc_spi_valid != 0);
+    wire spi_accept = AXIS_SPI_CONFIG_tvalid && AXIS_SPI_CONFIG_tready;
+    wire [0:1] agc_spi_ready = {spi_accept && (AXIS_SPI_CONFIG_tdest == 2'd2), spi_accept && (AXIS_SPI_CONFIG_tdest == 2'd3)};
+
+    always @(posedge dsp_clk) begin
+        if (dsp_rst) spi_pending <= 2'b00;
+        else spi_pending <= spi_waiting & ~{spi_accept && (AXIS_SPI_CONFIG_tdest == 2'd0), spi_accept && (AXIS_SPI_CONFIG_tdest == 2'd1)};
+    end
 
     //create spi ready to block the ctrl fifo ASAP
     wire spi_ready_now = AXIS_SPI_CONFIG_tready && !AXIS_SPI_CONFIG_tvalid;
@@ -485,8 +584,8 @@ module umtrx_core
     assign AXIS_SPI_READBACK_tready = 1'b1;
     always @(posedge dsp_clk) begin
         if (AXIS_SPI_READBACK_tvalid && AXIS_SPI_READBACK_tready) begin
-            if (AXIS_SPI_READBACK_tdest == 1'b0) spi_readback0 <= AXIS_SPI_READBACK_tdata;
-            if (AXIS_SPI_READBACK_tdest == 1'b1) spi_readback1 <= AXIS_SPI_READBACK_tdata;
+            if (AXIS_SPI_READBACK_tdest == 2'd0) spi_readback0 <= AXIS_SPI_READBACK_tdata;
+            if (AXIS_SPI_READBACK_tdest == 2'd1) spi_readback1 <= AXIS_SPI_READBACK_tdata;
         end
     end
 
@@ -515,17 +614,30 @@ module umtrx_core
    // Buffer Pool Status -- Slave #5   
    
    //compatibility number -> increment when the fpga has been sufficiently altered
-   localparam compat_num = {16'd9, 16'd3}; //major, minor
+   localparam compat_num = {16'd9, 16'd34}; //major, minor
 
    wire [31:0] irq_readback = {16'b0, aux_ld2, aux_ld1, button, spi_ready, 12'b0};
 
+   // RX buffering for the host: SRAM use, on chip fifo size, SRAM lines of RX0 (RX1 has the rest)
+   wire [18:0] sram_split;
+   wire [31:0] rx_buffer_info = {RX_SRAM[0], 2'b0, DSP_RX_FIFOSIZE[4:0], 5'b0, sram_split};
+
+   // What this build has, so the host needs no rebuild for a new variant, the
+   // chain counts are in words 1 and 2 and the RX buffering in rx_buffer_info:
+   // [31] valid, [20:16] TX fifo size,
+   // [0] sc8, [1] RX power, [2] RX gate, [3] RX FIR, [4] TX gmsk, [5] shared CORDICs,
+   // [7] RX block floating point, [8] RX diversity combining, [9] RX tone meter, [10] TX burst ramps,
+   // [11] RX AGC, [12] burst ATR
+   localparam [15:0] DSP_FEATURES = {3'b0, 1'b1, (`NUMDDC > 0), (`NUMDUC > 0), RX_TONE[0], (`NUMDDC > 1), 2'b10, SHARE_DSP[0], (`NUMDUC > 0), 4'b1111};
+   wire [31:0] dsp_caps = {1'b1, 10'b0, DSP_TX_FIFOSIZE[4:0], DSP_FEATURES};
+
    wb_readback_mux buff_pool_status
      (.wb_clk_i(wb_clk), .wb_rst_i(wb_rst), .wb_stb_i(s5_stb),
       .wb_adr_i(s5_adr), .wb_dat_o(s5_dat_i), .wb_ack_o(s5_ack),
 
-      .word00(spi_readback0),.word01(`NUMDDC),.word02(`NUMDUC),.word03(32'b0),
-      .word04(32'b0),.word05(32'b0),.word06(32'b0),.word07(32'b0),
-      .word08(status),.word09(32'b0),.word10(vita_time[63:32]),
+      .word00(spi_readback0),.word01(`NUMDDC),.word02(`NUMDUC),.word03(rx_buffer_info),
+      .word04(link_sent),.word05(link_total),.word06(link_crc_err),.word07(link_seq_err),
+      .word08(status),.word09(dsp_caps),.word10(vita_time[63:32]),
       .word11(vita_time[31:0]),.word12(compat_num),.word13(irq_readback),
       .word14(vita_time_pps[63:32]),.word15(vita_time_pps[31:0])
       );
@@ -534,7 +646,8 @@ module umtrx_core
    // Ethernet MAC  Slave #6
 
    simple_gemac_wrapper #(.RXFIFOSIZE(ETH_RX_FIFOSIZE), 
-			  .TXFIFOSIZE(ETH_TX_FIFOSIZE)) simple_gemac_wrapper
+			  .TXFIFOSIZE(ETH_TX_FIFOSIZE),
+			  .RX_FLOW_CTRL(1)) simple_gemac_wrapper
      (.clk125(clk_to_mac),  .reset(wb_rst | net_clr),
       .GMII_GTX_CLK(GMII_GTX_CLK), .GMII_TX_EN(GMII_TX_EN),  
       .GMII_TX_ER(GMII_TX_ER), .GMII_TXD(GMII_TXD),
@@ -598,27 +711,53 @@ module umtrx_core
 
     wire [31:0] sfc_debug;
     wire sfc_clear;
-    settings_fifo_ctrl #(.PROT_DEST(3), .PROT_HDR(1)) sfc
+    wire [31:0] rx_power0, rx_power1, rx_power2, rx_power3; //dsp clock domain
+    wire [31:0] tx_counters0, tx_counters1; //dsp clock domain, {late, underrun} packets
+    wire [7:0] rx_cmd_fill0, rx_cmd_fill1, rx_cmd_fill2, rx_cmd_fill3; //dsp clock domain
+
+    //RX AGC per LMS on the power of a DSP, the gain changes go in-band to the DSPs of the LMS
+    wire [0:1] agc_event_stb;
+    wire [31:0] agc_event_word [0:1];
+    wire [31:0] agc_event_power [0:1];
+    wire [15:0] agc_status [0:1];
+    generate for (i=0; i <= 1; i=i+1) begin
+        rx_agc #(.BASE(SR_RX_AGC0 + 6*i), .UNIT(i)) rx_agc(
+            .clk(dsp_clk), .rst(dsp_rst),
+            .set_stb(set_stb_dsp), .set_addr(set_addr_dsp), .set_data(set_data_dsp),
+            .power_in({rx_power3, rx_power2, rx_power1, rx_power0}),
+            .spi_config(agc_spi_config[i]), .spi_valid(agc_spi_valid[i]),
+            .spi_ready(agc_spi_ready[i]), .spi_idle(AXIS_SPI_CONFIG_tready),
+            .event_stb(agc_event_stb[i]), .event_word(agc_event_word[i]), .event_power(agc_event_power[i]),
+            .status(agc_status[i]));
+    end endgenerate
+
+    wire [31:0] time_snapshot_hi;
+    //peeks of the time lo words (11 and 15) latch their hi word for word09
+    //the results of up to 8 commands, SPI readbacks included, share an ack packet,
+    //the deep command fifo holds hop schedules of timed commands, its fill goes out with every ack
+    wire [31:0] ctrl_queue_status;
+    settings_fifo_ctrl #(.PROT_DEST(3), .PROT_HDR(1), .SNAPSHOT_MASK(16'h8800), .ACK_PACK(8), .CMD_FIFO_SIZE(10)) sfc
     (
         .clock(dsp_clk), .reset(dsp_rst), .clear(sfc_clear),
         .vita_time(vita_time), .perfs_ready(spi_ready),
         .in_data(ctrl_data_dsp), .in_valid(ctrl_valid_dsp), .in_ready(ctrl_ready_dsp),
         .out_data(resp_data_dsp), .out_valid(resp_valid_dsp), .out_ready(resp_ready_dsp),
         .strobe(set_stb_dsp1), .addr(set_addr_dsp1), .data(set_data_dsp1),
-        .word00(spi_readback1),.word01(32'b0),.word02(32'b0),.word03(32'b0),
-        .word04(32'b0),.word05(32'b0),.word06(32'b0),.word07(32'b0),
-        .word08(32'b0),.word09(32'b0),.word10(vita_time[63:32]),
-        .word11(vita_time[31:0]),.word12(32'b0),.word13(irq_readback),
+        .word00(spi_readback1),.word01(ctrl_queue_status),.word02(tx_counters0),.word03(tx_counters1),
+        .word04(rx_power0),.word05(rx_power1),.word06(rx_power2),.word07(rx_power3),
+        .word08({rx_cmd_fill3, rx_cmd_fill2, rx_cmd_fill1, rx_cmd_fill0}),.word09(time_snapshot_hi),.word10(vita_time[63:32]),
+        .word11(vita_time[31:0]),.word12({agc_status[1], agc_status[0]}),.word13(irq_readback),
         .word14(vita_time_pps[63:32]),.word15(vita_time_pps[31:0]),
-        .debug(sfc_debug)
+        .snapshot(time_snapshot_hi), .queue_status(ctrl_queue_status), .debug(sfc_debug)
     );
 
-   // Output control lines
+   // Output control lines, the PA enables and diversity switches through the burst ATR
    wire 	 phy_reset;
+   wire 	 enpa1_sr, enpa2_sr, divsw1_sr, divsw2_sr;
    assign 	 PHY_RESETn = ~phy_reset;
 
    setting_reg #(.my_addr(SR_MISC+0),.width(6)) sr_lms_res
-     (.clk(wb_clk),.rst(wb_rst),.strobe(set_stb),.addr(set_addr),.in(set_data),.out({en_dc_sync, enpa2, enpa1, lowpa, lms_res}),.changed());
+     (.clk(wb_clk),.rst(wb_rst),.strobe(set_stb),.addr(set_addr),.in(set_data),.out({en_dc_sync, enpa2_sr, enpa1_sr, lowpa, lms_res}),.changed());
 
    setting_reg #(.my_addr(SR_MISC+1),.width(1)) sr_clear_sfc
      (.clk(dsp_clk),.rst(dsp_rst),.strobe(set_stb_dsp),.addr(set_addr_dsp),.in(set_data_dsp),.changed(sfc_clear));
@@ -638,10 +777,10 @@ module umtrx_core
 
    // Diversity switches
    setting_reg #(.my_addr(SR_DIVSW+0),.width(1), .at_reset(32'd1)) sr_divsw1
-     (.clk(wb_clk),.rst(wb_rst),.strobe(set_stb),.addr(set_addr),.in(set_data),.out(DivSw1),.changed());
+     (.clk(wb_clk),.rst(wb_rst),.strobe(set_stb),.addr(set_addr),.in(set_data),.out(divsw1_sr),.changed());
 
    setting_reg #(.my_addr(SR_DIVSW+1),.width(1), .at_reset(32'd1)) sr_divsw2
-     (.clk(wb_clk),.rst(wb_rst),.strobe(set_stb),.addr(set_addr),.in(set_data),.out(DivSw2),.changed());
+     (.clk(wb_clk),.rst(wb_rst),.strobe(set_stb),.addr(set_addr),.in(set_data),.out(divsw2_sr),.changed());
 
    // /////////////////////////////////////////////////////////////////////////
    //  LEDS
@@ -736,7 +875,7 @@ module umtrx_core
    // /////////////////////////////////////////////////////////////////////////
    // RX Frontend
     wire [23:0] rx_front0_i, rx_front0_q;
-    rx_frontend #(.BASE(SR_RX_FRONT0)) rx_frontend0
+    rx_frontend #(.BASE(SR_RX_FRONT0), .DC_SHIFT_ADDR(SR_RX_FE_DC0)) rx_frontend0
     (
         .clk(fe_clk), .rst(fe_rst),
         .set_stb(set_stb_fe),.set_addr(set_addr_fe),.set_data(set_data_fe),
@@ -744,7 +883,7 @@ module umtrx_core
         .adc_a({adc0_a, 4'b0}), .adc_b({adc0_b, 4'b0})
     );
     wire [23:0] rx_front1_i, rx_front1_q;
-    rx_frontend #(.BASE(SR_RX_FRONT1)) rx_frontend1
+    rx_frontend #(.BASE(SR_RX_FRONT1), .DC_SHIFT_ADDR(SR_RX_FE_DC1)) rx_frontend1
     (
         .clk(fe_clk), .rst(fe_rst),
         .set_stb(set_stb_fe),.set_addr(set_addr_fe),.set_data(set_data_fe),
@@ -752,6 +891,12 @@ module umtrx_core
         .adc_a({adc1_a, 4'b0}), .adc_b({adc1_b, 4'b0})
     );
 
+    //digital loopback, the RX DSPs take the TX DSP outputs of the same frontend instead
+    wire loopback;
+    setting_reg #(.my_addr(SR_LOOPBACK),.width(1)) sr_loopback
+     (.clk(dsp_clk),.rst(dsp_rst),.strobe(set_stb_dsp),.addr(set_addr_dsp),.in(set_data_dsp),.out(loopback),.changed());
+    wire [23:0] rx_dsp_in0_i, rx_dsp_in0_q, rx_dsp_in1_i, rx_dsp_in1_q; //assigned in the TX section
+
    // /////////////////////////////////////////////////////////////////////////
    // RX chains
 
@@ -761,7 +906,36 @@ module umtrx_core
     setting_reg #(.my_addr(SR_RX_FE_SW),.width(4)) sr_rx_fe_sw
      (.clk(dsp_clk),.rst(dsp_rst),.strobe(set_stb_dsp),.addr(set_addr_dsp),.in(set_data_dsp),.out(rx_fe_sw),.changed());
 
+    //diversity combining: DSP1 takes the DDC0 samples, DSP3 those of DDC2
+    wire [4*32-1:0] rx_bb_sample;
+    wire [3:0] rx_bb_strobe, rx_combining;
+
+    //CORDIC buses of the DDCs, 25 bits each, DDC0 with DDC1 and DDC2 with DDC3
+    wire [4*25-1:0] rx_cordic_xi, rx_cordic_yi, rx_cordic_xo, rx_cordic_yo;
+    wire [4*24-1:0] rx_cordic_zi;
+
     generate
+    if (SHARE_DSP && `NUMDDC > 1) begin
+    cordic_z24_2x #(.bitwidth(25)) rx_cordic01
+    (
+        .clk(dsp_clk), .rst(dsp_rst),
+        .a_xi(rx_cordic_xi[0+:25]), .a_yi(rx_cordic_yi[0+:25]), .a_zi(rx_cordic_zi[0+:24]),
+        .a_xo(rx_cordic_xo[0+:25]), .a_yo(rx_cordic_yo[0+:25]),
+        .b_xi(rx_cordic_xi[25+:25]), .b_yi(rx_cordic_yi[25+:25]), .b_zi(rx_cordic_zi[24+:24]),
+        .b_xo(rx_cordic_xo[25+:25]), .b_yo(rx_cordic_yo[25+:25])
+    );
+    end
+    if (SHARE_DSP && `NUMDDC > 3) begin
+    cordic_z24_2x #(.bitwidth(25)) rx_cordic23
+    (
+        .clk(dsp_clk), .rst(dsp_rst),
+        .a_xi(rx_cordic_xi[50+:25]), .a_yi(rx_cordic_yi[50+:25]), .a_zi(rx_cordic_zi[48+:24]),
+        .a_xo(rx_cordic_xo[50+:25]), .a_yo(rx_cordic_yo[50+:25]),
+        .b_xi(rx_cordic_xi[75+:25]), .b_yi(rx_cordic_yi[75+:25]), .b_zi(rx_cordic_zi[72+:24]),
+        .b_xo(rx_cordic_xo[75+:25]), .b_yo(rx_cordic_yo[75+:25])
+    );
+    end
+
     if (`NUMDDC > 0) begin
     umtrx_rx_chain
     #(
@@ -769,7 +943,15 @@ module umtrx_core
         .DSPNO(0),
         .DSP_BASE(SR_RX_DSP0),
         .CTRL_BASE(SR_RX_CTRL0),
+        .GATE_BASE(SR_RX_GATE0),
+        .FIR_BASE(SR_RX_FIR0),
+        .COMBINE_BASE(SR_RX_COMBINE0),
+        .COMBINE(0),
+        .TONE_BASE(SR_RX_TONE0),
+        .TONE(RX_TONE),
+        .SHARED_CORDIC(SHARE_DSP && `NUMDDC > 1),
         .FIFOSIZE(DSP_RX_FIFOSIZE),
+        .CMD_FIFO_SIZE(DSP_RX_CMD_FIFOSIZE),
         .DEBUG(0)
     )
     umtrx_rx_chain0
@@ -779,15 +961,28 @@ module umtrx_core
         .fe_clk(fe_clk), .fe_rst(fe_rst),
         .set_stb_dsp(set_stb_dsp), .set_addr_dsp(set_addr_dsp), .set_data_dsp(set_data_dsp),
         .set_stb_fe(set_stb_fe), .set_addr_fe(set_addr_fe), .set_data_fe(set_data_fe),
-        .front_i(rx_fe_sw[0]?rx_front1_i:rx_front0_i),
-        .front_q(rx_fe_sw[0]?rx_front1_q:rx_front0_q),
+        .front_i(rx_fe_sw[0]?rx_dsp_in1_i:rx_dsp_in0_i),
+        .front_q(rx_fe_sw[0]?rx_dsp_in1_q:rx_dsp_in0_q),
         .adc_stb(rx_fe_sw[0]?adc1_strobe:adc0_strobe),
         .run(run_rx_dsp[0]),
-        .vita_data_sys(dsp_rx0_data), .vita_valid_sys(dsp_rx0_valid), .vita_ready_sys(dsp_rx0_ready),
+        .cordic_xi(rx_cordic_xi[0+:25]), .cordic_yi(rx_cordic_yi[0+:25]), .cordic_zi(rx_cordic_zi[0+:24]),
+        .cordic_xo(rx_cordic_xo[0+:25]), .cordic_yo(rx_cordic_yo[0+:25]),
+        .rx_power(rx_power0),
+        .cmd_queue_fill(rx_cmd_fill0),
+        .gain_stb(agc_event_stb[rx_fe_sw[0]]), .gain_word(agc_event_word[rx_fe_sw[0]]), .gain_power(agc_event_power[rx_fe_sw[0]]),
+        .bb_sample(rx_bb_sample[0+:32]), .bb_strobe(rx_bb_strobe[0]),
+        .combine_sample(rx_bb_sample[32+:32]), .combine_strobe(rx_bb_strobe[1]),
+        .keep_run(rx_combining[1]), .combining(rx_combining[0]),
+        .vita_data_sys(rx0_vita_data), .vita_valid_sys(rx0_vita_valid), .vita_ready_sys(rx0_vita_ready),
         .vita_time(vita_time)
     );
     end else begin
-        assign dsp_rx0_valid = 0;
+        assign rx0_vita_valid = 0;
+        assign rx_power0 = 0;
+        assign rx_cmd_fill0 = 0;
+        assign rx_bb_sample[0+:32] = 0;
+        assign rx_bb_strobe[0] = 0;
+        assign rx_combining[0] = 0;
         assign run_rx_dsp[0] = 0;
     end
     if (`NUMDDC > 1) begin
@@ -797,7 +992,15 @@ module umtrx_core
         .DSPNO(1),
         .DSP_BASE(SR_RX_DSP1),
         .CTRL_BASE(SR_RX_CTRL1),
-        .FIFOSIZE(DSP_RX_FIFOSIZE)
+        .GATE_BASE(SR_RX_GATE1),
+        .FIR_BASE(SR_RX_FIR1),
+        .COMBINE_BASE(SR_RX_COMBINE0),
+        .COMBINE(1),
+        .TONE_BASE(SR_RX_TONE1),
+        .TONE(RX_TONE),
+        .SHARED_CORDIC(SHARE_DSP && `NUMDDC > 1),
+        .FIFOSIZE(DSP_RX_FIFOSIZE),
+        .CMD_FIFO_SIZE(DSP_RX_CMD_FIFOSIZE)
     )
     umtrx_rx_chain1
     (
@@ -806,15 +1009,28 @@ module umtrx_core
         .fe_clk(fe_clk), .fe_rst(fe_rst),
         .set_stb_dsp(set_stb_dsp), .set_addr_dsp(set_addr_dsp), .set_data_dsp(set_data_dsp),
         .set_stb_fe(set_stb_fe), .set_addr_fe(set_addr_fe), .set_data_fe(set_data_fe),
-        .front_i(rx_fe_sw[1]?rx_front1_i:rx_front0_i),
-        .front_q(rx_fe_sw[1]?rx_front1_q:rx_front0_q),
+        .front_i(rx_fe_sw[1]?rx_dsp_in1_i:rx_dsp_in0_i),
+        .front_q(rx_fe_sw[1]?rx_dsp_in1_q:rx_dsp_in0_q),
         .adc_stb(rx_fe_sw[1]?adc1_strobe:adc0_strobe),
         .run(run_rx_dsp[1]),
-        .vita_data_sys(dsp_rx1_data), .vita_valid_sys(dsp_rx1_valid), .vita_ready_sys(dsp_rx1_ready),
+        .cordic_xi(rx_cordic_xi[25+:25]), .cordic_yi(rx_cordic_yi[25+:25]), .cordic_zi(rx_cordic_zi[24+:24]),
+        .cordic_xo(rx_cordic_xo[25+:25]), .cordic_yo(rx_cordic_yo[25+:25]),
+        .rx_power(rx_power1),
+        .cmd_queue_fill(rx_cmd_fill1),
+        .gain_stb(agc_event_stb[rx_fe_sw[1]]), .gain_word(agc_event_word[rx_fe_sw[1]]), .gain_power(agc_event_power[rx_fe_sw[1]]),
+        .bb_sample(rx_bb_sample[32+:32]), .bb_strobe(rx_bb_strobe[1]),
+        .combine_sample(rx_bb_sample[0+:32]), .combine_strobe(rx_bb_strobe[0]),
+        .keep_run(rx_combining[0]), .combining(rx_combining[1]),
+        .vita_data_sys(rx1_vita_data), .vita_valid_sys(rx1_vita_valid), .vita_ready_sys(rx1_vita_ready),
         .vita_time(vita_time)
     );
     end else begin
-        assign dsp_rx1_valid = 0;
+        assign rx1_vita_valid = 0;
+        assign rx_power1 = 0;
+        assign rx_cmd_fill1 = 0;
+        assign rx_bb_sample[32+:32] = 0;
+        assign rx_bb_strobe[1] = 0;
+        assign rx_combining[1] = 0;
         assign run_rx_dsp[1] = 0;
     end
     if (`NUMDDC > 2) begin
@@ -824,7 +1040,15 @@ module umtrx_core
         .DSPNO(2),
         .DSP_BASE(SR_RX_DSP2),
         .CTRL_BASE(SR_RX_CTRL2),
-        .FIFOSIZE(DSP_RX_FIFOSIZE)
+        .GATE_BASE(SR_RX_GATE2),
+        .FIR_BASE(SR_RX_FIR2),
+        .COMBINE_BASE(SR_RX_COMBINE1),
+        .COMBINE(0),
+        .TONE_BASE(SR_RX_TONE2),
+        .TONE(RX_TONE),
+        .SHARED_CORDIC(SHARE_DSP && `NUMDDC > 3),
+        .FIFOSIZE(DSP_RX_FIFOSIZE),
+        .CMD_FIFO_SIZE(DSP_RX_CMD_FIFOSIZE)
     )
     umtrx_rx_chain2
     (
@@ -833,15 +1057,28 @@ module umtrx_core
         .fe_clk(fe_clk), .fe_rst(fe_rst),
         .set_stb_dsp(set_stb_dsp), .set_addr_dsp(set_addr_dsp), .set_data_dsp(set_data_dsp),
         .set_stb_fe(set_stb_fe), .set_addr_fe(set_addr_fe), .set_data_fe(set_data_fe),
-        .front_i(rx_fe_sw[2]?rx_front1_i:rx_front0_i),
-        .front_q(rx_fe_sw[2]?rx_front1_q:rx_front0_q),
+        .front_i(rx_fe_sw[2]?rx_dsp_in1_i:rx_dsp_in0_i),
+        .front_q(rx_fe_sw[2]?rx_dsp_in1_q:rx_dsp_in0_q),
         .adc_stb(rx_fe_sw[2]?adc1_strobe:adc0_strobe),
         .run(run_rx_dsp[2]),
+        .cordic_xi(rx_cordic_xi[50+:25]), .cordic_yi(rx_cordic_yi[50+:25]), .cordic_zi(rx_cordic_zi[48+:24]),
+        .cordic_xo(rx_cordic_xo[50+:25]), .cordic_yo(rx_cordic_yo[50+:25]),
+        .rx_power(rx_power2),
+        .cmd_queue_fill(rx_cmd_fill2),
+        .gain_stb(agc_event_stb[rx_fe_sw[2]]), .gain_word(agc_event_word[rx_fe_sw[2]]), .gain_power(agc_event_power[rx_fe_sw[2]]),
+        .bb_sample(rx_bb_sample[64+:32]), .bb_strobe(rx_bb_strobe[2]),
+        .combine_sample(rx_bb_sample[96+:32]), .combine_strobe(rx_bb_strobe[3]),
+        .keep_run(rx_combining[3]), .combining(rx_combining[2]),
         .vita_data_sys(dsp_rx2_data), .vita_valid_sys(dsp_rx2_valid), .vita_ready_sys(dsp_rx2_ready),
         .vita_time(vita_time)
     );
     end else begin
         assign dsp_rx2_valid = 0;
+        assign rx_power2 = 0;
+        assign rx_cmd_fill2 = 0;
+        assign rx_bb_sample[64+:32] = 0;
+        assign rx_bb_strobe[2] = 0;
+        assign rx_combining[2] = 0;
         assign run_rx_dsp[2] = 0;
     end
     if (`NUMDDC > 3) begin
@@ -851,7 +1088,15 @@ module umtrx_core
         .DSPNO(3),
         .DSP_BASE(SR_RX_DSP3),
         .CTRL_BASE(SR_RX_CTRL3),
-        .FIFOSIZE(DSP_RX_FIFOSIZE)
+        .GATE_BASE(SR_RX_GATE3),
+        .FIR_BASE(SR_RX_FIR3),
+        .COMBINE_BASE(SR_RX_COMBINE1),
+        .COMBINE(1),
+        .TONE_BASE(SR_RX_TONE3),
+        .TONE(RX_TONE),
+        .SHARED_CORDIC(SHARE_DSP && `NUMDDC > 3),
+        .FIFOSIZE(DSP_RX_FIFOSIZE),
+        .CMD_FIFO_SIZE(DSP_RX_CMD_FIFOSIZE)
     )
     umtrx_rx_chain3
     (
@@ -860,15 +1105,28 @@ module umtrx_core
         .fe_clk(fe_clk), .fe_rst(fe_rst),
         .set_stb_dsp(set_stb_dsp), .set_addr_dsp(set_addr_dsp), .set_data_dsp(set_data_dsp),
         .set_stb_fe(set_stb_fe), .set_addr_fe(set_addr_fe), .set_data_fe(set_data_fe),
-        .front_i(rx_fe_sw[3]?rx_front1_i:rx_front0_i),
-        .front_q(rx_fe_sw[3]?rx_front1_q:rx_front0_q),
+        .front_i(rx_fe_sw[3]?rx_dsp_in1_i:rx_dsp_in0_i),
+        .front_q(rx_fe_sw[3]?rx_dsp_in1_q:rx_dsp_in0_q),
         .adc_stb(rx_fe_sw[3]?adc1_strobe:adc0_strobe),
         .run(run_rx_dsp[3]),
+        .cordic_xi(rx_cordic_xi[75+:25]), .cordic_yi(rx_cordic_yi[75+:25]), .cordic_zi(rx_cordic_zi[72+:24]),
+        .cordic_xo(rx_cordic_xo[75+:25]), .cordic_yo(rx_cordic_yo[75+:25]),
+        .rx_power(rx_power3),
+        .cmd_queue_fill(rx_cmd_fill3),
+        .gain_stb(agc_event_stb[rx_fe_sw[3]]), .gain_word(agc_event_word[rx_fe_sw[3]]), .gain_power(agc_event_power[rx_fe_sw[3]]),
+        .bb_sample(rx_bb_sample[96+:32]), .bb_strobe(rx_bb_strobe[3]),
+        .combine_sample(rx_bb_sample[64+:32]), .combine_strobe(rx_bb_strobe[2]),
+        .keep_run(rx_combining[2]), .combining(rx_combining[3]),
         .vita_data_sys(dsp_rx3_data), .vita_valid_sys(dsp_rx3_valid), .vita_ready_sys(dsp_rx3_ready),
         .vita_time(vita_time)
     );
     end else begin
         assign dsp_rx3_valid = 0;
+        assign rx_power3 = 0;
+        assign rx_cmd_fill3 = 0;
+        assign rx_bb_sample[96+:32] = 0;
+        assign rx_bb_strobe[3] = 0;
+        assign rx_combining[3] = 0;
         assign run_rx_dsp[3] = 0;
     end
     endgenerate
@@ -897,10 +1155,12 @@ module umtrx_core
 
    // /////////////////////////////////////////////////////////////////////////
    // TX chains
-    wire [35:0] sram0_data, sram1_data;
-    wire sram0_valid, sram1_valid;
-    wire sram0_ready, sram1_ready;
+    wire [35:0] tx0_vita_data, tx1_vita_data;
+    wire tx0_vita_valid, tx1_vita_valid;
+    wire tx0_vita_ready, tx1_vita_ready;
     wire run_tx_dsp0, run_tx_dsp1;
+    wire burst_pending0, burst_pending1;
+    wire [63:0] burst_time0, burst_time1;
 
     //switch to select frontend used per DSP
     wire tx_fe_sw;
@@ -913,7 +1173,25 @@ module umtrx_core
     assign {tx_front0_i, tx_front0_q} = (tx_fe_sw == 0)? {dac0_a_int, dac0_b_int} : {dac1_a_int, dac1_b_int};
     assign {tx_front1_i, tx_front1_q} = (tx_fe_sw == 1)? {dac0_a_int, dac0_b_int} : {dac1_a_int, dac1_b_int};
 
+    //ahead of the TX frontends, so the loopback is bit exact
+    assign {rx_dsp_in0_i, rx_dsp_in0_q} = loopback? {tx_front0_i, tx_front0_q} : {rx_front0_i, rx_front0_q};
+    assign {rx_dsp_in1_i, rx_dsp_in1_q} = loopback? {tx_front1_i, tx_front1_q} : {rx_front1_i, rx_front1_q};
+
+    //CORDIC buses of the DUCs, 24 bits each, DUC0 with DUC1
+    wire [2*24-1:0] tx_cordic_xi, tx_cordic_yi, tx_cordic_zi, tx_cordic_xo, tx_cordic_yo;
+
     generate
+    if (SHARE_DSP && `NUMDUC > 1) begin
+    cordic_z24_2x #(.bitwidth(24)) tx_cordic01
+    (
+        .clk(dsp_clk), .rst(dsp_rst),
+        .a_xi(tx_cordic_xi[0+:24]), .a_yi(tx_cordic_yi[0+:24]), .a_zi(tx_cordic_zi[0+:24]),
+        .a_xo(tx_cordic_xo[0+:24]), .a_yo(tx_cordic_yo[0+:24]),
+        .b_xi(tx_cordic_xi[24+:24]), .b_yi(tx_cordic_yi[24+:24]), .b_zi(tx_cordic_zi[24+:24]),
+        .b_xo(tx_cordic_xo[24+:24]), .b_yo(tx_cordic_yo[24+:24])
+    );
+    end
+
     if (`NUMDUC > 0) begin
     umtrx_tx_chain
     #(
@@ -921,6 +1199,9 @@ module umtrx_core
         .DSPNO(0),
         .DSP_BASE(SR_TX_DSP0),
         .CTRL_BASE(SR_TX_CTRL0),
+        .MOD_BASE(SR_TX_MOD0),
+        .RAMP_BASE(SR_TX_RAMP0),
+        .SHARED_CORDIC(SHARE_DSP && `NUMDUC > 1),
         .FIFOSIZE(DSP_TX_FIFOSIZE)
     )
     umtrx_tx_chain0
@@ -931,14 +1212,21 @@ module umtrx_core
         .set_stb_dsp(set_stb_dsp), .set_addr_dsp(set_addr_dsp), .set_data_dsp(set_data_dsp),
         .set_stb_fe(set_stb_fe), .set_addr_fe(set_addr_fe), .set_data_fe(set_data_fe),
         .front_i(dac0_a_int), .front_q(dac0_b_int), .dac_stb(dac0_strobe), .run(run_tx_dsp0),
-        .vita_data_sys(sram0_data), .vita_valid_sys(sram0_valid), .vita_ready_sys(sram0_ready),
+        .cordic_xi(tx_cordic_xi[0+:24]), .cordic_yi(tx_cordic_yi[0+:24]), .cordic_zi(tx_cordic_zi[0+:24]),
+        .cordic_xo(tx_cordic_xo[0+:24]), .cordic_yo(tx_cordic_yo[0+:24]),
+        .vita_data_sys(tx0_vita_data), .vita_valid_sys(tx0_vita_valid), .vita_ready_sys(tx0_vita_ready),
         .err_data_sys(err_tx0_data), .err_valid_sys(err_tx0_valid), .err_ready_sys(err_tx0_ready),
+        .counters(tx_counters0),
+        .burst_pending(burst_pending0), .burst_time(burst_time0),
         .vita_time(vita_time)
     );
     end else begin
-        assign sram0_ready = 1;
+        assign tx0_vita_ready = 1;
         assign err_tx0_valid = 0;
         assign run_tx_dsp0 = 0;
+        assign tx_counters0 = 0;
+        assign burst_pending0 = 0;
+        assign burst_time0 = 0;
     end
     if (`NUMDUC > 1) begin
     umtrx_tx_chain
@@ -947,6 +1235,9 @@ module umtrx_core
         .DSPNO(1),
         .DSP_BASE(SR_TX_DSP1),
         .CTRL_BASE(SR_TX_CTRL1),
+        .MOD_BASE(SR_TX_MOD1),
+        .RAMP_BASE(SR_TX_RAMP1),
+        .SHARED_CORDIC(SHARE_DSP && `NUMDUC > 1),
         .FIFOSIZE(DSP_TX_FIFOSIZE)
     )
     umtrx_tx_chain1
@@ -957,17 +1248,48 @@ module umtrx_core
         .set_stb_dsp(set_stb_dsp), .set_addr_dsp(set_addr_dsp), .set_data_dsp(set_data_dsp),
         .set_stb_fe(set_stb_fe), .set_addr_fe(set_addr_fe), .set_data_fe(set_data_fe),
         .front_i(dac1_a_int), .front_q(dac1_b_int), .dac_stb(dac1_strobe), .run(run_tx_dsp1),
-        .vita_data_sys(sram1_data), .vita_valid_sys(sram1_valid), .vita_ready_sys(sram1_ready),
+        .cordic_xi(tx_cordic_xi[24+:24]), .cordic_yi(tx_cordic_yi[24+:24]), .cordic_zi(tx_cordic_zi[24+:24]),
+        .cordic_xo(tx_cordic_xo[24+:24]), .cordic_yo(tx_cordic_yo[24+:24]),
+        .vita_data_sys(tx1_vita_data), .vita_valid_sys(tx1_vita_valid), .vita_ready_sys(tx1_vita_ready),
         .err_data_sys(err_tx1_data), .err_valid_sys(err_tx1_valid), .err_ready_sys(err_tx1_ready),
+        .counters(tx_counters1),
+        .burst_pending(burst_pending1), .burst_time(burst_time1),
         .vita_time(vita_time)
     );
     end else begin
-        assign sram1_ready = 1;
+        assign tx1_vita_ready = 1;
         assign err_tx1_valid = 0;
         assign run_tx_dsp1 = 0;
+        assign tx_counters1 = 0;
+        assign burst_pending1 = 0;
+        assign burst_time1 = 0;
     end
     endgenerate
 
+   // /////////////////////////////////////////////////////////////////////////
+   // Burst ATR: the PA enable [0] and diversity switch [1] of each frontend follow its DSPs
+
+    wire tx_fe_straight = (tx_fe_sw == 0); //TX DSP n drives frontend n
+    burst_atr #(.BASE(SR_ATR0), .WIDTH(2)) burst_atr0
+     (.clk(dsp_clk), .reset(dsp_rst),
+      .set_stb(set_stb_dsp), .set_addr(set_addr_dsp), .set_data(set_data_dsp),
+      .vita_time(vita_time),
+      .tx_run(tx_fe_straight? run_tx_dsp0 : run_tx_dsp1),
+      .tx_pending(tx_fe_straight? burst_pending0 : burst_pending1),
+      .tx_time(tx_fe_straight? burst_time0 : burst_time1),
+      .rx_run(|(run_rx_dsp & ~rx_fe_sw)),
+      .manual({divsw1_sr, enpa1_sr}), .lines({DivSw1, enpa1}));
+
+    burst_atr #(.BASE(SR_ATR1), .WIDTH(2)) burst_atr1
+     (.clk(dsp_clk), .reset(dsp_rst),
+      .set_stb(set_stb_dsp), .set_addr(set_addr_dsp), .set_data(set_data_dsp),
+      .vita_time(vita_time),
+      .tx_run(tx_fe_straight? run_tx_dsp1 : run_tx_dsp0),
+      .tx_pending(tx_fe_straight? burst_pending1 : burst_pending0),
+      .tx_time(tx_fe_straight? burst_time1 : burst_time0),
+      .rx_run(|(run_rx_dsp & rx_fe_sw)),
+      .manual({divsw2_sr, enpa2_sr}), .lines({DivSw2, enpa2}));
+
    // /////////////////////////////////////////////////////////////////////////
    // configuration specific LED mapping
 
@@ -984,6 +1306,73 @@ module umtrx_core
     endgenerate
 
 
+   // ///////////////////////////////////////////////////////////////////////////////////
+   // SRAM routing: TX0/TX1 from the router, or RX0/RX1 to the router
+
+    generate
+    if (RX_SRAM) begin
+        //both fifos share the data input, RX1 writes in the cycles RX0 does not
+        wire rx0_write = rx0_vita_valid & sram_in0_ready;
+        assign sram_in0_data = rx0_vita_data;
+        assign sram_in0_valid = rx0_write;
+        assign rx0_vita_ready = sram_in0_ready;
+        assign sram_in1_data = rx1_vita_data;
+        assign sram_in1_valid = rx1_vita_valid & ~rx0_write;
+        assign rx1_vita_ready = sram_in1_ready & ~rx0_write;
+
+        assign dsp_rx0_data = sram0_data;
+        assign dsp_rx0_valid = sram0_valid;
+        assign sram0_ready = dsp_rx0_ready;
+        assign dsp_rx1_data = sram1_data;
+        assign dsp_rx1_valid = sram1_valid;
+        assign sram1_ready = dsp_rx1_ready;
+
+        assign tx0_vita_data = dsp_tx0_data;
+        assign tx0_vita_valid = dsp_tx0_valid;
+        assign dsp_tx0_ready = tx0_vita_ready;
+        assign tx1_vita_data = dsp_tx1_data;
+        assign tx1_vita_valid = dsp_tx1_valid;
+        assign dsp_tx1_ready = tx1_vita_ready;
+    end else begin
+        //loop playback, per channel {play, load}: load holds the fifo output while the
+        //host fills it, play drops the host data and writes each line read out back in.
+        //both fifos share the data input, TX1 writes in the cycles TX0 does not
+        wire [3:0] tx_loop;
+        setting_reg #(.my_addr(SR_TX_LOOP),.width(4)) sr_tx_loop
+          (.clk(sys_clk),.rst(sys_rst),.strobe(set_stb_sys),.addr(set_addr_sys),.in(set_data_sys),.out(tx_loop),.changed());
+        wire tx0_load = tx_loop[0], tx0_play = tx_loop[1];
+        wire tx1_load = tx_loop[2], tx1_play = tx_loop[3];
+
+        wire tx0_in_ok = ~tx0_play | sram_in0_ready;
+        wire tx0_out = sram0_valid & tx0_vita_ready & ~tx0_load & tx0_in_ok;
+        wire tx0_write = tx0_play ? tx0_out : (dsp_tx0_valid & sram_in0_ready);
+        assign sram_in0_data = tx0_play ? sram0_data : dsp_tx0_data;
+        assign sram_in0_valid = tx0_write;
+        assign dsp_tx0_ready = tx0_play | sram_in0_ready;
+
+        wire tx1_in_ok = ~tx1_play | (sram_in1_ready & ~tx0_write);
+        wire tx1_out = sram1_valid & tx1_vita_ready & ~tx1_load & tx1_in_ok;
+        wire tx1_write = tx1_play ? tx1_out : (dsp_tx1_valid & sram_in1_ready & ~tx0_write);
+        assign sram_in1_data = tx1_play ? sram1_data : dsp_tx1_data;
+        assign sram_in1_valid = tx1_write;
+        assign dsp_tx1_ready = tx1_play | (sram_in1_ready & ~tx0_write);
+
+        assign tx0_vita_data = sram0_data;
+        assign tx0_vita_valid = sram0_valid & ~tx0_load & tx0_in_ok;
+        assign sram0_ready = tx0_vita_ready & ~tx0_load & tx0_in_ok;
+        assign tx1_vita_data = sram1_data;
+        assign tx1_vita_valid = sram1_valid & ~tx1_load & tx1_in_ok;
+        assign sram1_ready = tx1_vita_ready & ~tx1_load & tx1_in_ok;
+
+        assign dsp_rx0_data = rx0_vita_data;
+        assign dsp_rx0_valid = rx0_vita_valid;
+        assign rx0_vita_ready = dsp_rx0_ready;
+        assign dsp_rx1_data = rx1_vita_data;
+        assign dsp_rx1_valid = rx1_vita_valid;
+        assign rx1_vita_ready = dsp_rx1_ready;
+    end
+    endgenerate
+
    // ///////////////////////////////////////////////////////////////////////////////////
    // DSP TX
 
@@ -991,6 +1380,10 @@ module umtrx_core
    assign 	 RAM_A[20:19] = 2'b0;
 `endif // !`ifndef NO_EXT_FIFO
    
+   // SRAM words owned by TX0 (or RX0), the rest belong to TX1 (or RX1); takes effect on sram_clear.
+   setting_reg #(.my_addr(SR_SRAM_SPLIT),.width(19),.at_reset(32'h40000)) sr_sram_split
+     (.clk(sys_clk),.rst(sys_rst),.strobe(set_stb_sys),.addr(set_addr_sys),.in(set_data_sys),.out(sram_split),.changed());
+
    ext_fifo #(.EXT_WIDTH(36),.INT_WIDTH(36),.RAM_DEPTH(19),.FIFO_DEPTH(19)) 
      ext_fifo_i1
        (.int_clk(sys_clk),
@@ -1017,17 +1410,18 @@ module umtrx_core
 	.RAM_OEn(),
 	.RAM_CE1n(),
 `endif // !`ifndef NO_EXT_FIFO
-	.datain(dsp_tx0_valid?dsp_tx0_data:dsp_tx1_data),
-	.src_rdy_i(dsp_tx0_valid),
-	.dst_rdy_o(dsp_tx0_ready),
+	.datain(sram_in0_valid?sram_in0_data:sram_in1_data),
+	.src_rdy_i(sram_in0_valid),
+	.dst_rdy_o(sram_in0_ready),
 	.dataout(sram0_data),
 	.src_rdy_o(sram0_valid),
 	.dst_rdy_i(sram0_ready),
-	.src1_rdy_i(dsp_tx1_valid),
-	.dst1_rdy_o(dsp_tx1_ready),
+	.src1_rdy_i(sram_in1_valid),
+	.dst1_rdy_o(sram_in1_ready),
 	.src1_rdy_o(sram1_valid),
 	.dst1_rdy_i(sram1_ready),
 	.dataout_1(sram1_data),
+	.split(sram_split),
 	.debug(debug_extfifo),
 	.debug2(debug_extfifo2) );
 
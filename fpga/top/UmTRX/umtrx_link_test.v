@@ -0,0 +1,150 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Network link test on the DSP0 ports of the router.
+//! The source replaces the RX0 stream with packet_generator packets, one
+//! byte per clock, framed for the RX0 destination. Each UDP payload is the
+//! length (LEN), a sequence number from 0, header, a byte ramp and a byte
+//! sum of everything before it.
+//! The sink takes the TX0 stream from the router into packet_verifier
+//! instead of the TX chain. The transport word, VRT header and SID in front
+//! of each packet are dropped, the rest is length, sequence number from 0,
+//! payload and the ethernet CRC32 of it, little endian.
+//! A mode change waits for the end of the packet in flight. Turning a side
+//! on restarts its sequence numbers and clears its counters.
+//!
+//! Registers:
+//!  BASE+0 [0] source on, [1] sink on
+
+module umtrx_link_test
+  #(parameter BASE = 0,
+    parameter PORT_SEL = 0,
+    parameter LEN = 1468)
+   (input clk, input rst,
+    input set_stb, input [7:0] set_addr, input [31:0] set_data,
+
+    // RX0 stream, from the chain and into the router
+    input [35:0] rx_i_data, input rx_i_valid, output rx_i_ready,
+    output [35:0] rx_o_data, output rx_o_valid, input rx_o_ready,
+
+    // TX0 stream, from the router and into the chain
+    input [35:0] tx_i_data, input tx_i_valid, output tx_i_ready,
+    output [35:0] tx_o_data, output tx_o_valid, input tx_o_ready,
+
+    output reg [31:0] sent, output [31:0] total, output [31:0] crc_err, output [31:0] seq_err);
+
+   wire [1:0]  mode;
+   setting_reg #(.my_addr(BASE+0),.width(2)) sr_mode
+     (.clk(clk),.rst(rst),.strobe(set_stb),.addr(set_addr),.in(set_data),.out(mode),.changed());
+
+   // switch only between packets on the side that is changing
+   reg 	       src_on, sink_on, rx_in_pkt, tx_in_pkt;
+   reg 	       src_on_d, sink_on_d;
+   wire        rx_xfer = rx_o_valid & rx_o_ready;
+   wire        tx_xfer = tx_i_valid & tx_i_ready;
+
+   always @(posedge clk)
+     if(rst)
+       begin
+	  src_on <= 0;
+	  sink_on <= 0;
+	  rx_in_pkt <= 0;
+	  tx_in_pkt <= 0;
+       end
+     else
+       begin
+	  if(rx_xfer)
+	    rx_in_pkt <= ~rx_o_data[33];
+	  else if(~rx_in_pkt)
+	    src_on <= mode[0];
+	  if(tx_xfer)
+	    tx_in_pkt <= ~tx_i_data[33];
+	  else if(~tx_in_pkt)
+	    sink_on <= mode[1];
+       end
+
+   // the counters are kept after a side is turned off, for readback
+   always @(posedge clk)
+     begin
+	src_on_d <= src_on;
+	sink_on_d <= sink_on;
+     end
+   wire        src_start = src_on & ~src_on_d;
+   wire        sink_start = sink_on & ~sink_on_d;
+
+   // generated packets behind a protocol engine line
+   wire [2:0]  port_sel_bits = PORT_SEL;
+   wire [15:0] bytes = LEN + 4;
+   wire [35:0] gen_data;
+   wire        gen_valid, gen_ready;
+   reg 	       gen_hdr;
+
+   packet_generator32 #(.LEN(LEN)) packet_generator32
+     (.clk(clk), .reset(rst), .clear(~src_on),
+      .header(128'd0),
+      .data_o(gen_data), .src_rdy_o(gen_valid), .dst_rdy_i(gen_ready));
+
+   always @(posedge clk)
+     if(rst | ~src_on)
+       gen_hdr <= 1;
+     else if(rx_xfer)
+       gen_hdr <= rx_o_data[33];
+
+   wire [35:0] src_data = gen_hdr ? {4'b0001, 12'd0, port_sel_bits, 1'b1, bytes} :
+		{gen_data[35:33], 1'b0, gen_data[31:0]};
+   assign gen_ready = src_on & ~gen_hdr & rx_o_ready;
+
+   assign rx_o_data = src_on ? src_data : rx_i_data;
+   assign rx_o_valid = src_on ? (gen_hdr | gen_valid) : rx_i_valid;
+   assign rx_i_ready = ~src_on & rx_o_ready;
+
+   always @(posedge clk)
+     if(rst | src_start)
+       sent <= 0;
+     else if(rx_xfer & rx_o_data[33])
+       sent <= sent + 1;
+
+   // verified packets without the transport word, VRT header and SID
+   reg [1:0]   strip;
+   reg 	       ver_sof;
+   always @(posedge clk)
+     if(rst | ~sink_on)
+       begin
+	  strip <= 0;
+	  ver_sof <= 0;
+       end
+     else if(tx_xfer)
+       begin
+	  ver_sof <= (strip == 2);
+	  if(tx_i_data[33])
+	    strip <= 0;
+	  else if(strip != 3)
+	    strip <= strip + 1;
+       end
+
+   wire        ver_ready;
+   packet_verifier32 packet_verifier32
+     (.clk(clk), .reset(rst), .clear(sink_start),
+      .data_i({tx_i_data[35:33], ver_sof, tx_i_data[31:0]}),
+      .src_rdy_i(sink_on & tx_i_valid & (strip == 3)), .dst_rdy_o(ver_ready),
+      .total(total), .crc_err(crc_err), .seq_err(seq_err), .len_err());
+
+   assign tx_o_data = tx_i_data;
+   assign tx_o_valid = ~sink_on & tx_i_valid;
+   assign tx_i_ready = sink_on ? ((strip != 3) | ver_ready) : tx_o_ready;
+
+endmodule // umtrx_link_test
@@ -105,18 +105,46 @@ module umtrx_router
 
     ////////////////////////////////////////////////////////////////////
     // Communication output source combiner (feeds UDP proto machine)
+    //   - control lane: FIFO ctrl responses and CPU packets
+    //   - data lane: DSP streams and TX async messages, round robin
+    //   - the control lane has strict priority over the data lane, so a
+    //     response waits for at most the one data packet in flight
     ////////////////////////////////////////////////////////////////////
-    axi_mux8 #(.WIDTH(36), .BUFFER(1)) combiner
+    wire [35:0] ctl_lane_data, dat_lane_data;
+    wire        ctl_lane_valid, dat_lane_valid;
+    wire        ctl_lane_ready, dat_lane_ready;
+
+    axi_mux4 #(.WIDTH(36), .BUFFER(1)) ctl_lane
+    (
+        .clk(stream_clk), .reset(stream_rst), .clear(stream_clr),
+        .i0_tdata(ctrl_inp_data), .i0_tlast(ctrl_inp_data[33]), .i0_tvalid(ctrl_inp_valid), .i0_tready(ctrl_inp_ready),
+        .i1_tdata(cpu_inp_data), .i1_tlast(cpu_inp_data[33]), .i1_tvalid(cpu_inp_valid), .i1_tready(cpu_inp_ready),
+        .i2_tdata(36'd0), .i2_tlast(1'b0), .i2_tvalid(1'b0), .i2_tready(),
+        .i3_tdata(36'd0), .i3_tlast(1'b0), .i3_tvalid(1'b0), .i3_tready(),
+        .o_tdata(ctl_lane_data), .o_tlast(), .o_tvalid(ctl_lane_valid), .o_tready(ctl_lane_ready)
+    );
+
+    axi_mux8 #(.WIDTH(36), .BUFFER(1)) dat_lane
+    (
+        .clk(stream_clk), .reset(stream_rst), .clear(stream_clr),
+        .i0_tdata(dsp0_inp_data), .i0_tlast(dsp0_inp_data[33]), .i0_tvalid(dsp0_inp_valid), .i0_tready(dsp0_inp_ready),
+        .i1_tdata(dsp1_inp_data), .i1_tlast(dsp1_inp_data[33]), .i1_tvalid(dsp1_inp_valid), .i1_tready(dsp1_inp_ready),
+        .i2_tdata(dsp2_inp_data), .i2_tlast(dsp2_inp_data[33]), .i2_tvalid(dsp2_inp_valid), .i2_tready(dsp2_inp_ready),
+        .i3_tdata(dsp3_inp_data), .i3_tlast(dsp3_inp_data[33]), .i3_tvalid(dsp3_inp_valid), .i3_tready(dsp3_inp_ready),
+        .i4_tdata(err0_inp_data), .i4_tlast(err0_inp_data[33]), .i4_tvalid(err0_inp_valid), .i4_tready(err0_inp_ready),
+        .i5_tdata(err1_inp_data), .i5_tlast(err1_inp_data[33]), .i5_tvalid(err1_inp_valid), .i5_tready(err1_inp_ready),
+        .i6_tdata(36'd0), .i6_tlast(1'b0), .i6_tvalid(1'b0), .i6_tready(),
+        .i7_tdata(36'd0), .i7_tlast(1'b0), .i7_tvalid(1'b0), .i7_tready(),
+        .o_tdata(dat_lane_data), .o_tlast(), .o_tvalid(dat_lane_valid), .o_tready(dat_lane_ready)
+    );
+
+    axi_mux4 #(.PRIO(1), .WIDTH(36), .BUFFER(1)) combiner
     (
         .clk(stream_clk), .reset(stream_rst), .clear(stream_clr),
-        .i0_tdata(cpu_inp_data), .i0_tlast(cpu_inp_data[33]), .i0_tvalid(cpu_inp_valid), .i0_tready(cpu_inp_ready),
-        .i1_tdata(ctrl_inp_data), .i1_tlast(ctrl_inp_data[33]), .i1_tvalid(ctrl_inp_valid), .i1_tready(ctrl_inp_ready),
-        .i2_tdata(dsp0_inp_data), .i2_tlast(dsp0_inp_data[33]), .i2_tvalid(dsp0_inp_valid), .i2_tready(dsp0_inp_ready),
-        .i3_tdata(dsp1_inp_data), .i3_tlast(dsp1_inp_data[33]), .i3_tvalid(dsp1_inp_valid), .i3_tready(dsp1_inp_ready),
-        .i4_tdata(dsp2_inp_data), .i4_tlast(dsp2_inp_data[33]), .i4_tvalid(dsp2_inp_valid), .i4_tready(dsp2_inp_ready),
-        .i5_tdata(dsp3_inp_data), .i5_tlast(dsp3_inp_data[33]), .i5_tvalid(dsp3_inp_valid), .i5_tready(dsp3_inp_ready),
-        .i6_tdata(err0_inp_data), .i6_tlast(err0_inp_data[33]), .i6_tvalid(err0_inp_valid), .i6_tready(err0_inp_ready),
-        .i7_tdata(err1_inp_data), .i7_tlast(err1_inp_data[33]), .i7_tvalid(err1_inp_valid), .i7_tready(err1_inp_ready),
+        .i0_tdata(ctl_lane_data), .i0_tlast(ctl_lane_data[33]), .i0_tvalid(ctl_lane_valid), .i0_tready(ctl_lane_ready),
+        .i1_tdata(dat_lane_data), .i1_tlast(dat_lane_data[33]), .i1_tvalid(dat_lane_valid), .i1_tready(dat_lane_ready),
+        .i2_tdata(36'd0), .i2_tlast(1'b0), .i2_tvalid(1'b0), .i2_tready(),
+        .i3_tdata(36'd0), .i3_tlast(1'b0), .i3_tvalid(1'b0), .i3_tready(),
         .o_tdata(com_out_data), .o_tlast(), .o_tvalid(com_out_valid), .o_tready(com_out_ready)
     );
 
@@ -124,7 +152,7 @@ module umtrx_router
     // Interface CPU to memory mapped wishbone
     //   - Uses 1 setting register
     ////////////////////////////////////////////////////////////////////
-    buffer_int2 #(.BASE(CTRL_BASE), .BUF_SIZE(BUF_SIZE)) cpu_to_wb(
+    buffer_int2 #(.BASE(CTRL_BASE), .BUF_SIZE(BUF_SIZE), .CHKSUM(1)) cpu_to_wb(
         .clk(stream_clk), .rst(stream_rst | stream_clr),
         .set_stb(set_stb), .set_addr(set_addr), .set_data(set_data),
         .status(cpu_iface_status),
@@ -8,7 +8,15 @@ module umtrx_rx_chain
     parameter DSPNO = 0, //the dsp unit number: 0, 1, 2...
     parameter DSP_BASE = 0,
     parameter CTRL_BASE = 0,
+    parameter GATE_BASE = 0,
+    parameter FIR_BASE = 0,
+    parameter SHARED_CORDIC = 0, //the DDC CORDIC is on the cordic_* ports
     parameter FIFOSIZE = 10,
+    parameter CMD_FIFO_SIZE = 4, //stream command fifo, see vita_rx_control
+    parameter COMBINE_BASE = 0,
+    parameter COMBINE = 0, //diversity combining with the combine_* samples of the partner chain
+    parameter TONE_BASE = 0,
+    parameter TONE = 0, //single bin tone meter, its result replaces rx_power while enabled
     parameter DEBUG = 0
 )
 (
@@ -37,6 +45,31 @@ module umtrx_rx_chain
     input adc_stb,
     output run,
 
+    //fe clock domain, to a CORDIC shared with another chain
+    output [24:0] cordic_xi,
+    output [24:0] cordic_yi,
+    output [23:0] cordic_zi,
+    input [24:0] cordic_xo,
+    input [24:0] cordic_yo,
+
+    //averaged baseband power or the tone meter result, dsp clock domain
+    output [31:0] rx_power,
+    //stream commands queued, dsp clock domain
+    output [7:0] cmd_queue_fill,
+    //gain changes of the frontend for in-band reports, dsp clock domain
+    input gain_stb,
+    input [31:0] gain_word,
+    input [31:0] gain_power,
+
+    //dsp clock domain, the DDC output to the partner chain and the partner output to combine
+    output [31:0] bb_sample,
+    output bb_strobe,
+    input [31:0] combine_sample,
+    input combine_strobe,
+    //the partner combines this DDC: keep it running, and this one combining the partner
+    input keep_run,
+    output combining,
+
     //sys clock domain
     output [35:0] vita_data_sys,
     output vita_valid_sys,
@@ -53,12 +86,17 @@ module umtrx_rx_chain
     reg ddc_run;
     reg ddc_clear;
     wire [31:0] ddc_sample;
-    ddc_chain #(.BASE(DSP_BASE), .DSPNO(DSPNO)) ddc_chain
+    wire hop_stb;
+    wire [31:0] hop_phase_inc;
+    ddc_chain #(.BASE(DSP_BASE), .FIR_BASE(FIR_BASE), .DSPNO(DSPNO), .SHARED_CORDIC(SHARED_CORDIC)) ddc_chain
     (
         .clk(fe_clk), .rst(fe_rst), .clr(ddc_clear),
         .set_stb(set_stb_fe),.set_addr(set_addr_fe),.set_data(set_data_fe),
         .set_stb_user(), .set_addr_user(), .set_data_user(),
+        .hop_stb(hop_stb), .hop_phase_inc(hop_phase_inc),
         .rx_fe_i(front_i),.rx_fe_q(front_q),
+        .cordic_xi(cordic_xi), .cordic_yi(cordic_yi), .cordic_zi(cordic_zi),
+        .cordic_xo(cordic_xo), .cordic_yo(cordic_yo),
         .sample(ddc_sample), .run(ddc_run), .strobe(ddc_strobe),
         .debug()
     );
@@ -76,15 +114,119 @@ module umtrx_rx_chain
     //from dsp to fe
     wire vita_clear;
     wire vita_run;
+    wire tone_run;
     always @(posedge dsp_clk) begin
         if (adc_stb) begin
-            ddc_run <= vita_run;
+            ddc_run <= vita_run | keep_run | tone_run;
             ddc_clear <= vita_clear;
         end
     end
 
     assign run = vita_run;
 
+    /*******************************************************************
+     * Timed frequency hops, crossed like the run and clear above
+     ******************************************************************/
+    wire hop_dsp;
+    wire [31:0] hop_phase_inc_dsp;
+    hop_table #(.BASE(DSP_BASE+5)) hop_table
+     (.clk(dsp_clk), .rst(dsp_rst),
+      .set_stb(set_stb_dsp),.set_addr(set_addr_dsp),.set_data(set_data_dsp),
+      .vita_time(vita_time), .hop(hop_dsp), .phase_inc(hop_phase_inc_dsp));
+
+    reg hop_pending, hop_fe;
+    reg [31:0] hop_phase_inc_fe;
+    always @(posedge dsp_clk) begin
+        if (dsp_rst) hop_pending <= 0;
+        else if (hop_dsp) hop_pending <= 1;
+        else if (adc_stb) hop_pending <= 0;
+        if (hop_dsp) hop_phase_inc_fe <= hop_phase_inc_dsp;
+        if (adc_stb) hop_fe <= hop_pending;
+    end
+    assign hop_stb = hop_fe;
+    assign hop_phase_inc = hop_phase_inc_fe;
+
+    /*******************************************************************
+     * Diversity combining with the partner chain, before everything
+     * that looks at the samples so power and gate see the combined ones
+     ******************************************************************/
+    assign bb_sample = vita_sample;
+    assign bb_strobe = vita_strobe && adc_stb;
+
+    wire [31:0] comb_sample;
+    wire comb_strobe;
+    generate
+    if (COMBINE) begin
+    wire combine_enable;
+    rx_combine #(.BASE(COMBINE_BASE)) rx_combine
+     (.clk(dsp_clk), .rst(dsp_rst),
+      .set_stb(set_stb_dsp),.set_addr(set_addr_dsp),.set_data(set_data_dsp),
+      .stb_a(bb_strobe), .sample_a(bb_sample),
+      .stb_b(combine_strobe), .sample_b(combine_sample),
+      .enable(combine_enable),
+      .stb_out(comb_strobe), .sample_out(comb_sample));
+    assign combining = combine_enable & vita_run;
+    end else begin
+    assign comb_sample = bb_sample;
+    assign comb_strobe = bb_strobe;
+    assign combining = 1'b0;
+    end
+    endgenerate
+
+    /*******************************************************************
+     * Baseband power for readback
+     ******************************************************************/
+    wire [3:0] power_avg_shift;
+    setting_reg #(.my_addr(CTRL_BASE+9), .width(4)) sr_power_avg
+     (.clk(dsp_clk),.rst(dsp_rst),.strobe(set_stb_dsp),.addr(set_addr_dsp),
+      .in(set_data_dsp),.out(power_avg_shift),.changed());
+
+    wire [31:0] avg_power;
+    rx_power rx_power_meter
+     (.clk(dsp_clk), .rst(dsp_rst), .clear(1'b0),
+      .stb(comb_strobe), .sample(comb_sample),
+      .avg_shift(power_avg_shift), .power(avg_power));
+
+    /*******************************************************************
+     * Single bin tone meter for calibration, keeps the DDC running
+     ******************************************************************/
+    generate
+    if (TONE) begin
+    wire [31:0] tone_power;
+    rx_tone #(.BASE(TONE_BASE)) rx_tone
+     (.clk(dsp_clk), .rst(dsp_rst),
+      .set_stb(set_stb_dsp),.set_addr(set_addr_dsp),.set_data(set_data_dsp),
+      .stb(comb_strobe), .sample(comb_sample),
+      .enable(tone_run), .power(tone_power));
+    assign rx_power = tone_run? tone_power : avg_power;
+    end else begin
+    assign tone_run = 1'b0;
+    assign rx_power = avg_power;
+    end
+    endgenerate
+
+    /*******************************************************************
+     * Statistics context packet period in dsp clock cycles
+     ******************************************************************/
+    wire [31:0] stats_period;
+    setting_reg #(.my_addr(DSP_BASE+9)) sr_stats_period
+     (.clk(dsp_clk),.rst(dsp_rst),.strobe(set_stb_dsp),.addr(set_addr_dsp),
+      .in(set_data_dsp),.out(stats_period),.changed());
+
+    /*******************************************************************
+     * TDMA timeslot gate, only the samples in open windows are framed
+     ******************************************************************/
+    wire [31:0] gate_sample;
+    wire [63:0] gate_time;
+    wire gate_strobe, gate_last;
+    vita_rx_gate #(.BASE(GATE_BASE)) vita_rx_gate
+     (.clk(dsp_clk), .reset(dsp_rst), .clear(vita_clear),
+      .set_stb(set_stb_dsp),.set_addr(set_addr_dsp),.set_data(set_data_dsp),
+      .vita_time(vita_time), .run(vita_run),
+      .sample_i(comb_sample), .strobe_i(comb_strobe),
+      .sample_o(gate_sample), .strobe_o(gate_strobe),
+      .time_o(gate_time), .last_o(gate_last));
+
     /*******************************************************************
      * RX VITA framer
      ******************************************************************/
@@ -92,13 +234,17 @@ module umtrx_rx_chain
     wire vita_valid_dsp;
     wire vita_ready_dsp;
 
-    vita_rx_chain #(.BASE(CTRL_BASE),.UNIT(PROT_DEST),.FIFOSIZE(FIFOSIZE), .DSP_NUMBER(DSPNO)) vita_rx_chain
+    vita_rx_chain #(.BASE(CTRL_BASE),.UNIT(PROT_DEST),.FIFOSIZE(FIFOSIZE), .DSP_NUMBER(DSPNO), .CMD_FIFO_SIZE(CMD_FIFO_SIZE)) vita_rx_chain
      (.clk(dsp_clk), .reset(dsp_rst),
       .set_stb(set_stb_dsp),.set_addr(set_addr_dsp),.set_data(set_data_dsp),
       .set_stb_user(), .set_addr_user(), .set_data_user(),
       .vita_time(vita_time), .overrun(),
-      .sample(vita_sample), .run(vita_run), .strobe(vita_strobe && adc_stb), .clear_o(vita_clear),
+      .sample(gate_sample), .run(vita_run), .strobe(gate_strobe), .clear_o(vita_clear),
+      .sample_time(gate_time), .sample_last(gate_last),
+      .stats_period(stats_period), .stats_power(avg_power),
+      .gain_stb(gain_stb), .gain_word(gain_word), .gain_power(gain_power),
       .rx_data_o(vita_data_dsp), .rx_src_rdy_o(vita_valid_dsp), .rx_dst_rdy_i(vita_ready_dsp),
+      .cmd_queue_fill(cmd_queue_fill),
       .debug() );
 
     /*******************************************************************
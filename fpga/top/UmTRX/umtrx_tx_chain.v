@@ -8,6 +8,9 @@ module umtrx_tx_chain
     parameter DSPNO = 0, //the dsp unit number: 0, 1, 2...
     parameter DSP_BASE = 0,
     parameter CTRL_BASE = 0,
+    parameter MOD_BASE = 0,
+    parameter RAMP_BASE = 0,
+    parameter SHARED_CORDIC = 0, //the DUC CORDIC is on the cordic_* ports
     parameter FIFOSIZE = 10,
     parameter DEBUG = 0
 )
@@ -37,6 +40,13 @@ module umtrx_tx_chain
     input dac_stb,
     output run,
 
+    //fe clock domain, to a CORDIC shared with another chain
+    output [23:0] cordic_xi,
+    output [23:0] cordic_yi,
+    output [23:0] cordic_zi,
+    input [23:0] cordic_xo,
+    input [23:0] cordic_yo,
+
     //sys clock domain
     input [35:0] vita_data_sys,
     input vita_valid_sys,
@@ -47,6 +57,13 @@ module umtrx_tx_chain
     output err_valid_sys,
     input err_ready_sys,
 
+    //dsp clock domain, {late, underrun} packets, free running
+    output [31:0] counters,
+
+    //dsp clock domain, a timed burst waits for its time
+    output burst_pending,
+    output [63:0] burst_time,
+
     //vita time in dsp clock domain
     wire [63:0] vita_time
 );
@@ -58,12 +75,17 @@ module umtrx_tx_chain
     reg duc_run;
     reg duc_clear;
     reg [31:0] duc_sample;
-    duc_chain #(.BASE(DSP_BASE), .DSPNO(DSPNO)) duc_chain
+    wire hop_stb;
+    wire [31:0] hop_phase_inc;
+    duc_chain #(.BASE(DSP_BASE), .DSPNO(DSPNO), .SHARED_CORDIC(SHARED_CORDIC)) duc_chain
     (
         .clk(fe_clk),.rst(fe_rst), .clr(duc_clear),
         .set_stb(set_stb_fe),.set_addr(set_addr_fe),.set_data(set_data_fe),
         .set_stb_user(), .set_addr_user(), .set_data_user(),
+        .hop_stb(hop_stb), .hop_phase_inc(hop_phase_inc),
         .tx_fe_i(front_i),.tx_fe_q(front_q),
+        .cordic_xi(cordic_xi), .cordic_yi(cordic_yi), .cordic_zi(cordic_zi),
+        .cordic_xo(cordic_xo), .cordic_yo(cordic_yo),
         .sample(duc_sample), .run(duc_run), .strobe(duc_strobe),
         .debug()
     );
@@ -75,18 +97,63 @@ module umtrx_tx_chain
     always @(posedge fe_clk) vita_strobe <= duc_strobe;
 
     //from dsp to fe
-    wire [31:0] vita_sample;
+    wire [31:0] vita_sample, mod_sample, ramp_sample;
     wire vita_clear;
-    wire vita_run;
+    wire vita_run, mod_run, ramp_run;
     always @(posedge dsp_clk) begin
         if (dac_stb) begin
-            duc_run <= vita_run;
+            duc_run <= ramp_run;
             duc_clear <= vita_clear;
-            duc_sample <= vita_sample;
+            duc_sample <= ramp_sample;
         end
     end
 
-    assign run = vita_run;
+    assign run = ramp_run;
+
+    /*******************************************************************
+     * GMSK modulator, bits from the deframer and samples to the DUC
+     ******************************************************************/
+    wire mod_word_stb;
+    tx_gmsk #(.BASE(MOD_BASE)) tx_gmsk
+    (
+        .clk(dsp_clk), .rst(dsp_rst),
+        .set_stb(set_stb_dsp),.set_addr(set_addr_dsp),.set_data(set_data_dsp),
+        .word(vita_sample), .word_run(vita_run), .word_stb(mod_word_stb),
+        .sample_stb(vita_strobe && dac_stb), .sample(mod_sample), .run(mod_run)
+    );
+
+    /*******************************************************************
+     * Power ramps at the burst edges, run stays up for the ramp down
+     ******************************************************************/
+    tx_ramp #(.BASE(RAMP_BASE)) tx_ramp
+    (
+        .clk(dsp_clk), .rst(dsp_rst),
+        .set_stb(set_stb_dsp),.set_addr(set_addr_dsp),.set_data(set_data_dsp),
+        .stb(vita_strobe && dac_stb), .sample(mod_sample), .run(mod_run),
+        .sample_o(ramp_sample), .run_o(ramp_run)
+    );
+
+    /*******************************************************************
+     * Timed frequency hops, crossed like the run and clear above
+     ******************************************************************/
+    wire hop_dsp;
+    wire [31:0] hop_phase_inc_dsp;
+    hop_table #(.BASE(DSP_BASE+5)) hop_table
+     (.clk(dsp_clk), .rst(dsp_rst),
+      .set_stb(set_stb_dsp),.set_addr(set_addr_dsp),.set_data(set_data_dsp),
+      .vita_time(vita_time), .hop(hop_dsp), .phase_inc(hop_phase_inc_dsp));
+
+    reg hop_pending, hop_fe;
+    reg [31:0] hop_phase_inc_fe;
+    always @(posedge dsp_clk) begin
+        if (dsp_rst) hop_pending <= 0;
+        else if (hop_dsp) hop_pending <= 1;
+        else if (dac_stb) hop_pending <= 0;
+        if (hop_dsp) hop_phase_inc_fe <= hop_phase_inc_dsp;
+        if (dac_stb) hop_fe <= hop_pending;
+    end
+    assign hop_stb = hop_fe;
+    assign hop_phase_inc = hop_phase_inc_fe;
 
     /*******************************************************************
      * TX VITA deframer
@@ -107,7 +174,9 @@ module umtrx_tx_chain
         .vita_time(vita_time),
         .tx_data_i(vita_data_dsp), .tx_src_rdy_i(vita_valid_dsp), .tx_dst_rdy_o(vita_ready_dsp),
         .err_data_o(err_data_dsp), .err_src_rdy_o(err_valid_dsp), .err_dst_rdy_i(err_ready_dsp),
-        .sample(vita_sample), .strobe(vita_strobe && dac_stb), .run(vita_run), .clear_o(vita_clear),
+        .sample(vita_sample), .strobe(mod_word_stb), .run(vita_run), .clear_o(vita_clear),
+        .burst_pending(burst_pending), .burst_time(burst_time),
+        .counters(counters),
         .debug()
     );
 
@@ -52,6 +52,15 @@ module prot_eng_tx
 
    wire [15:0] 	  pre_checksum = pre_checksums[port_sel[2:0]];
 
+   // Header word 13 of a port is its 802.1Q tag {TCI, ethertype}, sent after
+   // word 4 which then ends in 8100. Zero sends untagged frames.
+   reg [7:0] 	  vlan_ports;
+   always @(posedge clk)
+     if(reset)
+       vlan_ports <= 0;
+     else if(set_stb & ((set_addr & 8'h8F)== (BASE+13)))
+       vlan_ports[set_addr[6:4]] <= (set_data != 0);
+
    // Protocol State Machine
    reg [15:0] length;
    wire [15:0] ip_length = length + 28;  // IP HDR + UDP HDR
@@ -78,12 +87,22 @@ module prot_eng_tx
 		else
 		  state <= 12;
 	     end
+	   4 :
+	     begin
+		sof_o <= 0;
+		state <= vlan_ports[port_sel] ? 13 : 5;
+	     end
 	   12 :
 	     begin
 		sof_o <= 0;
 		if(data_int1[33]) // eof
 		  state <= 0;
 	     end
+	   13 :
+	     begin
+		sof_o <= 0;
+		state <= 5;
+	     end
 	   default :
 	     begin
 		sof_o 	<= 0;
@@ -103,6 +122,7 @@ module prot_eng_tx
        2 : prot_data <= header_word;  // ETH
        3 : prot_data <= header_word;  // ETH
        4 : prot_data <= header_word;  // ETH
+       13: prot_data <= header_word;  // ETH, VLAN tag
        5 : prot_data <= { header_word[31:16], ip_length }; // IP
        6 : prot_data <= header_word; // IP
        7 : prot_data <= { header_word[31:16], (16'hFFFF ^ ip_checksum_reg) }; // IP
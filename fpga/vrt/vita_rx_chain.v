@@ -21,14 +21,19 @@ module vita_rx_chain
     parameter UNIT=0,
     parameter FIFOSIZE=10,
     parameter PROT_ENG_FLAGS=1,
-    parameter DSP_NUMBER=0)
+    parameter DSP_NUMBER=0,
+    parameter CMD_FIFO_SIZE=4)
    (input clk, input reset,
     input set_stb, input [7:0] set_addr, input [31:0] set_data,
     input set_stb_user, input [7:0] set_addr_user, input [31:0] set_data_user,
     input [63:0] vita_time,
     input [31:0] sample, input strobe,
+    input [63:0] sample_time, input sample_last,
+    input [31:0] stats_period, input [31:0] stats_power,
+    input gain_stb, input [31:0] gain_word, input [31:0] gain_power,
     output [35:0] rx_data_o, output rx_src_rdy_o, input rx_dst_rdy_i,
     output overrun, output run, output clear_o,
+    output [7:0] cmd_queue_fill,
     output [31:0] debug );
 
    wire [100:0] sample_data;
@@ -45,18 +50,101 @@ module vita_rx_chain
      (.clk(clk),.rst(reset),.strobe(set_stb),.addr(set_addr),
       .in(set_data),.out(),.changed(clear_int));
 
-   vita_rx_control #(.BASE(BASE), .WIDTH(32)) vita_rx_control
+   vita_rx_control #(.BASE(BASE), .WIDTH(32), .CMD_FIFO_SIZE(CMD_FIFO_SIZE)) vita_rx_control
      (.clk(clk), .reset(reset), .clear(clear),
       .set_stb(set_stb),.set_addr(set_addr),.set_data(set_data),
       .vita_time(vita_time), .overrun(overrun),
       .sample(sample), .run(run), .strobe(strobe),
+      .sample_time(sample_time), .sample_last(sample_last),
       .sample_fifo_o(sample_data), .sample_fifo_dst_rdy_i(sample_dst_rdy), .sample_fifo_src_rdy_o(sample_src_rdy),
+      .sample_fifo_occupied(sample_fifo_occupied), .command_queue_fill(cmd_queue_fill),
       .debug_rx(vrc_debug));
+
+   // Statistics context packets every stats_period cycles while running, zero turns them off.
+   // Overflows and data packets count since the last clear, the high water mark since the last packet.
+   wire [4:0]  sample_fifo_occupied;
+   wire        stats_ack;
+   reg 	       stats_req, overrun_d;
+   reg [31:0]  stats_cycles, overflows;
+   reg [4:0]   high_water;
+
+   always @(posedge clk)
+     if(reset | clear)
+       begin
+	  overflows <= 0;
+	  overrun_d <= 0;
+       end
+     else
+       begin
+	  overrun_d <= overrun;
+	  if(overrun & ~overrun_d)
+	    overflows <= overflows + 1;
+       end
+
+   always @(posedge clk)
+     if(reset | clear | stats_ack)
+       high_water <= 0;
+     else if(sample_fifo_occupied > high_water)
+       high_water <= sample_fifo_occupied;
+
+   always @(posedge clk)
+     if(reset | clear | ~run | (stats_period == 0))
+       begin
+	  stats_req <= 0;
+	  stats_cycles <= 0;
+       end
+     else
+       begin
+	  if(stats_ack)
+	    stats_req <= 0;
+	  else if(stats_cycles == stats_period)
+	    stats_req <= 1;
+	  stats_cycles <= (stats_cycles == stats_period) ? 0 : stats_cycles + 1;
+       end
    
+   // Gain change context packet for each gain_stb while running, stamped with the time of the strobe.
+   // The framer holds the packet it sends, a change before that is out waits in the next registers
+   // and a newer change replaces the waiting one, the sequence in gain_word tells.
+   wire        gain_ack;
+   reg 	       gain_req, gain_next;
+   reg [63:0]  gain_time, gain_time_next;
+   reg [31:0]  gain_word_r, gain_power_r, gain_word_next, gain_power_next;
+
+   always @(posedge clk)
+     if(reset | clear | ~run)
+       begin
+	  gain_req <= 0;
+	  gain_next <= 0;
+       end
+     else
+       begin
+	  if(gain_stb)
+	    begin
+	       gain_next <= 1;
+	       gain_time_next <= vita_time;
+	       gain_word_next <= gain_word;
+	       gain_power_next <= gain_power;
+	    end
+	  else if(gain_next & ~gain_req)
+	    begin
+	       gain_next <= 0;
+	       gain_req <= 1;
+	       gain_time <= gain_time_next;
+	       gain_word_r <= gain_word_next;
+	       gain_power_r <= gain_power_next;
+	    end
+	  if(gain_ack)
+	    gain_req <= 0;
+       end
+
    vita_rx_framer #(.BASE(BASE), .MAXCHAN(1)) vita_rx_framer
      (.clk(clk), .reset(reset), .clear(clear),
       .set_stb(set_stb),.set_addr(set_addr),.set_data(set_data),
       .sample_fifo_i(sample_data), .sample_fifo_dst_rdy_o(sample_dst_rdy), .sample_fifo_src_rdy_i(sample_src_rdy),
+      .vita_time(vita_time), .stats_req(stats_req), .stats_ack(stats_ack),
+      .stats_overflows(overflows), .stats_high_water({27'd0,high_water}), .stats_power(stats_power),
+      .gain_req(gain_req), .gain_ack(gain_ack),
+      .gain_time(gain_time), .gain_word(gain_word_r), .gain_power(gain_power_r),
       .data_o(rx_data_int), .src_rdy_o(rx_src_rdy_int), .dst_rdy_i(rx_dst_rdy_int),
       .debug_rx(vrf_debug) );
 
@@ -18,7 +18,8 @@
 
 module vita_rx_control
   #(parameter BASE=0,
-    parameter WIDTH=32)
+    parameter WIDTH=32,
+    parameter CMD_FIFO_SIZE=4) //block RAM command fifo of 2^N-2 lines for 6 to 8, 16 lines otherwise
    (input clk, input reset, input clear,
     input set_stb, input [7:0] set_addr, input [31:0] set_data,
     
@@ -34,6 +35,16 @@ module vita_rx_control
     input [WIDTH-1:0] sample,
     output run,
     input strobe,
+
+    // Time of the sample and end of a gated burst, from vita_rx_gate
+    input [63:0] sample_time,
+    input sample_last,
+
+    // Sample fifo fill, for the statistics packets
+    output [4:0] sample_fifo_occupied,
+
+    // Stream commands waiting in the command fifo
+    output reg [7:0] command_queue_fill,
     
     output [31:0] debug_rx
     );
@@ -78,14 +89,36 @@ module vita_rx_control
    
    assign      write_ctrl  = sc_pre1 & ~sc_pre2;
 
-   wire [4:0]  command_queue_len;
+   wire [4:0]  command_queue_len = (command_queue_fill > 31)? 5'd31 : command_queue_fill[4:0];
+   wire        command_fifo_ready;
 
-   fifo_short #(.WIDTH(96)) commandfifo
-     (.clk(clk),.reset(reset),.clear(clear),
-      .datain({new_command,new_time}), .src_rdy_i(write_ctrl), .dst_rdy_o(),
-      .dataout({send_imm_pre,chain_pre,reload_pre,stop_pre,numlines_pre,rcvtime_pre}),
-      .src_rdy_o(not_empty_ctrl), .dst_rdy_i(read_ctrl),
-      .occupied(command_queue_len), .space() );
+   // A deep fifo holds a whole schedule of timed capture windows
+   generate
+      if(CMD_FIFO_SIZE > 5)
+	axi_fifo #(.WIDTH(96), .SIZE(CMD_FIFO_SIZE)) commandfifo
+	  (.clk(clk),.reset(reset),.clear(clear),
+	   .i_tdata({new_command,new_time}), .i_tvalid(write_ctrl), .i_tready(command_fifo_ready),
+	   .o_tdata({send_imm_pre,chain_pre,reload_pre,stop_pre,numlines_pre,rcvtime_pre}),
+	   .o_tvalid(not_empty_ctrl), .o_tready(read_ctrl),
+	   .space(), .occupied() );
+      else
+	fifo_short #(.WIDTH(96)) commandfifo
+	  (.clk(clk),.reset(reset),.clear(clear),
+	   .datain({new_command,new_time}), .src_rdy_i(write_ctrl), .dst_rdy_o(command_fifo_ready),
+	   .dataout({send_imm_pre,chain_pre,reload_pre,stop_pre,numlines_pre,rcvtime_pre}),
+	   .src_rdy_o(not_empty_ctrl), .dst_rdy_i(read_ctrl),
+	   .occupied(), .space() );
+   endgenerate
+
+   // Commands written to a full fifo are dropped, they do not count
+   wire        command_write = write_ctrl & command_fifo_ready;
+   always @(posedge clk)
+     if(reset | clear)
+       command_queue_fill <= 0;
+     else if(command_write & ~read_ctrl)
+       command_queue_fill <= command_queue_fill + 1;
+     else if(read_ctrl & ~command_write)
+       command_queue_fill <= command_queue_fill - 1;
    
    reg [33:0]  pkt_fifo_line;
 
@@ -104,7 +137,8 @@ module vita_rx_control
    wire signal_zerolen 	    = (ibs_state == IBS_ZEROLEN);
 
    // Buffer of samples for while we're writing the packet headers
-   wire [4:0] flags = {signal_zerolen,signal_overrun,signal_brokenchain,signal_latecmd,signal_cmd_done};
+   wire       signal_gate_done    = run & sample_last;
+   wire [4:0] flags = {signal_zerolen,signal_overrun,signal_brokenchain,signal_latecmd,signal_cmd_done|signal_gate_done};
 
    wire       attempt_sample_write    = ((run & strobe) | (ibs_state==IBS_OVERRUN) |
 					 (ibs_state==IBS_BROKENCHAIN) | (ibs_state==IBS_LATECMD) |
@@ -112,10 +146,10 @@ module vita_rx_control
    
    fifo_short #(.WIDTH(5+64+WIDTH)) rx_sample_fifo
      (.clk(clk),.reset(reset),.clear(clear),
-      .datain({flags,vita_time,sample}), .src_rdy_i(attempt_sample_write), .dst_rdy_o(sample_fifo_in_rdy),
+      .datain({flags,(run ? sample_time : vita_time),sample}), .src_rdy_i(attempt_sample_write), .dst_rdy_o(sample_fifo_in_rdy),
       .dataout(sample_fifo_o), 
       .src_rdy_o(sample_fifo_src_rdy_o), .dst_rdy_i(sample_fifo_dst_rdy_i),
-      .space(), .occupied() );
+      .space(), .occupied(sample_fifo_occupied) );
    
    // Inband Signalling State Machine
    time_compare 
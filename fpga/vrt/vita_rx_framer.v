@@ -31,6 +31,15 @@ module vita_rx_framer
     input [5+64+(32*MAXCHAN)-1:0] sample_fifo_i,
     input sample_fifo_src_rdy_i,
     output sample_fifo_dst_rdy_o,
+
+    // Statistics context packet, sent between data packets while requested
+    input [63:0] vita_time,
+    input stats_req, output stats_ack,
+    input [31:0] stats_overflows, input [31:0] stats_high_water, input [31:0] stats_power,
+
+    // Gain change context packet, sent before the next data packet
+    input gain_req, output gain_ack,
+    input [63:0] gain_time, input [31:0] gain_word, input [31:0] gain_power,
     
     output [31:0] debug_rx
     );
@@ -62,7 +71,9 @@ module vita_rx_framer
    wire [15:0] 	  samples_per_packet;
    
    reg [33:0] 	  pkt_fifo_line;
-   reg [3:0] 	  vita_state;
+   reg [4:0] 	  vita_state;
+   reg [63:0] 	  stats_time;
+   reg [31:0] 	  data_pkts;
    reg [15:0] 	  sample_ctr;
    reg [3:0] 	  pkt_count;
    
@@ -105,6 +116,20 @@ module vita_rx_framer
    localparam VITA_ERR_TICS2 	 = 10;
    localparam VITA_ERR_PAYLOAD 	 = 11;
    localparam VITA_ERR_TRAILER 	 = 12; // Extension context packets have no trailer
+   localparam VITA_STATS_HEADER  = 13; // Statistics are extension context packets too
+   localparam VITA_STATS_STREAMID = 14;
+   localparam VITA_STATS_TICS 	 = 15;
+   localparam VITA_STATS_TICS2 	 = 16;
+   localparam VITA_STATS_OVERFLOWS = 17;
+   localparam VITA_STATS_HIGH_WATER = 18;
+   localparam VITA_STATS_POWER 	 = 19;
+   localparam VITA_STATS_PACKETS = 20;
+   localparam VITA_GAIN_HEADER 	 = 21; // Gain changes of the RX AGC
+   localparam VITA_GAIN_STREAMID = 22;
+   localparam VITA_GAIN_TICS 	 = 23;
+   localparam VITA_GAIN_TICS2 	 = 24;
+   localparam VITA_GAIN_CODE 	 = 25;
+   localparam VITA_GAIN_POWER 	 = 26;
       
    always @(posedge clk)
      if(reset | clear | clear_pkt_count)
@@ -112,6 +137,12 @@ module vita_rx_framer
      else if((vita_state == VITA_TRAILER) & pkt_fifo_rdy)
        pkt_count <= pkt_count + 1;
 
+   always @(posedge clk)
+     if(reset | clear)
+       data_pkts <= 0;
+     else if((vita_state == VITA_TRAILER) & pkt_fifo_rdy)
+       data_pkts <= data_pkts + 1;
+
    wire 	  has_streamid = vita_header[28];
    wire 	  has_trailer = vita_header[26];
    reg 		  trl_eob;
@@ -134,6 +165,24 @@ module vita_rx_framer
        VITA_ERR_TICS2 : pkt_fifo_line <= {2'b00,vita_time_fifo_o[31:0]};
        VITA_ERR_PAYLOAD : pkt_fifo_line <= {2'b10,27'd0,flags_fifo_o};
        //VITA_ERR_TRAILER : pkt_fifo_line <= {2'b11,vita_trailer};
+
+       // Statistics packets carry four words, the packet count does not advance
+       VITA_STATS_HEADER : pkt_fifo_line <= {2'b01,4'b0101,4'b0000,vita_header[23:20],pkt_count,16'd8};
+       VITA_STATS_STREAMID : pkt_fifo_line <= {2'b00,vita_streamid};
+       VITA_STATS_TICS : pkt_fifo_line <= {2'b00,stats_time[63:32]};
+       VITA_STATS_TICS2 : pkt_fifo_line <= {2'b00,stats_time[31:0]};
+       VITA_STATS_OVERFLOWS : pkt_fifo_line <= {2'b00,stats_overflows};
+       VITA_STATS_HIGH_WATER : pkt_fifo_line <= {2'b00,stats_high_water};
+       VITA_STATS_POWER : pkt_fifo_line <= {2'b00,stats_power};
+       VITA_STATS_PACKETS : pkt_fifo_line <= {2'b10,data_pkts};
+
+       // Gain change packets carry two words and the time the gain was applied
+       VITA_GAIN_HEADER : pkt_fifo_line <= {2'b01,4'b0101,4'b0000,vita_header[23:20],pkt_count,16'd6};
+       VITA_GAIN_STREAMID : pkt_fifo_line <= {2'b00,vita_streamid};
+       VITA_GAIN_TICS : pkt_fifo_line <= {2'b00,gain_time[63:32]};
+       VITA_GAIN_TICS2 : pkt_fifo_line <= {2'b00,gain_time[31:0]};
+       VITA_GAIN_CODE : pkt_fifo_line <= {2'b00,gain_word};
+       VITA_GAIN_POWER : pkt_fifo_line <= {2'b10,gain_power};
        
        default : pkt_fifo_line <= 34'h0_FFFF_FFFF;
        endcase // case (vita_state)
@@ -150,7 +199,12 @@ module vita_rx_framer
 	 begin
 	    sample_ctr <= 1;
 	    sample_phase <= 0;
-	    if(sample_fifo_src_rdy_i)
+	    stats_time <= vita_time;
+	    if(gain_req)
+	      vita_state <= VITA_GAIN_HEADER;
+	    else if(stats_req)
+	      vita_state <= VITA_STATS_HEADER;
+	    else if(sample_fifo_src_rdy_i)
 	      if(|flags_fifo_o[4:1])
 		vita_state <= VITA_ERR_HEADER;
 	      else
@@ -183,6 +237,10 @@ module vita_rx_framer
 	     vita_state <= VITA_IDLE;
 	   VITA_TRAILER :
 	     vita_state <= VITA_IDLE;
+	   VITA_STATS_PACKETS :
+	     vita_state <= VITA_IDLE;
+	   VITA_GAIN_POWER :
+	     vita_state <= VITA_IDLE;
 	   default :
 	     vita_state 	   <= vita_state + 1;
 	 endcase // case (vita_state)
@@ -199,6 +257,12 @@ module vita_rx_framer
      	 req_write_pkt_fifo <= (sample_fifo_src_rdy_i & ~|flags_fifo_o[4:1]);
        VITA_ERR_HEADER, VITA_ERR_STREAMID, VITA_ERR_TICS, VITA_ERR_TICS2, VITA_ERR_PAYLOAD :
 	 req_write_pkt_fifo <= 1;
+       VITA_STATS_HEADER, VITA_STATS_STREAMID, VITA_STATS_TICS, VITA_STATS_TICS2,
+       VITA_STATS_OVERFLOWS, VITA_STATS_HIGH_WATER, VITA_STATS_POWER, VITA_STATS_PACKETS :
+	 req_write_pkt_fifo <= 1;
+       VITA_GAIN_HEADER, VITA_GAIN_STREAMID, VITA_GAIN_TICS, VITA_GAIN_TICS2,
+       VITA_GAIN_CODE, VITA_GAIN_POWER :
+	 req_write_pkt_fifo <= 1;
        default :
 	 req_write_pkt_fifo <= 0;
      endcase // case (vita_state)
@@ -219,6 +283,9 @@ module vita_rx_framer
 				      ~|flags_fifo_o[4:1]) |
 				     (vita_state==VITA_ERR_PAYLOAD));
    
+   assign stats_ack = (vita_state == VITA_STATS_PACKETS) & pkt_fifo_rdy;
+   assign gain_ack = (vita_state == VITA_GAIN_POWER) & pkt_fifo_rdy;
+
    assign debug_rx  = vita_state;
    
 endmodule // vita_rx_framer
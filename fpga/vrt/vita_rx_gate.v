@@ -0,0 +1,116 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//! Repeating timeslot gate in front of vita_rx_control.
+//! The period is split in NUM windows of WINDOW ticks, only the samples
+//! in the windows set in the mask reach the framer, each run of open
+//! windows becomes one burst. The samples are held back by one strobe so
+//! the last one of a burst is known when it is written, with its own time.
+//! The pattern starts at the armed time and then runs on its own, so a
+//! stream restarted after an overflow keeps the slot alignment. The compare
+//! is modulo 2^32 like the hop table, the start must be less than 2^31
+//! ticks ahead. With a zero window the samples pass straight through.
+//!
+//! Registers:
+//!  BASE+0 window in ticks, zero turns the gate off
+//!  BASE+1 mask, bit n opens window n
+//!  BASE+2 [4:0] windows per period, zero for 32
+//!  BASE+3 low 32 bits of the start time of window 0, arms the gate
+
+module vita_rx_gate
+  #(parameter BASE = 0)
+   (input clk, input reset, input clear,
+    input set_stb, input [7:0] set_addr, input [31:0] set_data,
+    input [63:0] vita_time, input run,
+
+    input [31:0] sample_i, input strobe_i,
+    output [31:0] sample_o, output strobe_o,
+    output [63:0] time_o, output last_o);
+
+   wire [31:0] window, mask, start;
+   wire [4:0]  num;
+   wire        arm;
+
+   setting_reg #(.my_addr(BASE+0)) sr_window
+     (.clk(clk),.rst(reset),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(window),.changed());
+
+   setting_reg #(.my_addr(BASE+1)) sr_mask
+     (.clk(clk),.rst(reset),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(mask),.changed());
+
+   setting_reg #(.my_addr(BASE+2),.width(5)) sr_num
+     (.clk(clk),.rst(reset),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(num),.changed());
+
+   setting_reg #(.my_addr(BASE+3)) sr_start
+     (.clk(clk),.rst(reset),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(start),.changed(arm));
+
+   wire        enable = (window != 0);
+
+   // window index, steps when the vita time reaches the end of the window
+   reg 	       armed, started;
+   reg [31:0]  due;
+   reg [4:0]   idx;
+   wire [31:0] ahead = vita_time[31:0] - due;
+   wire [4:0]  last_idx = num - 5'd1;
+
+   always @(posedge clk)
+     if(reset | ~enable)
+       begin
+	  armed <= 0;
+	  started <= 0;
+       end
+     else if(arm)
+       begin
+	  armed <= 1;
+	  started <= 0;
+	  due <= start;
+	  idx <= 0;
+       end
+     else if(armed & ~ahead[31])
+       begin
+	  started <= 1;
+	  due <= due + window;
+	  if(started)
+	    idx <= (idx == last_idx) ? 5'd0 : idx + 5'd1;
+       end
+
+   wire        open = started & mask[idx];
+
+   // one sample behind, the next strobe tells if the held one ends a burst
+   reg [31:0]  held_sample;
+   reg [63:0]  held_time;
+   reg 	       held;
+
+   always @(posedge clk)
+     if(reset | clear | ~run)
+       held <= 0;
+     else if(strobe_i)
+       begin
+	  held <= open;
+	  held_sample <= sample_i;
+	  held_time <= vita_time;
+       end
+
+   assign sample_o = enable ? held_sample : sample_i;
+   assign strobe_o = enable ? (strobe_i & held) : strobe_i;
+   assign time_o = enable ? held_time : vita_time;
+   assign last_o = enable & ~open;
+
+endmodule // vita_rx_gate
@@ -61,13 +61,18 @@ module vita_rx_tb;
       .set_stb(set_stb), .set_addr(set_addr), .set_data(set_data),
       .vita_time(vita_time), .overrun(overrun),
       .sample_fifo_o(sample_data_o), .sample_fifo_dst_rdy_i(sample_dst_rdy), .sample_fifo_src_rdy_o(sample_src_rdy),
-      .sample(sample), .run(run), .strobe(strobe));
+      .sample(sample), .run(run), .strobe(strobe),
+      .sample_time(vita_time), .sample_last(1'b0));
 
    vita_rx_framer #(.BASE(0), .MAXCHAN(MAXCHAN)) vita_rx_framer
      (.clk(clk), .reset(reset), .clear(0),
       .set_stb(set_stb), .set_addr(set_addr), .set_data(set_data),
       .data_o(data_o), .dst_rdy_i(dst_rdy), .src_rdy_o(src_rdy),
       .sample_fifo_i(sample_data_o), .sample_fifo_dst_rdy_o(sample_dst_rdy), .sample_fifo_src_rdy_i(sample_src_rdy),
+      .vita_time(vita_time), .stats_req(1'b0), .stats_ack(),
+      .stats_overflows(32'd0), .stats_high_water(32'd0), .stats_power(32'd0),
+      .gain_req(1'b0), .gain_ack(),
+      .gain_time(64'd0), .gain_word(32'd0), .gain_power(32'd0),
       .fifo_occupied(), .fifo_full(), .fifo_empty() );
    
    rx_dsp_model rx_dsp_model
@@ -34,6 +34,8 @@ module vita_tx_chain
     output [35:0] err_data_o, output err_src_rdy_o, input err_dst_rdy_i,
     output [31:0] sample, input strobe,
     output underrun, output run, output clear_o,
+    output burst_pending, output [63:0] burst_time, // a timed burst waits for its time
+    output [31:0] counters, // {late, underrun} packets, free running
     output [31:0] debug);
 
    localparam MAXCHAN = 1;
@@ -129,6 +131,8 @@ module vita_tx_chain
       .vita_time(vita_time), .error(error), .ack(ack), .error_code(error_code),
       .sample_fifo_i(tx1_data), .sample_fifo_src_rdy_i(tx1_src_rdy), .sample_fifo_dst_rdy_o(tx1_dst_rdy),
       .sample(sample), .run(run), .strobe(strobe), .packet_consumed(packet_consumed),
+      .burst_pending(burst_pending), .burst_time(burst_time),
+      .counters(counters),
       .debug(debug_vtc) );
 
    wire [35:0] 		flow_data, err_data_int;
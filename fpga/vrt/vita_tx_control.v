@@ -26,6 +26,7 @@ module vita_tx_control
     output error, output ack,
     output reg [31:0] error_code,
     output reg packet_consumed,
+    output [31:0] counters,
     
     // From vita_tx_deframer
     input [5+64+16+WIDTH-1:0] sample_fifo_i,
@@ -37,6 +38,10 @@ module vita_tx_control
     output reg run,
     input strobe,
 
+    // A timed burst waits for its time, ahead of the run
+    output burst_pending,
+    output [63:0] burst_time,
+
     output [31:0] debug
     );
 
@@ -92,6 +97,32 @@ module vita_tx_control
    wire        policy_wait = error_policy[0];
    wire        policy_next_packet = error_policy[1];
    wire        policy_next_burst = error_policy[2];
+   wire        policy_idle_fill = error_policy[3];
+   wire        policy_no_seq_check = error_policy[4]; // looped packets repeat their sequence
+   wire        seq_error = seqnum_err & ~policy_no_seq_check;
+
+   // Late timed packets: 0 follow the policy above, 1 drop up to the end of
+   // the burst, 2 send at once, 3 drop the packet only. Untimed packets of a
+   // burst whose timed start was dropped go out at once. Every late packet
+   // is reported as a time error, also the ones sent.
+   localparam LATE_BY_POLICY = 2'd0;
+   localparam LATE_DROP_BURST = 2'd1;
+   localparam LATE_SEND_NOW = 2'd2;
+   localparam LATE_DROP_PACKET = 2'd3;
+   wire [1:0]  late_policy = error_policy[6:5];
+   reg 	       late_error; // the error state holds a late packet
+
+   // Free running, the host reads both at once and takes differences.
+   // The late count takes every time error, too early packets included.
+   reg [15:0]  late_count, underrun_count;
+   assign counters = {late_count, underrun_count};
+
+   // Idle fill: between bursts the chain keeps running on idle_sample,
+   // a gap after a packet without eob ends the burst quietly
+   wire [31:0] idle_sample;
+   setting_reg #(.my_addr(BASE+6)) sr_idle_sample
+     (.clk(clk),.rst(reset),.strobe(set_stb),.addr(set_addr),
+      .in(set_data),.out(idle_sample),.changed());
    reg 	       send_error, send_ack;
    
    always @(posedge clk)
@@ -101,27 +132,40 @@ module vita_tx_control
 	  send_error <= 0;
 	  send_ack <= 0;
 	  error_code <= 0;
+	  late_error <= 0;
        end
      else
        case(ibs_state)
 	 IBS_IDLE :
-	   if(sample_fifo_src_rdy_i)
-	     if(seqnum_err)
-	       begin
-		  ibs_state <= IBS_ERROR;
-		  error_code <= CODE_SEQ_ERROR;
-		  send_error <= 1;
-	       end
-	     else if(~send_at | now)
-	       ibs_state <= IBS_RUN;
-	     else if((late_qual & late_del) | too_early)
-	       begin
-		  ibs_state <= IBS_ERROR;
-		  error_code <= CODE_TIME_ERROR;
-		  send_error <= 1;
-	       end
+	   begin
+	      late_error <= 0;
+	      if(sample_fifo_src_rdy_i)
+		if(seq_error)
+		  begin
+		     ibs_state <= IBS_ERROR;
+		     error_code <= CODE_SEQ_ERROR;
+		     send_error <= 1;
+		  end
+		else if(~send_at | now)
+		  ibs_state <= IBS_RUN;
+		else if(late_qual & late_del & (late_policy == LATE_SEND_NOW))
+		  begin
+		     ibs_state <= IBS_RUN;
+		     error_code <= CODE_TIME_ERROR;
+		     send_error <= 1;
+		  end
+		else if((late_qual & late_del) | too_early)
+		  begin
+		     ibs_state <= IBS_ERROR;
+		     error_code <= CODE_TIME_ERROR;
+		     send_error <= 1;
+		     late_error <= late_qual & late_del;
+		  end
+	   end
 	 
 	 IBS_RUN :
+	   begin
+	   send_error <= 0; // a late packet sent at once reported on entry
 	   if(strobe)
 	     if(~sample_fifo_src_rdy_i)
 	       begin
@@ -138,9 +182,12 @@ module vita_tx_control
 		 end
 	       else
 		 ibs_state <= IBS_CONT_BURST;
+	   end
 
 	 IBS_CONT_BURST :
-	   if(strobe)
+	   if(strobe & policy_idle_fill)
+	     ibs_state <= IBS_IDLE;
+	   else if(strobe)
 	     begin
 		if(policy_next_packet)
 		  ibs_state <= IBS_ERROR_DONE;
@@ -152,7 +199,7 @@ module vita_tx_control
 		send_error <= 1;
 	     end
 	   else if(sample_fifo_src_rdy_i)
-	     if(seqnum_err)
+	     if(seq_error)
 	       begin
 		  ibs_state <= IBS_ERROR;
 		  error_code <= CODE_SEQ_ERROR_MIDBURST;
@@ -165,7 +212,14 @@ module vita_tx_control
 	   begin
 	      send_error <= 0;
 	      if(sample_fifo_src_rdy_i & eop)
-		if(policy_next_packet | (policy_next_burst & eob))
+		if(late_error & (late_policy == LATE_DROP_PACKET))
+		  ibs_state <= IBS_IDLE;
+		else if(late_error & (late_policy == LATE_DROP_BURST))
+		  begin
+		     if(eob)
+		       ibs_state <= IBS_IDLE;
+		  end
+		else if(policy_next_packet | (policy_next_burst & eob))
 		  ibs_state <= IBS_IDLE;
 		else if(policy_wait)
 		  ibs_state <= IBS_ERROR_WAIT;
@@ -183,6 +237,22 @@ module vita_tx_control
        endcase // case (ibs_state)
 
    
+   // one count per report, the reports of late and underrun packets are single cycle
+   always @(posedge clk)
+     if(reset)
+       begin
+	  late_count <= 0;
+	  underrun_count <= 0;
+       end
+     else if(send_error)
+       if(error_code[15:0] == 16'd8)
+	 late_count <= late_count + 16'd1;
+       else if((error_code[15:0] == 16'd2) | (error_code[15:0] == 16'd16))
+	 underrun_count <= underrun_count + 16'd1;
+
+   assign burst_pending = (ibs_state == IBS_IDLE) & sample_fifo_src_rdy_i & send_at;
+   assign burst_time = send_time;
+
    assign sample_fifo_dst_rdy_o = (ibs_state == IBS_ERROR) | (strobe & (ibs_state == IBS_RUN));  // FIXME also cleanout
 
    //register the output sample
@@ -194,7 +264,10 @@ module vita_tx_control
      else if (~run)
        sample_held <= 0;
      else if (strobe)
-       sample_held <= sample_fifo_i[5+64+16+WIDTH-1:5+64+16];
+       if (policy_idle_fill & (ibs_state != IBS_RUN))
+	 sample_held <= idle_sample;
+       else
+	 sample_held <= sample_fifo_i[5+64+16+WIDTH-1:5+64+16];
 
    assign error = send_error;
    assign ack = send_ack;
@@ -211,7 +284,7 @@ module vita_tx_control
        end
      else 
        if (ibs_state == IBS_RUN)
-	 if(eob & eop & strobe & sample_fifo_src_rdy_i)
+	 if(eob & eop & strobe & sample_fifo_src_rdy_i & ~policy_idle_fill)
 	   run <= 0;
 	 else 
 	   begin
@@ -219,7 +292,9 @@ module vita_tx_control
 	      countdown <= MAX_IDLE;
 	   end
        else
-	 if (countdown == 0)
+	 if (policy_idle_fill)
+	   countdown <= MAX_IDLE; // the idle samples keep it running until a clear
+	 else if (countdown == 0)
 	   run <= 0;
 	 else
 	   countdown <= countdown - 1;
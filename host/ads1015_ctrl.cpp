@@ -29,6 +29,7 @@ using namespace uhd;
 ads1015_ctrl::ads1015_ctrl()
     : _addr(ADS1015_NONE)
     , _config_reg(0)
+    , _config_time(boost::get_system_time())
 {
 
 }
@@ -64,11 +65,20 @@ void ads1015_ctrl::init(i2c_iface::sptr iface, ads1015_addr addr)
 
 void ads1015_ctrl::set_input(ads1015_input input)
 {
-    _config_reg = (_config_reg & ~ADS1015_CONF_MUX_MASK) |
-                  (input << ADS1015_CONF_MUX_OFFS);
+    const unsigned config = (_config_reg & ~ADS1015_CONF_MUX_MASK) |
+                            (input << ADS1015_CONF_MUX_OFFS);
+    // The same mux again would only restart the settling in continuous mode
+    if (config == _config_reg)
+        return;
+    _config_reg = config;
     set_reg(ADS1015_REG_CONFIG, _config_reg);
 }
 
+ads1015_ctrl::ads1015_input ads1015_ctrl::get_input() const
+{
+    return ads1015_input((_config_reg & ADS1015_CONF_MUX_MASK) >> ADS1015_CONF_MUX_OFFS);
+}
+
 void ads1015_ctrl::set_pga(ads1015_pga pga)
 {
     _config_reg = (_config_reg & ~ADS1015_CONF_PGA_MASK) |
@@ -86,11 +96,69 @@ void ads1015_ctrl::set_mode(bool powerdown)
     set_reg(ADS1015_REG_CONFIG, _config_reg);
 }
 
+void ads1015_ctrl::set_rate(ads1015_rate rate)
+{
+    _config_reg = (_config_reg & ~ADS1015_CONF_DR_MASK) |
+                  (rate << ADS1015_CONF_DR_OFFS);
+    set_reg(ADS1015_REG_CONFIG, _config_reg);
+}
+
+boost::posix_time::time_duration ads1015_ctrl::settle_time() const
+{
+    // Conversion period in us per data rate, 3300 SPS for the reserved code
+    static const long period_us[] = {7813, 4000, 2041, 1087, 625, 417, 303, 303};
+
+    const unsigned rate = (_config_reg & ADS1015_CONF_DR_MASK) >> ADS1015_CONF_DR_OFFS;
+    // The conversion in flight and a full one with the new config, with a margin
+    return boost::posix_time::microseconds(period_us[rate] * 2 + 100);
+}
+
+bool ads1015_ctrl::is_settled() const
+{
+    return boost::get_system_time() >= _config_time + settle_time();
+}
+
+uint16_t ads1015_ctrl::read_raw()
+{
+    return get_reg(ADS1015_REG_CONVERSION);
+}
+
+uint16_t ads1015_ctrl::read_settled()
+{
+    const boost::system_time ready = _config_time + settle_time();
+    if (boost::get_system_time() < ready)
+        boost::this_thread::sleep(ready);
+    return read_raw();
+}
+
 double ads1015_ctrl::get_value()
 {
     if (!_iface)
         return nan("");
 
+    if ((_config_reg & ADS1015_CONF_MODE) == ADS1015_CONF_MODE) {
+        // Power-down mode, start conversion
+        set_reg(ADS1015_REG_CONFIG, _config_reg | ADS1015_CONF_OS);
+
+        // Wait for conversion ready
+        unsigned i;
+        for (i = 0; i < ADS1015_POLL_RDY_WATCHDOG; i++) {
+            if (get_reg(ADS1015_REG_CONFIG) & ADS1015_CONF_OS)
+                break;
+        }
+
+        if (i == ADS1015_POLL_RDY_WATCHDOG)
+            return nan("");
+    } else {
+        // Continuous mode, wait for a result of the current input
+        return raw_to_value(read_settled());
+    }
+
+    return raw_to_value(get_reg(ADS1015_REG_CONVERSION));
+}
+
+double ads1015_ctrl::raw_to_value(uint16_t raw) const
+{
     struct coeffs {
         unsigned u;
         unsigned d;
@@ -109,22 +177,6 @@ double ads1015_ctrl::get_value()
     if (pga > 5)
         pga = 5;
 
-    if ((_config_reg & ADS1015_CONF_MODE) == ADS1015_CONF_MODE) {
-        // Power-down mode, start conversion
-        set_reg(ADS1015_REG_CONFIG, _config_reg | ADS1015_CONF_OS);
-
-        // Wait for conversion ready
-        unsigned i;
-        for (i = 0; i < ADS1015_POLL_RDY_WATCHDOG; i++) {
-            if (get_reg(ADS1015_REG_CONFIG) & ADS1015_CONF_OS)
-                break;
-        }
-
-        if (i == ADS1015_POLL_RDY_WATCHDOG)
-            return nan("");
-    }
-
-    uint16_t raw = get_reg(ADS1015_REG_CONVERSION);
     double val = (raw >> 4);
     val = val * gain_cfs[pga].d * 2 / (1000 * gain_cfs[pga].u );
     return  val;
@@ -145,5 +197,7 @@ void ads1015_ctrl::set_reg(ads1015_regs reg, uint16_t value)
 {
     byte_vector_t cmd = boost::assign::list_of((uint8_t)reg)((uint8_t)(value >> 8))((uint8_t)(value & 0xFF));
     _iface->write_i2c(_addr, cmd);
+    if (reg == ADS1015_REG_CONFIG)
+        _config_time = boost::get_system_time();
 }
 
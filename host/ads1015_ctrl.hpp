@@ -89,6 +89,29 @@ public:
 
     double get_value();
     void set_mode(bool powerdown);
+    void set_rate(ads1015_rate rate);
+
+    /** @brief input the mux was last programmed to */
+    ads1015_input get_input() const;
+
+    /**
+     * @brief continuous mode: the conversion register holds a result of the current input
+     *
+     * After a mux change it takes the conversion in flight and one more,
+     * until then the register holds the result of the previous input.
+     */
+    bool is_settled() const;
+
+    /** @brief one read of the conversion register, no conversion started */
+    uint16_t read_raw();
+
+    /** @brief continuous mode: wait until @ref is_settled, then @ref read_raw */
+    uint16_t read_settled();
+
+    /** @brief config register as last programmed, with the mux of the last input */
+    uint16_t get_config() const { return _config_reg; }
+    /** @brief convert a raw conversion register to volts with the current PGA */
+    double raw_to_value(uint16_t raw) const;
 
 private:
     enum ads1015_regs {
@@ -121,9 +144,13 @@ private:
     uint16_t get_reg(ads1015_regs reg);
     void set_reg(ads1015_regs reg, uint16_t value);
 
+    /** @brief time for the conversion register to follow a config change */
+    boost::posix_time::time_duration settle_time() const;
+
     uhd::i2c_iface::sptr   _iface;
     ads1015_addr           _addr;
     unsigned               _config_reg;
+    boost::system_time     _config_time; ///< last config write
 };
 
 
@@ -16,90 +16,244 @@
 //
 
 #include "apply_corrections.hpp"
+#include "fe_cal_table.hpp"
 #include <uhd/usrp/dboard_eeprom.hpp>
 #include <uhd/utils/paths.hpp>
 #include "umtrx_log_adapter.hpp"
-#include <uhd/utils/csv.hpp>
-#include <uhd/types/dict.hpp>
+#include "umtrx_async_log.hpp"
 #include <uhd/version.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
+#include <boost/bind/bind.hpp>
 #include <boost/thread/mutex.hpp>
-#include <cstdio>
+#include <boost/thread/thread.hpp>
+#include <boost/atomic.hpp>
 #include <complex>
-#include <fstream>
+#include <ctime>
+#include <map>
+#include <set>
+
+#ifdef UHD_PLATFORM_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 
 namespace fs = boost::filesystem;
 
 boost::mutex corrections_mutex;
 
 /***********************************************************************
- * Helper routines
+ * FE apply corrections implementation
  **********************************************************************/
-static double linear_interp(double x, double x0, double y0, double x1, double y1){
-    return y0 + (x - x0)*(y1 - y0)/(x1 - x0);
+//! Map the binary table next to the CSV, converting the CSV when it is newer
+static fe_cal_table::sptr load_fe_cal_table(const fs::path &csv_path)
+{
+    fs::path bin_path(csv_path);
+    bin_path.replace_extension(".bin");
+
+    const bool have_csv = fs::exists(csv_path);
+    const bool have_bin = fs::exists(bin_path);
+    if (have_bin and (not have_csv or fs::last_write_time(bin_path) >= fs::last_write_time(csv_path)))
+    {
+        try
+        {
+            return fe_cal_table::make_from_bin(bin_path.string());
+        }
+        catch (const std::exception &ex)
+        {
+            UHD_MSG(warning) << ex.what() << std::endl;
+        }
+    }
+    if (not have_csv) return fe_cal_table::sptr();
+
+    const fe_cal_table::entries_t entries = fe_cal_table::parse_csv(csv_path.string());
+    try
+    {
+        fe_cal_table::store_bin(bin_path.string(), entries);
+        return fe_cal_table::make_from_bin(bin_path.string());
+    }
+    catch (const std::exception &ex)
+    {
+        UHD_MSG(warning) << "Cannot convert " << csv_path.string() << ": " << ex.what() << std::endl;
+    }
+    return fe_cal_table::make_from_entries(entries);
 }
 
 /***********************************************************************
- * FE apply corrections implementation
+ * Calibration table cache with hot reload
  **********************************************************************/
-struct fe_cal_t{
-    double lo_freq;
-    double iq_corr_real;
-    double iq_corr_imag;
-};
+/*!
+ * Tables are loaded on first use and watched afterwards.
+ * When a calibration file changes on disk (inotify wakeup on linux,
+ * a periodic mtime check everywhere) the watcher thread loads the new
+ * table and swaps it in. Lookups only copy the table pointer under the
+ * lock, so tuning never waits for a file to be parsed.
+ */
+class fe_cal_cache_t : boost::noncopyable{
+public:
+    fe_cal_cache_t(void):
+        _stop(false),
+        _inotify_fd(-1)
+    {
+        //NOP
+    }
 
-static bool fe_cal_comp(fe_cal_t a, fe_cal_t b){
-    return (a.lo_freq < b.lo_freq);
-}
+    ~fe_cal_cache_t(void)
+    {
+        _stop = true;
+        if (_thread) _thread->join();
+#ifdef UHD_PLATFORM_LINUX
+        if (_inotify_fd >= 0) ::close(_inotify_fd);
+#endif
+    }
 
-static uhd::dict<std::string, std::vector<fe_cal_t> > fe_cal_cache;
+    //! the table for a CSV path, null when there is no calibration
+    fe_cal_table::sptr get(const fs::path &csv_path)
+    {
+        {
+            boost::mutex::scoped_lock l(_mutex);
+            std::map<std::string, entry_t>::const_iterator it = _entries.find(csv_path.string());
+            if (it != _entries.end()) return it->second.table;
+        }
 
-static bool is_same_freq(const double f1, const double f2)
-{
-    const double epsilon = 0.1;
-    return ((f1 - epsilon) < f2 and (f1 + epsilon) > f2);
-}
+        //one message, the lookup runs in the retune
+        const entry_t entry = load(csv_path);
+        if (not entry.table) {
+            UMTRX_MSG_ASYNC(status) << "Looking for FE correction at: " << csv_path.c_str() << "...  Not found" << std::endl;
+            return fe_cal_table::sptr();
+        }
+        UMTRX_MSG_ASYNC(status) << "Looking for FE correction at: " << csv_path.c_str() << "...  Loaded " << entry.table->size() << " points" << std::endl;
 
-static std::complex<double> get_fe_correction(
-    const std::string &key, const double lo_freq
-){
-    const std::vector<fe_cal_t> &datas = fe_cal_cache[key];
-    if (datas.empty()) throw uhd::runtime_error("empty calibration table " + key);
-
-    //search for lo freq
-    size_t lo_index = 0;
-    size_t hi_index = datas.size()-1;
-    for (size_t i = 0; i < datas.size(); i++){
-        if (is_same_freq(datas[i].lo_freq, lo_freq))
+        boost::mutex::scoped_lock l(_mutex);
+        _entries[csv_path.string()] = entry;
+        this->watch(csv_path.parent_path());
+        if (not _thread) _thread.reset(new boost::thread(boost::bind(&fe_cal_cache_t::watcher_loop, this)));
+        return entry.table;
+    }
+
+private:
+    struct entry_t{
+        fs::path csv_path;
+        std::time_t csv_time, bin_time;
+        fe_cal_table::sptr table;
+    };
+
+    static std::time_t mtime(const fs::path &path)
+    {
+        boost::system::error_code ec;
+        const std::time_t t = fs::last_write_time(path, ec);
+        return ec? std::time_t(-1) : t;
+    }
+
+    static fs::path bin_path(const fs::path &csv_path)
+    {
+        fs::path path(csv_path);
+        return path.replace_extension(".bin");
+    }
+
+    static entry_t load(const fs::path &csv_path)
+    {
+        entry_t entry;
+        entry.csv_path = csv_path;
+        entry.csv_time = mtime(csv_path);
+        entry.table = load_fe_cal_table(csv_path);
+        //the load may convert the CSV, so stat the binary table afterwards
+        entry.bin_time = mtime(bin_path(csv_path));
+        return entry;
+    }
+
+    //! call with the lock held
+    void watch(const fs::path &dir)
+    {
+#ifdef UHD_PLATFORM_LINUX
+        if (_watched_dirs.count(dir.string()) != 0) return;
+        if (_inotify_fd < 0) _inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (_inotify_fd < 0) return; //fall back to the periodic check
+        if (::inotify_add_watch(_inotify_fd, dir.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0)
+        {
+            _watched_dirs.insert(dir.string());
+        }
+#else
+        (void)dir;
+#endif
+    }
+
+    void reload_changed(void)
+    {
+        std::vector<entry_t> entries;
+        {
+            boost::mutex::scoped_lock l(_mutex);
+            for (std::map<std::string, entry_t>::const_iterator it = _entries.begin(); it != _entries.end(); ++it)
+                entries.push_back(it->second);
+        }
+        BOOST_FOREACH(const entry_t &old, entries)
         {
-            hi_index = i;
-            lo_index = i;
-            break;
+            if (mtime(old.csv_path) == old.csv_time and mtime(bin_path(old.csv_path)) == old.bin_time) continue;
+            entry_t entry;
+            try
+            {
+                entry = load(old.csv_path);
+            }
+            catch (const std::exception &ex)
+            {
+                UHD_MSG(warning) << "Cannot reload FE correction " << old.csv_path.string() << ": " << ex.what() << std::endl;
+                continue;
+            }
+            //a removed file keeps the last good table
+            if (not entry.table) entry.table = old.table;
+            else UHD_MSG(status) << "Reloaded FE correction " << old.csv_path.string() << std::endl;
+            boost::mutex::scoped_lock l(_mutex);
+            _entries[old.csv_path.string()] = entry;
         }
-        if (datas[i].lo_freq > lo_freq){
-            hi_index = i;
-            break;
+    }
+
+    void watcher_loop(void)
+    {
+        static const int CHECK_PERIOD_MS = 1000;
+        while (not _stop)
+        {
+            bool waited = false;
+#ifdef UHD_PLATFORM_LINUX
+            if (_inotify_fd >= 0)
+            {
+                pollfd pfd;
+                pfd.fd = _inotify_fd;
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                if (::poll(&pfd, 1, CHECK_PERIOD_MS) > 0)
+                {
+                    char events[4096];
+                    while (::read(_inotify_fd, events, sizeof(events)) > 0){}
+                }
+                waited = true;
+            }
+#endif
+            if (not waited) boost::this_thread::sleep(boost::posix_time::milliseconds(CHECK_PERIOD_MS));
+            if (not _stop) this->reload_changed();
         }
-        lo_index = i;
     }
 
-    if (lo_index == 0) return std::complex<double>(datas[lo_index].iq_corr_real, datas[lo_index].iq_corr_imag);
-    if (hi_index == lo_index) return std::complex<double>(datas[hi_index].iq_corr_real, datas[hi_index].iq_corr_imag);
+    boost::atomic<bool> _stop;
+    boost::mutex _mutex;
+    std::map<std::string, entry_t> _entries;
+    std::set<std::string> _watched_dirs;
+    int _inotify_fd;
+    boost::shared_ptr<boost::thread> _thread;
+};
 
-    //interpolation time
-    return std::complex<double>(
-        linear_interp(lo_freq, datas[lo_index].lo_freq, datas[lo_index].iq_corr_real, datas[hi_index].lo_freq, datas[hi_index].iq_corr_real),
-        linear_interp(lo_freq, datas[lo_index].lo_freq, datas[lo_index].iq_corr_imag, datas[hi_index].lo_freq, datas[hi_index].iq_corr_imag)
-    );
+static fe_cal_cache_t &get_fe_cal_cache(void)
+{
+    static fe_cal_cache_t cache;
+    return cache;
 }
 
-static void apply_fe_corrections(
+//! the calibration table for a dboard, null when there is none
+static fe_cal_table::sptr get_fe_cal_table(
     uhd::property_tree::sptr sub_tree,
     const uhd::fs_path &db_path,
-    const uhd::fs_path &fe_path,
-    const std::string &file_prefix,
-    const double lo_freq
+    const std::string &file_prefix
 ){
     //extract eeprom serial
     const uhd::usrp::dboard_eeprom_t db_eeprom = sub_tree->access<uhd::usrp::dboard_eeprom_t>(db_path).get();
@@ -112,47 +266,24 @@ static void apply_fe_corrections(
 #else
     const fs::path cal_data_path = fs::path(uhd::get_app_path()) / ".uhd" / "cal" / (file_prefix + db_eeprom.serial + ".csv");
 #endif
-    UHD_MSG(status) << "Looking for FE correction at: " << cal_data_path.c_str() << "...  ";
-    if (not fs::exists(cal_data_path)) {
-        UHD_MSG(status) << "Not found" << std::endl;
-        return;
-    }
-
-    UHD_MSG(status) << "Found, loading...  ";
 
-    //parse csv file or get from cache
-    if (not fe_cal_cache.has_key(cal_data_path.string())){
-        std::ifstream cal_data(cal_data_path.string().c_str());
-        const uhd::csv::rows_type rows = uhd::csv::to_rows(cal_data);
+    //tables are loaded once, later tunes only do the lookup
+    return get_fe_cal_cache().get(cal_data_path);
+}
 
-        bool read_data = false, skip_next = false;;
-        std::vector<fe_cal_t> datas;
-        BOOST_FOREACH(const uhd::csv::row_type &row, rows){
-            if (not read_data and not row.empty() and row[0] == "DATA STARTS HERE"){
-                read_data = true;
-                skip_next = true;
-                continue;
-            }
-            if (not read_data) continue;
-            if (skip_next){
-                skip_next = false;
-                continue;
-            }
-            fe_cal_t data;
-            std::sscanf(row[0].c_str(), "%lf" , &data.lo_freq);
-            std::sscanf(row[1].c_str(), "%lf" , &data.iq_corr_real);
-            std::sscanf(row[2].c_str(), "%lf" , &data.iq_corr_imag);
-            datas.push_back(data);
-        }
-        std::sort(datas.begin(), datas.end(), fe_cal_comp);
-        fe_cal_cache[cal_data_path.string()] = datas;
-        UHD_MSG(status) << "Loaded" << std::endl;
-    } else {
-        UHD_MSG(status) << "Loaded from cache" << std::endl;
-    }
+static void apply_fe_corrections(
+    uhd::property_tree::sptr sub_tree,
+    const uhd::fs_path &db_path,
+    const uhd::fs_path &fe_path,
+    const std::string &file_prefix,
+    const double lo_freq,
+    const double temperature
+){
+    const fe_cal_table::sptr table = get_fe_cal_table(sub_tree, db_path, file_prefix);
+    if (not table) return;
 
     sub_tree->access<std::complex<double> >(fe_path)
-        .set(get_fe_correction(cal_data_path.string(), lo_freq));
+        .set(table->get_correction(lo_freq, temperature));
 }
 
 /***********************************************************************
@@ -161,7 +292,8 @@ static void apply_fe_corrections(
 void uhd::usrp::apply_tx_fe_corrections(
     property_tree::sptr sub_tree, //starts at mboards/x
     const std::string &slot, //name of dboard slot
-    const double lo_freq //actual lo freq
+    const double lo_freq, //actual lo freq
+    const double temperature //degC, NaN when unknown
 ){
     boost::mutex::scoped_lock l(corrections_mutex);
     try{
@@ -170,25 +302,28 @@ void uhd::usrp::apply_tx_fe_corrections(
             "dboards/" + slot + "/tx_eeprom",
             "tx_frontends/" + slot + "/iq_balance/value",
             "tx_iq_cal_v0.2_",
-            lo_freq
+            lo_freq,
+            temperature
         );
         apply_fe_corrections(
             sub_tree,
             "dboards/" + slot + "/tx_eeprom",
             "tx_frontends/" + slot + "/dc_offset/value",
             "tx_dc_cal_v0.2_",
-            lo_freq
+            lo_freq,
+            temperature
         );
     }
     catch(const std::exception &e){
-        UHD_MSG(error) << "Failure in apply_tx_fe_corrections: " << e.what() << std::endl;
+        UMTRX_MSG_ASYNC(error) << "Failure in apply_tx_fe_corrections: " << e.what() << std::endl;
     }
 }
 
 void uhd::usrp::apply_rx_fe_corrections(
     property_tree::sptr sub_tree, //starts at mboards/x
     const std::string &slot, //name of dboard slot
-    const double lo_freq //actual lo freq
+    const double lo_freq, //actual lo freq
+    const double temperature //degC, NaN when unknown
 ){
     boost::mutex::scoped_lock l(corrections_mutex);
     try{
@@ -197,10 +332,43 @@ void uhd::usrp::apply_rx_fe_corrections(
             "dboards/" + slot + "/rx_eeprom",
             "rx_frontends/" + slot + "/iq_balance/value",
             "rx_iq_cal_v0.2_",
-            lo_freq
+            lo_freq,
+            temperature
         );
     }
     catch(const std::exception &e){
-        UHD_MSG(error) << "Failure in apply_rx_fe_corrections: " << e.what() << std::endl;
+        UMTRX_MSG_ASYNC(error) << "Failure in apply_rx_fe_corrections: " << e.what() << std::endl;
     }
 }
+
+uhd::usrp::fe_corrections_t uhd::usrp::get_tx_fe_corrections(
+    property_tree::sptr sub_tree, //starts at mboards/x
+    const std::string &slot, //name of dboard slot
+    const double lo_freq, //lo freq
+    const double temperature //degC, NaN when unknown
+){
+    boost::mutex::scoped_lock l(corrections_mutex);
+    fe_corrections_t corr;
+    const fe_cal_table::sptr iq_table = get_fe_cal_table(sub_tree, "dboards/" + slot + "/tx_eeprom", "tx_iq_cal_v0.2_");
+    corr.has_iq_balance = bool(iq_table);
+    if (iq_table) corr.iq_balance = iq_table->get_correction(lo_freq, temperature);
+    const fe_cal_table::sptr dc_table = get_fe_cal_table(sub_tree, "dboards/" + slot + "/tx_eeprom", "tx_dc_cal_v0.2_");
+    corr.has_dc_offset = bool(dc_table);
+    if (dc_table) corr.dc_offset = dc_table->get_correction(lo_freq, temperature);
+    return corr;
+}
+
+uhd::usrp::fe_corrections_t uhd::usrp::get_rx_fe_corrections(
+    property_tree::sptr sub_tree, //starts at mboards/x
+    const std::string &slot, //name of dboard slot
+    const double lo_freq, //lo freq
+    const double temperature //degC, NaN when unknown
+){
+    boost::mutex::scoped_lock l(corrections_mutex);
+    fe_corrections_t corr;
+    const fe_cal_table::sptr iq_table = get_fe_cal_table(sub_tree, "dboards/" + slot + "/rx_eeprom", "rx_iq_cal_v0.2_");
+    corr.has_iq_balance = bool(iq_table);
+    if (iq_table) corr.iq_balance = iq_table->get_correction(lo_freq, temperature);
+    corr.has_dc_offset = false;
+    return corr;
+}
@@ -20,6 +20,7 @@
 
 #include <uhd/config.hpp>
 #include <uhd/property_tree.hpp>
+#include <complex>
 #include <string>
 
 namespace uhd{ namespace usrp{
@@ -27,13 +28,38 @@ namespace uhd{ namespace usrp{
     void apply_tx_fe_corrections(
         property_tree::sptr sub_tree, //starts at mboards/x
         const std::string &slot, //name of dboard slot
-        const double tx_lo_freq //actual lo freq
+        const double tx_lo_freq, //actual lo freq
+        const double temperature //degC of the board side, NaN when unknown
     );
 
     void apply_rx_fe_corrections(
         property_tree::sptr sub_tree, //starts at mboards/x
         const std::string &slot, //name of dboard slot
-        const double rx_lo_freq //actual lo freq
+        const double rx_lo_freq, //actual lo freq
+        const double temperature //degC of the board side, NaN when unknown
+    );
+
+    //! calibrated corrections for one LO, as the apply routines would set them
+    struct fe_corrections_t{
+        fe_corrections_t(void): has_iq_balance(false), has_dc_offset(false){}
+        bool has_iq_balance;
+        std::complex<double> iq_balance;
+        bool has_dc_offset;
+        std::complex<double> dc_offset;
+    };
+
+    fe_corrections_t get_tx_fe_corrections(
+        property_tree::sptr sub_tree, //starts at mboards/x
+        const std::string &slot, //name of dboard slot
+        const double tx_lo_freq, //lo freq
+        const double temperature //degC of the board side, NaN when unknown
+    );
+
+    fe_corrections_t get_rx_fe_corrections(
+        property_tree::sptr sub_tree, //starts at mboards/x
+        const std::string &slot, //name of dboard slot
+        const double rx_lo_freq, //lo freq
+        const double temperature //degC of the board side, NaN when unknown
     );
 
 }} //namespace uhd::usrp
@@ -0,0 +1,77 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "dsp_hop_table.hpp"
+#include <uhd/exception.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/format.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <boost/math/special_functions/sign.hpp>
+#include <cmath>
+
+#define REG_HOP_CTRL     base + 0
+#define REG_HOP_PERIOD   base + 4
+#define REG_HOP_TIME     base + 8
+#define REG_HOP_FREQ     base + 12
+
+#define FLAG_HOP_ARM     (1ul << 31)
+#define FLAG_HOP_LOOP    (1ul << 30)
+
+const size_t dsp_hop_table_t::MAX_ENTRIES;
+
+//the FPGA compares the low 32 bits of the vita time
+static const boost::int64_t MAX_HOP_TICKS = boost::int64_t(1) << 31;
+
+//same word as set_freq in the dsp cores
+static boost::uint32_t freq_to_word(const double freq_, const double tick_rate)
+{
+    double freq = std::fmod(freq_, tick_rate);
+    if (std::abs(freq) > tick_rate/2.0)
+        freq -= boost::math::sign(freq)*tick_rate;
+    static const double scale_factor = std::pow(2.0, 32);
+    return boost::uint32_t(boost::int32_t(boost::math::round((freq / tick_rate) * scale_factor)));
+}
+
+void dsp_hop_table_load(uhd::wb_iface::sptr iface, const size_t base,
+    const dsp_hop_table_t &table, const double tick_rate, const double vita_rate)
+{
+    //disarming also empties the table
+    iface->poke32(REG_HOP_CTRL, 0);
+    if (table.entries.empty()) return;
+
+    if (table.entries.size() > dsp_hop_table_t::MAX_ENTRIES) throw uhd::value_error(str(boost::format(
+        "hop table: %u entries, the FPGA holds %u") % table.entries.size() % dsp_hop_table_t::MAX_ENTRIES));
+    if (table.loop and table.period <= 0.0) throw uhd::value_error("hop table: looping needs a period");
+
+    const boost::int64_t period = boost::math::llround(table.period*vita_rate);
+    if (period < 0 or period >= MAX_HOP_TICKS) throw uhd::value_error("hop table: period out of range");
+    iface->poke32(REG_HOP_PERIOD, boost::uint32_t(period));
+
+    boost::int64_t prev = table.entries.front().first.to_ticks(vita_rate);
+    for (size_t i = 0; i < table.entries.size(); i++)
+    {
+        const boost::int64_t ticks = table.entries[i].first.to_ticks(vita_rate);
+        if (period == 0 and (ticks < prev or ticks - prev >= MAX_HOP_TICKS)) throw uhd::value_error(str(boost::format(
+            "hop table: entry %u is not within 2^31 ticks after the previous one") % i));
+        prev = ticks;
+        iface->poke32(REG_HOP_TIME, boost::uint32_t(ticks));
+        iface->poke32(REG_HOP_FREQ, freq_to_word(table.entries[i].second, tick_rate));
+    }
+
+    //the count field wraps to zero for a full table
+    iface->poke32(REG_HOP_CTRL, FLAG_HOP_ARM | (table.loop? FLAG_HOP_LOOP : 0) | boost::uint32_t(table.entries.size() % dsp_hop_table_t::MAX_ENTRIES));
+}
@@ -0,0 +1,55 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_DSP_HOP_TABLE_HPP
+#define INCLUDED_DSP_HOP_TABLE_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/types/wb_iface.hpp>
+#include <utility>
+#include <vector>
+
+/*!
+ * Timed CORDIC frequency hops for a DSP core (FPGA 9.9+).
+ * The FPGA steps the phase increment at each entry time, or every
+ * period after the first entry when the period is set, without any
+ * control traffic per hop.
+ */
+struct dsp_hop_table_t
+{
+    typedef std::pair<uhd::time_spec_t, double> entry_t; //time, dsp frequency in Hz
+
+    static const size_t MAX_ENTRIES = 64;
+
+    std::vector<entry_t> entries; //empty stops hopping
+    double period; //seconds between hops, zero uses the entry times
+    bool loop; //start over after the last entry, needs a period
+
+    dsp_hop_table_t(void): period(0.0), loop(false) {}
+};
+
+/*!
+ * Load and arm the hop table of one DSP core.
+ * \param base byte address of the hop table control register
+ * \param tick_rate rate of the CORDIC, for the phase increments
+ * \param vita_rate rate of the vita time, for the entry times
+ */
+void dsp_hop_table_load(uhd::wb_iface::sptr iface, const size_t base,
+    const dsp_hop_table_t &table, const double tick_rate, const double vita_rate);
+
+#endif /* INCLUDED_DSP_HOP_TABLE_HPP */
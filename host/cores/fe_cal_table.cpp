@@ -0,0 +1,271 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "fe_cal_table.hpp"
+#include <uhd/exception.hpp>
+#include <uhd/utils/csv.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace ipc = boost::interprocess;
+
+static const char FE_CAL_MAGIC[8] = {'U', 'M', 'T', 'R', 'X', 'C', 'A', 'L'};
+static const boost::uint32_t FE_CAL_VERSION = 2; //1 had no temperature
+
+struct fe_cal_header_t{
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t num_entries;
+};
+
+/***********************************************************************
+ * Helper routines
+ **********************************************************************/
+static double linear_interp(double x, double x0, double y0, double x1, double y1){
+    return y0 + (x - x0)*(y1 - y0)/(x1 - x0);
+}
+
+static bool fe_cal_comp(const fe_cal_table::entry_t &a, const fe_cal_table::entry_t &b){
+    return (a.lo_freq < b.lo_freq);
+}
+
+//! entries without a temperature sort first
+static double temperature_key(const fe_cal_table::entry_t &e){
+    return boost::math::isnan(e.temperature)? -std::numeric_limits<double>::infinity() : e.temperature;
+}
+
+static bool fe_cal_layer_comp(const fe_cal_table::entry_t &a, const fe_cal_table::entry_t &b){
+    const double ta = temperature_key(a), tb = temperature_key(b);
+    if (ta != tb) return ta < tb;
+    return fe_cal_comp(a, b);
+}
+
+static bool is_same_freq(const double f1, const double f2)
+{
+    const double epsilon = 0.1;
+    return ((f1 - epsilon) < f2 and (f1 + epsilon) > f2);
+}
+
+/***********************************************************************
+ * Table implementation over a sorted range of entries
+ **********************************************************************/
+class fe_cal_table_impl : public fe_cal_table{
+public:
+    //! keep the entries in memory
+    fe_cal_table_impl(const entries_t &entries):
+        _storage(entries)
+    {
+        std::sort(_storage.begin(), _storage.end(), fe_cal_layer_comp);
+        _entries = _storage.empty()? NULL : &_storage.front();
+        _num_entries = _storage.size();
+        this->init_layers();
+    }
+
+    //! map the entries from a binary table file
+    fe_cal_table_impl(const std::string &path)
+    {
+        ipc::file_mapping file(path.c_str(), ipc::read_only);
+        _region.reset(new ipc::mapped_region(file, ipc::read_only));
+
+        const size_t size = _region->get_size();
+        if (size < sizeof(fe_cal_header_t)) throw uhd::runtime_error("truncated calibration table " + path);
+        const fe_cal_header_t *hdr = static_cast<const fe_cal_header_t *>(_region->get_address());
+        if (std::memcmp(hdr->magic, FE_CAL_MAGIC, sizeof(FE_CAL_MAGIC)) != 0 or hdr->version != FE_CAL_VERSION)
+        {
+            throw uhd::runtime_error("not a calibration table " + path);
+        }
+        if (size != sizeof(fe_cal_header_t) + hdr->num_entries*sizeof(entry_t))
+        {
+            throw uhd::runtime_error("truncated calibration table " + path);
+        }
+        _entries = reinterpret_cast<const entry_t *>(hdr + 1);
+        _num_entries = hdr->num_entries;
+        this->init_layers();
+    }
+
+    std::complex<double> get_correction(const double lo_freq, const double temperature) const
+    {
+        if (_layers.empty()) throw uhd::runtime_error("empty calibration table");
+        if (_layers.size() == 1) return this->get_layer_correction(_layers.front(), lo_freq);
+
+        //the layers right below and above, clamp outside of the calibrated temperatures
+        const double t = boost::math::isnan(temperature)?
+            (_layers.front().temperature + _layers.back().temperature)/2 : temperature;
+        size_t hi = 0;
+        while (hi < _layers.size() and _layers[hi].temperature < t) hi++;
+        if (hi == _layers.size()) return this->get_layer_correction(_layers.back(), lo_freq);
+        if (hi == 0 or _layers[hi].temperature == t) return this->get_layer_correction(_layers[hi], lo_freq);
+
+        const layer_t &lo = _layers[hi-1];
+        const std::complex<double> c0 = this->get_layer_correction(lo, lo_freq);
+        const std::complex<double> c1 = this->get_layer_correction(_layers[hi], lo_freq);
+        return std::complex<double>(
+            linear_interp(t, lo.temperature, c0.real(), _layers[hi].temperature, c1.real()),
+            linear_interp(t, lo.temperature, c0.imag(), _layers[hi].temperature, c1.imag())
+        );
+    }
+
+    size_t size(void) const
+    {
+        return _num_entries;
+    }
+
+private:
+    //! the entries of one temperature
+    struct layer_t{
+        double temperature;
+        const entry_t *begin, *end;
+    };
+
+    void init_layers(void)
+    {
+        for (size_t i = 0; i < _num_entries; i++)
+        {
+            if (i == 0 or temperature_key(_entries[i]) != temperature_key(_entries[i-1]))
+            {
+                layer_t layer;
+                layer.temperature = _entries[i].temperature;
+                layer.begin = _entries + i;
+                _layers.push_back(layer);
+            }
+            _layers.back().end = _entries + i + 1;
+        }
+
+        //entries without a temperature are dropped once some have one
+        if (_layers.size() > 1 and boost::math::isnan(_layers.front().temperature)) _layers.erase(_layers.begin());
+    }
+
+    std::complex<double> get_layer_correction(const layer_t &layer, const double lo_freq) const
+    {
+        const entry_t *begin = layer.begin;
+        const entry_t *end = layer.end;
+
+        //first entry not below the LO, clamp outside of the table
+        entry_t key; key.lo_freq = lo_freq;
+        const entry_t *hi = std::lower_bound(begin, end, key, fe_cal_comp);
+        if (hi == end) return corr(end[-1]);
+        if (hi == begin or is_same_freq(hi->lo_freq, lo_freq)) return corr(*hi);
+        const entry_t *lo = hi - 1;
+        if (is_same_freq(lo->lo_freq, lo_freq)) return corr(*lo);
+
+        //interpolation time
+        return std::complex<double>(
+            linear_interp(lo_freq, lo->lo_freq, lo->corr_real, hi->lo_freq, hi->corr_real),
+            linear_interp(lo_freq, lo->lo_freq, lo->corr_imag, hi->lo_freq, hi->corr_imag)
+        );
+    }
+
+    static std::complex<double> corr(const entry_t &e)
+    {
+        return std::complex<double>(e.corr_real, e.corr_imag);
+    }
+
+    entries_t _storage;
+    boost::shared_ptr<ipc::mapped_region> _region;
+    const entry_t *_entries;
+    size_t _num_entries;
+    std::vector<layer_t> _layers; //by temperature
+};
+
+/***********************************************************************
+ * Factories, CSV parsing and binary store
+ **********************************************************************/
+fe_cal_table::sptr fe_cal_table::make_from_bin(const std::string &path)
+{
+    try
+    {
+        return sptr(new fe_cal_table_impl(path));
+    }
+    catch (const ipc::interprocess_exception &ex)
+    {
+        throw uhd::runtime_error("cannot map calibration table " + path + ": " + ex.what());
+    }
+}
+
+fe_cal_table::sptr fe_cal_table::make_from_entries(const entries_t &entries)
+{
+    return sptr(new fe_cal_table_impl(entries));
+}
+
+fe_cal_table::entries_t fe_cal_table::parse_csv(const std::string &path)
+{
+    std::ifstream cal_data(path.c_str());
+    const uhd::csv::rows_type rows = uhd::csv::to_rows(cal_data);
+
+    bool read_data = false, read_columns = false;
+    size_t temperature_column = 0; //none
+    entries_t entries;
+    BOOST_FOREACH(const uhd::csv::row_type &row, rows){
+        if (not read_data and not row.empty() and row[0] == "DATA STARTS HERE"){
+            read_data = true;
+            read_columns = true;
+            continue;
+        }
+        if (not read_data) continue;
+        if (read_columns){
+            //the column names, older files have no temperature
+            read_columns = false;
+            for (size_t i = 3; i < row.size(); i++){
+                if (boost::algorithm::trim_copy(row[i]) == "temperature") temperature_column = i;
+            }
+            continue;
+        }
+        if (row.size() < 3) continue;
+        entry_t entry;
+        std::sscanf(row[0].c_str(), "%lf" , &entry.lo_freq);
+        std::sscanf(row[1].c_str(), "%lf" , &entry.corr_real);
+        std::sscanf(row[2].c_str(), "%lf" , &entry.corr_imag);
+        entry.temperature = std::numeric_limits<double>::quiet_NaN();
+        if (temperature_column != 0 and temperature_column < row.size()){
+            std::sscanf(row[temperature_column].c_str(), "%lf" , &entry.temperature);
+        }
+        entries.push_back(entry);
+    }
+    std::sort(entries.begin(), entries.end(), fe_cal_layer_comp);
+    return entries;
+}
+
+void fe_cal_table::store_bin(const std::string &path, const entries_t &entries)
+{
+    entries_t sorted(entries);
+    std::sort(sorted.begin(), sorted.end(), fe_cal_layer_comp);
+
+    fe_cal_header_t hdr;
+    std::memcpy(hdr.magic, FE_CAL_MAGIC, sizeof(FE_CAL_MAGIC));
+    hdr.version = FE_CAL_VERSION;
+    hdr.num_entries = boost::uint32_t(sorted.size());
+
+    //a reader mapping the old file keeps its pages, new readers see the new file
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+        if (not sorted.empty()) out.write(reinterpret_cast<const char *>(&sorted.front()), sorted.size()*sizeof(entry_t));
+        if (not out) throw uhd::runtime_error("cannot write calibration table " + tmp_path);
+    }
+    boost::filesystem::rename(tmp_path, path);
+}
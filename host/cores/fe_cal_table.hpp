@@ -0,0 +1,79 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_FE_CAL_TABLE_HPP
+#define INCLUDED_FE_CAL_TABLE_HPP
+
+#include <uhd/config.hpp>
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+#include <complex>
+#include <string>
+#include <vector>
+
+/*!
+ * A frontend correction table (DC offset or IQ balance versus LO frequency
+ * and board temperature).
+ *
+ * Entries of one temperature form a layer, a calibration run writes one.
+ * A lookup interpolates by LO within the layers right below and above the
+ * temperature, then by temperature between the two. Entries without a
+ * temperature (NaN, tables from before) only count when no entry has one.
+ *
+ * The binary form is a 16 byte header (magic "UMTRXCAL", format version,
+ * number of entries) followed by entries sorted by temperature then LO,
+ * in host byte order. It is memory mapped, so lookups are a binary search
+ * over the file pages.
+ */
+class fe_cal_table : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<fe_cal_table> sptr;
+
+    struct entry_t{
+        double lo_freq;
+        double temperature; //degC, NaN when not known
+        double corr_real;
+        double corr_imag;
+    };
+    typedef std::vector<entry_t> entries_t;
+
+    virtual ~fe_cal_table(void) {}
+
+    //! map a binary table, throws if the file is not a valid table
+    static sptr make_from_bin(const std::string &path);
+
+    //! make a table held in memory, entries do not need to be sorted
+    static sptr make_from_entries(const entries_t &entries);
+
+    //! parse a CSV written by the calibration utilities
+    static entries_t parse_csv(const std::string &path);
+
+    //! write entries as a binary table, written aside and renamed into place
+    static void store_bin(const std::string &path, const entries_t &entries);
+
+    /*!
+     * The correction for an LO at a temperature, interpolated between the
+     * nearest entries and clamped outside of the table.
+     * A NaN temperature takes the middle of the calibrated temperatures.
+     */
+    virtual std::complex<double> get_correction(const double lo_freq, const double temperature) const = 0;
+
+    //! number of entries in the table
+    virtual size_t size(void) const = 0;
+};
+
+#endif /* INCLUDED_FE_CAL_TABLE_HPP */
@@ -16,22 +16,32 @@
 //
 
 #include "rx_dsp_core_200.hpp"
+#include "umtrx_fifo_ctrl.hpp"
 #include <uhd/types/dict.hpp>
 #include <uhd/exception.hpp>
 #include "umtrx_log_adapter.hpp"
 #include <uhd/utils/safe_call.hpp>
 #include <uhd/utils/algorithm.hpp>
 #include <boost/assign/list_of.hpp>
-#include <boost/thread/thread.hpp> //thread sleep
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
 #include <boost/math/special_functions/round.hpp>
 #include <boost/math/special_functions/sign.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <algorithm>
 #include <cmath>
+#include <functional>
+#include <limits>
 
 #define REG_DSP_RX_FREQ       _dsp_base + 0
 #define REG_DSP_RX_SCALE_IQ   _dsp_base + 4
 #define REG_DSP_RX_DECIM      _dsp_base + 8
 #define REG_DSP_RX_MUX        _dsp_base + 12
+#define REG_DSP_RX_FRAC       _dsp_base + 16
+#define REG_DSP_RX_HOP        _dsp_base + 20 //4 regs
+#define REG_DSP_RX_STATS      _dsp_base + 36
+
+#define FLAG_DSP_RX_FRAC_ENB      (1 << 31)
 
 #define FLAG_DSP_RX_MUX_SWAP_IQ   (1 << 0)
 #define FLAG_DSP_RX_MUX_REAL_MODE (1 << 1)
@@ -40,16 +50,77 @@
 #define REG_RX_CTRL_TIME_HI        _ctrl_base + 4
 #define REG_RX_CTRL_TIME_LO        _ctrl_base + 8
 #define REG_RX_CTRL_FORMAT         _ctrl_base + 12
+#define FLAG_CTRL_FORMAT_LE        (1 << 1)
 #define REG_RX_CTRL_VRT_HDR        _ctrl_base + 16
 #define REG_RX_CTRL_VRT_SID        _ctrl_base + 20
 #define REG_RX_CTRL_VRT_TLR        _ctrl_base + 24
 #define REG_RX_CTRL_NSAMPS_PP      _ctrl_base + 28
 #define REG_RX_CTRL_NCHANNELS      _ctrl_base + 32
+#define REG_RX_CTRL_POWER_AVG      _ctrl_base + 36
+
+#define REG_RX_GATE_WINDOW         _gate_base + 0
+#define REG_RX_GATE_MASK           _gate_base + 4
+#define REG_RX_GATE_NUM            _gate_base + 8
+#define REG_RX_GATE_START          _gate_base + 12
+
+#define REG_RX_FIR_NUM             _fir_base + 0
+#define REG_RX_FIR_TAP             _fir_base + 4
+
+#define REG_RX_TONE_PHASE_INC      _tone_base + 0
+#define REG_RX_TONE_CTRL           _tone_base + 4 //[5] enable, [4:0] log2 length
+
+#define FLAG_RX_TONE_VALID        (1u << 31)
+
+//clocks of the filter per sample besides one per tap
+static const size_t FIR_OVERHEAD_CLOCKS = 4;
+
+//taps of the CIC droop compensation, odd for linear phase
+static const size_t CIC_COMP_MAX_TAPS = 21;
+
+const size_t rx_dsp_gate_t::MAX_WINDOWS;
+const size_t rx_dsp_core_200::MAX_FILTER_TAPS;
+
+//decimation fields of the first and the second CIC
+static const size_t MAX_CIC_RATE = 128;
+static const size_t MAX_CIC2_RATE = 8;
 
 template <class T> T ceil_log2(T num){
     return std::ceil(std::log(num)/std::log(T(2)));
 }
 
+/*!
+ * Inverse of the 4 stage CIC response over the passband, at the output
+ * rate of a CIC decimating by cic_decim, by frequency sampling with a
+ * Hamming window. Above 0.4 of the output rate, where the CIC output is
+ * mostly alias, the taps roll off instead. Unity gain at DC.
+ */
+static std::vector<double> cic_droop_taps(const size_t cic_decim, const size_t num_taps)
+{
+    const double R = double(cic_decim);
+    const size_t M = (num_taps - 1)/2;
+    std::vector<double> amp(M + 1, 0.0);
+    for (size_t k = 0; k <= M; k++)
+    {
+        const double f = double(k)/num_taps; //cycles per output sample
+        if (f > 0.4) continue;
+        const double h = (k == 0)? 1.0 : std::sin(M_PI*f)/(R*std::sin(M_PI*f/R));
+        amp[k] = std::min(1.0/std::pow(h, 4), 4.0);
+    }
+
+    std::vector<double> taps(num_taps);
+    double sum = 0.0;
+    for (size_t n = 0; n < num_taps; n++)
+    {
+        double h = amp[0];
+        for (size_t k = 1; k <= M; k++) h += 2*amp[k]*std::cos(2*M_PI*k*(double(n) - M)/num_taps);
+        const double window = 0.54 - 0.46*std::cos(2*M_PI*n/(num_taps - 1));
+        taps[n] = window*h/num_taps;
+        sum += taps[n];
+    }
+    for (size_t n = 0; n < num_taps; n++) taps[n] /= sum;
+    return taps;
+}
+
 using namespace uhd;
 
 class rx_dsp_core_200_impl : public rx_dsp_core_200{
@@ -57,12 +128,29 @@ public:
     rx_dsp_core_200_impl(
         wb_iface::sptr iface,
         const size_t dsp_base, const size_t ctrl_base,
-        const boost::uint32_t sid, const bool lingering_packet
+        const boost::uint32_t sid, const bool lingering_packet, const size_t gate_base, const size_t fir_base,
+        const size_t tone_base
     ):
-        _iface(iface), _dsp_base(dsp_base), _ctrl_base(ctrl_base),  _sid(sid), _initialized(true)
+        _iface(iface), _dsp_base(dsp_base), _ctrl_base(ctrl_base), _gate_base(gate_base), _fir_base(fir_base), _tone_base(tone_base),
+        _fifo_ctrl(UMTRX_UHD_PTR_NAMESPACE::dynamic_pointer_cast<umtrx_fifo_ctrl>(iface)),
+        _sid(sid), _initialized(true)
     {
         // previously uninitialized - assuming zero for all
         _tick_rate = _link_rate = _host_extra_scaling = _fxpt_scalar_correction = 0.0;
+        _host_rate = 0.0;
+        _wire_bytes = 4; //sc16
+        _frac_resampler = false;
+        _cic2 = false;
+        _low_latency = false;
+        _cic_rate = _cic2_rate = 1;
+        _hb0 = _hb1 = 0;
+        _fir_num_taps = 0;
+        _snapshot = false;
+        _stats_period = -1.0; //not in this FPGA
+        _fir_clocks = 0.0;
+        _cic_comp_decim = 0;
+        _tone_freq = 0.0;
+        _tone_length = 0;
         _vita_rate = _tick_rate;
 
         //init to something so update method has reasonable defaults
@@ -70,15 +158,14 @@ public:
         _dsp_extra_scaling = 1.0;
 
         //This is a hack/fix for the lingering packet problem.
-        //The caller should also flush the recv transports
+        //The caller should also flush the recv transports,
+        //and clears the chain once the lingering pkt propagated
         if (lingering_packet){
             stream_cmd_t stream_cmd(stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE);
             stream_cmd.num_samps = 1;
             issue_stream_command(stream_cmd);
-            boost::this_thread::sleep(boost::posix_time::milliseconds(10)); //lets lingering pkt propagate
         }
-
-        this->clear();
+        else this->clear();
         _initialized = false;
     }
 
@@ -139,10 +226,29 @@ public:
         cmd_word |= (inst_samps)? stream_cmd.num_samps : ((inst_stop)? 0 : 1);
 
         //issue the stream command
-        _iface->poke32(REG_RX_CTRL_STREAM_CMD, cmd_word);
         const boost::uint64_t ticks = (stream_cmd.stream_now)? 0 : stream_cmd.time_spec.to_ticks(_vita_rate);
-        _iface->poke32(REG_RX_CTRL_TIME_HI, boost::uint32_t(ticks >> 32));
-        _iface->poke32(REG_RX_CTRL_TIME_LO, boost::uint32_t(ticks >> 0)); //latches the command
+        this->poke_stream_command(cmd_word, ticks);
+    }
+
+    void issue_stream_windows(const std::vector<rx_dsp_window_t> &windows){
+        if (not _initialized)
+        {
+            UHD_MSG(error) << "issue_stream_windows called on uninitialized rx_dsp_core" << std::endl;
+            return;
+        }
+        BOOST_FOREACH(const rx_dsp_window_t &window, windows)
+        {
+            UHD_ASSERT_THROW(window.num_samps > 0 and window.num_samps <= 0x0fffffff);
+        }
+        _continuous_streaming = false;
+
+        //one packet per fifo ctrl window of commands instead of a round trip each
+        boost::scoped_ptr<umtrx_fifo_ctrl_batch> batch;
+        if (_fifo_ctrl) batch.reset(new umtrx_fifo_ctrl_batch(_fifo_ctrl));
+        BOOST_FOREACH(const rx_dsp_window_t &window, windows)
+        {
+            this->poke_stream_command(boost::uint32_t(window.num_samps), window.time.to_ticks(_vita_rate));
+        }
     }
 
     void set_mux(const std::string &mode, const bool fe_swapped){
@@ -157,6 +263,7 @@ public:
 
     void set_tick_rate(const double rate){
         _tick_rate = rate;
+        this->update_decim_table();
     }
 
     void set_vita_rate(const double rate){
@@ -166,40 +273,120 @@ public:
     void set_link_rate(const double rate){
         //_link_rate = rate/sizeof(boost::uint32_t); //in samps/s
         _link_rate = rate/sizeof(boost::uint16_t); //in samps/s (allows for 8sc)
+        this->update_decim_table();
     }
 
-    uhd::meta_range_t get_host_rates(void){
-        meta_range_t range;
-        for (int rate = 512; rate > 256; rate -= 4){
-            range.push_back(range_t(_tick_rate/rate));
-        }
-        for (int rate = 256; rate > 128; rate -= 2){
-            range.push_back(range_t(_tick_rate/rate));
+    void set_power_averaging(const size_t num_samps){
+        size_t shift = 0;
+        while (shift < 15 and (size_t(1) << shift) < num_samps) shift++;
+        _iface->poke32(REG_RX_CTRL_POWER_AVG, shift);
+    }
+
+    void set_stats_period(const double seconds){
+        _stats_period = seconds;
+    }
+
+    void set_frac_resampler(const bool enb){
+        _frac_resampler = enb;
+        if (not enb) _iface->poke32(REG_DSP_RX_FRAC, 0);
+    }
+
+    void set_cic2(const bool enb){
+        _cic2 = enb;
+        this->update_decim_table();
+    }
+
+    void set_low_latency(const bool enb){
+        _low_latency = enb;
+    }
+
+    double get_group_delay(void){
+        if (_tick_rate <= 0.0) return 0.0;
+        //a 4 stage CIC delays 2 of its input samples per decimation step,
+        //the halfbands are 7 and 31 tap FIRs
+        const double cic_ticks = 2.0*(_cic_rate - 1) + 2.0*(_cic2_rate - 1)*_cic_rate;
+        const double hb_in_ticks = double(_cic_rate*_cic2_rate);
+        const double hb_ticks = (_hb1? 3*hb_in_ticks : 0.0) + (_hb0? 15*hb_in_ticks*(_hb1? 2 : 1) : 0.0);
+        const double fir_delay = (_fir_num_taps > 1 and _host_rate > 0.0)? (_fir_num_taps - 1)/2/_host_rate : 0.0;
+        return (cic_ticks + hb_ticks)/_tick_rate + fir_delay;
+    }
+
+    //! the rate of the second CIC for a CIC decimation, 1 when the first takes it all, 0 when none fits
+    size_t cic2_rate(const size_t cic_decim) const{
+        for (size_t rate2 = 1; rate2 <= (_cic2? MAX_CIC2_RATE : 1); rate2++){
+            if (cic_decim % rate2 == 0 and cic_decim/rate2 <= MAX_CIC_RATE) return rate2;
         }
-        for (int rate = 128; rate >= int(std::ceil(_tick_rate/_link_rate)); rate -= 1){
-            range.push_back(range_t(_tick_rate/rate));
+        return 0;
+    }
+
+    uhd::meta_range_t get_host_rates(void){
+        if (_frac_resampler){
+            return meta_range_t(_tick_rate/this->max_decim(), _tick_rate/std::ceil(_tick_rate/_link_rate));
         }
-        return range;
+        return this->get_decim_rates();
+    }
+
+    size_t max_decim(void) const{
+        return 4*MAX_CIC_RATE*(_cic2? MAX_CIC2_RATE : 1);
+    }
+
+    uhd::meta_range_t get_decim_rates(void){
+        return _decim_rates;
     }
 
     double set_host_rate(const double rate){
-        const size_t decim_rate = boost::math::iround(_tick_rate/this->get_host_rates().clip(rate, true));
+        //with the fractional decimator: the next even integer decimation above the rate
+        //(a halfband stays enabled), the fractional stage takes the remaining ratio in [1, 2)
+        double frac_step = 1.0;
+        boost::uint32_t frac_word = 0;
+        double decim_target = double(_decims[this->nearest_decim_index(rate)]);
+        if (_frac_resampler){
+            const double target = this->get_host_rates().clip(rate);
+            decim_target = 0.0;
+            for (size_t i = this->lower_decim_index(target*(1 - 1e-12)); i < _decims.size(); i++){
+                if (decim_target == 0.0) decim_target = double(_decims[i]);
+                if (_decims[i] % 2 == 0){
+                    decim_target = double(_decims[i]);
+                    break;
+                }
+            }
+            frac_word = boost::uint32_t(std::min(boost::math::llround((_tick_rate/target/decim_target - 1.0)*(1u << 31)), 0x7fffffffLL));
+            frac_step = 1.0 + double(frac_word)/(1u << 31);
+            _iface->poke32(REG_DSP_RX_FRAC, (frac_word == 0)? 0 : (FLAG_DSP_RX_FRAC_ENB | frac_word));
+        }
+        const size_t decim_rate = boost::math::iround(decim_target);
         size_t decim = decim_rate;
 
-        //determine which half-band filters are activated
+        //determine which half-band filters are activated,
+        //the low latency mode leaves them off while the CICs take the decimation
+        const bool cic_only = _low_latency and cic2_rate(decim) != 0;
         int hb0 = 0, hb1 = 0;
-        if (decim % 2 == 0){
+        if (decim % 2 == 0 and not cic_only){
             hb0 = 1;
             decim /= 2;
         }
-        if (decim % 2 == 0){
+        if (decim % 2 == 0 and not cic_only){
             hb1 = 1;
             decim /= 2;
         }
 
-        _iface->poke32(REG_DSP_RX_DECIM, (hb1 << 9) | (hb0 << 8) | (decim & 0xff));
+        //the second CIC takes what the first can not
+        const size_t cic2 = cic2_rate(decim);
+        UHD_ASSERT_THROW(cic2 != 0);
+        decim /= cic2;
+
+        _iface->poke32(REG_DSP_RX_DECIM, ((cic2 - 1) << 10) | (hb1 << 9) | (hb0 << 8) | (decim & 0xff));
+        _cic_rate = decim;
+        _cic2_rate = cic2;
+        _hb0 = hb0;
+        _hb1 = hb1;
 
-        if (decim > 1 and hb0 == 0 and hb1 == 0)
+        //the channel filter makes up for the CIC rolloff when no halfband is on
+        _fir_clocks = decim_rate*frac_step;
+        _cic_comp_decim = (decim > 1 and hb0 == 0 and hb1 == 0)? decim*cic2 : 0; //two CICs droop about as one
+        const bool cic_comp = this->update_filter();
+
+        if (decim > 1 and hb0 == 0 and hb1 == 0 and not cic_comp and not cic_only)
         {
             UHD_MSG(warning) << boost::format(
                 "The requested decimation is odd; the user should expect CIC rolloff.\n"
@@ -209,12 +396,19 @@ public:
         }
 
         // Calculate CIC decimation (i.e., without halfband decimators)
-        // Calculate closest multiplier constant to reverse gain absent scale multipliers
+        // Calculate closest multiplier constant to reverse gain absent scale multipliers,
+        // each CIC shifts out the next power of two above its own gain
         const double rate_pow = std::pow(double(decim & 0xff), 4);
-        _scaling_adjustment = std::pow(2, ceil_log2(rate_pow))/(1.65*rate_pow);
+        const double rate2_pow = std::pow(double(cic2), 4);
+        _scaling_adjustment = std::pow(2, ceil_log2(rate_pow))*std::pow(2, ceil_log2(rate2_pow))/(1.65*rate_pow*rate2_pow);
         this->update_scalar();
 
-        return _tick_rate/decim_rate;
+        _host_rate = _tick_rate/(decim_rate*frac_step);
+        this->check_link_rate();
+
+        //the bin of the tone meter is relative to the host rate
+        if (_tone_base != 0 and _tone_freq != 0.0) this->set_tone_freq(_tone_freq);
+        return _host_rate;
     }
 
     void update_scalar(void){
@@ -248,10 +442,82 @@ public:
         return actual_freq;
     }
 
+    void set_hop_table(const dsp_hop_table_t &table){
+        dsp_hop_table_load(_iface, REG_DSP_RX_HOP, table, _tick_rate, _vita_rate);
+    }
+
     uhd::meta_range_t get_freq_range(void){
         return uhd::meta_range_t(-_tick_rate/2, +_tick_rate/2, _tick_rate/std::pow(2.0, 32));
     }
 
+    void set_gate(const rx_dsp_gate_t &gate){
+        if (_gate_base == 0) throw uhd::not_implemented_error("RX gate: not in this FPGA");
+
+        //a zero window turns the gate off, it also stops the old pattern
+        _iface->poke32(REG_RX_GATE_WINDOW, 0);
+        if (gate.window <= 0.0) return;
+
+        if (gate.num_windows == 0 or gate.num_windows > rx_dsp_gate_t::MAX_WINDOWS) throw uhd::value_error(str(boost::format(
+            "RX gate: %u windows, the FPGA takes 1 to %u") % gate.num_windows % rx_dsp_gate_t::MAX_WINDOWS));
+        const boost::int64_t window = boost::math::llround(gate.window*_vita_rate);
+        if (window <= 0 or window >= (boost::int64_t(1) << 31)) throw uhd::value_error("RX gate: window out of range");
+
+        _iface->poke32(REG_RX_GATE_MASK, gate.mask);
+        _iface->poke32(REG_RX_GATE_NUM, boost::uint32_t(gate.num_windows % rx_dsp_gate_t::MAX_WINDOWS));
+        _iface->poke32(REG_RX_GATE_WINDOW, boost::uint32_t(window));
+        _iface->poke32(REG_RX_GATE_START, boost::uint32_t(gate.start.to_ticks(_vita_rate))); //arms
+    }
+
+    double set_tone_freq(const double freq){
+        if (_tone_base == 0) throw uhd::not_implemented_error("RX tone meter: not in this FPGA");
+
+        //the NCO turns the bin down to DC, the sign is as for the DDC
+        const boost::int32_t phase_inc = boost::int32_t(boost::math::llround(-freq/_host_rate*std::pow(2.0, 32)));
+        _iface->poke32(REG_RX_TONE_PHASE_INC, boost::uint32_t(phase_inc));
+        _tone_freq = -phase_inc/std::pow(2.0, 32)*_host_rate;
+        return _tone_freq;
+    }
+
+    size_t set_tone_length(const size_t num_samps){
+        if (_tone_base == 0) throw uhd::not_implemented_error("RX tone meter: not in this FPGA");
+
+        if (num_samps == 0){
+            _iface->poke32(REG_RX_TONE_CTRL, 0);
+            _tone_length = 0;
+            return 0;
+        }
+        size_t len_shift = 0;
+        while (len_shift < 20 and (size_t(1) << len_shift) < num_samps) len_shift++;
+        _iface->poke32(REG_RX_TONE_CTRL, (1 << 5) | boost::uint32_t(len_shift));
+        _tone_length = size_t(1) << len_shift;
+        return _tone_length;
+    }
+
+    double tone_result_to_db(const boost::uint32_t result){
+        if ((result & FLAG_RX_TONE_VALID) == 0) return std::numeric_limits<double>::quiet_NaN();
+
+        //the result is in squared sc16 units with the CORDIC gain of 1.647/2 squared in it,
+        //the stream scaling takes it to the fc32 level of the tone
+        const double power = double(result & ~FLAG_RX_TONE_VALID);
+        const double cordic_gain = 1.646760258/2;
+        return 10*std::log10(std::max(power, 1e-3))
+            - 20*std::log10(cordic_gain)
+            + 20*std::log10(this->get_scaling_adjustment());
+    }
+
+    void set_filter(const std::vector<double> &taps){
+        if (_fir_base == 0 and not taps.empty()) throw uhd::not_implemented_error("RX filter: not in this FPGA");
+        for (size_t i = 0; i < taps.size(); i++)
+        {
+            if (std::abs(taps[i]) > 2.0) throw uhd::value_error(str(boost::format(
+                "RX filter: tap %u is %f, the taps must be within +-2.0") % i % taps[i]));
+        }
+        if (taps.size() > MAX_FILTER_TAPS) throw uhd::value_error(str(boost::format(
+            "RX filter: %u taps, the FPGA holds %u") % taps.size() % MAX_FILTER_TAPS));
+        _filter_taps = taps;
+        this->update_filter();
+    }
+
     void handle_overflow(void){
         if (_continuous_streaming) issue_stream_command(stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
     }
@@ -262,35 +528,152 @@ public:
         unsigned format_word = 0;
         if (stream_args.otw_format == "sc16"){
             format_word = 0;
+            _wire_bytes = 4;
             _dsp_extra_scaling = 1.0;
             _host_extra_scaling = 1.0;
         }
         else if (stream_args.otw_format == "sc8"){
             format_word = (1 << 0);
+            _wire_bytes = 2;
             double peak = stream_args.args.cast<double>("peak", 1.0);
             peak = std::max(peak, 1.0/256);
             _host_extra_scaling = peak*256;
             _dsp_extra_scaling = peak*256;
         }
+        else if (stream_args.otw_format == "bfp8"){
+            //sc8 mantissas of the full scale sc16, one exponent per packet
+            format_word = (1 << 0) | (1 << 2);
+            _wire_bytes = 2;
+            _dsp_extra_scaling = 1.0;
+            _host_extra_scaling = 1.0;
+        }
         else throw uhd::value_error("USRP RX cannot handle requested wire format: " + stream_args.otw_format);
 
         _host_extra_scaling *= stream_args.args.cast<double>("fullscale", 1.0);
 
         this->update_scalar();
+        _snapshot = stream_args.args.cast<int>("snapshot", 0) != 0;
+        this->check_link_rate();
 
+        //little-endian words for the data packets, the streamer resolved otw_endian
+        if (stream_args.args.get("otw_endian", "be") == "le") format_word |= FLAG_CTRL_FORMAT_LE;
         _iface->poke32(REG_RX_CTRL_FORMAT, format_word);
+
+        //statistics packets, in vita ticks between them
+        if (_stats_period >= 0.0){
+            const double period = stream_args.args.cast<double>("stats_period", _stats_period);
+            _iface->poke32(REG_DSP_RX_STATS, boost::uint32_t(std::min(std::max(period, 0.0)*_vita_rate, 4294967295.0)));
+        }
     }
 
 private:
+    //! Rebuild the decimation table, once per tick rate, link rate or CIC change
+    void update_decim_table(void){
+        _decims.clear();
+        _decim_rates = meta_range_t();
+        if (_tick_rate <= 0.0 or _link_rate <= 0.0) return;
+
+        //past 512 both halfbands stay on and the CICs split the rest
+        for (size_t rate = this->max_decim(); rate > 512; rate -= 4){
+            if (cic2_rate(rate/4) != 0) _decims.push_back(rate);
+        }
+        for (size_t rate = 512; rate > 256; rate -= 4) _decims.push_back(rate);
+        for (size_t rate = 256; rate > 128; rate -= 2) _decims.push_back(rate);
+        const size_t min_decim = size_t(std::max(1.0, std::ceil(_tick_rate/_link_rate)));
+        for (size_t rate = 128; rate >= min_decim; rate -= 1) _decims.push_back(rate);
+        BOOST_FOREACH(const size_t decim, _decims) _decim_rates.push_back(range_t(_tick_rate/decim));
+    }
+
+    //! Index of the first decimation with a rate at or above the given one, the rates go up with the index
+    size_t lower_decim_index(const double rate) const{
+        return std::lower_bound(_decims.begin(), _decims.end(), _tick_rate/rate, std::greater<double>()) - _decims.begin();
+    }
+
+    //! Index of the decimation with the rate nearest to the given one
+    size_t nearest_decim_index(const double rate) const{
+        UHD_ASSERT_THROW(not _decims.empty());
+        const size_t i = this->lower_decim_index(rate);
+        if (i == 0) return 0;
+        if (i == _decims.size()) return i - 1;
+        return (_tick_rate/_decims[i] - rate < rate - _tick_rate/_decims[i-1])? i : i - 1;
+    }
+
+    void poke_stream_command(const boost::uint32_t cmd_word, const boost::uint64_t ticks){
+        _iface->poke32(REG_RX_CTRL_STREAM_CMD, cmd_word);
+        _iface->poke32(REG_RX_CTRL_TIME_HI, boost::uint32_t(ticks >> 32));
+        _iface->poke32(REG_RX_CTRL_TIME_LO, boost::uint32_t(ticks >> 0)); //latches the command
+    }
+
+    //! Load the user taps, else the CIC compensation, \return true when that is on
+    bool update_filter(void){
+        if (_fir_base == 0) return false;
+
+        const size_t max_taps = (_fir_clocks > FIR_OVERHEAD_CLOCKS)?
+            std::min(MAX_FILTER_TAPS, size_t(_fir_clocks) - FIR_OVERHEAD_CLOCKS) : 0;
+        std::vector<double> taps = _filter_taps;
+        bool cic_comp = false;
+        if (taps.empty() and _cic_comp_decim > 1)
+        {
+            const size_t num_taps = (std::min(max_taps, CIC_COMP_MAX_TAPS) - 1) | 1;
+            if (max_taps >= 3) taps = cic_droop_taps(_cic_comp_decim, num_taps);
+            cic_comp = not taps.empty();
+        }
+        if (taps.size() > max_taps)
+        {
+            UHD_MSG(warning) << boost::format(
+                "RX filter: %u taps do not fit the %u clocks per sample at %f MHz, the filter is bypassed.\n"
+            ) % taps.size() % size_t(_fir_clocks) % (_host_rate/1e6) << std::endl;
+            taps.clear();
+        }
+
+        //load while bypassed, the count write restarts the load and applies the taps
+        _iface->poke32(REG_RX_FIR_NUM, 0);
+        _fir_num_taps = taps.size();
+        if (taps.empty()) return false;
+        for (size_t i = 0; i < taps.size(); i++)
+        {
+            const boost::int32_t tap = boost::int32_t(std::max(-131072.0, std::min(131071.0, boost::math::round(taps[i]*65536))));
+            _iface->poke32(REG_RX_FIR_TAP, boost::uint32_t(tap) & 0x3ffff);
+        }
+        _iface->poke32(REG_RX_FIR_NUM, boost::uint32_t(taps.size()));
+        return cic_comp;
+    }
+
+    //the host rates are bounded by the sc8 link rate, sc16 only fits half of them
+    void check_link_rate(void){
+        if (_snapshot or _link_rate <= 0.0 or _host_rate*_wire_bytes <= _link_rate*sizeof(boost::uint16_t)) return;
+        UHD_MSG(warning) << boost::format(
+            "RX rate %.3f Msps exceeds the link capacity for %s over the wire.\n"
+            "Use otw_format=sc8 or a lower rate to avoid overflows.") % (_host_rate/1e6) % ((_wire_bytes == 2)? "sc8" : "sc16") << std::endl;
+    }
+
     wb_iface::sptr _iface;
-    const size_t _dsp_base, _ctrl_base;
+    const size_t _dsp_base, _ctrl_base, _gate_base, _fir_base, _tone_base;
+    const umtrx_fifo_ctrl::sptr _fifo_ctrl; //null when iface is not a fifo ctrl
     double _tick_rate, _vita_rate, _link_rate;
     bool _continuous_streaming;
     double _scaling_adjustment, _dsp_extra_scaling, _host_extra_scaling, _fxpt_scalar_correction;
+    double _host_rate;
+    size_t _wire_bytes; //bytes per sample of the otw format
+    bool _frac_resampler;
+    bool _cic2;
+    std::vector<size_t> _decims; //valid decimations, descending so the rates go up
+    meta_range_t _decim_rates; //the rates of _decims
+    bool _low_latency;
+    size_t _cic_rate, _cic2_rate; //of the current decimation
+    int _hb0, _hb1;
+    size_t _fir_num_taps; //loaded in the channel filter
+    bool _snapshot; //bursts buffered by the SRAM, above the link rate
+    double _stats_period; //seconds, negative without statistics packets
+    std::vector<double> _filter_taps; //from the host, empty for the automatic filter
+    double _fir_clocks; //per sample at the filter
+    size_t _cic_comp_decim; //CIC decimation to compensate, zero when a halfband is on
+    double _tone_freq; //Hz of the host rate
+    size_t _tone_length; //samples, zero when stopped
     const boost::uint32_t _sid;
     bool _initialized;
 };
 
-rx_dsp_core_200::sptr rx_dsp_core_200::make(wb_iface::sptr iface, const size_t dsp_base, const size_t ctrl_base, const boost::uint32_t sid, const bool lingering_packet){
-    return sptr(new rx_dsp_core_200_impl(iface, dsp_base, ctrl_base, sid, lingering_packet));
+rx_dsp_core_200::sptr rx_dsp_core_200::make(wb_iface::sptr iface, const size_t dsp_base, const size_t ctrl_base, const boost::uint32_t sid, const bool lingering_packet, const size_t gate_base, const size_t fir_base, const size_t tone_base){
+    return sptr(new rx_dsp_core_200_impl(iface, dsp_base, ctrl_base, sid, lingering_packet, gate_base, fir_base, tone_base));
 }
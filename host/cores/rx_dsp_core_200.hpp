@@ -25,24 +25,78 @@
 #include <boost/shared_ptr.hpp>
 #include <uhd/types/stream_cmd.hpp>
 #include <uhd/types/wb_iface.hpp>
+#include "dsp_hop_table.hpp"
+#include <uhd/types/time_spec.hpp>
+#include <boost/cstdint.hpp>
 #include <string>
+#include <vector>
+
+/*!
+ * Repeating TDMA timeslot gate for an RX DSP core (FPGA 9.19+).
+ * The period is num_windows windows of window seconds from start, only
+ * the windows set in mask are framed and sent, each run of open windows
+ * as one burst with its own time. Once set, a continuous stream command
+ * streams gated, the pattern keeps running across stream restarts.
+ */
+struct rx_dsp_gate_t
+{
+    static const size_t MAX_WINDOWS = 32;
+
+    double window; //seconds, zero streams every sample
+    size_t num_windows; //per period, up to MAX_WINDOWS
+    boost::uint32_t mask; //bit n opens window n
+    uhd::time_spec_t start; //start of window 0, less than 2^31 ticks ahead
+
+    rx_dsp_gate_t(void): window(0.0), num_windows(8), mask(0xff) {}
+};
+
+/*!
+ * One timed capture window for rx_dsp_core_200::issue_stream_windows().
+ * The DSP waits for the time of each window, so windows need a gap of
+ * a few clocks between them: back to back captures are one longer window.
+ */
+struct rx_dsp_window_t
+{
+    uhd::time_spec_t time; //of the first sample
+    size_t num_samps; //up to 2^28-1
+
+    rx_dsp_window_t(const uhd::time_spec_t &time = uhd::time_spec_t(0.0), const size_t num_samps = 0):
+        time(time), num_samps(num_samps) {}
+};
 
 class rx_dsp_core_200 : boost::noncopyable{
 public:
     typedef boost::shared_ptr<rx_dsp_core_200> sptr;
 
+    /*!
+     * With lingering_packet a one sample burst pushes out the packet the last
+     * session left in the chain. The chain is then not cleared: the caller
+     * waits for the burst to leave, ex: for several chains at once, and calls clear().
+     */
     static sptr make(
         uhd::wb_iface::sptr iface,
         const size_t dsp_base, const size_t ctrl_base,
-        const boost::uint32_t sid, const bool lingering_packet = false
+        const boost::uint32_t sid, const bool lingering_packet = false,
+        const size_t gate_base = 0, const size_t fir_base = 0,
+        const size_t tone_base = 0
     );
 
+    //! Taps the channel filter holds (FPGA 9.20+)
+    static const size_t MAX_FILTER_TAPS = 64;
+
     virtual void clear(void) = 0;
 
     virtual void set_nsamps_per_packet(const size_t nsamps) = 0;
 
     virtual void issue_stream_command(const uhd::stream_cmd_t &stream_cmd) = 0;
 
+    /*!
+     * Queue timed capture windows, each a num samps and done command, in one
+     * batch of the fifo ctrl. The stream command queue drops what does not
+     * fit: the caller checks the free lines first.
+     */
+    virtual void issue_stream_windows(const std::vector<rx_dsp_window_t> &windows) = 0;
+
     virtual void set_mux(const std::string &mode, const bool fe_swapped = false) = 0;
 
     virtual void set_tick_rate(const double rate) = 0;
@@ -51,6 +105,28 @@ public:
 
     virtual void set_link_rate(const double rate) = 0;
 
+    //! Average the power readback over num_samps samples, rounded up to a power of two (FPGA 9.7+)
+    virtual void set_power_averaging(const size_t num_samps) = 0;
+
+    //! Send statistics context packets every seconds while streaming, zero for none (FPGA 9.10+)
+    virtual void set_stats_period(const double seconds) = 0;
+
+    //! Use the fractional decimator (FPGA 9.6+) for rates between the integer decimations
+    virtual void set_frac_resampler(const bool enb) = 0;
+
+    //! The second CIC (FPGA 9.29+) decimates up to 8 more, for rates down to 1/4096 of the tick rate
+    virtual void set_cic2(const bool enb) = 0;
+
+    /*!
+     * Leave the halfbands off where the CICs can take the decimation alone,
+     * the channel filter makes up for the CIC droop. Takes effect on the
+     * next set_host_rate.
+     */
+    virtual void set_low_latency(const bool enb) = 0;
+
+    //! Group delay of the DDC at the current rate in seconds, the fractional stage not counted
+    virtual double get_group_delay(void) = 0;
+
     virtual double set_host_rate(const double rate) = 0;
 
     virtual uhd::meta_range_t get_host_rates(void) = 0;
@@ -61,6 +137,37 @@ public:
 
     virtual double set_freq(const double freq) = 0;
 
+    //! Load timed CORDIC hops (FPGA 9.9+), an empty table stops hopping
+    virtual void set_hop_table(const dsp_hop_table_t &table) = 0;
+
+    /*!
+     * Load the channel filter after the decimators, needs a fir_base.
+     * The taps run at the host rate, newest sample first, within +-2.0.
+     * Each output takes a clock per tap, so low decimations fit fewer.
+     * Empty taps leave the filter to the CIC droop compensation when no
+     * halfband is on, and bypass it otherwise.
+     */
+    virtual void set_filter(const std::vector<double> &taps) = 0;
+
+    //! Gate the stream to a repeating pattern of timeslots, needs a gate_base
+    virtual void set_gate(const rx_dsp_gate_t &gate) = 0;
+
+    /*!
+     * Bin of the tone meter in Hz of the host rate, needs a tone_base.
+     * The new bin restarts the measurement. \return the actual bin
+     */
+    virtual double set_tone_freq(const double freq) = 0;
+
+    /*!
+     * Run the tone meter over num_samps samples, rounded up to a power of two
+     * up to 2^20, zero stops it. It keeps the DDC running without streaming
+     * and restarts the measurement. \return the actual length
+     */
+    virtual size_t set_tone_length(const size_t num_samps) = 0;
+
+    //! Tone level in dB of a full scale sample from a tone meter result, NaN before the first
+    virtual double tone_result_to_db(const boost::uint32_t result) = 0;
+
     virtual void handle_overflow(void) = 0;
 
     virtual void setup(const uhd::stream_args_t &stream_args) = 0;
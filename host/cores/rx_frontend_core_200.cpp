@@ -16,7 +16,10 @@
 //
 
 #include "rx_frontend_core_200.hpp"
+#include <uhd/exception.hpp>
 #include <boost/math/special_functions/round.hpp>
+#include <algorithm>
+#include <cmath>
 
 using namespace uhd;
 
@@ -30,6 +33,9 @@ using namespace uhd;
 #define OFFSET_SET   (1ul << 30)
 #define FLAG_MASK (OFFSET_FIXED | OFFSET_SET)
 
+//integrator headroom of rx_dcoffset, the longest time constant is 2^20 samples
+static const int DC_TRACK_MAX_SHIFT = 20;
+
 static boost::uint32_t fs_to_bits(const double num, const size_t bits){
     return boost::int32_t(boost::math::round(num * (1 << (bits-1))));
 }
@@ -37,8 +43,8 @@ static boost::uint32_t fs_to_bits(const double num, const size_t bits){
 
 class rx_frontend_core_200_impl : public rx_frontend_core_200{
 public:
-    rx_frontend_core_200_impl(wb_iface::sptr iface, const size_t base):
-        _i_dc_off(0), _q_dc_off(0), _iface(iface), _base(base)
+    rx_frontend_core_200_impl(wb_iface::sptr iface, const size_t base, const size_t dc_track_addr):
+        _i_dc_off(0), _q_dc_off(0), _iface(iface), _base(base), _dc_track_addr(dc_track_addr), _tick_rate(1.0), _dc_time_constant(0.0)
     {
         //NOP
     }
@@ -66,6 +72,21 @@ public:
         _iface->poke32(REG_RX_FE_OFFSET_Q, flags | (_q_dc_off & ~FLAG_MASK));
     }
 
+    void set_tick_rate(const double rate){
+        _tick_rate = rate;
+        //the time constant is kept in samples by the FPGA, follow the new rate
+        if (_dc_time_constant > 0.0) this->set_dc_offset_time_constant(_dc_time_constant);
+    }
+
+    double set_dc_offset_time_constant(const double seconds){
+        if (_dc_track_addr == 0) throw uhd::not_implemented_error("rx frontend: no dc tracking time constant in this FPGA");
+        _dc_time_constant = seconds;
+        const double samps = std::max(seconds*_tick_rate, 1.0);
+        const int shift = std::min(std::max(boost::math::iround(std::log(samps)/std::log(2.0)), 0), DC_TRACK_MAX_SHIFT);
+        _iface->poke32(_dc_track_addr, shift);
+        return std::ldexp(1.0, shift)/_tick_rate;
+    }
+
     void set_iq_balance(const std::complex<double> &cor){
         _iface->poke32(REG_RX_FE_MAG_CORRECTION, fs_to_bits(cor.real(), 18));
         _iface->poke32(REG_RX_FE_PHASE_CORRECTION, fs_to_bits(cor.imag(), 18));
@@ -75,8 +96,11 @@ private:
     boost::int32_t _i_dc_off, _q_dc_off;
     wb_iface::sptr _iface;
     const size_t _base;
+    const size_t _dc_track_addr;
+    double _tick_rate;
+    double _dc_time_constant; //requested, zero when left at the FPGA default
 };
 
-rx_frontend_core_200::sptr rx_frontend_core_200::make(wb_iface::sptr iface, const size_t base){
-    return sptr(new rx_frontend_core_200_impl(iface, base));
+rx_frontend_core_200::sptr rx_frontend_core_200::make(wb_iface::sptr iface, const size_t base, const size_t dc_track_addr){
+    return sptr(new rx_frontend_core_200_impl(iface, base, dc_track_addr));
 }
@@ -29,7 +29,11 @@ class rx_frontend_core_200 : boost::noncopyable{
 public:
     typedef boost::shared_ptr<rx_frontend_core_200> sptr;
 
-    static sptr make(uhd::wb_iface::sptr iface, const size_t base);
+    /*!
+     * \param base frontend settings base
+     * \param dc_track_addr dc tracking time constant register, zero without one
+     */
+    static sptr make(uhd::wb_iface::sptr iface, const size_t base, const size_t dc_track_addr = 0);
 
     virtual void set_mux(const bool swap) = 0;
 
@@ -37,6 +41,11 @@ public:
 
     virtual std::complex<double> set_dc_offset(const std::complex<double> &off) = 0;
 
+    virtual void set_tick_rate(const double rate) = 0;
+
+    //! Set the dc tracking time constant in seconds, returns the actual one
+    virtual double set_dc_offset_time_constant(const double seconds) = 0;
+
     virtual void set_iq_balance(const std::complex<double> &cor) = 0;
 
 };
@@ -0,0 +1,157 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_STREAM_STATS_HPP
+#define INCLUDED_STREAM_STATS_HPP
+
+#include <uhd/config.hpp>
+#include <boost/atomic.hpp>
+#include <boost/chrono.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+/*!
+ * Latency histogram with power of two buckets.
+ * Bucket i counts durations below 2^(i+6) ns (64ns up to 34ms),
+ * the last bucket counts everything longer.
+ */
+struct latency_histogram_t : boost::noncopyable
+{
+    static const size_t NUM_BUCKETS = 20;
+    static const size_t MIN_SHIFT = 6;
+
+    latency_histogram_t(void): sum_ns(0)
+    {
+        for (size_t i = 0; i < NUM_BUCKETS; i++) buckets[i] = 0;
+    }
+
+    UHD_INLINE void record(const boost::uint64_t ns)
+    {
+        size_t i = 0;
+        for (boost::uint64_t v = ns >> MIN_SHIFT; v != 0 and i < NUM_BUCKETS-1; v >>= 1) i++;
+        buckets[i].fetch_add(1, boost::memory_order_relaxed);
+        sum_ns.fetch_add(ns, boost::memory_order_relaxed);
+    }
+
+    //! upper bound of a bucket in seconds, the last one is unbounded
+    static double bucket_bound(const size_t i)
+    {
+        return double(boost::uint64_t(1) << (i + MIN_SHIFT))/1e9;
+    }
+
+    boost::atomic<boost::uint64_t> buckets[NUM_BUCKETS];
+    boost::atomic<boost::uint64_t> sum_ns;
+};
+
+/*!
+ * Cumulative counters of one streaming channel.
+ * The streaming threads add with relaxed atomics so the fast path never
+ * blocks, the status server reads them at any time. The counters outlive
+ * the streamers and only ever grow, as a metrics scraper expects.
+ */
+struct stream_stats_t : boost::noncopyable
+{
+    typedef boost::shared_ptr<stream_stats_t> sptr;
+    typedef boost::atomic<boost::uint64_t> counter_type;
+    typedef boost::chrono::steady_clock clock_type;
+
+    stream_stats_t(void):
+        packets(0), bytes(0), seq_errors(0), alignment_failures(0),
+        overflows(0), underflows(0), late_packets(0), filled_samples(0), discarded_packets(0), restarts(0), restart_gap_samples(0), convert_ns(0),
+        stats_packets(0), device_overflows(0), device_packets(0), device_fifo_high_water(0), device_power(0), device_ticks(0),
+        gain_events(0), device_gain(0),
+        last_ticks(0), last_ticks_host_ns(0), last_ack_latency_ns(0)
+    {
+        //NOP
+    }
+
+    static UHD_INLINE void add(counter_type &counter, const boost::uint64_t n = 1)
+    {
+        counter.fetch_add(n, boost::memory_order_relaxed);
+    }
+
+    //! add the nanoseconds since start, returns them
+    static UHD_INLINE boost::uint64_t add_time(counter_type &counter, const clock_type::time_point &start)
+    {
+        const boost::uint64_t ns = boost::chrono::duration_cast<boost::chrono::nanoseconds>(clock_type::now() - start).count();
+        add(counter, ns);
+        return ns;
+    }
+
+    counter_type packets; //data packets
+    counter_type bytes; //data packet bytes on the wire
+    counter_type seq_errors; //rx sequence gaps, tx sequence errors reported by the device
+    counter_type alignment_failures; //rx only
+    counter_type overflows; //rx only
+    counter_type underflows; //tx only
+    counter_type late_packets; //tx only, time errors reported by the device
+    counter_type filled_samples; //rx only, samples made up for lost packets
+    counter_type discarded_packets; //rx only, dropped to catch up with the other channels
+    counter_type restarts; //rx only, continuous streams restarted after an overflow
+    counter_type restart_gap_samples; //rx only, samples lost between the overflows and the restarts
+    counter_type convert_ns; //time spent in the converter over all packets
+    latency_histogram_t wakeup_latency; //rx only, kernel arrival to delivery, see the busy_poll hint
+
+    //rx only, the latest statistics context packet of the device (FPGA 9.10+)
+    counter_type stats_packets; //statistics packets received
+    counter_type device_overflows; //overflows since the stream setup
+    counter_type device_packets; //data packets framed since the stream setup
+    counter_type device_fifo_high_water; //sample fifo fill peak over the last period, of 16
+    counter_type device_power; //averaged I^2+Q^2, full scale 2^31
+    counter_type device_ticks; //vita time of the packet
+
+    //rx only, the gain change packets of the RX AGC (FPGA 9.32+)
+    counter_type gain_events; //gain change packets received
+    counter_type device_gain; //RXVGA2 gain of the latest one, dB
+
+    //the newest rx data packet or tx flow control ack, a lower bound for umtrx_time_model
+    //last_ticks is stored after the host time, load it first (acquire)
+    counter_type last_ticks; //vita time of the packet
+    counter_type last_ticks_host_ns; //clock_type time since epoch when it was handled
+
+    //tx only, from the send of a packet to the flow control ack that covers it
+    latency_histogram_t ack_latency;
+    counter_type last_ack_latency_ns;
+
+#ifdef UMTRX_STREAM_PROFILE
+    //hot path latency, only with the stream profile compiled in
+    latency_histogram_t get_buff_latency; //includes the flow control wait on tx
+    latency_histogram_t fc_wait_latency; //tx only
+    latency_histogram_t vrt_latency; //header unpack or pack
+    latency_histogram_t convert_latency;
+#endif
+};
+
+/*!
+ * Hot path profile scopes, nothing is compiled in without UMTRX_STREAM_PROFILE.
+ * UMTRX_PROFILE_START(t) takes the start time,
+ * UMTRX_PROFILE_STOP(stats, hist, t) records the time since into stats->hist,
+ * UMTRX_PROFILE_RECORD(stats, hist, ns) records an already measured time.
+ */
+#ifdef UMTRX_STREAM_PROFILE
+#define UMTRX_PROFILE_START(t) const stream_stats_t::clock_type::time_point t = stream_stats_t::clock_type::now()
+#define UMTRX_PROFILE_STOP(stats, hist, t) do { if (stats) (stats)->hist.record( \
+    boost::chrono::duration_cast<boost::chrono::nanoseconds>(stream_stats_t::clock_type::now() - t).count()); } while(0)
+#define UMTRX_PROFILE_RECORD(stats, hist, ns) do { if (stats) (stats)->hist.record(ns); } while(0)
+#else
+#define UMTRX_PROFILE_START(t)
+#define UMTRX_PROFILE_STOP(stats, hist, t)
+#define UMTRX_PROFILE_RECORD(stats, hist, ns)
+#endif
+
+#endif /* INCLUDED_STREAM_STATS_HPP */
@@ -23,6 +23,11 @@
 #include <uhd/convert.hpp>
 #include <uhd/stream.hpp>
 #include "umtrx_log_adapter.hpp"
+#include "missing/platform.hpp"
+#include "stream_stats.hpp"
+#include "umtrx_rx_packet_streamer.hpp"
+#include "umtrx_rx_callback_streamer.hpp"
+#include "umtrx_rx_gain_events.hpp"
 #include <uhd/utils/tasks.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/metadata.hpp>
@@ -35,8 +40,16 @@
 #include <boost/bind/bind.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/thread/barrier.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <cstring>
+#include <cmath>
 
 // Included for debugging
 #ifdef UHD_TXRX_DEBUG_PRINTS
@@ -56,8 +69,9 @@ UHD_INLINE boost::uint32_t get_context_code(
     return word0 & 0xff;
 }
 
-typedef boost::function<void(void)> handle_overflow_type;
-static inline void handle_overflow_nop(void){}
+//! Called with the time of the overflow, zero when unknown
+typedef boost::function<void(const time_spec_t &)> handle_overflow_type;
+static inline void handle_overflow_nop(const time_spec_t &){}
 
 /***********************************************************************
  * Super receive packet handler
@@ -74,13 +88,31 @@ public:
     typedef void(*vrt_unpacker_type)(const boost::uint32_t *, vrt::if_packet_info_t &);
     //typedef boost::function<void(const boost::uint32_t *, vrt::if_packet_info_t &)> vrt_unpacker_type;
 
+    //! What to put in place of lost packets, see set_gap_fill()
+    enum gap_fill_type{
+        GAP_FILL_NONE, //report a sequence error and realign
+        GAP_FILL_ZERO, //zero samples
+        GAP_FILL_HOLD  //repeat the last sample of the channel
+    };
+
     /*!
      * Make a new packet handler for receive
      * \param size the number of transport channels
      */
     recv_packet_handler(const size_t size = 1):
         _queue_error_for_next_call(false),
-        _buffers_infos_index(0)
+        _gap_fill(GAP_FILL_NONE),
+        _gap_fill_max(0),
+        _gap_run(false),
+        _bfp(false),
+        _scale_factor(1/32767.),
+        _rate_change_pending(false),
+        _rate_change_rate(0.0),
+        _rate_change_scale(0.0),
+        _buffers_infos_index(0),
+        _single_channel(false),
+        _convert_num_threads(1),
+        _convert_exit(false)
     {
         #ifdef  ERROR_INJECT_DROPPED_PACKETS
         recvd_packets = 0;
@@ -91,6 +123,7 @@ public:
     }
 
     ~recv_packet_handler(void){
+        this->stop_converter_threads();
     }
 
     //! Resize the number of transport channels
@@ -99,6 +132,8 @@ public:
         _props.resize(size);
         //re-initialize all buffers infos by re-creating the vector
         _buffers_infos = std::vector<buffers_info_type>(4, buffers_info_type(size));
+        _gap_pending = std::vector<per_buffer_info_type>(size);
+        _single_channel = (size == 1);
     }
 
     //! Get the channel width of this handler
@@ -114,8 +149,9 @@ public:
 
     /*!
      * Set the threshold for alignment failure.
-     * How many packets throw out before giving up?
-     * \param threshold number of packets per channel
+     * How many times may the alignment time move forward before giving up?
+     * Packets of a channel that is behind are dropped without counting.
+     * \param threshold number of restarts per channel
      */
     void set_alignment_failure_threshold(const size_t threshold){
         _alignment_faulure_threshold = threshold*this->size();
@@ -131,6 +167,34 @@ public:
         _samp_rate = rate;
     }
 
+    //! Get the rate of samples per second
+    double get_samp_rate(void) const{
+        return _samp_rate;
+    }
+
+    /*!
+     * Change the rate and the scale factor at the first aligned packet
+     * stamped at or after the given time, for a DSP rate change timed then.
+     * The packet the change falls in keeps the old ones, it has the DSP
+     * transient anyway. Replaces a change that is still pending.
+     */
+    void set_samp_rate_at(const time_spec_t &time, const double rate, const double scale_factor){
+        boost::mutex::scoped_lock lock(_rate_change_mutex);
+        _rate_change_time = time;
+        _rate_change_rate = rate;
+        _rate_change_scale = scale_factor;
+        _rate_change_pending = true;
+    }
+
+    //! Take the oldest gain change packet, see umtrx_rx_gain_events
+    bool recv_gain_event(umtrx_rx_gain_events::event_type &event){
+        boost::mutex::scoped_lock lock(_gain_events_mutex);
+        if (_gain_events.empty()) return false;
+        event = _gain_events.front();
+        _gain_events.pop_front();
+        return true;
+    }
+
     /*!
      * Set the function to get a managed buffer.
      * \param xport_chan which transport channel
@@ -141,6 +205,21 @@ public:
             while (get_buff(0.0));
         }
         _props.at(xport_chan).get_buff = get_buff;
+        _props.at(xport_chan).xport.reset();
+    }
+
+    /*!
+     * Receive straight from a transport, the per packet call is then one
+     * virtual call instead of a boost::function around a bind.
+     * \param xport_chan which transport channel
+     * \param xport the transport, owned by the handler from now on
+     */
+    void set_xport_chan_xport(const size_t xport_chan, const zero_copy_if::sptr &xport, const bool flush = false){
+        if (flush){
+            while (xport->get_recv_buff(0.0));
+        }
+        _props.at(xport_chan).xport = xport;
+        _props.at(xport_chan).get_buff = get_buff_type();
     }
 
     /*!
@@ -169,12 +248,94 @@ public:
     //! Set the conversion routine for all channels
     void set_converter(const uhd::convert::id_type &id){
         _num_outputs = id.num_outputs;
+        _converter_id = id;
         _converter = uhd::convert::get_converter(id)();
+        //each worker thread owns a private converter instance
+        for (size_t i = 1; i < _converters.size(); i++){
+            _converters[i] = uhd::convert::get_converter(id)();
+        }
+        if (not _converters.empty()) _converters[0] = _converter;
         this->set_scale_factor(1/32767.); //update after setting converter
+        _bfp = id.input_format.compare(0, 5, "bfp8_") == 0;
         _bytes_per_otw_item = uhd::convert::get_bytes_per_item(id.input_format);
         _bytes_per_cpu_item = uhd::convert::get_bytes_per_item(id.output_format);
     }
 
+    /*!
+     * Spread the copy-conversion of the channels across threads.
+     * The calling thread converts its own share of the channels,
+     * num_threads-1 workers are spawned to convert the remainder.
+     * Must be called after set_converter().
+     * \param num_threads total number of converting threads (0 or 1 disables)
+     * \param cpus pin worker i to cpus[i-1], workers past the end are not pinned
+     * \param rt_priority SCHED_FIFO priority of the workers (0 keeps the default)
+     */
+    void set_converter_threads(const size_t num_threads, const std::vector<int> &cpus = std::vector<int>(), const int rt_priority = 0)
+    {
+        this->stop_converter_threads();
+        _convert_num_threads = std::max<size_t>(1, std::min(num_threads, this->size()));
+        if (_convert_num_threads == 1) return;
+
+        _converters.resize(_convert_num_threads);
+        _converters[0] = _converter;
+        for (size_t i = 1; i < _converters.size(); i++){
+            _converters[i] = uhd::convert::get_converter(_converter_id)();
+            _converters[i]->set_scalar(_scale_factor);
+        }
+
+        _convert_exit = false;
+        _convert_barrier_start.reset(new boost::barrier(_convert_num_threads));
+        _convert_barrier_done.reset(new boost::barrier(_convert_num_threads));
+        for (size_t i = 1; i < _convert_num_threads; i++){
+            const int cpu = (i-1 < cpus.size())? cpus[i-1] : -1;
+            _convert_threads.create_thread(boost::bind(
+                &recv_packet_handler::converter_worker_loop, this, i, cpu, rt_priority));
+        }
+    }
+
+    /*!
+     * Run every converter once on a zeroed packet, so that the tables a
+     * converter builds on first use and the scratch buffers are in place
+     * before the first real packet. Call after set_converter_threads().
+     * \param nsamps samples per packet
+     */
+    void warm_up(const size_t nsamps)
+    {
+        if (nsamps == 0) return;
+        std::vector<char> otw(nsamps*_bytes_per_otw_item, 0);
+        std::vector<std::vector<char> > cpu(_num_outputs, std::vector<char>(nsamps*_bytes_per_cpu_item));
+        std::vector<void *> out(_num_outputs);
+        for (size_t i = 0; i < _num_outputs; i++) out[i] = &cpu[i].front();
+        const ref_vector<void *> out_buffs(out);
+        _converter->conv(&otw.front(), out_buffs, nsamps);
+        for (size_t i = 1; i < _converters.size(); i++) _converters[i]->conv(&otw.front(), out_buffs, nsamps);
+    }
+
+    //! Set the counters of a transport channel (optional)
+    void set_xport_chan_stats(const size_t xport_chan, const stream_stats_t::sptr &stats)
+    {
+        _props.at(xport_chan).stats = stats;
+    }
+
+    /*!
+     * Fill lost packets instead of reporting a sequence error.
+     * On a sequence jump the samples missing between the last packet and
+     * the VRT timestamp of the new one are filled in, so the stream stays
+     * contiguous and time aligned across channels.
+     * A fill is never merged with real samples in one recv() call:
+     * its metadata has out_of_sequence set with error code none, the
+     * time spec and the number of samples returned give the gap extent.
+     * Gaps longer than max_packets packets, or without a timestamp,
+     * are still reported as a sequence error.
+     * \param mode what to fill the gap with
+     * \param max_packets longest gap to fill, in packets
+     */
+    void set_gap_fill(const gap_fill_type mode, const size_t max_packets)
+    {
+        _gap_fill = mode;
+        _gap_fill_max = max_packets;
+    }
+
     //! Set the transport channel's overflow handler
     void set_overflow_handler(const size_t xport_chan, const handle_overflow_type &handle_overflow){
         _props.at(xport_chan).handle_overflow = handle_overflow;
@@ -182,7 +343,11 @@ public:
 
     //! Set the scale factor used in float conversion
     void set_scale_factor(const double scale_factor){
+        _scale_factor = scale_factor;
         _converter->set_scalar(scale_factor);
+        for (size_t i = 1; i < _converters.size(); i++){
+            _converters[i]->set_scalar(scale_factor);
+        }
     }
 
     //! Set the callback to issue stream commands
@@ -191,9 +356,16 @@ public:
         _props.at(xport_chan).issue_stream_cmd = issue_stream_cmd;
     }
 
+    //! Set one callback that issues stream commands to all channels at once
+    void set_issue_stream_cmd_all(const issue_stream_cmd_type &issue_stream_cmd)
+    {
+        _issue_stream_cmd_all = issue_stream_cmd;
+    }
+
     //! Overload call to issue stream commands
     void issue_stream_cmd(const stream_cmd_t &stream_cmd)
     {
+        if (_issue_stream_cmd_all) return _issue_stream_cmd_all(stream_cmd);
         for (size_t i = 0; i < _props.size(); i++)
         {
             if (_props[i].issue_stream_cmd) _props[i].issue_stream_cmd(stream_cmd);
@@ -224,6 +396,7 @@ public:
         size_t accum_num_samps = recv_one_packet(
             buffs, nsamps_per_buff, metadata, timeout
         );
+        _gap_run = metadata.out_of_sequence;
 
         if (one_packet){
 #ifdef UHD_TXRX_DEBUG_PRINTS
@@ -247,6 +420,9 @@ public:
                 _queue_error_for_next_call = true;
                 break;
             }
+
+            //a gap fill starts or ends, leave it for the next call
+            if (_queue_metadata.out_of_sequence != _gap_run) break;
             accum_num_samps += num_samps;
         }
 #ifdef UHD_TXRX_DEBUG_PRINTS
@@ -255,6 +431,95 @@ public:
         return accum_num_samps;
     }
 
+    /*******************************************************************
+     * Receive one aligned packet without copying:
+     * hands out the frames and wire payloads of the current packet,
+     * or whatever part of it a previous recv() has left.
+     ******************************************************************/
+    UHD_INLINE size_t recv_packet(umtrx_rx_packet_streamer::packet_type &packet, const double timeout)
+    {
+        packet.release();
+
+        //handle metadata queued from a previous receive
+        if (_queue_error_for_next_call){
+            _queue_error_for_next_call = false;
+            packet.metadata = _queue_metadata;
+            if (_queue_metadata.error_code != rx_metadata_t::ERROR_CODE_TIMEOUT) return 0;
+        }
+
+        if (get_curr_buffer_info().data_bytes_to_copy == 0)
+        {
+            get_aligned_buffs(timeout);
+        }
+        buffers_info_type &info = get_curr_buffer_info();
+        packet.metadata = info.metadata;
+        packet.metadata.time_spec += time_spec_t::from_ticks(info.fragment_offset_in_samps, _samp_rate);
+        packet.metadata.more_fragments = false;
+        packet.metadata.fragment_offset = info.fragment_offset_in_samps;
+        _gap_run = packet.metadata.out_of_sequence;
+        if (info.data_bytes_to_copy == 0) return 0;
+
+        //the frames move into the packet
+        packet.buffs.resize(this->size());
+        packet.payloads.resize(this->size());
+        packet.exponents.assign(this->size(), 0);
+        for (size_t i = 0; i < this->size(); i++)
+        {
+            per_buffer_info_type &buff_info = info[i];
+            packet.payloads[i] = buff_info.copy_buff;
+            packet.exponents[i] = buff_info.exponent;
+            if (_gap_fill == GAP_FILL_HOLD){
+                std::vector<char> &hold_item = _props[i].hold_item;
+                hold_item.resize(_bytes_per_otw_item);
+                std::memcpy(&hold_item.front(), buff_info.copy_buff + info.data_bytes_to_copy - _bytes_per_otw_item, _bytes_per_otw_item);
+                _props[i].hold_exponent = buff_info.exponent;
+            }
+            packet.buffs[i].swap(buff_info.buff);
+        }
+        packet.nsamps = info.data_bytes_to_copy/_bytes_per_otw_item;
+        info.fragment_offset_in_samps += packet.nsamps;
+        info.data_bytes_to_copy = 0;
+        return packet.nsamps;
+    }
+
+    /*******************************************************************
+     * Receive a batch of packets:
+     * the loop of a full buffer recv(), with the metadata of every
+     * packet kept instead of only the first.
+     ******************************************************************/
+    UHD_INLINE size_t recv_many(
+        const uhd::rx_streamer::buffs_type &buffs,
+        const size_t nsamps_per_buff,
+        std::vector<umtrx_rx_packet_streamer::batch_entry_type> &entries,
+        const size_t max_packets,
+        const double timeout
+    ){
+        entries.clear();
+        size_t accum_num_samps = 0;
+        while (entries.size() < max_packets and accum_num_samps < nsamps_per_buff){
+            umtrx_rx_packet_streamer::batch_entry_type entry;
+            entry.offset = accum_num_samps;
+
+            //the first packet also hands out the error queued by a recv()
+            if (entries.empty()) entry.nsamps = this->recv(
+                buffs, nsamps_per_buff, entry.metadata, timeout, true
+            );
+            else entry.nsamps = recv_one_packet(
+                buffs, nsamps_per_buff - accum_num_samps, entry.metadata,
+                timeout, accum_num_samps*_bytes_per_cpu_item
+            );
+
+            const rx_metadata_t::error_code_t error = entry.metadata.error_code;
+            if (error == rx_metadata_t::ERROR_CODE_TIMEOUT and not entries.empty()) break;
+            //a gap fill starts or ends, leave it for the next call
+            if (error == rx_metadata_t::ERROR_CODE_NONE and entry.nsamps == 0) break;
+            entries.push_back(entry);
+            accum_num_samps += entry.nsamps;
+            if (error != rx_metadata_t::ERROR_CODE_NONE or entry.metadata.more_fragments) break;
+        }
+        return accum_num_samps;
+    }
+
 private:
     vrt_unpacker_type _vrt_unpacker;
     size_t _header_offset_words32;
@@ -262,24 +527,70 @@ private:
     bool _queue_error_for_next_call;
     size_t _alignment_faulure_threshold;
     rx_metadata_t _queue_metadata;
+    gap_fill_type _gap_fill;
+    size_t _gap_fill_max;
+    bool _gap_run; //the current recv() call returns a gap fill
+    issue_stream_cmd_type _issue_stream_cmd_all;
     struct xport_chan_props_type{
         xport_chan_props_type(void):
             packet_count(0),
             handle_overflow(&handle_overflow_nop),
-            fc_update_window(0)
+            fc_update_window(0),
+            next_tsf(0),
+            next_tsf_valid(false),
+            gap_samps(0),
+            gap_spp(0),
+            hold_exponent(0)
         {}
         get_buff_type get_buff;
+        zero_copy_if::sptr xport; //used instead of get_buff when set
         issue_stream_cmd_type issue_stream_cmd;
         size_t packet_count;
         handle_overflow_type handle_overflow;
         handle_flowctrl_type handle_flowctrl;
         size_t fc_update_window;
+        stream_stats_t::sptr stats;
+
+        //gap fill state, only used with set_gap_fill()
+        boost::uint64_t next_tsf; //expected timestamp of the next packet
+        bool next_tsf_valid;
+        size_t gap_samps; //samples of the gap still to fill
+        size_t gap_spp; //samples per fill packet
+        vrt::if_packet_info_t gap_ifpi; //header the fill packets are made from
+        std::vector<char> fill_buff; //one fill packet of otw items
+        std::vector<char> hold_item; //last otw item received
+        int hold_exponent; //of the packet of the hold item
     };
     std::vector<xport_chan_props_type> _props;
     size_t _num_outputs;
+    bool _bfp; //block floating point: an exponent word leads each payload
     size_t _bytes_per_otw_item; //used in conversion
     size_t _bytes_per_cpu_item; //used in conversion
     uhd::convert::converter::sptr _converter; //used in conversion
+    uhd::convert::id_type _converter_id; //used to make worker converters
+    double _scale_factor; //applied to worker converters
+
+    //timed rate change, see set_samp_rate_at(), taken in the receive thread
+    boost::mutex _rate_change_mutex;
+    boost::atomic<bool> _rate_change_pending;
+    time_spec_t _rate_change_time;
+    double _rate_change_rate, _rate_change_scale;
+
+    //gain change packets of the RX AGC, taken in the receive thread
+    static const size_t GAIN_EVENTS_DEPTH = 256;
+    boost::mutex _gain_events_mutex;
+    std::deque<umtrx_rx_gain_events::event_type> _gain_events;
+
+    UHD_INLINE void take_rate_change(const rx_metadata_t &metadata){
+        if (not metadata.has_time_spec) return;
+        boost::mutex::scoped_lock lock(_rate_change_mutex);
+        if (not _rate_change_pending or metadata.time_spec < _rate_change_time) return;
+        _rate_change_pending = false;
+        _samp_rate = _rate_change_rate;
+        this->set_scale_factor(_rate_change_scale);
+        //the next timestamps follow the new rate
+        for (size_t i = 0; i < _props.size(); i++) _props[i].next_tsf_valid = false;
+    }
 
     //! information stored for a received buffer
     struct per_buffer_info_type{
@@ -287,16 +598,23 @@ private:
         {
             buff.reset();
             vrt_hdr = NULL;
-            time = time_spec_t(0.0);
+            ticks = 0;
             copy_buff = NULL;
+            exponent = 0;
+            filled = false;
         }
         managed_recv_buffer::sptr buff;
         const boost::uint32_t *vrt_hdr;
         vrt::if_packet_info_t ifpi;
-        time_spec_t time;
+        boost::uint64_t ticks; //the tsf, the timeline stays in ticks until the metadata
         const char *copy_buff;
+        int exponent; //shared by the samples of a block floating point packet
+        bool filled; //made up by the gap fill, no buffer behind it
     };
 
+    //! the packet that ended a gap, held back until the gap is filled
+    std::vector<per_buffer_info_type> _gap_pending;
+
     //!information stored for a set of aligned buffers
     struct buffers_info_type : std::vector<per_buffer_info_type> {
         buffers_info_type(const size_t size):
@@ -309,7 +627,7 @@ private:
         void reset()
         {
             indexes_todo.set();
-            alignment_time = time_spec_t(0.0);
+            alignment_ticks = 0;
             alignment_time_valid = false;
             data_bytes_to_copy = 0;
             fragment_offset_in_samps = 0;
@@ -318,7 +636,7 @@ private:
                 at(i).reset();
         }
         boost::dynamic_bitset<> indexes_todo; //used in alignment logic
-        time_spec_t alignment_time; //used in alignment logic
+        boost::uint64_t alignment_ticks; //used in alignment logic
         bool alignment_time_valid; //used in alignment logic
         size_t data_bytes_to_copy; //keeps track of state
         size_t fragment_offset_in_samps; //keeps track of state
@@ -332,6 +650,46 @@ private:
     buffers_info_type &get_prev_buffer_info(void){return _buffers_infos[(_buffers_infos_index + 3)%4];}
     buffers_info_type &get_next_buffer_info(void){return _buffers_infos[(_buffers_infos_index + 1)%4];}
     void increment_buffer_info(void){_buffers_infos_index = (_buffers_infos_index + 1)%4;}
+    bool _single_channel; //one channel is always aligned, see get_single_buff()
+
+    //! statistics context packets carry 4 words, the gain changes 2, the error packets 1
+    static const size_t STATS_PAYLOAD_WORDS32 = 4;
+    static const size_t GAIN_PAYLOAD_WORDS32 = 2;
+
+    static void record_device_stats(stream_stats_t &stats, const per_buffer_info_type &info)
+    {
+        //the device packs big endian
+        const boost::uint32_t *payload = info.vrt_hdr + info.ifpi.num_header_words32;
+        stream_stats_t::add(stats.stats_packets);
+        stats.device_overflows.store(uhd::ntohx(payload[0]), boost::memory_order_relaxed);
+        stats.device_fifo_high_water.store(uhd::ntohx(payload[1]), boost::memory_order_relaxed);
+        stats.device_power.store(uhd::ntohx(payload[2]), boost::memory_order_relaxed);
+        stats.device_packets.store(uhd::ntohx(payload[3]), boost::memory_order_relaxed);
+        stats.device_ticks.store(info.ifpi.tsf, boost::memory_order_relaxed);
+    }
+
+    //! queue a gain change: [31:16] sequence, [8] LMS, [4:0] RXVGA2 code, then the power
+    void record_gain_event(const size_t index, stream_stats_t *stats, const per_buffer_info_type &info)
+    {
+        const boost::uint32_t *payload = info.vrt_hdr + info.ifpi.num_header_words32;
+        const boost::uint32_t word = uhd::ntohx(payload[0]);
+        const boost::uint32_t power = uhd::ntohx(payload[1]);
+        umtrx_rx_gain_events::event_type event;
+        event.chan = index;
+        event.time = time_spec_t::from_ticks(info.ifpi.tsf, _tick_rate);
+        event.seq = boost::uint16_t(word >> 16);
+        event.frontend = (word >> 8) & 0x1;
+        event.gain = 3.0*(word & 0x1f);
+        event.power = 10*std::log10(std::max<double>(power, 1)/(32767.0*32767.0));
+        if (stats != NULL){
+            stream_stats_t::add(stats->gain_events);
+            stats->device_gain.store(3*(word & 0x1f), boost::memory_order_relaxed);
+        }
+
+        boost::mutex::scoped_lock lock(_gain_events_mutex);
+        if (_gain_events.size() >= GAIN_EVENTS_DEPTH) _gain_events.pop_front();
+        _gain_events.push_back(event);
+    }
 
     //! possible return options for the packet receiver
     enum packet_type{
@@ -358,9 +716,22 @@ private:
         per_buffer_info_type &curr_buffer_info,
         double timeout
     ){
+        //deliver the fill of a gap, then the packet that ended it
+        if (_props[index].gap_samps != 0) return this->get_gap_fill_packet(index, curr_buffer_info);
+        if (_gap_pending[index].buff){
+            curr_buffer_info = _gap_pending[index];
+            _gap_pending[index].reset();
+            this->track_next_tsf(index, curr_buffer_info);
+            return PACKET_IF_DATA;
+        }
+
         //get a single packet from the transport layer
+        stream_stats_t *stats = _props[index].stats.get();
         managed_recv_buffer::sptr &buff = curr_buffer_info.buff;
-        buff = _props[index].get_buff(timeout);
+        UMTRX_PROFILE_START(get_buff_start);
+        zero_copy_if *xport = _props[index].xport.get();
+        buff = xport? xport->get_recv_buff(timeout) : _props[index].get_buff(timeout);
+        UMTRX_PROFILE_STOP(stats, get_buff_latency, get_buff_start);
         if (buff.get() == NULL) return PACKET_TIMEOUT_ERROR;
 
         #ifdef  ERROR_INJECT_DROPPED_PACKETS
@@ -368,7 +739,7 @@ private:
         {
             recvd_packets = 0;
             buff.reset();
-            buff = _props[index].get_buff(timeout);
+            buff = xport? xport->get_recv_buff(timeout) : _props[index].get_buff(timeout);
             if (buff.get() == NULL) return PACKET_TIMEOUT_ERROR;
         }
         #endif
@@ -383,10 +754,34 @@ private:
         per_buffer_info_type &info = curr_buffer_info;
         info.ifpi.num_packet_words32 = num_packet_words32 - _header_offset_words32;
         info.vrt_hdr = buff->cast<const boost::uint32_t *>() + _header_offset_words32;
+        UMTRX_PROFILE_START(vrt_start);
         _vrt_unpacker(info.vrt_hdr, info.ifpi);
-        info.time = time_spec_t::from_ticks(info.ifpi.tsf, _tick_rate); //assumes has_tsf is true
+        UMTRX_PROFILE_STOP(stats, vrt_latency, vrt_start);
+        info.ticks = info.ifpi.tsf; //assumes has_tsf is true
         info.copy_buff = reinterpret_cast<const char *>(info.vrt_hdr + info.ifpi.num_header_words32);
 
+        //the exponent word is all zero but its low bits, in either word order
+        if (_bfp and info.ifpi.packet_type == vrt::if_packet_info_t::PACKET_TYPE_DATA and info.ifpi.num_payload_words32 != 0)
+        {
+            const boost::uint32_t word = info.vrt_hdr[info.ifpi.num_header_words32];
+            info.exponent = int((word | uhd::byteswap(word)) & 0xf);
+            info.copy_buff += sizeof(boost::uint32_t);
+            info.ifpi.num_payload_words32 -= 1;
+            info.ifpi.num_payload_bytes -= std::min(info.ifpi.num_payload_bytes, sizeof(boost::uint32_t));
+        }
+
+        if (stats != NULL and info.ifpi.packet_type == vrt::if_packet_info_t::PACKET_TYPE_DATA)
+        {
+            stream_stats_t::add(stats->packets);
+            stream_stats_t::add(stats->bytes, buff->size());
+            if (info.ifpi.has_tsf)
+            {
+                stats->last_ticks_host_ns.store(boost::chrono::duration_cast<boost::chrono::nanoseconds>(
+                    stream_stats_t::clock_type::now().time_since_epoch()).count(), boost::memory_order_relaxed);
+                stats->last_ticks.store(info.ifpi.tsf, boost::memory_order_release);
+            }
+        }
+
         //handle flow control
         if (_props[index].handle_flowctrl)
         {
@@ -403,6 +798,16 @@ private:
 
         //1) check for inline IF message packets
         if (info.ifpi.packet_type != vrt::if_packet_info_t::PACKET_TYPE_DATA){
+            //statistics packets only update the counters, go on with the next packet
+            if (info.ifpi.num_payload_words32 == STATS_PAYLOAD_WORDS32){
+                if (stats != NULL) record_device_stats(*stats, info);
+                return this->get_and_process_single_packet(index, prev_buffer_info, curr_buffer_info, timeout);
+            }
+            //so do the gain changes, they wait for recv_gain_event()
+            if (info.ifpi.num_payload_words32 == GAIN_PAYLOAD_WORDS32){
+                this->record_gain_event(index, stats, info);
+                return this->get_and_process_single_packet(index, prev_buffer_info, curr_buffer_info, timeout);
+            }
             return PACKET_INLINE_MESSAGE;
         }
 
@@ -412,12 +817,18 @@ private:
         const size_t expected_packet_count = _props[index].packet_count;
         _props[index].packet_count = (info.ifpi.packet_count + 1) & seq_mask;
         if (expected_packet_count != info.ifpi.packet_count){
+            if (stats != NULL) stream_stats_t::add(stats->seq_errors);
+            if (_gap_fill == GAP_FILL_NONE) return PACKET_SEQUENCE_ERROR;
+            if (this->start_gap_fill(index, info)) return this->get_gap_fill_packet(index, info);
+            this->track_next_tsf(index, info);
             return PACKET_SEQUENCE_ERROR;
         }
         #endif
 
+        if (_gap_fill != GAP_FILL_NONE) this->track_next_tsf(index, info);
+
         //3) check for out of order timestamps
-        if (info.ifpi.has_tsf and prev_buffer_info.time > info.time){
+        if (info.ifpi.has_tsf and prev_buffer_info.ticks > info.ticks){
             return PACKET_TIMESTAMP_ERROR;
         }
 
@@ -425,6 +836,67 @@ private:
         return PACKET_IF_DATA;
     }
 
+    //! remember where the packet after this one should start
+    UHD_INLINE void track_next_tsf(const size_t index, const per_buffer_info_type &info)
+    {
+        xport_chan_props_type &props = _props[index];
+        const size_t nsamps = info.ifpi.num_payload_bytes/_bytes_per_otw_item;
+        props.next_tsf = info.ifpi.tsf + boost::uint64_t(nsamps*_tick_rate/_samp_rate + 0.5);
+        props.next_tsf_valid = info.ifpi.has_tsf;
+    }
+
+    /*!
+     * Set up the fill of the gap before the packet in info.
+     * The packet is held back until the gap is filled.
+     * \return false when the gap cannot be filled
+     */
+    bool start_gap_fill(const size_t index, per_buffer_info_type &info)
+    {
+        xport_chan_props_type &props = _props[index];
+        if (not props.next_tsf_valid or not info.ifpi.has_tsf) return false;
+        const size_t spp = info.ifpi.num_payload_bytes/_bytes_per_otw_item;
+        const double gap = (double(info.ifpi.tsf) - double(props.next_tsf))*_samp_rate/_tick_rate;
+        if (spp == 0 or gap < 0.5 or gap > double(_gap_fill_max*spp)) return false;
+
+        props.gap_samps = size_t(gap + 0.5);
+        props.gap_spp = spp;
+        props.gap_ifpi = info.ifpi;
+        props.gap_ifpi.sob = false;
+        props.gap_ifpi.eob = false;
+        props.fill_buff.assign(spp*_bytes_per_otw_item, 0);
+        props.hold_item.resize(_bytes_per_otw_item, 0);
+        if (_gap_fill == GAP_FILL_HOLD){
+            for (size_t i = 0; i < props.fill_buff.size(); i += _bytes_per_otw_item){
+                std::memcpy(&props.fill_buff[i], &props.hold_item.front(), _bytes_per_otw_item);
+            }
+        }
+        if (props.stats) stream_stats_t::add(props.stats->filled_samples, props.gap_samps);
+
+        _gap_pending[index] = info;
+        info.reset();
+        UHD_LOG_FASTPATH("D");
+        return true;
+    }
+
+    //! make the next packet of a gap fill in info
+    packet_type get_gap_fill_packet(const size_t index, per_buffer_info_type &info)
+    {
+        xport_chan_props_type &props = _props[index];
+        const size_t nsamps = std::min(props.gap_samps, props.gap_spp);
+        info.reset();
+        info.ifpi = props.gap_ifpi;
+        info.ifpi.num_payload_bytes = nsamps*_bytes_per_otw_item;
+        info.ifpi.num_payload_words32 = (info.ifpi.num_payload_bytes + 3)/sizeof(boost::uint32_t);
+        info.ifpi.tsf = props.next_tsf;
+        info.ticks = info.ifpi.tsf;
+        info.copy_buff = &props.fill_buff.front();
+        info.exponent = props.hold_exponent;
+        info.filled = true;
+        props.gap_samps -= nsamps;
+        this->track_next_tsf(index, info);
+        return PACKET_IF_DATA;
+    }
+
     void _flush_all(double timeout)
     {
         for (size_t i = 0; i < _props.size(); i++)
@@ -446,6 +918,9 @@ private:
                 prev_buffer_info = curr_buffer_info;
                 curr_buffer_info.reset();
             }
+            _props[i].gap_samps = 0;
+            _props[i].next_tsf_valid = false;
+            _gap_pending[i].reset();
         }
         get_prev_buffer_info().reset();
         get_curr_buffer_info().reset();
@@ -455,30 +930,74 @@ private:
     /*******************************************************************
      * Alignment check:
      * Check the received packet for alignment and mark accordingly.
+     * Returns true when the packet moved the alignment time forward.
      ******************************************************************/
-    UHD_INLINE void alignment_check(
+    UHD_INLINE bool alignment_check(
         const size_t index, buffers_info_type &info
     ){
         //if alignment time was not valid or if the sequence id is newer:
         //  use this index's time as the alignment time
         //  reset the indexes list and remove this index
-        if (not info.alignment_time_valid or info[index].time > info.alignment_time){
+        if (not info.alignment_time_valid or info[index].ticks > info.alignment_ticks){
+            const bool restart = info.alignment_time_valid;
             info.alignment_time_valid = true;
-            info.alignment_time = info[index].time;
+            info.alignment_ticks = info[index].ticks;
             info.indexes_todo.set();
             info.indexes_todo.reset(index);
             info.data_bytes_to_copy = info[index].ifpi.num_payload_bytes;
+            return restart;
         }
 
         //if the sequence id matches:
         //  remove this index from the list and continue
-        else if (info[index].time == info.alignment_time){
+        else if (info[index].ticks == info.alignment_ticks){
             info.indexes_todo.reset(index);
         }
 
         //if the sequence id is older:
-        //  continue with the same index to try again
-        //else if (info[index].time < info.alignment_time)...
+        //  the caller fast-forwards this index
+        return false;
+    }
+
+    //! True when the data packet at index is older than the alignment time
+    UHD_INLINE bool is_behind(const size_t index, const buffers_info_type &info) const
+    {
+        return info.alignment_time_valid and info[index].ticks < info.alignment_ticks;
+    }
+
+    //! Whole packets from the one at index up to the alignment time, from the tick delta
+    UHD_INLINE size_t packets_behind(const size_t index, const buffers_info_type &info) const
+    {
+        const size_t nsamps = info[index].ifpi.num_payload_bytes/_bytes_per_otw_item;
+        const double packet_ticks = nsamps*_tick_rate/_samp_rate;
+        const double delta_ticks = double(info.alignment_ticks - info[index].ticks);
+        if (packet_ticks < 1.0) return 1;
+        return std::max<size_t>(1, size_t(delta_ticks/packet_ticks + 0.5));
+    }
+
+    /*!
+     * Drop the packets of a channel that is behind the alignment time.
+     * The number of packets to drop comes from the tick delta and they
+     * are dropped in one go, the alignment loop only sees the first
+     * packet that is not behind (or a message, error or timeout).
+     */
+    UHD_INLINE packet_type fast_forward(
+        const size_t index, buffers_info_type &prev_info, buffers_info_type &curr_info, const double timeout
+    ){
+        stream_stats_t *stats = _props[index].stats.get();
+        packet_type packet = PACKET_IF_DATA;
+        size_t num_drop = this->packets_behind(index, curr_info);
+        while (packet == PACKET_IF_DATA and this->is_behind(index, curr_info))
+        {
+            if (num_drop == 0) num_drop = this->packets_behind(index, curr_info); //more packets were lost on the way
+            for (; num_drop != 0 and packet == PACKET_IF_DATA; num_drop--)
+            {
+                if (stats != NULL) stream_stats_t::add(stats->discarded_packets);
+                curr_info[index].reset();
+                packet = get_and_process_single_packet(index, prev_info[index], curr_info[index], timeout);
+            }
+        }
+        return packet;
     }
 
     /*******************************************************************
@@ -489,6 +1008,8 @@ private:
      ******************************************************************/
     UHD_INLINE void get_aligned_buffs(double timeout){
 
+        if (_single_channel) return this->get_single_buff(timeout);
+
         get_prev_buffer_info().reset(); // no longer need the previous info - reset it for future use
 
         increment_buffer_info(); //increment to next buffer
@@ -499,9 +1020,12 @@ private:
 
         //Loop until we get a message of an aligned set of buffers:
         // - Receive a single packet and extract its info.
+        // - Fast-forward a channel that is behind the alignment time.
         // - Handle the packet type yielded by the receive.
         // - Check the timestamps for alignment conditions.
-        size_t iterations = 0;
+        //The newest timestamp sets the alignment time, so the loop only
+        //restarts when a channel jumps ahead of all the others.
+        size_t restarts = 0;
         while (curr_info.indexes_todo.any()){
 
             //get the index to process for this iteration
@@ -513,6 +1037,9 @@ private:
                 packet = get_and_process_single_packet(
                     index, prev_info[index], curr_info[index], timeout
                 );
+                if (packet == PACKET_IF_DATA and this->is_behind(index, curr_info)){
+                    packet = this->fast_forward(index, prev_info, curr_info, timeout);
+                }
             }
 
             //handle the case when the get packet throws
@@ -527,7 +1054,7 @@ private:
 
             switch(packet){
             case PACKET_IF_DATA:
-                alignment_check(index, curr_info);
+                if (alignment_check(index, curr_info)) restarts++;
                 break;
 
             case PACKET_TIMESTAMP_ERROR:
@@ -535,20 +1062,21 @@ private:
                 //we can receive a packet that comes before the previous packet in time.
                 //This could cause the alignment logic to discard future received packets.
                 //Therefore, when this occurs, we reset the info to restart from scratch.
-                if (curr_info.alignment_time_valid and curr_info.alignment_time != curr_info[index].time){
+                if (curr_info.alignment_time_valid and curr_info.alignment_ticks != curr_info[index].ticks){
                     curr_info.alignment_time_valid = false;
                 }
-                alignment_check(index, curr_info);
+                if (alignment_check(index, curr_info)) restarts++;
                 break;
 
             case PACKET_INLINE_MESSAGE:
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = next_info[index].ifpi.has_tsf;
-                curr_info.metadata.time_spec = next_info[index].time;
+                curr_info.metadata.time_spec = time_spec_t::from_ticks(next_info[index].ticks, _tick_rate);
                 curr_info.metadata.error_code = rx_metadata_t::error_code_t(get_context_code(next_info[index].vrt_hdr, next_info[index].ifpi));
                 if (curr_info.metadata.error_code == rx_metadata_t::ERROR_CODE_OVERFLOW){
+                    if (_props[index].stats) stream_stats_t::add(_props[index].stats->overflows);
                     rx_metadata_t metadata = curr_info.metadata;
-                    _props[index].handle_overflow();
+                    _props[index].handle_overflow(metadata.has_time_spec? metadata.time_spec : time_spec_t(0.0));
                     curr_info.metadata = metadata;
                     UHD_LOG_FASTPATH("O");
                 }
@@ -572,16 +1100,17 @@ private:
 
             }
 
-            //too many iterations: detect alignment failure
-            if (iterations++ > _alignment_faulure_threshold){
+            //too many restarts: detect alignment failure
+            if (restarts > _alignment_faulure_threshold){
                 UHD_MSG(error) << boost::format(
                     "The receive packet handler failed to time-align packets.\n"
-                    "%u received packets were processed by the handler.\n"
+                    "The alignment time moved forward %u times.\n"
                     "However, a timestamp match could not be determined.\n"
-                ) % iterations << std::endl;
+                ) % restarts << std::endl;
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_ALIGNMENT;
-                _props[index].handle_overflow();
+                if (_props[index].stats) stream_stats_t::add(_props[index].stats->alignment_failures);
+                _props[index].handle_overflow(time_spec_t(0.0));
                 return;
             }
 
@@ -589,15 +1118,101 @@ private:
 
         //set the metadata from the buffer information at index zero
         curr_info.metadata.has_time_spec = curr_info[0].ifpi.has_tsf;
-        curr_info.metadata.time_spec = curr_info[0].time;
+        curr_info.metadata.time_spec = time_spec_t::from_ticks(curr_info[0].ticks, _tick_rate);
         curr_info.metadata.more_fragments = false;
         curr_info.metadata.fragment_offset = 0;
         curr_info.metadata.start_of_burst = curr_info[0].ifpi.sob;
         curr_info.metadata.end_of_burst = curr_info[0].ifpi.eob;
         curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_NONE;
+        if (_gap_fill != GAP_FILL_NONE) for (size_t i = 0; i < curr_info.size(); i++){
+            if (curr_info[i].filled) curr_info.metadata.out_of_sequence = true;
+        }
+        if (_rate_change_pending) this->take_rate_change(curr_info.metadata);
 
     }
 
+    /*******************************************************************
+     * Get the buffer of a single channel:
+     * The straight line of get_aligned_buffs() for one channel, which
+     * is always aligned: no index bookkeeping, restarts or fast forward.
+     * Messages and errors are handled the same way.
+     ******************************************************************/
+    UHD_INLINE void get_single_buff(double timeout){
+
+        get_prev_buffer_info().reset(); // no longer need the previous info - reset it for future use
+
+        increment_buffer_info(); //increment to next buffer
+
+        buffers_info_type &prev_info = get_prev_buffer_info();
+        buffers_info_type &curr_info = get_curr_buffer_info();
+        buffers_info_type &next_info = get_next_buffer_info();
+        per_buffer_info_type &info = curr_info[0];
+
+        //the packet after a sequence error was saved with its bytes to copy, it goes out now
+        if (curr_info.data_bytes_to_copy == 0){
+            packet_type packet;
+            try{
+                packet = get_and_process_single_packet(0, prev_info[0], info, timeout);
+            }
+            catch(const std::exception &e){
+                UHD_MSG(error) << boost::format(
+                    "The receive packet handler caught an exception.\n%s"
+                ) % e.what() << std::endl;
+                std::swap(curr_info, next_info); //save progress from curr -> next
+                curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_BAD_PACKET;
+                return;
+            }
+
+            switch(packet){
+            case PACKET_IF_DATA:
+            case PACKET_TIMESTAMP_ERROR: //a time set while streaming, nothing to realign with
+                curr_info.data_bytes_to_copy = info.ifpi.num_payload_bytes;
+                break;
+
+            case PACKET_INLINE_MESSAGE:
+                std::swap(curr_info, next_info); //save progress from curr -> next
+                curr_info.metadata.has_time_spec = next_info[0].ifpi.has_tsf;
+                curr_info.metadata.time_spec = time_spec_t::from_ticks(next_info[0].ticks, _tick_rate);
+                curr_info.metadata.error_code = rx_metadata_t::error_code_t(get_context_code(next_info[0].vrt_hdr, next_info[0].ifpi));
+                if (curr_info.metadata.error_code == rx_metadata_t::ERROR_CODE_OVERFLOW){
+                    if (_props[0].stats) stream_stats_t::add(_props[0].stats->overflows);
+                    rx_metadata_t metadata = curr_info.metadata;
+                    _props[0].handle_overflow(metadata.has_time_spec? metadata.time_spec : time_spec_t(0.0));
+                    curr_info.metadata = metadata;
+                    UHD_LOG_FASTPATH("O");
+                }
+                return;
+
+            case PACKET_TIMEOUT_ERROR:
+                std::swap(curr_info, next_info); //save progress from curr -> next
+                curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_TIMEOUT;
+                return;
+
+            case PACKET_SEQUENCE_ERROR:
+                curr_info.data_bytes_to_copy = info.ifpi.num_payload_bytes;
+                std::swap(curr_info, next_info); //save progress from curr -> next
+                curr_info.metadata.has_time_spec = prev_info.metadata.has_time_spec;
+                curr_info.metadata.time_spec = prev_info.metadata.time_spec + time_spec_t::from_ticks(
+                    prev_info[0].ifpi.num_payload_words32*sizeof(boost::uint32_t)/_bytes_per_otw_item, _samp_rate);
+                curr_info.metadata.out_of_sequence = true;
+                curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_OVERFLOW;
+                UHD_LOG_FASTPATH("D");
+                return;
+            }
+        }
+
+        //set the metadata from the buffer information
+        curr_info.metadata.has_time_spec = info.ifpi.has_tsf;
+        curr_info.metadata.time_spec = time_spec_t::from_ticks(info.ticks, _tick_rate);
+        curr_info.metadata.more_fragments = false;
+        curr_info.metadata.fragment_offset = 0;
+        curr_info.metadata.start_of_burst = info.ifpi.sob;
+        curr_info.metadata.end_of_burst = info.ifpi.eob;
+        curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_NONE;
+        if (info.filled) curr_info.metadata.out_of_sequence = true;
+        if (_rate_change_pending) this->take_rate_change(curr_info.metadata);
+    }
+
     /*******************************************************************
      * Receive a single packet:
      * Handles fragmentation, messages, errors, and copy-conversion.
@@ -621,6 +1236,10 @@ private:
         buffers_info_type &info = get_curr_buffer_info();
         metadata = info.metadata;
 
+        //a gap fill never shares a recv() call with real samples
+        if (buffer_offset_bytes != 0 and metadata.error_code == rx_metadata_t::ERROR_CODE_NONE
+            and metadata.out_of_sequence != _gap_run) return 0;
+
         //interpolate the time spec (useful when this is a fragment)
         metadata.time_spec += time_spec_t::from_ticks(info.fragment_offset_in_samps, _samp_rate);
 
@@ -637,7 +1256,12 @@ private:
         _convert_bytes_to_copy = bytes_to_copy;
 
         //perform N channels of conversion
-        for (size_t i = 0; i < this->size(); i++) this->converter_thread_task(i);
+        if (_convert_num_threads > 1){
+            _convert_barrier_start->wait();
+            this->converter_worker_task(0);
+            _convert_barrier_done->wait();
+        }
+        else for (size_t i = 0; i < this->size(); i++) this->converter_thread_task(i, *_converter);
 
         //update the copy buffer's availability
         info.data_bytes_to_copy -= bytes_to_copy;
@@ -655,7 +1279,7 @@ private:
      * The entry and exit use a dual synchronization barrier,
      * to wait for data to become ready and block until completion.
      ******************************************************************/
-    UHD_INLINE void converter_thread_task(const size_t index)
+    UHD_INLINE void converter_thread_task(const size_t index, uhd::convert::converter &converter)
     {
         //shortcut references to local data structures
         buffers_info_type &buff_info = get_curr_buffer_info();
@@ -671,23 +1295,87 @@ private:
         const ref_vector<void *> out_buffs(io_buffs, _num_outputs);
 
         //perform the conversion operation
-        _converter->conv(info.copy_buff, out_buffs, _convert_nsamps);
+        stream_stats_t *stats = _props[index].stats.get();
+        const stream_stats_t::clock_type::time_point start = (stats != NULL)?
+            stream_stats_t::clock_type::now() : stream_stats_t::clock_type::time_point();
+        if (_bfp) converter.set_scalar(_scale_factor*double(1 << info.exponent));
+        converter.conv(info.copy_buff, out_buffs, _convert_nsamps);
+        if (stats != NULL)
+        {
+            const boost::uint64_t ns = stream_stats_t::add_time(stats->convert_ns, start);
+            UMTRX_PROFILE_RECORD(stats, convert_latency, ns);
+        }
 
         //advance the pointer for the source buffer
         info.copy_buff += _convert_bytes_to_copy;
 
         //release the buffer if fully consumed
         if (buff_info.data_bytes_to_copy == _convert_bytes_to_copy){
+            if (_gap_fill == GAP_FILL_HOLD and _convert_bytes_to_copy != 0){
+                std::vector<char> &hold_item = _props[index].hold_item;
+                hold_item.resize(_bytes_per_otw_item);
+                std::memcpy(&hold_item.front(), info.copy_buff - _bytes_per_otw_item, _bytes_per_otw_item);
+                _props[index].hold_exponent = info.exponent;
+            }
             info.buff.reset(); //effectively a release
         }
     }
 
+    //! Convert every Nth channel starting at the worker's index
+    UHD_INLINE void converter_worker_task(const size_t worker)
+    {
+        uhd::convert::converter &converter = *_converters[worker];
+        for (size_t i = worker; i < this->size(); i += _convert_num_threads){
+            this->converter_thread_task(i, converter);
+        }
+    }
+
+    //! Worker thread body: wait on the start barrier, convert, signal done
+    void converter_worker_loop(const size_t worker, const int cpu, const int rt_priority)
+    {
+        if (cpu >= 0 and not uhd::set_thread_affinity(size_t(cpu))){
+            UHD_MSG(warning) << "recv_packet_handler: failed to set converter thread affinity" << std::endl;
+        }
+        if (rt_priority > 0 and not uhd::set_thread_rt_priority(rt_priority)){
+            UHD_MSG(warning) << "recv_packet_handler: failed to set converter thread priority" << std::endl;
+        }
+        if (cpu >= 0 or rt_priority > 0){
+            UHD_MSG(status) << "rx converter " << worker << ": " << uhd::get_thread_placement() << std::endl;
+        }
+        while (true){
+            _convert_barrier_start->wait();
+            if (_convert_exit) break;
+            this->converter_worker_task(worker);
+            _convert_barrier_done->wait();
+        }
+    }
+
+    //! Release the workers from the start barrier and join them
+    void stop_converter_threads(void)
+    {
+        if (_convert_num_threads > 1){
+            _convert_exit = true;
+            _convert_barrier_start->wait();
+            _convert_threads.join_all();
+        }
+        _convert_num_threads = 1;
+        _converters.clear();
+    }
+
     //! Shared variables for the worker threads
     size_t _convert_nsamps;
     const rx_streamer::buffs_type *_convert_buffs;
     size_t _convert_buffer_offset_bytes;
     size_t _convert_bytes_to_copy;
 
+    //! Converter worker pool state
+    size_t _convert_num_threads;
+    volatile bool _convert_exit;
+    std::vector<uhd::convert::converter::sptr> _converters;
+    boost::shared_ptr<boost::barrier> _convert_barrier_start;
+    boost::shared_ptr<boost::barrier> _convert_barrier_done;
+    boost::thread_group _convert_threads;
+
     /*
      * This last section is only for debugging purposes.
      * It causes a lot of prints to stderr which can be piped to a file.
@@ -749,12 +1437,19 @@ private:
 #endif
 };
 
-class recv_packet_streamer : public recv_packet_handler, public rx_streamer{
+class recv_packet_streamer : public recv_packet_handler, public rx_streamer,
+    public umtrx_rx_packet_streamer, public umtrx_rx_callback_streamer, public umtrx_rx_gain_events{
 public:
-    recv_packet_streamer(const size_t max_num_samps){
+    recv_packet_streamer(const size_t max_num_samps):
+        _dispatching(false), _dispatch_exit(false)
+    {
         _max_num_samps = max_num_samps;
     }
 
+    ~recv_packet_streamer(void){
+        this->stop();
+    }
+
     size_t get_num_channels(void) const{
         return this->size();
     }
@@ -770,6 +1465,7 @@ public:
         const double timeout,
         const bool one_packet
     ){
+        if (_dispatching) throw uhd::runtime_error("recv_packet_streamer: recv() while the callback dispatcher runs");
         return recv_packet_handler::recv(buffs, nsamps_per_buff, metadata, timeout, one_packet);
     }
 
@@ -778,8 +1474,126 @@ public:
         return recv_packet_handler::issue_stream_cmd(stream_cmd);
     }
 
+    size_t recv_packet(umtrx_rx_packet_streamer::packet_type &packet, const double timeout)
+    {
+        if (_dispatching) throw uhd::runtime_error("recv_packet_streamer: recv_packet() while the callback dispatcher runs");
+        return recv_packet_handler::recv_packet(packet, timeout);
+    }
+
+    size_t recv_many(
+        const std::vector<void *> &buffs, const size_t nsamps_per_buff,
+        std::vector<umtrx_rx_packet_streamer::batch_entry_type> &entries, const size_t max_packets,
+        const double timeout
+    ){
+        if (_dispatching) throw uhd::runtime_error("recv_packet_streamer: recv_many() while the callback dispatcher runs");
+        return recv_packet_handler::recv_many(buffs, nsamps_per_buff, entries, max_packets, timeout);
+    }
+
+    bool recv_gain_event(umtrx_rx_gain_events::event_type &event)
+    {
+        return recv_packet_handler::recv_gain_event(event);
+    }
+
+    void start(const callback_type &callback, const pool_type &pool, const int cpu)
+    {
+        if (pool.slots.empty() or pool.nsamps_per_slot == 0) throw uhd::value_error("recv_packet_streamer: empty callback buffer pool");
+        BOOST_FOREACH(const std::vector<void *> &slot, pool.slots)
+        {
+            if (slot.size() != this->size()) throw uhd::value_error("recv_packet_streamer: pool slots need one buffer per channel");
+        }
+        this->stop();
+        _callback = callback;
+        _pool = pool;
+        _held.assign(pool.slots.size(), false);
+        _dispatch_exit = false;
+        _dispatching = true;
+        _dispatch_thread.reset(new boost::thread(boost::bind(&recv_packet_streamer::dispatch_loop, this, cpu)));
+    }
+
+    void stop(void)
+    {
+        if (not _dispatch_thread) return;
+        {
+            boost::mutex::scoped_lock lock(_held_mutex);
+            _dispatch_exit = true;
+        }
+        _held_cond.notify_all();
+        _dispatch_thread->join();
+        _dispatch_thread.reset();
+        _dispatching = false;
+    }
+
+    void release(const size_t slot)
+    {
+        boost::mutex::scoped_lock lock(_held_mutex);
+        if (slot < _held.size()) _held[slot] = false;
+        lock.unlock();
+        _held_cond.notify_all();
+    }
+
 private:
+    //! Receive into the slots in turn, the callback runs right after each packet
+    void dispatch_loop(const int cpu)
+    {
+        if (cpu >= 0 and not uhd::set_thread_affinity(size_t(cpu))){
+            UHD_MSG(warning) << "recv_packet_streamer: failed to set dispatch thread affinity" << std::endl;
+        }
+        if (cpu >= 0){
+            UHD_MSG(status) << "rx dispatch: " << uhd::get_thread_placement() << std::endl;
+        }
+        group_type group;
+        group.slot = 0;
+        while (true)
+        {
+            //wait for the application to give the slot back
+            {
+                boost::mutex::scoped_lock lock(_held_mutex);
+                while (_held[group.slot] and not _dispatch_exit) _held_cond.wait(lock);
+                if (_dispatch_exit) break;
+            }
+
+            group.buffs = _pool.slots[group.slot];
+            group.nsamps = recv_packet_handler::recv(group.buffs, _pool.nsamps_per_slot, group.metadata, 0.1, true);
+            if (group.metadata.error_code == uhd::rx_metadata_t::ERROR_CODE_TIMEOUT) continue;
+
+            //held before the callback, another thread may release it before the callback returns
+            {
+                boost::mutex::scoped_lock lock(_held_mutex);
+                _held[group.slot] = true;
+            }
+            bool keep = false;
+            try
+            {
+                keep = _callback(group);
+            }
+            catch (const std::exception &ex)
+            {
+                UHD_MSG(error) << "recv_packet_streamer: the rx callback threw, dispatch stops: " << ex.what() << std::endl;
+                break;
+            }
+            //a slot handed back refills at once, still warm in the cache
+            if (not keep)
+            {
+                boost::mutex::scoped_lock lock(_held_mutex);
+                _held[group.slot] = false;
+                continue;
+            }
+            //kept, fill the next slot
+            group.slot = (group.slot + 1) % _held.size();
+        }
+    }
+
     size_t _max_num_samps;
+
+    //! Callback dispatch state
+    boost::atomic<bool> _dispatching;
+    boost::scoped_ptr<boost::thread> _dispatch_thread;
+    callback_type _callback;
+    pool_type _pool;
+    boost::mutex _held_mutex;
+    boost::condition_variable _held_cond;
+    std::vector<bool> _held;
+    bool _dispatch_exit;
 };
 
 }}} //namespace
@@ -23,14 +23,23 @@
 #include <uhd/convert.hpp>
 #include <uhd/stream.hpp>
 #include "umtrx_log_adapter.hpp"
+#include "umtrx_tx_packet_streamer.hpp"
+#include "stream_stats.hpp"
+#include "missing/platform.hpp"
 #include <uhd/utils/tasks.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/metadata.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
 #include <uhd/transport/zero_copy.hpp>
 #include <boost/thread/thread_time.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/foreach.hpp>
 #include <boost/function.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -61,18 +70,30 @@ public:
     typedef void(*vrt_packer_type)(boost::uint32_t *, vrt::if_packet_info_t &);
     //typedef boost::function<void(boost::uint32_t *, vrt::if_packet_info_t &)> vrt_packer_type;
 
+    //! A buffer getter the handler calls directly, see set_xport_chan_buff_source()
+    class buff_source{
+    public:
+        typedef boost::shared_ptr<buff_source> sptr;
+        virtual ~buff_source(void){}
+        virtual managed_send_buffer::sptr get_send_buff(const double timeout) = 0;
+    };
+
     /*!
      * Make a new packet handler for send
      * \param size the number of transport channels
      */
     send_packet_handler(const size_t size = 1):
-        _next_packet_seq(0), _cached_metadata(false)
+        _rate_change_pending(false), _rate_change_rate(0.0), _rate_change_scale(0.0),
+        _scale_factor(32767.), _next_packet_seq(0), _cached_metadata(false),
+        _burst_len(0), _burst_remaining(0), _burst_eob_sent(false), _zc_nsamps(0),
+        _convert_num_threads(1), _convert_exit(false)
     {
         this->set_enable_trailer(true);
         this->resize(size);
     }
 
     ~send_packet_handler(void){
+        this->stop_converter_threads();
     }
 
     //! Resize the number of transport channels
@@ -115,6 +136,19 @@ public:
         _samp_rate = rate;
     }
 
+    /*!
+     * Change the rate and the scale factor from the first send() stamped at
+     * or after the given time, for a DSP rate change timed then.
+     * Replaces a change that is still pending.
+     */
+    void set_samp_rate_at(const time_spec_t &time, const double rate, const double scale_factor){
+        boost::mutex::scoped_lock lock(_rate_change_mutex);
+        _rate_change_time = time;
+        _rate_change_rate = rate;
+        _rate_change_scale = scale_factor;
+        _rate_change_pending = true;
+    }
+
     /*!
      * Set the function to get a managed buffer.
      * \param xport_chan which transport channel
@@ -122,12 +156,35 @@ public:
      */
     void set_xport_chan_get_buff(const size_t xport_chan, const get_buff_type &get_buff){
         _props.at(xport_chan).get_buff = get_buff;
+        _props.at(xport_chan).source.reset();
+    }
+
+    /*!
+     * Get the buffers from a source object, the per packet call is then one
+     * virtual call instead of a boost::function around a bind.
+     * \param xport_chan which transport channel
+     * \param source the buffer source, owned by the handler from now on
+     */
+    void set_xport_chan_buff_source(const size_t xport_chan, const buff_source::sptr &source){
+        _props.at(xport_chan).source = source;
+        _props.at(xport_chan).get_buff = get_buff_type();
+    }
+
+    //! Set the counters of a transport channel (optional)
+    void set_xport_chan_stats(const size_t xport_chan, const stream_stats_t::sptr &stats){
+        _props.at(xport_chan).stats = stats;
     }
 
     //! Set the conversion routine for all channels
     void set_converter(const uhd::convert::id_type &id){
         _num_inputs = id.num_inputs;
+        _converter_id = id;
         _converter = uhd::convert::get_converter(id)();
+        //each worker thread owns a private converter instance
+        for (size_t i = 1; i < _converters.size(); i++){
+            _converters[i] = uhd::convert::get_converter(id)();
+        }
+        if (not _converters.empty()) _converters[0] = _converter;
         this->set_scale_factor(32767.); //update after setting converter
         _bytes_per_otw_item = uhd::convert::get_bytes_per_item(id.output_format);
         _bytes_per_cpu_item = uhd::convert::get_bytes_per_item(id.input_format);
@@ -144,7 +201,61 @@ public:
 
     //! Set the scale factor used in float conversion
     void set_scale_factor(const double scale_factor){
+        _scale_factor = scale_factor;
         _converter->set_scalar(scale_factor);
+        for (size_t i = 1; i < _converters.size(); i++){
+            _converters[i]->set_scalar(scale_factor);
+        }
+    }
+
+    /*!
+     * Spread the conversion and commit of the channels across threads.
+     * The calling thread converts its own share of the channels,
+     * num_threads-1 workers are spawned to convert the remainder.
+     * Must be called after set_converter().
+     * \param num_threads total number of converting threads (0 or 1 disables)
+     * \param cpus pin worker i to cpus[i-1], workers past the end are not pinned
+     * \param rt_priority SCHED_FIFO priority of the workers (0 keeps the default)
+     */
+    void set_converter_threads(const size_t num_threads, const std::vector<int> &cpus = std::vector<int>(), const int rt_priority = 0)
+    {
+        this->stop_converter_threads();
+        _convert_num_threads = std::max<size_t>(1, std::min(num_threads, this->size()));
+        if (_convert_num_threads == 1) return;
+
+        _converters.resize(_convert_num_threads);
+        _converters[0] = _converter;
+        for (size_t i = 1; i < _converters.size(); i++){
+            _converters[i] = uhd::convert::get_converter(_converter_id)();
+            _converters[i]->set_scalar(_scale_factor);
+        }
+
+        _convert_exit = false;
+        _convert_barrier_start.reset(new boost::barrier(_convert_num_threads));
+        _convert_barrier_done.reset(new boost::barrier(_convert_num_threads));
+        for (size_t i = 1; i < _convert_num_threads; i++){
+            const int cpu = (i-1 < cpus.size())? cpus[i-1] : -1;
+            _convert_threads.create_thread(boost::bind(
+                &send_packet_handler::converter_worker_loop, this, i, cpu, rt_priority));
+        }
+    }
+
+    /*!
+     * Run every converter once on a zeroed packet, so that the tables a
+     * converter builds on first use and the scratch buffers are in place
+     * before the first real packet. Call after set_converter_threads().
+     * \param nsamps samples per packet
+     */
+    void warm_up(const size_t nsamps)
+    {
+        if (nsamps == 0) return;
+        std::vector<std::vector<char> > cpu(_num_inputs, std::vector<char>(nsamps*_bytes_per_cpu_item, 0));
+        std::vector<const void *> in(_num_inputs);
+        for (size_t i = 0; i < _num_inputs; i++) in[i] = &cpu[i].front();
+        const ref_vector<const void *> in_buffs(in);
+        std::vector<char> otw(nsamps*_bytes_per_otw_item + sizeof(boost::uint32_t)); //room for a partly filled last item32
+        _converter->conv(in_buffs, &otw.front(), nsamps);
+        for (size_t i = 1; i < _converters.size(); i++) _converters[i]->conv(in_buffs, &otw.front(), nsamps);
     }
 
     //! Set the callback to get async messages
@@ -162,10 +273,23 @@ public:
         return false;
     }
 
+    /*!
+     * Declare the length of the bursts ahead, ex: 156 samples for GSM.
+     * The packet that completes a burst after its start of burst carries
+     * the end of burst, the end of burst call without samples that follows
+     * sends nothing: one packet less per burst.
+     * \param num_samps samples per burst, 0 sends the end of burst as given
+     */
+    void set_burst_length(const size_t num_samps){
+        _burst_len = num_samps;
+        _burst_remaining = 0;
+        _burst_eob_sent = false;
+    }
+
     /*******************************************************************
      * Send:
      * The entry point for the fast-path send calls.
-     * Dispatch into combinations of single packet send calls.
+     * Flag the end of a declared burst, see set_burst_length().
      ******************************************************************/
     UHD_INLINE size_t send(
         const uhd::tx_streamer::buffs_type &buffs,
@@ -173,17 +297,146 @@ public:
         const uhd::tx_metadata_t &metadata,
         const double timeout
     ){
-        //translate the metadata to vrt if packet info
+        if (_burst_len == 0 or nsamps_per_buff == 0){
+            //the end of burst went out with the last packet of the burst
+            const bool eob_sent = _burst_eob_sent;
+            _burst_eob_sent = false;
+            if (eob_sent and metadata.end_of_burst and not metadata.start_of_burst) return 0;
+            return this->send_packets(buffs, nsamps_per_buff, metadata, timeout);
+        }
+
+        if (metadata.start_of_burst or (_cached_metadata and _metadata_cache.start_of_burst)){
+            _burst_remaining = _burst_len;
+        }
+        uhd::tx_metadata_t burst_metadata = metadata;
+        const bool last = _burst_remaining != 0 and nsamps_per_buff >= _burst_remaining;
+        if (last) burst_metadata.end_of_burst = true;
+
+        const size_t nsamps_sent = this->send_packets(buffs, nsamps_per_buff, burst_metadata, timeout);
+        _burst_remaining -= std::min(_burst_remaining, nsamps_sent);
+        _burst_eob_sent = last and nsamps_sent == nsamps_per_buff and not metadata.end_of_burst;
+        return nsamps_sent;
+    }
+
+    /*******************************************************************
+     * Zero copy send, see umtrx_tx_packet_streamer:
+     * Take the frame of a channel and hand out its payload,
+     * the header room is that of a timed packet.
+     ******************************************************************/
+    UHD_INLINE void *get_tx_buffer(const size_t chan, const size_t nsamps, const double timeout){
+        if (nsamps == 0 or nsamps > _max_samples_per_packet){
+            throw uhd::value_error("send_packet_handler: get_tx_buffer takes 1 to get_max_num_samps() samples");
+        }
+        if (_zc_nsamps != 0 and nsamps != _zc_nsamps){
+            throw uhd::value_error("send_packet_handler: every channel of a packet takes the same number of samples");
+        }
+        xport_chan_props_type &props = _props.at(chan);
+        if (not props.buff){
+            UMTRX_PROFILE_START(get_buff_start);
+            props.buff = props.source? props.source->get_send_buff(timeout) : props.get_buff(timeout);
+            UMTRX_PROFILE_STOP(props.stats, get_buff_latency, get_buff_start);
+            if (not props.buff) return NULL; //timeout
+        }
+
+        vrt::if_packet_info_t if_packet_info = this->make_if_packet_info(true, false, false);
+        if_packet_info.has_sid = props.has_sid;
+        if_packet_info.sid = props.sid;
+        props.zc_header_words32 = this->header_words32(if_packet_info);
+        _zc_nsamps = nsamps;
+        return props.buff->cast<boost::uint32_t *>() + _header_offset_words32 + props.zc_header_words32;
+    }
+
+    //! Pack the headers of the taken frames and send them
+    UHD_INLINE size_t commit(const uhd::tx_metadata_t &metadata){
+        BOOST_FOREACH(const xport_chan_props_type &props, _props){
+            if (_zc_nsamps == 0 or props.zc_header_words32 == 0 or not props.buff){
+                throw uhd::runtime_error("send_packet_handler: commit before get_tx_buffer of every channel");
+            }
+        }
+        if (_rate_change_pending and metadata.has_time_spec) this->take_rate_change(metadata.time_spec);
+
+        vrt::if_packet_info_t if_packet_info = this->make_if_packet_info(
+            metadata.has_time_spec, metadata.start_of_burst, metadata.end_of_burst);
+        if_packet_info.tsf = metadata.time_spec.to_ticks(_tick_rate);
+        if_packet_info.num_payload_bytes = _zc_nsamps*_num_inputs*_bytes_per_otw_item;
+        if_packet_info.num_payload_words32 = (if_packet_info.num_payload_bytes + 3/*round up*/)/sizeof(boost::uint32_t);
+        if_packet_info.packet_count = _next_packet_seq;
+
+        BOOST_FOREACH(xport_chan_props_type &props, _props){
+            boost::uint32_t *otw_mem = props.buff->cast<boost::uint32_t *>() + _header_offset_words32;
+            if_packet_info.has_sid = props.has_sid;
+            if_packet_info.sid = props.sid;
+
+            //an untimed header is shorter than the room, the payload moves up to it
+            const size_t num_header_words32 = this->header_words32(if_packet_info);
+            if (num_header_words32 != props.zc_header_words32){
+                std::memmove(otw_mem + num_header_words32, otw_mem + props.zc_header_words32,
+                    if_packet_info.num_payload_words32*sizeof(boost::uint32_t));
+            }
+            _vrt_packer(otw_mem, if_packet_info);
+
+            const size_t num_vita_words32 = _header_offset_words32+if_packet_info.num_packet_words32;
+            props.buff->commit(num_vita_words32*sizeof(boost::uint32_t));
+            if (props.stats){
+                stream_stats_t::add(props.stats->packets);
+                stream_stats_t::add(props.stats->bytes, num_vita_words32*sizeof(boost::uint32_t));
+            }
+            props.buff.reset(); //effectively a release
+            props.zc_header_words32 = 0;
+        }
+
+        const size_t nsamps_sent = _zc_nsamps;
+        _zc_nsamps = 0;
+        _burst_eob_sent = false;
+        _next_packet_seq++;
+        return nsamps_sent;
+    }
+
+private:
+    //! The data packet fields every packet of the streamer shares
+    UHD_INLINE vrt::if_packet_info_t make_if_packet_info(const bool has_tsf, const bool sob, const bool eob){
         vrt::if_packet_info_t if_packet_info;
         if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
-        //if_packet_info.has_sid = false; //set per channel
         if_packet_info.has_cid = false;
         if_packet_info.has_tlr = _has_tlr;
         if_packet_info.has_tsi = false;
-        if_packet_info.has_tsf = metadata.has_time_spec;
+        if_packet_info.has_tsf = has_tsf;
+        if_packet_info.tsf = 0;
+        if_packet_info.sob = sob;
+        if_packet_info.eob = eob;
+        if_packet_info.num_payload_bytes = 0;
+        if_packet_info.num_payload_words32 = 0;
+        if_packet_info.packet_count = 0;
+        return if_packet_info;
+    }
+
+    //! Header words of a packet, packed into scratch memory without the trailer
+    UHD_INLINE size_t header_words32(const vrt::if_packet_info_t &if_packet_info){
+        vrt::if_packet_info_t probe = if_packet_info;
+        probe.has_tlr = false;
+        probe.num_payload_words32 = 0;
+        boost::uint32_t scratch[vrt::max_if_hdr_words32];
+        _vrt_packer(scratch, probe);
+        return probe.num_header_words32;
+    }
+
+    /*******************************************************************
+     * Send packets:
+     * Dispatch into combinations of single packet send calls.
+     ******************************************************************/
+    UHD_INLINE size_t send_packets(
+        const uhd::tx_streamer::buffs_type &buffs,
+        const size_t nsamps_per_buff,
+        const uhd::tx_metadata_t &metadata,
+        const double timeout
+    ){
+        if (_rate_change_pending and metadata.has_time_spec) this->take_rate_change(metadata.time_spec);
+
+        //translate the metadata to vrt if packet info
+        vrt::if_packet_info_t if_packet_info = this->make_if_packet_info(
+            metadata.has_time_spec, metadata.start_of_burst, metadata.end_of_burst);
+        //if_packet_info.has_sid = false; //set per channel
         if_packet_info.tsf     = metadata.time_spec.to_ticks(_tick_rate);
-        if_packet_info.sob     = metadata.start_of_burst;
-        if_packet_info.eob     = metadata.end_of_burst;
 
         /*
          * Metadata is cached when we get a send requesting a start of burst with no samples.
@@ -198,7 +451,7 @@ public:
                 if_packet_info.tsf     = _metadata_cache.time_spec.to_ticks(_tick_rate);
             }
             if_packet_info.sob     = _metadata_cache.start_of_burst;
-            if_packet_info.eob     = _metadata_cache.end_of_burst;
+            if_packet_info.eob     = _metadata_cache.end_of_burst or metadata.end_of_burst;
             _cached_metadata = false;
         }
 
@@ -234,6 +487,7 @@ public:
 
         //false until final fragment
         if_packet_info.eob = false;
+        const boost::uint64_t first_tsf = if_packet_info.tsf; //the fragments follow in whole ticks
 
         const size_t num_fragments = (nsamps_per_buff-1)/_max_samples_per_packet;
         const size_t final_length = ((nsamps_per_buff-1)%_max_samples_per_packet)+1;
@@ -251,8 +505,7 @@ public:
             if (num_samps_sent == 0) return total_num_samps_sent;
 
             //setup metadata for the next fragment
-            const time_spec_t time_spec = metadata.time_spec + time_spec_t::from_ticks(total_num_samps_sent, _samp_rate);
-            if_packet_info.tsf = time_spec.to_ticks(_tick_rate);
+            if_packet_info.tsf = first_tsf + boost::uint64_t(total_num_samps_sent*_tick_rate/_samp_rate + 0.5);
             if_packet_info.sob = false;
 
         }
@@ -269,23 +522,41 @@ public:
 		return nsamps_sent;
     }
 
-private:
-
     vrt_packer_type _vrt_packer;
     size_t _header_offset_words32;
     double _tick_rate, _samp_rate;
+
+    //timed rate change, see set_samp_rate_at(), taken in the send thread
+    boost::mutex _rate_change_mutex;
+    boost::atomic<bool> _rate_change_pending;
+    time_spec_t _rate_change_time;
+    double _rate_change_rate, _rate_change_scale;
+
+    UHD_INLINE void take_rate_change(const time_spec_t &time){
+        boost::mutex::scoped_lock lock(_rate_change_mutex);
+        if (not _rate_change_pending or time < _rate_change_time) return;
+        _rate_change_pending = false;
+        _samp_rate = _rate_change_rate;
+        this->set_scale_factor(_rate_change_scale);
+    }
+
     struct xport_chan_props_type{
-        xport_chan_props_type(void):has_sid(false),sid(0){}
+        xport_chan_props_type(void):has_sid(false),sid(0),zc_header_words32(0){}
         get_buff_type get_buff;
+        buff_source::sptr source; //used instead of get_buff when set
         bool has_sid;
         boost::uint32_t sid;
         managed_send_buffer::sptr buff;
+        stream_stats_t::sptr stats;
+        size_t zc_header_words32; //header room of the payload get_tx_buffer handed out, 0 when none
     };
     std::vector<xport_chan_props_type> _props;
     size_t _num_inputs;
     size_t _bytes_per_otw_item; //used in conversion
     size_t _bytes_per_cpu_item; //used in conversion
     uhd::convert::converter::sptr _converter; //used in conversion
+    uhd::convert::id_type _converter_id; //used to make worker converters
+    double _scale_factor; //applied to worker converters
     size_t _max_samples_per_packet;
     std::vector<const void *> _zero_buffs;
     size_t _next_packet_seq;
@@ -293,6 +564,10 @@ private:
     async_receiver_type _async_receiver;
     bool _cached_metadata;
     uhd::tx_metadata_t _metadata_cache;
+    size_t _burst_len; //declared samples per burst, 0 when not declared
+    size_t _burst_remaining; //samples left in the current burst
+    bool _burst_eob_sent; //the last packet carried the end of burst
+    size_t _zc_nsamps; //samples of the packet get_tx_buffer handed out, 0 when none
 
 #ifdef UHD_TXRX_DEBUG_PRINTS
     struct dbg_send_stat_t {
@@ -357,7 +632,10 @@ private:
 
         //get a buffer for each channel or timeout
         BOOST_FOREACH(xport_chan_props_type &props, _props){
-            if (not props.buff) props.buff = props.get_buff(timeout);
+            if (props.buff) continue;
+            UMTRX_PROFILE_START(get_buff_start);
+            props.buff = props.source? props.source->get_send_buff(timeout) : props.get_buff(timeout);
+            UMTRX_PROFILE_STOP(props.stats, get_buff_latency, get_buff_start);
             if (not props.buff) return 0; //timeout
         }
 
@@ -368,7 +646,12 @@ private:
         _convert_if_packet_info = &if_packet_info;
 
         //perform N channels of conversion
-        for (size_t i = 0; i < this->size(); i++) this->converter_thread_task(i);
+        if (_convert_num_threads > 1){
+            _convert_barrier_start->wait();
+            this->converter_worker_task(0);
+            _convert_barrier_done->wait();
+        }
+        else for (size_t i = 0; i < this->size(); i++) this->converter_thread_task(i, *_converter);
 
         _next_packet_seq++; //increment sequence after commits
         return nsamps_per_buff;
@@ -379,7 +662,7 @@ private:
      * The entry and exit use a dual synchronization barrier,
      * to wait for data to become ready and block until completion.
      ******************************************************************/
-    UHD_INLINE void converter_thread_task(const size_t index)
+    UHD_INLINE void converter_thread_task(const size_t index, uhd::convert::converter &converter)
     {
         //shortcut references to local data structures
         managed_send_buffer::sptr &buff = _props[index].buff;
@@ -398,27 +681,92 @@ private:
         boost::uint32_t *otw_mem = buff->cast<boost::uint32_t *>() + _header_offset_words32;
         if_packet_info.has_sid = _props[index].has_sid;
         if_packet_info.sid = _props[index].sid;
+        stream_stats_t *stats = _props[index].stats.get();
+        UMTRX_PROFILE_START(vrt_start);
         _vrt_packer(otw_mem, if_packet_info);
+        UMTRX_PROFILE_STOP(stats, vrt_latency, vrt_start);
         otw_mem += if_packet_info.num_header_words32;
 
         //perform the conversion operation
-        _converter->conv(in_buffs, otw_mem, _convert_nsamps);
+        const stream_stats_t::clock_type::time_point start = (stats != NULL)?
+            stream_stats_t::clock_type::now() : stream_stats_t::clock_type::time_point();
+        converter.conv(in_buffs, otw_mem, _convert_nsamps);
+        if (stats != NULL)
+        {
+            const boost::uint64_t ns = stream_stats_t::add_time(stats->convert_ns, start);
+            UMTRX_PROFILE_RECORD(stats, convert_latency, ns);
+        }
 
         //commit the samples to the zero-copy interface
         const size_t num_vita_words32 = _header_offset_words32+if_packet_info.num_packet_words32;
         buff->commit(num_vita_words32*sizeof(boost::uint32_t));
+        if (stats != NULL)
+        {
+            stream_stats_t::add(stats->packets);
+            stream_stats_t::add(stats->bytes, num_vita_words32*sizeof(boost::uint32_t));
+        }
         buff.reset(); //effectively a release
     }
 
+    //! Convert every Nth channel starting at the worker's index
+    UHD_INLINE void converter_worker_task(const size_t worker)
+    {
+        uhd::convert::converter &converter = *_converters[worker];
+        for (size_t i = worker; i < this->size(); i += _convert_num_threads){
+            this->converter_thread_task(i, converter);
+        }
+    }
+
+    //! Worker thread body: wait on the start barrier, convert, signal done
+    void converter_worker_loop(const size_t worker, const int cpu, const int rt_priority)
+    {
+        if (cpu >= 0 and not uhd::set_thread_affinity(size_t(cpu))){
+            UHD_MSG(warning) << "send_packet_handler: failed to set converter thread affinity" << std::endl;
+        }
+        if (rt_priority > 0 and not uhd::set_thread_rt_priority(rt_priority)){
+            UHD_MSG(warning) << "send_packet_handler: failed to set converter thread priority" << std::endl;
+        }
+        if (cpu >= 0 or rt_priority > 0){
+            UHD_MSG(status) << "tx converter " << worker << ": " << uhd::get_thread_placement() << std::endl;
+        }
+        while (true){
+            _convert_barrier_start->wait();
+            if (_convert_exit) break;
+            this->converter_worker_task(worker);
+            _convert_barrier_done->wait();
+        }
+    }
+
+    //! Release the workers from the start barrier and join them
+    void stop_converter_threads(void)
+    {
+        if (_convert_num_threads > 1){
+            _convert_exit = true;
+            _convert_barrier_start->wait();
+            _convert_threads.join_all();
+        }
+        _convert_num_threads = 1;
+        _converters.clear();
+    }
+
     //! Shared variables for the worker threads
     size_t _convert_nsamps;
     const tx_streamer::buffs_type *_convert_buffs;
     size_t _convert_buffer_offset_bytes;
     vrt::if_packet_info_t *_convert_if_packet_info;
 
+    //! Converter worker pool state
+    size_t _convert_num_threads;
+    volatile bool _convert_exit;
+    std::vector<uhd::convert::converter::sptr> _converters;
+    boost::shared_ptr<boost::barrier> _convert_barrier_start;
+    boost::shared_ptr<boost::barrier> _convert_barrier_done;
+    boost::thread_group _convert_threads;
+
 };
 
-class send_packet_streamer : public send_packet_handler, public tx_streamer{
+class send_packet_streamer : public send_packet_handler, public tx_streamer,
+    public umtrx_tx_packet_streamer{
 public:
     send_packet_streamer(const size_t max_num_samps){
         _max_num_samps = max_num_samps;
@@ -448,6 +796,14 @@ public:
         return send_packet_handler::recv_async_msg(async_metadata, timeout);
     }
 
+    void *get_tx_buffer(const size_t chan, const size_t nsamps, const double timeout){
+        return send_packet_handler::get_tx_buffer(chan, nsamps, timeout);
+    }
+
+    size_t commit(const uhd::tx_metadata_t &metadata){
+        return send_packet_handler::commit(metadata);
+    }
+
 private:
     size_t _max_num_samps;
 };
@@ -16,9 +16,11 @@
 //
 
 #include "time64_core_200.hpp"
+#include "umtrx_fifo_ctrl.hpp"
 #include <uhd/exception.hpp>
 #include <uhd/utils/assert_has.hpp>
 #include <boost/math/special_functions/round.hpp>
+#include <boost/thread/mutex.hpp>
 
 #define REG_TIME64_TICKS_HI    _base + 0
 #define REG_TIME64_TICKS_LO    _base + 4
@@ -47,6 +49,7 @@ public:
         const size_t mimo_delay_cycles
     ):
         _iface(iface), _base(base),
+        _fifo_ctrl(UMTRX_UHD_PTR_NAMESPACE::dynamic_pointer_cast<umtrx_fifo_ctrl>(iface)),
         _readback_bases(readback_bases),
         _tick_rate(0.0),
         _mimo_delay_cycles(mimo_delay_cycles)
@@ -66,25 +69,19 @@ public:
     }
 
     uhd::time_spec_t get_time_now(void){
-        for (size_t i = 0; i < 3; i++){ //special algorithm because we cant read 64 bits synchronously
-            const boost::uint32_t ticks_hi = _iface->peek32(_readback_bases.rb_hi_now);
-            const boost::uint32_t ticks_lo = _iface->peek32(_readback_bases.rb_lo_now);
-            if (ticks_hi != _iface->peek32(_readback_bases.rb_hi_now)) continue;
-            const boost::uint64_t ticks = (boost::uint64_t(ticks_hi) << 32) | ticks_lo;
-            return time_spec_t::from_ticks(ticks, _tick_rate);
+        if (_readback_bases.rb_hi_snapshot != 0){
+            return time_spec_t::from_ticks(this->peek_snapshot(_readback_bases.rb_lo_now), _tick_rate);
         }
-        throw uhd::runtime_error("time64_core_200: get time now timeout");
+        return time_spec_t::from_ticks(this->peek_hi_lo_hi(
+            _readback_bases.rb_hi_now, _readback_bases.rb_lo_now, "get time now timeout"), _tick_rate);
     }
 
     uhd::time_spec_t get_time_last_pps(void){
-        for (size_t i = 0; i < 3; i++){ //special algorithm because we cant read 64 bits synchronously
-            const boost::uint32_t ticks_hi = _iface->peek32(_readback_bases.rb_hi_pps);
-            const boost::uint32_t ticks_lo = _iface->peek32(_readback_bases.rb_lo_pps);
-            if (ticks_hi != _iface->peek32(_readback_bases.rb_hi_pps)) continue;
-            const boost::uint64_t ticks = (boost::uint64_t(ticks_hi) << 32) | ticks_lo;
-            return time_spec_t::from_ticks(ticks, _tick_rate);
+        if (_readback_bases.rb_hi_snapshot != 0){
+            return time_spec_t::from_ticks(this->peek_snapshot(_readback_bases.rb_lo_pps), _tick_rate);
         }
-        throw uhd::runtime_error("time64_core_200: get time last pps timeout");
+        return time_spec_t::from_ticks(this->peek_hi_lo_hi(
+            _readback_bases.rb_hi_pps, _readback_bases.rb_lo_pps, "get time last pps timeout"), _tick_rate);
     }
 
     void set_time_now(const uhd::time_spec_t &time){
@@ -126,8 +123,47 @@ public:
     }
 
 private:
+    //! Peek a lo word then the hi word the FPGA latched with it
+    boost::uint64_t peek_snapshot(const size_t rb_lo){
+        boost::uint32_t ticks_hi, ticks_lo;
+        if (_fifo_ctrl){
+            //one round trip, no other peek of the controller in between
+            std::vector<wb_iface::wb_addr_type> addrs(2);
+            addrs[0] = rb_lo;
+            addrs[1] = _readback_bases.rb_hi_snapshot;
+            const std::vector<boost::uint32_t> words = _fifo_ctrl->peek32_multi(addrs);
+            ticks_lo = words[0];
+            ticks_hi = words[1];
+        }
+        else{
+            //any other lo peek in between would replace the snapshot
+            boost::mutex::scoped_lock lock(_snapshot_mutex);
+            ticks_lo = _iface->peek32(rb_lo);
+            ticks_hi = _iface->peek32(_readback_bases.rb_hi_snapshot);
+        }
+        return (boost::uint64_t(ticks_hi) << 32) | ticks_lo;
+    }
+
+    //! Without the snapshot: hi, lo, hi again until the hi words agree
+    boost::uint64_t peek_hi_lo_hi(const size_t rb_hi, const size_t rb_lo, const char *what){
+        std::vector<wb_iface::wb_addr_type> addrs(3);
+        addrs[0] = rb_hi;
+        addrs[1] = rb_lo;
+        addrs[2] = rb_hi;
+        for (size_t i = 0; i < 3; i++){ //special algorithm because we cant read 64 bits synchronously
+            std::vector<boost::uint32_t> words(3);
+            if (_fifo_ctrl) words = _fifo_ctrl->peek32_multi(addrs);
+            else for (size_t j = 0; j < addrs.size(); j++) words[j] = _iface->peek32(addrs[j]);
+            if (words[0] != words[2]) continue;
+            return (boost::uint64_t(words[0]) << 32) | words[1];
+        }
+        throw uhd::runtime_error(std::string("time64_core_200: ") + what);
+    }
+
     wb_iface::sptr _iface;
     const size_t _base;
+    const umtrx_fifo_ctrl::sptr _fifo_ctrl; //null when iface is not a fifo ctrl
+    boost::mutex _snapshot_mutex;
     const readback_bases_type _readback_bases;
     double _tick_rate;
     const size_t _mimo_delay_cycles;
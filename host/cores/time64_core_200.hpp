@@ -33,6 +33,7 @@ public:
     struct readback_bases_type{
         size_t rb_hi_now, rb_lo_now;
         size_t rb_hi_pps, rb_lo_pps;
+        size_t rb_hi_snapshot; //hi word latched by a lo peek, 0 when the FPGA has none
     };
 
     //! makes a new time64 core from iface and slave base
@@ -21,26 +21,56 @@
 #include "umtrx_log_adapter.hpp"
 #include <uhd/utils/algorithm.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/format.hpp>
 #include <boost/math/special_functions/round.hpp>
 #include <boost/math/special_functions/sign.hpp>
+#include <boost/math/special_functions/erf.hpp>
 #include <boost/thread/thread.hpp> //sleep
 #include <algorithm>
 #include <cmath>
+#include <functional>
+#include <vector>
 
 #define REG_DSP_TX_FREQ          _dsp_base + 0
 #define REG_DSP_TX_SCALE_IQ      _dsp_base + 4
 #define REG_DSP_TX_INTERP        _dsp_base + 8
+#define REG_DSP_TX_HOP           _dsp_base + 20 //4 regs
 
 #define REG_TX_CTRL_CLEAR           _ctrl_base + 0
 #define REG_TX_CTRL_FORMAT          _ctrl_base + 4
+#define FLAG_CTRL_FORMAT_LE         (1 << 1)
 #define REG_TX_CTRL_REPORT_SID      _ctrl_base + 8
 #define REG_TX_CTRL_POLICY          _ctrl_base + 12
 #define REG_TX_CTRL_CYCLES_PER_UP   _ctrl_base + 16
 #define REG_TX_CTRL_PACKETS_PER_UP  _ctrl_base + 20
+#define REG_TX_CTRL_IDLE_SAMPLE     _ctrl_base + 24
+
+#define REG_TX_MOD_MODE             _mod_base + 0
+#define REG_TX_MOD_STEP             _mod_base + 4
+
+#define FLAG_TX_MOD_DIFF_ENCODE     (0x1 << 8)
+
+#define REG_TX_RAMP_GAIN            _ramp_base + 0
+#define REG_TX_RAMP_LEN             _ramp_base + 4
+
+//entries of the ramp table, a gain of 65535 is unity
+static const size_t TX_RAMP_MAX_LEN = 64;
+
+//table of the modulator: the last three symbols by the sample in the symbol
+static const size_t GMSK_MAX_SPS = 16;
+
+//the modulator CORDIC needs this many clocks per sample
+static const size_t GMSK_MIN_INTERP = 24;
+
+//interpolation field of the CIC
+static const size_t MAX_CIC_RATE = 128;
 
 #define FLAG_TX_CTRL_POLICY_WAIT          (0x1 << 0)
 #define FLAG_TX_CTRL_POLICY_NEXT_PACKET   (0x1 << 1)
 #define FLAG_TX_CTRL_POLICY_NEXT_BURST    (0x1 << 2)
+#define FLAG_TX_CTRL_POLICY_IDLE_FILL     (0x1 << 3)
+#define FLAG_TX_CTRL_POLICY_NO_SEQ_CHECK  (0x1 << 4)
+#define FLAG_TX_CTRL_POLICY_LATE_SHIFT    5 //[6:5] late packets: 0 by policy, 1 drop burst, 2 send now, 3 drop packet
 
 //enable flag for registers: cycles and packets per update packet
 #define FLAG_TX_CTRL_UP_ENB              (1ul << 31)
@@ -49,6 +79,30 @@ template <class T> T ceil_log2(T num){
     return std::ceil(std::log(num)/std::log(T(2)));
 }
 
+/*!
+ * Phase of the gaussian frequency pulse of a symbol, per sample of its
+ * three symbol span, in fractions of the pi/2 a symbol turns the phase.
+ */
+static std::vector<double> gmsk_pulse_area(const size_t sps, const double bt)
+{
+    static const size_t SUBSTEPS = 16;
+    const double c = 2*M_PI*bt/std::sqrt(std::log(2.0))/std::sqrt(2.0);
+    std::vector<double> area(3*sps, 0.0);
+    double total = 0.0;
+    for (size_t n = 0; n < area.size(); n++)
+    {
+        for (size_t s = 0; s < SUBSTEPS; s++)
+        {
+            //symbol periods from the pulse center
+            const double t = (n + (s + 0.5)/SUBSTEPS)/sps - 1.5;
+            area[n] += boost::math::erfc(c*(t - 0.5)) - boost::math::erfc(c*(t + 0.5));
+        }
+        total += area[n];
+    }
+    for (size_t n = 0; n < area.size(); n++) area[n] /= total;
+    return area;
+}
+
 using namespace uhd;
 
 class tx_dsp_core_200_impl : public tx_dsp_core_200{
@@ -56,80 +110,134 @@ public:
     tx_dsp_core_200_impl(
         wb_iface::sptr iface,
         const size_t dsp_base, const size_t ctrl_base,
-        const boost::uint32_t sid
+        const boost::uint32_t sid, const size_t mod_base, const size_t ramp_base, const bool hold_clear
     ):
-        _iface(iface), _dsp_base(dsp_base), _ctrl_base(ctrl_base), _sid(sid)
+        _iface(iface), _dsp_base(dsp_base), _ctrl_base(ctrl_base), _mod_base(mod_base), _ramp_base(ramp_base), _sid(sid)
     {
         // previously uninitialized - assuming zero for all
-        _tick_rate = _link_rate = _host_extra_scaling = _fxpt_scalar_correction = 0.0;
+        _tick_rate = _vita_rate = _link_rate = _host_extra_scaling = _fxpt_scalar_correction = 0.0;
+        _host_rate = 0.0;
+        _wire_bytes = 4; //sc16
+        _policy = 0;
+        _late_policy = 0;
+        _idle_fill = false;
+        _loop = false;
+        _gmsk = false;
+        _low_latency = false;
+        _cic_rate = 1;
+        _hb0 = _hb1 = 0;
 
         //init to something so update method has reasonable defaults
         _scaling_adjustment = 1.0;
         _dsp_extra_scaling = 1.0;
 
         //init the tx control registers
-        this->clear();
+        if (hold_clear) this->begin_clear();
+        else this->clear();
         this->set_underflow_policy("next_packet");
     }
 
     void clear(void){
-        _iface->poke32(REG_TX_CTRL_CLEAR, 1); //reset and flush technique
+        this->begin_clear();
         boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+        this->end_clear();
+    }
+
+    void begin_clear(void){
+        _iface->poke32(REG_TX_CTRL_CLEAR, 1); //reset and flush technique
+    }
+
+    void end_clear(void){
         _iface->poke32(REG_TX_CTRL_CLEAR, 0);
         _iface->poke32(REG_TX_CTRL_REPORT_SID, _sid);
     }
 
     void set_underflow_policy(const std::string &policy){
         if (policy == "next_packet"){
-            _iface->poke32(REG_TX_CTRL_POLICY, FLAG_TX_CTRL_POLICY_NEXT_PACKET);
+            _policy = FLAG_TX_CTRL_POLICY_NEXT_PACKET;
         }
         else if (policy == "next_burst"){
-            _iface->poke32(REG_TX_CTRL_POLICY, FLAG_TX_CTRL_POLICY_NEXT_BURST);
+            _policy = FLAG_TX_CTRL_POLICY_NEXT_BURST;
         }
         else throw uhd::value_error("USRP TX cannot handle requested underflow policy: " + policy);
+        this->update_policy();
+    }
+
+    void set_late_policy(const std::string &policy){
+        if (policy == "policy") _late_policy = 0;
+        else if (policy == "drop_burst") _late_policy = 1;
+        else if (policy == "send_now") _late_policy = 2;
+        else if (policy == "drop_packet") _late_policy = 3;
+        else throw uhd::value_error("USRP TX cannot handle requested late policy: " + policy);
+        this->update_policy();
+    }
+
+    void set_idle_fill(const bool enb, const boost::int16_t idle_i, const boost::int16_t idle_q){
+        _iface->poke32(REG_TX_CTRL_IDLE_SAMPLE, (boost::uint32_t(boost::uint16_t(idle_i)) << 16) | boost::uint16_t(idle_q));
+        _idle_fill = enb;
+        this->update_policy();
+    }
+
+    void set_loop_playback(const bool enb){
+        _loop = enb;
+        this->update_policy();
     }
 
     void set_tick_rate(const double rate){
         _tick_rate = rate;
+        this->update_interp_table();
+    }
+
+    void set_vita_rate(const double rate){
+        _vita_rate = rate;
     }
 
     void set_link_rate(const double rate){
         //_link_rate = rate/sizeof(boost::uint32_t); //in samps/s
         _link_rate = rate/sizeof(boost::uint16_t); //in samps/s (allows for 8sc)
+        this->update_interp_table();
+    }
+
+    void set_low_latency(const bool enb){
+        _low_latency = enb;
+    }
+
+    double get_group_delay(void){
+        if (_host_rate <= 0.0) return 0.0;
+        //the halfbands are 31 and 7 tap FIRs, each delays by half its taps at its output rate,
+        //a 3 stage CIC delays 3/2 of its output samples per interpolation step
+        const double hb1_rate = _host_rate*(_hb1? 2 : 1);
+        const double hb0_rate = hb1_rate*(_hb0? 2 : 1);
+        return (_hb1? 15/hb1_rate : 0.0) + (_hb0? 3/hb0_rate : 0.0) + 1.5*(_cic_rate - 1)/(hb0_rate*_cic_rate);
     }
 
     uhd::meta_range_t get_host_rates(void){
-        meta_range_t range;
-        for (int rate = 512; rate > 256; rate -= 4){
-            range.push_back(range_t(_tick_rate/rate));
-        }
-        for (int rate = 256; rate > 128; rate -= 2){
-            range.push_back(range_t(_tick_rate/rate));
-        }
-        for (int rate = 128; rate >= int(std::ceil(_tick_rate/_link_rate)); rate -= 1){
-            range.push_back(range_t(_tick_rate/rate));
-        }
-        return range;
+        return _host_rates;
     }
 
     double set_host_rate(const double rate){
-        const size_t interp_rate = boost::math::iround(_tick_rate/this->get_host_rates().clip(rate, true));
+        const size_t interp_rate = _interps[this->nearest_interp_index(rate)];
         size_t interp = interp_rate;
 
-        //determine which half-band filters are activated
+        //determine which half-band filters are activated,
+        //the low latency mode leaves them off while the CIC takes the interpolation
+        const bool cic_only = _low_latency and interp <= MAX_CIC_RATE;
         int hb0 = 0, hb1 = 0;
-        if (interp % 2 == 0){
+        if (interp % 2 == 0 and not cic_only){
             hb0 = 1;
             interp /= 2;
         }
-        if (interp % 2 == 0){
+        if (interp % 2 == 0 and not cic_only){
             hb1 = 1;
             interp /= 2;
         }
 
         _iface->poke32(REG_DSP_TX_INTERP, (hb1 << 9) | (hb0 << 8) | (interp & 0xff));
+        _cic_rate = interp;
+        _hb0 = hb0;
+        _hb1 = hb1;
 
-        if (interp > 1 and hb0 == 0 and hb1 == 0)
+        if (interp > 1 and hb0 == 0 and hb1 == 0 and not cic_only)
         {
             UHD_MSG(warning) << boost::format(
                 "The requested interpolation is odd; the user should expect CIC rolloff.\n"
@@ -144,7 +252,10 @@ public:
         _scaling_adjustment = std::pow(2, ceil_log2(rate_pow))/(1.65*rate_pow);
         this->update_scalar();
 
-        return _tick_rate/interp_rate;
+        _host_rate = _tick_rate/interp_rate;
+        this->check_link_rate();
+        this->check_gmsk_rate();
+        return _host_rate;
     }
 
     void update_scalar(void){
@@ -178,10 +289,32 @@ public:
         return actual_freq;
     }
 
+    void set_hop_table(const dsp_hop_table_t &table){
+        dsp_hop_table_load(_iface, REG_DSP_TX_HOP, table, _tick_rate, _vita_rate);
+    }
+
     uhd::meta_range_t get_freq_range(void){
         return uhd::meta_range_t(-_tick_rate/2, +_tick_rate/2, _tick_rate/std::pow(2.0, 32));
     }
 
+    void set_ramp(const std::vector<double> &gains){
+        if (_ramp_base == 0){
+            if (gains.empty()) return;
+            throw uhd::not_implemented_error("USRP TX ramps need an FPGA image with the ramp generator");
+        }
+        if (gains.size() > TX_RAMP_MAX_LEN) throw uhd::value_error(str(boost::format(
+            "USRP TX ramps take up to %u gains, not %u") % TX_RAMP_MAX_LEN % gains.size()));
+
+        //off while the table changes, so no burst goes out on half a table
+        _iface->poke32(REG_TX_RAMP_LEN, 0);
+        for (size_t i = 0; i < gains.size(); i++){
+            const double gain = std::max(0.0, std::min(1.0, gains[i]));
+            const boost::uint32_t word = boost::uint32_t(boost::math::iround(gain*65535));
+            _iface->poke32(REG_TX_RAMP_GAIN, boost::uint32_t(i << 16) | word);
+        }
+        _iface->poke32(REG_TX_RAMP_LEN, boost::uint32_t(gains.size()));
+    }
+
     void set_updates(const size_t cycles_per_up, const size_t packets_per_up){
         _iface->poke32(REG_TX_CTRL_CYCLES_PER_UP,  (cycles_per_up  == 0)? 0 : (FLAG_TX_CTRL_UP_ENB | cycles_per_up));
         _iface->poke32(REG_TX_CTRL_PACKETS_PER_UP, (packets_per_up == 0)? 0 : (FLAG_TX_CTRL_UP_ENB | packets_per_up));
@@ -193,37 +326,143 @@ public:
         unsigned format_word = 0;
         if (stream_args.otw_format == "sc16"){
             format_word = 0;
+            _wire_bytes = 4;
             _dsp_extra_scaling = 1.0;
             _host_extra_scaling = 1.0;
         }
         else if (stream_args.otw_format == "sc8"){
             format_word = (1 << 0);
+            _wire_bytes = 2;
             double peak = stream_args.args.cast<double>("peak", 1.0);
             peak = std::max(peak, 1.0/256);
             _host_extra_scaling = 1.0/peak/256;
             _dsp_extra_scaling = 1.0/peak;
         }
+        else if (stream_args.otw_format == "gmsk"){
+            if (_mod_base == 0) throw uhd::not_implemented_error("USRP TX gmsk over the wire needs an FPGA image with the gmsk modulator");
+            if (stream_args.cpu_format != "gmsk") throw uhd::value_error("USRP TX gmsk over the wire takes cpu_format=gmsk, not " + stream_args.cpu_format);
+            format_word = 0;
+            _wire_bytes = 0; //a few bits per symbol, far below the link rate
+            _dsp_extra_scaling = 1.0;
+            _host_extra_scaling = 1.0;
+        }
         else throw uhd::value_error("USRP TX cannot handle requested wire format: " + stream_args.otw_format);
 
+        //the modulator passes the samples through unless this streamer sends bits
+        _gmsk = (stream_args.otw_format == "gmsk");
+        if (_gmsk) this->load_gmsk(
+            stream_args.args.cast<size_t>("sps", 4),
+            stream_args.args.cast<double>("bt", 0.3),
+            stream_args.args.cast<int>("diff_encode", 1) != 0);
+        else if (_mod_base != 0) _iface->poke32(REG_TX_MOD_MODE, 0);
+        this->check_gmsk_rate();
+
         _host_extra_scaling /= stream_args.args.cast<double>("fullscale", 1.0);
 
         this->update_scalar();
+        this->check_link_rate();
 
+        //little-endian words for the data packets, the streamer resolved otw_endian
+        if (stream_args.args.get("otw_endian", "be") == "le") format_word |= FLAG_CTRL_FORMAT_LE;
         _iface->poke32(REG_TX_CTRL_FORMAT, format_word);
 
         if (stream_args.args.has_key("underflow_policy")){
             this->set_underflow_policy(stream_args.args["underflow_policy"]);
         }
+        this->set_late_policy(stream_args.args.get("late_policy", "policy"));
     }
 
 private:
+    //! Rebuild the interpolation table, once per tick or link rate change
+    void update_interp_table(void){
+        _interps.clear();
+        _host_rates = meta_range_t();
+        if (_tick_rate <= 0.0 or _link_rate <= 0.0) return;
+
+        for (size_t rate = 512; rate > 256; rate -= 4) _interps.push_back(rate);
+        for (size_t rate = 256; rate > 128; rate -= 2) _interps.push_back(rate);
+        const size_t min_interp = size_t(std::max(1.0, std::ceil(_tick_rate/_link_rate)));
+        for (size_t rate = 128; rate >= min_interp; rate -= 1) _interps.push_back(rate);
+        for (size_t i = 0; i < _interps.size(); i++) _host_rates.push_back(range_t(_tick_rate/_interps[i]));
+    }
+
+    //! Index of the interpolation with the rate nearest to the given one, the rates go up with the index
+    size_t nearest_interp_index(const double rate) const{
+        UHD_ASSERT_THROW(not _interps.empty());
+        const size_t i = std::lower_bound(_interps.begin(), _interps.end(), _tick_rate/rate, std::greater<double>()) - _interps.begin();
+        if (i == 0) return 0;
+        if (i == _interps.size()) return i - 1;
+        return (_tick_rate/_interps[i] - rate < rate - _tick_rate/_interps[i-1])? i : i - 1;
+    }
+
+    //! Load the phase steps of the pulse and turn the modulator on
+    void load_gmsk(const size_t sps, const double bt, const bool diff_encode){
+        if (sps < 1 or sps > GMSK_MAX_SPS) throw uhd::value_error(str(boost::format(
+            "USRP TX gmsk takes 1 to %u samples per symbol, not %u") % GMSK_MAX_SPS % sps));
+        if (bt <= 0.0) throw uhd::value_error("USRP TX gmsk needs a positive bt");
+
+        //bit m of the symbols is the one m periods back, set for -1
+        _iface->poke32(REG_TX_MOD_MODE, 0);
+        const std::vector<double> area = gmsk_pulse_area(sps, bt);
+        static const double QUARTER_TURN = double(1 << 22);
+        for (size_t syms = 0; syms < 8; syms++)
+        {
+            for (size_t j = 0; j < sps; j++)
+            {
+                double step = 0.0;
+                for (size_t m = 0; m < 3; m++)
+                {
+                    step += ((syms & (1 << m))? -1.0 : 1.0)*area[m*sps + j];
+                }
+                const boost::int32_t word = boost::math::iround(step*QUARTER_TURN);
+                _iface->poke32(REG_TX_MOD_STEP, boost::uint32_t((syms*GMSK_MAX_SPS + j) << 24) | (boost::uint32_t(word) & 0xffffff));
+            }
+        }
+        _iface->poke32(REG_TX_MOD_MODE, boost::uint32_t(sps) | (diff_encode? FLAG_TX_MOD_DIFF_ENCODE : 0));
+    }
+
+    //the modulator makes one sample per CORDIC pass
+    void check_gmsk_rate(void){
+        if (not _gmsk or _host_rate <= 0.0 or _tick_rate/_host_rate >= GMSK_MIN_INTERP - 0.5) return;
+        UHD_MSG(warning) << boost::format(
+            "TX rate %.3f Msps is too fast for the gmsk modulator, it needs %u clocks per sample.\n"
+            "Use fewer samples per symbol.") % (_host_rate/1e6) % GMSK_MIN_INTERP << std::endl;
+    }
+
+    void update_policy(void){
+        _iface->poke32(REG_TX_CTRL_POLICY, _policy
+            | (_late_policy << FLAG_TX_CTRL_POLICY_LATE_SHIFT)
+            | (_idle_fill? FLAG_TX_CTRL_POLICY_IDLE_FILL : 0)
+            | (_loop? FLAG_TX_CTRL_POLICY_NO_SEQ_CHECK : 0));
+    }
+
+    //the host rates are bounded by the sc8 link rate, sc16 only fits half of them
+    void check_link_rate(void){
+        if (_link_rate <= 0.0 or _host_rate*_wire_bytes <= _link_rate*sizeof(boost::uint16_t)) return;
+        UHD_MSG(warning) << boost::format(
+            "TX rate %.3f Msps exceeds the link capacity for %s over the wire.\n"
+            "Use otw_format=sc8 or a lower rate to avoid underflows.") % (_host_rate/1e6) % ((_wire_bytes == 2)? "sc8" : "sc16") << std::endl;
+    }
+
     wb_iface::sptr _iface;
-    const size_t _dsp_base, _ctrl_base;
-    double _tick_rate, _link_rate;
+    const size_t _dsp_base, _ctrl_base, _mod_base, _ramp_base;
+    double _tick_rate, _vita_rate, _link_rate;
+    std::vector<size_t> _interps; //valid interpolations, descending so the rates go up
+    meta_range_t _host_rates; //the rates of _interps
     double _scaling_adjustment, _dsp_extra_scaling, _host_extra_scaling, _fxpt_scalar_correction;
+    double _host_rate;
+    size_t _wire_bytes; //bytes per sample of the otw format
+    boost::uint32_t _policy; //underflow policy flags
+    boost::uint32_t _late_policy; //late packet policy, see FLAG_TX_CTRL_POLICY_LATE_SHIFT
+    bool _idle_fill;
+    bool _loop; //replaying the SRAM, the sequence numbers repeat
+    bool _gmsk; //the FPGA modulates bits from the host
+    bool _low_latency;
+    size_t _cic_rate; //of the current interpolation
+    int _hb0, _hb1;
     const boost::uint32_t _sid;
 };
 
-tx_dsp_core_200::sptr tx_dsp_core_200::make(wb_iface::sptr iface, const size_t dsp_base, const size_t ctrl_base, const boost::uint32_t sid){
-    return sptr(new tx_dsp_core_200_impl(iface, dsp_base, ctrl_base, sid));
+tx_dsp_core_200::sptr tx_dsp_core_200::make(wb_iface::sptr iface, const size_t dsp_base, const size_t ctrl_base, const boost::uint32_t sid, const size_t mod_base, const size_t ramp_base, const bool hold_clear){
+    return sptr(new tx_dsp_core_200_impl(iface, dsp_base, ctrl_base, sid, mod_base, ramp_base, hold_clear));
 }
@@ -23,26 +23,53 @@
 #include <uhd/types/ranges.hpp>
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+#include <vector>
 #include <uhd/types/wb_iface.hpp>
+#include "dsp_hop_table.hpp"
 
 class tx_dsp_core_200 : boost::noncopyable{
 public:
     typedef boost::shared_ptr<tx_dsp_core_200> sptr;
 
+    /*!
+     * With hold_clear the chain is left in the reset of begin_clear(),
+     * the caller waits for the packets in flight, ex: for several chains
+     * at once, and calls end_clear().
+     */
     static sptr make(
         uhd::wb_iface::sptr iface,
         const size_t dsp_base, const size_t ctrl_base,
-        const boost::uint32_t sid
+        const boost::uint32_t sid, const size_t mod_base = 0,
+        const size_t ramp_base = 0, const bool hold_clear = false
     );
 
+    //! Reset the chain and flush the packets in flight, holds the reset 10 ms
     virtual void clear(void) = 0;
 
+    //! The first half of clear(), resets the chain and drops the packets that arrive
+    virtual void begin_clear(void) = 0;
+
+    //! The second half of clear(), the chain runs again
+    virtual void end_clear(void) = 0;
+
     virtual void set_tick_rate(const double rate) = 0;
 
+    virtual void set_vita_rate(const double rate) = 0;
+
     virtual void set_link_rate(const double rate) = 0;
 
     virtual double set_host_rate(const double rate) = 0;
 
+    /*!
+     * Leave the halfbands off where the CIC can take the interpolation alone,
+     * its droop is not made up for. Takes effect on the next set_host_rate.
+     */
+    virtual void set_low_latency(const bool enb) = 0;
+
+    //! Group delay of the DUC at the current rate in seconds
+    virtual double get_group_delay(void) = 0;
+
     virtual uhd::meta_range_t get_host_rates(void) = 0;
 
     virtual double get_scaling_adjustment(void) = 0;
@@ -51,8 +78,46 @@ public:
 
     virtual double set_freq(const double freq) = 0;
 
+    //! Load timed CORDIC hops (FPGA 9.9+), an empty table stops hopping
+    virtual void set_hop_table(const dsp_hop_table_t &table) = 0;
+
+    /*!
+     * Shape the burst edges in the FPGA (FPGA 9.30+, needs a ramp_base).
+     * The first gains.size() samples of each burst are scaled by the gains,
+     * then the last sample is held and scaled by them in reverse after the
+     * burst, so the host sends only the useful part. Gains are 0.0 to 1.0,
+     * up to 64 of them, an empty vector leaves the edges alone.
+     */
+    virtual void set_ramp(const std::vector<double> &gains) = 0;
+
     virtual void set_updates(const size_t cycles_per_up, const size_t packets_per_up) = 0;
 
+    /*!
+     * Keep the chain running on a fixed sample between bursts (FPGA 9.13+).
+     * Gaps then go out as the idle sample instead of stopping the DSP,
+     * and a gap inside a burst ends it without an underflow report.
+     */
+    virtual void set_idle_fill(const bool enb, const boost::int16_t idle_i, const boost::int16_t idle_q) = 0;
+
+    //! Accept the repeated sequence numbers of a looped SRAM playback (FPGA 9.14+)
+    virtual void set_loop_playback(const bool enb) = 0;
+
+    /*!
+     * What a late timed packet does (FPGA 9.27+), reported as a time error either way:
+     * policy follows the underflow policy, drop_burst drops up to the end
+     * of the burst, send_now sends it at once, drop_packet drops it alone.
+     */
+    virtual void set_late_policy(const std::string &policy) = 0;
+
+    /*!
+     * Set the wire format of the chain for a new streamer.
+     * With otw_format=gmsk (FPGA 9.21+, needs a mod_base) the FPGA modulates
+     * the bits: cpu_format=gmsk items are one word each, [31:24] number of
+     * bits up to 24 and [23:0] the bits, sent LSB first, in host order.
+     * The host rate is the symbol rate times the samples per symbol, args
+     * sps (4) up to 16, bt (0.3) and diff_encode (1, as GSM 05.04).
+     * The waveform lags the timestamp by 1.5 symbols, the pulse center.
+     */
     virtual void setup(const uhd::stream_args_t &stream_args) = 0;
 };
 
@@ -16,6 +16,7 @@
 
 #include "lms6002d.hpp"
 #include <boost/thread.hpp>
+#include <algorithm>
 
 #define usleep(x) boost::this_thread::sleep(boost::posix_time::microseconds(x))
 
@@ -25,8 +26,54 @@ static int verbosity = 0;
 /* LMS6002D Control Class implementation                                */
 /************************************************************************/
 
+void lms6002d_dev::write_regs(const uint8_t *addrs, const uint8_t *vals, size_t num)
+{
+    for (size_t i = 0; i < num; i++) write_reg(addrs[i], vals[i]);
+}
+
+void lms6002d_dev::read_regs(const uint8_t *addrs, uint8_t *vals, size_t num)
+{
+    for (size_t i = 0; i < num; i++) vals[i] = read_reg(addrs[i]);
+}
+
+uint8_t lms6002d_dev::batch_read(uint8_t address)
+{
+    for (size_t i = 0; i < _batch_addrs.size(); i++) {
+        if (_batch_addrs[i] == address) return _batch_vals[i];
+    }
+    return read_reg(address);
+}
+
+void lms6002d_dev::batch_write(uint8_t address, uint8_t val)
+{
+    if (_batch_depth == 0) return write_reg(address, val);
+    for (size_t i = 0; i < _batch_addrs.size(); i++) {
+        if (_batch_addrs[i] != address) continue;
+        _batch_vals[i] = val;
+        return;
+    }
+    _batch_addrs.push_back(address);
+    _batch_vals.push_back(val);
+}
+
+void lms6002d_dev::batch_begin()
+{
+    _batch_depth++;
+}
+
+void lms6002d_dev::batch_end(bool commit)
+{
+    if (--_batch_depth > 0) return;
+    std::vector<uint8_t> addrs, vals;
+    addrs.swap(_batch_addrs);
+    vals.swap(_batch_vals);
+    if (commit && !addrs.empty()) write_regs(&addrs[0], &vals[0], addrs.size());
+}
+
 void lms6002d_dev::dump()
 {
+    uint8_t addrs[128], vals[128];
+    size_t num = 0;
     for (int i = 0; i < 128; i++) {
         switch (i) {
             case 0x0C:
@@ -45,11 +92,15 @@ void lms6002d_dev::dump()
             case 0x6D:
                 continue;
         }
-        printf("reg[0x%02x] = 0x%02x\n", i, read_reg(i));
+        addrs[num++] = i;
+    }
+    read_regs(addrs, vals, num);
+    for (size_t i = 0; i < num; i++) {
+        printf("reg[0x%02x] = 0x%02x\n", addrs[i], vals[i]);
     }
 }
 
-double lms6002d_dev::txrx_pll_tune(uint8_t reg, double ref_clock, double out_freq)
+bool lms6002d_dev::txrx_pll_plan(double ref_clock, double out_freq, int8_t &freqsel_out, int64_t &nint, int64_t &nfrac, double &actual_freq)
 {
     // Supported frequency ranges and corresponding FREQSEL values.
     static const struct vco_sel { double fmin; double fmax; int8_t value; } freqsel[] = {
@@ -71,8 +122,6 @@ double lms6002d_dev::txrx_pll_tune(uint8_t reg, double ref_clock, double out_fre
         { 3.24e9,     3.72e9,     0x3c },
     };
 
-    if (verbosity>0) printf("lms6002d_dev::txrx_pll_tune(ref_clock=%f, out_freq=%f)\n", ref_clock, out_freq);
-
     // Find frequency range and FREQSEL for the given frequency
     int8_t found_freqsel = -1;
     for (unsigned i = 0; i < (int)sizeof(freqsel) / sizeof(freqsel[0]); i++) {
@@ -83,23 +132,44 @@ double lms6002d_dev::txrx_pll_tune(uint8_t reg, double ref_clock, double out_fre
     if (found_freqsel == -1)
     {
         // Unsupported frequency range
-        return -1;
+        return false;
     }
 
     // Calculate NINT, NFRAC
     int64_t vco_x = 1 << ((found_freqsel & 0x7) - 3);
-    int64_t nint = vco_x * out_freq / ref_clock;
-    int64_t nfrac = (1 << 23) * (vco_x * out_freq - nint * ref_clock) / ref_clock;
-    double actual_freq = (nint + nfrac/double(1<<23)) * (ref_clock/vco_x);
+    nint = vco_x * out_freq / ref_clock;
+    nfrac = (1 << 23) * (vco_x * out_freq - nint * ref_clock) / ref_clock;
+    actual_freq = (nint + nfrac/double(1<<23)) * (ref_clock/vco_x);
+    freqsel_out = found_freqsel;
 
     // DEBUG
     if (verbosity>0) printf("FREQSEL=%d VCO_X=%d NINT=%d  NFRAC=%d ACTUAL_FREQ=%f\n\n", (int)found_freqsel, (int)vco_x, (int)nint, (int)nfrac, actual_freq);
+    return true;
+}
+
+static uint32_t vcocap_cache_key(uint8_t reg, int8_t freqsel, int64_t nint)
+{
+    return (uint32_t(reg) << 24) | (uint32_t(freqsel & 0x3f) << 16) | uint32_t(nint & 0xffff);
+}
+
+double lms6002d_dev::txrx_pll_tune(uint8_t reg, double ref_clock, double out_freq)
+{
+    if (verbosity>0) printf("lms6002d_dev::txrx_pll_tune(ref_clock=%f, out_freq=%f)\n", ref_clock, out_freq);
+
+    int8_t found_freqsel;
+    int64_t nint, nfrac;
+    double actual_freq;
+    if (!txrx_pll_plan(ref_clock, out_freq, found_freqsel, nint, nfrac, actual_freq)) return -1;
 
     // Write NINT, NFRAC
-    write_reg(reg + 0x0, (nint >> 1) & 0xff);    // NINT[8:1]
-    write_reg(reg + 0x1, ((nfrac >> 16) & 0x7f) | ((nint & 0x1) << 7)); //NINT[0] nfrac[22:16]
-    write_reg(reg + 0x2, (nfrac >> 8) & 0xff);  // NFRAC[15:8]
-    write_reg(reg + 0x3, (nfrac) & 0xff);     // NFRAC[7:0]
+    const uint8_t nint_nfrac_addrs[4] = {uint8_t(reg + 0x0), uint8_t(reg + 0x1), uint8_t(reg + 0x2), uint8_t(reg + 0x3)};
+    const uint8_t nint_nfrac_vals[4] = {
+        uint8_t((nint >> 1) & 0xff),                            // NINT[8:1]
+        uint8_t(((nfrac >> 16) & 0x7f) | ((nint & 0x1) << 7)), // NINT[0] nfrac[22:16]
+        uint8_t((nfrac >> 8) & 0xff),                           // NFRAC[15:8]
+        uint8_t((nfrac) & 0xff)                                 // NFRAC[7:0]
+    };
+    write_regs(nint_nfrac_addrs, nint_nfrac_vals, 4);
     // Write FREQSEL
     lms_write_bits(reg + 0x5, (0x3f << 2), (found_freqsel << 2)); // FREQSEL[5:0]
     // Reset VOVCOREG, OFFDOWN to default
@@ -111,11 +181,80 @@ double lms6002d_dev::txrx_pll_tune(uint8_t reg, double ref_clock, double out_fre
     // DEBUG
     //reg_dump();
 
-    // Poll VOVCO
+    // Find the VCOCAP window, starting from the one found last time
+    // for this band and falling back to the full sweep
+    const uint32_t cache_key = vcocap_cache_key(reg, found_freqsel, nint);
     int start_i = -1;
     int stop_i = -1;
+    bool found = false;
+    std::map<uint32_t, vcocap_window>::const_iterator cached = _vcocap_cache.find(cache_key);
+    if (cached != _vcocap_cache.end()) {
+        static const int margin = 2;
+        const int first = std::max(0, cached->second.start - margin);
+        const int last = std::min(63, cached->second.stop + margin);
+        if (vcocap_sweep(reg, first, last, start_i, stop_i) < 0) return -1;
+        // Both edges must lie inside the window, or it has moved
+        found = start_i != -1 && stop_i != -1
+                && (start_i > first || first == 0)
+                && (stop_i < last || last == 63);
+        if (verbosity>0 && !found) printf("VCOCAP window moved, full sweep\n");
+    }
+    if (!found) {
+        if (vcocap_sweep(reg, 0, 63, start_i, stop_i) < 0) return -1;
+    }
+
+    if (start_i == -1 || stop_i == -1) {
+        _vcocap_cache.erase(cache_key);
+        printf("ERROR: Can't find VCOCAP value while tuning\n");
+        return -1;
+    }
+    vcocap_window window = {start_i, stop_i};
+    _vcocap_cache[cache_key] = window;
+
+    // Tune to the middle of the found VCOCAP range
+    int avg_i = (start_i + stop_i) / 2;
+    if (verbosity>0) printf("START=%d STOP=%d SET=%d\n", start_i, stop_i, avg_i);
+    lms_write_bits(reg + 0x09, 0x3f, avg_i);
+
+    // Return actual frequency we've tuned to
+    return actual_freq;
+}
+
+double lms6002d_dev::txrx_pll_hop(uint8_t reg, double ref_clock, double out_freq)
+{
+    if (verbosity>0) printf("lms6002d_dev::txrx_pll_hop(ref_clock=%f, out_freq=%f)\n", ref_clock, out_freq);
+
+    int8_t freqsel;
+    int64_t nint, nfrac;
+    double actual_freq;
+    if (!txrx_pll_plan(ref_clock, out_freq, freqsel, nint, nfrac, actual_freq)) return -1;
+
+    std::map<uint32_t, vcocap_window>::const_iterator cached = _vcocap_cache.find(vcocap_cache_key(reg, freqsel, nint));
+    if (cached == _vcocap_cache.end()) return -1;
+    const int vcocap = (cached->second.start + cached->second.stop) / 2;
+
+    // The whole register set goes out as one burst, no readback needed
+    const uint8_t addrs[6] = {uint8_t(reg + 0x0), uint8_t(reg + 0x1), uint8_t(reg + 0x2), uint8_t(reg + 0x3),
+                              uint8_t(reg + 0x5), uint8_t(reg + 0x9)};
+    const uint8_t vals[6] = {
+        uint8_t((nint >> 1) & 0xff),                            // NINT[8:1]
+        uint8_t(((nfrac >> 16) & 0x7f) | ((nint & 0x1) << 7)), // NINT[0] nfrac[22:16]
+        uint8_t((nfrac >> 8) & 0xff),                           // NFRAC[15:8]
+        uint8_t((nfrac) & 0xff),                                // NFRAC[7:0]
+        uint8_t((read_reg(reg + 0x5) & ~(0x3f << 2)) | (freqsel << 2)), // FREQSEL[5:0]
+        uint8_t((read_reg(reg + 0x9) & ~0x3f) | vcocap)         // VCOCAP[5:0]
+    };
+    write_regs(addrs, vals, 6);
+    return actual_freq;
+}
+
+int lms6002d_dev::vcocap_sweep(uint8_t reg, int first, int last, int &start_i, int &stop_i)
+{
+    // Poll VOVCO
+    start_i = -1;
+    stop_i = -1;
     enum State { VCO_HIGH, VCO_NORM, VCO_LOW } state = VCO_HIGH;
-    for (int i = 0; i < 64; i++) {
+    for (int i = first; i <= last; i++) {
         // Update VCOCAP
         lms_write_bits(reg + 0x9, 0x3f, i);
         usleep(long(50));
@@ -143,38 +282,32 @@ double lms6002d_dev::txrx_pll_tune(uint8_t reg, double ref_clock, double out_fre
             return -1;
         }
         if (verbosity>1) printf("VOVCO[%d]=%x\n", i, (comp>>6));
+        // Nothing more to learn once the window is closed
+        if (state == VCO_LOW) break;
     }
     if (VCO_NORM == state)
-        stop_i = 63;
-
-    if (start_i == -1 || stop_i == -1) {
-        printf("ERROR: Can't find VCOCAP value while tuning\n");
-        return -1;
-    }
-
-    // Tune to the middle of the found VCOCAP range
-    int avg_i = (start_i + stop_i) / 2;
-    if (verbosity>0) printf("START=%d STOP=%d SET=%d\n", start_i, stop_i, avg_i);
-    lms_write_bits(reg + 0x09, 0x3f, avg_i);
-
-    // Return actual frequency we've tuned to
-    return actual_freq;
+        stop_i = last;
+    return 0;
 }
 
 void lms6002d_dev::init()
 {
     if (verbosity>0) printf("lms6002d_dev::init()\n");
-    write_reg(0x09, 0x00); // RXOUTSW (disabled), CLK_EN (all disabled)
-    write_reg(0x17, 0xE0);
-    write_reg(0x27, 0xE3);
-    write_reg(0x70, 0x01);
-
-    // FAQ v1.0r12, 5.27:
-    write_reg(0x47, 0x40); // Improving Tx spurious emission performance
-    write_reg(0x59, 0x29); // Improving ADC’s performance
-    write_reg(0x64, 0x36); // Common Mode Voltage For ADC’s
-    write_reg(0x79, 0x37); // Higher LNA Gain
+    static const uint8_t init_addrs[] = {
+        0x09, // RXOUTSW (disabled), CLK_EN (all disabled)
+        0x17,
+        0x27,
+        0x70,
+        // FAQ v1.0r12, 5.27:
+        0x47, // Improving Tx spurious emission performance
+        0x59, // Improving ADC’s performance
+        0x64, // Common Mode Voltage For ADC’s
+        0x79  // Higher LNA Gain
+    };
+    static const uint8_t init_vals[] = {0x00, 0xE0, 0xE3, 0x01, 0x40, 0x29, 0x36, 0x37};
+    write_regs(init_addrs, init_vals, sizeof(init_addrs));
 
+    batch b(*this);
     // Power down DC comparators to improve the receiver linearity
     // (see FAQ v1.0r12, 5.26)
     lms_set_bits(0x6E, (0x3 << 6));
@@ -188,6 +321,7 @@ void lms6002d_dev::init()
     // Icp=0.2mA
     // This gives much better results for the GMSK modulation
     lms_write_bits(0x16, 0x1f, 0x02);
+    b.commit();
 }
 
 void lms6002d_dev::set_txrx_polarity_and_interleaving(int rx_fsync_polarity,
@@ -509,8 +643,11 @@ int lms6002d_dev::rxvga2_dc_calibration()
 void lms6002d_dev::lpf_bandwidth_tuning(int ref_clock, uint8_t lpf_bandwidth_code)
 {
     // Save registers 0x05 and 0x09, because we will modify them during tx_enable()
-    uint8_t reg_save_05 = read_reg(0x05);
-    uint8_t reg_save_09 = read_reg(0x09);
+    static const uint8_t save_addrs[2] = {0x05, 0x09};
+    uint8_t save_vals[2];
+    read_regs(save_addrs, save_vals, 2);
+    const uint8_t reg_save_05 = save_vals[0];
+    const uint8_t reg_save_09 = save_vals[1];
 
     // Enable TxPLL and tune it to 320MHz
     tx_enable();
@@ -545,9 +682,58 @@ void lms6002d_dev::lpf_bandwidth_tuning(int ref_clock, uint8_t lpf_bandwidth_cod
     lms_clear_bits(0x07, (1 << 7));
 
     // Restore registers 0x05, 0x06 and 0x09
-    write_reg(0x06, reg_save_06);
-    write_reg(0x05, reg_save_05);
-    write_reg(0x09, reg_save_09);
+    const uint8_t restore_addrs[3] = {0x06, 0x05, 0x09};
+    const uint8_t restore_vals[3] = {reg_save_06, reg_save_05, reg_save_09};
+    write_regs(restore_addrs, restore_vals, 3);
+}
+
+void lms6002d_dev::get_auto_calibration(auto_calibration_values &cal)
+{
+    // DC calibration modules of the Tx LPF, Rx LPF and RxVGA2 need their clocks
+    uint8_t clk_en_save = read_reg(0x09);
+    lms_set_bits(0x09, (1 << 1) | (1 << 3) | (1 << 4));
+
+    cal.lpf_dccal = read_reg(0x55) & 0x3f;
+    cal.rccal = (read_reg(0x56) >> 4) & 0x7;
+    for (uint8_t i = 0; i < 2; i++)
+        cal.tx_lpf_dc[i] = get_dc_calibration_value(i, 0x30) & 0x3f;
+    for (uint8_t i = 0; i < 2; i++)
+        cal.rx_lpf_dc[i] = get_dc_calibration_value(i, 0x50) & 0x3f;
+    for (uint8_t i = 0; i < 5; i++)
+        cal.rxvga2_dc[i] = get_dc_calibration_value(i, 0x60) & 0x3f;
+
+    write_reg(0x09, clk_en_save);
+}
+
+void lms6002d_dev::set_auto_calibration(const auto_calibration_values &cal)
+{
+    uint8_t clk_en_save = read_reg(0x09);
+    batch b(*this);
+    lms_set_bits(0x09, (1 << 1) | (1 << 3) | (1 << 4));
+
+    // RxLPFSPI::DCO_DACCAL and TxLPFSPI::DCO_DACCAL
+    lms_write_bits(0x35, 0x3f, cal.lpf_dccal & 0x3f);
+    lms_write_bits(0x55, 0x3f, cal.lpf_dccal & 0x3f);
+    // RxLPFSPI::RCCAL_LPF and TxLPFSPI::RCCAL_LPF
+    _lpf_rccal = cal.rccal & 0x7;
+    lms_write_bits(0x56, (7 << 4), (_lpf_rccal << 4));
+    lms_write_bits(0x36, (7 << 4), (_lpf_rccal << 4));
+    b.commit();
+
+    // the DC registers load by strobes, outside of the batch
+    for (uint8_t i = 0; i < 2; i++)
+        set_dc_calibration_value(i, 0x30, cal.tx_lpf_dc[i]);
+    for (uint8_t i = 0; i < 2; i++)
+        set_dc_calibration_value(i, 0x50, cal.rx_lpf_dc[i]);
+    for (uint8_t i = 0; i < 5; i++)
+        set_dc_calibration_value(i, 0x60, cal.rxvga2_dc[i]);
+
+    // Leave DC comparators powered down, as general_dc_calibration() does
+    batch restore(*this);
+    lms_set_bits(0x6E, (0x3 << 6));
+    lms_set_bits(0x5F, (0x1 << 7));
+    lms_write_bits(0x09, 0xff, clk_en_save);
+    restore.commit();
 }
 
 void lms6002d_dev::auto_calibration(int ref_clock, int lpf_bandwidth_code)
@@ -568,6 +754,7 @@ void lms6002d_dev::auto_calibration(int ref_clock, int lpf_bandwidth_code)
     // connect it to the internal termination resistor with
     // IN1SEL_MIX_RXFE and RINEN_MIX_RXFE configuration bits.
     uint8_t lna = get_rx_lna();
+    batch rx_off(*this);
     //   1. Select LNA1
     set_rx_lna(1);
     //   2. Connect LNA to external inputs.
@@ -580,6 +767,7 @@ void lms6002d_dev::auto_calibration(int ref_clock, int lpf_bandwidth_code)
     lms_set_bits(0x7C, (1 << 2));
     // Set RxVGA2 gain to max
     uint8_t rx_vga2gain = set_rx_vga2gain(30);
+    rx_off.commit();
     // Calibrate!
     if (verbosity > 0) printf("Rx LPF DC calibration...\n");
     txrx_lpf_dc_calibration(false);
@@ -587,8 +775,10 @@ void lms6002d_dev::auto_calibration(int ref_clock, int lpf_bandwidth_code)
     rxvga2_dc_calibration();
 
     // Restore saved values
+    batch restore(*this);
     set_rx_vga2gain(rx_vga2gain);
-    write_reg(0x71, reg_save_71);
-    write_reg(0x7C, reg_save_7C);
+    lms_write_bits(0x71, 0xff, reg_save_71);
+    lms_write_bits(0x7C, 0xff, reg_save_7C);
     set_rx_lna(lna);
+    restore.commit();
 }
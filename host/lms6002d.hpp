@@ -22,6 +22,8 @@
 #include <stdint.h>
 #include <assert.h>
 #include <cmath>
+#include <map>
+#include <vector>
 
 /*!
  * LMS6002D control class
@@ -36,6 +38,7 @@ public:
 
     lms6002d_dev()
         :_lpf_rccal(3) // Value recommended by LimeMicro
+        ,_batch_depth(0)
     {}
     ~lms6002d_dev() {}
 
@@ -55,6 +58,31 @@ public:
     virtual void write_reg(uint8_t addr, uint8_t val) = 0;
     /** Read through SPI */
     virtual uint8_t read_reg(uint8_t addr) = 0;
+    /** Write several registers in order, as one burst when the interface can */
+    virtual void write_regs(const uint8_t *addrs, const uint8_t *vals, size_t num);
+    /** Read several registers in order, as one burst when the interface can */
+    virtual void read_regs(const uint8_t *addrs, uint8_t *vals, size_t num);
+
+    /** Write combining scope for the register field helpers.
+    In it lms_set_bits(), lms_clear_bits() and lms_write_bits() update a copy
+    of each register they touch, commit() writes every touched register once,
+    in the order of the first touch, with write_regs(). A scope left without
+    commit() drops the updates. Scopes nest, the outermost one writes.
+    Direct read_reg()/write_reg() calls bypass it, so keep strobes and
+    readbacks, which need every write on the chip, out of it. */
+    class batch {
+    public:
+        batch(lms6002d_dev &dev): _dev(dev), _done(false) { _dev.batch_begin(); }
+        ~batch() { if (!_done) _dev.batch_end(false); }
+        void commit() {
+            if (_done) return;
+            _done = true;
+            _dev.batch_end(true);
+        }
+    private:
+        lms6002d_dev &_dev;
+        bool _done;
+    };
 
     /** Tune TX PLL to a given frequency. */
     double tx_pll_tune(double ref_clock, double out_freq) {
@@ -64,32 +92,49 @@ public:
     double rx_pll_tune(double ref_clock, double out_freq) {
         return txrx_pll_tune(0x20, ref_clock, out_freq);
     }
+    /** Retune TX PLL with register writes only, using the VCOCAP found by an
+        earlier tune in the same band. Returns -1 when there is none yet. */
+    double tx_pll_hop(double ref_clock, double out_freq) {
+        return txrx_pll_hop(0x10, ref_clock, out_freq);
+    }
+    /** Retune RX PLL with register writes only, see tx_pll_hop(). */
+    double rx_pll_hop(double ref_clock, double out_freq) {
+        return txrx_pll_hop(0x20, ref_clock, out_freq);
+    }
 
     void tx_enable() {
+        batch b(*this);
         // STXEN: Soft transmit enable
         lms_set_bits(0x05, (1 << 3));
         // Tx DSM SPI clock enabled
         lms_set_bits(0x09, (1 << 0));
+        b.commit();
     }
 
     void rx_enable() {
+        batch b(*this);
         // SRXEN: Soft receive enable
         lms_set_bits(0x05, (1 << 2));
         // Rx DSM SPI clock enabled
         lms_set_bits(0x09, (1 << 2));
+        b.commit();
     }
 
     void tx_disable() {
+        batch b(*this);
         // STXEN: Soft transmit enable
         lms_clear_bits(0x05, (1 << 3));
         // Tx DSM SPI clock enabled
         lms_clear_bits(0x09, (1 << 0));
+        b.commit();
     }
     void rx_disable() {
+        batch b(*this);
         // SRXEN: Soft receive enable
         lms_clear_bits(0x05, (1 << 2));
         // Rx DSM SPI clock enabled
         lms_clear_bits(0x09, (1 << 2));
+        b.commit();
     }
 
     bool get_tx_pll_locked() {
@@ -226,6 +271,28 @@ public:
         return gain * 3;
     }
 
+    /**  Set the Rx VGA1 and VGA2 codes in one batched write.
+    vga1 is the raw [0 .. 120] code, vga2 the raw [0 .. 20] code of 3dB steps */
+    void set_rx_vga_codes(uint8_t vga1, uint8_t vga2) {
+        static const uint8_t addrs[2] = {0x76, 0x65};
+        uint8_t vals[2];
+        read_regs(addrs, vals, 2);
+        vals[0] = (vals[0] & ~0x7f) | (vga1 & 0x7f);
+        vals[1] = (vals[1] & ~0x1f) | (vga2 & 0x1f);
+        write_regs(addrs, vals, 2);
+    }
+
+    /**  Set the Tx VGA1 and VGA2 codes in one batched write.
+    vga1 is the raw [0 .. 31] code of -35 .. -4 dB, vga2 is in dB [0 .. 25] */
+    void set_tx_vga_codes(uint8_t vga1, uint8_t vga2) {
+        static const uint8_t addrs[2] = {0x41, 0x45};
+        uint8_t vals[2];
+        read_regs(addrs, vals, 2);
+        vals[0] = (vals[0] & ~0x1f) | (vga1 & 0x1f);
+        vals[1] = (vals[1] & ~(0x1f << 3)) | ((vga2 & 0x1f) << 3);
+        write_regs(addrs, vals, 2);
+    }
+
     /**  Set Tx VGA1 DC offset, I channel.
     offset is a raw value [0 .. 255]
     Returns the old offset value */
@@ -316,6 +383,7 @@ public:
     width is in kHz [750 .. 14000]
     Returns the old width value in kHz */
     int8_t set_tx_lpf(int width) {
+        batch b(*this);
         // This is a *hack*.
         if (width == 500) {
             // If we set LPF bandwidth calibration value to the maximum
@@ -333,6 +401,7 @@ public:
 
         int8_t width_code = lpf_width_to_code(width);
         int8_t old_bits = lms_write_bits(0x34, (0x0f<<2), (width_code<<2));
+        b.commit();
         return lpf_code_to_width((old_bits>>2) & 0x0f);
     }
 
@@ -355,6 +424,7 @@ public:
     width is in kHz [750 .. 14000]
     Returns the old width value in kHz */
     int8_t set_rx_lpf(int width) {
+        batch b(*this);
         // This is a *hack*.
         if (width == 500) {
             // If we set LPF bandwidth calibration value to the maximum
@@ -371,6 +441,7 @@ public:
         }
         int8_t width_code = lpf_width_to_code(width);
         int8_t old_bits = lms_write_bits(0x54, (0x0f<<2), (width_code<<2));
+        b.commit();
         return lpf_code_to_width((old_bits>>2) & 0x0f);
     }
 
@@ -391,6 +462,7 @@ public:
 
     void rf_loopback_enable(int lna) {
         assert(lna>=0 && lna<=3);
+        batch b(*this);
 
         ///////////////////
         //  Configire LNA
@@ -430,9 +502,12 @@ public:
         // Select RXMIX input for loopback
         // LBRFEN[3:0] = lna
         lms_write_bits(0x08, 0x0f, lna);
+        b.commit();
     }
 
     void rf_loopback_disable() {
+        batch b(*this);
+
         /////////////////////
         // Disable loopback
         /////////////////////
@@ -459,6 +534,7 @@ public:
         lms_clear_bits(0x7D, (1 << 0));
         // Disable test mode for RX FE
         lms_clear_bits(0x70, (1 << 1));
+        b.commit();
     }
 
     /** Load value from 0x52/0x62 register to a selected DC calibration register */
@@ -527,8 +603,9 @@ public:
     /** This procedure is outlined in FAQ, section 4.7.
     It's purpose is to circumvent the fact that in some edge cases calibration
     may be successful even is DC_LOCK shows 0 or 7.
+    Virtual so that an interface may run the whole procedure closer to the chip.
     */
-    int general_dc_calibration(uint8_t dc_addr, uint8_t calibration_reg_base);
+    virtual int general_dc_calibration(uint8_t dc_addr, uint8_t calibration_reg_base);
 
     /** Programming and Calibration Guide: 4.2 DC Offset Calibration of LPF Tuning Module */
     bool lpf_tuning_dc_calibration();
@@ -563,9 +640,52 @@ public:
     */
     void auto_calibration(int ref_clock, int lpf_bandwidth_code);
 
+    /** Codes found by auto_calibration(), enough to restore it without re-running */
+    struct auto_calibration_values {
+        uint8_t lpf_dccal;    // DCO_DACCAL of the LPF tuning module
+        uint8_t rccal;        // RCCAL_LPF
+        uint8_t tx_lpf_dc[2]; // Tx LPF, I and Q
+        uint8_t rx_lpf_dc[2]; // Rx LPF, I and Q
+        uint8_t rxvga2_dc[5]; // RxVGA2 DC reference, VGA2A I and Q, VGA2B I and Q
+    };
+
+    /** Read back the calibration codes currently loaded into the chip */
+    void get_auto_calibration(auto_calibration_values &cal);
+
+    /** Load calibration codes saved with get_auto_calibration() instead of calibrating */
+    void set_auto_calibration(const auto_calibration_values &cal);
+
+    /** Forget the VCOCAP windows learned by previous tunes */
+    void clear_vcocap_cache() {
+        _vcocap_cache.clear();
+    }
+
+    /** The VCOCAP windows learned so far, by cache key, to carry them over a restart */
+    std::map<uint32_t, std::pair<int, int> > get_vcocap_cache() const {
+        std::map<uint32_t, std::pair<int, int> > windows;
+        for (std::map<uint32_t, vcocap_window>::const_iterator it = _vcocap_cache.begin(); it != _vcocap_cache.end(); ++it)
+            windows[it->first] = std::make_pair(it->second.start, it->second.stop);
+        return windows;
+    }
+
+    /** Load VCOCAP windows saved with get_vcocap_cache() */
+    void set_vcocap_cache(const std::map<uint32_t, std::pair<int, int> > &windows) {
+        for (std::map<uint32_t, std::pair<int, int> >::const_iterator it = windows.begin(); it != windows.end(); ++it) {
+            vcocap_window window = {it->second.first, it->second.second};
+            _vcocap_cache[it->first] = window;
+        }
+    }
 
 protected:
     double txrx_pll_tune(uint8_t reg, double ref_clock, double out_freq);
+    double txrx_pll_hop(uint8_t reg, double ref_clock, double out_freq);
+
+    /** Compute FREQSEL, NINT and NFRAC for a frequency, false if out of range */
+    bool txrx_pll_plan(double ref_clock, double out_freq, int8_t &freqsel, int64_t &nint, int64_t &nfrac, double &actual_freq);
+
+    /** Sweep VCOCAP over [first, last] and find the window where VTUNE is normal.
+    Virtual so that an interface may run the sweep closer to the chip. */
+    virtual int vcocap_sweep(uint8_t reg, int first, int last, int &start_i, int &stop_i);
 
     bool get_txrx_pll_locked(uint8_t reg) {
         int comp = read_reg(reg + 0x0a) >> 6;
@@ -576,23 +696,39 @@ protected:
     }
 
     void lms_set_bits(uint8_t address, uint8_t mask) {
-        write_reg(address, read_reg(address) | (mask));
+        batch_write(address, batch_read(address) | (mask));
     }
     void lms_clear_bits(uint8_t address, uint8_t mask) {
-        write_reg(address, read_reg(address) & (~mask));
+        batch_write(address, batch_read(address) & (~mask));
     }
 
     uint8_t lms_write_bits(uint8_t address, uint8_t mask, uint8_t bits) {
-        uint8_t reg = read_reg(address);
-        write_reg(address,  (reg & (~mask)) | bits);
+        uint8_t reg = batch_read(address);
+        batch_write(address,  (reg & (~mask)) | bits);
         return reg;
     }
     uint8_t lms_read_shift(uint8_t address, uint8_t mask, uint8_t shift) {
-        return (read_reg(address) & mask) >> shift;
+        return (batch_read(address) & mask) >> shift;
     }
 
+    /** Register value for the field helpers, the pending one in a batch */
+    uint8_t batch_read(uint8_t address);
+    /** Register write for the field helpers, held back in a batch */
+    void batch_write(uint8_t address, uint8_t val);
+    void batch_begin();
+    void batch_end(bool commit);
+
     uint8_t _lpf_rccal;  // Saved value for RCCAL_LPFCAL
 
+    // Last good VCOCAP window per (PLL, FREQSEL, NINT), so a retune
+    // nearby only sweeps a few codes around it.
+    struct vcocap_window { int start; int stop; };
+    std::map<uint32_t, vcocap_window> _vcocap_cache;
+
+    // Open batch scopes and the registers they touched, see batch
+    int _batch_depth;
+    std::vector<uint8_t> _batch_addrs, _batch_vals;
+
 };
 
 #endif /* INCLUDED_LMS6002D_HPP */
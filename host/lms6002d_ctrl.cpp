@@ -4,6 +4,10 @@
 
 #include "lms6002d_ctrl.hpp"
 #include "lms6002d.hpp"
+#include "umtrx_fifo_ctrl.hpp"
+#include "usrp2/fw_common.h"
+#include "umtrx_trace.hpp"
+#include "umtrx_async_log.hpp"
 #include "cores/adf4350_regs.hpp"
 
 #include <uhd/utils/log.hpp>
@@ -18,11 +22,17 @@
 #include <uhd/usrp/dboard_manager.hpp>
 #include <boost/assign/list_of.hpp>
 #include <boost/format.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
 #include <boost/thread.hpp>
 #include <boost/array.hpp>
 #include <boost/math/special_functions/round.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <boost/filesystem.hpp>
 #include <utility>
+#include <fstream>
+#include <algorithm>
+#include <vector>
 #include <cmath>
 #include <cfloat>
 #include <limits>
@@ -104,34 +114,284 @@ static const uhd::dict<std::string, gain_range_t> lms_rx_gain_ranges = map_list_
 ;
 
 
+/***********************************************************************
+ * Gain distribution tables: the overall VGA gain in 1dB steps to the
+ * register codes of each stage, built once so a gain change is a lookup
+ **********************************************************************/
+struct lms_gain_step_t
+{
+    uint8_t vga1, vga2; //register codes
+    double gain; //dB the codes give
+};
+
+static const gain_range_t lms_rx_gain_total_range(5, 60, 1.0);
+static const gain_range_t lms_tx_gain_total_range(-35, 21, 1.0);
+
+//Rx: VGA1 first, ahead of the filter, VGA2 takes what is left in its 3dB steps
+static std::vector<lms_gain_step_t> make_rx_gain_table(void)
+{
+    const gain_range_t &vga1_range = lms_rx_gain_ranges["VGA1"]; //one range per code
+    const double vga1_max = vga1_range.stop();
+    std::vector<lms_gain_step_t> table;
+    for (double gain = lms_rx_gain_total_range.start(); gain <= lms_rx_gain_total_range.stop(); gain += 1.0)
+    {
+        const int vga2 = std::min(10, std::max(0, int(std::ceil((gain - vga1_max)/3))));
+        const double vga1_db = gain - vga2*3;
+        size_t code = 0;
+        for (size_t i = 1; i < vga1_range.size(); i++)
+        {
+            if (std::abs(vga1_range[i].start() - vga1_db) < std::abs(vga1_range[code].start() - vga1_db)) code = i;
+        }
+        lms_gain_step_t step;
+        step.vga1 = uint8_t(code);
+        step.vga2 = uint8_t(vga2);
+        step.gain = vga1_range[code].start() + vga2*3;
+        table.push_back(step);
+    }
+    return table;
+}
+
+//Tx: VGA2 first, like the order of lms_tx_gain_ranges
+static std::vector<lms_gain_step_t> make_tx_gain_table(void)
+{
+    std::vector<lms_gain_step_t> table;
+    for (int gain = int(lms_tx_gain_total_range.start()); gain <= int(lms_tx_gain_total_range.stop()); gain++)
+    {
+        const int above_min = gain - int(lms_tx_gain_total_range.start());
+        const int vga2 = std::min(25, above_min);
+        lms_gain_step_t step;
+        step.vga1 = uint8_t(above_min - vga2);
+        step.vga2 = uint8_t(vga2);
+        step.gain = gain;
+        table.push_back(step);
+    }
+    return table;
+}
+
+static const std::vector<lms_gain_step_t> lms_rx_gain_table = make_rx_gain_table();
+static const std::vector<lms_gain_step_t> lms_tx_gain_table = make_tx_gain_table();
+
+static const lms_gain_step_t &lookup_gain_step(const std::vector<lms_gain_step_t> &table, const gain_range_t &range, const double gain)
+{
+    const double index = boost::math::round(range.clip(gain) - range.start());
+    return table.at(std::min(table.size() - 1, size_t(std::max(0.0, index))));
+}
+
 static int verbosity = 0;
 
 // LMS6002D interface class for UmTRX
 
 class umtrx_lms6002d_dev: public lms6002d_dev {
     uhd::spi_iface::sptr _spiface;
+    umtrx_fifo_ctrl::sptr _burst_iface; //null when the spi iface has no burst support
+    umtrx_iface::sptr _zpu_iface; //null when the LMS loops stay on the host
     const int _slaveno;
+    const boost::uint32_t _zpu_minor; //firmware minor version, zero without _zpu_iface
+
+    // Shadow copy of the registers written by the host.
+    // Reads are served from it, except for registers the chip updates itself.
+    uint8_t _shadow[128];
+    bool _shadow_valid[128];
+
+    static bool is_volatile_reg(uint8_t addr) {
+        switch (addr) {
+            case 0x00: case 0x01: // TOP DC cal value and status, RCCAL_LPFCAL
+            case 0x30: case 0x31: // TX LPF DC cal value and status
+            case 0x50: case 0x51: // RX LPF DC cal value and status
+            case 0x60: case 0x61: // RX VGA2 DC cal value and status
+            case 0x1A: case 0x2A: // TX/RX PLL VTUNE comparators (lock, VCOCAP)
+                return true;
+        }
+        return false;
+    }
+
+    void spi_write(uint8_t addr, uint8_t data) {
+        uint16_t command = (((uint16_t)0x80 | (uint16_t)addr) << 8) | (uint16_t)data;
+        _spiface->write_spi(_slaveno, spi_config_t::EDGE_RISE, command, 16);
+    }
+    uint8_t spi_read(uint8_t addr) {
+        return _spiface->read_spi(_slaveno, spi_config_t::EDGE_RISE, addr << 8, 16);
+    }
+    void shadow_forget(uint8_t addr) {
+        if (addr < 128) _shadow_valid[addr] = false;
+    }
+    void shadow_store(uint8_t addr, uint8_t data) {
+        if (addr > 127 or is_volatile_reg(addr)) return;
+        _shadow[addr] = data;
+        _shadow_valid[addr] = true;
+    }
+    bool shadow_load(uint8_t addr, uint8_t &data) const {
+        if (not _shadow_valid[addr]) return false;
+        data = _shadow[addr];
+        return true;
+    }
+    //! A write is needed unless the chip already holds the value.
+    //! Timed writes always go out, the shadow runs ahead of the chip for them.
+    bool is_dirty(uint8_t addr, uint8_t data) {
+        uint8_t held = 0;
+        return not shadow_load(addr, held) or held != data or is_timed();
+    }
+
 public:
-    umtrx_lms6002d_dev(uhd::spi_iface::sptr spiface, const int slaveno) : _spiface(spiface), _slaveno(slaveno) {};
+    umtrx_lms6002d_dev(uhd::spi_iface::sptr spiface, const int slaveno, umtrx_iface::sptr zpu_iface) :
+        _spiface(spiface),
+        _burst_iface(UMTRX_UHD_PTR_NAMESPACE::dynamic_pointer_cast<umtrx_fifo_ctrl>(spiface)),
+        _zpu_iface(zpu_iface),
+        _slaveno(slaveno),
+        _zpu_minor((_zpu_iface and _burst_iface)? _zpu_iface->peekfw(U2_FW_REG_VER_MINOR) : 0) {
+        this->invalidate_shadow();
+    };
+
+    //! True when register writes are timed commands, see umtrx_fifo_ctrl::set_time()
+    bool is_timed() {
+        return _burst_iface and _burst_iface->get_time() != uhd::time_spec_t(0.0);
+    }
+
+    //! Forget the shadow copy, Ex: after the chip has been reset
+    void invalidate_shadow() {
+        std::fill(_shadow_valid, _shadow_valid + 128, false);
+    }
+
+    //! The registers the shadow holds
+    std::map<uint8_t, uint8_t> get_shadow() const {
+        std::map<uint8_t, uint8_t> regs;
+        for (size_t addr = 0; addr < 128; addr++) {
+            if (_shadow_valid[addr]) regs[uint8_t(addr)] = _shadow[addr];
+        }
+        return regs;
+    }
+
+    //! Write registers saved with get_shadow(), the ones already held are dropped
+    void restore_shadow(const std::map<uint8_t, uint8_t> &regs) {
+        std::vector<uint8_t> addrs, vals;
+        for (std::map<uint8_t, uint8_t>::const_iterator it = regs.begin(); it != regs.end(); ++it) {
+            if (it->first > 127 or is_volatile_reg(it->first)) continue;
+            addrs.push_back(it->first);
+            vals.push_back(it->second);
+        }
+        if (not addrs.empty()) write_regs(&addrs[0], &vals[0], addrs.size());
+    }
 
     virtual void write_reg(uint8_t addr, uint8_t data) {
         if (verbosity>2) printf("umtrx_lms6002d_dev::write_reg(addr=0x%x, data=0x%x)\n", addr, data);
-        uint16_t command = (((uint16_t)0x80 | (uint16_t)addr) << 8) | (uint16_t)data;
-        _spiface->write_spi(_slaveno, spi_config_t::EDGE_RISE, command, 16);
+        if (addr < 128 and not is_dirty(addr, data)) return;
+        spi_write(addr, data);
+        shadow_store(addr, data);
     }
     virtual uint8_t read_reg(uint8_t addr) {
         if(addr > 127) return 0; // incorrect address, 7 bit long expected
-        uint8_t data = _spiface->read_spi(_slaveno, spi_config_t::EDGE_RISE, addr << 8, 16);
+        uint8_t data = 0;
+        if (not shadow_load(addr, data)) {
+            data = spi_read(addr);
+            shadow_store(addr, data);
+        }
         if (verbosity>2) printf("umtrx_lms6002d_dev::read_reg(addr=0x%x) data=0x%x\n", addr, data);
         return data;
     }
+    //! The whole DC calibration in the firmware: one round trip instead of a dozen SPI ones
+    virtual int general_dc_calibration(uint8_t dc_addr, uint8_t calibration_reg_base) {
+        if (_zpu_minor < UMTRX_FW_LMS_DC_CAL_MINOR or is_timed()) {
+            return lms6002d_dev::general_dc_calibration(dc_addr, calibration_reg_base);
+        }
+        const uint32_t result = zpu_transact(UMTRX_ZPU_REQUEST_LMS_DC_CALIBRATION,
+            (uint32_t(_slaveno & 0xff) << 16) | (uint32_t(calibration_reg_base) << 8) | dc_addr);
+
+        //the firmware went around the shadow
+        shadow_forget(0x5F);
+        shadow_forget(0x6E);
+        for (uint8_t i = 0; i < 4; i++) shadow_forget(calibration_reg_base + i);
+        if (result & UMTRX_LMS_DC_CAL_FAILED) {
+            printf("Error: DC Offset Calibration does not converge!\n");
+            return -1;
+        }
+        if (verbosity > 0) printf("Successful DC Offset Calibration for register bank 0x%X, DC addr %d. Result: 0x%X\n",
+                                  calibration_reg_base, dc_addr, result);
+        return int(result & 0xff);
+    }
+
+    //! The VCOCAP sweep in the firmware, with its 50 us settling per step done locally
+    virtual int vcocap_sweep(uint8_t reg, int first, int last, int &start_i, int &stop_i) {
+        if (_zpu_minor < UMTRX_FW_LMS_VCOCAP_MINOR or is_timed()) {
+            return lms6002d_dev::vcocap_sweep(reg, first, last, start_i, stop_i);
+        }
+        const uint32_t result = zpu_transact(UMTRX_ZPU_REQUEST_LMS_VCOCAP_SWEEP,
+            (uint32_t(_slaveno & 0xff) << 24) | (uint32_t(reg) << 16) | ((last & 0x3f) << 8) | (first & 0x3f));
+        shadow_forget(reg + 0x9); //left at the last VCOCAP tried
+        if (result & UMTRX_LMS_VCOCAP_ERROR) {
+            printf("ERROR: Incorrect VCOCAP reading while tuning\n");
+            return -1;
+        }
+        start_i = int8_t(result & 0xff);
+        stop_i = int8_t((result >> 8) & 0xff);
+        if (verbosity>1) printf("VCOCAP sweep [%d, %d] window [%d, %d]\n", first, last, start_i, stop_i);
+        return 0;
+    }
+
+    //! Run a ZPU action with the SPI core to the firmware
+    uint32_t zpu_transact(uint32_t action, uint32_t data) {
+        uint32_t result = 0;
+        _burst_iface->with_spi_core(boost::bind(&umtrx_lms6002d_dev::send_zpu_action,
+            this, action, data, boost::ref(result)));
+        return result;
+    }
+    void send_zpu_action(uint32_t action, uint32_t data, uint32_t &result) {
+        result = _zpu_iface->send_zpu_action(action, data);
+    }
+
+    virtual void write_regs(const uint8_t *addrs, const uint8_t *vals, size_t num) {
+        if (not _burst_iface) return lms6002d_dev::write_regs(addrs, vals, num);
+        std::vector<umtrx_fifo_ctrl::spi_transaction_t> burst;
+        for (size_t i = 0; i < num; i++) {
+            if (verbosity>2) printf("umtrx_lms6002d_dev::write_regs(addr=0x%x, data=0x%x)\n", addrs[i], vals[i]);
+            if (addrs[i] < 128 and not is_dirty(addrs[i], vals[i])) continue;
+            umtrx_fifo_ctrl::spi_transaction_t t;
+            t.which_slave = _slaveno;
+            t.data = (((uint16_t)0x80 | (uint16_t)addrs[i]) << 8) | (uint16_t)vals[i];
+            t.num_bits = 16;
+            burst.push_back(t);
+        }
+        if (not burst.empty()) _burst_iface->transact_spi_burst(burst);
+        for (size_t i = 0; i < num; i++) shadow_store(addrs[i], vals[i]);
+    }
+    virtual void read_regs(const uint8_t *addrs, uint8_t *vals, size_t num) {
+        if (not _burst_iface) return lms6002d_dev::read_regs(addrs, vals, num);
+
+        //only the registers missing from the shadow go over SPI
+        std::vector<umtrx_fifo_ctrl::spi_transaction_t> burst;
+        std::vector<size_t> burst_index;
+        for (size_t i = 0; i < num; i++) {
+            vals[i] = 0;
+            if (addrs[i] > 127 or shadow_load(addrs[i], vals[i])) continue;
+            umtrx_fifo_ctrl::spi_transaction_t t;
+            t.which_slave = _slaveno;
+            t.data = addrs[i] << 8;
+            t.num_bits = 16;
+            t.readback = true;
+            burst.push_back(t);
+            burst_index.push_back(i);
+        }
+        if (not burst.empty()) {
+            const std::vector<boost::uint32_t> result = _burst_iface->transact_spi_burst(burst);
+            for (size_t j = 0; j < burst.size(); j++) {
+                const size_t i = burst_index[j];
+                vals[i] = uint8_t(result[j]);
+                shadow_store(addrs[i], vals[i]);
+            }
+        }
+        for (size_t i = 0; i < num; i++) {
+            if (verbosity>2) printf("umtrx_lms6002d_dev::read_regs(addr=0x%x) data=0x%x\n", addrs[i], vals[i]);
+        }
+    }
 };
 
 // LMS6002D virtual daughter board for UmTRX
 
 class lms6002d_ctrl_impl : public lms6002d_ctrl {
 public:
-    lms6002d_ctrl_impl(uhd::spi_iface::sptr spiface, const int lms_spi_number, const double clock_rate);
+    static const size_t NUM_CAL_CODES = 11;
+
+    lms6002d_ctrl_impl(uhd::spi_iface::sptr spiface, const int lms_spi_number, const double clock_rate,
+        const std::string &cal_file, const std::string &cal_conditions, umtrx_iface::sptr zpu_iface);
 
     double set_rx_freq(const double freq)
     {
@@ -165,6 +425,18 @@ public:
         return uhd::sensor_value_t("LO", lms.get_tx_pll_locked(), "locked", "unlocked");
     }
 
+    uhd::sensor_value_t get_rx_tune_time()
+    {
+        boost::recursive_mutex::scoped_lock l(_mutex);
+        return uhd::sensor_value_t("LO tune time", _rx_tune_time, "s");
+    }
+
+    uhd::sensor_value_t get_tx_tune_time()
+    {
+        boost::recursive_mutex::scoped_lock l(_mutex);
+        return uhd::sensor_value_t("LO tune time", _tx_tune_time, "s");
+    }
+
     uhd::freq_range_t get_rx_bw_range(void)
     {
         return lms_bandwidth_range;
@@ -234,10 +506,26 @@ protected:
         if (verbosity>0) printf("lms6002d_ctrl_impl::set_freq(%f)\n", f);
         unsigned ref_freq = _clock_rate;
         double actual_freq = 0;
-        if (unit==dboard_iface::UNIT_TX) {
+        umtrx_trace_scope trace((unit==dboard_iface::UNIT_TX)? "tx_tune" : "rx_tune");
+        const boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+        // With a command time set, the VCOCAP sweep can't run: its readbacks would
+        // stall until that time. Write the registers from the VCOCAP cache instead.
+        double hop_freq = -1;
+        if (lms.is_timed()) {
+            hop_freq = (unit==dboard_iface::UNIT_TX)? lms.tx_pll_hop(ref_freq, f) : lms.rx_pll_hop(ref_freq, f);
+            if (hop_freq < 0) UMTRX_MSG_ASYNC(warning) << boost::format("LMS%d: no VCOCAP cached for a timed retune to %f MHz, "
+                "tune to this frequency once before hopping to it") % _lms_spi_number % (f/1e6) << std::endl;
+        }
+        if (hop_freq >= 0) {
+            actual_freq = hop_freq;
+            const double tune_time = (boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds()/1e6;
+            ((unit==dboard_iface::UNIT_TX)? _tx_tune_time : _rx_tune_time) = tune_time;
+        } else if (unit==dboard_iface::UNIT_TX) {
             actual_freq = lms.tx_pll_tune(ref_freq, f);
+            _tx_tune_time = (boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds()/1e6;
         } else if (unit==dboard_iface::UNIT_RX) {
             actual_freq = lms.rx_pll_tune(ref_freq, f);
+            _rx_tune_time = (boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds()/1e6;
         } else {
             assert(!"Wrong units_t value passed to lms6002d_ctrl_impl::set_freq()");
         }
@@ -279,6 +567,41 @@ protected:
         return gain;
     }
 
+    double get_rx_gain(const std::string &name) {
+        boost::recursive_mutex::scoped_lock l(_mutex);
+        assert_has(lms_rx_gain_ranges.keys(), name, "LMS6002D rx gain name");
+        if(name == "VGA1") return lms.get_rx_vga1gain();
+        if(name == "VGA2") return lms.get_rx_vga2gain();
+        UHD_THROW_INVALID_CODE_PATH();
+        return 0.0;
+    }
+
+    double set_rx_gain_total(const double gain) {
+        boost::recursive_mutex::scoped_lock l(_mutex);
+        const lms_gain_step_t &step = lookup_gain_step(lms_rx_gain_table, lms_rx_gain_total_range, gain);
+        if (verbosity>1) printf("lms6002d_ctrl_impl::set_rx_gain_total(%f) VGA1=%d VGA2=%d\n", gain, int(step.vga1), int(step.vga2));
+        lms.set_rx_vga_codes(step.vga1, step.vga2);
+        return step.gain;
+    }
+
+    double set_tx_gain_total(const double gain) {
+        boost::recursive_mutex::scoped_lock l(_mutex);
+        const lms_gain_step_t &step = lookup_gain_step(lms_tx_gain_table, lms_tx_gain_total_range, gain);
+        if (verbosity>1) printf("lms6002d_ctrl_impl::set_tx_gain_total(%f) VGA1=%d VGA2=%d\n", gain, int(step.vga1), int(step.vga2));
+        lms.set_tx_vga_codes(step.vga1, step.vga2);
+        return step.gain;
+    }
+
+    uhd::gain_range_t get_rx_gain_total_range(void)
+    {
+        return lms_rx_gain_total_range;
+    }
+
+    uhd::gain_range_t get_tx_gain_total_range(void)
+    {
+        return lms_tx_gain_total_range;
+    }
+
     void set_rx_ant(const std::string &ant) {
         boost::recursive_mutex::scoped_lock l(_mutex);
         if (verbosity>0) printf("lms6002d_ctrl_impl::set_rx_ant(%s)\n", ant.c_str());
@@ -502,6 +825,102 @@ protected:
     }
 
 private:
+    bool load_auto_calibration(const std::string &cal_file, const std::string &conditions)
+    {
+        std::ifstream in(cal_file.c_str());
+        if (not in) return false;
+
+        std::string stored_conditions;
+        std::getline(in, stored_conditions);
+        if (stored_conditions != conditions) return false;
+
+        std::vector<int> codes(NUM_CAL_CODES);
+        for (size_t i = 0; i < codes.size(); i++)
+        {
+            if (not (in >> codes[i])) return false;
+        }
+        return this->set_calibration_codes(codes);
+    }
+
+    //! The auto-calibration codes in the order of the cal file
+    std::vector<int> get_calibration_codes(void)
+    {
+        lms6002d_dev::auto_calibration_values cal;
+        lms.get_auto_calibration(cal);
+        std::vector<int> codes;
+        codes.push_back(cal.lpf_dccal);
+        codes.push_back(cal.rccal);
+        for (size_t i = 0; i < 2; i++) codes.push_back(cal.tx_lpf_dc[i]);
+        for (size_t i = 0; i < 2; i++) codes.push_back(cal.rx_lpf_dc[i]);
+        for (size_t i = 0; i < 5; i++) codes.push_back(cal.rxvga2_dc[i]);
+        return codes;
+    }
+
+    bool set_calibration_codes(const std::vector<int> &codes)
+    {
+        if (codes.size() != NUM_CAL_CODES) return false;
+        for (size_t i = 0; i < codes.size(); i++)
+        {
+            if (codes[i] < 0 or codes[i] > 0x3f) return false;
+        }
+        lms6002d_dev::auto_calibration_values cal;
+        cal.lpf_dccal = codes[0];
+        cal.rccal = codes[1];
+        for (size_t i = 0; i < 2; i++) cal.tx_lpf_dc[i] = codes[2+i];
+        for (size_t i = 0; i < 2; i++) cal.rx_lpf_dc[i] = codes[4+i];
+        for (size_t i = 0; i < 5; i++) cal.rxvga2_dc[i] = codes[6+i];
+        lms.set_auto_calibration(cal);
+        return true;
+    }
+
+    state_t get_state(void)
+    {
+        boost::recursive_mutex::scoped_lock l(_mutex);
+        state_t state;
+        state.regs = lms.get_shadow();
+        state.calibration = this->get_calibration_codes();
+        state.vcocap = lms.get_vcocap_cache();
+        return state;
+    }
+
+    void set_state(const state_t &state)
+    {
+        boost::recursive_mutex::scoped_lock l(_mutex);
+        lms.restore_shadow(state.regs);
+        if (not state.calibration.empty() and not this->set_calibration_codes(state.calibration))
+        {
+            UHD_MSG(warning) << "LMS" << _lms_spi_number << ": bad calibration codes in the saved state" << std::endl;
+        }
+        lms.set_vcocap_cache(state.vcocap);
+    }
+
+    void store_auto_calibration(const std::string &cal_file, const std::string &conditions)
+    {
+        const std::vector<int> codes = this->get_calibration_codes();
+
+        //write aside and rename, so a concurrent open never reads a partial file
+        namespace fs = boost::filesystem;
+        const fs::path path(cal_file);
+        const fs::path tmp_path(cal_file + ".tmp");
+        try
+        {
+            fs::create_directories(path.parent_path());
+            {
+                std::ofstream out(tmp_path.string().c_str());
+                out << conditions << std::endl;
+                for (size_t i = 0; i < codes.size(); i++) out << (i? " " : "") << codes[i];
+                out << std::endl;
+                if (not out) throw std::runtime_error("write failed");
+            }
+            fs::rename(tmp_path, path);
+        }
+        catch (const std::exception &ex)
+        {
+            UHD_MSG(warning) << "LMS" << _lms_spi_number << ": cannot store calibration to "
+                << cal_file << ": " << ex.what() << std::endl;
+        }
+    }
+
     umtrx_lms6002d_dev lms;        // Interface to the LMS chip.
     int tx_vga1gain, tx_vga2gain;  // Stored values of Tx VGA1 and VGA2 gains.
     bool rf_loopback_enabled;      // Whether RF loopback is enabled.
@@ -509,29 +928,36 @@ private:
     uhd::spi_iface::sptr _spiface;
     const int _lms_spi_number;
     const double _clock_rate;
+    double _rx_tune_time, _tx_tune_time; // Duration of the last retune, seconds.
 
     boost::recursive_mutex _mutex;
 };
 
-lms6002d_ctrl::sptr lms6002d_ctrl::make(uhd::spi_iface::sptr spiface, const int lms_spi_number, const double clock_rate)
+lms6002d_ctrl::sptr lms6002d_ctrl::make(uhd::spi_iface::sptr spiface, const int lms_spi_number, const double clock_rate,
+    const std::string &cal_file, const std::string &cal_conditions, umtrx_iface::sptr zpu_iface)
 {
-    return sptr(new lms6002d_ctrl_impl(spiface, lms_spi_number, clock_rate));
+    return sptr(new lms6002d_ctrl_impl(spiface, lms_spi_number, clock_rate, cal_file, cal_conditions, zpu_iface));
 }
 
 // LMS RX dboard configuration
 
-lms6002d_ctrl_impl::lms6002d_ctrl_impl(uhd::spi_iface::sptr spiface, const int lms_spi_number, const double clock_rate) :
-                                             lms(umtrx_lms6002d_dev(spiface, lms_spi_number)),
+lms6002d_ctrl_impl::lms6002d_ctrl_impl(uhd::spi_iface::sptr spiface, const int lms_spi_number, const double clock_rate,
+                                       const std::string &cal_file, const std::string &cal_conditions,
+                                       umtrx_iface::sptr zpu_iface) :
+                                             lms(umtrx_lms6002d_dev(spiface, lms_spi_number, zpu_iface)),
                                              tx_vga1gain(lms.get_tx_vga1gain()),
                                              tx_vga2gain(lms.get_tx_vga2gain()),
                                              rf_loopback_enabled(false),
                                              _spiface(spiface),
                                              _lms_spi_number(lms_spi_number),
-                                             _clock_rate(clock_rate)
+                                             _clock_rate(clock_rate),
+                                             _rx_tune_time(0.0),
+                                             _tx_tune_time(0.0)
 {
     ////////////////////////////////////////////////////////////////////
     // LMS6002D initialization
     ////////////////////////////////////////////////////////////////////
+    const boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
     lms.init();
     // Set proper values for Tx and Rx Fsync and IQ interleaving.
     lms.set_txrx_polarity_and_interleaving(0, lms6002d_dev::INTERLEAVE_IQ, 1, lms6002d_dev::INTERLEAVE_QI);
@@ -542,7 +968,21 @@ lms6002d_ctrl_impl::lms6002d_ctrl_impl(uhd::spi_iface::sptr spiface, const int l
     // -10dB is a good value for calibration if don't know a target gain yet
     lms.set_tx_vga1gain(-10);
 
-    // Perform autocalibration
-    lms.auto_calibration(_clock_rate, 0xf);
+    const boost::posix_time::ptime t1 = boost::posix_time::microsec_clock::universal_time();
+
+    // Perform autocalibration, unless one was stored for the same conditions
+    static const int lpf_bandwidth_code = 0xf;
+    const std::string conditions = str(boost::format("%s lpf=%d clock=%.0f")
+        % cal_conditions % lpf_bandwidth_code % _clock_rate);
+    const bool restored = not cal_file.empty() and load_auto_calibration(cal_file, conditions);
+    if (not restored)
+    {
+        lms.auto_calibration(_clock_rate, lpf_bandwidth_code);
+        if (not cal_file.empty()) store_auto_calibration(cal_file, conditions);
+    }
+    const boost::posix_time::ptime t2 = boost::posix_time::microsec_clock::universal_time();
+    UHD_MSG(status) << boost::format("LMS%d: init %.3fs, calibration %.3fs%s")
+        % _lms_spi_number % ((t1 - t0).total_microseconds()/1e6) % ((t2 - t1).total_microseconds()/1e6)
+        % (restored? " (restored)" : "") << std::endl;
 }
 
@@ -4,7 +4,10 @@
 #include <uhd/types/ranges.hpp>
 #include <uhd/types/serial.hpp>
 #include <uhd/types/sensors.hpp>
+#include "umtrx_iface.hpp"
 #include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+#include <map>
 #include <vector>
 #include <string>
 
@@ -15,7 +18,17 @@ class lms6002d_ctrl
 {
 public:
     typedef boost::shared_ptr<lms6002d_ctrl> sptr;
-    static sptr make(uhd::spi_iface::sptr spiface, const int lms_spi_number, const double clock_rate);
+
+    /*!
+     * Make a new controller, initializing and calibrating the chip.
+     * When cal_file is set, the auto-calibration result is restored from it
+     * if it was stored under the same cal_conditions, and saved to it otherwise.
+     * When zpu_iface is set, the DC calibrations and VCOCAP sweeps run in
+     * the firmware if it is recent enough, only the results come back.
+     */
+    static sptr make(uhd::spi_iface::sptr spiface, const int lms_spi_number, const double clock_rate,
+        const std::string &cal_file = "", const std::string &cal_conditions = "",
+        umtrx_iface::sptr zpu_iface = umtrx_iface::sptr());
 
     virtual double set_rx_freq(const double freq) = 0;
     virtual double set_tx_freq(const double freq) = 0;
@@ -26,9 +39,22 @@ public:
     virtual uhd::sensor_value_t get_rx_pll_locked() = 0;
     virtual uhd::sensor_value_t get_tx_pll_locked() = 0;
 
+    //! Duration of the last PLL retune in seconds
+    virtual uhd::sensor_value_t get_rx_tune_time() = 0;
+    virtual uhd::sensor_value_t get_tx_tune_time() = 0;
+
     virtual double set_rx_gain(const double gain, const std::string &name) = 0;
+    //! Gain of a stage as the chip has it, read over SPI
+    virtual double get_rx_gain(const std::string &name) = 0;
     virtual double set_tx_gain(const double gain, const std::string &name) = 0;
 
+    //! Overall VGA gain, split by a precomputed table and written in one batch.
+    //! The per stage gains are not told, their properties keep their last values.
+    virtual double set_rx_gain_total(const double gain) = 0;
+    virtual double set_tx_gain_total(const double gain) = 0;
+    virtual uhd::gain_range_t get_rx_gain_total_range(void) = 0;
+    virtual uhd::gain_range_t get_tx_gain_total_range(void) = 0;
+
     virtual void set_rx_ant(const std::string &ant) = 0;
     virtual void set_tx_ant(const std::string &ant) = 0;
 
@@ -74,6 +100,19 @@ public:
     virtual uint8_t get_rxvga2b_dc_i() = 0;
     virtual void set_rxvga2b_dc_q(uint8_t value) = 0;
     virtual uint8_t get_rxvga2b_dc_q() = 0;
+
+    //! What a restart can carry over instead of learning it again
+    struct state_t
+    {
+        std::map<uint8_t, uint8_t> regs; //the register shadow
+        std::vector<int> calibration; //auto-calibration codes, as in the cal file
+        std::map<boost::uint32_t, std::pair<int, int> > vcocap; //VCOCAP windows by cache key
+    };
+
+    virtual state_t get_state(void) = 0;
+
+    //! Registers in one SPI burst, then the calibration codes and VCOCAP windows
+    virtual void set_state(const state_t &state) = 0;
 };
 
 #endif /* INCLUDED_LMS6002D_CTRL_HPP */
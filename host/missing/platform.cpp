@@ -18,11 +18,16 @@
 #include "platform.hpp"
 #include <uhd/config.hpp>
 #include <boost/functional/hash.hpp>
+#include <boost/format.hpp>
 #ifdef UHD_PLATFORM_WIN32
 #include <Windows.h>
 #else
 #include <unistd.h>
 #endif
+#ifdef UHD_PLATFORM_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace uhd {
 
@@ -55,4 +60,54 @@ namespace uhd {
         boost::hash_combine(hash, uhd::get_host_id());
         return boost::uint32_t(hash);
     }
+
+    bool set_thread_affinity(const size_t cpu) {
+#ifdef UHD_PLATFORM_LINUX
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    bool set_thread_rt_priority(const int priority) {
+#ifdef UHD_PLATFORM_LINUX
+        struct sched_param param;
+        param.sched_priority = priority;
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+        (void)priority;
+        return false;
+#endif
+    }
+
+    std::string get_thread_placement(void) {
+#ifdef UHD_PLATFORM_LINUX
+        std::string cpus;
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) == 0) {
+            //compact ranges, ex: 0-3,6
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (not CPU_ISSET(cpu, &cpuset)) continue;
+                int last = cpu;
+                while (last+1 < CPU_SETSIZE and CPU_ISSET(last+1, &cpuset)) last++;
+                if (not cpus.empty()) cpus += ",";
+                cpus += (last == cpu)? str(boost::format("%d") % cpu) : str(boost::format("%d-%d") % cpu % last);
+                cpu = last;
+            }
+        }
+        int policy = SCHED_OTHER;
+        struct sched_param param;
+        param.sched_priority = 0;
+        pthread_getschedparam(pthread_self(), &policy, &param);
+        const char *name = (policy == SCHED_FIFO)? "SCHED_FIFO" : (policy == SCHED_RR)? "SCHED_RR" : "SCHED_OTHER";
+        return str(boost::format("cpus %s, %s %d") % (cpus.empty()? "?" : cpus) % name % param.sched_priority);
+#else
+        return "placement unknown";
+#endif
+    }
 }
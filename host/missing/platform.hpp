@@ -19,6 +19,8 @@
 #define INCLUDED_UHD_UTILS_PLATFORM_HPP_COPY
 
 #include <boost/cstdint.hpp>
+#include <cstddef>
+#include <string>
 
 namespace uhd {
 
@@ -31,6 +33,15 @@ namespace uhd {
     /* Get a unique identifier for the current machine and process */
     boost::uint32_t get_process_hash();
 
+    /* Pin the calling thread to a single CPU, returns false when unsupported */
+    bool set_thread_affinity(const size_t cpu);
+
+    /* Run the calling thread SCHED_FIFO at priority (1-99), returns false when unsupported or not permitted */
+    bool set_thread_rt_priority(const int priority);
+
+    /* Describe the CPUs and scheduling of the calling thread, ex: "cpus 2-3, SCHED_FIFO 50" */
+    std::string get_thread_placement(void);
+
 } //namespace uhd
 
 #endif /* INCLUDED_UHD_UTILS_PLATFORM_HPP_COPY */
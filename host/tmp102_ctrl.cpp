@@ -73,7 +73,12 @@ double tmp102_ctrl::get_temp()
         if (i == TMP102_POLL_RDY_WATCHDOG)
             return nan("");
     }
-    int16_t tmp = (int16_t)get_reg(REG_TEMP);
+    return raw_to_temp(get_reg(REG_TEMP));
+}
+
+double tmp102_ctrl::raw_to_temp(uint16_t raw)
+{
+    int16_t tmp = (int16_t)raw;
     if (tmp & 0x001) {
         tmp >>= 3;
     } else {
@@ -107,6 +112,13 @@ void tmp102_ctrl::set_shutdown_mode(bool shutdown_mode)
     set_reg(REG_CONF, _config);
 }
 
+void tmp102_ctrl::set_continuous(conversion_rate rate)
+{
+    _config &= ~(CONF_SD | CONF_CR_MASK);
+    _config |= (rate << CONF_CR_OFFS) & CONF_CR_MASK;
+    set_reg(REG_CONF, _config);
+}
+
 uint16_t tmp102_ctrl::get_reg(tmp102_regs reg)
 {
     byte_vector_t cmd = boost::assign::list_of(reg);
@@ -57,8 +57,14 @@ public:
         void set_ex_mode(bool ex_mode);
         void set_shutdown_mode(bool shutdown_mode);
 
+        /** @brief convert continuously at @ref rate, get_temp() is then one register read */
+        void set_continuous(conversion_rate rate);
+
         double get_temp();
 
+        /** @brief convert a raw temperature register to degC */
+        static double raw_to_temp(uint16_t raw);
+
 private:
         enum tmp102_regs {
             REG_TEMP  = 0,
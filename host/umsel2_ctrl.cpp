@@ -16,10 +16,13 @@
 
 #include "umsel2_ctrl.hpp"
 #include "umtrx_regs.hpp"
+#include "umtrx_log_adapter.hpp"
+#include "umtrx_async_log.hpp"
 #include <uhd/exception.hpp>
 #include <boost/thread.hpp>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include <map>
 
 static const int REG0_NVALUE_SHIFT = 4;
@@ -99,6 +102,12 @@ static const int REG12_RESYNC_CLOCK_MASK = ((1<<16)-1);
 static const int REG12_RESERVED_SHIFT = 4;
 static const int REG12_RESERVED_VALUE = 0x41;
 
+//largest VCO step tuned without a VCO calibration, well within one band
+static const double FAST_LOCK_MAX_VCO_STEP = 1e6;
+//longest wait for the lock detect after a tune
+static const long LOCK_TIMEOUT_US = 10000;
+static const size_t MAX_CACHED_PLANS = 4096;
+
 #define MODIFY_FIELD(reg, val, mask, shift) \
     reg = ((reg & ~(mask << shift)) | ((val & mask) << shift))
 
@@ -106,8 +115,8 @@ class umsel2_ctrl_impl : public umsel2_ctrl
 {
 public:
 
-    umsel2_ctrl_impl(uhd::wb_iface::sptr ctrl, uhd::spi_iface::sptr spiface, const double ref_clock, const bool verbose):
-        _ctrl(ctrl), _spiface(spiface), _ref_clock(ref_clock), verbose(verbose)
+    umsel2_ctrl_impl(uhd::wb_iface::sptr ctrl, uhd::spi_iface::sptr spiface, const double ref_clock, const bool verbose, const bool fast_lock):
+        _ctrl(ctrl), _spiface(spiface), _ref_clock(ref_clock), verbose(verbose), _fast_lock(fast_lock)
     {
         this->init_synth(SPI_SS_AUX1);
         this->init_synth(SPI_SS_AUX2);
@@ -166,6 +175,25 @@ public:
         return this->tune_synth(slaveno, freq);
     }
 
+    double prepare_rx_freq(const int which, const double freq)
+    {
+        const int slaveno = (which == 1)?SPI_SS_AUX1 : SPI_SS_AUX2;
+        this->set_output(slaveno, false);
+        return this->tune_synth(slaveno, freq);
+    }
+
+    void select_rx_output(const int which)
+    {
+        //off first, the two outputs never drive the LO port together
+        this->set_output((which == 1)?SPI_SS_AUX2 : SPI_SS_AUX1, false);
+        this->set_output((which == 1)?SPI_SS_AUX1 : SPI_SS_AUX2, true);
+    }
+
+    uhd::sensor_value_t get_tune_time(const int which)
+    {
+        return uhd::sensor_value_t("LO tune time", _tune_time[which], "s");
+    }
+
     uhd::sensor_value_t get_locked(const int which)
     {
         boost::uint32_t irq = _ctrl->peek32(U2_REG_IRQ_RB);
@@ -308,9 +336,7 @@ private:
         //phase resync 0
         MODIFY_FIELD(_regs[slaveno][12], 0, REG12_RESYNC_CLOCK_MASK, REG12_RESYNC_CLOCK_SHIFT);
 
-        //write all registers
-        for (int addr = 12; addr >= 0; addr--)
-            this->write_reg(slaveno, addr);
+        this->commit(slaveno);
     }
 
     void pd_synth(const int slaveno)
@@ -328,15 +354,29 @@ private:
         MODIFY_FIELD(_regs[slaveno][6], 0, 0x1, REG6_AUX_PWR_EN_SHIFT);
         MODIFY_FIELD(_regs[slaveno][6], 0, 0x1, REG6_PWR_EN_SHIFT);
 
-        //write all registers
-        for (int addr = 12; addr >= 0; addr--)
-            this->write_reg(slaveno, addr);
+        this->commit(slaveno);
     }
 
-    double tune_synth(const int slaveno, const double RFout)
+    void set_output(const int slaveno, const bool enb)
+    {
+        MODIFY_FIELD(_regs[slaveno][6], enb?1:0, 0x1, REG6_PWR_EN_SHIFT);
+        this->write_reg_changed(slaveno, 6);
+    }
+
+    //! Register values of one frequency, independent of the synth
+    struct synth_plan_t
+    {
+        int NINT, FRAC1, FRAC2, MOD2, PRESCALER;
+        int RDIV, REFDIV, REFDBL, RFOUTDIVSEL;
+        int VCObanddiv, ALC, SLT, TIMEOUT, ADC_CLK_DIV;
+        long adcWaitUs; //ADC conversion before the VCO calibration
+        double VCOout, RFoutactual;
+    };
+
+    synth_plan_t plan_synth(const double RFout)
     {
-        if (verbose) std::cout << " tune_synth(slaveno=" << slaveno << ")" << std::endl;
         if (verbose) std::cout << " RFout " << (RFout/1e6) << " MHz" << std::endl;
+        synth_plan_t plan;
 
         //determine the reference out divider and VCOout
         double VCOout = 0;
@@ -398,64 +438,152 @@ private:
         int TIMEOUT = std::ceil((fPFD*50e-6)/ALC);
         if (verbose) std::cout << " TIMEOUT " << TIMEOUT << "" << std::endl;
 
-        //ADC Clock Divider (ADC_CLK_DIV)
-        //PFD/((ADC_CLK_DIV × 4) × 2) < 100 kHz
-        /*
-        int ADC_CLK_DIV = 1;
-        while (not(fPFD/((ADC_CLK_DIV*4)*2) < 100e3)) ADC_CLK_DIV++;
+        //ADC Clock Divider (ADC_CLK_DIV), the datasheet formula for an ADC clock
+        //under 100 kHz, the ADI GUI gives the same 65 for a 26 MHz PFD.
+        //The ADC needs 16 of its clocks before the VCO calibration starts.
+        int ADC_CLK_DIV = std::max(1, std::min(REG10_ADC_CLK_DIV_MASK, int(std::ceil((fPFD/100e3 - 2)/4))));
+        const double ADC_CLK = fPFD/(ADC_CLK_DIV*4 + 2);
         if (verbose) std::cout << " ADC_CLK_DIV " << ADC_CLK_DIV << "" << std::endl;
-        const long sleepUs = long(1e6*16*ADC_CLK_DIV/fPFD);
-        */
-
-        //Copied from the ADI GUI
-        //after trying to juxtapose the documentation with the GUI
-        int ADC_CLK_DIV = 65;
-        const long sleepUs = 160;
 
-        //load registers
-        MODIFY_FIELD(_regs[slaveno][0], NINT, REG0_NVALUE_MASK, REG0_NVALUE_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][0], PRESCALER, 0x1, REG0_PRESCALER_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][0], 1/*enb*/, 0x1, REG0_AUTOCAL_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][1], FRAC1, REG1_MFRAC_MASK, REG1_MFRAC_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][2], MOD2, REG2_AUX_MOD_MASK, REG2_AUX_MOD_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][2], FRAC2, REG2_AUX_FRAC_MASK, REG2_AUX_FRAC_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][4], RDIV, REG4_R_MASK, REG4_R_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][4], REFDIV, 0x1, REG4_REF_DIV_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][4], REFDBL, 0x1, REG4_REF_DBL_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][6], RFOUTDIVSEL, REG6_RF_DIV_MASK, REG6_RF_DIV_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][9], SLT, REG9_SYNT_LOCK_TO_MASK, REG9_SYNT_LOCK_TO_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][9], ALC, REG9_AUTO_LVL_TO_MASK, REG9_AUTO_LVL_TO_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][9], TIMEOUT, REG9_TIMEOUT_MASK, REG9_TIMEOUT_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][9], VCObanddiv, REG9_VCO_BAND_MASK, REG9_VCO_BAND_SHIFT);
-        MODIFY_FIELD(_regs[slaveno][10], ADC_CLK_DIV, REG10_ADC_CLK_DIV_MASK, REG10_ADC_CLK_DIV_SHIFT);
-
-        //write other registers
-        this->write_reg(slaveno, 6);
-        this->write_reg(slaveno, 9);
-        this->write_reg(slaveno, 10);
-
-        //FREQUENCY UPDATE SEQUENCE
-        MODIFY_FIELD(_regs[slaveno][4], 1, 0x1, REG4_CNTR_RESET);
-        this->write_reg(slaveno, 4);
-        this->write_reg(slaveno, 2);
-        this->write_reg(slaveno, 1);
-        MODIFY_FIELD(_regs[slaveno][0], 0, 0x1, REG0_AUTOCAL_SHIFT);
-        this->write_reg(slaveno, 0);
-        MODIFY_FIELD(_regs[slaveno][4], 0, 0x1, REG4_CNTR_RESET);
-        this->write_reg(slaveno, 4);
-        boost::this_thread::sleep(boost::posix_time::microseconds(sleepUs));
-        if (verbose) std::cout << " sleep time " << (sleepUs) << " us" << std::endl;
-        MODIFY_FIELD(_regs[slaveno][0], 1, 0x1, REG0_AUTOCAL_SHIFT);
-        this->write_reg(slaveno, 0);
+        plan.NINT = NINT;
+        plan.FRAC1 = FRAC1;
+        plan.FRAC2 = FRAC2;
+        plan.MOD2 = MOD2;
+        plan.PRESCALER = PRESCALER;
+        plan.RDIV = RDIV;
+        plan.REFDIV = REFDIV;
+        plan.REFDBL = REFDBL;
+        plan.RFOUTDIVSEL = RFOUTDIVSEL;
+        plan.VCObanddiv = VCObanddiv;
+        plan.ALC = ALC;
+        plan.SLT = SLT;
+        plan.TIMEOUT = TIMEOUT;
+        plan.ADC_CLK_DIV = ADC_CLK_DIV;
+        plan.adcWaitUs = long(std::ceil(1e6*16/ADC_CLK));
+        plan.VCOout = VCOout;
 
         //calculate actual tune value
         double Nactual = NINT + std::ldexp(double(FRAC1 + FRAC2/double(MOD2)), -24);
-        double RFoutactual = (fPFD*Nactual)/(1 << RFOUTDIVSEL);
+        plan.RFoutactual = (fPFD*Nactual)/(1 << RFOUTDIVSEL);
         if (verbose) std::cout << " Nactual " << Nactual << "" << std::endl;
-        if (verbose) std::cout << " RFoutactual " << (RFoutactual/1e6) << " MHz" << std::endl;
-        if (verbose) boost::this_thread::sleep(boost::posix_time::microseconds(10000));
-        if (verbose) std::cout << " Locked " << this->get_locked((slaveno==SPI_SS_AUX1)?1:2).value << "" << std::endl;
-        return RFoutactual;
+        if (verbose) std::cout << " RFoutactual " << (plan.RFoutactual/1e6) << " MHz" << std::endl;
+        return plan;
+    }
+
+    //! Plans are kept per requested Hz, a hopping set is planned once
+    const synth_plan_t &get_plan(const double RFout)
+    {
+        const long long key = (long long)(std::floor(RFout + 0.5));
+        std::map<long long, synth_plan_t>::const_iterator it = _plans.find(key);
+        if (it != _plans.end()) return it->second;
+        if (_plans.size() >= MAX_CACHED_PLANS) _plans.clear();
+        return _plans[key] = this->plan_synth(RFout);
+    }
+
+    double tune_synth(const int slaveno, const double RFout)
+    {
+        if (verbose) std::cout << " tune_synth(slaveno=" << slaveno << ")" << std::endl;
+        const boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+        const synth_plan_t plan = this->get_plan(RFout);
+
+        //a small step with the same dividers stays in the VCO band, it needs no VCO calibration
+        const std::map<int, synth_plan_t>::const_iterator last = _last_plan.find(slaveno);
+        const bool fast = _fast_lock and last != _last_plan.end()
+            and last->second.RFOUTDIVSEL == plan.RFOUTDIVSEL and last->second.RDIV == plan.RDIV
+            and std::abs(plan.VCOout - last->second.VCOout) <= FAST_LOCK_MAX_VCO_STEP;
+        _last_plan.erase(slaveno); //until it locked
+
+        //load registers
+        MODIFY_FIELD(_regs[slaveno][0], plan.NINT, REG0_NVALUE_MASK, REG0_NVALUE_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][0], plan.PRESCALER, 0x1, REG0_PRESCALER_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][1], plan.FRAC1, REG1_MFRAC_MASK, REG1_MFRAC_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][2], plan.MOD2, REG2_AUX_MOD_MASK, REG2_AUX_MOD_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][2], plan.FRAC2, REG2_AUX_FRAC_MASK, REG2_AUX_FRAC_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][4], plan.RDIV, REG4_R_MASK, REG4_R_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][4], plan.REFDIV, 0x1, REG4_REF_DIV_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][4], plan.REFDBL, 0x1, REG4_REF_DBL_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][6], plan.RFOUTDIVSEL, REG6_RF_DIV_MASK, REG6_RF_DIV_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][9], plan.SLT, REG9_SYNT_LOCK_TO_MASK, REG9_SYNT_LOCK_TO_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][9], plan.ALC, REG9_AUTO_LVL_TO_MASK, REG9_AUTO_LVL_TO_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][9], plan.TIMEOUT, REG9_TIMEOUT_MASK, REG9_TIMEOUT_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][9], plan.VCObanddiv, REG9_VCO_BAND_MASK, REG9_VCO_BAND_SHIFT);
+        MODIFY_FIELD(_regs[slaveno][10], plan.ADC_CLK_DIV, REG10_ADC_CLK_DIV_MASK, REG10_ADC_CLK_DIV_SHIFT);
+
+        bool locked = false;
+        if (fast)
+        {
+            //new N with the autocal off, the VCO keeps its band
+            this->write_reg(slaveno, 2);
+            this->write_reg(slaveno, 1);
+            MODIFY_FIELD(_regs[slaveno][0], 0, 0x1, REG0_AUTOCAL_SHIFT);
+            this->write_reg(slaveno, 0);
+            locked = this->wait_locked(slaveno);
+            if (verbose) std::cout << " fast lock " << (locked? "locked" : "failed, calibrating") << std::endl;
+        }
+
+        if (not locked)
+        {
+            //write other registers, only when they changed
+            this->write_reg_changed(slaveno, 6);
+            this->write_reg_changed(slaveno, 9);
+            this->write_reg_changed(slaveno, 10);
+
+            //FREQUENCY UPDATE SEQUENCE
+            MODIFY_FIELD(_regs[slaveno][4], 1, 0x1, REG4_CNTR_RESET);
+            this->write_reg(slaveno, 4);
+            this->write_reg(slaveno, 2);
+            this->write_reg(slaveno, 1);
+            MODIFY_FIELD(_regs[slaveno][0], 0, 0x1, REG0_AUTOCAL_SHIFT);
+            this->write_reg(slaveno, 0);
+            MODIFY_FIELD(_regs[slaveno][4], 0, 0x1, REG4_CNTR_RESET);
+            this->write_reg(slaveno, 4);
+            boost::this_thread::sleep(boost::posix_time::microseconds(plan.adcWaitUs));
+            if (verbose) std::cout << " sleep time " << (plan.adcWaitUs) << " us" << std::endl;
+            MODIFY_FIELD(_regs[slaveno][0], 1, 0x1, REG0_AUTOCAL_SHIFT);
+            this->write_reg(slaveno, 0);
+            locked = this->wait_locked(slaveno);
+        }
+
+        const int which = (slaveno==SPI_SS_AUX1)?1:2;
+        _tune_time[which] = (boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds()/1e6;
+        if (verbose) std::cout << " tune time " << (_tune_time[which]*1e6) << " us" << std::endl;
+        if (locked) _last_plan[slaveno] = plan;
+        else UMTRX_MSG_ASYNC(warning) << "UmSEL2 synth " << which << ": no lock at " << (plan.RFoutactual/1e6) << " MHz" << std::endl;
+        return plan.RFoutactual;
+    }
+
+    //! Poll the lock detect, it stays low through the VCO calibration
+    bool wait_locked(const int slaveno)
+    {
+        const boost::uint32_t bit = (slaveno==SPI_SS_AUX1)? AUX_LD1_IRQ_BIT : AUX_LD2_IRQ_BIT;
+        const boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time()
+            + boost::posix_time::microseconds(LOCK_TIMEOUT_US);
+        do
+        {
+            if ((_ctrl->peek32(U2_REG_IRQ_RB) & bit) != 0) return true;
+        }
+        while (boost::posix_time::microsec_clock::universal_time() < deadline);
+        return false;
+    }
+
+    //! A register is dirty until its shadow value has been written
+    bool is_dirty(const int slaveno, const int addr)
+    {
+        const std::map<int, int> &written = _written[slaveno];
+        std::map<int, int>::const_iterator it = written.find(addr);
+        return it == written.end() or it->second != _regs[slaveno][addr];
+    }
+
+    void write_reg_changed(const int slaveno, const int addr)
+    {
+        if (this->is_dirty(slaveno, addr)) this->write_reg(slaveno, addr);
+    }
+
+    //! Write the dirty registers, from R12 down to R0 as the datasheet orders them
+    void commit(const int slaveno)
+    {
+        for (int addr = 12; addr >= 0; addr--)
+            this->write_reg_changed(slaveno, addr);
     }
 
     void write_reg(const int slaveno, const int addr)
@@ -463,16 +591,22 @@ private:
         int value = (_regs[slaveno][addr] & ~0xf) | addr;
         if (verbose) std::cout << "write_reg[" << addr << "] = 0x" << std::hex << value << std::dec << std::endl;
         _spiface->write_spi(slaveno, uhd::spi_config_t::EDGE_RISE, value, 32);
+        _written[slaveno][addr] = _regs[slaveno][addr];
     }
 
     uhd::wb_iface::sptr _ctrl;
     uhd::spi_iface::sptr _spiface;
     const double _ref_clock;
     std::map<int, std::map<int, int> > _regs;
+    std::map<int, std::map<int, int> > _written; //last values sent to each synth, none after power up
     const bool verbose;
+    const bool _fast_lock;
+    std::map<long long, synth_plan_t> _plans;
+    std::map<int, synth_plan_t> _last_plan; //of each synth when it locked
+    std::map<int, double> _tune_time; //seconds, by which
 };
 
-umsel2_ctrl::sptr umsel2_ctrl::make(uhd::wb_iface::sptr ctrl, uhd::spi_iface::sptr spiface, const double ref_clock, const bool verbose)
+umsel2_ctrl::sptr umsel2_ctrl::make(uhd::wb_iface::sptr ctrl, uhd::spi_iface::sptr spiface, const double ref_clock, const bool verbose, const bool fast_lock)
 {
-    return umsel2_ctrl::sptr(new umsel2_ctrl_impl(ctrl, spiface, ref_clock, verbose));
+    return umsel2_ctrl::sptr(new umsel2_ctrl_impl(ctrl, spiface, ref_clock, verbose, fast_lock));
 }
@@ -35,7 +35,11 @@ class umsel2_ctrl
 public:
     typedef boost::shared_ptr<umsel2_ctrl> sptr;
 
-    static sptr make(uhd::wb_iface::sptr ctrl, uhd::spi_iface::sptr spiface, const double ref_clock, const bool verbose);
+    /*!
+     * Make the control of both synthesizers.
+     * \param fast_lock tune small steps without a VCO calibration
+     */
+    static sptr make(uhd::wb_iface::sptr ctrl, uhd::spi_iface::sptr spiface, const double ref_clock, const bool verbose, const bool fast_lock = true);
 
     /*!
      * Query the tune range.
@@ -51,6 +55,28 @@ public:
      */
     virtual double set_rx_freq(const int which, const double freq) = 0;
 
+    /*!
+     * Tune a synthesizer with its RF output off, for a ping-pong hop.
+     * The output stays off until select_rx_output() picks the synth.
+     * \param which values 1 or 2
+     * \param freq the freq in Hz
+     * \return the actual freq in Hz
+     */
+    virtual double prepare_rx_freq(const int which, const double freq) = 0;
+
+    /*!
+     * Turn on the RF output of one synthesizer and off the other one's.
+     * Two SPI writes back to back, timed by the command time of the ctrl.
+     * \param which values 1 or 2
+     */
+    virtual void select_rx_output(const int which) = 0;
+
+    /*!
+     * Query the duration of the last tune, up to the lock detect.
+     * \param which values 1 or 2
+     */
+    virtual uhd::sensor_value_t get_tune_time(const int which) = 0;
+
     /*!
      * Query lock detect.
      * \param which values 1 or 2
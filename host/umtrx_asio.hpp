@@ -0,0 +1,486 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_ASIO_HPP
+#define INCLUDED_UMTRX_ASIO_HPP
+
+#include "umtrx_rx_callback_streamer.hpp"
+#include <uhd/stream.hpp>
+#include <uhd/convert.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/types/metadata.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/utility.hpp>
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <vector>
+
+/*!
+ * Asynchronous streaming on an asio io_service.
+ *
+ * The operations complete by posting their handler to the io_service,
+ * asio style, so one thread running the io_service drives the streams,
+ * the hopping and the monitoring of several boards. The handlers take an
+ * error_code first: operation_aborted after close(), timed_out when the
+ * timeout of the operation passed.
+ *
+ * RX rides on the umtrx_rx_callback_streamer dispatcher: its thread
+ * receives into the pool, async_recv() completes with the next packet of
+ * every channel and the slot goes back to the pool when the handler
+ * returns. Packets wait in their slots until they are asked for, a full
+ * pool stalls the stream as with the callback streamer.
+ *
+ * TX, the async messages and the device clock do not block the loop:
+ * send() and recv_async_msg() are tried with no timeout, again every
+ * poll_interval until the operation is done. async_send() operations run
+ * one after the other, in the order they were started.
+ *
+ * Call the async_* functions from the thread that runs the io_service.
+ * The object lives until the handlers posted by it ran.
+ *
+ * Header only so that applications can use it without linking the module.
+ */
+class umtrx_asio_stream : public boost::enable_shared_from_this<umtrx_asio_stream>, boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_asio_stream> sptr;
+    typedef umtrx_rx_callback_streamer::group_type group_type;
+    typedef umtrx_rx_callback_streamer::pool_type pool_type;
+
+    //! The packet is only valid until the handler returns
+    typedef boost::function<void(const boost::system::error_code &, const group_type &)> recv_handler_type;
+    //! Samples per channel that were sent
+    typedef boost::function<void(const boost::system::error_code &, size_t)> send_handler_type;
+    typedef boost::function<void(const boost::system::error_code &, const uhd::async_metadata_t &)> async_msg_handler_type;
+    typedef boost::function<void(const boost::system::error_code &)> wait_handler_type;
+
+    /*!
+     * Make an asio front end, without streams.
+     * \param io the io_service the handlers are posted to
+     * \param poll_interval seconds between the tries of a TX operation
+     */
+    static sptr make(boost::asio::io_service &io, const double poll_interval = 0.0002)
+    {
+        return sptr(new umtrx_asio_stream(io, poll_interval));
+    }
+
+    /*!
+     * Receive with async_recv(): starts the dispatcher of the streamer.
+     * The stream commands are up to the application.
+     * \param rx_stream an UmTRX rx streamer
+     * \param pool the buffers, owned by the application until close()
+     * \param cpu the CPU to pin the dispatch thread to, negative leaves it
+     */
+    void attach_rx(uhd::rx_streamer::sptr rx_stream, const pool_type &pool, const int cpu = -1)
+    {
+        umtrx_rx_callback_streamer *callback = umtrx_rx_callback_streamer::get(rx_stream);
+        if (callback == NULL) throw uhd::not_implemented_error("umtrx_asio_stream: not an UmTRX rx streamer");
+        _rx_stream = rx_stream;
+        _rx_callback = callback;
+        _rx_callback->start(boost::bind(&umtrx_asio_stream::handle_rx_group, this, _1), pool, cpu);
+    }
+
+    /*!
+     * Send with async_send() and read the async messages.
+     * \param tx_stream any tx streamer
+     * \param cpu_format the cpu_format of its stream args, for the buffer offsets
+     */
+    void attach_tx(uhd::tx_streamer::sptr tx_stream, const std::string &cpu_format)
+    {
+        _tx_stream = tx_stream;
+        _tx_bytes_per_samp = uhd::convert::get_bytes_per_item(cpu_format);
+    }
+
+    //! Complete with the next packet of every channel
+    void async_recv(const recv_handler_type &handler)
+    {
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        if (_closed or _rx_callback == NULL)
+        {
+            _io.post(boost::bind(handler, boost::asio::error::operation_aborted, group_type()));
+            return;
+        }
+        _rx_handlers.push_back(handler);
+        this->service_rx();
+    }
+
+    /*!
+     * Send a block of samples without blocking the loop.
+     * A block the streamer takes in parts goes on without start of burst
+     * and time spec, the end of burst goes with its last part.
+     * \param buffs one buffer per channel, valid until the handler runs
+     * \param nsamps samples per channel
+     * \param metadata as for send()
+     * \param timeout seconds until the handler gets timed_out and the samples sent so far
+     */
+    void async_send(const std::vector<const void *> &buffs, const size_t nsamps,
+        const uhd::tx_metadata_t &metadata, const double timeout, const send_handler_type &handler)
+    {
+        boost::shared_ptr<send_op_type> op(new send_op_type(_io));
+        op->buffs = buffs;
+        op->nsamps = nsamps;
+        op->sent = 0;
+        op->metadata = metadata;
+        op->deadline = now() + to_duration(timeout);
+        op->handler = handler;
+        if (this->is_closed() or not _tx_stream)
+        {
+            _io.post(boost::bind(handler, boost::asio::error::operation_aborted, size_t(0)));
+            return;
+        }
+        _send_ops.push_back(op);
+        if (_send_ops.size() == 1) _io.post(boost::bind(&umtrx_asio_stream::try_send, shared_from_this()));
+    }
+
+    //! Complete with the next async message of the TX stream
+    void async_recv_async_msg(const double timeout, const async_msg_handler_type &handler)
+    {
+        if (this->is_closed() or not _tx_stream)
+        {
+            _io.post(boost::bind(handler, boost::asio::error::operation_aborted, uhd::async_metadata_t()));
+            return;
+        }
+        boost::shared_ptr<boost::asio::deadline_timer> timer(new boost::asio::deadline_timer(_io));
+        _io.post(boost::bind(&umtrx_asio_stream::try_recv_async_msg, shared_from_this(), timer, now() + to_duration(timeout), handler));
+    }
+
+    /*!
+     * Take the device time now as the reference of async_wait_until().
+     * The RX packets update it on their own, ex: set it from get_time_now()
+     * or a PPS event when there is no RX stream.
+     */
+    void set_time_reference(const uhd::time_spec_t &device_time)
+    {
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        _ref_device = device_time;
+        _ref_host = now();
+        _ref_valid = true;
+    }
+
+    //! Estimated device time now, false without a reference
+    bool get_device_time(uhd::time_spec_t &time)
+    {
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        if (not _ref_valid) return false;
+        time = _ref_device + uhd::time_spec_t((now() - _ref_host).total_microseconds()/1e6);
+        return true;
+    }
+
+    /*!
+     * Complete at a device time, by the host clock from the time reference.
+     * The RX reference lags by the packet duration and its latency, a wait
+     * completes later than its time by as much. The handler gets not_connected
+     * without a reference.
+     */
+    void async_wait_until(const uhd::time_spec_t &device_time, const wait_handler_type &handler)
+    {
+        uhd::time_spec_t device_now;
+        if (this->is_closed() or not this->get_device_time(device_now))
+        {
+            _io.post(boost::bind(handler, this->is_closed()? boost::asio::error::operation_aborted : boost::asio::error::not_connected));
+            return;
+        }
+        boost::shared_ptr<boost::asio::deadline_timer> timer(new boost::asio::deadline_timer(_io));
+        timer->expires_from_now(to_duration((device_time - device_now).get_real_secs()));
+        timer->async_wait(boost::bind(&umtrx_asio_stream::handle_wait, shared_from_this(), timer, handler, _1));
+    }
+
+    //! Stop the dispatcher and abort the operations in flight
+    void close(void)
+    {
+        {
+            boost::mutex::scoped_lock lock(_rx_mutex);
+            if (_closed) return;
+            _closed = true;
+        }
+        if (_rx_callback != NULL) _rx_callback->stop();
+
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        while (not _rx_handlers.empty())
+        {
+            _io.post(boost::bind(_rx_handlers.front(), boost::asio::error::operation_aborted, group_type()));
+            _rx_handlers.pop_front();
+        }
+        while (not _rx_ready.empty())
+        {
+            _rx_callback->release(_rx_ready.front().slot);
+            _rx_ready.pop_front();
+        }
+    }
+
+    ~umtrx_asio_stream(void)
+    {
+        try {this->close();} catch (...) {}
+    }
+
+private:
+    umtrx_asio_stream(boost::asio::io_service &io, const double poll_interval):
+        _io(io), _poll_interval(to_duration(poll_interval)),
+        _rx_callback(NULL), _closed(false), _tx_bytes_per_samp(0), _ref_valid(false)
+    {}
+
+    struct send_op_type
+    {
+        send_op_type(boost::asio::io_service &io): timer(io) {}
+        std::vector<const void *> buffs;
+        size_t nsamps, sent;
+        uhd::tx_metadata_t metadata;
+        boost::posix_time::ptime deadline;
+        send_handler_type handler;
+        boost::asio::deadline_timer timer;
+    };
+
+    bool is_closed(void)
+    {
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        return _closed;
+    }
+
+    static boost::posix_time::ptime now(void)
+    {
+        return boost::posix_time::microsec_clock::universal_time();
+    }
+
+    static boost::posix_time::time_duration to_duration(const double secs)
+    {
+        return boost::posix_time::microseconds(long(std::max(0.0, secs)*1e6));
+    }
+
+    //! On the dispatch thread: keep the slot until a handler took the packet
+    bool handle_rx_group(const group_type &group)
+    {
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        if (_closed) return false;
+        if (group.metadata.has_time_spec and group.nsamps != 0)
+        {
+            _ref_device = group.metadata.time_spec;
+            _ref_host = now();
+            _ref_valid = true;
+        }
+        _rx_ready.push_back(group);
+        try
+        {
+            this->service_rx();
+        }
+        catch (const boost::bad_weak_ptr &)
+        {
+            //the last owner is gone and close() is about to stop the dispatcher
+            _rx_ready.pop_back();
+            return false;
+        }
+        return true;
+    }
+
+    //! Pair the waiting handlers with the received packets, with the rx mutex
+    void service_rx(void)
+    {
+        while (not _rx_handlers.empty() and not _rx_ready.empty())
+        {
+            _io.post(boost::bind(&umtrx_asio_stream::complete_recv, shared_from_this(), _rx_handlers.front(), _rx_ready.front()));
+            _rx_handlers.pop_front();
+            _rx_ready.pop_front();
+        }
+    }
+
+    void complete_recv(const recv_handler_type &handler, const group_type &group)
+    {
+        try
+        {
+            handler(boost::system::error_code(), group);
+        }
+        catch (...)
+        {
+            _rx_callback->release(group.slot);
+            throw;
+        }
+        _rx_callback->release(group.slot);
+    }
+
+    void try_send(void)
+    {
+        if (_send_ops.empty()) return;
+        boost::shared_ptr<send_op_type> op = _send_ops.front();
+        boost::system::error_code ec;
+        if (this->is_closed()) ec = boost::asio::error::operation_aborted;
+        else
+        {
+            std::vector<const void *> buffs(op->buffs.size());
+            for (size_t ch = 0; ch < buffs.size(); ch++)
+            {
+                buffs[ch] = static_cast<const char *>(op->buffs[ch]) + op->sent*_tx_bytes_per_samp;
+            }
+            const size_t n = _tx_stream->send(buffs, op->nsamps - op->sent, op->metadata, 0.0);
+            op->sent += n;
+            if (n != 0)
+            {
+                op->metadata.start_of_burst = false;
+                op->metadata.has_time_spec = false;
+            }
+            //an empty block, ex: an end of burst, is done after one try
+            const bool done = op->sent == op->nsamps;
+            if (not done and now() < op->deadline)
+            {
+                op->timer.expires_from_now(_poll_interval);
+                op->timer.async_wait(boost::bind(&umtrx_asio_stream::try_send, shared_from_this()));
+                return;
+            }
+            if (not done) ec = boost::asio::error::timed_out;
+        }
+
+        _send_ops.pop_front();
+        _io.post(boost::bind(op->handler, ec, op->sent));
+        if (not _send_ops.empty()) _io.post(boost::bind(&umtrx_asio_stream::try_send, shared_from_this()));
+    }
+
+    void try_recv_async_msg(boost::shared_ptr<boost::asio::deadline_timer> timer,
+        const boost::posix_time::ptime &deadline, const async_msg_handler_type &handler)
+    {
+        uhd::async_metadata_t metadata;
+        if (this->is_closed()) handler(boost::asio::error::operation_aborted, metadata);
+        else if (_tx_stream->recv_async_msg(metadata, 0.0)) handler(boost::system::error_code(), metadata);
+        else if (now() >= deadline) handler(boost::asio::error::timed_out, metadata);
+        else
+        {
+            timer->expires_from_now(_poll_interval);
+            timer->async_wait(boost::bind(&umtrx_asio_stream::try_recv_async_msg, shared_from_this(), timer, deadline, handler));
+        }
+    }
+
+    void handle_wait(boost::shared_ptr<boost::asio::deadline_timer>, const wait_handler_type &handler,
+        const boost::system::error_code &ec)
+    {
+        handler(this->is_closed()? boost::system::error_code(boost::asio::error::operation_aborted) : ec);
+    }
+
+    boost::asio::io_service &_io;
+    const boost::posix_time::time_duration _poll_interval;
+
+    //with the rx mutex, the dispatch thread shares them
+    boost::mutex _rx_mutex;
+    uhd::rx_streamer::sptr _rx_stream;
+    umtrx_rx_callback_streamer *_rx_callback;
+    std::deque<recv_handler_type> _rx_handlers;
+    std::deque<group_type> _rx_ready;
+    bool _closed;
+
+    //on the io_service thread only
+    uhd::tx_streamer::sptr _tx_stream;
+    size_t _tx_bytes_per_samp;
+    std::deque<boost::shared_ptr<send_op_type> > _send_ops;
+
+    //device time reference, with the rx mutex
+    uhd::time_spec_t _ref_device;
+    boost::posix_time::ptime _ref_host;
+    bool _ref_valid;
+};
+
+/*!
+ * Asynchronous control on an asio io_service.
+ *
+ * For a controller like umtrx_fifo_ctrl: batches of pokes go out without
+ * waiting for their acks, peeks complete when their ack arrived. The acks
+ * are taken with poll_acks() every poll_interval while peeks are waiting.
+ * Call the async_* functions from the thread that runs the io_service.
+ */
+template <typename ctrl_sptr_type>
+class umtrx_asio_ctrl : public boost::enable_shared_from_this<umtrx_asio_ctrl<ctrl_sptr_type> >, boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_asio_ctrl> sptr;
+    typedef std::vector<std::pair<boost::uint32_t, boost::uint32_t> > pokes_type; //address, data
+    typedef boost::function<void(const boost::system::error_code &)> poke_handler_type;
+    typedef boost::function<void(const boost::system::error_code &, boost::uint32_t)> peek_handler_type;
+
+    static sptr make(boost::asio::io_service &io, ctrl_sptr_type ctrl, const double poll_interval = 0.0001)
+    {
+        return sptr(new umtrx_asio_ctrl(io, ctrl, poll_interval));
+    }
+
+    /*!
+     * Send pokes in one batch, the handler runs once they are sent.
+     * Blocks only while the window of the controller is full.
+     */
+    void async_poke32_batch(const pokes_type &pokes, const poke_handler_type &handler)
+    {
+        boost::system::error_code ec;
+        try
+        {
+            _ctrl->begin_batch();
+            for (size_t i = 0; i < pokes.size(); i++) _ctrl->poke32(pokes[i].first, pokes[i].second);
+            _ctrl->end_batch();
+        }
+        catch (const uhd::exception &)
+        {
+            ec = boost::asio::error::timed_out;
+        }
+        _io.post(boost::bind(handler, ec));
+    }
+
+    //! Complete with a readback word
+    void async_peek32(const boost::uint32_t addr, const double timeout, const peek_handler_type &handler)
+    {
+        boost::shared_ptr<peek_op_type> op(new peek_op_type(_io));
+        op->future = _ctrl->peek32_async(addr);
+        op->deadline = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::microseconds(long(timeout*1e6));
+        op->handler = handler;
+        _io.post(boost::bind(&umtrx_asio_ctrl::try_peek, this->shared_from_this(), op));
+    }
+
+private:
+    umtrx_asio_ctrl(boost::asio::io_service &io, ctrl_sptr_type ctrl, const double poll_interval):
+        _io(io), _ctrl(ctrl), _poll_interval(boost::posix_time::microseconds(long(poll_interval*1e6)))
+    {}
+
+    typedef typename ctrl_sptr_type::element_type ctrl_type;
+
+    struct peek_op_type
+    {
+        peek_op_type(boost::asio::io_service &io): timer(io) {}
+        typename ctrl_type::peek_future::sptr future;
+        boost::posix_time::ptime deadline;
+        peek_handler_type handler;
+        boost::asio::deadline_timer timer;
+    };
+
+    void try_peek(boost::shared_ptr<peek_op_type> op)
+    {
+        _ctrl->poll_acks();
+        if (op->future->ready()) op->handler(boost::system::error_code(), op->future->get());
+        else if (boost::posix_time::microsec_clock::universal_time() >= op->deadline) op->handler(boost::asio::error::timed_out, 0);
+        else
+        {
+            op->timer.expires_from_now(_poll_interval);
+            op->timer.async_wait(boost::bind(&umtrx_asio_ctrl::try_peek, this->shared_from_this(), op));
+        }
+    }
+
+    boost::asio::io_service &_io;
+    ctrl_sptr_type _ctrl;
+    const boost::posix_time::time_duration _poll_interval;
+};
+
+#endif /* INCLUDED_UMTRX_ASIO_HPP */
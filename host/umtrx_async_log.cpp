@@ -0,0 +1,199 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_async_log.hpp"
+#include "umtrx_log_adapter.hpp"
+#include <uhd/utils/safe_call.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/atomic.hpp>
+#include <boost/chrono.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+static const size_t NUM_SITES = 256; //call sites that hash together share a limit
+static const size_t QUEUE_DEPTH = 1024;
+static const long DRAIN_PERIOD_MS = 20;
+static const long FLUSH_TIMEOUT_MS = 1000;
+
+struct log_entry_t
+{
+    umtrx_log_level_t level;
+    std::string text;
+};
+
+//! One rate limit window of a call site
+struct log_site_t
+{
+    log_site_t(void): window(0), count(0), suppressed(0){}
+    boost::atomic<boost::uint32_t> window; //second the count is for
+    boost::atomic<boost::uint32_t> count;
+    boost::atomic<boost::uint32_t> suppressed;
+};
+
+class async_logger : boost::noncopyable
+{
+public:
+    static async_logger &get(void)
+    {
+        static async_logger logger;
+        return logger;
+    }
+
+    //! Queue an entry without waiting, takes it over
+    void push(log_entry_t *entry)
+    {
+        _pending.fetch_add(1);
+        if (not _queue.bounded_push(entry))
+        {
+            delete entry;
+            _pending.fetch_sub(1);
+            _dropped.fetch_add(1, boost::memory_order_relaxed);
+        }
+    }
+
+    void flush(void)
+    {
+        for (long i = 0; i < FLUSH_TIMEOUT_MS and _pending.load() != 0; i++)
+        {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+    }
+
+    log_site_t &site(const char *file, const int line)
+    {
+        const size_t hash = size_t(file) ^ (size_t(line)*2654435761u);
+        return _sites[hash % NUM_SITES];
+    }
+
+    boost::uint32_t now_sec(void) const
+    {
+        return boost::uint32_t(boost::chrono::duration_cast<boost::chrono::seconds>(
+            boost::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    boost::atomic<size_t> rate_limit;
+
+private:
+    async_logger(void):
+        rate_limit(10), _queue(QUEUE_DEPTH), _pending(0), _dropped(0)
+    {
+        _thread.reset(new boost::thread(boost::bind(&async_logger::run, this)));
+    }
+
+    ~async_logger(void)
+    {
+        UHD_SAFE_CALL(
+            _thread->interrupt();
+            _thread->join();
+            this->drain();
+        )
+    }
+
+    void run(void)
+    {
+        try
+        {
+            while (true)
+            {
+                this->drain();
+                boost::this_thread::sleep(boost::posix_time::milliseconds(DRAIN_PERIOD_MS));
+            }
+        }
+        catch (const boost::thread_interrupted &)
+        {
+            //the destructor drains the rest
+        }
+    }
+
+    void drain(void)
+    {
+        log_entry_t *entry = NULL;
+        while (_queue.pop(entry))
+        {
+            switch (entry->level)
+            {
+            case UMTRX_LOG_status: UHD_MSG(status) << entry->text; break;
+            case UMTRX_LOG_warning: UHD_MSG(warning) << entry->text; break;
+            default: UHD_MSG(error) << entry->text; break;
+            }
+            delete entry;
+            _pending.fetch_sub(1);
+        }
+        const size_t dropped = _dropped.exchange(0, boost::memory_order_relaxed);
+        if (dropped != 0) UHD_MSG(warning) << "umtrx: the log queue was full, " << dropped << " messages dropped" << std::endl;
+    }
+
+    boost::lockfree::queue<log_entry_t *, boost::lockfree::fixed_sized<true> > _queue;
+    boost::atomic<size_t> _pending; //queued and not yet written
+    boost::atomic<size_t> _dropped;
+    log_site_t _sites[NUM_SITES];
+    boost::scoped_ptr<boost::thread> _thread;
+};
+
+void umtrx_async_log::set_rate_limit(const size_t per_second)
+{
+    async_logger::get().rate_limit.store(per_second);
+}
+
+void umtrx_async_log::flush(void)
+{
+    async_logger::get().flush();
+}
+
+umtrx_async_log_line::umtrx_async_log_line(const umtrx_log_level_t level, const char *file, const int line):
+    _level(level), _suppressed(0), _pass(true)
+{
+    async_logger &logger = async_logger::get();
+    const size_t limit = logger.rate_limit.load(boost::memory_order_relaxed);
+    if (limit == 0) return;
+
+    //a new second restarts the count of the site
+    log_site_t &site = logger.site(file, line);
+    const boost::uint32_t now = logger.now_sec();
+    boost::uint32_t window = site.window.load(boost::memory_order_relaxed);
+    if (window != now and site.window.compare_exchange_strong(window, now)) site.count.store(0);
+
+    if (site.count.fetch_add(1) >= limit)
+    {
+        site.suppressed.fetch_add(1, boost::memory_order_relaxed);
+        _pass = false;
+        _ss.setstate(std::ios::badbit); //the insertions do nothing
+        return;
+    }
+    _suppressed = site.suppressed.exchange(0, boost::memory_order_relaxed);
+}
+
+umtrx_async_log_line::~umtrx_async_log_line(void)
+{
+    if (not _pass) return;
+    UHD_SAFE_CALL(
+        log_entry_t *entry = new log_entry_t();
+        entry->level = _level;
+        entry->text = _ss.str();
+        if (_suppressed != 0)
+        {
+            const bool endl = not entry->text.empty() and entry->text[entry->text.size()-1] == '\n';
+            if (endl) entry->text.resize(entry->text.size()-1);
+            entry->text += str(boost::format(" (%u more suppressed)") % _suppressed);
+            if (endl) entry->text += "\n";
+        }
+        async_logger::get().push(entry);
+    )
+}
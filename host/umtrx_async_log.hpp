@@ -0,0 +1,75 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_ASYNC_LOG_HPP
+#define INCLUDED_UMTRX_ASYNC_LOG_HPP
+
+#include <boost/utility.hpp>
+#include <sstream>
+#include <string>
+
+enum umtrx_log_level_t
+{
+    UMTRX_LOG_status,
+    UMTRX_LOG_warning,
+    UMTRX_LOG_error
+};
+
+/*!
+ * Log a message from a path that must not wait on the log output:
+ *   UMTRX_MSG_ASYNC(warning) << "no lock at " << freq << std::endl;
+ *
+ * The message is formatted by the caller and handed to a lock-free
+ * queue, a background thread writes it out with UHD_MSG. A caller never
+ * takes a lock or waits: with the queue full the message is dropped and
+ * counted. Each call site gets at most umtrx_async_log::set_rate_limit()
+ * messages a second, the ones over the limit are not even formatted and
+ * the next message of the site tells how many there were.
+ * One call of the macro is one message, it should end in std::endl.
+ */
+#define UMTRX_MSG_ASYNC(severity) \
+    umtrx_async_log_line(UMTRX_LOG_##severity, __FILE__, __LINE__).stream()
+
+namespace umtrx_async_log
+{
+    //! Messages a second per call site, zero for no limit, default 10
+    void set_rate_limit(const size_t per_second);
+
+    //! Wait until the messages logged so far are written out
+    void flush(void);
+}
+
+//! One message of UMTRX_MSG_ASYNC, queued when it goes out of scope
+class umtrx_async_log_line : boost::noncopyable
+{
+public:
+    umtrx_async_log_line(const umtrx_log_level_t level, const char *file, const int line);
+    ~umtrx_async_log_line(void);
+
+    std::ostream &stream(void)
+    {
+        return _ss;
+    }
+
+private:
+    const umtrx_log_level_t _level;
+    size_t _suppressed; //by the rate limit since the last message of the site
+    bool _pass;
+    std::ostringstream _ss;
+};
+
+#endif /* INCLUDED_UMTRX_ASYNC_LOG_HPP */
@@ -0,0 +1,224 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_ASYNC_RING_HPP
+#define INCLUDED_UMTRX_ASYNC_RING_HPP
+
+#include <uhd/types/metadata.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/scoped_array.hpp>
+
+/*!
+ * Lossy ring of async metadata with one producer and any number of readers.
+ *
+ * Every reader has its own cursor, so an event is stored once however
+ * many readers see it. The producer never waits: a reader that falls a
+ * whole ring behind skips to the oldest event still resident and counts
+ * the ones it lost. The slots are seqlocked, a read that raced with an
+ * overwrite is thrown away. Readers only lock to sleep when the ring is
+ * empty, the producer only locks to wake a sleeping reader.
+ */
+class umtrx_async_ring : public boost::enable_shared_from_this<umtrx_async_ring>, boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_async_ring> sptr;
+
+    //! A read position, starts at the next event pushed
+    class cursor : boost::noncopyable
+    {
+    public:
+        typedef boost::shared_ptr<cursor> sptr;
+
+        /*!
+         * Pop the next event of this cursor.
+         * \return false when none came within timeout seconds
+         */
+        bool pop(uhd::async_metadata_t &md, const double timeout)
+        {
+            return _ring->pop(*this, md, timeout);
+        }
+
+        //! Events this cursor lost to overwrites
+        boost::uint64_t get_num_dropped(void) const
+        {
+            return _dropped.load(boost::memory_order_relaxed);
+        }
+
+    private:
+        friend class umtrx_async_ring;
+        cursor(umtrx_async_ring::sptr ring, const bool all, const boost::uint32_t tag):
+            _ring(ring), _all(all), _tag(tag), _next(ring->_head.load()), _dropped(0)
+        {}
+
+        const umtrx_async_ring::sptr _ring;
+        const bool _all; //every tag, else only _tag
+        const boost::uint32_t _tag;
+        boost::atomic<boost::uint64_t> _next;
+        boost::atomic<boost::uint64_t> _dropped;
+    };
+
+    //! Make a ring of at least capacity events
+    static sptr make(const size_t capacity)
+    {
+        return sptr(new umtrx_async_ring(capacity));
+    }
+
+    //! A cursor over the events of one tag
+    cursor::sptr make_cursor(const boost::uint32_t tag)
+    {
+        return cursor::sptr(new cursor(shared_from_this(), false, tag));
+    }
+
+    //! A cursor over every event
+    cursor::sptr make_cursor(void)
+    {
+        return cursor::sptr(new cursor(shared_from_this(), true, 0));
+    }
+
+    //! A tag no other caller got, for a new reader
+    boost::uint32_t new_tag(void)
+    {
+        return _next_tag.fetch_add(1, boost::memory_order_relaxed);
+    }
+
+    //! Store an event, only ever called from the one producer thread
+    void push(const uhd::async_metadata_t &md, const boost::uint32_t tag)
+    {
+        const boost::uint64_t n = _head.load(boost::memory_order_relaxed);
+        slot_type &s = _slots[size_t(n & (_size - 1))];
+        s.seq.store(2*n + 1, boost::memory_order_relaxed);
+        boost::atomic_thread_fence(boost::memory_order_release);
+        s.md = md;
+        s.tag = tag;
+        s.seq.store(2*n + 2, boost::memory_order_release);
+        _head.store(n + 1);
+
+        //the lock orders the notify after the reader's empty check
+        if (_waiters.load() != 0)
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            lock.unlock();
+            _cond.notify_all();
+        }
+    }
+
+    //! Events lost by all cursors
+    boost::uint64_t get_num_dropped(void) const
+    {
+        return _dropped.load(boost::memory_order_relaxed);
+    }
+
+private:
+    struct slot_type
+    {
+        slot_type(void): seq(0), tag(0){}
+        boost::atomic<boost::uint64_t> seq; //odd while written, 2n+2 once event n is in
+        uhd::async_metadata_t md;
+        boost::uint32_t tag;
+    };
+
+    umtrx_async_ring(const size_t capacity):
+        _size(1), _head(0), _waiters(0), _next_tag(0), _dropped(0)
+    {
+        while (_size < capacity) _size <<= 1;
+        _slots.reset(new slot_type[_size]);
+    }
+
+    //! Take the next event of the cursor without waiting
+    bool try_pop(cursor &c, uhd::async_metadata_t &md)
+    {
+        while (true)
+        {
+            boost::uint64_t n = c._next.load();
+            const boost::uint64_t head = _head.load();
+            if (n >= head) return false;
+
+            //lapped, skip to the oldest resident event
+            if (head - n > _size)
+            {
+                const boost::uint64_t oldest = head - _size;
+                if (c._next.compare_exchange_strong(n, oldest))
+                {
+                    c._dropped.fetch_add(oldest - n, boost::memory_order_relaxed);
+                    _dropped.fetch_add(oldest - n, boost::memory_order_relaxed);
+                }
+                continue;
+            }
+
+            const slot_type &s = _slots[size_t(n & (_size - 1))];
+            const boost::uint64_t seq = s.seq.load(boost::memory_order_acquire);
+            if (seq != 2*n + 2) continue; //overwritten under us, the lap check skips it
+            const uhd::async_metadata_t copy = s.md;
+            const boost::uint32_t tag = s.tag;
+            boost::atomic_thread_fence(boost::memory_order_acquire);
+            if (s.seq.load(boost::memory_order_relaxed) != seq) continue;
+
+            //another reader of this cursor may have taken it
+            if (not c._next.compare_exchange_strong(n, n + 1)) continue;
+            if (c._all or tag == c._tag)
+            {
+                md = copy;
+                return true;
+            }
+        }
+    }
+
+    bool pop(cursor &c, uhd::async_metadata_t &md, const double timeout)
+    {
+        if (this->try_pop(c, md)) return true;
+        if (timeout <= 0.0) return false;
+
+        const boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds(long(timeout*1e6));
+        while (true)
+        {
+            {
+                boost::mutex::scoped_lock lock(_mutex);
+                _waiters.fetch_add(1);
+                bool ready = true;
+                while (c._next.load() >= _head.load())
+                {
+                    if (not _cond.timed_wait(lock, deadline))
+                    {
+                        ready = false;
+                        break;
+                    }
+                }
+                _waiters.fetch_sub(1);
+                if (not ready) return this->try_pop(c, md);
+            }
+            if (this->try_pop(c, md)) return true; //else only events of other tags came
+        }
+    }
+
+    boost::uint64_t _size;
+    boost::scoped_array<slot_type> _slots;
+    boost::atomic<boost::uint64_t> _head; //events pushed so far
+    boost::atomic<size_t> _waiters;
+    boost::atomic<boost::uint32_t> _next_tag;
+    boost::atomic<boost::uint64_t> _dropped;
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+};
+
+#endif /* INCLUDED_UMTRX_ASYNC_RING_HPP */
@@ -0,0 +1,574 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+/***********************************************************************
+ * SIMD converters for the UmTRX over-the-wire formats (sc16_item32_be
+ * and sc8_item32_be). They register above the UHD generic and simd
+ * priorities, so both the RX and TX streamers pick them up through
+ * uhd::convert::get_converter().
+ * The item32_be words carry I in the upper half: on a little-endian host
+ * the sc16 items only need each 16-bit lane byte-swapped. An sc8 item
+ * packs two samples as I0 Q0 I1 Q1 in memory order, so sc8 is plain
+ * interleaved bytes whatever the host order.
+ * The gmsk items are words of bits for the TX modulator, only swapped.
+ * The bfp8 items are sc8 mantissas of a block floating point packet: the
+ * streamer sets the scalar of each packet from its shared exponent, the
+ * sc16 output takes the exponent as a left shift.
+ **********************************************************************/
+
+#include <uhd/config.hpp>
+#include <uhd/convert.hpp>
+#include <uhd/utils/static.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <boost/cstdint.hpp>
+#include <complex>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <emmintrin.h>
+#  define UMTRX_CONVERT_SSE2
+#  if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 5)
+#    include <immintrin.h>
+#    define UMTRX_CONVERT_AVX2
+#  endif
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#  include <arm_neon.h>
+#  define UMTRX_CONVERT_NEON
+#endif
+
+using namespace uhd::convert;
+
+//above the generic, table and simd converters shipped by UHD
+static const priority_type PRIORITY_UMTRX = 5;
+
+typedef std::complex<float> fc32_t;
+typedef std::complex<boost::int16_t> sc16_t;
+
+/***********************************************************************
+ * Scalar kernels: loop tails and non-simd platforms
+ **********************************************************************/
+static UHD_INLINE boost::int16_t swap16(const boost::uint16_t x)
+{
+    return boost::int16_t((x << 8) | (x >> 8));
+}
+
+static UHD_INLINE void item32_to_fc32_tail(const boost::uint16_t *in, fc32_t *out, const size_t num, const float scalar)
+{
+    for (size_t i = 0; i < num; i++)
+    {
+        out[i] = fc32_t(swap16(in[2*i+0])*scalar, swap16(in[2*i+1])*scalar);
+    }
+}
+
+static UHD_INLINE void fc32_to_item32_tail(const fc32_t *in, boost::uint16_t *out, const size_t num, const float scalar)
+{
+    for (size_t i = 0; i < num; i++)
+    {
+        out[2*i+0] = swap16(boost::uint16_t(boost::int16_t(in[i].real()*scalar)));
+        out[2*i+1] = swap16(boost::uint16_t(boost::int16_t(in[i].imag()*scalar)));
+    }
+}
+
+static UHD_INLINE void sc8_to_fc32_tail(const boost::int8_t *in, fc32_t *out, const size_t num, const float scalar)
+{
+    for (size_t i = 0; i < num; i++)
+    {
+        out[i] = fc32_t(in[2*i+0]*scalar, in[2*i+1]*scalar);
+    }
+}
+
+static UHD_INLINE boost::int8_t saturate8(const float x)
+{
+    const int v = int(x);
+    return boost::int8_t((v > 127)? 127 : (v < -128)? -128 : v);
+}
+
+static UHD_INLINE void fc32_to_sc8_tail(const fc32_t *in, boost::int8_t *out, const size_t num, const float scalar)
+{
+    for (size_t i = 0; i < num; i++)
+    {
+        out[2*i+0] = saturate8(in[i].real()*scalar);
+        out[2*i+1] = saturate8(in[i].imag()*scalar);
+    }
+}
+
+static UHD_INLINE void bfp8_to_sc16_tail(const boost::int8_t *in, sc16_t *out, const size_t num, const int shift)
+{
+    for (size_t i = 0; i < num; i++)
+    {
+        out[i] = sc16_t(boost::int16_t(in[2*i+0] << shift), boost::int16_t(in[2*i+1] << shift));
+    }
+}
+
+//the swap is its own inverse: used for both sc16 directions
+static UHD_INLINE void swap16_tail(const boost::uint16_t *in, boost::uint16_t *out, const size_t num)
+{
+    for (size_t i = 0; i < 2*num; i++) out[i] = boost::uint16_t(swap16(in[i]));
+}
+
+/***********************************************************************
+ * SSE2 kernels (x86 baseline)
+ **********************************************************************/
+#ifdef UMTRX_CONVERT_SSE2
+static UHD_INLINE __m128i swap16_sse2(const __m128i x)
+{
+    return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+static void item32_to_fc32_sse2(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const boost::uint16_t *in = reinterpret_cast<const boost::uint16_t *>(in_);
+    float *out = reinterpret_cast<float *>(out_);
+    const __m128 scale = _mm_set1_ps(scalar);
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4) //4 complex samples per iteration
+    {
+        const __m128i x = swap16_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2*i)));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16); //sign extend
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(out + 2*i + 0, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + 2*i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    item32_to_fc32_tail(in + 2*i, reinterpret_cast<fc32_t *>(out + 2*i), num - i, scalar);
+}
+
+static void fc32_to_item32_sse2(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const float *in = reinterpret_cast<const float *>(in_);
+    boost::uint16_t *out = reinterpret_cast<boost::uint16_t *>(out_);
+    const __m128 scale = _mm_set1_ps(scalar);
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        const __m128i lo = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + 2*i + 0), scale));
+        const __m128i hi = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + 2*i + 4), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2*i), swap16_sse2(_mm_packs_epi32(lo, hi)));
+    }
+    fc32_to_item32_tail(reinterpret_cast<const fc32_t *>(in + 2*i), out + 2*i, num - i, scalar);
+}
+
+static void sc16_swap_sse2(const void *in_, void *out_, const size_t num)
+{
+    const boost::uint16_t *in = reinterpret_cast<const boost::uint16_t *>(in_);
+    boost::uint16_t *out = reinterpret_cast<boost::uint16_t *>(out_);
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2*i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2*i), swap16_sse2(x));
+    }
+    swap16_tail(in + 2*i, out + 2*i, num - i);
+}
+
+static void sc8_to_fc32_sse2(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const boost::int8_t *in = reinterpret_cast<const boost::int8_t *>(in_);
+    float *out = reinterpret_cast<float *>(out_);
+    const __m128 scale = _mm_set1_ps(scalar);
+    size_t i = 0;
+    for (; i + 8 <= num; i += 8) //8 complex samples per iteration
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2*i));
+        const __m128i lo16 = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8); //sign extend
+        const __m128i hi16 = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+        const __m128i w0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo16, lo16), 16);
+        const __m128i w1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo16, lo16), 16);
+        const __m128i w2 = _mm_srai_epi32(_mm_unpacklo_epi16(hi16, hi16), 16);
+        const __m128i w3 = _mm_srai_epi32(_mm_unpackhi_epi16(hi16, hi16), 16);
+        _mm_storeu_ps(out + 2*i + 0, _mm_mul_ps(_mm_cvtepi32_ps(w0), scale));
+        _mm_storeu_ps(out + 2*i + 4, _mm_mul_ps(_mm_cvtepi32_ps(w1), scale));
+        _mm_storeu_ps(out + 2*i + 8, _mm_mul_ps(_mm_cvtepi32_ps(w2), scale));
+        _mm_storeu_ps(out + 2*i + 12, _mm_mul_ps(_mm_cvtepi32_ps(w3), scale));
+    }
+    sc8_to_fc32_tail(in + 2*i, reinterpret_cast<fc32_t *>(out + 2*i), num - i, scalar);
+}
+
+static void bfp8_to_sc16_sse2(const void *in_, void *out_, const size_t num, const int shift)
+{
+    const boost::int8_t *in = reinterpret_cast<const boost::int8_t *>(in_);
+    boost::int16_t *out = reinterpret_cast<boost::int16_t *>(out_);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    size_t i = 0;
+    for (; i + 8 <= num; i += 8)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2*i));
+        const __m128i lo16 = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8); //sign extend
+        const __m128i hi16 = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2*i + 0), _mm_sll_epi16(lo16, count));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2*i + 8), _mm_sll_epi16(hi16, count));
+    }
+    bfp8_to_sc16_tail(in + 2*i, reinterpret_cast<sc16_t *>(out + 2*i), num - i, shift);
+}
+
+static void fc32_to_sc8_sse2(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const float *in = reinterpret_cast<const float *>(in_);
+    boost::int8_t *out = reinterpret_cast<boost::int8_t *>(out_);
+    const __m128 scale = _mm_set1_ps(scalar);
+    size_t i = 0;
+    for (; i + 8 <= num; i += 8)
+    {
+        const __m128i w0 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + 2*i + 0), scale));
+        const __m128i w1 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + 2*i + 4), scale));
+        const __m128i w2 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + 2*i + 8), scale));
+        const __m128i w3 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + 2*i + 12), scale));
+        const __m128i x = _mm_packs_epi16(_mm_packs_epi32(w0, w1), _mm_packs_epi32(w2, w3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2*i), x);
+    }
+    fc32_to_sc8_tail(reinterpret_cast<const fc32_t *>(in + 2*i), out + 2*i, num - i, scalar);
+}
+#endif //UMTRX_CONVERT_SSE2
+
+/***********************************************************************
+ * AVX2 kernels (x86, selected at runtime)
+ **********************************************************************/
+#ifdef UMTRX_CONVERT_AVX2
+__attribute__((target("avx2")))
+static void item32_to_fc32_avx2(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const boost::uint16_t *in = reinterpret_cast<const boost::uint16_t *>(in_);
+    float *out = reinterpret_cast<float *>(out_);
+    const __m256 scale = _mm256_set1_ps(scalar);
+    const __m256i swap = _mm256_setr_epi8(
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    size_t i = 0;
+    for (; i + 8 <= num; i += 8) //8 complex samples per iteration
+    {
+        const __m256i x = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 2*i)), swap);
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(x));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(x, 1));
+        _mm256_storeu_ps(out + 2*i + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(out + 2*i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+    item32_to_fc32_tail(in + 2*i, reinterpret_cast<fc32_t *>(out + 2*i), num - i, scalar);
+}
+
+__attribute__((target("avx2")))
+static void fc32_to_item32_avx2(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const float *in = reinterpret_cast<const float *>(in_);
+    boost::uint16_t *out = reinterpret_cast<boost::uint16_t *>(out_);
+    const __m256 scale = _mm256_set1_ps(scalar);
+    const __m256i swap = _mm256_setr_epi8(
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    size_t i = 0;
+    for (; i + 8 <= num; i += 8)
+    {
+        const __m256i lo = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in + 2*i + 0), scale));
+        const __m256i hi = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in + 2*i + 8), scale));
+        //packs works per 128-bit lane, restore the sample order afterwards
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2*i), _mm256_shuffle_epi8(packed, swap));
+    }
+    fc32_to_item32_tail(reinterpret_cast<const fc32_t *>(in + 2*i), out + 2*i, num - i, scalar);
+}
+#endif //UMTRX_CONVERT_AVX2
+
+/***********************************************************************
+ * NEON kernels (arm)
+ **********************************************************************/
+#ifdef UMTRX_CONVERT_NEON
+static void item32_to_fc32_neon(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const boost::uint16_t *in = reinterpret_cast<const boost::uint16_t *>(in_);
+    float *out = reinterpret_cast<float *>(out_);
+    const float32x4_t scale = vdupq_n_f32(scalar);
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        const int16x8_t x = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(reinterpret_cast<const boost::uint8_t *>(in + 2*i))));
+        vst1q_f32(out + 2*i + 0, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+        vst1q_f32(out + 2*i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+    }
+    item32_to_fc32_tail(in + 2*i, reinterpret_cast<fc32_t *>(out + 2*i), num - i, scalar);
+}
+
+static void fc32_to_item32_neon(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const float *in = reinterpret_cast<const float *>(in_);
+    boost::uint16_t *out = reinterpret_cast<boost::uint16_t *>(out_);
+    const float32x4_t scale = vdupq_n_f32(scalar);
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        const int16x4_t lo = vqmovn_s32(vcvtq_s32_f32(vmulq_f32(vld1q_f32(in + 2*i + 0), scale)));
+        const int16x4_t hi = vqmovn_s32(vcvtq_s32_f32(vmulq_f32(vld1q_f32(in + 2*i + 4), scale)));
+        const uint8x16_t x = vrev16q_u8(vreinterpretq_u8_s16(vcombine_s16(lo, hi)));
+        vst1q_u8(reinterpret_cast<boost::uint8_t *>(out + 2*i), x);
+    }
+    fc32_to_item32_tail(reinterpret_cast<const fc32_t *>(in + 2*i), out + 2*i, num - i, scalar);
+}
+
+static void sc16_swap_neon(const void *in_, void *out_, const size_t num)
+{
+    const boost::uint16_t *in = reinterpret_cast<const boost::uint16_t *>(in_);
+    boost::uint16_t *out = reinterpret_cast<boost::uint16_t *>(out_);
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        vst1q_u8(reinterpret_cast<boost::uint8_t *>(out + 2*i),
+            vrev16q_u8(vld1q_u8(reinterpret_cast<const boost::uint8_t *>(in + 2*i))));
+    }
+    swap16_tail(in + 2*i, out + 2*i, num - i);
+}
+
+static void sc8_to_fc32_neon(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const boost::int8_t *in = reinterpret_cast<const boost::int8_t *>(in_);
+    float *out = reinterpret_cast<float *>(out_);
+    const float32x4_t scale = vdupq_n_f32(scalar);
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        const int16x8_t x = vmovl_s8(vld1_s8(in + 2*i));
+        vst1q_f32(out + 2*i + 0, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+        vst1q_f32(out + 2*i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+    }
+    sc8_to_fc32_tail(in + 2*i, reinterpret_cast<fc32_t *>(out + 2*i), num - i, scalar);
+}
+
+static void bfp8_to_sc16_neon(const void *in_, void *out_, const size_t num, const int shift)
+{
+    const boost::int8_t *in = reinterpret_cast<const boost::int8_t *>(in_);
+    boost::int16_t *out = reinterpret_cast<boost::int16_t *>(out_);
+    const int16x8_t count = vdupq_n_s16(boost::int16_t(shift));
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        vst1q_s16(out + 2*i, vshlq_s16(vmovl_s8(vld1_s8(in + 2*i)), count));
+    }
+    bfp8_to_sc16_tail(in + 2*i, reinterpret_cast<sc16_t *>(out + 2*i), num - i, shift);
+}
+
+static void fc32_to_sc8_neon(const void *in_, void *out_, const size_t num, const float scalar)
+{
+    const float *in = reinterpret_cast<const float *>(in_);
+    boost::int8_t *out = reinterpret_cast<boost::int8_t *>(out_);
+    const float32x4_t scale = vdupq_n_f32(scalar);
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        const int16x4_t lo = vqmovn_s32(vcvtq_s32_f32(vmulq_f32(vld1q_f32(in + 2*i + 0), scale)));
+        const int16x4_t hi = vqmovn_s32(vcvtq_s32_f32(vmulq_f32(vld1q_f32(in + 2*i + 4), scale)));
+        vst1_s8(out + 2*i, vqmovn_s16(vcombine_s16(lo, hi)));
+    }
+    fc32_to_sc8_tail(reinterpret_cast<const fc32_t *>(in + 2*i), out + 2*i, num - i, scalar);
+}
+#endif //UMTRX_CONVERT_NEON
+
+/***********************************************************************
+ * Converter classes: the kernel is picked once at registration
+ **********************************************************************/
+typedef void (*scaled_kernel_type)(const void *, void *, const size_t, const float);
+typedef void (*swap_kernel_type)(const void *, void *, const size_t);
+typedef void (*shift_kernel_type)(const void *, void *, const size_t, const int);
+
+static scaled_kernel_type item32_to_fc32_kernel = NULL;
+static scaled_kernel_type fc32_to_item32_kernel = NULL;
+static swap_kernel_type swap16_kernel = NULL;
+static scaled_kernel_type sc8_to_fc32_kernel = NULL;
+static scaled_kernel_type fc32_to_sc8_kernel = NULL;
+
+//plain loops where there is no simd version
+static void sc8_to_fc32_generic(const void *in, void *out, const size_t num, const float scalar)
+{
+    sc8_to_fc32_tail(reinterpret_cast<const boost::int8_t *>(in), reinterpret_cast<fc32_t *>(out), num, scalar);
+}
+
+static void bfp8_to_sc16_generic(const void *in, void *out, const size_t num, const int shift)
+{
+    bfp8_to_sc16_tail(reinterpret_cast<const boost::int8_t *>(in), reinterpret_cast<sc16_t *>(out), num, shift);
+}
+
+static shift_kernel_type bfp8_to_sc16_kernel = &bfp8_to_sc16_generic;
+
+class umtrx_convert_scaled : public converter
+{
+public:
+    umtrx_convert_scaled(const scaled_kernel_type kernel):
+        _kernel(kernel), _scalar(1.0f)
+    {
+        //NOP
+    }
+
+    void set_scalar(const double scalar)
+    {
+        _scalar = float(scalar);
+    }
+
+private:
+    void operator()(const input_type &in, const output_type &out, const size_t num)
+    {
+        _kernel(in[0], out[0], num, _scalar);
+    }
+
+    const scaled_kernel_type _kernel;
+    float _scalar;
+};
+
+class umtrx_convert_swap : public converter
+{
+public:
+    umtrx_convert_swap(const swap_kernel_type kernel):
+        _kernel(kernel)
+    {
+        //NOP
+    }
+
+    void set_scalar(const double)
+    {
+        //NOP -- sc16 to sc16 is not scaled
+    }
+
+private:
+    void operator()(const input_type &in, const output_type &out, const size_t num)
+    {
+        _kernel(in[0], out[0], num);
+    }
+
+    const swap_kernel_type _kernel;
+};
+
+class umtrx_convert_shift : public converter
+{
+public:
+    umtrx_convert_shift(const shift_kernel_type kernel):
+        _kernel(kernel), _shift(0)
+    {
+        //NOP
+    }
+
+    //! The streamer scalar of a packet is 2^exponent/32767
+    void set_scalar(const double scalar)
+    {
+        const double shift = std::floor(std::log(scalar*32767)/std::log(2.0) + 0.5);
+        _shift = (shift > 8)? 8 : (shift < 0)? 0 : int(shift);
+    }
+
+private:
+    void operator()(const input_type &in, const output_type &out, const size_t num)
+    {
+        _kernel(in[0], out[0], num, _shift);
+    }
+
+    const shift_kernel_type _kernel;
+    int _shift;
+};
+
+static converter::sptr make_item32_to_fc32(void)
+{
+    return converter::sptr(new umtrx_convert_scaled(item32_to_fc32_kernel));
+}
+
+static converter::sptr make_fc32_to_item32(void)
+{
+    return converter::sptr(new umtrx_convert_scaled(fc32_to_item32_kernel));
+}
+
+static converter::sptr make_sc8_to_fc32(void)
+{
+    return converter::sptr(new umtrx_convert_scaled(sc8_to_fc32_kernel));
+}
+
+static converter::sptr make_fc32_to_sc8(void)
+{
+    return converter::sptr(new umtrx_convert_scaled(fc32_to_sc8_kernel));
+}
+
+static converter::sptr make_bfp8_to_fc32(void)
+{
+    return converter::sptr(new umtrx_convert_scaled((sc8_to_fc32_kernel != NULL)? sc8_to_fc32_kernel : &sc8_to_fc32_generic));
+}
+
+static converter::sptr make_bfp8_to_sc16(void)
+{
+    return converter::sptr(new umtrx_convert_shift(bfp8_to_sc16_kernel));
+}
+
+static converter::sptr make_swap16(void)
+{
+    return converter::sptr(new umtrx_convert_swap(swap16_kernel));
+}
+
+static void gmsk_swap(const void *in_, void *out_, const size_t num)
+{
+    const boost::uint32_t *in = reinterpret_cast<const boost::uint32_t *>(in_);
+    boost::uint32_t *out = reinterpret_cast<boost::uint32_t *>(out_);
+    for (size_t i = 0; i < num; i++) out[i] = uhd::htonx(in[i]);
+}
+
+static converter::sptr make_gmsk_swap(void)
+{
+    return converter::sptr(new umtrx_convert_swap(&gmsk_swap));
+}
+
+static id_type make_id(const std::string &input, const std::string &output)
+{
+    id_type id;
+    id.input_format = input;
+    id.num_inputs = 1;
+    id.output_format = output;
+    id.num_outputs = 1;
+    return id;
+}
+
+UHD_STATIC_BLOCK(register_umtrx_converters)
+{
+    //bits for the TX modulator, a word per item on both sides
+    register_bytes_per_item("gmsk", sizeof(boost::uint32_t));
+    register_converter(make_id("gmsk", "gmsk_item32_be"), &make_gmsk_swap, PRIORITY_UMTRX);
+
+#if defined(UMTRX_CONVERT_SSE2)
+    item32_to_fc32_kernel = &item32_to_fc32_sse2;
+    fc32_to_item32_kernel = &fc32_to_item32_sse2;
+    swap16_kernel = &sc16_swap_sse2;
+    sc8_to_fc32_kernel = &sc8_to_fc32_sse2;
+    fc32_to_sc8_kernel = &fc32_to_sc8_sse2;
+    bfp8_to_sc16_kernel = &bfp8_to_sc16_sse2;
+#  if defined(UMTRX_CONVERT_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        item32_to_fc32_kernel = &item32_to_fc32_avx2;
+        fc32_to_item32_kernel = &fc32_to_item32_avx2;
+    }
+#  endif
+#elif defined(UMTRX_CONVERT_NEON)
+    item32_to_fc32_kernel = &item32_to_fc32_neon;
+    fc32_to_item32_kernel = &fc32_to_item32_neon;
+    swap16_kernel = &sc16_swap_neon;
+    sc8_to_fc32_kernel = &sc8_to_fc32_neon;
+    fc32_to_sc8_kernel = &fc32_to_sc8_neon;
+    bfp8_to_sc16_kernel = &bfp8_to_sc16_neon;
+#endif
+
+    //block floating point RX only exists on UmTRX, it has a plain fallback
+    register_bytes_per_item("bfp8", sizeof(boost::int16_t));
+    register_converter(make_id("bfp8_item32_be", "fc32"), &make_bfp8_to_fc32, PRIORITY_UMTRX);
+    register_converter(make_id("bfp8_item32_be", "sc16"), &make_bfp8_to_sc16, PRIORITY_UMTRX);
+
+    //otherwise nothing better than the UHD generic converters
+    if (swap16_kernel == NULL) return;
+
+    register_converter(make_id("sc16_item32_be", "fc32"), &make_item32_to_fc32, PRIORITY_UMTRX);
+    register_converter(make_id("fc32", "sc16_item32_be"), &make_fc32_to_item32, PRIORITY_UMTRX);
+    register_converter(make_id("sc16_item32_be", "sc16"), &make_swap16, PRIORITY_UMTRX);
+    register_converter(make_id("sc16", "sc16_item32_be"), &make_swap16, PRIORITY_UMTRX);
+    register_converter(make_id("sc8_item32_be", "fc32"), &make_sc8_to_fc32, PRIORITY_UMTRX);
+    register_converter(make_id("fc32", "sc8_item32_be"), &make_fc32_to_sc8, PRIORITY_UMTRX);
+}
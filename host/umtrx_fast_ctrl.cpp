@@ -0,0 +1,206 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_fast_ctrl.hpp"
+#include <uhd/exception.hpp>
+#include <uhd/types/dict.hpp>
+#include <boost/foreach.hpp>
+
+using namespace uhd;
+
+typedef property<double> double_prop;
+typedef property<std::complex<double> > complex_prop;
+
+//! The handles of one side
+struct fast_ctrl_fe_t
+{
+    double_prop *rx_freq, *tx_freq;
+    uhd::dict<std::string, double_prop *> rx_gains, tx_gains;
+    double_prop *rx_gain_total, *tx_gain_total; //null when not in the tree
+    complex_prop *rx_dc_offset, *rx_iq_balance, *tx_dc_offset, *tx_iq_balance;
+};
+
+class umtrx_fast_ctrl_impl : public umtrx_fast_ctrl
+{
+public:
+    umtrx_fast_ctrl_impl(property_tree::sptr tree, const fs_path &mb_path)
+    {
+        BOOST_FOREACH(const std::string &name, tree->list(mb_path / "rx_dsps"))
+        {
+            _rx_rates.push_back(&tree->access<double>(mb_path / "rx_dsps" / name / "rate" / "value"));
+            _rx_freqs.push_back(&tree->access<double>(mb_path / "rx_dsps" / name / "freq" / "value"));
+        }
+        BOOST_FOREACH(const std::string &name, tree->list(mb_path / "tx_dsps"))
+        {
+            _tx_rates.push_back(&tree->access<double>(mb_path / "tx_dsps" / name / "rate" / "value"));
+            _tx_freqs.push_back(&tree->access<double>(mb_path / "tx_dsps" / name / "freq" / "value"));
+        }
+
+        for (char side = 'A'; side <= 'B'; side++)
+        {
+            const std::string fe_name(1, side);
+            const fs_path rx_rf_path = mb_path / "dboards" / fe_name / "rx_frontends" / "0";
+            const fs_path tx_rf_path = mb_path / "dboards" / fe_name / "tx_frontends" / "0";
+            fast_ctrl_fe_t fe;
+            fe.rx_freq = &tree->access<double>(rx_rf_path / "freq" / "value");
+            fe.tx_freq = &tree->access<double>(tx_rf_path / "freq" / "value");
+            BOOST_FOREACH(const std::string &name, tree->list(rx_rf_path / "gains"))
+            {
+                fe.rx_gains[name] = &tree->access<double>(rx_rf_path / "gains" / name / "value");
+            }
+            BOOST_FOREACH(const std::string &name, tree->list(tx_rf_path / "gains"))
+            {
+                fe.tx_gains[name] = &tree->access<double>(tx_rf_path / "gains" / name / "value");
+            }
+            fe.rx_gain_total = tree->exists(rx_rf_path / "gain_total" / "value")?
+                &tree->access<double>(rx_rf_path / "gain_total" / "value") : NULL;
+            fe.tx_gain_total = tree->exists(tx_rf_path / "gain_total" / "value")?
+                &tree->access<double>(tx_rf_path / "gain_total" / "value") : NULL;
+            fe.rx_dc_offset = &tree->access<std::complex<double> >(mb_path / "rx_frontends" / fe_name / "dc_offset" / "value");
+            fe.rx_iq_balance = &tree->access<std::complex<double> >(mb_path / "rx_frontends" / fe_name / "iq_balance" / "value");
+            fe.tx_dc_offset = &tree->access<std::complex<double> >(mb_path / "tx_frontends" / fe_name / "dc_offset" / "value");
+            fe.tx_iq_balance = &tree->access<std::complex<double> >(mb_path / "tx_frontends" / fe_name / "iq_balance" / "value");
+            _fes.push_back(fe);
+        }
+    }
+
+    size_t get_num_rx_dsps(void) const
+    {
+        return _rx_rates.size();
+    }
+
+    size_t get_num_tx_dsps(void) const
+    {
+        return _tx_rates.size();
+    }
+
+    double set_rx_rate(const size_t dsp, const double rate)
+    {
+        return set(*_rx_rates.at(dsp), rate);
+    }
+
+    double get_rx_rate(const size_t dsp)
+    {
+        return _rx_rates.at(dsp)->get();
+    }
+
+    double set_tx_rate(const size_t dsp, const double rate)
+    {
+        return set(*_tx_rates.at(dsp), rate);
+    }
+
+    double get_tx_rate(const size_t dsp)
+    {
+        return _tx_rates.at(dsp)->get();
+    }
+
+    double set_rx_dsp_freq(const size_t dsp, const double freq)
+    {
+        return set(*_rx_freqs.at(dsp), freq);
+    }
+
+    double set_tx_dsp_freq(const size_t dsp, const double freq)
+    {
+        return set(*_tx_freqs.at(dsp), freq);
+    }
+
+    double set_rx_rf_freq(const size_t fe, const double freq)
+    {
+        return set(*_fes.at(fe).rx_freq, freq);
+    }
+
+    double set_tx_rf_freq(const size_t fe, const double freq)
+    {
+        return set(*_fes.at(fe).tx_freq, freq);
+    }
+
+    std::vector<std::string> get_rx_gain_names(const size_t fe) const
+    {
+        return _fes.at(fe).rx_gains.keys();
+    }
+
+    std::vector<std::string> get_tx_gain_names(const size_t fe) const
+    {
+        return _fes.at(fe).tx_gains.keys();
+    }
+
+    double set_rx_gain(const size_t fe, const std::string &name, const double gain)
+    {
+        return set(*gain_prop(_fes.at(fe).rx_gains, name), gain);
+    }
+
+    double set_tx_gain(const size_t fe, const std::string &name, const double gain)
+    {
+        return set(*gain_prop(_fes.at(fe).tx_gains, name), gain);
+    }
+
+    double set_rx_gain_total(const size_t fe, const double gain)
+    {
+        return set(*total_gain_prop(_fes.at(fe).rx_gain_total), gain);
+    }
+
+    double set_tx_gain_total(const size_t fe, const double gain)
+    {
+        return set(*total_gain_prop(_fes.at(fe).tx_gain_total), gain);
+    }
+
+    void set_rx_dc_offset(const size_t fe, const std::complex<double> &offset)
+    {
+        _fes.at(fe).rx_dc_offset->set(offset);
+    }
+
+    void set_rx_iq_balance(const size_t fe, const std::complex<double> &correction)
+    {
+        _fes.at(fe).rx_iq_balance->set(correction);
+    }
+
+    void set_tx_dc_offset(const size_t fe, const std::complex<double> &offset)
+    {
+        _fes.at(fe).tx_dc_offset->set(offset);
+    }
+
+    void set_tx_iq_balance(const size_t fe, const std::complex<double> &correction)
+    {
+        _fes.at(fe).tx_iq_balance->set(correction);
+    }
+
+private:
+    static double set(double_prop &prop, const double value)
+    {
+        return prop.set(value).get();
+    }
+
+    static double_prop *gain_prop(const uhd::dict<std::string, double_prop *> &gains, const std::string &name)
+    {
+        if (not gains.has_key(name)) throw uhd::key_error("umtrx fast ctrl: no gain stage " + name);
+        return gains[name];
+    }
+
+    static double_prop *total_gain_prop(double_prop *prop)
+    {
+        if (prop == NULL) throw uhd::not_implemented_error("umtrx fast ctrl: no overall gain, the PA sets the Tx power");
+        return prop;
+    }
+
+    std::vector<double_prop *> _rx_rates, _rx_freqs, _tx_rates, _tx_freqs;
+    std::vector<fast_ctrl_fe_t> _fes;
+};
+
+umtrx_fast_ctrl::sptr umtrx_fast_ctrl::make(property_tree::sptr tree, const fs_path &mb_path)
+{
+    return sptr(new umtrx_fast_ctrl_impl(tree, mb_path));
+}
@@ -0,0 +1,81 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_FAST_CTRL_HPP
+#define INCLUDED_UMTRX_FAST_CTRL_HPP
+
+#include <uhd/property_tree.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <complex>
+#include <string>
+#include <vector>
+
+/*!
+ * Typed handles on the properties of the hot control paths.
+ *
+ * The property tree parses the path and walks the nodes on every access.
+ * This resolves the tune, gain, rate and correction properties of every
+ * channel once, so a hopping loop or an AGC only pays for the property
+ * itself, its coercer and subscribers run like with the tree.
+ * DSP channels index the rx_dsps and tx_dsps, frontends 0 and 1 are the
+ * A and B sides. Setters return the coerced value. The handles point into
+ * the tree, they are good for the lifetime of the device.
+ */
+class umtrx_fast_ctrl : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_fast_ctrl> sptr;
+
+    //! Resolve the handles, the mboard nodes must all exist
+    static sptr make(uhd::property_tree::sptr tree, const uhd::fs_path &mb_path);
+
+    virtual size_t get_num_rx_dsps(void) const = 0;
+    virtual size_t get_num_tx_dsps(void) const = 0;
+
+    virtual double set_rx_rate(const size_t dsp, const double rate) = 0;
+    virtual double get_rx_rate(const size_t dsp) = 0;
+    virtual double set_tx_rate(const size_t dsp, const double rate) = 0;
+    virtual double get_tx_rate(const size_t dsp) = 0;
+
+    //! DSP tune, the offset from the RF frequency
+    virtual double set_rx_dsp_freq(const size_t dsp, const double freq) = 0;
+    virtual double set_tx_dsp_freq(const size_t dsp, const double freq) = 0;
+
+    //! LO tune of a frontend
+    virtual double set_rx_rf_freq(const size_t fe, const double freq) = 0;
+    virtual double set_tx_rf_freq(const size_t fe, const double freq) = 0;
+
+    //! Gain stages of a frontend, by the names the tree lists
+    virtual std::vector<std::string> get_rx_gain_names(const size_t fe) const = 0;
+    virtual std::vector<std::string> get_tx_gain_names(const size_t fe) const = 0;
+    virtual double set_rx_gain(const size_t fe, const std::string &name, const double gain) = 0;
+    virtual double set_tx_gain(const size_t fe, const std::string &name, const double gain) = 0;
+
+    //! Overall LMS VGA gain of a frontend from the distribution table,
+    //! Tx only without a PA, the PA power is a gain stage then
+    virtual double set_rx_gain_total(const size_t fe, const double gain) = 0;
+    virtual double set_tx_gain_total(const size_t fe, const double gain) = 0;
+
+    //! Frontend corrections
+    virtual void set_rx_dc_offset(const size_t fe, const std::complex<double> &offset) = 0;
+    virtual void set_rx_iq_balance(const size_t fe, const std::complex<double> &correction) = 0;
+    virtual void set_tx_dc_offset(const size_t fe, const std::complex<double> &offset) = 0;
+    virtual void set_tx_iq_balance(const size_t fe, const std::complex<double> &correction) = 0;
+};
+
+#endif /* INCLUDED_UMTRX_FAST_CTRL_HPP */
@@ -21,19 +21,25 @@
 #include <uhd/utils/safe_call.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
 #include "umtrx_fifo_ctrl.hpp"
+#include "umtrx_trace.hpp"
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/chrono.hpp>
 #include <boost/asio.hpp> //htonl
+#include <algorithm>
 #include <boost/format.hpp>
+#include <deque>
 
 using namespace uhd;
 using namespace uhd::transport;
 
 static const size_t POKE32_CMD = (1 << 8);
 static const size_t PEEK32_CMD = 0;
-static const double ACK_TIMEOUT = 0.5;
-static const double MASSIVE_TIMEOUT = 10.0; //for when we wait on a timed command
-static const boost::uint32_t MAX_SEQS_OUT = 15;
+static const double ACK_TIMEOUT = 0.5; //immediate commands, without retransmission
+static const double RETRANSMIT_TIMEOUT = 0.02; //ack wait of each attempt with retransmission
+static const double CMD_EXEC_TIME = 50e-6; //worst case execution per queued command, a SPI transaction
+static const double MASSIVE_TIMEOUT = 10.0; //for a timed command when the device time is unknown
+static const boost::uint32_t MAX_SEQS_OUT = 15; //without the queue status
 
 #define SPI_DIV SR_SPI_CORE + 0
 #define SPI_CTRL SR_SPI_CORE + 1
@@ -41,26 +47,71 @@ static const boost::uint32_t MAX_SEQS_OUT = 15;
 // spi clock rate = master_clock/(div+1)/2
 #define SPI_DIVIDER 16
 
+//! Host steady clock in seconds, the base of the ack deadlines
+static double host_secs(void)
+{
+    return boost::chrono::duration<double>(boost::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/***********************************************************************
+ * A sent packet waiting for its acks
+ **********************************************************************/
+struct fifo_ctrl_pkt_record
+{
+    boost::uint16_t last_seq; //of the last command in the packet
+    double deadline; //host time by which the acks are due
+    std::vector<boost::uint32_t> words; //copy to send again, empty when it is not retransmitted
+    size_t retries; //left
+};
+
+/***********************************************************************
+ * Readback state shared between the controller and a peek future
+ **********************************************************************/
+struct fifo_ctrl_peek_state
+{
+    typedef boost::shared_ptr<fifo_ctrl_peek_state> sptr;
+    fifo_ctrl_peek_state(const boost::uint16_t seq): seq(seq), value(0), done(false){}
+    const boost::uint16_t seq;
+    boost::uint32_t value;
+    bool done;
+};
+
 class umtrx_fifo_ctrl_impl : public umtrx_fifo_ctrl{
 public:
 
-    umtrx_fifo_ctrl_impl(zero_copy_if::sptr xport, const boost::uint32_t sid, const boost::uint32_t window_size):
+    umtrx_fifo_ctrl_impl(zero_copy_if::sptr xport, const boost::uint32_t sid, const boost::uint32_t window_size, const boost::uint32_t max_cmds_per_pkt,
+        const bool has_queue_status, const size_t max_retries):
         _xport(xport),
         _sid(sid),
+        _has_queue_status(has_queue_status),
         _window_size(std::min(window_size, MAX_SEQS_OUT)),
+        _max_cmds_per_pkt(std::max<boost::uint32_t>(1, std::min(max_cmds_per_pkt, _window_size))),
+        _max_retries(max_retries),
+        _queue_fill(0),
         _seq_out(0),
         _seq_ack(0),
-        _timeout(ACK_TIMEOUT)
+        _batch_depth(0),
+        _pkt_cmds(0),
+        _closing(false),
+        _close_timeout(ACK_TIMEOUT)
     {
-        UHD_MSG(status) << "fifo_ctrl.window_size = " << _window_size << std::endl;
         while (_xport->get_recv_buff(0.0)){} //flush
         this->set_time(uhd::time_spec_t(0.0));
         this->set_tick_rate(1.0); //something possible but bogus
         this->init_spi();
+
+        //outstanding commands never fill the command fifo, so the input never blocks
+        if (_has_queue_status){
+            const boost::uint32_t lines = this->peek32(U2_REG_CTRL_QUEUE_RB) >> 16;
+            _window_size = std::max<boost::uint32_t>(1, std::min(window_size, lines));
+            _max_cmds_per_pkt = std::max<boost::uint32_t>(1, std::min(max_cmds_per_pkt, _window_size));
+        }
+        UHD_MSG(status) << "fifo_ctrl.window_size = " << _window_size << std::endl;
     }
 
     ~umtrx_fifo_ctrl_impl(void){
-        _timeout = ACK_TIMEOUT; //reset timeout to something small
+        //do not wait on timed commands still due
+        this->cap_deadlines();
         UHD_SAFE_CALL(
             this->peek32(0); //dummy peek with the purpose of ack'ing all packets
         )
@@ -70,19 +121,91 @@ public:
      * Peek and poke 32 bit implementation
      ******************************************************************/
     void poke32(wb_addr_type addr, boost::uint32_t data){
+        umtrx_trace_scope trace(UMTRX_TRACE_WB, UMTRX_TRACE_WRITE, 0, addr, data);
         boost::mutex::scoped_lock lock(_mutex);
 
-        this->send_pkt((addr - SETTING_REGS_BASE)/4, data, POKE32_CMD);
-
-        this->wait_for_ack(_seq_out-_window_size);
+        this->queue_cmd((addr - SETTING_REGS_BASE)/4, data, POKE32_CMD);
     }
 
     boost::uint32_t peek32(wb_addr_type addr){
+        umtrx_trace_scope trace(UMTRX_TRACE_WB, UMTRX_TRACE_READ, 0, addr);
         boost::mutex::scoped_lock lock(_mutex);
 
         this->send_pkt((addr - READBACK_BASE)/4, 0, PEEK32_CMD);
 
-        return this->wait_for_ack(_seq_out);
+        const boost::uint32_t data = this->wait_for_ack(_seq_out);
+        trace.set_data(data);
+        return data;
+    }
+
+    /*******************************************************************
+     * Deferred readback: the ack is collected by whichever call
+     * waits on the ack stream next, or by the future itself
+     ******************************************************************/
+    class peek_future_impl : public peek_future{
+    public:
+        peek_future_impl(umtrx_fifo_ctrl_impl *ctrl, fifo_ctrl_peek_state::sptr state):
+            _ctrl(ctrl), _state(state){}
+
+        bool ready(void){
+            boost::mutex::scoped_lock lock(_ctrl->_mutex);
+            return _state->done;
+        }
+
+        boost::uint32_t get(void){
+            boost::mutex::scoped_lock lock(_ctrl->_mutex);
+            return _ctrl->collect_peek(_state);
+        }
+
+    private:
+        umtrx_fifo_ctrl_impl *_ctrl;
+        fifo_ctrl_peek_state::sptr _state;
+    };
+
+    peek_future::sptr peek32_async(const wb_addr_type addr){
+        boost::mutex::scoped_lock lock(_mutex);
+
+        fifo_ctrl_peek_state::sptr state = this->queue_peek((addr - READBACK_BASE)/4);
+        return peek_future::sptr(new peek_future_impl(this, state));
+    }
+
+    std::vector<boost::uint32_t> peek32_multi(const std::vector<wb_addr_type> &addrs){
+        umtrx_trace_scope trace(UMTRX_TRACE_WB, UMTRX_TRACE_READ, 0,
+            addrs.empty()? 0 : addrs.front(), addrs.size());
+        boost::mutex::scoped_lock lock(_mutex);
+
+        //queue all the peeks, packed as one batch
+        std::vector<fifo_ctrl_peek_state::sptr> readbacks(addrs.size());
+        _batch_depth++;
+        for (size_t i = 0; i < addrs.size(); i++){
+            readbacks[i] = this->queue_peek((addrs[i] - READBACK_BASE)/4);
+        }
+        _batch_depth--;
+        if (_batch_depth == 0) this->commit_pkt();
+
+        //the last ack carries the others of its packet
+        std::vector<boost::uint32_t> results(addrs.size());
+        for (size_t i = readbacks.size(); i > 0; i--){
+            results[i-1] = this->collect_peek(readbacks[i-1]);
+        }
+        return results;
+    }
+
+    void flush(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        this->commit_pkt();
+        this->wait_for_ack(_seq_out);
+    }
+
+    void begin_batch(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        _batch_depth++;
+    }
+
+    void end_batch(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        UHD_ASSERT_THROW(_batch_depth > 0);
+        if (--_batch_depth == 0) this->commit_pkt();
     }
 
     /*******************************************************************
@@ -102,8 +225,7 @@ public:
     void init_spi(void){
         boost::mutex::scoped_lock lock(_mutex);
 
-        this->send_pkt(SPI_DIV, SPI_DIVIDER, POKE32_CMD);
-        this->wait_for_ack(_seq_out-_window_size);
+        this->queue_cmd(SPI_DIV, SPI_DIVIDER, POKE32_CMD);
 
         _ctrl_word_cache = 0; // force update first time around
     }
@@ -115,71 +237,268 @@ public:
         size_t num_bits,
         bool readback
     ){
+        umtrx_trace_scope trace(UMTRX_TRACE_SPI, readback? UMTRX_TRACE_READ : UMTRX_TRACE_WRITE, which_slave, num_bits, data);
         boost::mutex::scoped_lock lock(_mutex);
 
-        //load control word
-        boost::uint32_t ctrl_word = 0;
-        ctrl_word |= ((which_slave & 0xffffff) << 0);
-        ctrl_word |= ((num_bits & 0x3ff) << 24);
-        if (config.mosi_edge == spi_config_t::EDGE_FALL) ctrl_word |= (1 << 31);
-        if (config.miso_edge == spi_config_t::EDGE_RISE) ctrl_word |= (1 << 30);
-
-        //load data word (must be in upper bits)
-        const boost::uint32_t data_out = data << (32 - num_bits);
-
-        //conditionally send control word
-        if (_ctrl_word_cache != ctrl_word){
-            this->send_pkt(SPI_CTRL, ctrl_word, POKE32_CMD);
-            this->wait_for_ack(_seq_out-_window_size);
-            _ctrl_word_cache = ctrl_word;
-        }
-
-        //send data word
-        this->send_pkt(SPI_DATA, data_out, POKE32_CMD);
-        this->wait_for_ack(_seq_out-_window_size);
+        this->queue_spi(which_slave, config, data, num_bits);
 
         //conditional readback
         if (readback){
             this->send_pkt(U2_REG_SPI_RB, 0, PEEK32_CMD);
-            return this->wait_for_ack(_seq_out);
+            const boost::uint32_t result = this->wait_for_ack(_seq_out);
+            trace.set_data(result);
+            return result;
         }
 
         return 0;
     }
 
+    std::vector<boost::uint32_t> transact_spi_burst(const std::vector<spi_transaction_t> &transactions){
+        umtrx_trace_scope trace(UMTRX_TRACE_SPI, UMTRX_TRACE_WRITE,
+            transactions.empty()? 0 : transactions.front().which_slave, transactions.size(),
+            transactions.empty()? 0 : transactions.front().data);
+        boost::mutex::scoped_lock lock(_mutex);
+
+        //queue everything back to back, packed as one batch
+        std::vector<fifo_ctrl_peek_state::sptr> readbacks(transactions.size());
+        _batch_depth++;
+        for (size_t i = 0; i < transactions.size(); i++){
+            const spi_transaction_t &t = transactions[i];
+            this->queue_spi(t.which_slave, t.config, t.data, t.num_bits);
+            if (t.readback) readbacks[i] = this->queue_peek(U2_REG_SPI_RB);
+        }
+        _batch_depth--;
+        if (_batch_depth == 0) this->commit_pkt();
+
+        //then collect the readbacks in order
+        std::vector<boost::uint32_t> results(transactions.size(), 0);
+        for (size_t i = 0; i < readbacks.size(); i++){
+            if (readbacks[i]) results[i] = this->collect_peek(readbacks[i]);
+        }
+        return results;
+    }
+
+    void with_spi_core(const boost::function<void(void)> &fcn){
+        boost::mutex::scoped_lock lock(_mutex);
+        this->commit_pkt();
+        this->wait_for_ack(_seq_out);
+        _ctrl_word_cache = 0; //sent again, should the function have touched it
+        fcn();
+    }
+
     /*******************************************************************
      * Update methods for time
      ******************************************************************/
     void set_time(const uhd::time_spec_t &time){
         boost::mutex::scoped_lock lock(_mutex);
+        this->commit_pkt(); //the time applies to a whole packet
         _time = time;
         _use_time = _time != uhd::time_spec_t(0.0);
-        if (_use_time) _timeout = MASSIVE_TIMEOUT; //permanently sets larger timeout
+    }
+
+    void set_time_estimator(const time_estimator_type &estimator){
+        boost::mutex::scoped_lock lock(_mutex);
+        _time_estimator = estimator;
+    }
+
+    uhd::time_spec_t get_time(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        return _time;
     }
 
     void set_tick_rate(const double rate){
         boost::mutex::scoped_lock lock(_mutex);
+        this->commit_pkt();
         _tick_rate = rate;
     }
 
+    size_t get_queue_fill(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        return _queue_fill;
+    }
+
+    size_t get_window_size(void){
+        return _window_size;
+    }
+
+    void close(const double timeout){
+        boost::mutex::scoped_lock lock(_mutex);
+        _close_timeout = timeout;
+        this->cap_deadlines();
+        if (not _closing) _batch_depth++; //ended by the final peek
+        _closing = true;
+    }
+
+    size_t poll_acks(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_batch_depth == 0) this->commit_pkt();
+        boost::uint32_t result = 0;
+        while (wraparound_lt16(_seq_ack, _seq_out)){
+            managed_recv_buffer::sptr buff = _xport->get_recv_buff(0.0);
+            if (not buff) break;
+            this->handle_ack_pkt(buff, _seq_out, result);
+        }
+        return boost::uint16_t(_seq_out - _seq_ack);
+    }
+
 private:
 
     /*******************************************************************
      * Primary control and interaction private methods
      ******************************************************************/
+    //! Send a single command packet, any open batch packet goes first
     UHD_INLINE void send_pkt(wb_addr_type addr, boost::uint32_t data, int cmd){
-        managed_send_buffer::sptr buff = _xport->get_send_buff(0.0);
+        this->commit_pkt();
+        this->append_cmd(addr, data, cmd);
+        this->commit_pkt();
+    }
+
+    //! Send a command without waiting for its ack, packed into the open packet while batching
+    UHD_INLINE void queue_cmd(wb_addr_type addr, boost::uint32_t data, int cmd){
+        if (_batch_depth == 0 or _max_cmds_per_pkt == 1){
+            this->send_pkt(addr, data, cmd);
+            this->wait_for_ack(_seq_out-_window_size);
+            return;
+        }
+
+        //the open packet never holds a full window,
+        //so the seq waited on here has always been sent
+        this->wait_for_ack(_seq_out+1-_window_size);
+        this->append_cmd(addr, data, cmd);
+        if (_pkt_cmds >= _max_cmds_per_pkt) this->commit_pkt();
+    }
+
+    //! Queue a readback, its value is filled in when the ack arrives
+    UHD_INLINE fifo_ctrl_peek_state::sptr queue_peek(wb_addr_type addr){
+        fifo_ctrl_peek_state::sptr state(new fifo_ctrl_peek_state(boost::uint16_t(_seq_out+1)));
+        _pending_peeks.push_back(state);
+        this->queue_cmd(addr, 0, PEEK32_CMD);
+        return state;
+    }
+
+    //! Wait for a queued readback, sending the open packet if it holds it
+    UHD_INLINE boost::uint32_t collect_peek(fifo_ctrl_peek_state::sptr state){
+        if (not state->done){
+            this->commit_pkt();
+            this->wait_for_ack(state->seq);
+        }
+        return state->value;
+    }
+
+    //! Queue the ctrl (on a cache miss) and data words of a SPI transaction
+    UHD_INLINE void queue_spi(int which_slave, const spi_config_t &config, boost::uint32_t data, size_t num_bits){
+        //load control word
+        boost::uint32_t ctrl_word = 0;
+        ctrl_word |= ((which_slave & 0xffffff) << 0);
+        ctrl_word |= ((num_bits & 0x3ff) << 24);
+        if (config.mosi_edge == spi_config_t::EDGE_FALL) ctrl_word |= (1 << 31);
+        if (config.miso_edge == spi_config_t::EDGE_RISE) ctrl_word |= (1 << 30);
+
+        //load data word (must be in upper bits)
+        const boost::uint32_t data_out = data << (32 - num_bits);
+
+        //conditionally send control word
+        if (_ctrl_word_cache != ctrl_word){
+            this->queue_cmd(SPI_CTRL, ctrl_word, POKE32_CMD);
+            _ctrl_word_cache = ctrl_word;
+        }
+
+        //send data word
+        this->queue_cmd(SPI_DATA, data_out, POKE32_CMD);
+    }
+
+    //! Add a command to the open packet, opening one if needed
+    UHD_INLINE void append_cmd(wb_addr_type addr, boost::uint32_t data, int cmd){
+        if (not _pkt_buff){
+            _pkt_buff = _xport->get_send_buff(0.0);
+            if (not _pkt_buff){
+                throw uhd::runtime_error("fifo ctrl timed out getting a send buffer");
+            }
+            _pkt_cmds = 0;
+        }
+        ++_seq_out;
+        boost::uint32_t *payload = this->pack_hdr(0) + 2*_pkt_cmds;
+        const boost::uint32_t ctrl_word = (addr & 0xff) | cmd | (_seq_out << 16);
+        payload[0] = htonl(ctrl_word);
+        payload[1] = htonl(data);
+        _pkt_cmds++;
+    }
+
+    //! Finish the header of the open packet and send it
+    UHD_INLINE void commit_pkt(void){
+        if (not _pkt_buff) return;
+        this->pack_hdr(_pkt_cmds);
+        boost::uint32_t *trans = _pkt_buff->cast<boost::uint32_t *>();
+        trans[0] = htonl(_seq_out);
+
+        fifo_ctrl_pkt_record record;
+        record.last_seq = _seq_out;
+        record.deadline = this->ack_deadline();
+        record.retries = (_use_time or _closing)? 0 : _max_retries;
+        if (record.retries != 0) record.words.assign(trans, trans + _pkt_words32 + 1);
+        _inflight.push_back(record);
+
+        _pkt_buff->commit(sizeof(boost::uint32_t)*(_pkt_words32+1));
+        _pkt_buff.reset();
+        _pkt_cmds = 0;
+    }
+
+    /*!
+     * The ack deadline of the packet being sent.
+     * Timed commands are due at their command time, by the estimated device time,
+     * immediate ones after the commands queued ahead of them. The fifo executes
+     * in order, nothing is due before the packets in front of it.
+     */
+    UHD_INLINE double ack_deadline(void){
+        const double now = host_secs();
+        const double exec = CMD_EXEC_TIME*boost::uint16_t(_seq_out - _seq_ack);
+        double deadline = now + exec + (_max_retries? RETRANSMIT_TIMEOUT : ACK_TIMEOUT);
+        if (_use_time){
+            uhd::time_spec_t device_now;
+            double error = 0.0;
+            if (_time_estimator and _time_estimator(device_now, error)){
+                deadline = now + exec + ACK_TIMEOUT + error + std::max(0.0, (_time - device_now).get_real_secs());
+            }
+            else deadline = now + MASSIVE_TIMEOUT;
+        }
+        if (not _inflight.empty()) deadline = std::max(deadline, _inflight.back().deadline);
+        if (_closing) deadline = std::min(deadline, now + _close_timeout);
+        return deadline;
+    }
+
+    //! Do not wait on timed commands still due, nor retransmit, during the teardown
+    void cap_deadlines(void){
+        const double deadline = host_secs() + _close_timeout;
+        for (size_t i = 0; i < _inflight.size(); i++){
+            _inflight[i].deadline = std::min(_inflight[i].deadline, deadline);
+            _inflight[i].retries = 0;
+        }
+    }
+
+    //! Send the oldest unacked packet again, a lost packet or ack
+    UHD_INLINE void retransmit(fifo_ctrl_pkt_record &record){
+        managed_send_buffer::sptr buff = _xport->get_send_buff(RETRANSMIT_TIMEOUT);
         if (not buff){
             throw uhd::runtime_error("fifo ctrl timed out getting a send buffer");
         }
-        boost::uint32_t *trans = buff->cast<boost::uint32_t *>();
-        trans[0] = htonl(++_seq_out);
-        boost::uint32_t *pkt = trans + 1;
+        std::copy(record.words.begin(), record.words.end(), buff->cast<boost::uint32_t *>());
+        buff->commit(sizeof(boost::uint32_t)*record.words.size());
+        record.retries--;
+        //the queue ahead of it is gone, it only waits on itself now
+        record.deadline = host_secs() + CMD_EXEC_TIME*boost::uint16_t(record.last_seq - _seq_ack) + RETRANSMIT_TIMEOUT;
+        for (size_t i = 1; i < _inflight.size(); i++){
+            _inflight[i].deadline = std::max(_inflight[i].deadline, record.deadline);
+        }
+    }
+
+    //! Pack the VRT header for num_cmds commands, return the payload start
+    UHD_INLINE boost::uint32_t *pack_hdr(const size_t num_cmds){
+        boost::uint32_t *pkt = _pkt_buff->cast<boost::uint32_t *>() + 1;
 
         //load packet info
         vrt::if_packet_info_t packet_info;
         packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_CONTEXT;
-        packet_info.num_payload_words32 = 2;
+        packet_info.num_payload_words32 = 2*num_cmds;
         packet_info.num_payload_bytes = packet_info.num_payload_words32*sizeof(boost::uint32_t);
         packet_info.packet_count = _seq_out;
         packet_info.sid = _sid;
@@ -194,14 +513,8 @@ private:
 
         //load header
         vrt::if_hdr_pack_be(pkt, packet_info);
-
-        //load payload
-        const boost::uint32_t ctrl_word = (addr & 0xff) | cmd | (_seq_out << 16);
-        pkt[packet_info.num_header_words32+0] = htonl(ctrl_word);
-        pkt[packet_info.num_header_words32+1] = htonl(data);
-
-        //send the buffer over the interface
-        buff->commit(sizeof(boost::uint32_t)*(packet_info.num_packet_words32+1));
+        _pkt_words32 = packet_info.num_packet_words32;
+        return pkt + packet_info.num_header_words32;
     }
 
     UHD_INLINE bool wraparound_lt16(const boost::int16_t i0, const boost::int16_t i1){
@@ -210,40 +523,91 @@ private:
         return boost::int16_t(i1 - i0) > 0;
     }
 
+    //! Wait for the ack of a command, an ack packet holds the (hdr, data) results of one or more
     UHD_INLINE boost::uint32_t wait_for_ack(const boost::uint16_t seq_to_ack){
+        boost::uint32_t result = 0;
 
         while (wraparound_lt16(_seq_ack, seq_to_ack)){
-            managed_recv_buffer::sptr buff = _xport->get_recv_buff(_timeout);
-            if (not buff){
-                throw uhd::runtime_error("fifo ctrl timed out looking for acks");
+            while (not _inflight.empty() and not wraparound_lt16(_seq_ack, _inflight.front().last_seq)){
+                _inflight.pop_front();
             }
-            const boost::uint32_t *pkt = buff->cast<const boost::uint32_t *>();
-            vrt::if_packet_info_t packet_info;
-            packet_info.num_packet_words32 = buff->size()/sizeof(boost::uint32_t);
-            vrt::if_hdr_unpack_be(pkt, packet_info);
-            _seq_ack = ntohl(pkt[packet_info.num_header_words32+0]) >> 16;
-            if (_seq_ack == seq_to_ack){
-                return ntohl(pkt[packet_info.num_header_words32+1]);
+            const double timeout = _inflight.empty()? ACK_TIMEOUT : _inflight.front().deadline - host_secs();
+            managed_recv_buffer::sptr buff = _xport->get_recv_buff(std::max(0.0, timeout));
+            if (not buff){
+                if (not _inflight.empty() and _inflight.front().retries != 0){
+                    this->retransmit(_inflight.front());
+                    continue;
+                }
+                throw uhd::runtime_error(str(boost::format(
+                    "fifo ctrl timed out looking for acks, seq %u, last ack %u") % seq_to_ack % _seq_ack));
             }
+            this->handle_ack_pkt(buff, seq_to_ack, result);
         }
 
-        return 0;
+        return result;
     }
 
+    //! Take the results of an ack packet, the data of seq_to_ack goes to result
+    UHD_INLINE void handle_ack_pkt(managed_recv_buffer::sptr buff, const boost::uint16_t seq_to_ack, boost::uint32_t &result){
+        const boost::uint32_t *pkt = buff->cast<const boost::uint32_t *>();
+        vrt::if_packet_info_t packet_info;
+        packet_info.num_packet_words32 = buff->size()/sizeof(boost::uint32_t);
+        vrt::if_hdr_unpack_be(pkt, packet_info);
+        if (_has_queue_status) _queue_fill = packet_info.sid & 0xffff;
+        const boost::uint32_t *results = pkt + packet_info.num_header_words32;
+        const size_t num_results = std::max<size_t>(1, packet_info.num_payload_words32/2);
+        for (size_t i = 0; i < num_results; i++){
+            const boost::uint16_t seq = ntohl(results[2*i+0]) >> 16;
+            if (not wraparound_lt16(_seq_ack, seq)) continue; //a retransmitted packet ack'd twice
+            _seq_ack = seq;
+            const boost::uint32_t data = ntohl(results[2*i+1]);
+            if (not _pending_peeks.empty()) this->resolve_peeks(data);
+            if (_seq_ack == seq_to_ack) result = data;
+        }
+    }
+
+    //! Complete the deferred readbacks up to the current ack
+    void resolve_peeks(const boost::uint32_t data){
+        while (not _pending_peeks.empty()){
+            fifo_ctrl_peek_state::sptr state = _pending_peeks.front();
+            if (wraparound_lt16(_seq_ack, state->seq)) break;
+            if (state->seq == _seq_ack) state->value = data;
+            state->done = true;
+            _pending_peeks.pop_front();
+        }
+    }
+
+    std::deque<fifo_ctrl_peek_state::sptr> _pending_peeks;
+    std::deque<fifo_ctrl_pkt_record> _inflight;
     zero_copy_if::sptr _xport;
     const boost::uint32_t _sid;
-    const boost::uint32_t _window_size;
+    const bool _has_queue_status;
+    boost::uint32_t _window_size;
+    boost::uint32_t _max_cmds_per_pkt;
+    const size_t _max_retries;
+    size_t _queue_fill;
     boost::mutex _mutex;
     boost::uint16_t _seq_out;
     boost::uint16_t _seq_ack;
     uhd::time_spec_t _time;
     bool _use_time;
     double _tick_rate;
-    double _timeout;
+    time_estimator_type _time_estimator;
     boost::uint32_t _ctrl_word_cache;
+
+    //open multi-command packet while batching
+    size_t _batch_depth;
+    managed_send_buffer::sptr _pkt_buff;
+    size_t _pkt_cmds;
+    size_t _pkt_words32;
+
+    //teardown bounds set by close()
+    bool _closing;
+    double _close_timeout;
 };
 
 
-umtrx_fifo_ctrl::sptr umtrx_fifo_ctrl::make(zero_copy_if::sptr xport, const boost::uint32_t sid, const size_t window_size){
-    return sptr(new umtrx_fifo_ctrl_impl(xport, sid, boost::uint32_t(window_size)));
+umtrx_fifo_ctrl::sptr umtrx_fifo_ctrl::make(zero_copy_if::sptr xport, const boost::uint32_t sid, const size_t window_size, const size_t max_cmds_per_pkt,
+    const bool has_queue_status, const size_t max_retries){
+    return sptr(new umtrx_fifo_ctrl_impl(xport, sid, boost::uint32_t(window_size), boost::uint32_t(max_cmds_per_pkt), has_queue_status, max_retries));
 }
@@ -22,10 +22,13 @@
 #include <uhd/types/serial.hpp>
 #include <uhd/transport/zero_copy.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
 #include <boost/utility.hpp>
 #include <boost/cstdint.hpp>
 #include <uhd/types/wb_iface.hpp>
+#include <uhd/utils/safe_call.hpp>
 #include <string>
+#include <vector>
 
 #include "umtrx_common.hpp"
 
@@ -38,14 +41,147 @@ class umtrx_fifo_ctrl : public uhd::wb_iface, public uhd::spi_iface
 public:
     typedef UMTRX_UHD_PTR_NAMESPACE::shared_ptr<umtrx_fifo_ctrl> sptr;
 
-    //! Make a new FIFO control object
-    static sptr make(uhd::transport::zero_copy_if::sptr xport, const boost::uint32_t sid, const size_t window_size);
+    /*!
+     * Make a new FIFO control object
+     * \param max_cmds_per_pkt commands packed per packet inside a batch,
+     *        1 unless the FPGA settings_fifo_ctrl accepts multi-command packets
+     * \param has_queue_status the FPGA reports its command fifo size and fill,
+     *        the window then grows up to the fifo size instead of the 15 of a shortfifo
+     * \param max_retries times an immediate packet is sent again when its ack does not come,
+     *        0 waits the full ack timeout instead. A command whose ack only was lost runs twice.
+     */
+    static sptr make(uhd::transport::zero_copy_if::sptr xport, const boost::uint32_t sid, const size_t window_size, const size_t max_cmds_per_pkt = 1,
+        const bool has_queue_status = false, const size_t max_retries = 0);
+
+    //! A readback issued with peek32_async(), must not outlive the controller
+    class peek_future
+    {
+    public:
+        typedef boost::shared_ptr<peek_future> sptr;
+        virtual ~peek_future(void){}
+
+        //! True when the readback has been ack'd
+        virtual bool ready(void) = 0;
+
+        //! Wait for the readback (if needed) and return its value
+        virtual boost::uint32_t get(void) = 0;
+    };
+
+    /*!
+     * Issue a readback without waiting for it.
+     * Pokes and other peeks keep streaming out while it is in flight.
+     */
+    virtual peek_future::sptr peek32_async(const wb_addr_type addr) = 0;
+
+    /*!
+     * Read a block of readback words in one round trip.
+     * The peeks go out back to back, packed like a batch, and the FPGA
+     * acks up to a packet of them with one reply. No other command of
+     * this controller runs in between, Ex: a time hi/lo pair is coherent
+     * when the lo word is peeked right before its snapshot register.
+     * \param addrs readback addresses, in the order they are executed
+     * \return one word per address
+     */
+    virtual std::vector<boost::uint32_t> peek32_multi(const std::vector<wb_addr_type> &addrs) = 0;
+
+    //! Wait until every command sent so far has been ack'd
+    virtual void flush(void) = 0;
+
+    /*!
+     * Start a batch: pokes are packed into shared packets until end_batch().
+     * Peeks, time changes and the window limit send the open packet early.
+     * Batches nest, only the outermost end_batch() sends the packet.
+     */
+    virtual void begin_batch(void) = 0;
+
+    //! End a batch started with begin_batch()
+    virtual void end_batch(void) = 0;
+
+    //! One transaction of a SPI burst
+    struct spi_transaction_t
+    {
+        spi_transaction_t(void): which_slave(0), data(0), num_bits(0), readback(false){}
+        int which_slave;
+        uhd::spi_config_t config;
+        boost::uint32_t data;
+        size_t num_bits;
+        bool readback;
+    };
+
+    /*!
+     * Run a burst of SPI transactions back to back.
+     * The readbacks are only collected after the whole burst is sent.
+     * \return one readback word per transaction, 0 for plain writes
+     */
+    virtual std::vector<boost::uint32_t> transact_spi_burst(const std::vector<spi_transaction_t> &transactions) = 0;
+
+    /*!
+     * Run a function with the SPI core to itself, Ex: a firmware routine driving the SPI.
+     * Every command sent so far is ack'd first, and the SPI config is sent again afterwards.
+     * The function must not call into the fifo ctrl.
+     */
+    virtual void with_spi_core(const boost::function<void(void)> &fcn) = 0;
 
     //! Set the command time that will activate
     virtual void set_time(const uhd::time_spec_t &time) = 0;
 
+    //! Device time estimate and its error bound, false when there is none
+    typedef boost::function<bool(uhd::time_spec_t &, double &)> time_estimator_type;
+
+    /*!
+     * Set the device time estimate the ack deadlines of timed commands come from,
+     * Ex: umtrx_time_model::estimate_time_now(). Without one a timed command may
+     * take 10 seconds to time out. It is called with the controller locked and
+     * must not call into it.
+     */
+    virtual void set_time_estimator(const time_estimator_type &estimator) = 0;
+
+    //! Get the command time, zero when commands are not timed
+    virtual uhd::time_spec_t get_time(void) = 0;
+
     //! Set the tick rate (converting time into ticks)
     virtual void set_tick_rate(const double rate) = 0;
+
+    //! Commands waiting in the FPGA as of the last ack, Ex: timed ones not due yet
+    virtual size_t get_queue_fill(void) = 0;
+
+    //! Commands that may be outstanding at once
+    virtual size_t get_window_size(void) = 0;
+
+    /*!
+     * Take the acks that already arrived, without waiting.
+     * Sends the open packet unless a batch is open. For event loops that
+     * wait on peek_future::ready(): lost acks are only sent again by the
+     * calls that wait.
+     * \return commands still waiting for their ack
+     */
+    virtual size_t poll_acks(void) = 0;
+
+    /*!
+     * Start the teardown. Ack waits from here on, and the final flush of
+     * the destructor, give up after timeout seconds. The pokes are packed
+     * into shared packets until the destructor sends them.
+     * \param timeout seconds to wait for an ack
+     */
+    virtual void close(const double timeout) = 0;
+};
+
+//! Keeps a fifo ctrl batch open for the lifetime of the scope
+class umtrx_fifo_ctrl_batch : boost::noncopyable
+{
+public:
+    umtrx_fifo_ctrl_batch(umtrx_fifo_ctrl::sptr ctrl): _ctrl(ctrl)
+    {
+        _ctrl->begin_batch();
+    }
+
+    ~umtrx_fifo_ctrl_batch(void)
+    {
+        UHD_SAFE_CALL(_ctrl->end_batch();)
+    }
+
+private:
+    umtrx_fifo_ctrl::sptr _ctrl;
 };
 
 #endif /* INCLUDED_UMTRX_FIFO_CTRL_HPP */
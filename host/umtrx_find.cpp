@@ -20,47 +20,102 @@
 #include "umtrx_log_adapter.hpp"
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/byteswap.hpp>
+#include <uhd/exception.hpp>
 #include <uhd/types/device_addr.hpp>
 #include <uhd/transport/if_addrs.hpp>
 #include <uhd/transport/udp_simple.hpp>
 #include <boost/asio.hpp>
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <set>
 
 using namespace uhd;
 using namespace uhd::usrp;
 using namespace uhd::transport;
 namespace asio = boost::asio;
 
-device_addrs_t umtrx_find(const device_addr_t &hint) {
-
-    device_addrs_t umtrx_addrs;
-
-    //Return an empty list of addresses when a resource is specified,
-    //since a resource is intended for a different, non-USB, device.
-    if (hint.has_key("resource")) return umtrx_addrs;
-
-    //return an empty list of addresses when type is set to non-umtrx
-    if (hint.has_key("type") and hint["type"] != "umtrx") return umtrx_addrs;
+/***********************************************************************
+ * Discovery state shared by the interface and verification threads
+ **********************************************************************/
+struct umtrx_find_state
+{
+    umtrx_find_state(void): done(false){}
+    boost::mutex mutex;
+    device_addrs_t addrs;
+    std::set<std::string> seen; //reply addresses, a board may answer on several broadcasts
+    bool done; //the hinted serial was found
+};
+
+static usrp2_ctrl_data_t umtrx_hello(void)
+{
+    usrp2_ctrl_data_t ctrl_data_out = usrp2_ctrl_data_t();
+    ctrl_data_out.proto_ver = uhd::htonx<boost::uint32_t>(USRP2_FW_COMPAT_NUM);
+    ctrl_data_out.id = uhd::htonx<boost::uint32_t>(UMTRX_CTRL_ID_REQUEST);
+    return ctrl_data_out;
+}
 
-    //if no address was specified, send a broadcast on each interface
-    if (not hint.has_key("addr")){
-        BOOST_FOREACH(const if_addrs_t &if_addrs, get_if_addrs()){
-            //avoid the loopback device
-            if (if_addrs.inet == asio::ip::address_v4::loopback().to_string()) continue;
+/*!
+ * Check one board that replied to the broadcast and add it when it matches the hint.
+ * Runs in its own thread, the boards of a rack are verified at the same time.
+ */
+static void umtrx_verify(const device_addr_t &hint, const std::string &addr, umtrx_find_state *state)
+{
+    device_addr_t new_addr;
+    new_addr["type"] = "umtrx";
+    new_addr["addr"] = addr;
+
+    //Attempt a simple 2-way communication with a connected socket.
+    //Reason: Although the USRP will respond the broadcast above,
+    //we may not be able to communicate directly (non-broadcast).
+    udp_simple::sptr ctrl_xport;
+    try{
+        ctrl_xport = udp_simple::make_connected(addr, BOOST_STRINGIZE(USRP2_UDP_CTRL_PORT));
+        const usrp2_ctrl_data_t ctrl_data_out = umtrx_hello();
+        ctrl_xport->send(boost::asio::buffer(&ctrl_data_out, sizeof(ctrl_data_out)));
+        boost::uint8_t usrp2_ctrl_data_in_mem[udp_simple::mtu]; //allocate max bytes for recv
+        const usrp2_ctrl_data_t *ctrl_data_in = reinterpret_cast<const usrp2_ctrl_data_t *>(usrp2_ctrl_data_in_mem);
+        const size_t len = ctrl_xport->recv(asio::buffer(usrp2_ctrl_data_in_mem));
+        if (len <= offsetof(usrp2_ctrl_data_t, data) or ntohl(ctrl_data_in->id) != UMTRX_CTRL_ID_RESPONSE) return;
+    }
+    catch(const std::exception &){
+        return; //otherwise we don't find it...
+    }
 
-            //create a new hint with this broadcast address
-            device_addr_t new_hint = hint;
-            new_hint["addr"] = if_addrs.bcast;
+    //Attempt to read the name from the EEPROM and perform filtering.
+    //This operation can throw due to compatibility mismatch.
+    try{
+        umtrx_iface::sptr iface = umtrx_iface::make(ctrl_xport);
+        if (iface->is_device_locked()) return; //ignore locked devices
+        mboard_eeprom_t mb_eeprom = iface->mb_eeprom;
+        new_addr["name"] = mb_eeprom["name"];
+        new_addr["serial"] = mb_eeprom["serial"];
+    }
+    catch(const std::exception &){
+        //set these values as empty string so the device may still be found
+        //and the filter's below can still operate on the discovered device
+        new_addr["name"] = "";
+        new_addr["serial"] = "";
+    }
 
-            //call discover with the new hint and append results
-            device_addrs_t new_umtrx_addrs = umtrx_find(new_hint);
-            umtrx_addrs.insert(umtrx_addrs.begin(),
-                new_umtrx_addrs.begin(), new_umtrx_addrs.end()
-            );
-        }
-        return umtrx_addrs;
+    //filter the discovered device below by matching optional keys
+    if (
+        (not hint.has_key("name")   or hint["name"]   == new_addr["name"]) and
+        (not hint.has_key("serial") or hint["serial"] == new_addr["serial"])
+    ){
+        boost::mutex::scoped_lock lock(state->mutex);
+        state->addrs.push_back(new_addr);
+        if (hint.has_key("serial")) state->done = true; //serials are unique, stop listening
     }
+}
 
+/*!
+ * Broadcast (or unicast) a hello to hint["addr"] and verify the boards that reply.
+ */
+static void umtrx_find_addr(const device_addr_t &hint, umtrx_find_state *state)
+{
     //Create a UDP transport to communicate:
     //Some devices will cause a throw when opened for a broadcast address.
     //We print and recover so the caller can loop through all bcast addrs.
@@ -70,13 +125,11 @@ device_addrs_t umtrx_find(const device_addr_t &hint) {
     }
     catch(const std::exception &e){
         UHD_MSG(error) << boost::format("Cannot open UDP transport on %s\n%s") % hint["addr"] % e.what() << std::endl;
-        return umtrx_addrs; //dont throw, but return empty address so caller can insert
+        return; //dont throw, the other interfaces still report their devices
     }
 
     //send a hello control packet
-    usrp2_ctrl_data_t ctrl_data_out = usrp2_ctrl_data_t();
-    ctrl_data_out.proto_ver = uhd::htonx<boost::uint32_t>(USRP2_FW_COMPAT_NUM);
-    ctrl_data_out.id = uhd::htonx<boost::uint32_t>(UMTRX_CTRL_ID_REQUEST);
+    const usrp2_ctrl_data_t ctrl_data_out = umtrx_hello();
     try
     {
         udp_transport->send(boost::asio::buffer(&ctrl_data_out, sizeof(ctrl_data_out)));
@@ -90,67 +143,97 @@ device_addrs_t umtrx_find(const device_addr_t &hint) {
         UHD_MSG(error) << "UMTRX Network discovery unknown error " << std::endl;
     }
 
-    //loop and recieve until the timeout
+    //loop and recieve until the timeout, verifying each board as it replies
+    boost::thread_group verifiers;
     boost::uint8_t usrp2_ctrl_data_in_mem[udp_simple::mtu]; //allocate max bytes for recv
     const usrp2_ctrl_data_t *ctrl_data_in = reinterpret_cast<const usrp2_ctrl_data_t *>(usrp2_ctrl_data_in_mem);
     while(true){
-        size_t len = udp_transport->recv(asio::buffer(usrp2_ctrl_data_in_mem));
-        if (len > offsetof(usrp2_ctrl_data_t, data) and ntohl(ctrl_data_in->id) == UMTRX_CTRL_ID_RESPONSE){
-
-            //make a boost asio ipv4 with the raw addr in host byte order
-            device_addr_t new_addr;
-            new_addr["type"] = "umtrx";
-            //We used to get the address from the control packet.
-            //Now now uses the socket itself to yield the address.
-            //boost::asio::ip::address_v4 ip_addr(ntohl(ctrl_data_in->data.ip_addr));
-            //new_addr["addr"] = ip_addr.to_string();
-            new_addr["addr"] = udp_transport->get_recv_addr();
-
-            //Attempt a simple 2-way communication with a connected socket.
-            //Reason: Although the USRP will respond the broadcast above,
-            //we may not be able to communicate directly (non-broadcast).
-            udp_simple::sptr ctrl_xport = udp_simple::make_connected(
-                new_addr["addr"], BOOST_STRINGIZE(USRP2_UDP_CTRL_PORT)
-            );
-            ctrl_xport->send(boost::asio::buffer(&ctrl_data_out, sizeof(ctrl_data_out)));
-            size_t len = ctrl_xport->recv(asio::buffer(usrp2_ctrl_data_in_mem));
-            if (len > offsetof(usrp2_ctrl_data_t, data) and ntohl(ctrl_data_in->id) == UMTRX_CTRL_ID_RESPONSE){
-                //found the device, open up for communication!
-            }
-            else{
-                //otherwise we don't find it...
-                continue;
-            }
-
-            //Attempt to read the name from the EEPROM and perform filtering.
-            //This operation can throw due to compatibility mismatch.
-            try{
-                umtrx_iface::sptr iface = umtrx_iface::make(ctrl_xport);
-                if (iface->is_device_locked()) continue; //ignore locked devices
-                mboard_eeprom_t mb_eeprom = iface->mb_eeprom;
-                new_addr["name"] = mb_eeprom["name"];
-                new_addr["serial"] = mb_eeprom["serial"];
-            }
-            catch(const std::exception &){
-                //set these values as empty string so the device may still be found
-                //and the filter's below can still operate on the discovered device
-                new_addr["name"] = "";
-                new_addr["serial"] = "";
-            }
-
-            //filter the discovered device below by matching optional keys
-            if (
-                (not hint.has_key("name")   or hint["name"]   == new_addr["name"]) and
-                (not hint.has_key("serial") or hint["serial"] == new_addr["serial"])
-            ){
-                umtrx_addrs.push_back(new_addr);
-            }
-
-            //dont break here, it will exit the while loop
-            //just continue on to the next loop iteration
+        {
+            boost::mutex::scoped_lock lock(state->mutex);
+            if (state->done) break;
         }
+        size_t len = udp_transport->recv(asio::buffer(usrp2_ctrl_data_in_mem));
         if (len == 0) break; //timeout
+        if (len <= offsetof(usrp2_ctrl_data_t, data) or ntohl(ctrl_data_in->id) != UMTRX_CTRL_ID_RESPONSE) continue;
+
+        //We used to get the address from the control packet.
+        //Now now uses the socket itself to yield the address.
+        const std::string addr = udp_transport->get_recv_addr();
+        {
+            boost::mutex::scoped_lock lock(state->mutex);
+            if (not state->seen.insert(addr).second) continue;
+        }
+#ifndef UMTRX_EMBEDDED
+        verifiers.create_thread(boost::bind(&umtrx_verify, hint, addr, state));
+#else
+        umtrx_verify(hint, addr, state); //one board at a time, no thread per reply
+#endif
+    }
+    verifiers.join_all();
+}
+
+device_addrs_t umtrx_find(const device_addr_t &hint);
+
+static void umtrx_find_sub(const device_addr_t &hint, device_addrs_t *found)
+{
+    try{
+        *found = umtrx_find(hint);
+    }
+    catch(const std::exception &ex){
+        UHD_MSG(error) << "UMTRX Network discovery error " << ex.what() << std::endl;
+    }
+}
+
+device_addrs_t umtrx_find(const device_addr_t &hint) {
+
+    device_addrs_t umtrx_addrs;
+
+    //Return an empty list of addresses when a resource is specified,
+    //since a resource is intended for a different, non-USB, device.
+    if (hint.has_key("resource")) return umtrx_addrs;
+
+    //return an empty list of addresses when type is set to non-umtrx
+    if (hint.has_key("type") and hint["type"] != "umtrx") return umtrx_addrs;
+
+    //a hint for several boards (addr0, serial1, ...) resolves each board in parallel,
+    //the result lists one device per board in the order of the hint
+    const device_addrs_t hints = separate_device_addr(hint);
+    if (hints.size() > 1){
+        std::vector<device_addrs_t> found(hints.size());
+        boost::thread_group finders;
+        for (size_t i = 0; i < hints.size(); i++){
+            finders.create_thread(boost::bind(&umtrx_find_sub, hints[i], &found[i]));
+        }
+        finders.join_all();
+        for (size_t i = 0; i < hints.size(); i++){
+            if (found[i].size() != 1) throw uhd::value_error(str(boost::format(
+                "Could not resolve device hint \"%s\" to a single device."
+            ) % hints[i].to_string()));
+            umtrx_addrs.push_back(found[i][0]);
+        }
+        return umtrx_addrs;
+    }
+
+    umtrx_find_state state;
+
+    //if no address was specified, send a broadcast on each interface
+    if (not hint.has_key("addr")){
+        boost::thread_group finders;
+        BOOST_FOREACH(const if_addrs_t &if_addrs, get_if_addrs()){
+            //avoid the loopback device
+            if (if_addrs.inet == asio::ip::address_v4::loopback().to_string()) continue;
+
+            //create a new hint with this broadcast address
+            device_addr_t new_hint = hint;
+            new_hint["addr"] = if_addrs.bcast;
+
+            //all interfaces listen at once, a hinted serial on one ends the others
+            finders.create_thread(boost::bind(&umtrx_find_addr, new_hint, &state));
+        }
+        finders.join_all();
+        return state.addrs;
     }
 
-    return umtrx_addrs;
+    umtrx_find_addr(hint, &state);
+    return state.addrs;
 }
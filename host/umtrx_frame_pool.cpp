@@ -0,0 +1,180 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_frame_pool.hpp"
+#include "umtrx_log_adapter.hpp"
+#include <uhd/config.hpp>
+#include <uhd/exception.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+using namespace uhd;
+
+#ifdef UHD_PLATFORM_LINUX
+
+//! bytes from a size hint with an optional k/M/G suffix
+static size_t parse_size(const std::string &value)
+{
+    if (value.empty()) return 0;
+    size_t scale = 1;
+    std::string number = value;
+    switch (value[value.size()-1])
+    {
+    case 'k': case 'K': scale = size_t(1) << 10; break;
+    case 'm': case 'M': scale = size_t(1) << 20; break;
+    case 'g': case 'G': scale = size_t(1) << 30; break;
+    default: break;
+    }
+    if (scale != 1) number.erase(number.size()-1);
+    return size_t(boost::lexical_cast<double>(number)*scale);
+}
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <ifaddrs.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+static const int UMTRX_MPOL_BIND = 2; //linux/mempolicy.h
+static const unsigned UMTRX_MPOL_MF_MOVE = 1 << 1;
+
+static int numa_node_of_iface(const std::string &iface)
+{
+    std::ifstream file(("/sys/class/net/" + iface + "/device/numa_node").c_str());
+    int node = -1;
+    if (not (file >> node)) node = -1; //virtual interfaces have no device
+    return node;
+}
+
+std::string umtrx_frame_pool::find_iface(const boost::uint32_t device_addr)
+{
+    struct ifaddrs *ifas = NULL;
+    if (::getifaddrs(&ifas) != 0) throw uhd::os_error("umtrx_frame_pool: getifaddrs failed");
+    std::string name;
+    for (struct ifaddrs *ifa = ifas; ifa != NULL and name.empty(); ifa = ifa->ifa_next)
+    {
+        if (ifa->ifa_addr == NULL or ifa->ifa_netmask == NULL) continue;
+        if (ifa->ifa_addr->sa_family != AF_INET) continue;
+        const boost::uint32_t ip = reinterpret_cast<struct sockaddr_in *>(ifa->ifa_addr)->sin_addr.s_addr;
+        const boost::uint32_t mask = reinterpret_cast<struct sockaddr_in *>(ifa->ifa_netmask)->sin_addr.s_addr;
+        if ((ip & mask) == (device_addr & mask)) name = ifa->ifa_name;
+    }
+    ::freeifaddrs(ifas);
+    if (name.empty()) throw uhd::lookup_error("umtrx: no interface for the device, set xport_iface");
+    return name;
+}
+
+umtrx_frame_pool::umtrx_frame_pool(const size_t bytes, const device_addr_t &hints, const boost::uint32_t device_addr):
+    _mem(NULL), _bytes(0)
+{
+    const size_t page_size = ::getpagesize();
+    const size_t huge_size = parse_size(hints.get("hugepage_size", ""));
+    void *mem = MAP_FAILED;
+
+    //explicit huge pages from the hugetlb pool
+    if (huge_size > page_size)
+    {
+        int huge_shift = 0;
+        while ((size_t(1) << huge_shift) < huge_size) huge_shift++;
+        _bytes = (bytes + huge_size - 1) & ~(huge_size - 1);
+        mem = ::mmap(NULL, _bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (huge_shift << MAP_HUGE_SHIFT), -1, 0);
+        if (mem == MAP_FAILED) UHD_MSG(warning) << boost::format(
+            "umtrx_frame_pool: no %u byte huge pages for %u bytes (%s), check vm.nr_hugepages\n"
+            "Falling back to transparent huge pages.") % huge_size % _bytes % strerror(errno) << std::endl;
+    }
+
+    //normal pages, still asking for transparent huge pages
+    if (mem == MAP_FAILED)
+    {
+        _bytes = (std::max<size_t>(bytes, 1) + page_size - 1) & ~(page_size - 1);
+        mem = ::mmap(NULL, _bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) throw uhd::os_error(str(boost::format("umtrx_frame_pool: mmap %u bytes: %s") % _bytes % strerror(errno)));
+        #ifdef MADV_HUGEPAGE
+        if (huge_size > page_size) ::madvise(mem, _bytes, MADV_HUGEPAGE);
+        #endif
+    }
+    _mem = reinterpret_cast<char *>(mem);
+
+    //bind before the first touch so the pages are allocated on the node
+    int node = -1;
+    const std::string numa = hints.get("numa_node", "");
+    if (numa == "auto") node = numa_node_of_iface(hints.has_key("xport_iface")? hints["xport_iface"] : find_iface(device_addr));
+    else if (not numa.empty()) node = boost::lexical_cast<int>(numa);
+    if (node >= 0)
+    {
+        unsigned long mask[4] = {0, 0, 0, 0};
+        const size_t mask_bits = sizeof(mask)*8;
+        UHD_ASSERT_THROW(size_t(node) < mask_bits);
+        mask[node/(sizeof(mask[0])*8)] |= 1UL << (node % (sizeof(mask[0])*8));
+        if (::syscall(SYS_mbind, _mem, _bytes, UMTRX_MPOL_BIND, mask, mask_bits, UMTRX_MPOL_MF_MOVE) != 0)
+        {
+            UHD_MSG(warning) << boost::format("umtrx_frame_pool: cannot bind to numa node %d: %s") % node % strerror(errno) << std::endl;
+        }
+    }
+
+    //fault the pages in now rather than on the first packets
+    std::memset(_mem, 0, _bytes);
+    if (hints.cast<int>("prefault", 0) != 0 and ::mlock(_mem, _bytes) != 0)
+    {
+        UHD_MSG(warning) << boost::format("umtrx_frame_pool: cannot lock %u bytes: %s, check ulimit -l") % _bytes % strerror(errno) << std::endl;
+    }
+
+    if (huge_size > page_size or node >= 0) UHD_MSG(status) << boost::format(
+        "umtrx_frame_pool: %u bytes, huge pages %u, numa node %d") % _bytes % huge_size % node << std::endl;
+}
+
+umtrx_frame_pool::~umtrx_frame_pool(void)
+{
+    ::munmap(_mem, _bytes);
+}
+
+#else //UHD_PLATFORM_LINUX
+
+std::string umtrx_frame_pool::find_iface(const boost::uint32_t)
+{
+    throw uhd::not_implemented_error("umtrx_frame_pool: interface lookup requires linux");
+}
+
+umtrx_frame_pool::umtrx_frame_pool(const size_t bytes, const device_addr_t &hints, const boost::uint32_t):
+    _mem(new char[bytes]()), _bytes(bytes)
+{
+    if (hints.has_key("hugepage_size") or hints.has_key("numa_node") or hints.has_key("prefault"))
+    {
+        UHD_MSG(warning) << "umtrx_frame_pool: huge pages, numa binding and locking require linux" << std::endl;
+    }
+}
+
+umtrx_frame_pool::~umtrx_frame_pool(void)
+{
+    delete [] _mem;
+}
+
+#endif //UHD_PLATFORM_LINUX
+
+umtrx_frame_pool::sptr umtrx_frame_pool::make(const size_t bytes, const device_addr_t &hints, const boost::uint32_t device_addr)
+{
+    return sptr(new umtrx_frame_pool(bytes, hints, device_addr));
+}
@@ -0,0 +1,71 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_FRAME_POOL_HPP
+#define INCLUDED_UMTRX_FRAME_POOL_HPP
+
+#include <uhd/types/device_addr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <string>
+
+/*!
+ * Frame memory of the UmTRX transports.
+ * One zeroed block carved into frames by the transport, optionally
+ * backed by huge pages and bound to the NUMA node of the NIC.
+ *
+ * Transport hints:
+ *  - hugepage_size: huge page size in bytes, k/M/G suffixes allowed,
+ *    ex: 2M or 1G (default: none). Falls back to normal pages with
+ *    transparent huge pages when the hugetlb pool is empty.
+ *  - numa_node: node to bind the frames to, or auto for the node of
+ *    the interface (xport_iface or the one facing the device)
+ *  - prefault: 1 also locks the frames in memory, within RLIMIT_MEMLOCK
+ */
+class umtrx_frame_pool : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_frame_pool> sptr;
+
+    /*!
+     * Allocate a pool.
+     * \param bytes size of the pool
+     * \param hints the transport hints
+     * \param device_addr device ipv4 address, network order, for numa_node=auto
+     */
+    static sptr make(const size_t bytes, const uhd::device_addr_t &hints, const boost::uint32_t device_addr);
+
+    ~umtrx_frame_pool(void);
+
+    //! Start of the pool memory
+    char *get(void) const
+    {
+        return _mem;
+    }
+
+    //! Find the interface whose ipv4 subnet contains the device address (network order)
+    static std::string find_iface(const boost::uint32_t device_addr);
+
+private:
+    umtrx_frame_pool(const size_t bytes, const uhd::device_addr_t &hints, const boost::uint32_t device_addr);
+
+    char *_mem;
+    size_t _bytes; //mapped size
+};
+
+#endif /* INCLUDED_UMTRX_FRAME_POOL_HPP */
@@ -0,0 +1,212 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_host_check.hpp"
+#include <uhd/config.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/foreach.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+
+static umtrx_host_check::finding_t make_finding(const std::string &item, const bool ok,
+    const std::string &detail, const std::string &remedy)
+{
+    umtrx_host_check::finding_t finding;
+    finding.item = item;
+    finding.ok = ok;
+    finding.detail = detail;
+    finding.remedy = ok? "" : remedy;
+    return finding;
+}
+
+bool umtrx_host_check::print(const std::vector<finding_t> &findings, std::ostream &out)
+{
+    bool all_ok = true;
+    BOOST_FOREACH(const finding_t &finding, findings)
+    {
+        out << boost::format("[%s] %s: %s") % (finding.ok? " ok " : "FAIL") % finding.item % finding.detail << std::endl;
+        if (not finding.remedy.empty()) out << "       fix: " << finding.remedy << std::endl;
+        all_ok = all_ok and finding.ok;
+    }
+    return all_ok;
+}
+
+#ifdef UHD_PLATFORM_LINUX
+
+#include <linux/ethtool.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//! first word of a /proc or /sys file, empty when it does not exist
+static std::string read_word(const std::string &path)
+{
+    std::ifstream file(path.c_str());
+    std::string word;
+    if (not (file >> word)) word.clear();
+    return word;
+}
+
+static long long read_number(const std::string &path)
+{
+    const std::string word = read_word(path);
+    try
+    {
+        return word.empty()? -1 : boost::lexical_cast<long long>(word);
+    }
+    catch (const boost::bad_lexical_cast &)
+    {
+        return -1;
+    }
+}
+
+//! true when the cpu is in a list like 0-3,6
+static bool cpu_in_list(const std::string &list, const int cpu)
+{
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+        int first = -1, last = -1;
+        const int num = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (num == 1) last = first;
+        if (num >= 1 and cpu >= first and cpu <= last) return true;
+    }
+    return false;
+}
+
+static void check_buff_max(std::vector<umtrx_host_check::finding_t> &findings,
+    const std::string &name, const size_t required)
+{
+    if (required == 0) return;
+    const long long max = read_number("/proc/sys/net/core/" + name);
+    if (max < 0) return;
+    findings.push_back(make_finding("net.core." + name, max >= (long long)(required),
+        str(boost::format("%d bytes, the streams ask for %u") % max % required),
+        str(boost::format("sudo sysctl -w net.core.%s=%u (and add it to /etc/sysctl.conf)") % name % required)));
+}
+
+static void check_mtu(std::vector<umtrx_host_check::finding_t> &findings,
+    const std::string &iface, const size_t frame_size)
+{
+    if (frame_size == 0) return;
+    const long long mtu = read_number("/sys/class/net/" + iface + "/mtu");
+    if (mtu < 0) return;
+    const size_t needed = frame_size + 28; //IPv4 and UDP headers
+    findings.push_back(make_finding(iface + " MTU", mtu >= (long long)(needed),
+        str(boost::format("%d, frames of %u bytes need %u") % mtu % frame_size % needed),
+        str(boost::format("sudo ip link set dev %s mtu %u") % iface % needed)));
+}
+
+static void check_ring(std::vector<umtrx_host_check::finding_t> &findings, const std::string &iface)
+{
+    const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return;
+    struct ethtool_ringparam ring;
+    std::memset(&ring, 0, sizeof(ring));
+    ring.cmd = ETHTOOL_GRINGPARAM;
+    struct ifreq ifr;
+    std::memset(&ifr, 0, sizeof(ifr));
+    std::strncpy(ifr.ifr_name, iface.c_str(), IFNAMSIZ - 1);
+    ifr.ifr_data = reinterpret_cast<char *>(&ring);
+    const int ret = ::ioctl(fd, SIOCETHTOOL, &ifr);
+    ::close(fd);
+    if (ret != 0 or ring.rx_max_pending == 0) return; //virtual interfaces have no ring
+
+    findings.push_back(make_finding(iface + " RX ring", ring.rx_pending >= ring.rx_max_pending,
+        str(boost::format("%u descriptors of %u") % ring.rx_pending % ring.rx_max_pending),
+        str(boost::format("sudo ethtool -G %s rx %u") % iface % ring.rx_max_pending)));
+}
+
+static void check_irq_affinity(std::vector<umtrx_host_check::finding_t> &findings,
+    const std::string &iface, const int stream_cpu)
+{
+    if (stream_cpu < 0) return;
+    std::ifstream interrupts("/proc/interrupts");
+    const int other_cpu = (stream_cpu == 0)? 1 : 0;
+    std::string line;
+    while (std::getline(interrupts, line))
+    {
+        //ex: " 42:  1234  0  IR-PCI-MSI 123-edge  eth0-rx-0"
+        std::stringstream ss(line);
+        std::string irq, name;
+        if (not (ss >> irq) or irq.size() < 2 or irq[irq.size()-1] != ':') continue;
+        irq.erase(irq.size()-1);
+        std::string word;
+        while (ss >> word) name = word;
+        if (name.compare(0, iface.size(), iface) != 0) continue;
+        if (name.size() > iface.size() and name[iface.size()] != '-') continue; //ex: eth1 for eth10
+
+        const std::string cpus = read_word("/proc/irq/" + irq + "/smp_affinity_list");
+        if (cpus.empty()) continue;
+        findings.push_back(make_finding("IRQ " + irq + " " + name, not cpu_in_list(cpus, stream_cpu),
+            str(boost::format("CPUs %s, the stream runs on CPU %d") % cpus % stream_cpu),
+            str(boost::format("echo %d | sudo tee /proc/irq/%s/smp_affinity_list "
+                "(and keep irqbalance off CPU %d: IRQBALANCE_BANNED_CPULIST=%d)") % other_cpu % irq % stream_cpu % stream_cpu)));
+    }
+}
+
+static void check_governor(std::vector<umtrx_host_check::finding_t> &findings, const int stream_cpu)
+{
+    const long num_cpus = ::sysconf(_SC_NPROCESSORS_CONF);
+    size_t checked = 0, slow = 0;
+    std::string example;
+    for (long cpu = 0; cpu < num_cpus; cpu++)
+    {
+        if (stream_cpu >= 0 and cpu != stream_cpu) continue;
+        const std::string governor = read_word(str(boost::format(
+            "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor") % cpu));
+        if (governor.empty()) continue; //no cpufreq, ex: a VM
+        checked++;
+        if (governor == "performance") continue;
+        if (slow++ == 0) example = str(boost::format("CPU %d is %s") % cpu % governor);
+    }
+    if (checked == 0) return;
+    findings.push_back(make_finding("CPU governor", slow == 0,
+        (slow == 0)? "performance" : str(boost::format("%s, %u of %u CPUs are not performance") % example % slow % checked),
+        "sudo cpupower frequency-set -g performance"));
+}
+
+std::vector<umtrx_host_check::finding_t> umtrx_host_check::run(const std::string &iface, const requirements_t &req)
+{
+    std::vector<finding_t> findings;
+    check_buff_max(findings, "rmem_max", req.recv_buff_size);
+    check_buff_max(findings, "wmem_max", req.send_buff_size);
+    if (not iface.empty())
+    {
+        check_mtu(findings, iface, req.frame_size);
+        check_ring(findings, iface);
+        check_irq_affinity(findings, iface, req.stream_cpu);
+    }
+    check_governor(findings, req.stream_cpu);
+    return findings;
+}
+
+#else //UHD_PLATFORM_LINUX
+
+std::vector<umtrx_host_check::finding_t> umtrx_host_check::run(const std::string &, const requirements_t &)
+{
+    return std::vector<finding_t>(1, make_finding("host check", true, "not available on this platform", ""));
+}
+
+#endif //UHD_PLATFORM_LINUX
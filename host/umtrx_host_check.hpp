@@ -0,0 +1,60 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_HOST_CHECK_HPP
+#define INCLUDED_UMTRX_HOST_CHECK_HPP
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/*!
+ * Preflight of the host settings a stream depends on:
+ * the socket buffer limits, the MTU and RX ring of the interface,
+ * the IRQ affinity of the interface against the streaming CPU
+ * and the CPU frequency governor. Linux only, the checks read
+ * /proc and /sys and never change anything.
+ */
+class umtrx_host_check
+{
+public:
+    //! What the streams need from the host
+    struct requirements_t
+    {
+        requirements_t(void): recv_buff_size(0), send_buff_size(0), frame_size(0), stream_cpu(-1){}
+        size_t recv_buff_size; //socket receive buffer bytes, 0 skips the check
+        size_t send_buff_size; //socket send buffer bytes, 0 skips the check
+        size_t frame_size; //largest UDP payload bytes, 0 skips the MTU check
+        int stream_cpu; //CPU of the streaming thread, negative when not pinned
+    };
+
+    struct finding_t
+    {
+        std::string item; //ex: net.core.rmem_max
+        bool ok;
+        std::string detail; //what was found
+        std::string remedy; //the command that fixes it, empty when ok
+    };
+
+    //! Check the host for streams over the interface
+    static std::vector<finding_t> run(const std::string &iface, const requirements_t &req);
+
+    //! Print the findings, \return true when all are ok
+    static bool print(const std::vector<finding_t> &findings, std::ostream &out);
+};
+
+#endif /* INCLUDED_UMTRX_HOST_CHECK_HPP */
@@ -0,0 +1,169 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_IF_HDR_HPP
+#define INCLUDED_UMTRX_IF_HDR_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/transport/vrt_if_packet.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <boost/cstdint.hpp>
+
+/***********************************************************************
+ * RX VRT header fast path:
+ * rx_dsp_core_200::clear() programs every RX framer for the same layout:
+ * IF data with stream id, trailer, fractional time, no class id or tsi.
+ * The header is then 4 words: hdr, sid, tsf hi, tsf lo.
+ **********************************************************************/
+static const boost::uint32_t RX_VRT_HDR_MASK = 0xfcf00000; //type, cid, tlr, tsi, tsf
+static const boost::uint32_t RX_VRT_HDR_BITS = 0
+    | (0x1 << 28) //if data with stream id
+    | (0x1 << 26) //has trailer
+    | (0x1 << 20) //fractional time sample count
+;
+static const size_t RX_VRT_HDR_WORDS32 = 4;
+
+//! the word order of the framing: data packets are big-endian, or little-endian on images with le_framing
+struct umtrx_if_hdr_be
+{
+    static UHD_INLINE boost::uint32_t to_host(const boost::uint32_t x){return uhd::ntohx(x);}
+    static UHD_INLINE boost::uint32_t to_wire(const boost::uint32_t x){return uhd::htonx(x);}
+    static UHD_INLINE void unpack(const boost::uint32_t *p, uhd::transport::vrt::if_packet_info_t &i){uhd::transport::vrt::if_hdr_unpack_be(p, i);}
+    static UHD_INLINE void pack(boost::uint32_t *p, uhd::transport::vrt::if_packet_info_t &i){uhd::transport::vrt::if_hdr_pack_be(p, i);}
+};
+
+struct umtrx_if_hdr_le
+{
+    static UHD_INLINE boost::uint32_t to_host(const boost::uint32_t x){return uhd::wtohx(x);}
+    static UHD_INLINE boost::uint32_t to_wire(const boost::uint32_t x){return uhd::htowx(x);}
+    static UHD_INLINE void unpack(const boost::uint32_t *p, uhd::transport::vrt::if_packet_info_t &i){uhd::transport::vrt::if_hdr_unpack_le(p, i);}
+    static UHD_INLINE void pack(boost::uint32_t *p, uhd::transport::vrt::if_packet_info_t &i){uhd::transport::vrt::if_hdr_pack_le(p, i);}
+};
+
+template <typename order>
+static UHD_INLINE void umtrx_if_hdr_unpack(const boost::uint32_t *packet_buff, uhd::transport::vrt::if_packet_info_t &if_packet_info)
+{
+    const boost::uint32_t vrt_hdr_word = order::to_host(packet_buff[0]);
+    const size_t packet_words32 = vrt_hdr_word & 0xffff;
+
+    //anything unexpected (or truncated) takes the generic path
+    if (
+        (vrt_hdr_word & RX_VRT_HDR_MASK) != RX_VRT_HDR_BITS or
+        packet_words32 > if_packet_info.num_packet_words32 or
+        packet_words32 < RX_VRT_HDR_WORDS32 + 1
+    ) return order::unpack(packet_buff, if_packet_info);
+
+    if_packet_info.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    if_packet_info.num_packet_words32 = packet_words32;
+    if_packet_info.packet_count = (vrt_hdr_word >> 16) & 0xf;
+    if_packet_info.sob = (vrt_hdr_word & (0x1 << 25)) != 0;
+    if_packet_info.eob = (vrt_hdr_word & (0x1 << 24)) != 0;
+    if_packet_info.has_sid = true;
+    if_packet_info.sid = order::to_host(packet_buff[1]);
+    if_packet_info.has_cid = false;
+    if_packet_info.has_tsi = false;
+    if_packet_info.has_tsf = true;
+    if_packet_info.tsf = (boost::uint64_t(order::to_host(packet_buff[2])) << 32) | order::to_host(packet_buff[3]);
+    if_packet_info.has_tlr = true;
+    if_packet_info.tlr = order::to_host(packet_buff[packet_words32 - 1]);
+    if_packet_info.num_header_words32 = RX_VRT_HDR_WORDS32;
+    if_packet_info.num_payload_words32 = packet_words32 - RX_VRT_HDR_WORDS32 - 1;
+    if_packet_info.num_payload_bytes = if_packet_info.num_payload_words32*sizeof(boost::uint32_t);
+}
+
+/***********************************************************************
+ * TX VRT header fast path:
+ * the send handler packs IF data with stream id, an optional trailer
+ * and optional fractional time, never a class id or tsi. The header is
+ * a prebuilt template with the per packet fields or'd in.
+ **********************************************************************/
+static const boost::uint32_t TX_VRT_HDR_BITS = 0
+    | (0x1 << 28) //if data with stream id
+;
+
+template <typename order>
+static UHD_INLINE void umtrx_if_hdr_pack(boost::uint32_t *packet_buff, uhd::transport::vrt::if_packet_info_t &if_packet_info)
+{
+    //anything else takes the generic path
+    if (
+        if_packet_info.packet_type != uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA or
+        not if_packet_info.has_sid or if_packet_info.has_cid or if_packet_info.has_tsi
+    ) return order::pack(packet_buff, if_packet_info);
+
+    boost::uint32_t vrt_hdr_word = TX_VRT_HDR_BITS;
+    size_t num_header_words32 = 2;
+    packet_buff[1] = order::to_wire(if_packet_info.sid);
+    if (if_packet_info.has_tsf)
+    {
+        packet_buff[2] = order::to_wire(boost::uint32_t(if_packet_info.tsf >> 32));
+        packet_buff[3] = order::to_wire(boost::uint32_t(if_packet_info.tsf >> 0));
+        num_header_words32 = 4;
+        vrt_hdr_word |= (0x1 << 20);
+    }
+    if (if_packet_info.has_tlr)
+    {
+        packet_buff[num_header_words32 + if_packet_info.num_payload_words32] = order::to_wire(if_packet_info.tlr);
+        vrt_hdr_word |= (0x1 << 26);
+    }
+
+    if_packet_info.num_header_words32 = num_header_words32;
+    if_packet_info.num_packet_words32 = num_header_words32 + if_packet_info.num_payload_words32 + (if_packet_info.has_tlr? 1 : 0);
+    vrt_hdr_word |= ((if_packet_info.packet_count & 0xf) << 16) | (if_packet_info.num_packet_words32 & 0xffff);
+    if (if_packet_info.sob) vrt_hdr_word |= (0x1 << 25);
+    if (if_packet_info.eob) vrt_hdr_word |= (0x1 << 24);
+    packet_buff[0] = order::to_wire(vrt_hdr_word);
+}
+
+//! plain functions for the streamers
+static UHD_INLINE void umtrx_if_hdr_unpack_be(const boost::uint32_t *packet_buff, uhd::transport::vrt::if_packet_info_t &if_packet_info)
+{
+    umtrx_if_hdr_unpack<umtrx_if_hdr_be>(packet_buff, if_packet_info);
+}
+
+static UHD_INLINE void umtrx_if_hdr_unpack_le(const boost::uint32_t *packet_buff, uhd::transport::vrt::if_packet_info_t &if_packet_info)
+{
+    umtrx_if_hdr_unpack<umtrx_if_hdr_le>(packet_buff, if_packet_info);
+}
+
+static UHD_INLINE void umtrx_if_hdr_pack_be(boost::uint32_t *packet_buff, uhd::transport::vrt::if_packet_info_t &if_packet_info)
+{
+    umtrx_if_hdr_pack<umtrx_if_hdr_be>(packet_buff, if_packet_info);
+}
+
+static UHD_INLINE void umtrx_if_hdr_pack_le(boost::uint32_t *packet_buff, uhd::transport::vrt::if_packet_info_t &if_packet_info)
+{
+    umtrx_if_hdr_pack<umtrx_if_hdr_le>(packet_buff, if_packet_info);
+}
+
+/***********************************************************************
+ * TX send batching, used by the batching transports:
+ * only data packets in the middle of a burst are held back.
+ * UmTRX TX frames carry one pad word before the VRT header,
+ * anything else (stream ctrl, EOB, context) goes out right away.
+ **********************************************************************/
+static const size_t TX_VRT_HDR_OFFSET_WORDS32 = 1;
+
+static UHD_INLINE bool umtrx_tx_is_coalescable(const void *mem, const size_t len)
+{
+    if (len < (TX_VRT_HDR_OFFSET_WORDS32 + 1)*sizeof(boost::uint32_t)) return false;
+    const boost::uint32_t vrt_hdr_word = uhd::ntohx(reinterpret_cast<const boost::uint32_t *>(mem)[TX_VRT_HDR_OFFSET_WORDS32]);
+    const bool is_data_with_sid = ((vrt_hdr_word >> 28) & 0xf) == 0x1;
+    const bool is_eob = (vrt_hdr_word & (0x1 << 24)) != 0;
+    return is_data_with_sid and not is_eob;
+}
+
+#endif /* INCLUDED_UMTRX_IF_HDR_HPP */
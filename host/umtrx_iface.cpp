@@ -19,6 +19,7 @@
 #include "usrp2/fw_common.h"
 #include "umtrx_impl.hpp"
 #include "umtrx_iface.hpp"
+#include "umtrx_trace.hpp"
 #include <uhd/exception.hpp>
 #include "umtrx_log_adapter.hpp"
 #include "missing/platform.hpp"
@@ -26,6 +27,7 @@
 #include <uhd/utils/safe_call.hpp>
 #include <uhd/types/dict.hpp>
 #include <boost/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/foreach.hpp>
 #include <boost/asio.hpp> //used for htonl and ntohl
 #include <boost/assign/list_of.hpp>
@@ -34,6 +36,10 @@
 #include <boost/tokenizer.hpp>
 #include <boost/functional/hash.hpp>
 #include <algorithm>
+#include <cmath>
+#include <map>
+#include <cstring>
+#include <cstddef>
 #include <iostream>
 #undef NDEBUG //evil hack for debug
 #include <cassert>
@@ -42,8 +48,15 @@ using namespace uhd;
 using namespace uhd::usrp;
 using namespace uhd::transport;
 
-static const double CTRL_RECV_TIMEOUT = 1.0;
-static const size_t CTRL_RECV_RETRIES = 3;
+static const double CTRL_RECV_TIMEOUT = 1.0; //for a request over all its retransmissions
+//retransmission timeout: the first one until there is a round trip time, the bounds after
+static const double CTRL_INITIAL_RTO = 0.1;
+static const double CTRL_MIN_RTO = 0.005;
+static const double CTRL_MAX_RTO = 0.25;
+//requests sent before the first reply came back, the firmware handles them in order
+static const size_t CTRL_MAX_IN_FLIGHT = 4;
+//how often the recv task checks for shutdown
+static const double CTRL_RECV_POLL = 0.1;
 
 //custom timeout error for retry logic to catch/retry
 struct timeout_error : uhd::runtime_error
@@ -61,6 +74,14 @@ static const boost::uint32_t MIN_PROTO_COMPAT_I2C = 7;
 // and the compatibility of the register mapping (more likely to change).
 static const boost::uint32_t MIN_PROTO_COMPAT_REG = 10;
 
+//! The first four bytes of an I2C transfer for the trace, the first one on top
+static boost::uint32_t trace_i2c_bytes(const byte_vector_t &buf)
+{
+    boost::uint32_t word = 0;
+    for (size_t i = 0; i < 4; i++) word = (word << 8) | ((i < buf.size())? buf[i] : 0);
+    return word;
+}
+
 class umtrx_iface_impl : public umtrx_iface{
 public:
 /***********************************************************************
@@ -69,8 +90,13 @@ public:
     umtrx_iface_impl(udp_simple::sptr ctrl_transport):
         _ctrl_transport(ctrl_transport),
         _ctrl_seq_num(0),
-        _protocol_compat(USRP2_FW_COMPAT_NUM)
+        _srtt(0.0),
+        _rttvar(0.0),
+        _protocol_compat(USRP2_FW_COMPAT_NUM),
+        _batch_supported(true)
     {
+        _recv_task = task::make(boost::bind(&umtrx_iface_impl::recv_task, this));
+
         //Obtain the firmware's compat number.
         usrp2_ctrl_data_t ctrl_data;
         ctrl_data.id = htonl(UMTRX_CTRL_ID_REQUEST);
@@ -81,8 +107,11 @@ public:
         //Save the response compat number for future communication.
         _protocol_compat = ntohl(ctrl_data.proto_ver);
 
-        // Read EEPROM with UMTRX extensions
+        // Read EEPROM with UMTRX extensions, the fields come from one image read
+        // when the firmware has it, later reads and writes go to the device
+        this->load_eeprom_image();
         load_umtrx_eeprom(mb_eeprom, *this);
+        _eeprom_image.clear();
     }
 
     ~umtrx_iface_impl(void){UHD_SAFE_CALL(
@@ -105,18 +134,25 @@ public:
     }
 
     bool is_device_locked(void){
+        umtrx_ctrl_batch batch;
+        const size_t compat_i = batch.peek32(U2_REG_COMPAT_NUM_RB);
+        const size_t time_i = batch.peekfw(U2_FW_REG_LOCK_TIME);
+        const size_t gpid_i = batch.peekfw(U2_FW_REG_LOCK_GPID);
+        const size_t curr_i = batch.peek32(U2_REG_TIME64_LO_RB_IMM);
+        this->transact_batch(batch);
+
         //never assume lock with fpga image mismatch
-        if ((this->peek32(U2_REG_COMPAT_NUM_RB) >> 16) != USRP2_FPGA_COMPAT_NUM) return false;
+        if ((batch.get(compat_i) >> 16) != USRP2_FPGA_COMPAT_NUM) return false;
 
-        boost::uint32_t lock_time = this->peekfw(U2_FW_REG_LOCK_TIME);
-        boost::uint32_t lock_gpid = this->peekfw(U2_FW_REG_LOCK_GPID);
+        boost::uint32_t lock_time = batch.get(time_i);
+        boost::uint32_t lock_gpid = batch.get(gpid_i);
 
         //may not be the right tick rate, but this is ok for locking purposes
         const boost::uint32_t lock_timeout_time = boost::uint32_t(3*100e6);
 
         //if the difference is larger, assume not locked anymore
         if ((lock_time & 1) == 0) return false; //bit0 says unlocked
-        const boost::uint32_t time_diff = this->get_curr_time() - lock_time;
+        const boost::uint32_t time_diff = (batch.get(curr_i) | 1) - lock_time;
         if (time_diff >= lock_timeout_time) return false;
 
         //otherwise only lock if the device hash is different that ours
@@ -138,11 +174,15 @@ public:
  * Peek and Poke
  **********************************************************************/
     void poke32(wb_addr_type addr, boost::uint32_t data){
+        umtrx_trace_scope trace(UMTRX_TRACE_WB_UDP, UMTRX_TRACE_WRITE, 0, addr, data);
         this->get_reg<boost::uint32_t, USRP2_REG_ACTION_FPGA_POKE32>(addr, data);
     }
 
     boost::uint32_t peek32(wb_addr_type addr){
-        return this->get_reg<boost::uint32_t, USRP2_REG_ACTION_FPGA_PEEK32>(addr);
+        umtrx_trace_scope trace(UMTRX_TRACE_WB_UDP, UMTRX_TRACE_READ, 0, addr);
+        const boost::uint32_t data = this->get_reg<boost::uint32_t, USRP2_REG_ACTION_FPGA_PEEK32>(addr);
+        trace.set_data(data);
+        return data;
     }
 
     void poke16(wb_addr_type addr, boost::uint16_t data){
@@ -188,6 +228,7 @@ public:
         size_t num_bits,
         bool readback
     ){
+        umtrx_trace_scope trace(UMTRX_TRACE_SPI, readback? UMTRX_TRACE_READ : UMTRX_TRACE_WRITE, which_slave, num_bits, data);
         static const uhd::dict<spi_config_t::edge_t, int> spi_edge_to_otw = boost::assign::map_list_of
             (spi_config_t::EDGE_RISE, USRP2_CLK_EDGE_RISE)
             (spi_config_t::EDGE_FALL, USRP2_CLK_EDGE_FALL)
@@ -207,6 +248,7 @@ public:
         usrp2_ctrl_data_t in_data = this->ctrl_send_and_recv(out_data, MIN_PROTO_COMPAT_SPI);
         UHD_ASSERT_THROW(ntohl(in_data.id) == USRP2_CTRL_ID_OMG_TRANSACTED_SPI_DUDE);
 
+        if (readback) trace.set_data(ntohl(in_data.data.spi_args.data));
         return ntohl(in_data.data.spi_args.data);
     }
 
@@ -214,6 +256,7 @@ public:
  * I2C
  **********************************************************************/
     void write_i2c(boost::uint16_t addr, const byte_vector_t &buf){
+        umtrx_trace_scope trace(UMTRX_TRACE_I2C, UMTRX_TRACE_WRITE, addr, buf.size(), trace_i2c_bytes(buf));
         //setup the out data
         usrp2_ctrl_data_t out_data = usrp2_ctrl_data_t();
         out_data.id = htonl(USRP2_CTRL_ID_WRITE_THESE_I2C_VALUES_BRO);
@@ -232,6 +275,7 @@ public:
     }
 
     byte_vector_t read_i2c(boost::uint16_t addr, size_t num_bytes){
+        umtrx_trace_scope trace(UMTRX_TRACE_I2C, UMTRX_TRACE_READ, addr, num_bytes);
         //setup the out data
         usrp2_ctrl_data_t out_data = usrp2_ctrl_data_t();
         out_data.id = htonl(USRP2_CTRL_ID_DO_AN_I2C_READ_FOR_ME_BRO);
@@ -249,6 +293,7 @@ public:
         //copy out the data
         byte_vector_t result(num_bytes);
         std::copy(in_data.data.i2c_args.data, in_data.data.i2c_args.data + num_bytes, result.begin());
+        trace.set_data(trace_i2c_bytes(result));
         return result;
     }
 
@@ -271,62 +316,281 @@ public:
         return ntohl(in_data.data.zpu_action.data);
     }
 
+/***********************************************************************
+ * Sensor snapshot
+ **********************************************************************/
+    bool read_sensors_snapshot(uint16_t &mask, uint16_t pwr_config, uint16_t dc_config, uint16_t *values)
+    {
+        //setup the out data
+        usrp2_ctrl_data_t out_data = usrp2_ctrl_data_t();
+        out_data.id = htonl(UMTRX_CTRL_ID_SENSORS_REQUEST);
+        out_data.data.sensors_args.mask = htons(mask);
+        out_data.data.sensors_args.values[0] = htons(pwr_config);
+        out_data.data.sensors_args.values[1] = htons(dc_config);
+
+        //send and recv, older firmware answers with huh what
+        usrp2_ctrl_data_t in_data = this->ctrl_send_and_recv(out_data, MIN_PROTO_COMPAT_I2C);
+        if (ntohl(in_data.id) != UMTRX_CTRL_ID_SENSORS_RESPONSE) return false;
+
+        mask = ntohs(in_data.data.sensors_args.mask);
+        for (size_t i = 0; i < UMTRX_SENSORS_NUM; i++){
+            values[i] = ntohs(in_data.data.sensors_args.values[i]);
+        }
+        return true;
+    }
+
+/***********************************************************************
+ * Batched operations
+ **********************************************************************/
+    void transact_batch(umtrx_ctrl_batch &batch)
+    {
+        for (size_t first = 0; first < batch.ops.size(); first += UMTRX_CTRL_BATCH_MAX_OPS)
+        {
+            const size_t num_ops = std::min<size_t>(UMTRX_CTRL_BATCH_MAX_OPS, batch.ops.size() - first);
+            if (_batch_supported and this->transact_batch_packet(&batch.ops[first], num_ops)) continue;
+            _batch_supported = false;
+            for (size_t i = 0; i < num_ops; i++) this->transact_batch_op(batch.ops[first + i]);
+        }
+    }
+
+    bool transact_batch_packet(umtrx_ctrl_batch::op_t *ops, const size_t num_ops)
+    {
+        umtrx_ctrl_batch_t out_data = umtrx_ctrl_batch_t();
+        out_data.id = htonl(UMTRX_CTRL_ID_BATCH_REQUEST);
+        out_data.num_ops = htonl(num_ops);
+        for (size_t i = 0; i < num_ops; i++)
+        {
+            out_data.ops[i].type = ops[i].type;
+            out_data.ops[i].flags = ops[i].flags;
+            out_data.ops[i].len = ops[i].len;
+            out_data.ops[i].addr = htonl(ops[i].addr);
+            out_data.ops[i].data = htonl(ops[i].data);
+        }
+
+        //send and recv, older firmware answers with huh what
+        const umtrx_ctrl_batch_t in_data = this->ctrl_send_and_recv(out_data, MIN_PROTO_COMPAT_REG, USRP2_FW_COMPAT_NUM,
+            offsetof(umtrx_ctrl_batch_t, ops) + num_ops*sizeof(umtrx_batch_op_t));
+        if (ntohl(in_data.id) != UMTRX_CTRL_ID_BATCH_RESPONSE) return false;
+        UHD_ASSERT_THROW(ntohl(in_data.num_ops) == num_ops);
+
+        for (size_t i = 0; i < num_ops; i++)
+        {
+            ops[i].data = ntohl(in_data.ops[i].data);
+            ops[i].failed = in_data.ops[i].status != 0;
+        }
+        return true;
+    }
+
+    //one op through the single requests, for firmware without batches
+    void transact_batch_op(umtrx_ctrl_batch::op_t &op)
+    {
+        op.failed = false;
+        switch (op.type)
+        {
+        case UMTRX_BATCH_OP_POKE32: this->poke32(op.addr, op.data); break;
+        case UMTRX_BATCH_OP_PEEK32: op.data = this->peek32(op.addr); break;
+        case UMTRX_BATCH_OP_FW_POKE32: this->pokefw(op.addr, op.data); break;
+        case UMTRX_BATCH_OP_FW_PEEK32: op.data = this->peekfw(op.addr); break;
+        case UMTRX_BATCH_OP_SPI:{
+            spi_config_t config;
+            config.mosi_edge = (op.flags & UMTRX_BATCH_SPI_MOSI_RISE)? spi_config_t::EDGE_RISE : spi_config_t::EDGE_FALL;
+            config.miso_edge = (op.flags & UMTRX_BATCH_SPI_MISO_RISE)? spi_config_t::EDGE_RISE : spi_config_t::EDGE_FALL;
+            op.data = this->transact_spi(op.addr, config, op.data, op.len, (op.flags & UMTRX_BATCH_SPI_READBACK) != 0);
+        } break;
+        case UMTRX_BATCH_OP_I2C_WRITE:{
+            byte_vector_t buf(op.len);
+            for (size_t i = 0; i < buf.size(); i++) buf[i] = boost::uint8_t(op.data >> (24 - 8*i));
+            this->write_i2c(op.addr, buf);
+        } break;
+        case UMTRX_BATCH_OP_I2C_READ:{
+            const byte_vector_t buf = this->read_i2c(op.addr, op.len);
+            op.data = 0;
+            for (size_t i = 0; i < buf.size(); i++) op.data |= boost::uint32_t(buf[i]) << (24 - 8*i);
+        } break;
+        default: op.failed = true;
+        }
+    }
+
+/***********************************************************************
+ * EEPROM
+ **********************************************************************/
+    void load_eeprom_image(void)
+    {
+        umtrx_ctrl_eeprom_t out_data = umtrx_ctrl_eeprom_t();
+        out_data.id = htonl(UMTRX_CTRL_ID_EEPROM_REQUEST);
+        out_data.addr = USRP2_I2C_ADDR_MBOARD;
+        out_data.offset = htons(0);
+        out_data.len = htons(UMTRX_CTRL_EEPROM_MAX_BYTES);
+
+        //send and recv, older firmware answers with huh what
+        const umtrx_ctrl_eeprom_t in_data = this->ctrl_send_and_recv(out_data, MIN_PROTO_COMPAT_I2C, USRP2_FW_COMPAT_NUM,
+            offsetof(umtrx_ctrl_eeprom_t, data));
+        if (ntohl(in_data.id) != UMTRX_CTRL_ID_EEPROM_RESPONSE or in_data.ok == 0) return;
+        const size_t len = std::min<size_t>(ntohs(in_data.len), UMTRX_CTRL_EEPROM_MAX_BYTES);
+        _eeprom_image.assign(in_data.data, in_data.data + len);
+    }
+
+    //from the image while it is loaded, else the address write and all the
+    //current address reads in one round trip
+    byte_vector_t read_eeprom(boost::uint16_t addr, boost::uint16_t offset, size_t num_bytes)
+    {
+        if (addr == USRP2_I2C_ADDR_MBOARD and offset + num_bytes <= _eeprom_image.size())
+        {
+            return byte_vector_t(_eeprom_image.begin() + offset, _eeprom_image.begin() + offset + num_bytes);
+        }
+        if (not _batch_supported) return i2c_iface::read_eeprom(addr, offset, num_bytes);
+
+        umtrx_ctrl_batch batch;
+        batch.write_i2c(addr, byte_vector_t(1, boost::uint8_t(offset)));
+        for (size_t i = 0; i < num_bytes; i += 4) batch.read_i2c(addr, std::min<size_t>(4, num_bytes - i));
+        this->transact_batch(batch);
+
+        byte_vector_t result;
+        for (size_t i = 1; i < batch.size(); i++)
+        {
+            const byte_vector_t bytes = batch.get_bytes(i);
+            result.insert(result.end(), bytes.begin(), bytes.end());
+        }
+        return result;
+    }
+
 /***********************************************************************
  * Send/Recv over control
  **********************************************************************/
-    usrp2_ctrl_data_t ctrl_send_and_recv(
-        const usrp2_ctrl_data_t &out_data,
+    template <typename packet_t>
+    packet_t ctrl_send_and_recv(
+        const packet_t &out_data,
         boost::uint32_t lo = USRP2_FW_COMPAT_NUM,
-        boost::uint32_t hi = USRP2_FW_COMPAT_NUM
+        boost::uint32_t hi = USRP2_FW_COMPAT_NUM,
+        const size_t out_len = sizeof(packet_t)
     ){
-        boost::mutex::scoped_lock lock(_ctrl_mutex);
-
-        for (size_t i = 0; i < CTRL_RECV_RETRIES; i++){
-            try{
-                return ctrl_send_and_recv_internal(out_data, lo, hi, CTRL_RECV_TIMEOUT/CTRL_RECV_RETRIES);
-            }
-            catch(const timeout_error &e){
-                UHD_MSG(error)
-                    << "Control packet attempt " << i
-                    << ", sequence number " << _ctrl_seq_num
-                    << ":\n" << e.what() << std::endl;
-            }
+        try{
+            return ctrl_send_and_recv_internal(out_data, lo, hi, CTRL_RECV_TIMEOUT, out_len);
+        }
+        catch(const timeout_error &e){
+            UHD_MSG(error) << e.what() << std::endl;
         }
         throw uhd::runtime_error("link dead: timeout waiting for control packet ACK");
     }
 
-    usrp2_ctrl_data_t ctrl_send_and_recv_internal(
-        const usrp2_ctrl_data_t &out_data,
+    //! A request in flight, completed by the recv task when the reply with its seq arrives
+    struct ctrl_pending_t{
+        ctrl_pending_t(void): len(0), done(false){}
+        boost::uint8_t mem[udp_simple::mtu];
+        size_t len;
+        bool done;
+    };
+
+    //packet_t starts like usrp2_ctrl_data_t, sent with out_len bytes but never less than that
+    template <typename packet_t>
+    packet_t ctrl_send_and_recv_internal(
+        const packet_t &out_data,
         boost::uint32_t lo, boost::uint32_t hi,
-        const double timeout
+        const double timeout, const size_t out_len
     ){
-        //fill in the seq number and send
-        usrp2_ctrl_data_t out_copy = out_data;
+        //take a slot and a seq number, several callers may be in flight at once
+        ctrl_pending_t pending;
+        packet_t out_copy = out_data;
         out_copy.proto_ver = htonl(_protocol_compat);
-        out_copy.seq = htonl(++_ctrl_seq_num);
-        _ctrl_transport->send(boost::asio::buffer(&out_copy, sizeof(usrp2_ctrl_data_t)));
-
-        //loop until we get the packet or timeout
-        boost::uint8_t usrp2_ctrl_data_in_mem[udp_simple::mtu]; //allocate max bytes for recv
-        const usrp2_ctrl_data_t *ctrl_data_in = reinterpret_cast<const usrp2_ctrl_data_t *>(usrp2_ctrl_data_in_mem);
-        while(true){
-            size_t len = _ctrl_transport->recv(boost::asio::buffer(usrp2_ctrl_data_in_mem), timeout);
-            boost::uint32_t compat = ntohl(ctrl_data_in->proto_ver);
-            if(len >= sizeof(boost::uint32_t) and (hi < compat or lo > compat)){
-                throw uhd::runtime_error(str(boost::format(
-                    "\nPlease update the firmware and FPGA images for your device.\n"
-                    "See the application notes for UmTRX for instructions.\n"
-                    "Expected protocol compatibility number %s, but got %d:\n"
-                    "The firmware build is not compatible with the host code build."
-                ) % ((lo == hi)? (boost::format("%d") % hi) : (boost::format("[%d to %d]") % lo % hi)) % compat));
+        const boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds(long(timeout*1e6));
+        {
+            boost::mutex::scoped_lock lock(_pending_mutex);
+            while (_pending.size() >= CTRL_MAX_IN_FLIGHT){
+                if (not _pending_cond.timed_wait(lock, deadline)) throw timeout_error("no free control slot");
             }
-            if (len >= sizeof(usrp2_ctrl_data_t) and ntohl(ctrl_data_in->seq) == _ctrl_seq_num){
-                return *ctrl_data_in;
+            out_copy.seq = htonl(++_ctrl_seq_num);
+            _pending[_ctrl_seq_num] = &pending;
+        }
+
+        //send and wait for the recv task to hand over the reply, sending the
+        //same seq again after each retransmission timeout: a late reply to any
+        //copy completes the request, the firmware answers a repeat from its reply cache.
+        //the slot must be released even when interrupted
+        size_t attempts = 0;
+        double rtt = 0.0;
+        try{
+            double rto = this->get_rto();
+            const boost::posix_time::ptime start = boost::get_system_time();
+            boost::mutex::scoped_lock lock(_pending_mutex, boost::defer_lock);
+            for (;;){
+                {
+                    boost::mutex::scoped_lock send_lock(_send_mutex);
+                    _ctrl_transport->send(boost::asio::buffer(&out_copy, std::max(out_len, sizeof(usrp2_ctrl_data_t))));
+                }
+                attempts++;
+                const boost::system_time resend = std::min(deadline,
+                    boost::get_system_time() + boost::posix_time::microseconds(long(rto*1e6)));
+                lock.lock();
+                while (not pending.done and _pending_cond.timed_wait(lock, resend)){}
+                if (pending.done or boost::get_system_time() >= deadline) break;
+                lock.unlock();
+                rto = std::min(2*rto, CTRL_MAX_RTO);
             }
-            if (len == 0) break; //timeout
-            //didnt get seq or bad packet, continue looking...
+            //Karn: a retransmitted request does not tell which copy was answered
+            if (pending.done and attempts == 1) rtt = 1e-6*(boost::get_system_time() - start).total_microseconds();
+        }
+        catch(...){
+            this->release_pending(ntohl(out_copy.seq));
+            throw;
+        }
+        this->release_pending(ntohl(out_copy.seq));
+        if (rtt > 0.0) this->add_rtt_sample(rtt);
+        if (not pending.done) throw timeout_error(str(boost::format(
+            "no control response to sequence number %u after %u attempts, possible packet loss") % ntohl(out_copy.seq) % attempts));
+
+        const usrp2_ctrl_data_t *ctrl_data_in = reinterpret_cast<const usrp2_ctrl_data_t *>(pending.mem);
+        boost::uint32_t compat = ntohl(ctrl_data_in->proto_ver);
+        if(hi < compat or lo > compat){
+            throw uhd::runtime_error(str(boost::format(
+                "\nPlease update the firmware and FPGA images for your device.\n"
+                "See the application notes for UmTRX for instructions.\n"
+                "Expected protocol compatibility number %s, but got %d:\n"
+                "The firmware build is not compatible with the host code build."
+            ) % ((lo == hi)? (boost::format("%d") % hi) : (boost::format("[%d to %d]") % lo % hi)) % compat));
+        }
+        packet_t in_data = packet_t();
+        std::memcpy(&in_data, pending.mem, std::min(pending.len, sizeof(packet_t)));
+        return in_data;
+    }
+
+    //! Retransmission timeout from the smoothed round trip time, as TCP does (RFC 6298)
+    double get_rto(void){
+        boost::mutex::scoped_lock lock(_pending_mutex);
+        if (_srtt == 0.0) return CTRL_INITIAL_RTO;
+        return std::min(CTRL_MAX_RTO, std::max(CTRL_MIN_RTO, _srtt + 4*_rttvar));
+    }
+
+    void add_rtt_sample(const double rtt){
+        boost::mutex::scoped_lock lock(_pending_mutex);
+        if (_srtt == 0.0){
+            _srtt = rtt;
+            _rttvar = rtt/2;
+            return;
         }
-        throw timeout_error("no control response, possible packet loss");
+        _rttvar = 0.75*_rttvar + 0.25*std::abs(_srtt - rtt);
+        _srtt = 0.875*_srtt + 0.125*rtt;
+    }
+
+    void release_pending(const boost::uint32_t seq){
+        boost::mutex::scoped_lock lock(_pending_mutex);
+        _pending.erase(seq);
+        _pending_cond.notify_all(); //a slot is free
+    }
+
+    //! Complete the request a reply belongs to, a reply without a waiter is stale
+    void recv_task(void){
+        ctrl_pending_t reply;
+        reply.len = _ctrl_transport->recv(boost::asio::buffer(reply.mem), CTRL_RECV_POLL);
+        if (reply.len < sizeof(usrp2_ctrl_data_t)) return; //timeout or bad packet
+        const boost::uint32_t seq = ntohl(reinterpret_cast<const usrp2_ctrl_data_t *>(reply.mem)->seq);
+
+        boost::mutex::scoped_lock lock(_pending_mutex);
+        std::map<boost::uint32_t, ctrl_pending_t *>::iterator it = _pending.find(seq);
+        if (it == _pending.end() or it->second->done) return;
+        std::memcpy(it->second->mem, reply.mem, reply.len);
+        it->second->len = reply.len;
+        it->second->done = true;
+        _pending_cond.notify_all();
     }
 
     rev_type get_rev(void){
@@ -357,14 +621,103 @@ private:
     udp_simple::sptr _ctrl_transport;
 
     //used in send/recv
-    boost::mutex _ctrl_mutex;
+    boost::mutex _send_mutex;
+    boost::mutex _pending_mutex; //guards the seq number and the requests in flight
+    boost::condition_variable _pending_cond;
+    std::map<boost::uint32_t, ctrl_pending_t *> _pending;
     boost::uint32_t _ctrl_seq_num;
+    double _srtt, _rttvar; //round trip time of the requests answered at the first attempt, 0 before any
     boost::uint32_t _protocol_compat;
+    bool _batch_supported; //cleared when the firmware does not know batches
+    byte_vector_t _eeprom_image; //mboard EEPROM, only while the fields are parsed at open
 
     //lock thread stuff
     task::sptr _lock_task;
+
+    //completes the requests in flight, declared last so it stops first
+    task::sptr _recv_task;
 };
 
+/***********************************************************************
+ * Batch builder
+ **********************************************************************/
+size_t umtrx_ctrl_batch::add(const int type, const boost::uint32_t addr, const boost::uint32_t data,
+    const boost::uint8_t flags, const boost::uint8_t len)
+{
+    op_t op;
+    op.type = type;
+    op.flags = flags;
+    op.len = len;
+    op.failed = false;
+    op.addr = addr;
+    op.data = data;
+    ops.push_back(op);
+    return ops.size() - 1;
+}
+
+size_t umtrx_ctrl_batch::poke32(const boost::uint32_t addr, const boost::uint32_t data)
+{
+    return this->add(UMTRX_BATCH_OP_POKE32, addr, data);
+}
+
+size_t umtrx_ctrl_batch::peek32(const boost::uint32_t addr)
+{
+    return this->add(UMTRX_BATCH_OP_PEEK32, addr, 0);
+}
+
+size_t umtrx_ctrl_batch::pokefw(const boost::uint32_t addr, const boost::uint32_t data)
+{
+    return this->add(UMTRX_BATCH_OP_FW_POKE32, addr, data);
+}
+
+size_t umtrx_ctrl_batch::peekfw(const boost::uint32_t addr)
+{
+    return this->add(UMTRX_BATCH_OP_FW_PEEK32, addr, 0);
+}
+
+size_t umtrx_ctrl_batch::transact_spi(const int which_slave, const spi_config_t &config,
+    const boost::uint32_t data, const size_t num_bits, const bool readback)
+{
+    UHD_ASSERT_THROW(num_bits <= 32);
+    const boost::uint8_t flags = 0
+        | ((readback)? UMTRX_BATCH_SPI_READBACK : 0)
+        | ((config.mosi_edge == spi_config_t::EDGE_RISE)? UMTRX_BATCH_SPI_MOSI_RISE : 0)
+        | ((config.miso_edge == spi_config_t::EDGE_RISE)? UMTRX_BATCH_SPI_MISO_RISE : 0);
+    return this->add(UMTRX_BATCH_OP_SPI, which_slave, data, flags, num_bits);
+}
+
+size_t umtrx_ctrl_batch::write_i2c(const boost::uint16_t addr, const byte_vector_t &buf)
+{
+    UHD_ASSERT_THROW(buf.size() <= sizeof(boost::uint32_t));
+    boost::uint32_t data = 0;
+    for (size_t i = 0; i < buf.size(); i++) data |= boost::uint32_t(buf[i]) << (24 - 8*i);
+    return this->add(UMTRX_BATCH_OP_I2C_WRITE, addr, data, 0, buf.size());
+}
+
+size_t umtrx_ctrl_batch::read_i2c(const boost::uint16_t addr, const size_t num_bytes)
+{
+    UHD_ASSERT_THROW(num_bytes <= sizeof(boost::uint32_t));
+    return this->add(UMTRX_BATCH_OP_I2C_READ, addr, 0, 0, num_bytes);
+}
+
+boost::uint32_t umtrx_ctrl_batch::get(const size_t index) const
+{
+    return ops.at(index).data;
+}
+
+byte_vector_t umtrx_ctrl_batch::get_bytes(const size_t index) const
+{
+    const op_t &op = ops.at(index);
+    byte_vector_t bytes(op.len);
+    for (size_t i = 0; i < bytes.size(); i++) bytes[i] = boost::uint8_t(op.data >> (24 - 8*i));
+    return bytes;
+}
+
+bool umtrx_ctrl_batch::failed(const size_t index) const
+{
+    return ops.at(index).failed;
+}
+
 /***********************************************************************
  * Public make function for usrp2 interface
  **********************************************************************/
@@ -26,9 +26,53 @@
 #include <boost/utility.hpp>
 #include <boost/function.hpp>
 #include <string>
+#include <vector>
 
 #include "umtrx_common.hpp"
 
+/*!
+ * A list of control operations run by the firmware in one round trip,
+ * see umtrx_iface::transact_batch(). Each add call returns the index of
+ * the operation, its result can be read back after the batch ran.
+ */
+class umtrx_ctrl_batch
+{
+public:
+    size_t poke32(const boost::uint32_t addr, const boost::uint32_t data);
+    size_t peek32(const boost::uint32_t addr);
+    size_t pokefw(const boost::uint32_t addr, const boost::uint32_t data);
+    size_t peekfw(const boost::uint32_t addr);
+    size_t transact_spi(const int which_slave, const uhd::spi_config_t &config,
+        const boost::uint32_t data, const size_t num_bits, const bool readback);
+    //! I2C transfers carry at most 4 bytes each
+    size_t write_i2c(const boost::uint16_t addr, const uhd::byte_vector_t &buf);
+    size_t read_i2c(const boost::uint16_t addr, const size_t num_bytes);
+
+    //! The read data of an operation
+    boost::uint32_t get(const size_t index) const;
+    //! The bytes of an I2C read
+    uhd::byte_vector_t get_bytes(const size_t index) const;
+    //! True when the firmware could not run the operation
+    bool failed(const size_t index) const;
+
+    size_t size(void) const {return ops.size();}
+    void clear(void) {ops.clear();}
+
+    struct op_t
+    {
+        int type; //UMTRX_BATCH_OP_*
+        boost::uint8_t flags, len;
+        bool failed;
+        boost::uint32_t addr;
+        boost::uint32_t data; //I2C bytes are packed from the high byte down
+    };
+    std::vector<op_t> ops;
+
+private:
+    size_t add(const int type, const boost::uint32_t addr, const boost::uint32_t data,
+        const boost::uint8_t flags = 0, const boost::uint8_t len = 0);
+};
+
 /*!
  * The umtrx interface class:
  * Provides a set of functions to implementation layer.
@@ -65,9 +109,32 @@ public:
     //! A version string for firmware
     virtual const std::string get_fw_version_string(void) = 0;
 
+    //! Poke a firmware register
+    virtual void pokefw(wb_addr_type addr, boost::uint32_t data) = 0;
+
+    //! Peek a firmware register
+    virtual boost::uint32_t peekfw(wb_addr_type addr) = 0;
+
     //! A hack: Perform an action on the ZPU
     virtual uint32_t send_zpu_action(uint32_t action, uint32_t data) = 0;
 
+    /*!
+     * Sample the board sensors in a single firmware request.
+     * \param mask in: sensors to sample (UMTRX_SENSORS_* bits), out: sensors sampled
+     * \param pwr_config PA sense ADC config register
+     * \param dc_config DC sense ADC config register
+     * \param values raw sensor registers, UMTRX_SENSORS_NUM entries
+     * \return false if the firmware does not know the request
+     */
+    virtual bool read_sensors_snapshot(uint16_t &mask, uint16_t pwr_config, uint16_t dc_config, uint16_t *values) = 0;
+
+    /*!
+     * Run a list of operations, one round trip per UMTRX_CTRL_BATCH_MAX_OPS.
+     * Firmware without the batch request gets them one by one instead.
+     * \param batch the operations, their results are filled in
+     */
+    virtual void transact_batch(umtrx_ctrl_batch &batch) = 0;
+
     //motherboard eeprom map structure
     uhd::usrp::mboard_eeprom_t mb_eeprom;
 };
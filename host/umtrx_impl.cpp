@@ -19,13 +19,25 @@
 #include "umtrx_regs.hpp"
 #include "umtrx_version.hpp"
 #include "umtrx_log_adapter.hpp"
+#include "umtrx_fast_ctrl.hpp"
+#include "umtrx_trace.hpp"
+#include "umtrx_async_log.hpp"
 #include "cores/apply_corrections.hpp"
 #include <uhd/utils/log.hpp>
+#include <uhd/utils/paths.hpp>
 #include <boost/bind/bind.hpp>
 #include <boost/thread.hpp> //sleep
+#include <boost/chrono.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/function.hpp>
 #include <boost/assign/list_of.hpp>
 #include <boost/utility.hpp>
+#include <boost/weak_ptr.hpp>
 #include <boost/foreach.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <cmath>
+#include <limits>
 
 static int verbosity = 0;
 
@@ -203,23 +215,167 @@ static mtu_result_t determine_mtu(const std::string &addr, const mtu_result_t &u
     return mtu;
 }
 
+/***********************************************************************
+ * Startup helpers
+ **********************************************************************/
+//! Collects the duration of each startup stage for a one line report,
+//! with tracing on each stage is also an "open/<stage>" span
+class startup_timer
+{
+public:
+    startup_timer(void): _start(now()), _last(_start), _last_ns(umtrx_trace::get().now_ns()){}
+
+    void mark(const std::string &stage)
+    {
+        const boost::posix_time::ptime t = now();
+        _report += str(boost::format("%s %.3fs, ") % stage % secs(t - _last));
+        _last = t;
+        umtrx_trace::get().record_span("open/" + stage, _last_ns);
+        _last_ns = umtrx_trace::get().now_ns();
+    }
+
+    std::string to_string(void) const
+    {
+        return _report + str(boost::format("total %.3fs") % secs(now() - _start));
+    }
+
+private:
+    static boost::posix_time::ptime now(void)
+    {
+        return boost::posix_time::microsec_clock::universal_time();
+    }
+    static double secs(const boost::posix_time::time_duration &d)
+    {
+        return d.total_microseconds()/1e6;
+    }
+    const boost::posix_time::ptime _start;
+    boost::posix_time::ptime _last;
+    boost::uint64_t _last_ns;
+    std::string _report;
+};
+
+//! Thread body for bringing up one LMS, errors are handed back as text
+static void make_lms_ctrl(lms6002d_ctrl::sptr &ctrl, std::string &error,
+    uhd::spi_iface::sptr spiface, const int lms_spi_number, const double clock_rate,
+    const std::string &cal_file, const std::string &cal_conditions, umtrx_iface::sptr zpu_iface)
+{
+    try
+    {
+        ctrl = lms6002d_ctrl::make(spiface, lms_spi_number, clock_rate, cal_file, cal_conditions, zpu_iface);
+    }
+    catch (const std::exception &ex)
+    {
+        error = ex.what();
+    }
+}
+
+//! Thread body for the teardown, drops the last handle of the tx async loop
+static void release_tx_async_loop(boost::shared_ptr<umtrx_tx_async_loop> &loop)
+{
+    loop.reset();
+}
+
+/***********************************************************************
+ * FPGA capabilities
+ **********************************************************************/
+//register blocks of each DSP chain, the image tells how many chains there are
+static const int rx_ctrl_srs[UMTRX_MAX_DDC] = {SR_RX_CTRL0, SR_RX_CTRL1, SR_RX_CTRL2, SR_RX_CTRL3};
+static const int rx_dsp_srs[UMTRX_MAX_DDC] = {SR_RX_DSP0, SR_RX_DSP1, SR_RX_DSP2, SR_RX_DSP3};
+static const int rx_gate_srs[UMTRX_MAX_DDC] = {SR_RX_GATE0, SR_RX_GATE1, SR_RX_GATE2, SR_RX_GATE3};
+static const int rx_fir_srs[UMTRX_MAX_DDC] = {SR_RX_FIR0, SR_RX_FIR1, SR_RX_FIR2, SR_RX_FIR3};
+static const int rx_tone_srs[UMTRX_MAX_DDC] = {SR_RX_TONE0, SR_RX_TONE1, SR_RX_TONE2, SR_RX_TONE3};
+static const int tx_ctrl_srs[UMTRX_MAX_DUC] = {SR_TX_CTRL0, SR_TX_CTRL1};
+static const int tx_dsp_srs[UMTRX_MAX_DUC] = {SR_TX_DSP0, SR_TX_DSP1};
+static const int tx_mod_srs[UMTRX_MAX_DUC] = {SR_TX_MOD0, SR_TX_MOD1};
+static const int tx_ramp_srs[UMTRX_MAX_DUC] = {SR_TX_RAMP0, SR_TX_RAMP1};
+static const int rx_agc_srs[2] = {SR_RX_AGC0, SR_RX_AGC1}; //per LMS
+static const int burst_atr_srs[2] = {SR_ATR0, SR_ATR1}; //per LMS
+
+//the RX AGC writes RXVGA2 at the SPI clock of the fifo ctrl writes
+static const boost::uint32_t RX_AGC_SPI_DIVIDER = 16;
+static const boost::uint32_t RX_AGC_VGA2_REG = 0x65;
+
+//! Raised cosine ramp up of num_samps gains, without the 0 and 1 at its ends
+static std::vector<double> tx_ramp_raised_cosine(const size_t num_samps)
+{
+    std::vector<double> gains(num_samps);
+    for (size_t i = 0; i < num_samps; i++)
+    {
+        gains[i] = 0.5*(1.0 - std::cos(M_PI*(i + 1)/(num_samps + 1)));
+    }
+    return gains;
+}
+
+//! The estimate of the time model while it lives, see umtrx_fifo_ctrl::set_time_estimator
+static bool estimate_device_time(boost::weak_ptr<umtrx_time_model> model, uhd::time_spec_t &time, double &error)
+{
+    umtrx_time_model::sptr locked = model.lock();
+    return locked and locked->estimate_time_now(time, error);
+}
+
+static std::vector<std::string> fpga_caps_names(const boost::uint32_t caps)
+{
+    std::vector<std::string> names;
+    if (caps & U2_FLAG_CAPS_SC8) names.push_back("sc8");
+    if (caps & U2_FLAG_CAPS_RX_POWER) names.push_back("rx_power");
+    if (caps & U2_FLAG_CAPS_RX_GATE) names.push_back("rx_gate");
+    if (caps & U2_FLAG_CAPS_RX_FIR) names.push_back("rx_filter");
+    if (caps & U2_FLAG_CAPS_TX_GMSK) names.push_back("tx_gmsk");
+    if (caps & U2_FLAG_CAPS_SHARED_DSP) names.push_back("shared_dsp");
+    if (caps & U2_FLAG_CAPS_LE_FRAMING) names.push_back("le_framing");
+    if (caps & U2_FLAG_CAPS_RX_BFP8) names.push_back("rx_bfp8");
+    if (caps & U2_FLAG_CAPS_RX_COMBINE) names.push_back("rx_combine");
+    if (caps & U2_FLAG_CAPS_RX_TONE) names.push_back("rx_tone");
+    if (caps & U2_FLAG_CAPS_TX_RAMP) names.push_back("tx_ramp");
+    if (caps & U2_FLAG_CAPS_RX_AGC) names.push_back("rx_agc");
+    if (caps & U2_FLAG_CAPS_BURST_ATR) names.push_back("burst_atr");
+    return names;
+}
+
+boost::uint32_t umtrx_impl::read_fpga_caps(const boost::uint16_t fpga_minor)
+{
+    if (fpga_minor >= UMTRX_FPGA_CAPS_MINOR)
+    {
+        const boost::uint32_t caps = _iface->peek32(U2_REG_CAPS_RB);
+        if ((caps & U2_FLAG_CAPS_VALID) == 0) throw uhd::runtime_error(str(boost::format(
+            "umtrx capability word 0x%08x -- (unsupported FPGA image?)") % caps));
+        return caps;
+    }
+
+    //older images have all the features of their version and the default TX fifo
+    boost::uint32_t caps = U2_FLAG_CAPS_VALID | (9 << 16) | U2_FLAG_CAPS_SC8;
+    if (fpga_minor >= UMTRX_FPGA_RX_POWER_MINOR) caps |= U2_FLAG_CAPS_RX_POWER;
+    if (fpga_minor >= UMTRX_FPGA_RX_GATE_MINOR) caps |= U2_FLAG_CAPS_RX_GATE;
+    if (fpga_minor >= UMTRX_FPGA_RX_FIR_MINOR) caps |= U2_FLAG_CAPS_RX_FIR;
+    if (fpga_minor >= UMTRX_FPGA_TX_GMSK_MINOR) caps |= U2_FLAG_CAPS_TX_GMSK;
+    return caps;
+}
+
 /***********************************************************************
  * Structors
  **********************************************************************/
 umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
 {
+    //trace=<entries> records the register accesses, see TRACE in umtrx_monitor.cpp
+    if (device_addr.has_key("trace")) umtrx_trace::get().enable(device_addr.cast<size_t>("trace", 0));
+    umtrx_trace_scope open_trace("open");
+    //log_rate=<n> messages a second per call site of the async log, 0 for no limit
+    if (device_addr.has_key("log_rate")) umtrx_async_log::set_rate_limit(device_addr.cast<size_t>("log_rate", 10));
+    startup_timer startup;
     _umtrx_vga2_def = device_addr.cast<int>("lmsvga2", UMTRX_VGA2_DEF);
     _device_ip_addr = device_addr["addr"];
+    _xport_args = device_addr;
     UHD_MSG(status) << "UmTRX driver version: " << UMTRX_VERSION << std::endl;
     UHD_MSG(status) << "Opening a UmTRX device... " << _device_ip_addr << std::endl;
 
-    //mtu self check -- not really doing anything with it
+    //probe the path mtu, it becomes the default data frame size
+    //the echoes pass the firmware buffer, so jumbo frames are not probed
     mtu_result_t user_mtu;
     user_mtu.recv_mtu = size_t(device_addr.cast<double>("recv_frame_size", udp_simple::mtu));
     user_mtu.send_mtu = size_t(device_addr.cast<double>("send_frame_size", udp_simple::mtu));
     user_mtu = determine_mtu(_device_ip_addr, user_mtu);
-    UHD_VAR(user_mtu.recv_mtu);
-    UHD_VAR(user_mtu.send_mtu);
+    _recv_mtu = user_mtu.recv_mtu;
+    _send_mtu = user_mtu.send_mtu;
 
     ////////////////////////////////////////////////////////////////////
     // create controller objects and initialize the properties tree
@@ -255,16 +411,59 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
     }
     _tree->create<std::string>(mb_path / "fpga_version").set(str(boost::format("%u.%u") % fpga_major % fpga_minor));
 
+    //the DSP chains, fifos and features below are built from what the image reports
+    _fpga_caps = this->read_fpga_caps(fpga_minor);
+    const boost::uint32_t fw_minor = _iface->peekfw(U2_FW_REG_VER_MINOR);
+    _framer_dscp = fw_minor >= UMTRX_FW_STREAM_QOS_MINOR;
+    _framer_dest = fw_minor >= UMTRX_FW_STREAM_DEST_MINOR;
+    _framer_vlan = _framer_dscp and fpga_minor >= UMTRX_FPGA_VLAN_MINOR;
+    _tree->create<std::vector<std::string> >(mb_path / "fpga_caps").set(fpga_caps_names(_fpga_caps));
+
+    //link rate from the speed the phy negotiated, older firmware leaves it zero
+    const boost::uint32_t link_mbps = _iface->peekfw(U2_FW_REG_LINK_SPEED);
+    _link_rate_bps = device_addr.cast<double>("link_rate", (link_mbps != 0)? link_mbps*1e6/8 : UMTRX_LINK_RATE_BPS);
+    _tree->create<double>(mb_path / "link_rate").set(_link_rate_bps);
+    _tree->create<size_t>(mb_path / "link_mtu/recv").set(_recv_mtu);
+    _tree->create<size_t>(mb_path / "link_mtu/send").set(_send_mtu);
+    UHD_MSG(status) << boost::format("Link: %.0f Mb/s, MTU %u bytes to host, %u bytes to device")
+        % (_link_rate_bps*8/1e6) % _recv_mtu % _send_mtu << std::endl;
+    if (link_mbps != 0 and link_mbps < 1000) UHD_MSG(warning)
+        << "UmTRX link is below gigabit, the host rates are limited accordingly" << std::endl;
+
+    //time from the FPGA configuration to the firmware main loop, older firmware reads zero
+    const boost::uint32_t boot_time_ms = _iface->peekfw(U2_FW_REG_BOOT_TIME);
+    if (boot_time_ms != 0) UHD_MSG(status) << boost::format("Firmware boot took %u ms") % boot_time_ms << std::endl;
+    _tree->create<sensor_value_t>(mb_path / "sensors" / "fw_boot_time")
+        .set(sensor_value_t("FW boot time", double(boot_time_ms), "ms"));
+
+    //worst ctrl response time the firmware main loop measured, older firmware reads zero
+    _tree->create<sensor_value_t>(mb_path / "sensors" / "fw_ctrl_latency")
+        .publish(boost::bind(&umtrx_impl::read_fw_ctrl_latency, this));
+
     //lock the device/motherboard to this process
     _iface->lock_device(true);
+    startup.mark("iface");
 
     ////////////////////////////////////////////////////////////////
     // high performance settings control
     ////////////////////////////////////////////////////////////////
     _iface->poke32(U2_REG_MISC_CTRL_SFC_CLEAR, 1); //clear settings fifo control state machine
     const size_t fifo_ctrl_window(device_addr.cast<size_t>("fifo_ctrl_window", 1024)); //default gets clipped to hardware maximum
-    _ctrl = umtrx_fifo_ctrl::make(this->make_xport(UMTRX_CTRL_FRAMER, device_addr_t()), UMTRX_CTRL_SID, fifo_ctrl_window);
+    const size_t fifo_ctrl_cmds_per_pkt = (fpga_minor >= UMTRX_FPGA_MULTI_CMD_MINOR)? fifo_ctrl_window : 1;
+    //immediate commands whose ack is lost are sent again after milliseconds, 0 waits the full ack timeout
+    const size_t fifo_ctrl_retries(device_addr.cast<size_t>("fifo_ctrl_retries", 2));
+    _ctrl = umtrx_fifo_ctrl::make(this->make_xport(UMTRX_CTRL_FRAMER, device_addr_t()), UMTRX_CTRL_SID, fifo_ctrl_window, fifo_ctrl_cmds_per_pkt,
+        fpga_minor >= UMTRX_FPGA_CTRL_QUEUE_MINOR, fifo_ctrl_retries);
     _ctrl->peek32(0); //test readback
+    //seconds the teardown waits for each control ack, a dead link closes as quickly
+    _teardown_timeout = device_addr.cast<double>("teardown_timeout", 0.2);
+    _tree->create<sensor_value_t>(mb_path / "sensors" / "ctrl_queue")
+        .publish(boost::bind(&umtrx_impl::read_ctrl_queue, this));
+    startup.mark("ctrl");
+    //raw access to both control paths for umtrx_ctrl_bench
+    _tree->create<umtrx_iface::sptr>(mb_path / "umtrx_iface").set(_iface);
+    _tree->create<umtrx_fifo_ctrl::sptr>(mb_path / "fifo_ctrl").set(_ctrl);
+    this->setup_sram_split(device_addr, fpga_minor);
     _tree->create<time_spec_t>(mb_path / "time/cmd")
         .subscribe(boost::bind(&umtrx_fifo_ctrl::set_time, _ctrl, boost::placeholders::_1));
     _tree->create<double>(mb_path / "tick_rate")
@@ -296,7 +495,24 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
     ////////////////////////////////////////////////////////////////////////
     // autodetect umtrx hardware rev and initialize rev. specific sensors
     ////////////////////////////////////////////////////////////////////////
+    _sensors_mask = 0;
+    _sensors_snapshot = true;
+    _sensor_poll_period = device_addr.cast<double>("sensor_poll_period", 1.0);
+    //sensor_continuous=1 keeps the ADCs converting, a sample then reads the input settled since the last one
+    _sensor_continuous = device_addr.cast<int>("sensor_continuous", 0) != 0;
+    _sensor_seq_mask = 0;
+    //temp_rate=<Hz> of the TMP102 conversions, 0.25, 1, 4 or 8
+    const double temp_rate = device_addr.cast<double>("temp_rate", 4.0);
+    _temp_rate = (temp_rate < 0.5)? tmp102_ctrl::TMP102_CR_025HZ :
+                 (temp_rate < 2.0)? tmp102_ctrl::TMP102_CR_1HZ :
+                 (temp_rate < 6.0)? tmp102_ctrl::TMP102_CR_4HZ : tmp102_ctrl::TMP102_CR_8HZ;
+    _sensor_slot_paths.resize(UMTRX_SENSORS_NUM);
+    protection_setup(device_addr, mb_path);
+    //cal_temp_step=<degC> of board temperature change that applies the corrections again, 0 never
+    _fe_cal_temp_step = device_addr.cast<double>("cal_temp_step", 2.0);
     detect_hw_rev(mb_path);
+    _tree->create<umtrx_sensor_snapshot_t>(mb_path / "sensor_snapshot")
+        .publish(boost::bind(&umtrx_impl::get_cached_snapshot, this));
     _tree->create<std::string>(mb_path / "hwrev").set(get_hw_rev());
     UHD_MSG(status) << "Detected UmTRX " << get_hw_rev() << std::endl;
 
@@ -318,16 +534,31 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
     {
         //TODO delect umsel2 automatically with I2C communication
         const bool umsel_verbose = device_addr.has_key("umsel_verbose");
-        _umsel2 = umsel2_ctrl::make(_ctrl/*peek*/, _ctrl/*spi*/, this->get_master_clock_rate(), umsel_verbose);
+        const bool umsel_fast_lock = device_addr.get("umsel_fast_lock", "on") != "off";
+        _umsel2 = umsel2_ctrl::make(_ctrl/*peek*/, _ctrl/*spi*/, this->get_master_clock_rate(), umsel_verbose, umsel_fast_lock);
+    }
+
+    //umsel_pingpong=on: for boards with both synth outputs on the LO port of channel A,
+    //a hop tunes the muted synth and swaps the outputs, at the command time when one is set
+    _umsel_pingpong = _umsel2 and device_addr.get("umsel_pingpong", "off") != "off";
+    _umsel_active = 1;
+    if (_umsel_pingpong)
+    {
+        _umsel2->select_rx_output(_umsel_active);
+        UHD_MSG(status) << "UmSEL2 ping-pong: both synthesizers serve RX front end A, B tunes the LMS only" << std::endl;
     }
 
     //register lock detect for umsel2
     if (_umsel2)
     {
-        _tree->create<sensor_value_t>(mb_path / "dboards" / "A" / "rx_frontends" / "0" / "sensors" / "aux_lo_locked")
-            .publish(boost::bind(&umsel2_ctrl::get_locked, _umsel2, 1));
-        _tree->create<sensor_value_t>(mb_path / "dboards" / "B" / "rx_frontends" / "0" / "sensors" / "aux_lo_locked")
-            .publish(boost::bind(&umsel2_ctrl::get_locked, _umsel2, 2));
+        create_cached_sensor(mb_path / "dboards" / "A" / "rx_frontends" / "0" / "sensors" / "aux_lo_locked",
+            boost::bind(&umsel2_ctrl::get_locked, _umsel2, 1));
+        create_cached_sensor(mb_path / "dboards" / "B" / "rx_frontends" / "0" / "sensors" / "aux_lo_locked",
+            boost::bind(&umsel2_ctrl::get_locked, _umsel2, 2));
+        _tree->create<sensor_value_t>(mb_path / "dboards" / "A" / "rx_frontends" / "0" / "sensors" / "aux_lo_tune_time")
+            .publish(boost::bind(&umsel2_ctrl::get_tune_time, _umsel2, 1));
+        _tree->create<sensor_value_t>(mb_path / "dboards" / "B" / "rx_frontends" / "0" / "sensors" / "aux_lo_tune_time")
+            .publish(boost::bind(&umsel2_ctrl::get_tune_time, _umsel2, 2));
     }
 
     ////////////////////////////////////////////////////////////////////////
@@ -419,8 +650,9 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
     ////////////////////////////////////////////////////////////////
     _rx_fes.resize(2);
     _tx_fes.resize(2);
-    _rx_fes[0] = rx_frontend_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_RX_FRONT0));
-    _rx_fes[1] = rx_frontend_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_RX_FRONT1));
+    const bool dc_track = fpga_minor >= UMTRX_FPGA_DC_TRACK_MINOR;
+    _rx_fes[0] = rx_frontend_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_RX_FRONT0), dc_track? U2_REG_SR_ADDR(SR_RX_FE_DC0) : 0);
+    _rx_fes[1] = rx_frontend_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_RX_FRONT1), dc_track? U2_REG_SR_ADDR(SR_RX_FE_DC1) : 0);
     _tx_fes[0] = tx_frontend_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_TX_FRONT0));
     _tx_fes[1] = tx_frontend_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_TX_FRONT1));
 
@@ -445,6 +677,20 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
         _tree->create<bool>(rx_fe_path / "dc_offset" / "enable")
             .subscribe(boost::bind(&rx_frontend_core_200::set_dc_offset_auto, rx_fe, boost::placeholders::_1))
             .set(true);
+        if (dc_track)
+        {
+            //the frontends run at the dsp rate, the FPGA default is 2^20 samples
+            rx_fe->set_tick_rate(this->get_master_dsp_rate());
+            _tree->access<double>(mb_path / "dsp_rate")
+                .subscribe(boost::bind(&rx_frontend_core_200::set_tick_rate, rx_fe, boost::placeholders::_1));
+            _tree->create<double>(rx_fe_path / "dc_offset" / "time_constant")
+                .coerce(boost::bind(&rx_frontend_core_200::set_dc_offset_time_constant, rx_fe, boost::placeholders::_1))
+                .set(device_addr.cast<double>("rx_dc_time_constant", std::ldexp(1.0, 20)/this->get_master_dsp_rate()));
+            //freeze holds the current estimate, same as disabling the automatic correction
+            _tree->create<std::string>(rx_fe_path / "dc_offset" / "mode")
+                .subscribe(boost::bind(&umtrx_impl::set_rx_dc_offset_mode, this, rx_fe_path, boost::placeholders::_1))
+                .set("track");
+        }
         _tree->create<std::complex<double> >(rx_fe_path / "iq_balance" / "value")
             .subscribe(boost::bind(&rx_frontend_core_200::set_iq_balance, rx_fe, boost::placeholders::_1))
             .set(std::polar<double>(0.0, 0.0));
@@ -462,16 +708,33 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
     // create rx dsp control objects
     ////////////////////////////////////////////////////////////////
     _rx_dsps.resize(_iface->peek32(U2_REG_NUM_DDC));
-    if (_rx_dsps.size() < 2) throw uhd::runtime_error(str(boost::format("umtrx rx_dsps %u -- (unsupported FPGA image?)") % _rx_dsps.size()));
-    if (_rx_dsps.size() > 0) _rx_dsps[0] = rx_dsp_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_RX_DSP0), U2_REG_SR_ADDR(SR_RX_CTRL0), UMTRX_DSP_RX0_SID, true);
-    if (_rx_dsps.size() > 1) _rx_dsps[1] = rx_dsp_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_RX_DSP1), U2_REG_SR_ADDR(SR_RX_CTRL1), UMTRX_DSP_RX1_SID, true);
-    if (_rx_dsps.size() > 2) _rx_dsps[2] = rx_dsp_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_RX_DSP2), U2_REG_SR_ADDR(SR_RX_CTRL2), UMTRX_DSP_RX2_SID, true);
-    if (_rx_dsps.size() > 3) _rx_dsps[3] = rx_dsp_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_RX_DSP3), U2_REG_SR_ADDR(SR_RX_CTRL3), UMTRX_DSP_RX3_SID, true);
+    if (_rx_dsps.size() < 2 or _rx_dsps.size() > UMTRX_MAX_DDC) throw uhd::runtime_error(str(boost::format("umtrx rx_dsps %u -- (unsupported FPGA image?)") % _rx_dsps.size()));
+    const bool rx_gate = (_fpga_caps & U2_FLAG_CAPS_RX_GATE) != 0;
+    const bool rx_fir = (_fpga_caps & U2_FLAG_CAPS_RX_FIR) != 0;
+    const bool rx_power = (_fpga_caps & U2_FLAG_CAPS_RX_POWER) != 0;
+    const bool rx_combine = (_fpga_caps & U2_FLAG_CAPS_RX_COMBINE) != 0;
+    const bool rx_tone = (_fpga_caps & U2_FLAG_CAPS_RX_TONE) != 0;
+    for (size_t dspno = 0; dspno < _rx_dsps.size(); dspno++)
+    {
+        _rx_dsps[dspno] = rx_dsp_core_200::make(_ctrl, U2_REG_SR_ADDR(rx_dsp_srs[dspno]), U2_REG_SR_ADDR(rx_ctrl_srs[dspno]),
+            UMTRX_DSP_RX_SIDS[dspno], true, rx_gate? U2_REG_SR_ADDR(rx_gate_srs[dspno]) : 0, rx_fir? U2_REG_SR_ADDR(rx_fir_srs[dspno]) : 0,
+            rx_tone? U2_REG_SR_ADDR(rx_tone_srs[dspno]) : 0);
+    }
+    this->flush_rx_dsps(fpga_minor >= UMTRX_FPGA_RX_CMD_QUEUE_MINOR);
+    _rx_tone_length.assign(_rx_dsps.size(), 0);
     _tree->create<sensor_value_t>(mb_path / "rx_dsps"); //phony property so this dir exists
 
+    //exact rates between the integer decimations, unless rx_frac_resampler=0
+    const bool rx_frac_resampler = fpga_minor >= UMTRX_FPGA_FRAC_RESAMP_MINOR
+        and device_addr.cast<int>("rx_frac_resampler", 1) != 0;
+
     for (size_t dspno = 0; dspno < _rx_dsps.size(); dspno++){
         _rx_dsps[dspno]->set_mux("IQ", false/*no swap*/);
-        _rx_dsps[dspno]->set_link_rate(UMTRX_LINK_RATE_BPS);
+        if (fpga_minor >= UMTRX_FPGA_FRAC_RESAMP_MINOR) _rx_dsps[dspno]->set_frac_resampler(rx_frac_resampler);
+        if (fpga_minor >= UMTRX_FPGA_RX_CIC2_MINOR) _rx_dsps[dspno]->set_cic2(true);
+        if (rx_power) _rx_dsps[dspno]->set_power_averaging(device_addr.cast<size_t>("rx_power_avg", 1024));
+        if (fpga_minor >= UMTRX_FPGA_RX_STATS_MINOR) _rx_dsps[dspno]->set_stats_period(device_addr.cast<double>("rx_stats_period", 0.1));
+        _rx_dsps[dspno]->set_link_rate(_link_rate_bps);
         _tree->access<double>(mb_path / "dsp_rate")
             .subscribe(boost::bind(&rx_dsp_core_200::set_tick_rate, _rx_dsps[dspno], boost::placeholders::_1));
         _tree->access<double>(mb_path / "tick_rate")
@@ -483,27 +746,97 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
             .set(this->get_master_clock_rate()/12) //some default
             .coerce(boost::bind(&rx_dsp_core_200::set_host_rate, _rx_dsps[dspno], boost::placeholders::_1))
             .subscribe(boost::bind(&umtrx_impl::update_rx_samp_rate, this, dspno, boost::placeholders::_1));
+        //CIC only where it can, less delay for less stopband rejection
+        _tree->create<bool>(rx_dsp_path / "low_latency")
+            .subscribe(boost::bind(&umtrx_impl::set_rx_low_latency, this, dspno, boost::placeholders::_1))
+            .set(device_addr.cast<int>("rx_low_latency", 0) != 0);
+        _tree->create<double>(rx_dsp_path / "group_delay")
+            .publish(boost::bind(&rx_dsp_core_200::get_group_delay, _rx_dsps[dspno]));
         _tree->create<double>(rx_dsp_path / "freq/value")
             .coerce(boost::bind(&rx_dsp_core_200::set_freq, _rx_dsps[dspno], boost::placeholders::_1));
+        if (fpga_minor >= UMTRX_FPGA_HOP_TABLE_MINOR) _tree->create<dsp_hop_table_t>(rx_dsp_path / "freq/hops")
+            .subscribe(boost::bind(&rx_dsp_core_200::set_hop_table, _rx_dsps[dspno], boost::placeholders::_1));
         _tree->create<meta_range_t>(rx_dsp_path / "freq/range")
             .publish(boost::bind(&rx_dsp_core_200::get_freq_range, _rx_dsps[dspno]));
         _tree->create<stream_cmd_t>(rx_dsp_path / "stream_cmd")
             .subscribe(boost::bind(&rx_dsp_core_200::issue_stream_command, _rx_dsps[dspno], boost::placeholders::_1));
+        //a schedule of timed captures in one transaction, the queue holds UMTRX_RX_CMD_QUEUE_LINES
+        if (fpga_minor >= UMTRX_FPGA_RX_CMD_QUEUE_MINOR)
+        {
+            _tree->create<std::vector<rx_dsp_window_t> >(rx_dsp_path / "stream_windows")
+                .subscribe(boost::bind(&umtrx_impl::issue_rx_stream_windows, this, dspno, boost::placeholders::_1));
+            _tree->create<sensor_value_t>(rx_dsp_path / "sensors" / "cmd_queue")
+                .publish(boost::bind(&umtrx_impl::read_rx_cmd_queue, this, dspno));
+        }
+        //continuous streaming only sends the open timeslots once a gate is set
+        if (rx_gate) _tree->create<rx_dsp_gate_t>(rx_dsp_path / "gate")
+            .subscribe(boost::bind(&rx_dsp_core_200::set_gate, _rx_dsps[dspno], boost::placeholders::_1))
+            .set(rx_dsp_gate_t()); //a previous session may have left one
+        //empty for the CIC droop compensation, taps at the host rate otherwise
+        if (rx_fir) _tree->create<std::vector<double> >(rx_dsp_path / "filter")
+            .subscribe(boost::bind(&rx_dsp_core_200::set_filter, _rx_dsps[dspno], boost::placeholders::_1))
+            .set(std::vector<double>());
+        //the odd DSPs stream the weighted sum of the even DSP before them and their own,
+        //weights in DSP order, empty streams the own DDC only
+        if (rx_combine and (dspno % 2) == 1) _tree->create<std::vector<std::complex<double> > >(rx_dsp_path / "combine")
+            .subscribe(boost::bind(&umtrx_impl::set_rx_combine, this, dspno, boost::placeholders::_1))
+            .set(std::vector<std::complex<double> >());
+        //read on demand, not cached: AGC loops poll it
+        if (rx_power) _tree->create<sensor_value_t>(rx_dsp_path / "sensors" / "power")
+            .publish(boost::bind(&umtrx_impl::read_rx_power, this, dspno));
+        //one DFT bin for the calibrations without streaming, a set of either restarts it,
+        //the result replaces the power readback while the length is not zero
+        if (rx_tone)
+        {
+            _tree->create<size_t>(rx_dsp_path / "tone" / "length")
+                .coerce(boost::bind(&umtrx_impl::set_rx_tone_length, this, dspno, boost::placeholders::_1))
+                .set(0); //a previous session may have left it running
+            _tree->create<double>(rx_dsp_path / "tone" / "freq")
+                .coerce(boost::bind(&rx_dsp_core_200::set_tone_freq, _rx_dsps[dspno], boost::placeholders::_1))
+                .set(0.0);
+            _tree->create<sensor_value_t>(rx_dsp_path / "sensors" / "tone")
+                .publish(boost::bind(&umtrx_impl::read_rx_tone, this, dspno));
+        }
+        //samples the device can hold back while the host is late, before an overflow
+        _tree->create<size_t>(rx_dsp_path / "buffer_bytes")
+            .set(_rx_fifo_bytes + ((dspno < _rx_sram_bytes.size())? _rx_sram_bytes[dspno] : 0));
     }
 
     ////////////////////////////////////////////////////////////////
     // create tx dsp control objects
     ////////////////////////////////////////////////////////////////
-    _tx_dsps.resize(_iface->peek32(U2_REG_NUM_DUC));
-    if (_tx_dsps.empty()) _tx_dsps.resize(1); //uhd cant support empty sides
-    if (_tx_dsps.size() > 0) _tx_dsps[0] = tx_dsp_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_TX_DSP0), U2_REG_SR_ADDR(SR_TX_CTRL0), UMTRX_DSP_TX0_SID);
-    if (_tx_dsps.size() > 1) _tx_dsps[1] = tx_dsp_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_TX_DSP1), U2_REG_SR_ADDR(SR_TX_CTRL1), UMTRX_DSP_TX1_SID);
+    //stop a playback left over by a previous session, the dsp clear flushes it
+    const bool tx_loop = fpga_minor >= UMTRX_FPGA_TX_LOOP_MINOR and _rx_sram_bytes[0] == 0;
+    _tx_loop_bits = 0;
+    if (tx_loop) _iface->poke32(U2_REG_TX_LOOP, _tx_loop_bits);
+    _num_duc = _iface->peek32(U2_REG_NUM_DUC);
+    if (_num_duc > UMTRX_MAX_DUC) throw uhd::runtime_error(str(boost::format("umtrx tx_dsps %u -- (unsupported FPGA image?)") % _num_duc));
+    _tx_dsps.resize(std::max<size_t>(_num_duc, 1)); //uhd cant support empty sides
+    const bool tx_gmsk = (_fpga_caps & U2_FLAG_CAPS_TX_GMSK) != 0;
+    const bool tx_ramp = (_fpga_caps & U2_FLAG_CAPS_TX_RAMP) != 0;
+    for (size_t dspno = 0; dspno < _tx_dsps.size(); dspno++)
+    {
+        _tx_dsps[dspno] = tx_dsp_core_200::make(_ctrl, U2_REG_SR_ADDR(tx_dsp_srs[dspno]), U2_REG_SR_ADDR(tx_ctrl_srs[dspno]),
+            UMTRX_DSP_TX_SIDS[dspno], tx_gmsk? U2_REG_SR_ADDR(tx_mod_srs[dspno]) : 0,
+            tx_ramp? U2_REG_SR_ADDR(tx_ramp_srs[dspno]) : 0, true/*hold clear*/);
+    }
+    //one reset hold for the packets in flight to every chain
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    {
+        umtrx_fifo_ctrl_batch batch(_ctrl);
+        for (size_t dspno = 0; dspno < _tx_dsps.size(); dspno++) _tx_dsps[dspno]->end_clear();
+    }
+    _tx_idle_fill = fpga_minor >= UMTRX_FPGA_TX_IDLE_FILL_MINOR;
+    _tx_late_policy = fpga_minor >= UMTRX_FPGA_TX_LATE_MINOR;
     _tree->create<sensor_value_t>(mb_path / "tx_dsps"); //phony property so this dir exists
+    _tx_fc_state.resize(_tx_dsps.size());
 
     for (size_t dspno = 0; dspno < _tx_dsps.size(); dspno++){
-        _tx_dsps[dspno]->set_link_rate(UMTRX_LINK_RATE_BPS);
+        _tx_dsps[dspno]->set_link_rate(_link_rate_bps);
         _tree->access<double>(mb_path / "dsp_rate")
             .subscribe(boost::bind(&tx_dsp_core_200::set_tick_rate, _tx_dsps[dspno], boost::placeholders::_1));
+        _tree->access<double>(mb_path / "tick_rate")
+            .subscribe(boost::bind(&tx_dsp_core_200::set_vita_rate, _tx_dsps[dspno], boost::placeholders::_1));
         fs_path tx_dsp_path = mb_path / str(boost::format("tx_dsps/%u") % dspno);
         _tree->create<meta_range_t>(tx_dsp_path / "rate/range")
             .publish(boost::bind(&tx_dsp_core_200::get_host_rates, _tx_dsps[dspno]));
@@ -511,12 +844,92 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
             .set(this->get_master_clock_rate()/12) //some default
             .coerce(boost::bind(&tx_dsp_core_200::set_host_rate, _tx_dsps[dspno], boost::placeholders::_1))
             .subscribe(boost::bind(&umtrx_impl::update_tx_samp_rate, this, dspno, boost::placeholders::_1));
+        _tree->create<bool>(tx_dsp_path / "low_latency")
+            .subscribe(boost::bind(&umtrx_impl::set_tx_low_latency, this, dspno, boost::placeholders::_1))
+            .set(device_addr.cast<int>("tx_low_latency", 0) != 0);
+        _tree->create<double>(tx_dsp_path / "group_delay")
+            .publish(boost::bind(&tx_dsp_core_200::get_group_delay, _tx_dsps[dspno]));
         _tree->create<double>(tx_dsp_path / "freq/value")
             .coerce(boost::bind(&tx_dsp_core_200::set_freq, _tx_dsps[dspno], boost::placeholders::_1));
+        if (fpga_minor >= UMTRX_FPGA_HOP_TABLE_MINOR) _tree->create<dsp_hop_table_t>(tx_dsp_path / "freq/hops")
+            .subscribe(boost::bind(&tx_dsp_core_200::set_hop_table, _tx_dsps[dspno], boost::placeholders::_1));
+        //burst edge gains, tx_ramp=<samples> starts with a raised cosine, as GSM bursts need
+        if (tx_ramp) _tree->create<std::vector<double> >(tx_dsp_path / "ramp")
+            .subscribe(boost::bind(&tx_dsp_core_200::set_ramp, _tx_dsps[dspno], boost::placeholders::_1))
+            .set(tx_ramp_raised_cosine(device_addr.cast<size_t>("tx_ramp", 0)));
         _tree->create<meta_range_t>(tx_dsp_path / "freq/range")
             .publish(boost::bind(&tx_dsp_core_200::get_freq_range, _tx_dsps[dspno]));
+        if (tx_loop) _tree->create<std::string>(tx_dsp_path / "loop").set("off")
+            .subscribe(boost::bind(&umtrx_impl::set_tx_loop, this, dspno, boost::placeholders::_1));
+        _tree->create<sensor_value_t>(tx_dsp_path / "stats/fc_in_flight")
+            .publish(boost::bind(&umtrx_impl::get_tx_fc_in_flight, this, dspno));
+        _tree->create<sensor_value_t>(tx_dsp_path / "stats/fc_latency")
+            .publish(boost::bind(&umtrx_impl::get_tx_fc_latency, this, dspno));
+        _tree->create<sensor_value_t>(tx_dsp_path / "stats/fc_ack_latency")
+            .publish(boost::bind(&umtrx_impl::get_tx_fc_ack_latency, this, dspno));
+        //late and underflow packets as the device counted them, one peek for both
+        if (_tx_late_policy) _tree->create<boost::uint32_t>(tx_dsp_path / "stats/device_counters")
+            .publish(boost::bind(&umtrx_fifo_ctrl::peek32, _ctrl, U2_REG_TX_COUNTERS_RB(dspno)));
     }
 
+    //the device time and the DSP readbacks above in one block peek, for monitors polling them together
+    _dsp_status_time_snapshot = fpga_minor >= UMTRX_FPGA_TIME_SNAPSHOT_MINOR;
+    _dsp_status_rx_power = rx_power;
+    _dsp_status_rx_cmd_queue = fpga_minor >= UMTRX_FPGA_RX_CMD_QUEUE_MINOR;
+    _tree->create<umtrx_dsp_status_t>(mb_path / "dsp_status")
+        .publish(boost::bind(&umtrx_impl::read_dsp_status, this));
+
+    //digital loopback of the TX DSPs into the RX DSPs, bit exact and without RF
+    if (fpga_minor >= UMTRX_FPGA_LOOPBACK_MINOR) _tree->create<bool>(mb_path / "loopback")
+        .subscribe(boost::bind(&umtrx_impl::set_loopback, this, boost::placeholders::_1))
+        .set(false); //a previous session may have left it on
+
+    //network link test on the RX0 destination and the TX0 SID, umtrx_link_test drives it
+    if (fpga_minor >= UMTRX_FPGA_LINK_TEST_MINOR)
+    {
+        const fs_path link_path = mb_path / "link_test";
+        _tree->create<std::string>(link_path / "mode")
+            .subscribe(boost::bind(&umtrx_impl::set_link_test, this, boost::placeholders::_1))
+            .set("off");
+        _tree->create<boost::uint32_t>(link_path / "sent")
+            .publish(boost::bind(&umtrx_iface::peek32, _iface, U2_REG_LINK_TEST_SENT_RB));
+        _tree->create<boost::uint32_t>(link_path / "received")
+            .publish(boost::bind(&umtrx_iface::peek32, _iface, U2_REG_LINK_TEST_TOTAL_RB));
+        _tree->create<boost::uint32_t>(link_path / "crc_errors")
+            .publish(boost::bind(&umtrx_iface::peek32, _iface, U2_REG_LINK_TEST_CRC_ERR_RB));
+        _tree->create<boost::uint32_t>(link_path / "seq_errors")
+            .publish(boost::bind(&umtrx_iface::peek32, _iface, U2_REG_LINK_TEST_SEQ_ERR_RB));
+        //each read makes a new transport, it takes over the stream destination of the framer
+        _tree->create<zero_copy_if::sptr>(link_path / "rx_xport")
+            .publish(boost::bind(&umtrx_impl::make_xport, this, UMTRX_DSP_RX0_FRAMER, device_addr_t(), stream_stats_t::sptr()));
+        _tree->create<zero_copy_if::sptr>(link_path / "tx_xport")
+            .publish(boost::bind(&umtrx_impl::make_xport, this, UMTRX_DSP_TX0_FRAMER, device_addr_t(), stream_stats_t::sptr()));
+    }
+
+    //ethernet PAUSE flow control, the MAC asks the switch to hold off when its rx fifo fills
+    if (fpga_minor >= UMTRX_FPGA_ETH_PAUSE_MINOR)
+    {
+        const fs_path pause_path = mb_path / "eth_pause";
+        _tree->create<boost::uint32_t>(pause_path / "time")
+            .subscribe(boost::bind(&umtrx_iface::poke32, _iface, U2_REG_ETH_MAC_PAUSE_TIME, boost::placeholders::_1))
+            .set(device_addr.cast<boost::uint32_t>("eth_pause_time", _iface->peek32(U2_REG_ETH_MAC_PAUSE_TIME)));
+        _tree->create<boost::uint32_t>(pause_path / "thresh")
+            .subscribe(boost::bind(&umtrx_iface::poke32, _iface, U2_REG_ETH_MAC_PAUSE_THRESH, boost::placeholders::_1))
+            .set(device_addr.cast<boost::uint32_t>("eth_pause_thresh", _iface->peek32(U2_REG_ETH_MAC_PAUSE_THRESH)));
+        _tree->create<std::string>(pause_path / "mode")
+            .subscribe(boost::bind(&umtrx_impl::set_eth_pause, this, boost::placeholders::_1))
+            .set(device_addr.get("eth_pause", "respect"));
+        _tree->create<boost::uint32_t>(pause_path / "received")
+            .publish(boost::bind(&umtrx_iface::peek32, _iface, U2_REG_ETH_MAC_PAUSE_RCVD_RB));
+        _tree->create<boost::uint32_t>(pause_path / "sent")
+            .publish(boost::bind(&umtrx_iface::peek32, _iface, U2_REG_ETH_MAC_PAUSE_SENT_RB));
+        _tree->create<boost::uint32_t>(pause_path / "last_quanta")
+            .publish(boost::bind(&umtrx_iface::peek32, _iface, U2_REG_ETH_MAC_PAUSE_QUANTA_RB));
+    }
+
+    //ethernet MAC frame counters as sensors and metrics, see umtrx_monitor.cpp
+    if (fpga_minor >= UMTRX_FPGA_ETH_STATS_MINOR) this->eth_stats_start(mb_path);
+
     ////////////////////////////////////////////////////////////////
     // create time control objects
     ////////////////////////////////////////////////////////////////
@@ -525,16 +938,24 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
     time64_rb_bases.rb_lo_now = U2_REG_TIME64_LO_RB_IMM;
     time64_rb_bases.rb_hi_pps = U2_REG_TIME64_HI_RB_PPS;
     time64_rb_bases.rb_lo_pps = U2_REG_TIME64_LO_RB_PPS;
+    time64_rb_bases.rb_hi_snapshot = (fpga_minor >= UMTRX_FPGA_TIME_SNAPSHOT_MINOR)? U2_REG_TIME64_HI_RB_SNAPSHOT : 0;
     _time64 = time64_core_200::make(_ctrl, U2_REG_SR_ADDR(SR_TIME64), time64_rb_bases);
 
+    //time readbacks and sets go through the model so it can track the clock
+    _time_model = umtrx_time_model::make(_time64);
+    _tree->create<umtrx_time_model::sptr>(mb_path / "time_model").set(_time_model);
+    //timed commands are due by the modelled device time, the model does not own the controller
+    _ctrl->set_time_estimator(boost::bind(&estimate_device_time, boost::weak_ptr<umtrx_time_model>(_time_model),
+        boost::placeholders::_1, boost::placeholders::_2));
+
     _tree->access<double>(mb_path / "tick_rate")
-        .subscribe(boost::bind(&time64_core_200::set_tick_rate, _time64, boost::placeholders::_1));
+        .subscribe(boost::bind(&umtrx_time_model::set_tick_rate, _time_model, boost::placeholders::_1));
     _tree->create<time_spec_t>(mb_path / "time" / "now")
-        .publish(boost::bind(&time64_core_200::get_time_now, _time64))
-        .subscribe(boost::bind(&time64_core_200::set_time_now, _time64, boost::placeholders::_1));
+        .publish(boost::bind(&umtrx_time_model::get_time_now, _time_model))
+        .subscribe(boost::bind(&umtrx_time_model::set_time_now, _time_model, boost::placeholders::_1));
     _tree->create<time_spec_t>(mb_path / "time" / "pps")
         .publish(boost::bind(&time64_core_200::get_time_last_pps, _time64))
-        .subscribe(boost::bind(&time64_core_200::set_time_next_pps, _time64, boost::placeholders::_1));
+        .subscribe(boost::bind(&umtrx_time_model::set_time_next_pps, _time_model, boost::placeholders::_1));
     //setup time source props
     _tree->create<std::string>(mb_path / "time_source" / "value")
         .subscribe(boost::bind(&time64_core_200::set_time_source, _time64, boost::placeholders::_1));
@@ -550,8 +971,64 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
     ////////////////////////////////////////////////////////////////////
     // create RF frontend interfacing
     ////////////////////////////////////////////////////////////////////
-    _lms_ctrl["A"] = lms6002d_ctrl::make(_ctrl/*spi*/, SPI_SS_LMS1, this->get_master_clock_rate() / _pll_div);
-    _lms_ctrl["B"] = lms6002d_ctrl::make(_ctrl/*spi*/, SPI_SS_LMS2, this->get_master_clock_rate() / _pll_div);
+    startup.mark("board");
+    {
+        //The chips only share the control fifo, whose lock is taken per SPI transaction,
+        //so the init and calibration of both sides run concurrently and overlap their sleeps.
+        const double lms_clock_rate = this->get_master_clock_rate() / _pll_div;
+
+        //Auto-calibration results are kept per board side and reused while the
+        //temperature stays within the same band, disable with lms_cal_cache=0
+        std::string cal_file_a, cal_file_b, cal_conditions_a, cal_conditions_b;
+        if (device_addr.cast<int>("lms_cal_cache", 1) != 0 and not _iface->mb_eeprom["serial"].empty())
+        {
+#if UHD_VERSION >= 4000000
+            const std::string cal_dir = uhd::get_cal_data_path();
+#else
+            const std::string cal_dir = uhd::get_app_path() + "/.uhd/cal";
+#endif
+            cal_file_a = cal_dir + "/lms_autocal_" + _iface->mb_eeprom["serial"] + ".A.txt";
+            cal_file_b = cal_dir + "/lms_autocal_" + _iface->mb_eeprom["serial"] + ".B.txt";
+            const double temp_band = device_addr.cast<double>("lms_cal_temp_band", 10.0);
+            std::string band_a = "none", band_b = "none";
+            if (_hw_rev >= UMTRX_VER_2_1)
+            {
+                band_a = boost::lexical_cast<std::string>(int(std::floor(this->read_temp_c("A").to_real()/temp_band)));
+                band_b = (_hw_rev >= UMTRX_VER_2_2)?
+                    boost::lexical_cast<std::string>(int(std::floor(this->read_temp_c("B").to_real()/temp_band))) : band_a;
+            }
+            cal_conditions_a = str(boost::format("serial=%s side=A temp_band=%s/%g") % _iface->mb_eeprom["serial"] % band_a % temp_band);
+            cal_conditions_b = str(boost::format("serial=%s side=B temp_band=%s/%g") % _iface->mb_eeprom["serial"] % band_b % temp_band);
+        }
+
+        //the firmware runs the LMS calibration loops it knows, unless they are kept on the host
+        umtrx_iface::sptr lms_zpu_iface;
+        if (not device_addr.has_key("lms_host_loops")) lms_zpu_iface = _iface;
+
+        lms6002d_ctrl::sptr lms_a, lms_b;
+        std::string error_a, error_b;
+        boost::function<void(void)> init_a = boost::bind(&make_lms_ctrl, boost::ref(lms_a), boost::ref(error_a),
+            uhd::spi_iface::sptr(_ctrl), SPI_SS_LMS1, lms_clock_rate, cal_file_a, cal_conditions_a, lms_zpu_iface);
+        boost::function<void(void)> init_b = boost::bind(&make_lms_ctrl, boost::ref(lms_b), boost::ref(error_b),
+            uhd::spi_iface::sptr(_ctrl), SPI_SS_LMS2, lms_clock_rate, cal_file_b, cal_conditions_b, lms_zpu_iface);
+        if (device_addr.has_key("lms_serial_init"))
+        {
+            init_a();
+            init_b();
+        }
+        else
+        {
+            boost::thread_group lms_init;
+            lms_init.create_thread(init_a);
+            lms_init.create_thread(init_b);
+            lms_init.join_all();
+        }
+        if (not error_a.empty()) throw uhd::runtime_error("LMS A initialization failed: " + error_a);
+        if (not error_b.empty()) throw uhd::runtime_error("LMS B initialization failed: " + error_b);
+        _lms_ctrl["A"] = lms_a;
+        _lms_ctrl["B"] = lms_b;
+    }
+    startup.mark("lms");
 
     // LMS dboard do not have physical eeprom so we just hardcode values from host/lib/usrp/dboard/db_lms.cpp
     dboard_eeprom_t rx_db_eeprom, tx_db_eeprom, gdb_db_eeprom;
@@ -582,10 +1059,14 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
             .set(gdb_db_eeprom);
 
         //sensors -- always say locked
-        _tree->create<sensor_value_t>(rx_rf_fe_path / "sensors" / "lo_locked")
-            .publish(boost::bind(&lms6002d_ctrl::get_rx_pll_locked, ctrl));
-        _tree->create<sensor_value_t>(tx_rf_fe_path / "sensors" / "lo_locked")
-            .publish(boost::bind(&lms6002d_ctrl::get_tx_pll_locked, ctrl));
+        create_cached_sensor(rx_rf_fe_path / "sensors" / "lo_locked",
+            boost::bind(&lms6002d_ctrl::get_rx_pll_locked, ctrl));
+        create_cached_sensor(tx_rf_fe_path / "sensors" / "lo_locked",
+            boost::bind(&lms6002d_ctrl::get_tx_pll_locked, ctrl));
+        _tree->create<sensor_value_t>(rx_rf_fe_path / "sensors" / "lo_tune_time")
+            .publish(boost::bind(&lms6002d_ctrl::get_rx_tune_time, ctrl));
+        _tree->create<sensor_value_t>(tx_rf_fe_path / "sensors" / "lo_tune_time")
+            .publish(boost::bind(&lms6002d_ctrl::get_tx_tune_time, ctrl));
 
         //rx gains
         BOOST_FOREACH(const std::string &name, ctrl->get_rx_gains())
@@ -598,6 +1079,37 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
                 .set((ctrl->get_rx_gain_range(name).start() + ctrl->get_rx_gain_range(name).stop())/2.0);
         }
 
+        //overall VGA gain in one write, for AGC loops, out of the gains group
+        _tree->create<meta_range_t>(rx_rf_fe_path / "gain_total" / "range")
+            .publish(boost::bind(&lms6002d_ctrl::get_rx_gain_total_range, ctrl));
+        _tree->create<double>(rx_rf_fe_path / "gain_total" / "value")
+            .coerce(boost::bind(&lms6002d_ctrl::set_rx_gain_total, ctrl, boost::placeholders::_1));
+
+        //the FPGA steps VGA2 on the power of a DSP, the receivers get the changes in-band
+        if (_fpga_caps & U2_FLAG_CAPS_RX_AGC)
+        {
+            const fs_path agc_path = rx_rf_fe_path / "agc";
+            const meta_range_t vga2_range = ctrl->get_rx_gain_range("VGA2");
+            const boost::function<void(void)> update = boost::bind(&umtrx_impl::update_rx_agc, this, fe_name, false);
+            _tree->create<size_t>(agc_path / "source").set((fe_name == "B" and _rx_dsps.size() > 1)? 1 : 0).subscribe(boost::bind(update));
+            _tree->create<double>(agc_path / "target").set(-20.0).subscribe(boost::bind(update)); //dBFS
+            _tree->create<double>(agc_path / "window").set(6.0).subscribe(boost::bind(update)); //dB around the target
+            _tree->create<double>(agc_path / "period").set(100e-6).subscribe(boost::bind(update)); //seconds between evaluations
+            _tree->create<size_t>(agc_path / "attack").set(1).subscribe(boost::bind(update)); //evaluations over the window to step down
+            _tree->create<size_t>(agc_path / "decay").set(8).subscribe(boost::bind(update)); //evaluations under the window to step up
+            _tree->create<meta_range_t>(agc_path / "range").set(vga2_range).subscribe(boost::bind(update));
+            _tree->create<bool>(agc_path / "enable").set(false).subscribe(boost::bind(update));
+            create_cached_sensor(rx_rf_fe_path / "sensors" / "agc_gain",
+                boost::bind(&umtrx_impl::read_rx_agc_gain, this, fe_name));
+
+            //the FPGA steps from the gain the host writes
+            _tree->access<double>(rx_rf_fe_path / "gains" / "VGA2" / "value")
+                .subscribe(boost::bind(&umtrx_impl::update_rx_agc, this, fe_name, true));
+            _tree->access<double>(rx_rf_fe_path / "gain_total" / "value")
+                .subscribe(boost::bind(&umtrx_impl::update_rx_agc, this, fe_name, true));
+            this->update_rx_agc(fe_name, true);
+        }
+
         //tx gains
         if (!_pa[fe_name])
         {
@@ -611,6 +1123,10 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
                     .coerce(boost::bind(&lms6002d_ctrl::set_tx_gain, ctrl, boost::placeholders::_1, name))
                     .set((ctrl->get_tx_gain_range(name).start() + ctrl->get_tx_gain_range(name).stop())/2.0);
             }
+            _tree->create<meta_range_t>(tx_rf_fe_path / "gain_total" / "range")
+                .publish(boost::bind(&lms6002d_ctrl::get_tx_gain_total_range, ctrl));
+            _tree->create<double>(tx_rf_fe_path / "gain_total" / "value")
+                .coerce(boost::bind(&lms6002d_ctrl::set_tx_gain_total, ctrl, boost::placeholders::_1));
         } else {
             // Set LMS internal VGA1 gain to optimal value
             // VGA2 will be set in the set_tx_power()
@@ -631,14 +1147,16 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
 
         //rx freq
         _tree->create<double>(rx_rf_fe_path / "freq" / "value")
-            .coerce(boost::bind(&umtrx_impl::set_rx_freq, this, fe_name, boost::placeholders::_1));
+            .coerce(boost::bind(&umtrx_impl::set_rx_freq, this, fe_name, boost::placeholders::_1))
+            .subscribe(boost::bind(&umtrx_impl::expire_cached_sensor, this, std::string(rx_rf_fe_path / "sensors" / "lo_locked")));
         _tree->create<meta_range_t>(rx_rf_fe_path / "freq" / "range")
             .publish(boost::bind(&umtrx_impl::get_rx_freq_range, this, fe_name));
         _tree->create<bool>(rx_rf_fe_path / "use_lo_offset").set(false);
 
         //tx freq
         _tree->create<double>(tx_rf_fe_path / "freq" / "value")
-            .coerce(boost::bind(&lms6002d_ctrl::set_tx_freq, ctrl, boost::placeholders::_1));
+            .coerce(boost::bind(&umtrx_impl::set_tx_freq, this, fe_name, boost::placeholders::_1))
+            .subscribe(boost::bind(&umtrx_impl::expire_cached_sensor, this, std::string(tx_rf_fe_path / "sensors" / "lo_locked")));
         _tree->create<meta_range_t>(tx_rf_fe_path / "freq" / "range")
             .publish(boost::bind(&lms6002d_ctrl::get_tx_freq_range, ctrl));
         _tree->create<bool>(tx_rf_fe_path / "use_lo_offset").set(false);
@@ -665,6 +1183,18 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
         _tree->create<bool>(tx_rf_fe_path / "enabled")
             .coerce(boost::bind(&lms6002d_ctrl::set_tx_enabled, ctrl, boost::placeholders::_1));
 
+        //the FPGA switches the PA and the diversity switch around the bursts, the LMS stays enabled
+        if (_fpga_caps & U2_FLAG_CAPS_BURST_ATR)
+        {
+            const fs_path atr_path = tx_rf_fe_path / "atr";
+            const boost::function<void(void)> update = boost::bind(&umtrx_impl::update_burst_atr, this, fe_name);
+            _tree->create<double>(atr_path / "lead").set(0.0).subscribe(boost::bind(update)); //seconds ahead of a timed burst
+            _tree->create<double>(atr_path / "lag").set(0.0).subscribe(boost::bind(update)); //seconds after a burst
+            _tree->create<bool>(atr_path / "diversity").set(false).subscribe(boost::bind(update)); //flip the diversity switch for the bursts
+            _tree->create<bool>(atr_path / "enable").set(false).subscribe(boost::bind(update));
+            this->update_burst_atr(fe_name);
+        }
+
         //rx bw
         _tree->create<double>(rx_rf_fe_path / "bandwidth" / "value")
             .coerce(boost::bind(&lms6002d_ctrl::set_rx_bandwidth, ctrl, boost::placeholders::_1))
@@ -687,6 +1217,12 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
             .set(0.0) //default value
             .subscribe(boost::bind(&umtrx_impl::set_rx_fe_corrections, this, "0", fe_name, boost::placeholders::_1));
 
+        //LOs to precompute corrections for, a retune to one of them applies its corrections in the same batch
+        _tree->create<std::vector<double> >(mb_path / "tx_frontends" / fe_name / "corrections" / "lo_list")
+            .subscribe(boost::bind(&umtrx_impl::set_tx_fe_correction_plan, this, fe_name, boost::placeholders::_1));
+        _tree->create<std::vector<double> >(mb_path / "rx_frontends" / fe_name / "corrections" / "lo_list")
+            .subscribe(boost::bind(&umtrx_impl::set_rx_fe_correction_plan, this, fe_name, boost::placeholders::_1));
+
         //tx cal props
         _tree->create<uint8_t>(tx_rf_fe_path / "lms6002d" / "tx_dc_i" / "value")
             .subscribe(boost::bind(&lms6002d_ctrl::_set_tx_vga1dc_i_int, ctrl, boost::placeholders::_1))
@@ -744,6 +1280,7 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
     //TCXO DAC calibration control
     _tree->create<uint16_t>(mb_path / "tcxo_dac" / "value")
         .subscribe(boost::bind(&umtrx_impl::set_tcxo_dac, this, _iface, boost::placeholders::_1));
+    this->gpsdo_telemetry_start(device_addr, mb_path);
 
     ////////////////////////////////////////////////////////////////////
     // post config tasks
@@ -752,7 +1289,7 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
         .set(this->get_master_clock_rate());
     _tree->access<double>(mb_path / "dsp_rate")
         .set(this->get_master_dsp_rate());
-    this->time64_self_test();
+    this->time64_self_test(device_addr);
 
     //reset cordic rates and their properties to zero
     BOOST_FOREACH(const std::string &name, _tree->list(mb_path / "rx_dsps"))
@@ -766,6 +1303,10 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
 
     _rx_streamers.resize(_rx_dsps.size());
     _tx_streamers.resize(_tx_dsps.size());
+    for (size_t i = 0; i < _rx_dsps.size(); i++) _rx_stream_stats.push_back(stream_stats_t::sptr(new stream_stats_t()));
+    for (size_t i = 0; i < _rx_dsps.size(); i++) _time_model->add_rx_stats(_rx_stream_stats[i]);
+    for (size_t i = 0; i < _tx_dsps.size(); i++) _tx_stream_stats.push_back(stream_stats_t::sptr(new stream_stats_t()));
+    for (size_t i = 0; i < _tx_dsps.size(); i++) _time_model->add_tx_stats(_tx_stream_stats[i]);
 
     subdev_spec_t rx_spec("A:0 B:0 A:0 B:0");
     rx_spec.resize(_rx_dsps.size());
@@ -778,13 +1319,59 @@ umtrx_impl::umtrx_impl(const device_addr_t &device_addr)
     _tree->access<std::string>(mb_path / "clock_source" / "value").set("internal");
     _tree->access<std::string>(mb_path / "time_source" / "value").set("none");
 
+    //tx async msgs of all streamers, each reader keeps its own cursor
+    _async_ring = umtrx_async_ring::make(1024/*messages deep*/);
+    _old_async_cursor = _async_ring->make_cursor();
+
+    //cpu and priority of the streaming threads, applied as they start
+    _tx_async_placement = umtrx_thread_placement(device_addr, "tx_async_cpu", true);
+    _rx_convert_cpus = umtrx_thread_placement::parse_cpus(device_addr.get("rx_convert_cpus", ""));
+    _rt_priority = _tx_async_placement.rt_priority;
+
+    //typed handles for the hot control paths, once every node they use exists
+    _tree->create<umtrx_fast_ctrl::sptr>(mb_path / "fast_ctrl").set(umtrx_fast_ctrl::make(_tree, mb_path));
+
+    //configuration snapshot, ex: state_file=/var/lib/umtrx/state
+    _tree->create<std::string>(mb_path / "state" / "save")
+        .subscribe(boost::bind(&umtrx_impl::save_state, this, boost::placeholders::_1));
+    _tree->create<std::string>(mb_path / "state" / "restore")
+        .subscribe(boost::bind(&umtrx_impl::restore_state, this, boost::placeholders::_1));
+    _state_file = device_addr.get("state_file", "");
+    if (not _state_file.empty() and boost::filesystem::exists(_state_file))
+    {
+        try
+        {
+            this->restore_state(_state_file);
+        }
+        catch (const std::exception &ex)
+        {
+            UHD_MSG(warning) << "Cannot restore the state from " << _state_file << ": " << ex.what() << std::endl;
+        }
+        startup.mark("state");
+    }
+
     //create status monitor and client handler
     this->status_monitor_start(device_addr);
+    startup.mark("setup");
+    UHD_MSG(status) << "Startup timing: " << startup.to_string() << std::endl;
 }
 
 umtrx_impl::~umtrx_impl(void)
 {
-    this->status_monitor_stop();
+    //bounded acks from here on, the shutdown writes below and those of
+    //the member destructors share packets until the fifo ctrl goes
+    _ctrl->close(_teardown_timeout);
+
+    //the threads sit in timed reads, join them side by side;
+    //the reports thread is joined before the PPS callbacks go
+    {
+        boost::thread_group joins;
+        joins.create_thread(boost::bind(&umtrx_impl::status_monitor_stop, this));
+        joins.create_thread(boost::bind(&release_tx_async_loop, boost::ref(_tx_async_loop)));
+        joins.join_all();
+    }
+    if (not _state_file.empty()) UHD_SAFE_CALL(this->save_state(_state_file);)
+    umtrx_async_log::flush();
 
     BOOST_FOREACH(const std::string &fe_name, _lms_ctrl.keys())
     {
@@ -847,21 +1434,26 @@ const uhd::gain_range_t &umtrx_impl::get_tx_power_range(const std::string &which
 
 double umtrx_impl::set_tx_power(double power, const std::string &which)
 {
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
     double min_pa_power = _pa[which]->min_power_dBm();
     double actual_power;
+    _tx_power_target = power;
+    _pa_loop_trim = 0.0;
 
     if (power >= min_pa_power)
     {
-        UHD_MSG(status) << "Setting Tx power using PA (VGA2=" << _umtrx_vga2_def << ", PA=" << power << ")" << std::endl;
+        UMTRX_MSG_ASYNC(status) << "Setting Tx power using PA (VGA2=" << _umtrx_vga2_def << ", PA=" << power << ")" << std::endl;
         // Set VGA2 to the recommended value and use PA to control Tx power
         _lms_ctrl[which]->set_tx_gain(_umtrx_vga2_def, "VGA2");
-        actual_power = set_pa_power(power, which);
+        _tx_vga2_base = _umtrx_vga2_def;
+        actual_power = set_pa_power_limited(power, which);
     } else {
         double vga2_gain = _umtrx_vga2_def - (min_pa_power-power);
-        UHD_MSG(status) << "Setting Tx power using VGA2 (VGA2=" << vga2_gain << ", PA=" << min_pa_power << ")" << std::endl;
+        UMTRX_MSG_ASYNC(status) << "Setting Tx power using VGA2 (VGA2=" << vga2_gain << ", PA=" << min_pa_power << ")" << std::endl;
         // Set PA output power to minimum and use VGA2 to control Tx power
         actual_power = _lms_ctrl[which]->set_tx_gain(vga2_gain, "VGA2");
-        actual_power = set_pa_power(min_pa_power, which) - (_umtrx_vga2_def-actual_power);
+        _tx_vga2_base = actual_power;
+        actual_power = set_pa_power_limited(min_pa_power, which) - (_umtrx_vga2_def-actual_power);
     }
 
     return actual_power;
@@ -887,7 +1479,7 @@ double umtrx_impl::set_pa_power(double power, const std::string &which)
 
     // TODO:: Check that power is actually there by reading VSWR sensor.
 
-    UHD_MSG(status) << "Setting PA power: Requested: " << power << "dBm = " << power_amp::dBm2w(power) << "W "
+    UMTRX_MSG_ASYNC(status) << "Setting PA power: Requested: " << power << "dBm = " << power_amp::dBm2w(power) << "W "
                     << "(" << v << "V dcdc_r=" << int(dcdc_val) << "). "
                     << "Actual: " << power_actual << "dBm = " << power_amp::dBm2w(power_actual) <<"W "
                     << "(" << v_actual << "V)" << std::endl;
@@ -901,29 +1493,209 @@ void umtrx_impl::set_mb_eeprom(const uhd::i2c_iface::sptr &iface, const uhd::usr
     store_umtrx_eeprom(eeprom, *iface);
 }
 
-void umtrx_impl::time64_self_test(void)
+void umtrx_impl::setup_sram_split(const device_addr_t &device_addr, const boost::uint16_t fpga_minor)
+{
+    //default split: each Tx channel owns one half of the SRAM, Rx has the on-chip fifos only
+    _tx_sram_bytes.assign(2, UMTRX_SRAM_BYTES);
+    _rx_sram_bytes.assign(2, 0);
+    _rx_fifo_bytes = UMTRX_DSP_FIFO_BYTES;
+
+    //images built with RX_EXT_FIFO (and the 4DDC build) buffer RX0/RX1 in the SRAM instead
+    bool rx_sram = false;
+    if (fpga_minor >= UMTRX_FPGA_RX_SRAM_MINOR)
+    {
+        const boost::uint32_t info = _iface->peek32(U2_REG_RX_BUFFER_RB);
+        rx_sram = (info & U2_FLAG_RX_BUFFER_SRAM) != 0;
+        _rx_fifo_bytes = size_t(4) << ((info >> 24) & 0x1f); //one sample per fifo line
+    }
+    if (rx_sram and _xport_args.has_key("tx_sram_split")) UHD_MSG(warning)
+        << "tx_sram_split ignored, this FPGA image buffers Rx in the SRAM" << std::endl;
+    const std::string split_key = rx_sram? "rx_sram_split" : "tx_sram_split";
+    std::vector<size_t> &sram_bytes = rx_sram? _rx_sram_bytes : _tx_sram_bytes;
+    if (rx_sram) _tx_sram_bytes.assign(2, size_t(4) << ((_fpga_caps >> 16) & 0x1f));
+
+    if (fpga_minor < UMTRX_FPGA_SRAM_SPLIT_MINOR)
+    {
+        if (_xport_args.has_key(split_key)) UHD_MSG(warning)
+            << split_key << " requires FPGA version 9." << UMTRX_FPGA_SRAM_SPLIT_MINOR
+            << " or later, using an even split" << std::endl;
+        return;
+    }
+
+    const double fraction0 = device_addr.cast<double>(split_key, 0.5);
+    if (fraction0 <= 0.0 or fraction0 >= 1.0) throw uhd::value_error(str(
+        boost::format("%s must be within (0, 1), but got %f") % split_key % fraction0));
+
+    const size_t words0 = std::max<size_t>(1, std::min<size_t>(UMTRX_SRAM_WORDS-1,
+        size_t(fraction0*UMTRX_SRAM_WORDS)));
+    _iface->poke32(U2_REG_SRAM_SPLIT, words0);
+    _iface->poke32(U2_REG_MISC_CTRL_SRAM_CLEAR, 1); //the split is latched when the fifo resets
+
+    //keep the same budget as the even split: UMTRX_SRAM_BYTES per half
+    const double share0 = double(words0)/UMTRX_SRAM_WORDS;
+    sram_bytes[0] = size_t(2*UMTRX_SRAM_BYTES*share0);
+    sram_bytes[1] = size_t(2*UMTRX_SRAM_BYTES*(1.0 - share0));
+    UHD_MSG(status) << boost::format("%s SRAM split: %s0 %u bytes, %s1 %u bytes")
+        % (rx_sram? "Rx" : "Tx") % (rx_sram? "RX" : "TX") % sram_bytes[0]
+        % (rx_sram? "RX" : "TX") % sram_bytes[1] << std::endl;
+}
+
+void umtrx_impl::time64_self_test(const device_addr_t &device_addr)
 {
-    //check the the ticks elapsed across a sleep is within an expected range
+    //check that the vita time advances at the rate of the host clock
     //this proves that the clock is the correct rate and not off by a factor
+    //the slope of a least squares fit over a short window is enough for that
 
+    if (not device_addr.cast<bool>("self_test", true)) return;
     UHD_MSG(status) << "Time register self-test... " << std::flush;
+
+    const double window = 0.02;
+    const boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    size_t n = 0;
+    double x = 0.0;
     const time_spec_t t0 = _time64->get_time_now();
-    const double sleepTime = 0.50;
-    boost::this_thread::sleep(boost::posix_time::milliseconds(long(sleepTime*1000)));
-    const time_spec_t t1 = _time64->get_time_now();
-    const double secs_elapsed = (t1 - t0).get_real_secs();
-    const bool within_range = (secs_elapsed < (1.5)*sleepTime and secs_elapsed > (0.5)*sleepTime);
+    do
+    {
+        //host time at the middle of the readback round trip
+        const double before = boost::chrono::duration<double>(boost::chrono::steady_clock::now() - start).count();
+        const double y = (_time64->get_time_now() - t0).get_real_secs();
+        x = (before + boost::chrono::duration<double>(boost::chrono::steady_clock::now() - start).count())/2;
+        sx += x; sy += y; sxx += x*x; sxy += x*y; n++;
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    } while (x < window);
+
+    //vita seconds per host second, times the tick rate the time core was set to
+    const double den = n*sxx - sx*sx;
+    const double slope = (n < 3 or den <= 0.0)? 0.0 : (n*sxy - sx*sy)/den;
+    const double rate = slope*this->get_master_clock_rate();
+    const bool within_range = (slope < 1.1 and slope > 0.9);
     UHD_MSG(status) << (within_range? "pass" : "fail") << std::endl;
+    if (not within_range) UHD_MSG(warning) << boost::format(
+        "Time register runs at %.3f MHz, expected %.3f MHz") % (rate/1e6) % (this->get_master_clock_rate()/1e6) << std::endl;
 }
 
 void umtrx_impl::update_clock_source(const std::string &){}
 
 void umtrx_impl::set_rx_fe_corrections(const std::string &mb, const std::string &board, const double lo_freq){
-    apply_rx_fe_corrections(this->get_tree()->subtree("/mboards/" + mb), board, lo_freq);
+    const double temperature = this->get_fe_temperature(board);
+    {
+        //planned LOs were corrected by set_rx_freq() already
+        boost::mutex::scoped_lock l(_fe_plan_mutex);
+        _fe_cal_temp[board] = temperature;
+        uhd::usrp::fe_corrections_t corr;
+        if (get_planned_fe_corrections(_rx_fe_plan[board], lo_freq, corr)) return;
+    }
+    apply_rx_fe_corrections(this->get_tree()->subtree("/mboards/" + mb), board, lo_freq, temperature);
 }
 
 void umtrx_impl::set_tx_fe_corrections(const std::string &mb, const std::string &board, const double lo_freq){
-    apply_tx_fe_corrections(this->get_tree()->subtree("/mboards/" + mb), board, lo_freq);
+    const double temperature = this->get_fe_temperature(board);
+    {
+        //planned LOs were corrected by set_tx_freq() already
+        boost::mutex::scoped_lock l(_fe_plan_mutex);
+        _fe_cal_temp[board] = temperature;
+        uhd::usrp::fe_corrections_t corr;
+        if (get_planned_fe_corrections(_tx_fe_plan[board], lo_freq, corr)) return;
+    }
+    apply_tx_fe_corrections(this->get_tree()->subtree("/mboards/" + mb), board, lo_freq, temperature);
+}
+
+void umtrx_impl::set_rx_fe_correction_plan(const std::string &which, const std::vector<double> &lo_freqs)
+{
+    const double temperature = this->get_fe_temperature(which);
+    fe_correction_plan_t plan;
+    BOOST_FOREACH(const double lo_freq, lo_freqs)
+    {
+        plan[lo_freq] = get_rx_fe_corrections(this->get_tree()->subtree("/mboards/0"), which, lo_freq, temperature);
+    }
+    boost::mutex::scoped_lock l(_fe_plan_mutex);
+    _rx_fe_plan[which] = plan;
+}
+
+void umtrx_impl::set_tx_fe_correction_plan(const std::string &which, const std::vector<double> &lo_freqs)
+{
+    const double temperature = this->get_fe_temperature(which);
+    fe_correction_plan_t plan;
+    BOOST_FOREACH(const double lo_freq, lo_freqs)
+    {
+        plan[lo_freq] = get_tx_fe_corrections(this->get_tree()->subtree("/mboards/0"), which, lo_freq, temperature);
+    }
+    boost::mutex::scoped_lock l(_fe_plan_mutex);
+    _tx_fe_plan[which] = plan;
+}
+
+double umtrx_impl::get_fe_temperature(const std::string &which)
+{
+    //the tmp102 of the side, from the sensor cache when it is fresh
+    const fs_path path = fs_path("/mboards/0/sensors") / ("temp" + which);
+    if (not _tree->exists(path)) return std::numeric_limits<double>::quiet_NaN();
+    try
+    {
+        return _tree->access<sensor_value_t>(path).get().to_real();
+    }
+    catch (const std::exception &)
+    {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+void umtrx_impl::fe_temperature_update(const umtrx_sensor_cache_t &cache)
+{
+    if (_fe_cal_temp_step <= 0) return;
+    BOOST_FOREACH(const std::string &which, _lms_ctrl.keys())
+    {
+        const std::map<std::string, sensor_value_t>::const_iterator it = cache.sensors.find("/mboards/0/sensors/temp" + which);
+        if (it == cache.sensors.end()) continue;
+        const double temperature = it->second.to_real();
+        {
+            boost::mutex::scoped_lock l(_fe_plan_mutex);
+            const std::map<std::string, double>::const_iterator last = _fe_cal_temp.find(which);
+            if (last == _fe_cal_temp.end() or boost::math::isnan(last->second)) continue; //not tuned yet
+            if (std::abs(temperature - last->second) < _fe_cal_temp_step) continue;
+        }
+
+        //plans first, so the corrections of the current LOs come from the new plans
+        UMTRX_MSG_ASYNC(status) << boost::format("FE corrections %s: board at %.1fC, applying again") % which % temperature << std::endl;
+        std::vector<double> tx_los, rx_los;
+        {
+            boost::mutex::scoped_lock l(_fe_plan_mutex);
+            BOOST_FOREACH(const fe_correction_plan_t::value_type &p, _tx_fe_plan[which]) tx_los.push_back(p.first);
+            BOOST_FOREACH(const fe_correction_plan_t::value_type &p, _rx_fe_plan[which]) rx_los.push_back(p.first);
+        }
+        if (not tx_los.empty()) this->set_tx_fe_correction_plan(which, tx_los);
+        if (not rx_los.empty()) this->set_rx_fe_correction_plan(which, rx_los);
+
+        const fs_path db_path = fs_path("/mboards/0/dboards") / which;
+        const double tx_lo = _tree->access<double>(db_path / "tx_frontends" / "0" / "freq" / "value").get();
+        const double rx_lo = _tree->access<double>(db_path / "rx_frontends" / "0" / "freq" / "value").get();
+        this->set_tx_fe_corrections("0", which, tx_lo);
+        this->apply_planned_fe_corrections(which, true, tx_lo);
+        this->set_rx_fe_corrections("0", which, rx_lo);
+        this->apply_planned_fe_corrections(which, false, rx_lo);
+    }
+}
+
+bool umtrx_impl::get_planned_fe_corrections(const fe_correction_plan_t &plan, const double lo_freq, uhd::usrp::fe_corrections_t &corr)
+{
+    //the tuned LO is the requested one up to the PLL resolution
+    static const double tolerance = 1e3;
+    fe_correction_plan_t::const_iterator it = plan.lower_bound(lo_freq - tolerance);
+    if (it == plan.end() or it->first > lo_freq + tolerance) return false;
+    corr = it->second;
+    return true;
+}
+
+void umtrx_impl::apply_planned_fe_corrections(const std::string &which, const bool is_tx, const double lo_freq)
+{
+    uhd::usrp::fe_corrections_t corr;
+    {
+        boost::mutex::scoped_lock l(_fe_plan_mutex);
+        if (not get_planned_fe_corrections(is_tx? _tx_fe_plan[which] : _rx_fe_plan[which], lo_freq, corr)) return;
+    }
+    const fs_path fe_path = fs_path("/mboards/0") / (is_tx? "tx_frontends" : "rx_frontends") / which;
+    if (corr.has_iq_balance) _tree->access<std::complex<double> >(fe_path / "iq_balance" / "value").set(corr.iq_balance);
+    if (corr.has_dc_offset) _tree->access<std::complex<double> >(fe_path / "dc_offset" / "value").set(corr.dc_offset);
 }
 
 void umtrx_impl::set_tcxo_dac(const umtrx_iface::sptr &iface, const uint16_t val){
@@ -960,9 +1732,40 @@ uint8_t umtrx_impl::dc_offset_double2int(double corr)
     return (int)(corr*128 + 128.5);
 }
 
+double umtrx_impl::set_tx_freq(const std::string &which, const double freq)
+{
+    //the retune and its planned corrections share the fifo packets,
+    //so a timed hop and its corrections take effect together
+    umtrx_fifo_ctrl_batch batch(_ctrl);
+    const double actual_freq = _lms_ctrl[which]->set_tx_freq(freq);
+    this->apply_planned_fe_corrections(which, true, actual_freq);
+    return actual_freq;
+}
+
 double umtrx_impl::set_rx_freq(const std::string &which, const double freq)
 {
-    if (_umsel2)
+    umtrx_fifo_ctrl_batch batch(_ctrl);
+    double actual_freq = 0.0;
+    if (_umsel_pingpong and which == "A")
+    {
+        const double actual_lms_freq = _lms_ctrl[which]->set_rx_freq(UMSEL2_CH1_LMS_IF);
+
+        //the standby synth locks now, only the output swap waits for the command time
+        const int standby = 3 - _umsel_active;
+        const uhd::time_spec_t cmd_time = _ctrl->get_time();
+        _ctrl->set_time(uhd::time_spec_t(0.0));
+        const double actual_umsel_freq = _umsel2->prepare_rx_freq(standby, freq - actual_lms_freq);
+        _ctrl->set_time(cmd_time);
+        _umsel2->select_rx_output(standby);
+        _umsel_active = standby;
+
+        actual_freq = actual_umsel_freq + actual_lms_freq;
+    }
+    else if (_umsel_pingpong)
+    {
+        actual_freq = _lms_ctrl[which]->set_rx_freq(freq);
+    }
+    else if (_umsel2)
     {
         const double target_lms_freq = (which=="A")?UMSEL2_CH1_LMS_IF:UMSEL2_CH2_LMS_IF;
         const double actual_lms_freq = _lms_ctrl[which]->set_rx_freq(target_lms_freq);
@@ -979,17 +1782,19 @@ double umtrx_impl::set_rx_freq(const std::string &which, const double freq)
         std::cout << "actual_total_freq " << (actual_umsel_freq + actual_lms_freq)/1e6 << " MHz" << std::endl;
         //*/
 
-        return actual_umsel_freq + actual_lms_freq;
+        actual_freq = actual_umsel_freq + actual_lms_freq;
     }
     else
     {
-        return _lms_ctrl[which]->set_rx_freq(freq);
+        actual_freq = _lms_ctrl[which]->set_rx_freq(freq);
     }
+    this->apply_planned_fe_corrections(which, false, actual_freq);
+    return actual_freq;
 }
 
 uhd::freq_range_t umtrx_impl::get_rx_freq_range(const std::string &which) const
 {
-    if (_umsel2)
+    if (_umsel2 and not (_umsel_pingpong and which == "B"))
     {
         const double target_lms_freq = (which=="A")?UMSEL2_CH1_LMS_IF:UMSEL2_CH2_LMS_IF;
         const uhd::freq_range_t range_umsel = _umsel2->get_rx_freq_range((which=="A")?1:2);
@@ -1006,6 +1811,11 @@ uhd::freq_range_t umtrx_impl::get_rx_freq_range(const std::string &which) const
 uhd::sensor_value_t umtrx_impl::read_temp_c(const std::string &which)
 {
     boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+    const size_t slot = (which == "A") ? UMTRX_SENSORS_TEMP_A : UMTRX_SENSORS_TEMP_B;
+    uint16_t values[UMTRX_SENSORS_NUM];
+    uint16_t mask = 1 << slot;
+    if (read_sensors_raw(mask, values)) return sensor_from_raw(slot, mask, values);
+
     double temp = (which == "A") ? _temp_side_a.get_temp() :
                                    _temp_side_b.get_temp();
     return uhd::sensor_value_t("Temp"+which, temp, "C");
@@ -1021,12 +1831,313 @@ uhd::sensor_value_t umtrx_impl::read_pa_v(const std::string &which)
     }
     UHD_ASSERT_THROW(i < 4);
 
+    uint16_t values[UMTRX_SENSORS_NUM];
+    uint16_t mask = 1 << (UMTRX_SENSORS_PWR_0 + i);
+    if (read_sensors_raw(mask, values)) return sensor_from_raw(UMTRX_SENSORS_PWR_0 + i, mask, values);
+
+    if (_sensor_continuous)
+    {
+        values[UMTRX_SENSORS_PWR_0 + i] = read_adc_settled(_sense_pwr, UMTRX_SENSORS_PWR_0, i);
+        return sensor_from_raw(UMTRX_SENSORS_PWR_0 + i, mask, values);
+    }
+
     _sense_pwr.set_input((ads1015_ctrl::ads1015_input)
                          (ads1015_ctrl::ADS1015_CONF_AIN0_GND + i));
     double val = _sense_pwr.get_value() * 10;
     return uhd::sensor_value_t("Voltage"+which, val, "V");
 }
 
+void umtrx_impl::set_rx_dc_offset_mode(const fs_path &rx_fe_path, const std::string &mode)
+{
+    if (mode != "track" and mode != "freeze") throw uhd::value_error("rx dc_offset mode must be track or freeze, not " + mode);
+    _tree->access<bool>(rx_fe_path / "dc_offset" / "enable").set(mode == "track");
+}
+
+//averaged I^2+Q^2 of the 16 bit samples: 0 dBFS is a full scale tone
+static double rx_power_to_dbfs(const boost::uint32_t power)
+{
+    return 10*std::log10(std::max<double>(power, 1)/(32767.0*32767.0));
+}
+
+uhd::sensor_value_t umtrx_impl::read_rx_power(const size_t dspno)
+{
+    if (_rx_tone_length[dspno] != 0) throw uhd::runtime_error("RX power: the tone meter of this DSP runs");
+    const boost::uint32_t power = _ctrl->peek32(U2_REG_RX_POWER_RB(dspno));
+    return uhd::sensor_value_t("RX Power", rx_power_to_dbfs(power), "dBFS");
+}
+
+size_t umtrx_impl::set_rx_tone_length(const size_t dspno, const size_t num_samps)
+{
+    _rx_tone_length[dspno] = _rx_dsps[dspno]->set_tone_length(num_samps);
+    return _rx_tone_length[dspno];
+}
+
+uhd::sensor_value_t umtrx_impl::read_rx_tone(const size_t dspno)
+{
+    if (_rx_tone_length[dspno] == 0) throw uhd::runtime_error("RX tone: set tone/length first");
+
+    //the first result after a restart takes the settling and one length,
+    //give it twice that at the host rate before giving up
+    const double rate = _tree->access<double>(fs_path("/mboards/0/rx_dsps") / str(boost::format("%u") % dspno) / "rate" / "value").get();
+    const double timeout = 2*(_rx_tone_length[dspno] + 64)/rate + 0.1;
+    const boost::system_time exit_time = boost::get_system_time() + boost::posix_time::microseconds(long(timeout*1e6));
+    boost::uint32_t result = 0;
+    while (((result = _ctrl->peek32(U2_REG_RX_POWER_RB(dspno))) & U2_FLAG_RX_TONE_VALID) == 0)
+    {
+        if (boost::get_system_time() > exit_time) throw uhd::runtime_error(str(boost::format(
+            "RX tone: no result on DSP %u after %.3f s") % dspno % timeout));
+        boost::this_thread::sleep(boost::posix_time::microseconds(200));
+    }
+    return uhd::sensor_value_t("RX Tone", _rx_dsps[dspno]->tone_result_to_db(result), "dB");
+}
+
+/*!
+ * The rx dsps are made with a one sample burst each for the lingering packet.
+ * Wait for all of them at once, the fifo ctrl runs in order: once the command
+ * queues are empty the bursts ran and the clears arrive behind them.
+ * Images without the queue readback wait one fixed time for all.
+ */
+void umtrx_impl::flush_rx_dsps(const bool cmd_queue_rb)
+{
+    static const double FLUSH_TIMEOUT = 0.01; //the old fixed wait per chain
+    if (cmd_queue_rb)
+    {
+        const boost::uint32_t mask = (_rx_dsps.size() >= 4)? 0xffffffff : ((1u << (8*_rx_dsps.size())) - 1);
+        const boost::system_time exit_time = boost::get_system_time() + boost::posix_time::microseconds(long(FLUSH_TIMEOUT*1e6));
+        while ((_ctrl->peek32(U2_REG_RX_CMD_QUEUE_RB) & mask) != 0)
+        {
+            if (boost::get_system_time() > exit_time)
+            {
+                UHD_MSG(warning) << "RX DSP: lingering packet bursts still queued after " << FLUSH_TIMEOUT << " s" << std::endl;
+                break;
+            }
+        }
+    }
+    else boost::this_thread::sleep(boost::posix_time::microseconds(long(FLUSH_TIMEOUT*1e6)));
+
+    umtrx_fifo_ctrl_batch batch(_ctrl);
+    for (size_t dspno = 0; dspno < _rx_dsps.size(); dspno++) _rx_dsps[dspno]->clear();
+}
+
+uhd::sensor_value_t umtrx_impl::read_rx_cmd_queue(const size_t dspno)
+{
+    const boost::uint32_t fill = (_ctrl->peek32(U2_REG_RX_CMD_QUEUE_RB) >> (8*dspno)) & 0xff;
+    return uhd::sensor_value_t("RX cmd queue", double(fill), "commands");
+}
+
+umtrx_dsp_status_t umtrx_impl::read_dsp_status(void)
+{
+    //the time words first: the lo word and its snapshot, or hi, lo, hi on older images
+    std::vector<wb_iface::wb_addr_type> addrs;
+    if (_dsp_status_time_snapshot)
+    {
+        addrs.push_back(U2_REG_TIME64_LO_RB_IMM);
+        addrs.push_back(U2_REG_TIME64_HI_RB_SNAPSHOT);
+    }
+    else
+    {
+        addrs.push_back(U2_REG_TIME64_HI_RB_IMM);
+        addrs.push_back(U2_REG_TIME64_LO_RB_IMM);
+        addrs.push_back(U2_REG_TIME64_HI_RB_IMM);
+    }
+    const size_t num_time = addrs.size();
+    if (_dsp_status_rx_power) for (size_t i = 0; i < _rx_dsps.size(); i++) addrs.push_back(U2_REG_RX_POWER_RB(i));
+    if (_dsp_status_rx_cmd_queue) addrs.push_back(U2_REG_RX_CMD_QUEUE_RB);
+    if (_tx_late_policy) for (size_t i = 0; i < _num_duc; i++) addrs.push_back(U2_REG_TX_COUNTERS_RB(i));
+
+    const std::vector<boost::uint32_t> words = _ctrl->peek32_multi(addrs);
+    std::vector<boost::uint32_t>::const_iterator it = words.begin() + num_time;
+
+    umtrx_dsp_status_t status;
+    boost::uint32_t ticks_hi = words[1], ticks_lo = words[0];
+    if (not _dsp_status_time_snapshot)
+    {
+        //the lo word wrapped between the hi peeks: its top bit tells on which side
+        ticks_lo = words[1];
+        ticks_hi = (words[0] == words[2] or (ticks_lo & 0x80000000))? words[0] : words[2];
+    }
+    status.time = uhd::time_spec_t::from_ticks((boost::uint64_t(ticks_hi) << 32) | ticks_lo, get_master_clock_rate());
+    //the word of a DSP with its tone meter on is the tone result, not a power
+    if (_dsp_status_rx_power) for (size_t i = 0; i < _rx_dsps.size(); i++, it++) status.rx_power.push_back(
+        (_rx_tone_length[i] != 0)? std::numeric_limits<double>::quiet_NaN() : rx_power_to_dbfs(*it));
+    if (_dsp_status_rx_cmd_queue)
+    {
+        const boost::uint32_t fill = *it++;
+        for (size_t i = 0; i < _rx_dsps.size(); i++) status.rx_cmd_queue.push_back((fill >> (8*i)) & 0xff);
+    }
+    if (_tx_late_policy) for (size_t i = 0; i < _num_duc; i++) status.tx_counters.push_back(*it++);
+    return status;
+}
+
+void umtrx_impl::issue_rx_stream_windows(const size_t dspno, const std::vector<rx_dsp_window_t> &windows)
+{
+    //the queue drops the commands that do not fit, refuse them all instead
+    const size_t fill = (_ctrl->peek32(U2_REG_RX_CMD_QUEUE_RB) >> (8*dspno)) & 0xff;
+    if (fill + windows.size() > UMTRX_RX_CMD_QUEUE_LINES) throw uhd::value_error(str(boost::format(
+        "RX DSP %u: %u capture windows do not fit the %u free stream command lines")
+        % dspno % windows.size() % (UMTRX_RX_CMD_QUEUE_LINES - fill)));
+    _rx_dsps[dspno]->issue_stream_windows(windows);
+}
+
+void umtrx_impl::set_rx_combine(const size_t dspno, const std::vector<std::complex<double> > &weights)
+{
+    static const int rx_combine_srs[UMTRX_MAX_DDC/2] = {SR_RX_COMBINE0, SR_RX_COMBINE1};
+    const size_t sr = rx_combine_srs[dspno/2];
+    if (weights.empty())
+    {
+        _ctrl->poke32(U2_REG_SR_ADDR(sr+2), 0);
+        return;
+    }
+    if (weights.size() != 2) throw uhd::value_error(str(boost::format(
+        "RX DSP %u combines 2 DSPs, not %u weights") % dspno % weights.size()));
+
+    //1.0 is 2^14 in 16 bits
+    boost::uint32_t words[2];
+    for (size_t i = 0; i < 2; i++)
+    {
+        const std::complex<double> w = weights[i]*double(1 << 14);
+        if (std::abs(w.real()) > 32767 or std::abs(w.imag()) > 32767) throw uhd::value_error(str(boost::format(
+            "RX DSP %u: combining weight %u is out of the +/-2.0 range") % dspno % i));
+        words[i] = (boost::uint32_t(boost::int16_t(boost::math::iround(w.imag()))) << 16)
+            | boost::uint16_t(boost::int16_t(boost::math::iround(w.real())));
+    }
+
+    //the partner DDC must run at the same rate, its samples are taken as they come
+    const fs_path mb_path = "/mboards/0";
+    const double rate = _tree->access<double>(mb_path / str(boost::format("rx_dsps/%u/rate/value") % dspno)).get();
+    property<double> &partner_rate = _tree->access<double>(mb_path / str(boost::format("rx_dsps/%u/rate/value") % (dspno-1)));
+    if (partner_rate.get() != rate) partner_rate.set(rate);
+
+    //the enable write takes both weights at once
+    _ctrl->poke32(U2_REG_SR_ADDR(sr+0), words[1]); //own DDC
+    _ctrl->poke32(U2_REG_SR_ADDR(sr+1), words[0]); //partner DDC
+    _ctrl->poke32(U2_REG_SR_ADDR(sr+2), 1);
+}
+
+void umtrx_impl::update_rx_agc(const std::string &fe_name, const bool load_gain)
+{
+    const size_t unit = (fe_name == "A")? 0 : 1;
+    const size_t sr = rx_agc_srs[unit];
+    const fs_path agc_path = fs_path("/mboards/0") / "dboards" / fe_name / "rx_frontends" / "0" / "agc";
+
+    const size_t source = _tree->access<size_t>(agc_path / "source").get();
+    if (source >= _rx_dsps.size()) throw uhd::value_error(str(boost::format(
+        "RX AGC %s: no RX DSP %u for the power") % fe_name % source));
+    const double window = _tree->access<double>(agc_path / "window").get();
+    if (window < 3.0) throw uhd::value_error(str(boost::format(
+        "RX AGC %s: a window of %g dB is less than the 3 dB step") % fe_name % window));
+    const meta_range_t range = _tree->access<meta_range_t>(agc_path / "range").get();
+    const int min_code = std::max(0, int(std::ceil(range.start()/3 - 1e-6)));
+    const int max_code = std::min(31, int(std::floor(range.stop()/3 + 1e-6)));
+    if (min_code > max_code) throw uhd::value_error(str(boost::format(
+        "RX AGC %s: no VGA2 step in %s dB") % fe_name % range.to_pp_string()));
+
+    //the power targets, with the same scale as the power readback
+    const double target = _tree->access<double>(agc_path / "target").get();
+    const double full_scale = 32767.0*32767.0;
+    const double target_hi = std::min(full_scale*std::pow(10.0, (target + window/2)/10), 2147483647.0);
+    const double target_lo = std::min(full_scale*std::pow(10.0, (target - window/2)/10), 2147483647.0);
+    const double period = _tree->access<double>(agc_path / "period").get()*this->get_master_clock_rate();
+    const size_t attack = std::min<size_t>(_tree->access<size_t>(agc_path / "attack").get(), 15);
+    const size_t decay = std::min<size_t>(_tree->access<size_t>(agc_path / "decay").get(), 15);
+    const bool enable = _tree->access<bool>(agc_path / "enable").get();
+
+    //disable while the registers change, the control write goes last
+    umtrx_fifo_ctrl_batch batch(_ctrl);
+    _ctrl->poke32(U2_REG_SR_ADDR(sr+0), 0);
+    _ctrl->poke32(U2_REG_SR_ADDR(sr+1), boost::uint32_t(target_hi));
+    _ctrl->poke32(U2_REG_SR_ADDR(sr+2), boost::uint32_t(target_lo));
+    _ctrl->poke32(U2_REG_SR_ADDR(sr+3), boost::uint32_t(std::min(std::max(period, 1.0), 4294967295.0)));
+
+    //the RXVGA2 register write, as the SPI core takes it from the host
+    const boost::uint32_t slave = (unit == 0)? SPI_SS_LMS1 : SPI_SS_LMS2;
+    _ctrl->poke32(U2_REG_SR_ADDR(sr+4), slave | (16 << 24) | (1 << 30)); //16 bits, miso on the rising edge as lms6002d_ctrl
+    if (load_gain)
+    {
+        const boost::uint32_t code = boost::uint32_t(boost::math::iround(_lms_ctrl[fe_name]->get_rx_gain("VGA2")/3)) & 0x1f;
+        _ctrl->poke32(U2_REG_SR_ADDR(sr+5), (RX_AGC_SPI_DIVIDER << 16) | (RX_AGC_VGA2_REG << 8) | code);
+    }
+
+    _ctrl->poke32(U2_REG_SR_ADDR(sr+0), (enable? 1 : 0) | (source << 1) | (min_code << 3) | (max_code << 8)
+        | (attack << 16) | (decay << 20));
+}
+
+void umtrx_impl::update_burst_atr(const std::string &fe_name)
+{
+    const fs_path mb_path = "/mboards/0";
+    const fs_path atr_path = mb_path / "dboards" / fe_name / "tx_frontends" / "0" / "atr";
+    if (not _tree->exists(atr_path / "enable")) return; //the PA and diversity setup come first
+
+    const size_t side = (fe_name == "A")? 0 : 1;
+    const double rate = this->get_master_clock_rate();
+    //ticks of the 16 bit counters, up to 2.5 ms at 26 MHz
+    const double lead = std::min(std::max(_tree->access<double>(atr_path / "lead").get()*rate, 0.0), 65535.0);
+    const double lag = std::min(std::max(_tree->access<double>(atr_path / "lag").get()*rate, 0.0), 65535.0);
+
+    //the lines in the manual setting, as commit_pa_state and set_diversity write them
+    const bool pa_cmd = (_hw_rev >= UMTRX_VER_2_3_1); //the host drives the PA enables from then on
+    const bool pa_en = ((side == 0)? _pa_en1 : _pa_en2) and not get_pa_shutdown(side);
+    const bool divsw = _tree->access<bool>(mb_path / ((side == 0)? "divsw1" : "divsw2")).get();
+    const boost::uint32_t div_line = (divsw != (side == 1))? 0 : 1;
+    const boost::uint32_t div_burst = _tree->access<bool>(atr_path / "diversity").get()? (div_line ^ 1) : div_line;
+
+    //[0] PA enable and [1] diversity switch of the idle, rx, tx and full duplex states, then the mask
+    const boost::uint32_t idle = div_line << 1;
+    const boost::uint32_t burst = (div_burst << 1) | ((pa_cmd and pa_en)? 1 : 0);
+    const boost::uint32_t mask = _tree->access<bool>(atr_path / "enable").get()? (2 | (pa_cmd? 1 : 0)) : 0;
+
+    umtrx_fifo_ctrl_batch batch(_ctrl);
+    _ctrl->poke32(U2_REG_SR_ADDR(burst_atr_srs[side]+1), (boost::uint32_t(boost::math::iround(lag)) << 16)
+        | boost::uint32_t(boost::math::iround(lead)));
+    _ctrl->poke32(U2_REG_SR_ADDR(burst_atr_srs[side]+0), idle | (idle << 2) | (burst << 4) | (burst << 6) | (mask << 8));
+}
+
+uhd::sensor_value_t umtrx_impl::read_rx_agc_gain(const std::string &fe_name)
+{
+    const size_t unit = (fe_name == "A")? 0 : 1;
+    const boost::uint32_t status = _ctrl->peek32(U2_REG_RX_AGC_RB) >> (16*unit);
+    return uhd::sensor_value_t("RX AGC gain", double(3*(status & 0x1f)), "dB");
+}
+
+uhd::sensor_value_t umtrx_impl::read_fw_ctrl_latency(void)
+{
+    return uhd::sensor_value_t("FW ctrl latency", double(_iface->peekfw(U2_FW_REG_CTRL_LATENCY_MAX)), "us");
+}
+
+uhd::sensor_value_t umtrx_impl::read_ctrl_queue(void)
+{
+    return uhd::sensor_value_t("Ctrl queue", double(_ctrl->get_queue_fill()), "commands");
+}
+
+void umtrx_impl::set_loopback(const bool enb)
+{
+    _iface->poke32(U2_REG_LOOPBACK, enb? 1 : 0);
+}
+
+void umtrx_impl::set_link_test(const std::string &mode)
+{
+    boost::uint32_t flags = 0;
+    if (mode == "source") flags = U2_FLAG_LINK_TEST_SOURCE;
+    else if (mode == "sink") flags = U2_FLAG_LINK_TEST_SINK;
+    else if (mode == "both") flags = U2_FLAG_LINK_TEST_SOURCE | U2_FLAG_LINK_TEST_SINK;
+    else if (mode != "off") throw uhd::value_error("umtrx: unknown link_test mode " + mode + ", expected off, source, sink or both");
+    _iface->poke32(U2_REG_LINK_TEST, flags);
+}
+
+void umtrx_impl::set_eth_pause(const std::string &mode)
+{
+    boost::uint32_t flags = 0;
+    if (mode == "respect") flags = U2_FLAG_ETH_MAC_PAUSE_EN;
+    else if (mode == "send") flags = U2_FLAG_ETH_MAC_PAUSE_SEND_EN;
+    else if (mode == "both") flags = U2_FLAG_ETH_MAC_PAUSE_EN | U2_FLAG_ETH_MAC_PAUSE_SEND_EN;
+    else if (mode != "off") throw uhd::value_error("umtrx: unknown eth_pause mode " + mode + ", expected off, respect, send or both");
+
+    //the other bits are the address filter set up by the firmware
+    const boost::uint32_t mask = U2_FLAG_ETH_MAC_PAUSE_EN | U2_FLAG_ETH_MAC_PAUSE_SEND_EN;
+    const boost::uint32_t settings = _iface->peek32(U2_REG_ETH_MAC_SETTINGS);
+    _iface->poke32(U2_REG_ETH_MAC_SETTINGS, (settings & ~mask) | flags);
+}
+
 uhd::sensor_value_t umtrx_impl::read_dc_v(const std::string &which)
 {
     boost::recursive_mutex::scoped_lock l(_i2c_mutex);
@@ -1037,12 +2148,128 @@ uhd::sensor_value_t umtrx_impl::read_dc_v(const std::string &which)
     }
     UHD_ASSERT_THROW(i < 4);
 
+    uint16_t values[UMTRX_SENSORS_NUM];
+    uint16_t mask = 1 << (UMTRX_SENSORS_DC_0 + i);
+    if (read_sensors_raw(mask, values)) return sensor_from_raw(UMTRX_SENSORS_DC_0 + i, mask, values);
+
+    if (_sensor_continuous)
+    {
+        values[UMTRX_SENSORS_DC_0 + i] = read_adc_settled(_sense_dc, UMTRX_SENSORS_DC_0, i);
+        return sensor_from_raw(UMTRX_SENSORS_DC_0 + i, mask, values);
+    }
+
     _sense_dc.set_input((ads1015_ctrl::ads1015_input)
                          (ads1015_ctrl::ADS1015_CONF_AIN0_GND + i));
     double val = _sense_dc.get_value() * 40;
     return uhd::sensor_value_t("Voltage"+which, val, "V");
 }
 
+bool umtrx_impl::read_sensors_raw(uint16_t &mask, uint16_t *values)
+{
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+
+    //continuous ADC inputs come from the sequencer, the firmware would read them right after a mux change
+    const uint16_t adc = _sensor_continuous? (mask & ~((1 << UMTRX_SENSORS_PWR_0) - 1)) : 0;
+    if (adc != 0)
+    {
+        if (_sensor_poll_period <= 0 or (_sensor_seq_mask & adc) != adc) return false;
+        for (size_t slot = UMTRX_SENSORS_PWR_0; slot < UMTRX_SENSORS_NUM; slot++)
+        {
+            if (adc & (1 << slot)) values[slot] = _sensor_seq_values[slot];
+        }
+    }
+
+    uint16_t rest = mask & ~adc;
+    if (rest != 0)
+    {
+        if (not _sensors_snapshot) return false;
+        if (not _iface->read_sensors_snapshot(rest, _sense_pwr.get_config(), _sense_dc.get_config(), values))
+        {
+            UHD_MSG(status) << "Firmware has no sensor snapshot support, reading sensors over I2C" << std::endl;
+            _sensors_snapshot = false;
+            return false;
+        }
+    }
+    mask = rest | adc;
+    return true;
+}
+
+uint16_t umtrx_impl::read_adc_settled(ads1015_ctrl &adc, const size_t base, const size_t input)
+{
+    //a direct read moves the mux, its result keeps the sequencer store whole
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+    adc.set_input(ads1015_ctrl::ads1015_input(ads1015_ctrl::ADS1015_CONF_AIN0_GND + input));
+    _sensor_seq_values[base + input] = adc.read_settled();
+    _sensor_seq_mask |= 1 << (base + input);
+    return _sensor_seq_values[base + input];
+}
+
+void umtrx_impl::sensor_sequencer_step(void)
+{
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+    if (not _sensor_continuous) return;
+
+    ads1015_ctrl *adcs[] = {&_sense_pwr, &_sense_dc};
+    const size_t bases[] = {UMTRX_SENSORS_PWR_0, UMTRX_SENSORS_DC_0};
+    for (size_t n = 0; n < 2; n++)
+    {
+        if ((_sensors_mask & (1 << bases[n])) == 0) continue;
+        ads1015_ctrl &adc = *adcs[n];
+
+        //the result of the input programmed a sample ago, or by a direct read since
+        const size_t input = size_t(adc.get_input()) - ads1015_ctrl::ADS1015_CONF_AIN0_GND;
+        if (input < 4)
+        {
+            if (not adc.is_settled()) continue;
+            _sensor_seq_values[bases[n] + input] = adc.read_raw();
+            _sensor_seq_mask |= 1 << (bases[n] + input);
+        }
+
+        //the next input converts until the next sample
+        const size_t next = (input < 4)? (input + 1) % 4 : 0;
+        adc.set_input(ads1015_ctrl::ads1015_input(ads1015_ctrl::ADS1015_CONF_AIN0_GND + next));
+    }
+}
+
+uhd::sensor_value_t umtrx_impl::sensor_from_raw(const size_t slot, const uint16_t mask, const uint16_t *values)
+{
+    //sensors that did not answer read as NaN, like the I2C path
+    const bool ok = (mask & (1 << slot)) != 0;
+    if (slot == UMTRX_SENSORS_TEMP_A or slot == UMTRX_SENSORS_TEMP_B)
+    {
+        const std::string which = (slot == UMTRX_SENSORS_TEMP_A) ? "A" : "B";
+        const double temp = ok ? tmp102_ctrl::raw_to_temp(values[slot]) : std::numeric_limits<double>::quiet_NaN();
+        return uhd::sensor_value_t("Temp"+which, temp, "C");
+    }
+    if (slot < UMTRX_SENSORS_DC_0)
+    {
+        const double val = ok ? _sense_pwr.raw_to_value(values[slot]) * 10 : std::numeric_limits<double>::quiet_NaN();
+        return uhd::sensor_value_t("Voltage"+power_sensors[slot - UMTRX_SENSORS_PWR_0], val, "V");
+    }
+    const double val = ok ? _sense_dc.raw_to_value(values[slot]) * 40 : std::numeric_limits<double>::quiet_NaN();
+    return uhd::sensor_value_t("Voltage"+dc_sensors[slot - UMTRX_SENSORS_DC_0], val, "V");
+}
+
+umtrx_sensor_snapshot_t umtrx_impl::read_sensor_snapshot(void)
+{
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+    umtrx_sensor_snapshot_t snapshot;
+    uint16_t values[UMTRX_SENSORS_NUM];
+    uint16_t mask = _sensors_mask;
+    const bool ok = read_sensors_raw(mask, values);
+
+    for (size_t slot = 0; slot < UMTRX_SENSORS_NUM; slot++)
+    {
+        if ((_sensors_mask & (1 << slot)) == 0) continue;
+        if (ok) snapshot.sensors.push_back(sensor_from_raw(slot, mask, values));
+        else if (slot <= UMTRX_SENSORS_TEMP_B) snapshot.sensors.push_back(read_temp_c((slot == UMTRX_SENSORS_TEMP_A) ? "A" : "B"));
+        else if (slot < UMTRX_SENSORS_DC_0) snapshot.sensors.push_back(read_pa_v(power_sensors[slot - UMTRX_SENSORS_PWR_0]));
+        else snapshot.sensors.push_back(read_dc_v(dc_sensors[slot - UMTRX_SENSORS_DC_0]));
+    }
+    snapshot.time = boost::posix_time::microsec_clock::universal_time();
+    return snapshot;
+}
+
 void umtrx_impl::detect_hw_rev(const fs_path& mb_path)
 {
     //UmTRX v2.0 doesn't have temp sensors
@@ -1059,8 +2286,11 @@ void umtrx_impl::detect_hw_rev(const fs_path& mb_path)
     // Initialize side A temp sensor
     _temp_side_a.init(_iface, tmp102_ctrl::TMP102_SDA);
     _temp_side_a.set_ex_mode(true);
-    _tree->create<sensor_value_t>(mb_path / "sensors" / "tempA")
-        .publish(boost::bind(&umtrx_impl::read_temp_c, this, "A"));
+    _temp_side_a.set_continuous(_temp_rate);
+    _sensors_mask |= 1 << UMTRX_SENSORS_TEMP_A;
+    create_cached_sensor(mb_path / "sensors" / "tempA",
+        boost::bind(&umtrx_impl::read_temp_c, this, "A"));
+    _sensor_slot_paths[UMTRX_SENSORS_TEMP_A] = mb_path / "sensors" / "tempA";
     UHD_MSG(status) << this->read_temp_c("A").to_pp_string() << std::endl;
 
     if (!tmp102_ctrl::check(_iface, tmp102_ctrl::TMP102_SCL)) {
@@ -1070,8 +2300,11 @@ void umtrx_impl::detect_hw_rev(const fs_path& mb_path)
     // Initialize side B temp sensor
     _temp_side_b.init(_iface, tmp102_ctrl::TMP102_SCL);
     _temp_side_b.set_ex_mode(true);
-    _tree->create<sensor_value_t>(mb_path / "sensors" / "tempB")
-        .publish(boost::bind(&umtrx_impl::read_temp_c, this, "B"));
+    _temp_side_b.set_continuous(_temp_rate);
+    _sensors_mask |= 1 << UMTRX_SENSORS_TEMP_B;
+    create_cached_sensor(mb_path / "sensors" / "tempB",
+        boost::bind(&umtrx_impl::read_temp_c, this, "B"));
+    _sensor_slot_paths[UMTRX_SENSORS_TEMP_B] = mb_path / "sensors" / "tempB";
     UHD_MSG(status) << this->read_temp_c("B").to_pp_string() << std::endl;
 
     if (!ads1015_ctrl::check(_iface, ads1015_ctrl::ADS1015_ADDR_VDD)) {
@@ -1080,11 +2313,13 @@ void umtrx_impl::detect_hw_rev(const fs_path& mb_path)
     }
     //Initialize PA sense ADC
     _sense_pwr.init(_iface, ads1015_ctrl::ADS1015_ADDR_VDD);
-    _sense_pwr.set_mode(true);
+    _sense_pwr.set_mode(not _sensor_continuous);
     _sense_pwr.set_pga(ads1015_ctrl::ADS1015_PGA_2_048V);
     for (unsigned i = 0; i < power_sensors.size(); i++) {
-        _tree->create<sensor_value_t>(mb_path / "sensors" / "voltage"+power_sensors[i])
-            .publish(boost::bind(&umtrx_impl::read_pa_v, this, power_sensors[i]));
+        _sensors_mask |= 1 << (UMTRX_SENSORS_PWR_0 + i);
+        create_cached_sensor(mb_path / "sensors" / "voltage"+power_sensors[i],
+            boost::bind(&umtrx_impl::read_pa_v, this, power_sensors[i]));
+        _sensor_slot_paths[UMTRX_SENSORS_PWR_0 + i] = mb_path / "sensors" / "voltage"+power_sensors[i];
         UHD_MSG(status) << this->read_pa_v(power_sensors[i]).to_pp_string() << std::endl;
     }
 
@@ -1093,11 +2328,13 @@ void umtrx_impl::detect_hw_rev(const fs_path& mb_path)
         return;
     }
     _sense_dc.init(_iface, ads1015_ctrl::ADS1015_ADDR_GROUND);
-    _sense_dc.set_mode(true);
+    _sense_dc.set_mode(not _sensor_continuous);
     _sense_dc.set_pga(ads1015_ctrl::ADS1015_PGA_1_024V);
     for (unsigned i = 0; i < power_sensors.size(); i++) {
-        _tree->create<sensor_value_t>(mb_path / "sensors" / "voltage"+dc_sensors[i])
-            .publish(boost::bind(&umtrx_impl::read_dc_v, this, dc_sensors[i]));
+        _sensors_mask |= 1 << (UMTRX_SENSORS_DC_0 + i);
+        create_cached_sensor(mb_path / "sensors" / "voltage"+dc_sensors[i],
+            boost::bind(&umtrx_impl::read_dc_v, this, dc_sensors[i]));
+        _sensor_slot_paths[UMTRX_SENSORS_DC_0 + i] = mb_path / "sensors" / "voltage"+dc_sensors[i];
         UHD_MSG(status) << this->read_dc_v(dc_sensors[i]).to_pp_string() << std::endl;
     }
 
@@ -1156,8 +2393,12 @@ void umtrx_impl::commit_pa_state()
         _iface->poke32(U2_REG_MISC_LMS_RES, LMS1_RESET | LMS2_RESET
                    | PAREG_ENDCSYNC
                    | ((_pa_nlow) ? PAREG_NLOW_PA : 0)
-                   | ((_pa_en1)  ? PAREG_ENPA1 : 0)
-                   | ((_pa_en2)  ? PAREG_ENPA2 : 0));
+                   | ((_pa_en1 and not get_pa_shutdown(0)) ? PAREG_ENPA1 : 0)
+                   | ((_pa_en2 and not get_pa_shutdown(1)) ? PAREG_ENPA2 : 0));
+
+    //the bursts switch a PA only while it is enabled
+    this->update_burst_atr("A");
+    this->update_burst_atr("B");
 }
 
 void umtrx_impl::set_enpa1(bool en)
@@ -1180,6 +2421,7 @@ void umtrx_impl::set_diversity(bool en, int chan)
     // chan 0 has inversed switch polarity
     // chan 1 has straight switch polarity
     _iface->poke32(U2_REG_SR_ADDR(SR_DIVSW+chan), (en != (chan==1)) ? 0 : 1);
+    this->update_burst_atr((chan == 0)? "A" : "B");
 }
 
 const char* umtrx_impl::get_hw_rev() const
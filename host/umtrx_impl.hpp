@@ -29,10 +29,17 @@
 #include "cores/rx_dsp_core_200.hpp"
 #include "cores/tx_dsp_core_200.hpp"
 #include "cores/time64_core_200.hpp"
+#include "umtrx_time_model.hpp"
+#include "umtrx_sensor_history.hpp"
+#include "cores/stream_stats.hpp"
 #include "ads1015_ctrl.hpp"
 #include "tmp102_ctrl.hpp"
 #include "power_amp.hpp"
 #include "umsel2_ctrl.hpp"
+#include "cores/apply_corrections.hpp"
+#include "umtrx_thread_placement.hpp"
+#include "umtrx_async_ring.hpp"
+#include "umtrx_pps_events.hpp"
 #include <uhd/usrp/mboard_eeprom.hpp>
 #include <uhd/property_tree.hpp>
 #include <uhd/device.hpp>
@@ -50,7 +57,9 @@
 #include <uhd/transport/udp_zero_copy.hpp>
 #include <uhd/transport/bounded_buffer.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#ifndef UMTRX_EMBEDDED
 #include <boost/property_tree/json_parser.hpp>
+#endif
 #include <uhd/types/ranges.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/utils/static.hpp>
@@ -61,11 +70,89 @@
 #include <boost/weak_ptr.hpp>
 #include <boost/asio.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <map>
+#include <list>
 #include <uhd/utils/tasks.hpp>
 
 
+class flow_control_monitor;
+class umtrx_tx_async_loop;
+class umtrx_status_session;
+
 // Halfthe size of USRP2 SRAM, because we split the same SRAM into buffers for two Tx channels instead of one.
 static const size_t UMTRX_SRAM_BYTES = size_t(1 << 19);
+// Number of SRAM lines shared by both Tx channels, see SR_SRAM_SPLIT.
+static const size_t UMTRX_SRAM_WORDS = size_t(1 << 19);
+// First FPGA minor version with a configurable SRAM split between Tx channels.
+static const boost::uint16_t UMTRX_FPGA_SRAM_SPLIT_MINOR = 4;
+// First FPGA minor version accepting several commands per settings fifo packet.
+static const boost::uint16_t UMTRX_FPGA_MULTI_CMD_MINOR = 5;
+// First FPGA minor version with the fractional decimator in the DDC chains.
+static const boost::uint16_t UMTRX_FPGA_FRAC_RESAMP_MINOR = 6;
+// First FPGA minor version with the averaged power readback per RX DSP.
+static const boost::uint16_t UMTRX_FPGA_RX_POWER_MINOR = 7;
+// First FPGA minor version with a settable DC tracking time constant in the RX frontends.
+static const boost::uint16_t UMTRX_FPGA_DC_TRACK_MINOR = 8;
+// First FPGA minor version with the timed frequency hop tables in the DSP chains.
+static const boost::uint16_t UMTRX_FPGA_HOP_TABLE_MINOR = 9;
+// First FPGA minor version sending statistics context packets in the RX streams.
+static const boost::uint16_t UMTRX_FPGA_RX_STATS_MINOR = 10;
+// First FPGA minor version reporting the Rx buffering, see U2_REG_RX_BUFFER_RB.
+static const boost::uint16_t UMTRX_FPGA_RX_SRAM_MINOR = 11;
+// First FPGA minor version latching the time hi word on a lo peek, see U2_REG_TIME64_HI_RB_SNAPSHOT.
+static const boost::uint16_t UMTRX_FPGA_TIME_SNAPSHOT_MINOR = 12;
+// First FPGA minor version with the idle fill between TX bursts, see tx_dsp_core_200::set_idle_fill.
+static const boost::uint16_t UMTRX_FPGA_TX_IDLE_FILL_MINOR = 13;
+// First FPGA minor version replaying the TX SRAM in a loop, see U2_REG_TX_LOOP.
+static const boost::uint16_t UMTRX_FPGA_TX_LOOP_MINOR = 14;
+// First FPGA minor version with the digital TX to RX loopback, see U2_REG_LOOPBACK.
+static const boost::uint16_t UMTRX_FPGA_LOOPBACK_MINOR = 15;
+// First FPGA minor version with the network link test on DSP0, see U2_REG_LINK_TEST.
+static const boost::uint16_t UMTRX_FPGA_LINK_TEST_MINOR = 16;
+// First FPGA minor version that sends PAUSE frames and counts them, see U2_REG_ETH_MAC_SETTINGS.
+static const boost::uint16_t UMTRX_FPGA_ETH_PAUSE_MINOR = 17;
+// First FPGA minor version with the strict priority control lane in the router output.
+static const boost::uint16_t UMTRX_FPGA_CTRL_PRIO_MINOR = 18;
+// First FPGA minor version with the TDMA timeslot gate in the RX chains, see SR_RX_GATE0.
+static const boost::uint16_t UMTRX_FPGA_RX_GATE_MINOR = 19;
+// First FPGA minor version with the FIR channel filter in the DDC chains, see SR_RX_FIR0.
+static const boost::uint16_t UMTRX_FPGA_RX_FIR_MINOR = 20;
+// First FPGA minor version with the GMSK modulator in the TX chains, see SR_TX_MOD0.
+static const boost::uint16_t UMTRX_FPGA_TX_GMSK_MINOR = 21;
+// First FPGA minor version with the capability word, see U2_REG_CAPS_RB.
+static const boost::uint16_t UMTRX_FPGA_CAPS_MINOR = 22;
+// First FPGA minor version packing the results of up to 8 commands of a packet into one ack.
+static const boost::uint16_t UMTRX_FPGA_ACK_PACK_MINOR = 23;
+// First FPGA minor version with the deep fifo ctrl command queue, see U2_REG_CTRL_QUEUE_RB.
+static const boost::uint16_t UMTRX_FPGA_CTRL_QUEUE_MINOR = 24;
+// First FPGA minor version with the deep RX stream command queues, see U2_REG_RX_CMD_QUEUE_RB.
+static const boost::uint16_t UMTRX_FPGA_RX_CMD_QUEUE_MINOR = 25;
+// First FPGA minor version sending the 802.1Q tag of a framer, see UMTRX_FW_STREAM_QOS_MINOR.
+static const boost::uint16_t UMTRX_FPGA_VLAN_MINOR = 26;
+// First FPGA minor version with the TX late packet policy and counters, see U2_REG_TX_COUNTERS_RB.
+static const boost::uint16_t UMTRX_FPGA_TX_LATE_MINOR = 27;
+// First FPGA minor version with the RX tone meters, see U2_FLAG_CAPS_RX_TONE.
+static const boost::uint16_t UMTRX_FPGA_RX_TONE_MINOR = 28;
+// First FPGA minor version with the second RX CIC, decimations up to 4096.
+static const boost::uint16_t UMTRX_FPGA_RX_CIC2_MINOR = 29;
+// First FPGA minor version with the TX burst ramps, see U2_FLAG_CAPS_TX_RAMP.
+static const boost::uint16_t UMTRX_FPGA_TX_RAMP_MINOR = 30;
+// First FPGA minor version that counts the ethernet frames, see U2_REG_ETH_MAC_RX_FRAMES_RB.
+static const boost::uint16_t UMTRX_FPGA_ETH_STATS_MINOR = 31;
+// First FPGA minor version with the RX AGC and its gain change packets, see U2_FLAG_CAPS_RX_AGC.
+static const boost::uint16_t UMTRX_FPGA_RX_AGC_MINOR = 32;
+// First FPGA minor version gating the PA enables and diversity switches by the bursts, see U2_FLAG_CAPS_BURST_ATR.
+static const boost::uint16_t UMTRX_FPGA_BURST_ATR_MINOR = 33;
+// First FPGA minor version filling in the checksums of the firmware packets, the firmware finds it in the router status.
+static const boost::uint16_t UMTRX_FPGA_FW_CHKSUM_MINOR = 34;
+// Stream commands an RX DSP queues from that version on, 16 before.
+static const size_t UMTRX_RX_CMD_QUEUE_LINES = (1 << 8) - 2;
+// On-chip fifo of a DSP chain with the default FIFOSIZE of 9, one sample per line.
+static const size_t UMTRX_DSP_FIFO_BYTES = size_t(4 << 9);
+// Largest data frame with jumbo=1, UDP payload bytes. Needs an RX_FIFOSIZE 11 (JUMBO_FRAMES) image for RX.
+static const size_t UMTRX_JUMBO_FRAME_BYTES = 8000;
 static const double UMTRX_LINK_RATE_BPS = 1000e6/8;
 
 //framer indexes for use with make_xport()
@@ -89,6 +176,35 @@ static const boost::uint32_t UMTRX_DSP_RX1_SID = 0x21;
 static const boost::uint32_t UMTRX_DSP_RX2_SID = 0x22;
 static const boost::uint32_t UMTRX_DSP_RX3_SID = 0x23;
 
+//by DSP number, the image reports how many chains it has in U2_REG_NUM_DDC and U2_REG_NUM_DUC
+static const size_t UMTRX_MAX_DDC = 4;
+static const size_t UMTRX_MAX_DUC = 2;
+static const size_t UMTRX_DSP_RX_FRAMERS[UMTRX_MAX_DDC] = {UMTRX_DSP_RX0_FRAMER, UMTRX_DSP_RX1_FRAMER, UMTRX_DSP_RX2_FRAMER, UMTRX_DSP_RX3_FRAMER};
+static const boost::uint32_t UMTRX_DSP_RX_SIDS[UMTRX_MAX_DDC] = {UMTRX_DSP_RX0_SID, UMTRX_DSP_RX1_SID, UMTRX_DSP_RX2_SID, UMTRX_DSP_RX3_SID};
+static const size_t UMTRX_DSP_TX_FRAMERS[UMTRX_MAX_DUC] = {UMTRX_DSP_TX0_FRAMER, UMTRX_DSP_TX1_FRAMER};
+static const boost::uint32_t UMTRX_DSP_TX_SIDS[UMTRX_MAX_DUC] = {UMTRX_DSP_TX0_SID, UMTRX_DSP_TX1_SID};
+
+//! board sensors sampled together, see mb_path/sensor_snapshot
+struct umtrx_sensor_snapshot_t{
+    boost::posix_time::ptime time; //host time when the samples arrived
+    std::vector<uhd::sensor_value_t> sensors;
+};
+
+//! DSP readbacks sampled together in one round trip, see mb_path/dsp_status
+struct umtrx_dsp_status_t{
+    uhd::time_spec_t time; //device time of the readback
+    std::vector<double> rx_power; //dBFS per RX DSP, empty without the power readback
+    std::vector<size_t> rx_cmd_queue; //stream commands waiting per RX DSP, empty without the queue
+    std::vector<boost::uint32_t> tx_counters; //per TX DSP, as stats/device_counters, empty without them
+};
+
+//! sensor readings refreshed by the status monitor, replaced as a whole
+struct umtrx_sensor_cache_t{
+    boost::posix_time::ptime time;
+    umtrx_sensor_snapshot_t board;
+    std::map<std::string, uhd::sensor_value_t> sensors; //keyed by property path
+};
+
 //! load and store for umtrx mboard eeprom map
 void load_umtrx_eeprom(uhd::usrp::mboard_eeprom_t &mb_eeprom, uhd::i2c_iface &iface);
 void store_umtrx_eeprom(const uhd::usrp::mboard_eeprom_t &mb_eeprom, uhd::i2c_iface &iface);
@@ -98,17 +214,20 @@ void store_umtrx_eeprom(const uhd::usrp::mboard_eeprom_t &mb_eeprom, uhd::i2c_if
  * The implementation details are encapsulated here.
  * Handles device properties and streaming...
  */
-class umtrx_impl : public uhd::device {
+class umtrx_impl : public uhd::device, public umtrx_pps_events {
 public:
     umtrx_impl(const uhd::device_addr_t &);
     ~umtrx_impl(void);
 
     //the io interface
-    typedef uhd::transport::bounded_buffer<uhd::async_metadata_t> async_md_type;
     uhd::rx_streamer::sptr get_rx_stream(const uhd::stream_args_t &args);
     uhd::tx_streamer::sptr get_tx_stream(const uhd::stream_args_t &args);
     bool recv_async_msg(uhd::async_metadata_t &, double);
-    boost::shared_ptr<async_md_type> _old_async_queue;
+
+    //the PPS events, see umtrx_monitor.cpp
+    size_t add_pps_callback(const callback_type &callback);
+    void remove_pps_callback(const size_t id);
+    bool recv_pps_event(event_type &event, const double timeout);
 
 private:
     enum umtrx_hw_rev {
@@ -160,9 +279,29 @@ private:
 
     //communication interfaces
     std::string _device_ip_addr;
+    uhd::device_addr_t _xport_args; //device args used as transport hints
+    size_t _recv_mtu, _send_mtu; //probed at open, the default data frame sizes
+    double _link_rate_bps; //negotiated link rate, the limit for the host rates
+    std::vector<size_t> _tx_sram_bytes; //per Tx DSP share of the SRAM, or the on-chip fifo
+    std::vector<size_t> _rx_sram_bytes; //per Rx DSP share of the SRAM, zero unless Rx is buffered there
+    size_t _rx_fifo_bytes; //on-chip fifo of each Rx DSP
+    bool _tx_idle_fill; //the fpga can fill the TX gaps, see tx_dsp_core_200::set_idle_fill
+    bool _tx_late_policy; //the fpga takes a late policy and counts late packets, see tx_dsp_core_200::set_late_policy
+    size_t _num_duc; //TX chains in the image, _tx_dsps has a stand-in when there are none
+    boost::uint32_t _fpga_caps; //U2_REG_CAPS_RB, or made up from the version of older images
+    boost::uint32_t read_fpga_caps(const boost::uint16_t fpga_minor);
+    bool _framer_dscp, _framer_vlan; //the firmware takes the qos word, the fpga sends the tag
+    bool _framer_dest; //the firmware points a framer at another destination than the sender
+    boost::uint32_t get_stream_qos(const size_t which, const uhd::device_addr_t &args) const;
+    boost::uint32_t _tx_loop_bits; //U2_REG_TX_LOOP
+    void set_tx_loop(const size_t dsp, const std::string &mode);
+    void setup_sram_split(const uhd::device_addr_t &device_addr, const boost::uint16_t fpga_minor);
     umtrx_iface::sptr _iface;
     umtrx_fifo_ctrl::sptr _ctrl;
+    double _teardown_timeout; //seconds per control ack at the teardown
     umsel2_ctrl::sptr _umsel2;
+    bool _umsel_pingpong; //both synths serve front end A, one of them is tuned ahead
+    int _umsel_active; //the synth on air in ping-pong mode
 
     //controls for perifs
     uhd::dict<std::string, lms6002d_ctrl::sptr> _lms_ctrl;
@@ -175,6 +314,7 @@ private:
     std::vector<rx_dsp_core_200::sptr> _rx_dsps;
     std::vector<tx_dsp_core_200::sptr> _tx_dsps;
     time64_core_200::sptr _time64;
+    umtrx_time_model::sptr _time_model;
 
     //helper routines
     void set_mb_eeprom(const uhd::i2c_iface::sptr &, const uhd::usrp::mboard_eeprom_t &);
@@ -185,15 +325,40 @@ private:
     void update_tx_subdev_spec(const uhd::usrp::subdev_spec_t &);
     void update_clock_source(const std::string &);
     void update_rx_samp_rate(const size_t, const double rate);
+    void issue_rx_stream_windows(const size_t dspno, const std::vector<rx_dsp_window_t> &windows);
+    void set_rx_combine(const size_t dspno, const std::vector<std::complex<double> > &weights);
+    void update_rx_agc(const std::string &fe_name, const bool load_gain);
+    uhd::sensor_value_t read_rx_agc_gain(const std::string &fe_name);
+    void update_burst_atr(const std::string &fe_name);
     void update_tx_samp_rate(const size_t, const double rate);
-    void time64_self_test(void);
+    void set_rx_low_latency(const size_t dsp, const bool enb);
+    void set_tx_low_latency(const size_t dsp, const bool enb);
+    void time64_self_test(const uhd::device_addr_t &device_addr);
     void update_rates(void);
     void set_rx_fe_corrections(const std::string &mb, const std::string &board, const double);
     void set_tx_fe_corrections(const std::string &mb, const std::string &board, const double);
+
+    //frontend corrections precomputed for a list of LOs, applied in the retune batch
+    typedef std::map<double, uhd::usrp::fe_corrections_t> fe_correction_plan_t;
+    uhd::dict<std::string, fe_correction_plan_t> _rx_fe_plan, _tx_fe_plan;
+    boost::mutex _fe_plan_mutex;
+    void set_rx_fe_correction_plan(const std::string &which, const std::vector<double> &lo_freqs);
+    void set_tx_fe_correction_plan(const std::string &which, const std::vector<double> &lo_freqs);
+    static bool get_planned_fe_corrections(const fe_correction_plan_t &plan, const double lo_freq, uhd::usrp::fe_corrections_t &corr);
+    void apply_planned_fe_corrections(const std::string &which, const bool is_tx, const double lo_freq);
+    double get_fe_temperature(const std::string &which);
+    void fe_temperature_update(const umtrx_sensor_cache_t &cache);
+    std::map<std::string, double> _fe_cal_temp; //degC the corrections of a side were last looked up at
+    double _fe_cal_temp_step;
     void set_tcxo_dac(const umtrx_iface::sptr &, const uint16_t val);
     void detect_hw_rev(const uhd::fs_path &mb_path);
     void detect_hw_dcdc_ver(const uhd::fs_path &mb_path);
     void commit_pa_state();
+
+    //configuration snapshot for a fast restart, see umtrx_state.cpp
+    void save_state(const std::string &path);
+    void restore_state(const std::string &path);
+    std::string _state_file; //restored at open, saved at close
     void set_enpa1(bool en);
     void set_enpa2(bool en);
     void set_nlow(bool en);
@@ -204,10 +369,19 @@ private:
     double set_tx_power(double power, const std::string &which);
     double set_pa_power(double power, const std::string &which);
     uint16_t get_tcxo_dac(const umtrx_iface::sptr &);
-    uhd::transport::zero_copy_if::sptr make_xport(const size_t which, const uhd::device_addr_t &args);
+    uhd::transport::zero_copy_if::sptr make_xport(const size_t which, const uhd::device_addr_t &args, stream_stats_t::sptr stats = stream_stats_t::sptr());
+    uhd::transport::zero_copy_if::sptr get_stream_xport(const size_t which, const uhd::device_addr_t &args, stream_stats_t::sptr stats = stream_stats_t::sptr());
+    //per framer, the transport of the last streamer and the args it was made with
+    struct pooled_xport_t
+    {
+        uhd::transport::zero_copy_if::sptr xport;
+        std::string args;
+    };
+    uhd::dict<size_t, pooled_xport_t> _xport_pool;
     std::complex<double> get_dc_offset_correction(const std::string &which) const;
     void set_dc_offset_correction(const std::string &which, const std::complex<double> &corr);
     double set_rx_freq(const std::string &which, const double freq);
+    double set_tx_freq(const std::string &which, const double freq);
     uhd::freq_range_t get_rx_freq_range(const std::string &which) const;
 
     // Find a dcdc_r value to approximate requested Vout voltage
@@ -220,25 +394,168 @@ private:
     uhd::sensor_value_t read_temp_c(const std::string &which);
     uhd::sensor_value_t read_pa_v(const std::string &which);
     uhd::sensor_value_t read_dc_v(const std::string &which);
+    uhd::sensor_value_t read_rx_power(const size_t dspno);
+    uhd::sensor_value_t read_rx_tone(const size_t dspno);
+    size_t set_rx_tone_length(const size_t dspno, const size_t num_samps);
+    std::vector<size_t> _rx_tone_length; //zero while the power readback is the averaged power
+    uhd::sensor_value_t read_rx_cmd_queue(const size_t dspno);
+    void flush_rx_dsps(const bool cmd_queue_rb);
+    umtrx_dsp_status_t read_dsp_status(void);
+    bool _dsp_status_time_snapshot, _dsp_status_rx_power, _dsp_status_rx_cmd_queue; //readbacks the image has
+    uhd::sensor_value_t read_fw_ctrl_latency(void);
+    uhd::sensor_value_t read_ctrl_queue(void);
+    void set_loopback(const bool enb);
+    void set_link_test(const std::string &mode);
+    void set_eth_pause(const std::string &mode);
+    void set_rx_dc_offset_mode(const uhd::fs_path &rx_fe_path, const std::string &mode);
     boost::recursive_mutex _i2c_mutex;
 
+    //all sensors in one firmware request, when the firmware supports it
+    umtrx_sensor_snapshot_t read_sensor_snapshot(void);
+    bool read_sensors_raw(uint16_t &mask, uint16_t *values);
+    uhd::sensor_value_t sensor_from_raw(const size_t slot, const uint16_t mask, const uint16_t *values);
+    uint16_t _sensors_mask; //UMTRX_SENSORS_* found by detect_hw_rev
+    bool _sensors_snapshot;
+
+    //ADS1015s in continuous mode, the monitor steps their mux once per sample
+    void sensor_sequencer_step(void);
+    uint16_t read_adc_settled(ads1015_ctrl &adc, const size_t base, const size_t input);
+    bool _sensor_continuous;
+    uint16_t _sensor_seq_mask; //ADC slots held in _sensor_seq_values
+    uint16_t _sensor_seq_values[UMTRX_SENSORS_NUM];
+    tmp102_ctrl::conversion_rate _temp_rate;
+
     //status monitoring
     void status_monitor_start(const uhd::device_addr_t &device_addr);
     void status_monitor_stop(void);
     uhd::task::sptr _status_monitor_task;
     void status_monitor_handler(void);
 
+    //GPSDO telemetry pushed by the firmware after every PPS
+    void gpsdo_telemetry_start(const uhd::device_addr_t &device_addr, const uhd::fs_path &mb_path);
+    void gpsdo_telemetry_handler(void);
+    uhd::sensor_value_t get_gpsdo_sensor(const std::string &which);
+    uhd::transport::udp_simple::sptr _gpsdo_xport;
+    uhd::task::sptr _gpsdo_task;
+    boost::mutex _gpsdo_mutex;
+    umtrx_gpsdo_telemetry_t _gpsdo_telemetry; //host byte order
+    boost::posix_time::ptime _gpsdo_time; //when the last report arrived, not_a_date_time before
+    bool _gpsdo_pps_flag; //the firmware flags the PPS edges without a valid measurement
+    event_type _pps_event; //of the last report
+    size_t _pps_event_count; //reports since the start, under the gpsdo mutex
+    boost::condition_variable _pps_event_cond;
+    boost::recursive_mutex _pps_callbacks_mutex; //held while the callbacks run
+    std::map<size_t, callback_type> _pps_callbacks;
+    size_t _pps_callback_next;
+
+    //ethernet MAC counters, all of them come in one control round trip
+    void eth_stats_start(const uhd::fs_path &mb_path);
+    uhd::sensor_value_t get_eth_stat(const size_t which);
+    std::vector<boost::uint32_t> read_eth_stats(void);
+    void format_eth_metrics(std::ostream &os);
+    boost::mutex _eth_stats_mutex;
+    std::vector<boost::uint32_t> _eth_stats; //last read, empty without the counters
+    boost::posix_time::ptime _eth_stats_time; //not_a_date_time without the counters
+
+    //sensor properties are served from the cache the monitor refreshes
+    void create_cached_sensor(const uhd::fs_path &path, const boost::function<uhd::sensor_value_t(void)> &read);
+    void update_sensor_cache(void);
+    boost::shared_ptr<const umtrx_sensor_cache_t> get_sensor_cache(void);
+    uhd::sensor_value_t get_cached_sensor(const std::string &path);
+    umtrx_sensor_snapshot_t get_cached_snapshot(void);
+    double get_sensor_age(const std::string &path);
+    void expire_cached_sensor(const std::string &path);
+    bool is_sensor_expired(const std::string &path, const boost::posix_time::ptime &cache_time);
+    double _sensor_poll_period;
+    std::map<std::string, boost::function<uhd::sensor_value_t(void)> > _sensor_readers;
+    std::vector<std::string> _sensor_slot_paths; //property path per UMTRX_SENSORS_* slot
+    std::map<std::string, boost::posix_time::ptime> _sensor_expired; //reads skip caches older than this
+    boost::mutex _sensor_expired_mutex;
+    boost::shared_ptr<const umtrx_sensor_cache_t> _sensor_cache;
+    umtrx_sensor_history::sptr _sensor_history; //of every sample, NULL with sensor_history=0
+
+    //thermal and VSWR protection of the PAs, run after each sensor sample
+    struct protection_side_t{
+        bool temp_tripped;
+        bool temp_shutdown;
+        bool vswr_tripped;
+        double backoff; //dB
+    };
+    void protection_setup(const uhd::device_addr_t &device_addr, const uhd::fs_path &mb_path);
+    void protection_update(const umtrx_sensor_cache_t &cache);
+    double set_pa_power_limited(double power, const std::string &which);
+    bool get_pa_shutdown(const size_t side) const;
+    uhd::sensor_value_t get_protection_state(const size_t side);
+    bool _prot_enabled;
+    double _prot_temp_max, _prot_temp_shutdown, _prot_temp_hyst;
+    double _prot_vswr_max, _prot_vswr_hyst, _prot_vswr_min_pf;
+    double _prot_backoff_step;
+    double _vswr_calibration, _vswr_coef;
+    protection_side_t _prot_state[2];
+    double _pa_power_requested; //PA power last asked through set_tx_power
+    std::string _pa_power_side;
+    double _pa_power_backoff; //dB currently applied
+
+    //closed loop Tx power from the forward power detectors, run after the protection
+    void power_loop_update(const umtrx_sensor_cache_t &cache);
+    uhd::sensor_value_t get_power_loop_trim(void);
+    bool _pa_loop_enabled;
+    double _pa_loop_step, _pa_loop_deadband, _pa_loop_max_trim;
+    double _pa_loop_min_pf, _pa_loop_offset;
+    double _pa_loop_trim; //dB, on the PA power or on VGA2 below the PA range
+    double _tx_power_target; //Tx power last asked through set_tx_power
+    double _tx_vga2_base; //VGA2 set by set_tx_power
+
+#ifndef UMTRX_EMBEDDED
     //tcp query server
     uhd::task::sptr _server_query_task;
     void server_query_handler(void);
     boost::asio::io_service _server_query_io_service;
     boost::shared_ptr<boost::asio::ip::tcp::acceptor> _server_query_tcp_acceptor;
-    void client_query_handle(boost::shared_ptr<boost::asio::ip::tcp::socket>);
+    std::list<boost::weak_ptr<umtrx_status_session> > _server_sessions; //only touched on the server thread
+    void server_query_accept(void);
+    void server_query_accepted(boost::shared_ptr<umtrx_status_session> session, const boost::system::error_code &ec);
+    void server_push_deltas(boost::shared_ptr<const umtrx_sensor_cache_t> cache);
     void client_query_handle1(const boost::property_tree::ptree &request, boost::property_tree::ptree &response);
+    void client_query_binary(const std::string &request, std::string &response);
+#endif
 
     //streaming
     std::vector<UMTRX_UHD_PTR_NAMESPACE::weak_ptr<uhd::rx_streamer> > _rx_streamers;
     std::vector<UMTRX_UHD_PTR_NAMESPACE::weak_ptr<uhd::tx_streamer> > _tx_streamers;
+    std::vector<stream_stats_t::sptr> _rx_stream_stats, _tx_stream_stats; //per dsp, kept across streamers
+
+    //thread placement from the device args
+    umtrx_thread_placement _tx_async_placement;
+    boost::shared_ptr<umtrx_tx_async_loop> _tx_async_loop; //flow control and msgs of all tx channels
+    umtrx_async_ring::sptr _async_ring; //tx async msgs, each streamer reads its own tag
+    umtrx_async_ring::cursor::sptr _old_async_cursor; //every msg, for the device recv_async_msg()
+    std::vector<int> _rx_convert_cpus;
+    int _rt_priority;
+    std::string get_stream_metrics(void);
+
+    //tx flow control settings per dsp, the window follows the sample rate in latency mode
+    struct tx_fc_state_t
+    {
+        tx_fc_state_t(void): max_window(0), spp(0), ups_per_sec(0.0), ups_per_fifo(0.0), latency_target(0.0), samp_rate(0.0),
+            adaptive(false), adaptive_margin(0.0){}
+        boost::weak_ptr<flow_control_monitor> monitor;
+        size_t max_window; //packets, limited by the SRAM share
+        size_t spp;
+        double ups_per_sec;
+        double ups_per_fifo;
+        double latency_target; //seconds, 0 to disable
+        double samp_rate; //last host rate applied to the window
+        bool adaptive; //the acks size the window below max_window
+        double adaptive_margin; //seconds on top of the measured ack interval
+    };
+    std::vector<tx_fc_state_t> _tx_fc_state;
+    boost::mutex _tx_fc_mutex;
+    void update_tx_fc_window(const size_t dsp, const double rate);
+    size_t get_tx_fc_window(const size_t dsp, const uhd::device_addr_t &args, const size_t frame_size) const;
+    uhd::sensor_value_t get_tx_fc_in_flight(const size_t dsp);
+    uhd::sensor_value_t get_tx_fc_latency(const size_t dsp);
+    uhd::sensor_value_t get_tx_fc_ack_latency(const size_t dsp);
     boost::mutex _setupMutex;
 };
 
@@ -17,7 +17,17 @@
 //
 
 #include "umtrx_impl.hpp"
+#include "umtrx_async_log.hpp"
 #include "umtrx_regs.hpp"
+#include "umtrx_mmsg_zero_copy.hpp"
+#include "umtrx_packet_mmap_zero_copy.hpp"
+#include "umtrx_packet_tx_ring_zero_copy.hpp"
+#include "umtrx_sid_demux.hpp"
+#include "umtrx_rx_channelizer.hpp"
+#include "umtrx_tx_burst_queue.hpp"
+#include "umtrx_if_hdr.hpp"
+#include "umtrx_frame_pool.hpp"
+#include "umtrx_host_check.hpp"
 #include "usrp2/fw_common.h"
 #include "cores/validate_subdev_spec.hpp"
 #include "cores/async_packet_handler.hpp"
@@ -27,15 +37,39 @@
 #include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/chrono.hpp>
+#include <sstream>
+#include <cmath>
 #ifdef THREAD_PRIORITY_HPP_DEPRECATED
 #  include <uhd/utils/thread.hpp>
 #else // THREAD_PRIORITY_HPP_DEPRECATED
 #  include <uhd/utils/thread_priority.hpp>
 #endif // THREAD_PRIORITY_HPP_DEPRECATED
 
+#ifndef UMTRX_EMBEDDED
 //A reasonable number of frames for send/recv and async/sync
 static const size_t DEFAULT_NUM_FRAMES = 32;
 
+//Stream buffering: the socket holds buffer_time seconds of the stream,
+//the frames a fraction of it, within these bounds
+static const double DEFAULT_BUFFER_TIME = 0.5;
+static const double FRAMES_BUFFER_FRACTION = 1.0/16;
+static const size_t MAX_NUM_FRAMES = 4096;
+static const double MIN_RECV_BUFF_SIZE = 1e6;
+static const double MAX_RECV_BUFF_SIZE = 50e6;
+#else
+//the embedded profile budgets a few MB per stream, buffer_time still raises it to the caps
+static const size_t DEFAULT_NUM_FRAMES = 16;
+static const double DEFAULT_BUFFER_TIME = 0.1;
+static const double FRAMES_BUFFER_FRACTION = 1.0/16;
+static const size_t MAX_NUM_FRAMES = 512;
+static const double MIN_RECV_BUFF_SIZE = 256e3;
+static const double MAX_RECV_BUFF_SIZE = 4e6;
+#endif
+
 using namespace uhd;
 using namespace uhd::usrp;
 using namespace uhd::transport;
@@ -48,6 +82,62 @@ static UHD_INLINE pt::time_duration to_time_dur(double timeout){
     return pt::microseconds(long(timeout*1e6));
 }
 
+//! Frames for seconds of a stream of bytes_per_sec, at least the default
+static size_t buffer_frames(const double bytes_per_sec, const double seconds, const size_t frame_size)
+{
+    const double frames = std::ceil(bytes_per_sec*seconds/frame_size);
+    return size_t(std::min<double>(MAX_NUM_FRAMES, std::max<double>(DEFAULT_NUM_FRAMES, frames)));
+}
+
+/*!
+ * The host_check stream arg: warn about the host settings that would drop
+ * the stream, with the command that fixes each. See umtrx_host_check.
+ */
+static void warn_host_check(const std::string &device_ip, const device_addr_t &args, const size_t frame_size)
+{
+    umtrx_host_check::requirements_t req;
+    req.recv_buff_size = size_t(args.cast<double>("recv_buff_size", 0));
+    req.frame_size = frame_size;
+    req.stream_cpu = args.cast<int>("convert_cpu", -1);
+    std::string iface = args.get("xport_iface", "");
+    if (iface.empty()) try
+    {
+        const boost::asio::ip::address_v4::bytes_type ip = boost::asio::ip::address_v4::from_string(device_ip).to_bytes();
+        boost::uint32_t addr;
+        std::memcpy(&addr, &ip[0], sizeof(addr));
+        iface = umtrx_frame_pool::find_iface(addr);
+    }
+    catch (const std::exception &) {} //only the host wide checks then
+
+    BOOST_FOREACH(const umtrx_host_check::finding_t &finding, umtrx_host_check::run(iface, req))
+    {
+        if (finding.ok) continue;
+        UHD_MSG(warning) << boost::format("Host check %s: %s\nFix: %s") % finding.item % finding.detail % finding.remedy << std::endl;
+    }
+}
+
+/*!
+ * The word order of the data packets of a stream, the otw_endian stream arg:
+ * auto takes little-endian words on a little-endian host when the image can,
+ * so the header and the converters need no byteswap. The args get the
+ * resolved order for the DSP setup.
+ */
+static bool resolve_otw_endian(stream_args_t &args, const boost::uint32_t caps)
+{
+    const std::string endian = args.args.get("otw_endian", "auto");
+    const bool can_le = (caps & U2_FLAG_CAPS_LE_FRAMING) != 0 and args.otw_format != "gmsk" and args.otw_format != "bfp8";
+    bool le = false;
+    if (endian == "le")
+    {
+        if (not can_le) throw uhd::value_error("This FPGA image or otw_format has no otw_endian=le");
+        le = true;
+    }
+    else if (endian == "auto") le = can_le and uhd::htowx(boost::uint32_t(1)) == 1;
+    else if (endian != "be") throw uhd::value_error("otw_endian is auto, be or le, not " + endian);
+    args.args["otw_endian"] = le? "le" : "be";
+    return le;
+}
+
 /***********************************************************************
  * constants
  **********************************************************************/
@@ -109,9 +199,15 @@ void umtrx_impl::update_rx_samp_rate(const size_t dsp, const double rate)
         UMTRX_UHD_PTR_NAMESPACE::dynamic_pointer_cast<sph::recv_packet_streamer>(_rx_streamers[dsp].lock());
     if (not my_streamer) return;
 
-    my_streamer->set_samp_rate(rate);
+    //a timed rate change switches the streamer at the first packet of the new rate
     const double adj = _rx_dsps[dsp]->get_scaling_adjustment();
-    my_streamer->set_scale_factor(adj);
+    const time_spec_t cmd_time = _ctrl->get_time();
+    if (cmd_time != time_spec_t(0.0)) my_streamer->set_samp_rate_at(cmd_time, rate, adj);
+    else
+    {
+        my_streamer->set_samp_rate(rate);
+        my_streamer->set_scale_factor(adj);
+    }
 }
 
 void umtrx_impl::update_tx_samp_rate(const size_t dsp, const double rate)
@@ -120,9 +216,29 @@ void umtrx_impl::update_tx_samp_rate(const size_t dsp, const double rate)
         UMTRX_UHD_PTR_NAMESPACE::dynamic_pointer_cast<sph::send_packet_streamer>(_tx_streamers[dsp].lock());
     if (not my_streamer) return;
 
-    my_streamer->set_samp_rate(rate);
+    //a timed rate change switches the streamer at the first send stamped at its time
     const double adj = _tx_dsps[dsp]->get_scaling_adjustment();
-    my_streamer->set_scale_factor(adj);
+    const time_spec_t cmd_time = _ctrl->get_time();
+    if (cmd_time != time_spec_t(0.0)) my_streamer->set_samp_rate_at(cmd_time, rate, adj);
+    else
+    {
+        my_streamer->set_samp_rate(rate);
+        my_streamer->set_scale_factor(adj);
+    }
+    this->update_tx_fc_window(dsp, rate);
+}
+
+//the halfbands are picked with the rate, so the rate is set again
+void umtrx_impl::set_rx_low_latency(const size_t dsp, const bool enb)
+{
+    _rx_dsps[dsp]->set_low_latency(enb);
+    _tree->access<double>(fs_path("/mboards/0/rx_dsps") / str(boost::format("%u") % dsp) / "rate" / "value").update();
+}
+
+void umtrx_impl::set_tx_low_latency(const size_t dsp, const bool enb)
+{
+    _tx_dsps[dsp]->set_low_latency(enb);
+    _tree->access<double>(fs_path("/mboards/0/tx_dsps") / str(boost::format("%u") % dsp) / "rate" / "value").update();
 }
 
 void umtrx_impl::update_tick_rate(const double rate)
@@ -147,7 +263,8 @@ void umtrx_impl::update_tick_rate(const double rate)
 /***********************************************************************
  * Transport creation and framer programming
  **********************************************************************/
-static void program_stream_dest(zero_copy_if::sptr &xport, const size_t which)
+static void program_stream_dest(zero_copy_if::sptr &xport, const size_t which, const boost::uint32_t qos,
+    const boost::uint32_t dst_addr = 0, const boost::uint16_t dst_port = 0)
 {
     //perform an initial flush of transport
     while (xport->get_recv_buff(0.0)){}
@@ -157,6 +274,9 @@ static void program_stream_dest(zero_copy_if::sptr &xport, const size_t which)
     stream_ctrl.sequence = uhd::htonx(boost::uint32_t(0 /* don't care seq num */));
     stream_ctrl.vrt_hdr = uhd::htonx(boost::uint32_t(USRP2_INVALID_VRT_HEADER));
     stream_ctrl.which = uhd::htonx(boost::uint32_t(which));
+    stream_ctrl.qos = uhd::htonx(qos);
+    stream_ctrl.dst_addr = uhd::htonx(dst_addr);
+    stream_ctrl.dst_port = uhd::htonx(boost::uint32_t(dst_port));
 
     //send the partial stream control without destination
     managed_send_buffer::sptr send_buff = xport->get_send_buff();
@@ -164,7 +284,72 @@ static void program_stream_dest(zero_copy_if::sptr &xport, const size_t which)
     send_buff->commit(sizeof(stream_ctrl));
 }
 
-uhd::transport::zero_copy_if::sptr umtrx_impl::make_xport(const size_t which, const uhd::device_addr_t &args)
+/*!
+ * Where an RX framer sends instead of the stream ctrl sender: dst_addr is
+ * a host on the device subnet or a multicast group, dst_port a UDP port,
+ * either one alone keeps the other of the sender. Stream args only.
+ */
+static void parse_stream_dest(const device_addr_t &args, boost::uint32_t &dst_addr, boost::uint16_t &dst_port)
+{
+    dst_addr = 0;
+    dst_port = 0;
+    if (args.has_key("dst_addr"))
+    {
+        boost::system::error_code ec;
+        const boost::asio::ip::address_v4 addr = boost::asio::ip::address_v4::from_string(args["dst_addr"], ec);
+        if (ec or addr.to_ulong() == 0) throw uhd::value_error("umtrx: dst_addr " + args["dst_addr"] + " is not an IPv4 address");
+        dst_addr = boost::uint32_t(addr.to_ulong());
+    }
+    if (args.has_key("dst_port"))
+    {
+        const int port = args.cast<int>("dst_port", 0);
+        if (port < 1 or port > 65535) throw uhd::value_error("umtrx: dst_port " + args["dst_port"] + ", expected 1 to 65535");
+        dst_port = boost::uint16_t(port);
+    }
+}
+
+/*!
+ * The QoS marking of a framer from the stream args over the device args:
+ * dscp=<0-63> for the IP DSCP, vlan_pcp=<0-7> and vlan_id=<0-4095> for an
+ * 802.1Q tag, VLAN ID 0 only tags the priority. The control framer takes
+ * ctrl_dscp, ctrl_vlan_pcp and ctrl_vlan_id instead.
+ */
+boost::uint32_t umtrx_impl::get_stream_qos(const size_t which, const device_addr_t &args) const
+{
+    device_addr_t hints = _xport_args;
+    BOOST_FOREACH(const std::string &key, args.keys()) hints[key] = args[key];
+    const std::string prefix = (which == UMTRX_CTRL_FRAMER)? "ctrl_" : "";
+    if (which == UMTRX_CTRL_FRAMER and hints.has_key("vlan_id") and not hints.has_key("ctrl_vlan_id"))
+    {
+        hints["ctrl_vlan_id"] = hints["vlan_id"]; //one VLAN for both unless told otherwise
+    }
+
+    boost::uint32_t qos = 0;
+    if (hints.has_key(prefix + "dscp"))
+    {
+        const int dscp = hints.cast<int>(prefix + "dscp", 0);
+        if (dscp < 0 or dscp > 63) throw uhd::value_error(str(boost::format("umtrx: %sdscp %d, expected 0 to 63") % prefix % dscp));
+        qos |= boost::uint32_t(dscp);
+    }
+    if (hints.has_key(prefix + "vlan_pcp") or hints.has_key(prefix + "vlan_id"))
+    {
+        const int pcp = hints.cast<int>(prefix + "vlan_pcp", 0);
+        const int vid = hints.cast<int>(prefix + "vlan_id", 0);
+        if (pcp < 0 or pcp > 7) throw uhd::value_error(str(boost::format("umtrx: %svlan_pcp %d, expected 0 to 7") % prefix % pcp));
+        if (vid < 0 or vid > 4095) throw uhd::value_error(str(boost::format("umtrx: %svlan_id %d, expected 0 to 4095") % prefix % vid));
+        //firmware that knows the tag would send frames the older fpga cannot tag
+        if (not _framer_vlan) throw uhd::value_error("umtrx: VLAN tags need a newer firmware and FPGA image");
+        qos |= USRP2_STREAM_QOS_VLAN | (boost::uint32_t(pcp) << USRP2_STREAM_QOS_PCP_SHIFT) | (boost::uint32_t(vid) << USRP2_STREAM_QOS_VID_SHIFT);
+    }
+    if (qos != 0 and not _framer_dscp)
+    {
+        UHD_MSG(warning) << "umtrx: this firmware does not mark the stream packets, dscp ignored" << std::endl;
+        return 0;
+    }
+    return qos;
+}
+
+uhd::transport::zero_copy_if::sptr umtrx_impl::make_xport(const size_t which, const uhd::device_addr_t &args, stream_stats_t::sptr stats)
 {
     zero_copy_xport_params default_params;
     default_params.send_frame_size = transport::udp_simple::mtu;
@@ -172,15 +357,229 @@ uhd::transport::zero_copy_if::sptr umtrx_impl::make_xport(const size_t which, co
     default_params.num_send_frames = DEFAULT_NUM_FRAMES;
     default_params.num_recv_frames = DEFAULT_NUM_FRAMES;
     udp_zero_copy::buff_params ignored_params;
-    zero_copy_if::sptr xport = udp_zero_copy::make(_device_ip_addr, BOOST_STRINGIZE(USRP2_UDP_SERVER_PORT), default_params, ignored_params, args);
-    program_stream_dest(xport, which);
+    zero_copy_if::sptr xport;
+
+    //stream args override the transport hints given in the device args
+    device_addr_t hints = _xport_args;
+    BOOST_FOREACH(const std::string &key, args.keys()) hints[key] = args[key];
+
+    const bool is_rx_framer = which >= UMTRX_DSP_RX0_FRAMER and which <= UMTRX_DSP_RX3_FRAMER;
+    const std::string xport_type = hints.get("xport", "udp");
+    if (xport_type != "udp" and xport_type != "mmsg" and xport_type != "packet_mmap")
+    {
+        throw uhd::value_error("umtrx: unknown xport type " + xport_type + ", expected udp, mmsg or packet_mmap");
+    }
+    const bool is_tx_framer = which == UMTRX_DSP_TX0_FRAMER or which == UMTRX_DSP_TX1_FRAMER;
+
+    //jumbo=1 picks the largest data frame the FPGA path takes, the interface MTU must be raised to match.
+    //An RX packet must fit the DSP packet buffer, a TX packet the flow control window.
+    device_addr_t udp_args = args;
+    if (is_rx_framer or is_tx_framer)
+    {
+        const std::string key = is_rx_framer? "recv_frame_size" : "send_frame_size";
+        const size_t max_frame = std::min(UMTRX_JUMBO_FRAME_BYTES, is_rx_framer? _rx_fifo_bytes - 4 :
+            _tx_sram_bytes[(which == UMTRX_DSP_TX0_FRAMER)? 0 : 1]);
+        const size_t probed_mtu = is_rx_framer? _recv_mtu : _send_mtu;
+        size_t frame_size = size_t(hints.cast<double>(key,
+            (hints.cast<int>("jumbo", 0) != 0)? max_frame : std::min(probed_mtu, max_frame)));
+        if (frame_size > max_frame)
+        {
+            UHD_MSG(warning) << boost::format("umtrx: %s %u is larger than the FPGA takes, using %u")
+                % key % frame_size % max_frame << std::endl;
+            frame_size = max_frame;
+        }
+        hints[key] = udp_args[key] = boost::lexical_cast<std::string>(frame_size);
+        if (is_rx_framer) default_params.recv_frame_size = frame_size;
+        else default_params.send_frame_size = frame_size;
+    }
+    if (is_tx_framer and xport_type == "mmsg")
+    {
+        //coalesce mid-burst TX packets into one sendmmsg() per batch
+        if (not hints.has_key("send_batch_size")) hints["send_batch_size"] = "16";
+        xport = umtrx_mmsg_zero_copy::make(_device_ip_addr, BOOST_STRINGIZE(USRP2_UDP_SERVER_PORT), hints);
+    }
+    else if (is_rx_framer and xport_type == "mmsg")
+    {
+        xport = umtrx_mmsg_zero_copy::make(_device_ip_addr, BOOST_STRINGIZE(USRP2_UDP_SERVER_PORT), hints, stats);
+    }
+    else if (is_tx_framer and xport_type == "packet_mmap")
+    {
+        //the flow control holds at most a window of packets in flight, so does the ring
+        hints["num_send_frames"] = boost::lexical_cast<std::string>(this->get_tx_fc_window(
+            (which == UMTRX_DSP_TX0_FRAMER)? 0 : 1, args, default_params.send_frame_size));
+        if (not hints.has_key("send_batch_size")) hints["send_batch_size"] = "16";
+        xport = umtrx_packet_tx_ring_zero_copy::make(_device_ip_addr, BOOST_STRINGIZE(USRP2_UDP_SERVER_PORT), hints);
+    }
+    else if (is_rx_framer and xport_type == "packet_mmap")
+    {
+        xport = umtrx_packet_mmap_zero_copy::make(_device_ip_addr, BOOST_STRINGIZE(USRP2_UDP_SERVER_PORT), hints, stats);
+    }
+    else
+    {
+        if (is_rx_framer and hints.cast<int>("busy_poll", 0) != 0)
+        {
+            UHD_MSG(warning) << "umtrx: busy_poll needs xport=mmsg or xport=packet_mmap, ignored by the udp transport" << std::endl;
+        }
+        xport = udp_zero_copy::make(_device_ip_addr, BOOST_STRINGIZE(USRP2_UDP_SERVER_PORT), default_params, ignored_params, udp_args);
+    }
+    boost::uint32_t dst_addr = 0;
+    boost::uint16_t dst_port = 0;
+    if (is_rx_framer) parse_stream_dest(args, dst_addr, dst_port);
+    if ((dst_addr != 0 or dst_port != 0) and not _framer_dest)
+        throw uhd::value_error("umtrx: dst_addr and dst_port need a newer firmware image");
+    program_stream_dest(xport, which, this->get_stream_qos(which, args), dst_addr, dst_port);
     _iface->peek32(0); //peek to ensure the zpu processed the program_stream_dest()
     return xport;
 }
 
+//! The socket and buffers of a framer outlive its streamer, a new streamer
+//! with the same args takes them back once the old one let go of them.
+uhd::transport::zero_copy_if::sptr umtrx_impl::get_stream_xport(const size_t which, const uhd::device_addr_t &args, stream_stats_t::sptr stats)
+{
+    const std::string key = args.to_string();
+    if (_xport_pool.has_key(which))
+    {
+        pooled_xport_t &pooled = _xport_pool[which];
+        if (pooled.xport.use_count() == 1 and pooled.args == key)
+        {
+            //another xport may have taken the framer since, flushes the stale packets too
+            boost::uint32_t dst_addr = 0;
+            boost::uint16_t dst_port = 0;
+            if (which >= UMTRX_DSP_RX0_FRAMER and which <= UMTRX_DSP_RX3_FRAMER) parse_stream_dest(args, dst_addr, dst_port);
+            program_stream_dest(pooled.xport, which, this->get_stream_qos(which, args), dst_addr, dst_port);
+            _iface->peek32(0); //peek to ensure the zpu processed the program_stream_dest()
+            return pooled.xport;
+        }
+        //still streaming, the new one gets its own and the pool keeps the old
+        if (pooled.xport.use_count() > 1) return this->make_xport(which, args, stats);
+    }
+    pooled_xport_t pooled;
+    pooled.xport = this->make_xport(which, args, stats);
+    pooled.args = key;
+    _xport_pool[which] = pooled;
+    return pooled.xport;
+}
+
 /***********************************************************************
  * Receive streamer
  **********************************************************************/
+/*!
+ * The DSPs of one receive streamer.
+ * Stream commands go to all of them in one FIFO packet. With several
+ * DSPs a start now becomes a start at a time lead seconds ahead, shared
+ * by all of them, so they start on the same tick and the alignment has
+ * nothing to line up. A stop stays immediate.
+ * The device stops a continuous stream on an overflow. The first channel
+ * to report it restarts the group, at the first sample of the old stream
+ * lead seconds past the device time, so the samples stay on the grid of
+ * the stream and the gap is a whole number of samples. The overflows of
+ * the other channels come before that time and are left alone.
+ */
+class rx_stream_group : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<rx_stream_group> sptr;
+
+    rx_stream_group(umtrx_fifo_ctrl::sptr ctrl, time64_core_200::sptr time64, property_tree::sptr tree,
+        const fs_path &rate_path, const double lead, const bool auto_restart, const size_t snapshot_samps = 0):
+        _ctrl(ctrl), _time64(time64), _tree(tree), _rate_path(rate_path),
+        _lead(lead), _auto_restart(auto_restart), _snapshot_samps(snapshot_samps), _continuous(false), _restart_time(0.0)
+    {}
+
+    void add(rx_dsp_core_200::sptr dsp, stream_stats_t::sptr stats)
+    {
+        _dsps.push_back(dsp);
+        _stats.push_back(stats);
+    }
+
+    //! The command of one channel only
+    void issue_channel_cmd(const size_t chan, const stream_cmd_t &stream_cmd)
+    {
+        this->check_snapshot(stream_cmd);
+        _dsps.at(chan)->issue_stream_command(stream_cmd);
+    }
+
+    void issue_stream_cmd(const stream_cmd_t &stream_cmd)
+    {
+        this->check_snapshot(stream_cmd);
+        boost::mutex::scoped_lock lock(_mutex);
+        stream_cmd_t cmd = stream_cmd;
+        _continuous = cmd.stream_mode == stream_cmd_t::STREAM_MODE_START_CONTINUOUS;
+        if (_dsps.size() > 1 and cmd.stream_now and cmd.stream_mode != stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS)
+        {
+            cmd.stream_now = false;
+            cmd.time_spec = _time64->get_time_now() + time_spec_t(_lead);
+        }
+        _restart_time = cmd.stream_now? time_spec_t(0.0) : cmd.time_spec;
+        this->issue(cmd);
+    }
+
+    //! On an overflow or alignment failure, zero overflow_time when unknown
+    void handle_overflow(const time_spec_t &overflow_time)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        if (not _auto_restart or not _continuous) return;
+        const bool known = overflow_time != time_spec_t(0.0);
+        if (known and overflow_time < _restart_time) return; //already restarted
+
+        const double rate = _tree->access<double>(_rate_path).get();
+        const time_spec_t earliest = _time64->get_time_now() + time_spec_t(_lead);
+        time_spec_t restart = earliest;
+        boost::uint64_t gap = 0;
+        if (known and earliest > overflow_time)
+        {
+            gap = boost::uint64_t(std::ceil((earliest - overflow_time).get_real_secs()*rate));
+            restart = overflow_time + time_spec_t::from_ticks(gap, rate);
+        }
+
+        stream_cmd_t cmd(stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+        cmd.stream_now = false;
+        cmd.time_spec = restart;
+        _restart_time = restart;
+        this->issue(cmd);
+
+        BOOST_FOREACH(const stream_stats_t::sptr &stats, _stats)
+        {
+            if (not stats) continue;
+            stream_stats_t::add(stats->restarts);
+            stream_stats_t::add(stats->restart_gap_samples, gap);
+        }
+        if (known) UMTRX_MSG_ASYNC(warning) << boost::format("RX overflow at %.6fs, restarted at %.6fs, %u samples lost")
+            % overflow_time.get_real_secs() % restart.get_real_secs() % gap << std::endl;
+        else UMTRX_MSG_ASYNC(warning) << boost::format("RX stream restarted at %.6fs") % restart.get_real_secs() << std::endl;
+    }
+
+private:
+    //! A snapshot above the link rate must end before it fills the buffer
+    void check_snapshot(const stream_cmd_t &cmd)
+    {
+        if (_snapshot_samps == 0 or cmd.stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS) return;
+        if (cmd.stream_mode != stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE) throw uhd::value_error(
+            "snapshot streams take num samps and done commands only");
+        if (cmd.num_samps > _snapshot_samps) throw uhd::value_error(str(boost::format(
+            "snapshot of %u samples, the RX buffer holds %u") % cmd.num_samps % _snapshot_samps));
+    }
+
+    void issue(const stream_cmd_t &cmd)
+    {
+        umtrx_fifo_ctrl_batch batch(_ctrl);
+        BOOST_FOREACH(const rx_dsp_core_200::sptr &dsp, _dsps) dsp->issue_stream_command(cmd);
+    }
+
+    const umtrx_fifo_ctrl::sptr _ctrl;
+    const time64_core_200::sptr _time64;
+    const property_tree::sptr _tree;
+    const fs_path _rate_path;
+    const double _lead;
+    const bool _auto_restart;
+    const size_t _snapshot_samps; //largest snapshot burst, zero when not a snapshot stream
+    std::vector<rx_dsp_core_200::sptr> _dsps;
+    std::vector<stream_stats_t::sptr> _stats;
+    boost::mutex _mutex;
+    bool _continuous;
+    time_spec_t _restart_time; //of the last timed start
+};
+
 uhd::rx_streamer::sptr umtrx_impl::get_rx_stream(const uhd::stream_args_t &args_)
 {
     boost::mutex::scoped_lock l(_setupMutex);
@@ -189,32 +588,93 @@ uhd::rx_streamer::sptr umtrx_impl::get_rx_stream(const uhd::stream_args_t &args_
     //setup defaults for unspecified values
     args.otw_format = args.otw_format.empty()? "sc16" : args.otw_format;
     args.channels = args.channels.empty()? std::vector<size_t>(1, 0) : args.channels;
+    if (args.otw_format == "sc8" and (_fpga_caps & U2_FLAG_CAPS_SC8) == 0)
+        throw uhd::value_error("This FPGA image has no otw_format=sc8");
+    if (args.otw_format == "bfp8" and (_fpga_caps & U2_FLAG_CAPS_RX_BFP8) == 0)
+        throw uhd::value_error("This FPGA image has no otw_format=bfp8");
+    const bool le = resolve_otw_endian(args, _fpga_caps);
+
+    //all framers may share one socket, packets are then demuxed by SID
+    const bool shared_xport = args.args.get("rx_xport", "") == "shared";
+
+    //channel n streams to dst_addr<n>/dst_port<n>, or dst_addr and dst_port + n:
+    //different ports for the NIC RSS hash or other hosts, this streamer only controls them
+    bool stream_dest = false;
+    BOOST_FOREACH(const std::string &key, args.args.keys())
+    {
+        if (key.compare(0, 8, "dst_addr") == 0 or key.compare(0, 8, "dst_port") == 0) stream_dest = true;
+    }
+    if (stream_dest and shared_xport) throw uhd::value_error("umtrx: rx_xport=shared cannot send the channels elsewhere");
 
-    //setup the transport hints (default to a large recv buff)
+    //size the transport for buffer_time seconds at the rate of the fastest channel,
+    //set the rates before the streamer is made, ex: buffer_time=0.1
+    const double buffer_time = args.args.cast<double>("buffer_time", DEFAULT_BUFFER_TIME);
+    double bytes_per_sec = 0;
+    BOOST_FOREACH(const size_t dsp, args.channels)
+    {
+        if (dsp >= _rx_dsps.size()) continue; //reported below
+        const double rate = _tree->access<double>(str(boost::format("/mboards/0/rx_dsps/%u/rate/value") % dsp)).get();
+        bytes_per_sec = std::max(bytes_per_sec, rate*convert::get_bytes_per_item(args.otw_format));
+    }
+    if (shared_xport) bytes_per_sec *= args.channels.size();
     if (not args.args.has_key("recv_buff_size"))
     {
         #if defined(UHD_PLATFORM_MACOS) || defined(UHD_PLATFORM_BSD)
             //limit buffer resize on macos or it will error
             args.args["recv_buff_size"] = "1e6";
         #elif defined(UHD_PLATFORM_LINUX) || defined(UHD_PLATFORM_WIN32)
-            //set to half-a-second of buffering at max rate
-            args.args["recv_buff_size"] = "50e6";
+            const double buff_size = std::min(MAX_RECV_BUFF_SIZE, std::max(MIN_RECV_BUFF_SIZE, bytes_per_sec*buffer_time));
+            args.args["recv_buff_size"] = boost::lexical_cast<std::string>(size_t(buff_size));
         #endif
     }
+    if (not args.args.has_key("num_recv_frames"))
+    {
+        const size_t frame_size = size_t(args.args.cast<double>("recv_frame_size", _xport_args.cast<double>("recv_frame_size", _recv_mtu)));
+        size_t frames = buffer_frames(bytes_per_sec, buffer_time*FRAMES_BUFFER_FRACTION, frame_size);
+        if (shared_xport) frames = std::max(frames, std::min(MAX_NUM_FRAMES, DEFAULT_NUM_FRAMES*args.channels.size()));
+        args.args["num_recv_frames"] = boost::lexical_cast<std::string>(frames);
+    }
+
+    //host_check=1: check the host against the buffers of this stream first
+    if (args.args.cast<int>("host_check", 0) != 0)
+    {
+        device_addr_t check_args = _xport_args;
+        BOOST_FOREACH(const std::string &key, args.args.keys()) check_args[key] = args.args[key];
+        warn_host_check(_device_ip_addr, check_args,
+            size_t(check_args.cast<double>("recv_frame_size", _recv_mtu)));
+    }
 
     //create the transport
     std::vector<zero_copy_if::sptr> xports;
+    std::vector<boost::uint32_t> sids;
     for (size_t chan_i = 0; chan_i < args.channels.size(); chan_i++)
     {
         const size_t dsp = args.channels[chan_i];
-        size_t which = ~0;
-        if (dsp == 0) which = UMTRX_DSP_RX0_FRAMER;
-        if (dsp == 1) which = UMTRX_DSP_RX1_FRAMER;
-        if (dsp == 2) which = UMTRX_DSP_RX2_FRAMER;
-        if (dsp == 3) which = UMTRX_DSP_RX3_FRAMER;
-        UHD_ASSERT_THROW(which != size_t(~0));
-        xports.push_back(make_xport(which, args.args));
+        if (dsp >= _rx_dsps.size()) throw uhd::index_error(str(boost::format(
+            "umtrx: RX channel %u, this FPGA image has %u DDCs") % dsp % _rx_dsps.size()));
+        const size_t which = UMTRX_DSP_RX_FRAMERS[dsp];
+        const boost::uint32_t sid = UMTRX_DSP_RX_SIDS[dsp];
+        sids.push_back(sid);
+        if (shared_xport and not xports.empty())
+        {
+            //the framer learns its destination from the source port of the stream ctrl
+            program_stream_dest(xports.front(), which, this->get_stream_qos(which, args.args));
+            _iface->peek32(0); //peek to ensure the zpu processed the program_stream_dest()
+            xports.push_back(xports.front());
+        }
+        else if (stream_dest)
+        {
+            device_addr_t chan_args = args.args;
+            const std::string n = boost::lexical_cast<std::string>(chan_i);
+            if (chan_args.has_key("dst_addr" + n)) chan_args["dst_addr"] = chan_args["dst_addr" + n];
+            if (chan_args.has_key("dst_port" + n)) chan_args["dst_port"] = chan_args["dst_port" + n];
+            else if (args.args.has_key("dst_port")) chan_args["dst_port"] = boost::lexical_cast<std::string>(args.args.cast<int>("dst_port", 0) + int(chan_i));
+            xports.push_back(get_stream_xport(which, chan_args, _rx_stream_stats[dsp]));
+        }
+        else xports.push_back(get_stream_xport(which, args.args, _rx_stream_stats[dsp]));
     }
+    umtrx_sid_demux::sptr demux;
+    if (shared_xport) demux = umtrx_sid_demux::make(xports.front(), sids, le);
 
     //calculate packet size
     static const size_t hdr_size = 0
@@ -223,46 +683,107 @@ uhd::rx_streamer::sptr umtrx_impl::get_rx_stream(const uhd::stream_args_t &args_
         - sizeof(vrt::if_packet_info_t().cid) //no class id ever used
         - sizeof(vrt::if_packet_info_t().tsi) //no int time ever used
     ;
-    const size_t bpp = xports[0]->get_recv_frame_size() - hdr_size;
+    const size_t exp_size = (args.otw_format == "bfp8")? sizeof(boost::uint32_t) : 0; //shared exponent word
+    const size_t bpp = xports[0]->get_recv_frame_size() - hdr_size - exp_size;
     const size_t bpi = convert::get_bytes_per_item(args.otw_format);
-    const size_t spp = unsigned(args.args.cast<double>("spp", bpp/bpi));
+    size_t spp = unsigned(args.args.cast<double>("spp", bpp/bpi));
+    if (args.otw_format == "sc8" or args.otw_format == "bfp8") spp &= ~size_t(1); //two sc8 samples per item32
+
+    //snapshot=1: a burst above the link rate lands in the RX SRAM at the full rate,
+    //framed with its timestamps, and drains at link speed, it must fit the buffer
+    size_t snapshot_samps = 0;
+    if (args.args.cast<int>("snapshot", 0) != 0)
+    {
+        size_t buffer_bytes = ~size_t(0);
+        BOOST_FOREACH(const size_t dsp, args.channels)
+        {
+            if (dsp >= _rx_sram_bytes.size() or _rx_sram_bytes[dsp] == 0) throw uhd::value_error(str(boost::format(
+                "snapshot=1 needs the SRAM buffer, RX channel %u has none on this FPGA image") % dsp));
+            buffer_bytes = std::min(buffer_bytes, _tree->access<size_t>(
+                str(boost::format("/mboards/0/rx_dsps/%u/buffer_bytes") % dsp)).get());
+        }
+        snapshot_samps = (buffer_bytes/(spp*bpi + hdr_size + exp_size))*spp;
+    }
 
     //make the new streamer given the samples per packet
     UMTRX_UHD_PTR_NAMESPACE::shared_ptr<sph::recv_packet_streamer> my_streamer = UMTRX_UHD_PTR_NAMESPACE::make_shared<sph::recv_packet_streamer>(spp);
 
     //init some streamer stuff
     my_streamer->resize(args.channels.size());
-    my_streamer->set_vrt_unpacker(&vrt::if_hdr_unpack_be);
+    my_streamer->set_vrt_unpacker(le? &umtrx_if_hdr_unpack_le : &umtrx_if_hdr_unpack_be);
 
     //set the converter
     uhd::convert::id_type id;
-    id.input_format = args.otw_format + "_item32_be";
+    id.input_format = args.otw_format + (le? "_item32_le" : "_item32_be");
     id.num_inputs = 1;
     id.output_format = args.cpu_format;
     id.num_outputs = 1;
     my_streamer->set_converter(id);
 
+    //optional parallel conversion, ex: convert_threads=4,convert_cpu=2
+    //the workers default to the rx_convert_cpus device arg
+    const size_t convert_threads = args.args.cast<size_t>("convert_threads", 1);
+    std::vector<int> convert_cpus = _rx_convert_cpus;
+    if (args.args.has_key("convert_cpu"))
+    {
+        const int first_cpu = args.args.cast<int>("convert_cpu", -1); //negative disables pinning
+        convert_cpus.clear();
+        for (size_t i = 1; i < convert_threads and first_cpu >= 0; i++) convert_cpus.push_back(first_cpu + int(i) - 1);
+    }
+    my_streamer->set_converter_threads(convert_threads, convert_cpus, _rt_priority);
+    //prefault=1: warm the converters, the frames of the umtrx transports are also locked
+    if (args.args.cast<int>("prefault", 0) != 0) my_streamer->warm_up(spp);
+
+    //optional fill of lost packets, ex: gap_fill=zero,gap_fill_max=64
+    const std::string gap_fill = args.args.get("gap_fill", "none");
+    if (gap_fill == "zero") my_streamer->set_gap_fill(sph::recv_packet_handler::GAP_FILL_ZERO, args.args.cast<size_t>("gap_fill_max", 64));
+    else if (gap_fill == "hold") my_streamer->set_gap_fill(sph::recv_packet_handler::GAP_FILL_HOLD, args.args.cast<size_t>("gap_fill_max", 64));
+    else if (gap_fill != "none") throw uhd::value_error("gap_fill must be none, zero or hold, not " + gap_fill);
+
     //bind callbacks for the handler
+    //the stream commands of all channels go out together, ex: start_lead=0.005,
+    //overflow_restart=off leaves the restart after an overflow to the application
+    rx_stream_group::sptr group(new rx_stream_group(_ctrl, _time64, _tree,
+        fs_path("/mboards/0/rx_dsps") / boost::lexical_cast<std::string>(args.channels.front()) / "rate" / "value",
+        args.args.cast<double>("start_lead", 0.005), args.args.get("overflow_restart", "on") != "off", snapshot_samps));
     for (size_t chan_i = 0; chan_i < args.channels.size(); chan_i++)
     {
         const size_t dsp = args.channels[chan_i];
         _rx_dsps[dsp]->set_nsamps_per_packet(spp); //seems to be a good place to set this
         _rx_dsps[dsp]->setup(args);
-        my_streamer->set_xport_chan_get_buff(chan_i, boost::bind(
-            &zero_copy_if::get_recv_buff, xports[chan_i], boost::placeholders::_1
+        if (demux) my_streamer->set_xport_chan_get_buff(chan_i, boost::bind(
+            &umtrx_sid_demux::get_recv_buff, demux, sids[chan_i], boost::placeholders::_1
         ), true /*flush*/);
+        else my_streamer->set_xport_chan_xport(chan_i, xports[chan_i], true /*flush*/);
         my_streamer->set_issue_stream_cmd(chan_i, boost::bind(
-            &rx_dsp_core_200::issue_stream_command, _rx_dsps[dsp], boost::placeholders::_1));
+            &rx_stream_group::issue_channel_cmd, group, chan_i, boost::placeholders::_1));
+        my_streamer->set_overflow_handler(chan_i, boost::bind(
+            &rx_stream_group::handle_overflow, group, boost::placeholders::_1));
+        group->add(_rx_dsps[dsp], _rx_stream_stats[dsp]);
+        my_streamer->set_xport_chan_stats(chan_i, _rx_stream_stats[dsp]);
         _rx_streamers[dsp] = my_streamer; //store weak pointer
     }
 
-    //set the packet threshold to be an entire socket buffer's worth
-    const size_t packets_per_sock_buff = size_t(50e6/xports[0]->get_recv_frame_size());
-    my_streamer->set_alignment_failure_threshold(packets_per_sock_buff);
+    my_streamer->set_issue_stream_cmd_all(boost::bind(&rx_stream_group::issue_stream_cmd, group, boost::placeholders::_1));
+
+    //lagging channels are fast-forwarded, only alignment restarts count
+    my_streamer->set_alignment_failure_threshold(args.args.cast<size_t>("alignment_restarts", 16));
 
     //sets all tick and samp rates on this streamer
     this->update_rates();
 
+    //optional host channelizer, ex: channelizer=8,channelizer_taps=8
+    if (args.args.has_key("channelizer"))
+    {
+        if (args.channels.size() != 1 or args.cpu_format != "fc32")
+        {
+            throw uhd::value_error("channelizer requires one channel with the fc32 cpu format");
+        }
+        return umtrx_rx_channelizer::make(my_streamer, args.args.cast<size_t>("channelizer", 1),
+            args.args.cast<size_t>("channelizer_taps", 8),
+            boost::bind(&sph::recv_packet_handler::get_samp_rate, my_streamer.get()));
+    }
+
     return my_streamer;
 }
 
@@ -276,10 +797,17 @@ public:
 
     /*!
      * Make a new flow control monitor.
+     * The sequence counters form a single producer (get_send_buff)
+     * single consumer (the async task) pair: the window check is a pair
+     * of atomic loads, the waiter spins briefly before it blocks.
      * \param max_seqs_out num seqs before throttling
      */
-    flow_control_monitor(seq_type max_seqs_out):_max_seqs_out(max_seqs_out){
+    flow_control_monitor(seq_type max_seqs_out):
+        _adaptive(false), _min_seqs_out(1), _base_margin(0.0), _margin(0.0)
+    {
+        this->set_max_seqs_out(max_seqs_out);
         this->clear();
+        _waiting = false;
         _ready_fcn = boost::bind(&flow_control_monitor::ready, this);
     }
 
@@ -295,7 +823,10 @@ public:
      * \return the sequence to be sent to the dsp
      */
     UHD_INLINE seq_type get_curr_seq_out(void){
-        return _last_seq_out++;
+        const seq_type seq = _last_seq_out.fetch_add(1, boost::memory_order_relaxed);
+        _send_ns[seq % SEND_TIME_RING].store(boost::chrono::duration_cast<boost::chrono::nanoseconds>(
+            clock_type::now().time_since_epoch()).count(), boost::memory_order_relaxed);
+        return seq;
     }
 
     /*!
@@ -304,112 +835,358 @@ public:
      * \return false on timeout
      */
     UHD_INLINE bool check_fc_condition(double timeout){
+        for (size_t i = 0; i < FC_SPIN_COUNT; i++){
+            if (this->ready()) return true;
+        }
+
+        //slow path: block until the async task updates the ack
         boost::mutex::scoped_lock lock(_fc_mutex);
-        if (this->ready()) return true;
+        _waiting = true;
         boost::this_thread::disable_interruption di; //disable because the wait can throw
-        return _fc_cond.timed_wait(lock, to_time_dur(timeout), _ready_fcn);
+        const bool ok = _fc_cond.timed_wait(lock, to_time_dur(timeout), _ready_fcn);
+        _waiting = false;
+        return ok;
     }
 
     /*!
      * Update the flow control condition.
      * \param seq the last sequence number to be ACK'd
+     * \param device_secs device time of the ack, negative without a timestamp
+     * \return nanoseconds from the send of the newest packet ACK'd to now, 0 when unknown
      */
-    UHD_INLINE void update_fc_condition(seq_type seq){
-        boost::mutex::scoped_lock lock(_fc_mutex);
+    UHD_INLINE boost::uint64_t update_fc_condition(seq_type seq, const double device_secs){
+        if (_adaptive) this->adapt(seq, device_secs);
+        const seq_type last_ack = _last_seq_ack.load(boost::memory_order_relaxed);
         _last_seq_ack = seq;
-        lock.unlock();
-        _fc_cond.notify_one();
+        //the lock orders the notify after the waiter's predicate check
+        if (_waiting){
+            boost::mutex::scoped_lock lock(_fc_mutex);
+            lock.unlock();
+            _fc_cond.notify_one();
+        }
+
+        //the send times of a window wider than the ring are overwritten
+        const seq_type out = _last_seq_out.load(boost::memory_order_relaxed);
+        if (seq == last_ack or seq_type(out - seq) >= SEND_TIME_RING - 1) return 0;
+        const boost::uint64_t sent_ns = _send_ns[seq_type(seq - 1) % SEND_TIME_RING].load(boost::memory_order_relaxed);
+        const boost::uint64_t now_ns = boost::chrono::duration_cast<boost::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+        return (now_ns > sent_ns)? now_ns - sent_ns : 0;
+    }
+
+    //! Get the number of sequences sent but not yet ACK'd
+    UHD_INLINE seq_type get_seqs_in_flight(void) const{
+        return seq_type(_last_seq_out.load(boost::memory_order_relaxed) - _last_seq_ack.load());
+    }
+
+    //! Change the window, Ex: when the sample rate changes in latency mode
+    void set_max_seqs_out(seq_type max_seqs_out){
+        _max_seqs_out = max_seqs_out;
+        if (_waiting){
+            boost::mutex::scoped_lock lock(_fc_mutex);
+            lock.unlock();
+            _fc_cond.notify_one();
+        }
+    }
+
+    seq_type get_max_seqs_out(void) const{
+        return _max_seqs_out.load(boost::memory_order_relaxed);
+    }
+
+    /*!
+     * Let the acks size the window, called before the updates start.
+     * The window covers the measured drain rate over the ack interval,
+     * its jitter and a margin: small while the acks are regular, wider
+     * as they spread. An underflow doubles the margin, it decays back.
+     * \param min_seqs_out the narrowest window
+     * \param max_seqs_out the widest window, where it starts
+     * \param margin seconds on top of the ack interval
+     */
+    void set_adaptive(const seq_type min_seqs_out, const seq_type max_seqs_out, const double margin){
+        boost::mutex::scoped_lock lock(_adapt_mutex);
+        _min_seqs_out = std::min(min_seqs_out, max_seqs_out);
+        _base_margin = _margin = margin;
+        _ack_stats_valid = false;
+        _last_ack_device = -1.0;
+        _drain_rate = 0.0;
+        _adaptive_max = max_seqs_out;
+        this->set_max_seqs_out(max_seqs_out);
+        _adaptive = true;
+    }
+
+    //! The device ran dry, the window was too narrow
+    void note_underflow(void){
+        boost::mutex::scoped_lock lock(_adapt_mutex);
+        if (_adaptive) _margin = std::min(_margin*2.0, ADAPTIVE_MAX_MARGIN);
     }
 
 private:
+    static const size_t FC_SPIN_COUNT = 100;
+    static const size_t SEND_TIME_RING = 4096; //packets, a power of two for the wrap of seq_type
+    static const double ADAPTIVE_MAX_MARGIN; //seconds
+    static const double ADAPTIVE_MARGIN_DECAY; //per ack
+
+    typedef boost::chrono::steady_clock clock_type;
+
+    //! Measure the acks and resize the window, on the async thread
+    void adapt(const seq_type seq, const double device_secs){
+        boost::mutex::scoped_lock lock(_adapt_mutex);
+        const clock_type::time_point now = clock_type::now();
+        const seq_type last_ack = _last_seq_ack.load(boost::memory_order_relaxed);
+        if (_ack_stats_valid){
+            const double dt = boost::chrono::duration<double>(now - _last_ack_time).count();
+            if (dt > 0.0){
+                //mean and deviation of the interval, as the TCP retransmit timer
+                const double err = dt - _ack_interval;
+                _ack_interval += err/8;
+                _ack_jitter += (std::abs(err) - _ack_jitter)/4;
+
+                //the drain rate only counts while the device had packets queued,
+                //over the device time of the acks when they have it: no network jitter
+                const double drain_dt = (device_secs > _last_ack_device and _last_ack_device >= 0.0)? device_secs - _last_ack_device : dt;
+                const seq_type acked = seq_type(seq - last_ack);
+                if (acked != 0 and _was_busy){
+                    const double rate = acked/drain_dt;
+                    _drain_rate = (_drain_rate > 0.0)? _drain_rate + (rate - _drain_rate)/8 : rate;
+                }
+            }
+        }
+        else{
+            _ack_interval = 0.0;
+            _ack_jitter = 0.0;
+            _ack_stats_valid = true;
+        }
+        _last_ack_time = now;
+        _last_ack_device = device_secs;
+        _was_busy = seq_type(_last_seq_out.load(boost::memory_order_relaxed) - seq) != 0;
+
+        _margin = std::max(_base_margin, _margin*ADAPTIVE_MARGIN_DECAY);
+        if (_drain_rate <= 0.0) return;
+        const double need = _drain_rate*(_ack_interval + 4*_ack_jitter + _margin);
+        const seq_type window = seq_type(std::min<double>(_adaptive_max, std::max<double>(_min_seqs_out, std::ceil(need))));
+        if (window != this->get_max_seqs_out()) _max_seqs_out = window;
+    }
+
     bool ready(void){
-        return seq_type(_last_seq_out -_last_seq_ack) < _max_seqs_out;
+        return this->get_seqs_in_flight() < this->get_max_seqs_out();
     }
 
     boost::mutex _fc_mutex;
     boost::condition_variable _fc_cond;
-    seq_type _last_seq_out, _last_seq_ack;
-    const seq_type _max_seqs_out;
+    boost::atomic<seq_type> _last_seq_out, _last_seq_ack;
+    boost::atomic<bool> _waiting;
+    boost::atomic<seq_type> _max_seqs_out;
     boost::function<bool(void)> _ready_fcn;
+    boost::atomic<boost::uint64_t> _send_ns[SEND_TIME_RING]; //clock_type ns since epoch, by seq
+
+    //adaptive window state, the async thread measures, set_adaptive() resets
+    boost::mutex _adapt_mutex;
+    boost::atomic<bool> _adaptive;
+    seq_type _min_seqs_out, _adaptive_max;
+    double _base_margin, _margin;
+    bool _ack_stats_valid, _was_busy;
+    clock_type::time_point _last_ack_time;
+    double _last_ack_device; //seconds, negative without a timestamp
+    double _ack_interval, _ack_jitter; //seconds
+    double _drain_rate; //packets per second
 };
 
-static managed_send_buffer::sptr get_send_buff(
-    task::sptr /*holds ref*/,
-    flow_control_monitor::sptr fc_mon,
-    zero_copy_if::sptr xport,
-    double timeout
-)
+const double flow_control_monitor::ADAPTIVE_MAX_MARGIN = 0.1;
+const double flow_control_monitor::ADAPTIVE_MARGIN_DECAY = 0.9995;
+
+/*!
+ * The tx buffer source of a channel: waits on flow control, gets a buffer
+ * from the transport and writes the flow control word into it.
+ * Called by the send handler directly, it also holds the async registration.
+ */
+class umtrx_tx_buff_source : public sph::send_packet_handler::buff_source
 {
-    //wait on flow control w/ timeout
-    if (not fc_mon->check_fc_condition(timeout)) return managed_send_buffer::sptr();
+public:
+    umtrx_tx_buff_source(boost::shared_ptr<void> async_reg, flow_control_monitor::sptr fc_mon,
+        stream_stats_t::sptr stats, zero_copy_if::sptr xport):
+        _async_reg(async_reg), _fc_mon(fc_mon), _stats(stats), _xport(xport)
+    {}
 
-    //get a buffer from the transport w/ timeout
-    managed_send_buffer::sptr buff = xport->get_send_buff(timeout);
+    managed_send_buffer::sptr get_send_buff(const double timeout)
+    {
+        //wait on flow control w/ timeout
+        UMTRX_PROFILE_START(fc_wait_start);
+        const bool fc_ready = _fc_mon->check_fc_condition(timeout);
+        UMTRX_PROFILE_STOP(_stats, fc_wait_latency, fc_wait_start);
+        if (not fc_ready) return managed_send_buffer::sptr();
 
-    //write the flow control word into the buffer
-    if (buff.get()) buff->cast<boost::uint32_t *>()[0] = uhd::htonx(fc_mon->get_curr_seq_out());
+        //get a buffer from the transport w/ timeout
+        managed_send_buffer::sptr buff = _xport->get_send_buff(timeout);
 
-    return buff;
-}
+        //write the flow control word into the buffer
+        if (buff.get()) buff->cast<boost::uint32_t *>()[0] = uhd::htonx(_fc_mon->get_curr_seq_out());
 
-static void handle_tx_async_msgs(
-    const size_t chan,
-    const double tick_rate,
-    flow_control_monitor::sptr fc_mon,
-    zero_copy_if::sptr xport,
-    boost::function<void(void)> stop_flow_control,
-    boost::shared_ptr<umtrx_impl::async_md_type> async_queue,
-    boost::shared_ptr<umtrx_impl::async_md_type> old_async_queue
-){
-    set_thread_priority_safe();
-
-    while (not boost::this_thread::interruption_requested())
-    {
-        managed_recv_buffer::sptr buff = xport->get_recv_buff();
-        if (not buff) continue; //ignore timeout/error buffers
-
-        try{
-            //extract the vrt header packet info
-            vrt::if_packet_info_t if_packet_info;
-            if_packet_info.num_packet_words32 = buff->size()/sizeof(boost::uint32_t);
-            const boost::uint32_t *vrt_hdr = buff->cast<const boost::uint32_t *>();
-            vrt::if_hdr_unpack_be(vrt_hdr, if_packet_info);
-
-            //handle a tx async report message
-            if (if_packet_info.packet_type != vrt::if_packet_info_t::PACKET_TYPE_DATA)
-            {
-                //fill in the async metadata
-                async_metadata_t metadata;
-                load_metadata_from_buff(uhd::ntohx<boost::uint32_t>, metadata, if_packet_info, vrt_hdr, tick_rate, chan);
-
-                //catch the flow control packets and react
-                if (metadata.event_code == 0){
-                    boost::uint32_t fc_word32 = (vrt_hdr + if_packet_info.num_header_words32)[1];
-                    fc_mon->update_fc_condition(uhd::ntohx(fc_word32));
-                    continue;
-                }
-                //else UHD_MSG(often) << "metadata.event_code " << metadata.event_code << std::endl;
-                async_queue->push_with_pop_on_full(metadata);
-                old_async_queue->push_with_pop_on_full(metadata);
+        return buff;
+    }
 
-                standard_async_msg_prints(metadata);
-            }
-            else{
-                //TODO unknown received packet, may want to print error...
+private:
+    boost::shared_ptr<void> _async_reg;
+    flow_control_monitor::sptr _fc_mon;
+    stream_stats_t::sptr _stats;
+    zero_copy_if::sptr _xport;
+};
+
+/*!
+ * One thread per device for the tx async and flow control packets.
+ * Every tx framer sends its reports to one socket, the packets are
+ * demuxed by the report SID to the channel registered for it.
+ */
+class umtrx_tx_async_loop : public boost::enable_shared_from_this<umtrx_tx_async_loop>
+{
+public:
+    typedef boost::shared_ptr<umtrx_tx_async_loop> sptr;
+
+    umtrx_tx_async_loop(zero_copy_if::sptr xport, umtrx_async_ring::sptr ring, const umtrx_thread_placement &placement):
+        _xport(xport), _ring(ring), _placement(placement)
+    {
+        _task = task::make(boost::bind(&umtrx_tx_async_loop::run, this));
+    }
+
+    ~umtrx_tx_async_loop(void)
+    {
+        _task.reset(); //join before the transport goes
+    }
+
+    zero_copy_if::sptr get_xport(void)
+    {
+        return _xport;
+    }
+
+    /*!
+     * Route the reports of a sid to a streamer channel,
+     * its msgs go to the ring under the streamer's tag.
+     * The registration lasts as long as the returned handle,
+     * releasing it turns the flow control updates off.
+     */
+    boost::shared_ptr<void> add(const boost::uint32_t sid, const size_t chan, const double tick_rate,
+        flow_control_monitor::sptr fc_mon, stream_stats_t::sptr stats, const boost::uint32_t tag,
+        const boost::function<void(void)> &stop_flow_control)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        chan_type &c = _chans[sid];
+        c.chan = chan;
+        c.tick_rate = tick_rate;
+        c.fc_mon = fc_mon;
+        c.stats = stats;
+        c.tag = tag;
+        return boost::shared_ptr<void>(static_cast<void *>(0), boost::bind(
+            &umtrx_tx_async_loop::remove, shared_from_this(), sid, fc_mon.get(), stop_flow_control));
+    }
+
+private:
+    struct chan_type
+    {
+        chan_type(void): chan(0), tick_rate(1.0), tag(0){}
+        size_t chan;
+        double tick_rate;
+        flow_control_monitor::sptr fc_mon;
+        stream_stats_t::sptr stats;
+        boost::uint32_t tag;
+    };
+
+    void remove(const boost::uint32_t sid, flow_control_monitor *fc_mon, const boost::function<void(void)> &stop_flow_control)
+    {
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            chan_type &c = _chans[sid];
+            if (c.fc_mon.get() != fc_mon) return; //a newer streamer took the channel
+            c = chan_type();
+        }
+        //reports still in flight are dropped by the loop
+        stop_flow_control();
+    }
+
+    void run(void)
+    {
+        //explicit rt_priority replaces the uhd default priority
+        if (_placement.rt_priority == 0) set_thread_priority_safe();
+        _placement.apply("tx async");
+
+        while (not boost::this_thread::interruption_requested())
+        {
+            managed_recv_buffer::sptr buff = _xport->get_recv_buff();
+            if (not buff) continue; //ignore timeout/error buffers
+
+            try{
+                this->handle(buff);
+            }catch(const std::exception &e){
+                UMTRX_MSG_ASYNC(error) << "Error in the tx async loop: " << e.what() << std::endl;
             }
-        }catch(const std::exception &e){
-            UHD_MSG(error) << "Error in handle_tx_async_msgs: " << e.what() << std::endl;
         }
     }
 
-    stop_flow_control();
-    //flush after fc off, max time of 1s
-    size_t i = 0;
-    while (not xport->get_recv_buff(0.01))
+    void handle(managed_recv_buffer::sptr buff)
     {
-        if (i++ > 100) break;
+        //extract the vrt header packet info
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.num_packet_words32 = buff->size()/sizeof(boost::uint32_t);
+        const boost::uint32_t *vrt_hdr = buff->cast<const boost::uint32_t *>();
+        vrt::if_hdr_unpack_be(vrt_hdr, if_packet_info); //the status packets stay big-endian with le framing
+
+        //TODO unknown received packet, may want to print error...
+        if (if_packet_info.packet_type == vrt::if_packet_info_t::PACKET_TYPE_DATA) return;
+
+        chan_type c;
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            std::map<boost::uint32_t, chan_type>::const_iterator it = _chans.find(if_packet_info.sid);
+            if (it == _chans.end() or not it->second.fc_mon) return; //no streamer on this channel
+            c = it->second;
+        }
+
+        //fill in the async metadata
+        async_metadata_t metadata;
+        load_metadata_from_buff(uhd::ntohx<boost::uint32_t>, metadata, if_packet_info, vrt_hdr, c.tick_rate, c.chan);
+
+        //catch the flow control packets and react
+        if (metadata.event_code == 0){
+            boost::uint32_t fc_word32 = (vrt_hdr + if_packet_info.num_header_words32)[1];
+            //the framer stamps the ack with the device time it was made at
+            const double device_secs = if_packet_info.has_tsf? double(if_packet_info.tsf)/c.tick_rate : -1.0;
+            const boost::uint64_t latency_ns = c.fc_mon->update_fc_condition(uhd::ntohx(fc_word32), device_secs);
+            if (latency_ns != 0)
+            {
+                c.stats->ack_latency.record(latency_ns);
+                c.stats->last_ack_latency_ns.store(latency_ns, boost::memory_order_relaxed);
+            }
+            if (if_packet_info.has_tsf)
+            {
+                c.stats->last_ticks_host_ns.store(boost::chrono::duration_cast<boost::chrono::nanoseconds>(
+                    stream_stats_t::clock_type::now().time_since_epoch()).count(), boost::memory_order_relaxed);
+                c.stats->last_ticks.store(if_packet_info.tsf, boost::memory_order_release);
+            }
+            return;
+        }
+        //else UHD_MSG(often) << "metadata.event_code " << metadata.event_code << std::endl;
+        switch (metadata.event_code)
+        {
+        case async_metadata_t::EVENT_CODE_UNDERFLOW:
+        case async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET:
+            c.fc_mon->note_underflow();
+            stream_stats_t::add(c.stats->underflows); break;
+        case async_metadata_t::EVENT_CODE_SEQ_ERROR:
+        case async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST:
+            stream_stats_t::add(c.stats->seq_errors); break;
+        case async_metadata_t::EVENT_CODE_TIME_ERROR:
+            stream_stats_t::add(c.stats->late_packets); break;
+        default: break;
+        }
+        _ring->push(metadata, c.tag);
+
+        standard_async_msg_prints(metadata);
     }
-}
+
+    zero_copy_if::sptr _xport;
+    umtrx_async_ring::sptr _ring;
+    const umtrx_thread_placement _placement;
+    boost::mutex _mutex;
+    std::map<boost::uint32_t, chan_type> _chans;
+    task::sptr _task;
+};
 
 /***********************************************************************
  * Transmit streamer
@@ -422,12 +1199,43 @@ uhd::tx_streamer::sptr umtrx_impl::get_tx_stream(const uhd::stream_args_t &args_
     //setup defaults for unspecified values
     args.otw_format = args.otw_format.empty()? "sc16" : args.otw_format;
     args.channels = args.channels.empty()? std::vector<size_t>(1, 0) : args.channels;
+    if (args.otw_format == "sc8" and (_fpga_caps & U2_FLAG_CAPS_SC8) == 0)
+        throw uhd::value_error("This FPGA image has no otw_format=sc8");
+    const bool le = resolve_otw_endian(args, _fpga_caps);
 
-    //The buffer should be the size of the SRAM on the device,
+    //The buffer should be the size of the SRAM share of the largest channel,
     //because we will never commit more than the SRAM can hold.
     if (not args.args.has_key("send_buff_size"))
     {
-        args.args["send_buff_size"] = boost::lexical_cast<std::string>(UMTRX_SRAM_BYTES);
+        size_t sram_bytes = 0;
+        BOOST_FOREACH(const size_t dsp, args.channels)
+        {
+            UHD_ASSERT_THROW(dsp < _tx_sram_bytes.size());
+            sram_bytes = std::max(sram_bytes, _tx_sram_bytes[dsp]);
+        }
+        args.args["send_buff_size"] = boost::lexical_cast<std::string>(sram_bytes);
+    }
+
+    //frames for a fraction of buffer_time seconds at the rate of the fastest channel
+    if (not args.args.has_key("num_send_frames"))
+    {
+        double bytes_per_sec = 0;
+        BOOST_FOREACH(const size_t dsp, args.channels)
+        {
+            const double rate = _tree->access<double>(str(boost::format("/mboards/0/tx_dsps/%u/rate/value") % dsp)).get();
+            bytes_per_sec = std::max(bytes_per_sec, rate*convert::get_bytes_per_item(args.otw_format));
+        }
+        const size_t frame_size = size_t(args.args.cast<double>("send_frame_size", _xport_args.cast<double>("send_frame_size", _send_mtu)));
+        const double buffer_time = args.args.cast<double>("buffer_time", DEFAULT_BUFFER_TIME);
+        args.args["num_send_frames"] = boost::lexical_cast<std::string>(
+            buffer_frames(bytes_per_sec, buffer_time*FRAMES_BUFFER_FRACTION, frame_size));
+    }
+
+    //the async loop of the device, its socket takes the reports of every tx framer
+    if (not _tx_async_loop)
+    {
+        _tx_async_loop.reset(new umtrx_tx_async_loop(
+            make_xport(UMTRX_DSP_TX0_FRAMER, device_addr_t("xport=udp")), _async_ring, _tx_async_placement));
     }
 
     //create the transport
@@ -435,11 +1243,14 @@ uhd::tx_streamer::sptr umtrx_impl::get_tx_stream(const uhd::stream_args_t &args_
     for (size_t chan_i = 0; chan_i < args.channels.size(); chan_i++)
     {
         const size_t dsp = args.channels[chan_i];
-        size_t which = ~0;
-        if (dsp == 0) which = UMTRX_DSP_TX0_FRAMER;
-        if (dsp == 1) which = UMTRX_DSP_TX1_FRAMER;
-        UHD_ASSERT_THROW(which != size_t(~0));
-        xports.push_back(make_xport(which, args.args));
+        if (dsp >= _num_duc) throw uhd::index_error(str(boost::format(
+            "umtrx: TX channel %u, this FPGA image has %u DUCs") % dsp % _num_duc));
+        const size_t which = UMTRX_DSP_TX_FRAMERS[dsp];
+        xports.push_back(get_stream_xport(which, args.args));
+
+        //the data socket only sends, point the framer back at the async loop
+        program_stream_dest(_tx_async_loop->get_xport(), which, this->get_stream_qos(which, args.args));
+        _iface->peek32(0); //peek to ensure the zpu processed the program_stream_dest()
     }
 
     //calculate packet size
@@ -451,27 +1262,40 @@ uhd::tx_streamer::sptr umtrx_impl::get_tx_stream(const uhd::stream_args_t &args_
         - sizeof(vrt::if_packet_info_t().tsi) //no int time ever used
     ;
     const size_t bpp = xports[0]->get_send_frame_size() - hdr_size;
-    const size_t spp = bpp/convert::get_bytes_per_item(args.otw_format);
+    size_t spp = bpp/convert::get_bytes_per_item(args.otw_format);
+    if (args.otw_format == "sc8") spp &= ~size_t(1); //two sc8 samples per item32
 
     //make the new streamer given the samples per packet
     UMTRX_UHD_PTR_NAMESPACE::shared_ptr<sph::send_packet_streamer> my_streamer = UMTRX_UHD_PTR_NAMESPACE::make_shared<sph::send_packet_streamer>(spp);
 
     //init some streamer stuff
     my_streamer->resize(args.channels.size());
-    my_streamer->set_vrt_packer(&vrt::if_hdr_pack_be, vrt_send_header_offset_words32);
+    my_streamer->set_vrt_packer(le? &umtrx_if_hdr_pack_le : &umtrx_if_hdr_pack_be, vrt_send_header_offset_words32);
 
     //set the converter
     uhd::convert::id_type id;
     id.input_format = args.cpu_format;
     id.num_inputs = 1;
-    id.output_format = args.otw_format + "_item32_be";
+    id.output_format = args.otw_format + (le? "_item32_le" : "_item32_be");
     id.num_outputs = 1;
     my_streamer->set_converter(id);
 
-    //shared async queue for all channels in streamer
-    boost::shared_ptr<async_md_type> async_md(new async_md_type(1000/*messages deep*/));
-    if (not _old_async_queue) _old_async_queue.reset(new async_md_type(1000/*messages deep*/));
-    my_streamer->set_async_receiver(boost::bind(&async_md_type::pop_with_timed_wait, async_md, boost::placeholders::_1, boost::placeholders::_2));
+    //optional parallel conversion and commit of the channels, ex: convert_threads=2,convert_cpu=3
+    const size_t convert_threads = args.args.cast<size_t>("convert_threads", 1);
+    std::vector<int> convert_cpus;
+    const int first_cpu = args.args.cast<int>("convert_cpu", -1); //negative leaves the workers unpinned
+    for (size_t i = 1; i < convert_threads and first_cpu >= 0; i++) convert_cpus.push_back(first_cpu + int(i) - 1);
+    my_streamer->set_converter_threads(convert_threads, convert_cpus, _rt_priority);
+    //prefault=1: warm the converters, the frames of the umtrx transports are also locked
+    if (args.args.cast<int>("prefault", 0) != 0) my_streamer->warm_up(spp);
+    //burst_len=N: the last packet of an N sample burst carries the end of burst,
+    //the end of burst call without samples sends no extra packet
+    my_streamer->set_burst_length(args.args.cast<size_t>("burst_len", 0));
+
+    //the streamer reads the msgs of all its channels by its tag
+    const boost::uint32_t async_tag = _async_ring->new_tag();
+    my_streamer->set_async_receiver(boost::bind(&umtrx_async_ring::cursor::pop,
+        _async_ring->make_cursor(async_tag), boost::placeholders::_1, boost::placeholders::_2));
 
     //bind callbacks for the handler
     for (size_t chan_i = 0; chan_i < args.channels.size(); chan_i++)
@@ -479,35 +1303,52 @@ uhd::tx_streamer::sptr umtrx_impl::get_tx_stream(const uhd::stream_args_t &args_
         const size_t dsp = args.channels[chan_i];
         _tx_dsps[dsp]->setup(args);
 
+        //optional idle fill between bursts, ex: idle_fill=1,idle_i=0,idle_q=0
+        const bool idle_fill = args.args.cast<int>("idle_fill", 0) != 0;
+        if (idle_fill and not _tx_idle_fill) throw uhd::not_implemented_error("idle_fill needs FPGA 9.13 or newer");
+        if (idle_fill and args.otw_format == "gmsk") throw uhd::value_error("idle_fill cannot send otw_format=gmsk");
+        //optional late packet policy, ex: late_policy=drop_packet
+        if (args.args.has_key("late_policy") and not _tx_late_policy) throw uhd::not_implemented_error("late_policy needs FPGA 9.27 or newer");
+        if (_tx_idle_fill) _tx_dsps[dsp]->set_idle_fill(idle_fill,
+            args.args.cast<boost::int16_t>("idle_i", 0), args.args.cast<boost::int16_t>("idle_q", 0));
+
         //set transmit sid -- needed by packet dispatcher to determine destination
-        boost::uint32_t sid = ~0;
-        if (dsp == 0) sid = UMTRX_DSP_TX0_SID;
-        if (dsp == 1) sid = UMTRX_DSP_TX1_SID;
-        UHD_ASSERT_THROW(sid != boost::uint32_t(~0));
+        const boost::uint32_t sid = UMTRX_DSP_TX_SIDS[dsp];
         my_streamer->set_xport_chan_sid(chan_i, true, sid);
 
         //create a flow control monitor
-        const size_t fc_window = UMTRX_SRAM_BYTES/xports[chan_i]->get_send_frame_size();
+        //the window is sized from this channel's share of the SRAM,
+        //and may be narrowed (never widened) with the fc_window_bytes arg
+        const size_t fc_window = this->get_tx_fc_window(dsp, args.args, xports[chan_i]->get_send_frame_size());
         flow_control_monitor::sptr fc_mon(new flow_control_monitor(fc_window));
 
-        //enable flow control packets
-        const double ups_per_sec = args.args.cast<double>("ups_per_sec", 20);
-        const double ups_per_fifo = args.args.cast<double>("ups_per_fifo", 8.0);
-        _tx_dsps[dsp]->set_updates(
-            (ups_per_sec > 0.0)? size_t(this->get_master_clock_rate()/ups_per_sec) : 0,
-            (ups_per_fifo > 0.0)? size_t(fc_window/ups_per_fifo) : 0
-        );
+        //flow control packets are enabled by update_tx_fc_window() once the rate is known,
+        //tx_latency_target (seconds) caps the window and raises the update cadence to match,
+        //fc_adaptive=1 sizes it from the measured acks within that cap (fc_adaptive_margin seconds on top)
+        {
+            boost::mutex::scoped_lock lock(_tx_fc_mutex);
+            tx_fc_state_t &fc = _tx_fc_state[dsp];
+            fc.monitor = fc_mon;
+            fc.max_window = fc_window;
+            fc.spp = spp;
+            fc.ups_per_sec = args.args.cast<double>("ups_per_sec", 20);
+            fc.ups_per_fifo = args.args.cast<double>("ups_per_fifo", 8.0);
+            fc.latency_target = args.args.cast<double>("tx_latency_target", 0.0);
+            if (fc.latency_target < 0.0) throw uhd::value_error("tx_latency_target must not be negative");
+            fc.adaptive = args.args.cast<int>("fc_adaptive", 0) != 0;
+            fc.adaptive_margin = args.args.cast<double>("fc_adaptive_margin", 0.001);
+            if (fc.adaptive_margin < 0.0) throw uhd::value_error("fc_adaptive_margin must not be negative");
+        }
 
-        //create async task for flow control and msgs
+        //route the flow control and msgs of this channel from the async loop
         boost::function<void(void)> stop_flow_control = boost::bind(&tx_dsp_core_200::set_updates, _tx_dsps[dsp], 0, 0);
-        task::sptr task = task::make(boost::bind(
-            &handle_tx_async_msgs, chan_i, this->get_master_clock_rate(),
-            fc_mon, xports[chan_i], stop_flow_control, async_md, _old_async_queue));
+        boost::shared_ptr<void> async_reg = _tx_async_loop->add(sid, chan_i, this->get_master_clock_rate(),
+            fc_mon, _tx_stream_stats[dsp], async_tag, stop_flow_control);
 
-        //buffer get method handles flow control and hold task reference count
-        my_streamer->set_xport_chan_get_buff(chan_i, boost::bind(
-            &get_send_buff, task, fc_mon, xports[chan_i], boost::placeholders::_1
-        ));
+        //buffer source handles flow control and holds the registration
+        my_streamer->set_xport_chan_buff_source(chan_i, boost::make_shared<umtrx_tx_buff_source>(
+            async_reg, fc_mon, _tx_stream_stats[dsp], xports[chan_i]));
+        my_streamer->set_xport_chan_stats(chan_i, _tx_stream_stats[dsp]);
 
         _tx_streamers[dsp] = my_streamer; //store weak pointer
     }
@@ -515,11 +1356,252 @@ uhd::tx_streamer::sptr umtrx_impl::get_tx_stream(const uhd::stream_args_t &args_
     //sets all tick and samp rates on this streamer
     this->update_rates();
 
+    //optional timed burst queue, ex: burst_queue=16,burst_cpu=3
+    if (args.args.has_key("burst_queue"))
+    {
+        const size_t depth = args.args.cast<size_t>("burst_queue", 0);
+        if (depth == 0) throw uhd::value_error("burst_queue must hold at least one burst");
+        umtrx_thread_placement placement;
+        placement.cpu = args.args.cast<int>("burst_cpu", -1);
+        placement.rt_priority = _rt_priority;
+        return umtrx_tx_burst_queue::make(my_streamer, depth,
+            convert::get_bytes_per_item(args.cpu_format), placement);
+    }
+
     return my_streamer;
 }
 
+/***********************************************************************
+ * TX flow control window and statistics
+ **********************************************************************/
+//minimum number of timed flow control updates within the latency target
+static const double TX_LATENCY_UPS_PER_TARGET = 4.0;
+
+//timed flow control updates of the adaptive window, the ack interval bounds its latency
+static const double TX_ADAPTIVE_UPS_PER_SEC = 500.0;
+static const size_t TX_ADAPTIVE_MIN_WINDOW = 2;
+
+//! Packets in flight the SRAM of a TX DSP takes, narrowed by the fc_window_bytes arg
+size_t umtrx_impl::get_tx_fc_window(const size_t dsp, const uhd::device_addr_t &args, const size_t frame_size) const
+{
+    const size_t fc_bytes = std::min(_tx_sram_bytes[dsp], args.cast<size_t>("fc_window_bytes", _tx_sram_bytes[dsp]));
+    return std::max<size_t>(1, fc_bytes/frame_size);
+}
+
+void umtrx_impl::update_tx_fc_window(const size_t dsp, const double rate)
+{
+    boost::mutex::scoped_lock lock(_tx_fc_mutex);
+    tx_fc_state_t &fc = _tx_fc_state[dsp];
+    flow_control_monitor::sptr fc_mon = fc.monitor.lock();
+    if (not fc_mon) return;
+    fc.samp_rate = rate;
+
+    size_t window = fc.max_window;
+    double ups_per_sec = fc.ups_per_sec;
+    double ups_per_fifo = fc.ups_per_fifo;
+    if (fc.latency_target > 0.0 and rate > 0.0)
+    {
+        const size_t target_window = size_t(fc.latency_target*rate/fc.spp);
+        window = std::max<size_t>(1, std::min(window, target_window));
+        ups_per_sec = std::max(ups_per_sec, TX_LATENCY_UPS_PER_TARGET/fc.latency_target);
+        if (ups_per_fifo <= 0.0) ups_per_fifo = 8.0;
+    }
+    if (fc.adaptive)
+    {
+        ups_per_sec = std::max(ups_per_sec, TX_ADAPTIVE_UPS_PER_SEC);
+        fc_mon->set_adaptive(flow_control_monitor::seq_type(std::min(window, TX_ADAPTIVE_MIN_WINDOW)),
+            flow_control_monitor::seq_type(window), fc.adaptive_margin);
+    }
+    else fc_mon->set_max_seqs_out(window);
+
+    _tx_dsps[dsp]->set_updates(
+        (ups_per_sec > 0.0)? size_t(this->get_master_clock_rate()/ups_per_sec) : 0,
+        (ups_per_fifo > 0.0)? std::max<size_t>(1, size_t(window/ups_per_fifo)) : 0
+    );
+}
+
+uhd::sensor_value_t umtrx_impl::get_tx_fc_in_flight(const size_t dsp)
+{
+    boost::mutex::scoped_lock lock(_tx_fc_mutex);
+    flow_control_monitor::sptr fc_mon = _tx_fc_state[dsp].monitor.lock();
+    const int in_flight = fc_mon? int(fc_mon->get_seqs_in_flight()) : 0;
+    return uhd::sensor_value_t("FC in flight", in_flight, "packets");
+}
+
+uhd::sensor_value_t umtrx_impl::get_tx_fc_ack_latency(const size_t dsp)
+{
+    //measured on the newest ack: the send of the packet to the ack that covers it
+    const double latency = _tx_stream_stats[dsp]->last_ack_latency_ns.load(boost::memory_order_relaxed)/1e9;
+    return uhd::sensor_value_t("FC ack latency", latency, "s");
+}
+
+uhd::sensor_value_t umtrx_impl::get_tx_fc_latency(const size_t dsp)
+{
+    //samples buffered between the host and the DAC, expressed in seconds
+    boost::mutex::scoped_lock lock(_tx_fc_mutex);
+    const tx_fc_state_t &fc = _tx_fc_state[dsp];
+    flow_control_monitor::sptr fc_mon = fc.monitor.lock();
+    const double latency = (fc_mon and fc.samp_rate > 0.0)? fc_mon->get_seqs_in_flight()*double(fc.spp)/fc.samp_rate : 0.0;
+    return uhd::sensor_value_t("FC latency", latency, "s");
+}
+
+/***********************************************************************
+ * TX loop playback from the SRAM
+ * load: the SRAM holds what a tx stream sends, nothing goes out
+ * play: the SRAM content repeats until off, the host data is dropped
+ * off: the normal path, the dsp clear flushes what is left
+ **********************************************************************/
+void umtrx_impl::set_tx_loop(const size_t dsp, const std::string &mode)
+{
+    boost::uint32_t bits = 0;
+    if (mode == "load") bits = 0x1;
+    else if (mode == "play") bits = 0x2;
+    else if (mode != "off") throw uhd::value_error("TX loop mode must be off, load or play, but got " + mode);
+
+    _tx_loop_bits = (_tx_loop_bits & ~(boost::uint32_t(0x3) << (2*dsp))) | (bits << (2*dsp));
+    _tx_dsps[dsp]->set_loop_playback(mode == "play");
+    _iface->poke32(U2_REG_TX_LOOP, _tx_loop_bits);
+    if (mode == "off") _tx_dsps[dsp]->clear();
+}
+
+/***********************************************************************
+ * Streaming metrics in the Prometheus text format
+ **********************************************************************/
+struct stream_metric_t
+{
+    const char *name;
+    const char *help;
+    stream_stats_t::counter_type stream_stats_t::*counter;
+    bool rx, tx;
+};
+
+static const stream_metric_t stream_metrics[] = {
+    {"packets_total", "Data packets", &stream_stats_t::packets, true, true},
+    {"bytes_total", "Data packet bytes on the wire", &stream_stats_t::bytes, true, true},
+    {"sequence_errors_total", "Packet sequence errors", &stream_stats_t::seq_errors, true, true},
+    {"alignment_failures_total", "Channel time alignment failures", &stream_stats_t::alignment_failures, true, false},
+    {"overflows_total", "Overflows reported by the device", &stream_stats_t::overflows, true, false},
+    {"underflows_total", "Underflows reported by the device", &stream_stats_t::underflows, false, true},
+    {"late_packets_total", "Packets that arrived late at the device", &stream_stats_t::late_packets, false, true},
+    {"filled_samples_total", "Samples filled in for lost packets", &stream_stats_t::filled_samples, true, false},
+    {"discarded_packets_total", "Packets dropped to time-align the channels", &stream_stats_t::discarded_packets, true, false},
+    {"restarts_total", "Stream restarts after an overflow", &stream_stats_t::restarts, true, false},
+    {"restart_gap_samples_total", "Samples lost between an overflow and the restart", &stream_stats_t::restart_gap_samples, true, false},
+    {"convert_seconds_total", "Time spent converting samples", &stream_stats_t::convert_ns, true, true},
+    {"stats_packets_total", "Statistics packets from the device", &stream_stats_t::stats_packets, true, false},
+    {"gain_events_total", "Gain change packets of the RX AGC", &stream_stats_t::gain_events, true, false},
+};
+
+//gauges from the latest statistics packet of the device
+static const stream_metric_t device_gauges[] = {
+    {"device_overflows", "Overflows counted by the device since the stream setup", &stream_stats_t::device_overflows, true, false},
+    {"device_packets", "Data packets framed by the device since the stream setup", &stream_stats_t::device_packets, true, false},
+    {"device_fifo_high_water", "Peak sample fifo fill over the last period, of 16", &stream_stats_t::device_fifo_high_water, true, false},
+    {"device_power", "Averaged baseband power, full scale 2^31", &stream_stats_t::device_power, true, false},
+    {"device_ticks", "Device time of the latest statistics packet", &stream_stats_t::device_ticks, true, false},
+    {"device_gain", "RXVGA2 gain of the latest AGC change, dB", &stream_stats_t::device_gain, true, false},
+};
+
+static void format_device_gauges(std::ostream &os, const std::vector<stream_stats_t::sptr> &stats)
+{
+    BOOST_FOREACH(const stream_metric_t &metric, device_gauges)
+    {
+        const std::string name = std::string("umtrx_rx_") + metric.name;
+        os << "# HELP " << name << " " << metric.help << "\n";
+        os << "# TYPE " << name << " gauge\n";
+        for (size_t dsp = 0; dsp < stats.size(); dsp++)
+        {
+            os << name << "{dsp=\"" << dsp << "\"} " << ((*stats[dsp]).*metric.counter).load(boost::memory_order_relaxed) << "\n";
+        }
+    }
+}
+
+static void format_stream_metrics(std::ostream &os, const std::string &dir, const std::vector<stream_stats_t::sptr> &stats)
+{
+    BOOST_FOREACH(const stream_metric_t &metric, stream_metrics)
+    {
+        if (not (dir == "rx"? metric.rx : metric.tx)) continue;
+        const std::string name = "umtrx_" + dir + "_" + metric.name;
+        os << "# HELP " << name << " " << metric.help << "\n";
+        os << "# TYPE " << name << " counter\n";
+        for (size_t dsp = 0; dsp < stats.size(); dsp++)
+        {
+            const boost::uint64_t value = ((*stats[dsp]).*metric.counter).load(boost::memory_order_relaxed);
+            os << name << "{dsp=\"" << dsp << "\"} ";
+            if (metric.counter == &stream_stats_t::convert_ns) os << value/1e9 << "\n";
+            else os << value << "\n";
+        }
+    }
+}
+
+static void format_stream_histogram(std::ostream &os, const std::string &dir, const std::string &stage,
+    latency_histogram_t stream_stats_t::*histogram, const std::vector<stream_stats_t::sptr> &stats)
+{
+    const std::string name = "umtrx_" + dir + "_" + stage + "_seconds";
+    os << "# HELP " << name << " Hot path latency of " << stage << "\n";
+    os << "# TYPE " << name << " histogram\n";
+    for (size_t dsp = 0; dsp < stats.size(); dsp++)
+    {
+        const latency_histogram_t &h = (*stats[dsp]).*histogram;
+        boost::uint64_t count = 0;
+        for (size_t i = 0; i < latency_histogram_t::NUM_BUCKETS; i++)
+        {
+            count += h.buckets[i].load(boost::memory_order_relaxed);
+            os << name << "_bucket{dsp=\"" << dsp << "\",le=\"";
+            if (i + 1 == latency_histogram_t::NUM_BUCKETS) os << "+Inf";
+            else os << latency_histogram_t::bucket_bound(i);
+            os << "\"} " << count << "\n";
+        }
+        os << name << "_sum{dsp=\"" << dsp << "\"} " << h.sum_ns.load(boost::memory_order_relaxed)/1e9 << "\n";
+        os << name << "_count{dsp=\"" << dsp << "\"} " << count << "\n";
+    }
+}
+
+std::string umtrx_impl::get_stream_metrics(void)
+{
+    std::ostringstream os;
+    format_stream_metrics(os, "rx", _rx_stream_stats);
+    format_stream_metrics(os, "tx", _tx_stream_stats);
+    format_device_gauges(os, _rx_stream_stats);
+
+    os << "# HELP umtrx_tx_async_dropped Async msgs a reader lost to ring overwrites\n";
+    os << "# TYPE umtrx_tx_async_dropped counter\n";
+    os << "umtrx_tx_async_dropped " << _async_ring->get_num_dropped() << "\n";
+    this->format_eth_metrics(os);
+
+    //flow control occupancy is a gauge of the current streamer
+    boost::mutex::scoped_lock lock(_tx_fc_mutex);
+    os << "# HELP umtrx_tx_fc_in_flight Packets sent but not yet acknowledged\n";
+    os << "# TYPE umtrx_tx_fc_in_flight gauge\n";
+    for (size_t dsp = 0; dsp < _tx_fc_state.size(); dsp++)
+    {
+        flow_control_monitor::sptr fc_mon = _tx_fc_state[dsp].monitor.lock();
+        os << "umtrx_tx_fc_in_flight{dsp=\"" << dsp << "\"} " << (fc_mon? fc_mon->get_seqs_in_flight() : 0) << "\n";
+    }
+    os << "# HELP umtrx_tx_fc_window Flow control window\n";
+    os << "# TYPE umtrx_tx_fc_window gauge\n";
+    for (size_t dsp = 0; dsp < _tx_fc_state.size(); dsp++)
+    {
+        flow_control_monitor::sptr fc_mon = _tx_fc_state[dsp].monitor.lock();
+        os << "umtrx_tx_fc_window{dsp=\"" << dsp << "\"} " << (fc_mon? fc_mon->get_max_seqs_out() : 0) << "\n";
+    }
+
+    format_stream_histogram(os, "rx", "wakeup", &stream_stats_t::wakeup_latency, _rx_stream_stats);
+    format_stream_histogram(os, "tx", "ack", &stream_stats_t::ack_latency, _tx_stream_stats);
+#ifdef UMTRX_STREAM_PROFILE
+    format_stream_histogram(os, "rx", "get_buff", &stream_stats_t::get_buff_latency, _rx_stream_stats);
+    format_stream_histogram(os, "rx", "vrt", &stream_stats_t::vrt_latency, _rx_stream_stats);
+    format_stream_histogram(os, "rx", "convert", &stream_stats_t::convert_latency, _rx_stream_stats);
+    format_stream_histogram(os, "tx", "get_buff", &stream_stats_t::get_buff_latency, _tx_stream_stats);
+    format_stream_histogram(os, "tx", "fc_wait", &stream_stats_t::fc_wait_latency, _tx_stream_stats);
+    format_stream_histogram(os, "tx", "vrt", &stream_stats_t::vrt_latency, _tx_stream_stats);
+    format_stream_histogram(os, "tx", "convert", &stream_stats_t::convert_latency, _tx_stream_stats);
+#endif
+    return os.str();
+}
+
 bool umtrx_impl::recv_async_msg(uhd::async_metadata_t &async_metadata, const double timeout)
 {
     boost::this_thread::disable_interruption di; //disable because the wait can throw
-    return _old_async_queue->pop_with_timed_wait(async_metadata, timeout);
+    return _old_async_cursor->pop(async_metadata, timeout);
 }
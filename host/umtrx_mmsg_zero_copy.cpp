@@ -0,0 +1,546 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_mmsg_zero_copy.hpp"
+#include "umtrx_frame_pool.hpp"
+#include "umtrx_thread_placement.hpp"
+#include "umtrx_log_adapter.hpp"
+#include "umtrx_if_hdr.hpp"
+#include <uhd/config.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/transport/udp_simple.hpp> //mtu
+#include <uhd/transport/bounded_buffer.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/bind/bind.hpp>
+#include <vector>
+#include <deque>
+#include <cstring>
+
+using namespace uhd;
+using namespace uhd::transport;
+
+#ifdef UHD_PLATFORM_LINUX
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+
+#ifndef UMTRX_EMBEDDED
+static const size_t DEFAULT_NUM_RECV_FRAMES = 256;
+#else
+static const size_t DEFAULT_NUM_RECV_FRAMES = 64;
+#endif
+static const size_t DEFAULT_NUM_SEND_FRAMES = 32;
+static const size_t DEFAULT_RECV_BATCH_SIZE = 32;
+static const size_t DEFAULT_SEND_BATCH_SIZE = 1; //send each frame on commit
+static const double DEFAULT_SEND_FLUSH_TIME = 1e-3;
+static const size_t FRAME_ALIGNMENT = 64; //cache line
+
+static size_t align_frame(const size_t size)
+{
+    return (size + FRAME_ALIGNMENT - 1) & ~(FRAME_ALIGNMENT - 1);
+}
+
+static int timeout_to_ms(const double timeout)
+{
+    return (timeout <= 0.0)? 0 : int(timeout*1e3 + 0.999);
+}
+
+static boost::int64_t clock_ns(const clockid_t clock)
+{
+    struct timespec ts;
+    ::clock_gettime(clock, &ts);
+    return boost::int64_t(ts.tv_sec)*1000000000 + ts.tv_nsec;
+}
+
+/***********************************************************************
+ * Managed buffers: released buffers return to their free list
+ **********************************************************************/
+class mmsg_zero_copy_mrb : public managed_recv_buffer
+{
+public:
+    mmsg_zero_copy_mrb(void *mem, bounded_buffer<mmsg_zero_copy_mrb *> &free_list):
+        mem(mem), len(0), _free_list(free_list)
+    {
+        //NOP
+    }
+
+    void release(void)
+    {
+        _free_list.push_with_haste(this);
+    }
+
+    UHD_INLINE sptr get_new(void)
+    {
+        return make(this, mem, len);
+    }
+
+    void *mem;
+    size_t len;
+
+private:
+    bounded_buffer<mmsg_zero_copy_mrb *> &_free_list;
+};
+
+class mmsg_zero_copy_msb;
+
+//! Committed send frames go to the transport, which sends them now or in a batch
+class mmsg_send_queue
+{
+public:
+    virtual ~mmsg_send_queue(void){}
+    virtual void enqueue(mmsg_zero_copy_msb *msb) = 0;
+};
+
+class mmsg_zero_copy_msb : public managed_send_buffer
+{
+public:
+    mmsg_zero_copy_msb(void *mem, const size_t frame_size, mmsg_send_queue &queue):
+        mem(mem), len(0), _frame_size(frame_size), _queue(queue)
+    {
+        //NOP
+    }
+
+    void release(void)
+    {
+        len = this->size();
+        _queue.enqueue(this);
+    }
+
+    UHD_INLINE sptr get_new(void)
+    {
+        return make(this, mem, _frame_size);
+    }
+
+    void *mem;
+    size_t len;
+
+private:
+    const size_t _frame_size;
+    mmsg_send_queue &_queue;
+};
+
+/***********************************************************************
+ * Batched receive transport implementation
+ **********************************************************************/
+class umtrx_mmsg_zero_copy_impl : public umtrx_mmsg_zero_copy, public mmsg_send_queue
+{
+public:
+    umtrx_mmsg_zero_copy_impl(const std::string &addr, const std::string &port, const device_addr_t &hints, stream_stats_t::sptr stats):
+        _recv_frame_size(size_t(hints.cast<double>("recv_frame_size", udp_simple::mtu))),
+        _send_frame_size(size_t(hints.cast<double>("send_frame_size", udp_simple::mtu))),
+        _num_recv_frames(size_t(hints.cast<double>("num_recv_frames", DEFAULT_NUM_RECV_FRAMES))),
+        _num_send_frames(size_t(hints.cast<double>("num_send_frames", DEFAULT_NUM_SEND_FRAMES))),
+        _batch_size(std::min(_num_recv_frames, size_t(hints.cast<double>("recv_batch_size", DEFAULT_RECV_BATCH_SIZE)))),
+        _send_batch_size(std::min(_num_send_frames, size_t(hints.cast<double>("send_batch_size", DEFAULT_SEND_BATCH_SIZE)))),
+        _send_flush_time(boost::posix_time::microseconds(long(hints.cast<double>("send_flush_time", DEFAULT_SEND_FLUSH_TIME)*1e6))),
+        _send_flusher_placement(hints, "tx_async_cpu", true),
+        _busy_poll(hints.cast<int>("busy_poll", 0) != 0),
+        _stats((_busy_poll or hints.cast<int>("wakeup_latency", 0) != 0)? stats : stream_stats_t::sptr()),
+        _sock_fd(-1),
+        _recv_free(_num_recv_frames),
+        _send_free(_num_send_frames),
+        _send_done(false)
+    {
+        UHD_ASSERT_THROW(_batch_size > 0);
+        UHD_ASSERT_THROW(_num_send_frames > 0);
+        UHD_ASSERT_THROW(_send_batch_size > 0);
+        this->open_socket(addr, port, hints);
+
+        //allocate the frame memory and the managed buffers
+        struct sockaddr_in peer;
+        socklen_t peer_len = sizeof(peer);
+        ::getpeername(_sock_fd, reinterpret_cast<struct sockaddr *>(&peer), &peer_len);
+        const size_t recv_bytes = _num_recv_frames*align_frame(_recv_frame_size);
+        _frame_pool = umtrx_frame_pool::make(recv_bytes + _num_send_frames*align_frame(_send_frame_size), hints, peer.sin_addr.s_addr);
+        char *recv_mem = _frame_pool->get();
+        char *send_mem = recv_mem + recv_bytes;
+        for (size_t i = 0; i < _num_recv_frames; i++)
+        {
+            _mrbs.push_back(new mmsg_zero_copy_mrb(recv_mem + i*align_frame(_recv_frame_size), _recv_free));
+            _recv_free.push_with_haste(_mrbs.back());
+        }
+        for (size_t i = 0; i < _num_send_frames; i++)
+        {
+            _msbs.push_back(new mmsg_zero_copy_msb(send_mem + i*align_frame(_send_frame_size), _send_frame_size, *this));
+            _send_free.push_with_haste(_msbs.back());
+        }
+
+        //pre-size the batch descriptors, the iovecs are filled per call
+        _msgs.resize(_batch_size);
+        _iovs.resize(_batch_size);
+        if (_stats) _cmsgs.resize(_batch_size*CMSG_SPACE(sizeof(struct timespec)));
+        _pending.reserve(_batch_size);
+        _send_queue.reserve(_send_batch_size);
+        _send_msgs.resize(_send_batch_size);
+        _send_iovs.resize(_send_batch_size);
+
+        //the flusher sends a partial batch once its deadline expires
+        if (_send_batch_size > 1)
+        {
+            _send_flusher.reset(new boost::thread(boost::bind(&umtrx_mmsg_zero_copy_impl::send_flusher_loop, this)));
+        }
+
+        UHD_MSG(status) << boost::format("umtrx_mmsg_zero_copy: %u recv frames, batch %u, send batch %u%s")
+            % _num_recv_frames % _batch_size % _send_batch_size % (_busy_poll? ", busy poll" : "") << std::endl;
+    }
+
+    ~umtrx_mmsg_zero_copy_impl(void)
+    {
+        if (_send_flusher)
+        {
+            {
+                boost::mutex::scoped_lock lock(_send_mutex);
+                _send_done = true;
+            }
+            _send_cond.notify_one();
+            _send_flusher->join();
+        }
+        {
+            boost::mutex::scoped_lock lock(_send_mutex);
+            this->flush_send_queue();
+        }
+        ::close(_sock_fd);
+        for (size_t i = 0; i < _mrbs.size(); i++) delete _mrbs[i];
+        for (size_t i = 0; i < _msbs.size(); i++) delete _msbs[i];
+    }
+
+    /*******************************************************************
+     * Receive: hand out frames from the ready queue,
+     * refill the queue with one recvmmsg() when it runs dry.
+     ******************************************************************/
+    managed_recv_buffer::sptr get_recv_buff(double timeout)
+    {
+        if (_ready.empty() and not this->fill_ready(timeout))
+        {
+            return managed_recv_buffer::sptr();
+        }
+        mmsg_zero_copy_mrb *mrb = _ready.front();
+        _ready.pop_front();
+        return mrb->get_new();
+    }
+
+    size_t get_num_recv_frames(void) const
+    {
+        return _num_recv_frames;
+    }
+
+    size_t get_recv_frame_size(void) const
+    {
+        return _recv_frame_size;
+    }
+
+    /*******************************************************************
+     * Send: committed frames are coalesced into one sendmmsg() call,
+     * flushed when the batch fills, at burst end, or on the deadline.
+     ******************************************************************/
+    managed_send_buffer::sptr get_send_buff(double timeout)
+    {
+        mmsg_zero_copy_msb *msb = NULL;
+        if (not _send_free.pop_with_haste(msb))
+        {
+            //the free frames may all be sitting in the batch
+            {
+                boost::mutex::scoped_lock lock(_send_mutex);
+                this->flush_send_queue();
+            }
+            if (not _send_free.pop_with_timed_wait(msb, timeout))
+            {
+                return managed_send_buffer::sptr();
+            }
+        }
+        return msb->get_new();
+    }
+
+    void enqueue(mmsg_zero_copy_msb *msb)
+    {
+        boost::mutex::scoped_lock lock(_send_mutex);
+        _send_queue.push_back(msb);
+        if (_send_queue.size() >= _send_batch_size or not umtrx_tx_is_coalescable(msb->mem, msb->len))
+        {
+            this->flush_send_queue();
+        }
+        else if (_send_queue.size() == 1)
+        {
+            _send_deadline = boost::get_system_time() + _send_flush_time;
+            lock.unlock();
+            _send_cond.notify_one();
+        }
+    }
+
+    size_t get_num_send_frames(void) const
+    {
+        return _num_send_frames;
+    }
+
+    size_t get_send_frame_size(void) const
+    {
+        return _send_frame_size;
+    }
+
+private:
+    void open_socket(const std::string &addr, const std::string &port, const device_addr_t &hints)
+    {
+        struct addrinfo hints_ai;
+        std::memset(&hints_ai, 0, sizeof(hints_ai));
+        hints_ai.ai_family = AF_INET;
+        hints_ai.ai_socktype = SOCK_DGRAM;
+        struct addrinfo *res = NULL;
+        if (::getaddrinfo(addr.c_str(), port.c_str(), &hints_ai, &res) != 0 or res == NULL)
+        {
+            throw uhd::io_error("umtrx_mmsg_zero_copy: cannot resolve " + addr);
+        }
+
+        _sock_fd = ::socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        const bool connected = (_sock_fd >= 0) and (::connect(_sock_fd, res->ai_addr, res->ai_addrlen) == 0);
+        ::freeaddrinfo(res);
+        if (not connected)
+        {
+            if (_sock_fd >= 0) ::close(_sock_fd);
+            throw uhd::io_error(str(boost::format("umtrx_mmsg_zero_copy: cannot connect to %s:%s: %s") % addr % port % strerror(errno)));
+        }
+
+        this->resize_buff(SO_RCVBUF, "recv_buff_size", hints);
+        this->resize_buff(SO_SNDBUF, "send_buff_size", hints);
+
+        //let the kernel spin on the NIC queue inside recvmmsg() too
+        if (hints.has_key("busy_poll_usecs"))
+        {
+            const int usecs = hints.cast<int>("busy_poll_usecs", 0);
+            if (::setsockopt(_sock_fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) != 0)
+            {
+                UHD_MSG(warning) << "umtrx_mmsg_zero_copy: SO_BUSY_POLL failed (needs CAP_NET_ADMIN to raise): " << strerror(errno) << std::endl;
+            }
+        }
+
+        //kernel arrival timestamps for the wakeup latency
+        if (_stats)
+        {
+            const int on = 1;
+            if (::setsockopt(_sock_fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) != 0) _stats.reset();
+        }
+    }
+
+    void resize_buff(const int opt, const std::string &key, const device_addr_t &hints)
+    {
+        if (not hints.has_key(key)) return;
+        const int requested = int(hints.cast<double>(key, 0.0));
+        int actual = 0;
+        socklen_t len = sizeof(actual);
+        ::setsockopt(_sock_fd, SOL_SOCKET, opt, &requested, sizeof(requested));
+        ::getsockopt(_sock_fd, SOL_SOCKET, opt, &actual, &len);
+        //linux reports the doubled bookkeeping size
+        if (actual/2 < requested)
+        {
+            UHD_MSG(warning) << boost::format(
+                "umtrx_mmsg_zero_copy: %s requested %d bytes, got %d bytes\n"
+                "Check the sysctl net.core.rmem_max / net.core.wmem_max limits."
+            ) % key % requested % (actual/2) << std::endl;
+        }
+    }
+
+    bool fill_ready(const double timeout)
+    {
+        //claim as many free frames as the batch will take
+        mmsg_zero_copy_mrb *mrb = NULL;
+        while (_pending.size() < _batch_size and _recv_free.pop_with_haste(mrb))
+        {
+            _pending.push_back(mrb);
+        }
+        if (_pending.empty())
+        {
+            if (not _recv_free.pop_with_timed_wait(mrb, timeout)) return false;
+            _pending.push_back(mrb);
+        }
+
+        //fast path: data is usually already waiting in the socket
+        int num_recvd = this->recv_batch();
+        if (num_recvd <= 0 and errno == EAGAIN and _busy_poll)
+        {
+            //spin on non-blocking reads until the caller's timeout
+            const boost::int64_t deadline = clock_ns(CLOCK_MONOTONIC) + boost::int64_t(std::max(timeout, 0.0)*1e9);
+            do num_recvd = this->recv_batch();
+            while (num_recvd <= 0 and errno == EAGAIN and clock_ns(CLOCK_MONOTONIC) < deadline);
+        }
+        else if (num_recvd <= 0 and errno == EAGAIN)
+        {
+            struct pollfd pfd;
+            pfd.fd = _sock_fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (::poll(&pfd, 1, timeout_to_ms(timeout)) <= 0) return false;
+            num_recvd = this->recv_batch();
+        }
+        if (num_recvd <= 0) return false;
+
+        if (_stats) this->record_wakeup_latency(num_recvd);
+        for (int i = 0; i < num_recvd; i++)
+        {
+            _pending[i]->len = _msgs[i].msg_len;
+            _ready.push_back(_pending[i]);
+        }
+        _pending.erase(_pending.begin(), _pending.begin() + num_recvd);
+        return true;
+    }
+
+    //! Send everything in the queue, call with the send mutex held
+    void flush_send_queue(void)
+    {
+        size_t num_sent = 0;
+        while (num_sent < _send_queue.size())
+        {
+            const size_t num_msgs = _send_queue.size() - num_sent;
+            for (size_t i = 0; i < num_msgs; i++)
+            {
+                _send_iovs[i].iov_base = _send_queue[num_sent + i]->mem;
+                _send_iovs[i].iov_len = _send_queue[num_sent + i]->len;
+                std::memset(&_send_msgs[i], 0, sizeof(_send_msgs[i]));
+                _send_msgs[i].msg_hdr.msg_iov = &_send_iovs[i];
+                _send_msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            const int ret = ::sendmmsg(_sock_fd, &_send_msgs.front(), num_msgs, 0);
+            if (ret < 0 and errno == EINTR) continue;
+            if (ret <= 0)
+            {
+                UHD_MSG(error) << "umtrx_mmsg_zero_copy: sendmmsg failed: " << strerror(errno) << std::endl;
+                break; //drop the rest of the batch, the frames are still recycled
+            }
+            num_sent += size_t(ret);
+        }
+        for (size_t i = 0; i < _send_queue.size(); i++)
+        {
+            _send_free.push_with_haste(_send_queue[i]);
+        }
+        _send_queue.clear();
+    }
+
+    void send_flusher_loop(void)
+    {
+        _send_flusher_placement.apply("umtrx_mmsg_zero_copy send flusher");
+        boost::mutex::scoped_lock lock(_send_mutex);
+        while (not _send_done)
+        {
+            if (_send_queue.empty()) _send_cond.wait(lock);
+            else if (boost::get_system_time() >= _send_deadline) this->flush_send_queue();
+            else _send_cond.timed_wait(lock, _send_deadline);
+        }
+    }
+
+    int recv_batch(void)
+    {
+        for (size_t i = 0; i < _pending.size(); i++)
+        {
+            _iovs[i].iov_base = _pending[i]->mem;
+            _iovs[i].iov_len = _recv_frame_size;
+            std::memset(&_msgs[i], 0, sizeof(_msgs[i]));
+            _msgs[i].msg_hdr.msg_iov = &_iovs[i];
+            _msgs[i].msg_hdr.msg_iovlen = 1;
+            if (_stats)
+            {
+                _msgs[i].msg_hdr.msg_control = &_cmsgs[i*CMSG_SPACE(sizeof(struct timespec))];
+                _msgs[i].msg_hdr.msg_controllen = CMSG_SPACE(sizeof(struct timespec));
+            }
+        }
+        errno = 0;
+        const int ret = ::recvmmsg(_sock_fd, &_msgs.front(), _pending.size(), MSG_DONTWAIT, NULL);
+        if (ret < 0 and errno != EAGAIN and errno != EWOULDBLOCK and errno != EINTR)
+        {
+            UHD_MSG(error) << "umtrx_mmsg_zero_copy: recvmmsg failed: " << strerror(errno) << std::endl;
+        }
+        if (ret < 0 and errno == EWOULDBLOCK) errno = EAGAIN;
+        return ret;
+    }
+
+    //! Time from the kernel receive timestamp of each datagram until now
+    void record_wakeup_latency(const int num_recvd)
+    {
+        const boost::int64_t now = clock_ns(CLOCK_REALTIME);
+        for (int i = 0; i < num_recvd; i++)
+        {
+            struct msghdr &hdr = _msgs[i].msg_hdr;
+            for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&hdr, cmsg))
+            {
+                if (cmsg->cmsg_level != SOL_SOCKET or cmsg->cmsg_type != SCM_TIMESTAMPNS) continue;
+                struct timespec ts;
+                std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                const boost::int64_t ns = now - (boost::int64_t(ts.tv_sec)*1000000000 + ts.tv_nsec);
+                _stats->wakeup_latency.record(boost::uint64_t(std::max<boost::int64_t>(ns, 0)));
+            }
+        }
+    }
+
+    const size_t _recv_frame_size, _send_frame_size;
+    const size_t _num_recv_frames, _num_send_frames;
+    const size_t _batch_size;
+    const size_t _send_batch_size;
+    const boost::posix_time::time_duration _send_flush_time;
+    const umtrx_thread_placement _send_flusher_placement; //follows the tx async threads
+    const bool _busy_poll;
+    stream_stats_t::sptr _stats; //set when recording the wakeup latency
+    int _sock_fd;
+
+    umtrx_frame_pool::sptr _frame_pool; //recv frames, then send frames
+    std::vector<mmsg_zero_copy_mrb *> _mrbs;
+    std::vector<mmsg_zero_copy_msb *> _msbs;
+    bounded_buffer<mmsg_zero_copy_mrb *> _recv_free;
+    bounded_buffer<mmsg_zero_copy_msb *> _send_free;
+
+    //receive state, only touched by the receiving thread
+    std::vector<mmsg_zero_copy_mrb *> _pending; //claimed, waiting for data
+    std::deque<mmsg_zero_copy_mrb *> _ready; //filled, waiting for the user
+    std::vector<struct mmsghdr> _msgs;
+    std::vector<struct iovec> _iovs;
+    std::vector<char> _cmsgs; //receive timestamps, one control buffer per message
+
+    //send batching state, shared by the sender and the flusher thread
+    boost::mutex _send_mutex;
+    boost::condition_variable _send_cond;
+    std::vector<mmsg_zero_copy_msb *> _send_queue;
+    std::vector<struct mmsghdr> _send_msgs;
+    std::vector<struct iovec> _send_iovs;
+    boost::system_time _send_deadline;
+    bool _send_done;
+    boost::scoped_ptr<boost::thread> _send_flusher;
+};
+
+zero_copy_if::sptr umtrx_mmsg_zero_copy::make(const std::string &addr, const std::string &port, const device_addr_t &hints, stream_stats_t::sptr stats)
+{
+    return zero_copy_if::sptr(new umtrx_mmsg_zero_copy_impl(addr, port, hints, stats));
+}
+
+#else //UHD_PLATFORM_LINUX
+
+zero_copy_if::sptr umtrx_mmsg_zero_copy::make(const std::string &, const std::string &, const device_addr_t &, stream_stats_t::sptr)
+{
+    throw uhd::not_implemented_error("umtrx_mmsg_zero_copy: recvmmsg transport requires linux");
+}
+
+#endif //UHD_PLATFORM_LINUX
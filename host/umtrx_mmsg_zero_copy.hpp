@@ -0,0 +1,61 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_MMSG_ZERO_COPY_HPP
+#define INCLUDED_UMTRX_MMSG_ZERO_COPY_HPP
+
+#include <uhd/transport/zero_copy.hpp>
+#include <uhd/types/device_addr.hpp>
+#include "cores/stream_stats.hpp"
+#include <string>
+
+/*!
+ * A connected UDP zero copy transport which fills a ring of
+ * receive frames with a single recvmmsg() syscall per batch.
+ * Committed send frames may be coalesced and flushed with sendmmsg()
+ * when the batch fills, at burst end (VRT EOB), or on a deadline.
+ *
+ * Transport hints (from the device or stream args):
+ *  - recv_frame_size, send_frame_size: frame sizes in bytes
+ *  - num_recv_frames: size of the receive ring (default 256)
+ *  - num_send_frames: number of send frames (default 32)
+ *  - recv_batch_size: max frames per recvmmsg() call (default 32)
+ *  - send_batch_size: max frames per sendmmsg() call (default 1, no batching)
+ *  - send_flush_time: deadline in seconds for a partial send batch (default 1e-3)
+ *  - recv_buff_size, send_buff_size: socket buffer sizes in bytes
+ *  - hugepage_size, numa_node, prefault: frame memory placement, see umtrx_frame_pool
+ *  - tx_async_cpu, rt_priority: send flusher placement, see umtrx_thread_placement
+ *  - busy_poll: 1 to spin with non-blocking reads up to the get_recv_buff()
+ *    timeout instead of sleeping in poll(), burns a core (default 0)
+ *  - busy_poll_usecs: SO_BUSY_POLL time of the socket, for the kernel side
+ *  - wakeup_latency: 1 to record the kernel arrival to delivery time into
+ *    the stats wakeup histogram, always on with busy_poll (default 0)
+ */
+class umtrx_mmsg_zero_copy : public virtual uhd::transport::zero_copy_if
+{
+public:
+    //! Make a new connected transport, throws on non-linux platforms
+    //! stats (optional) get the wakeup latency histogram
+    static uhd::transport::zero_copy_if::sptr make(
+        const std::string &addr,
+        const std::string &port,
+        const uhd::device_addr_t &hints,
+        stream_stats_t::sptr stats = stream_stats_t::sptr()
+    );
+};
+
+#endif /* INCLUDED_UMTRX_MMSG_ZERO_COPY_HPP */
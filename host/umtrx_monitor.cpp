@@ -16,11 +16,23 @@
 //
 
 #include "umtrx_impl.hpp"
+#include "umtrx_regs.hpp"
 #include "umtrx_log_adapter.hpp"
+#include "umtrx_trace.hpp"
 #include <uhd/types/sensors.hpp>
 #include <uhd/types/ranges.hpp>
 #include <boost/asio.hpp>
 #include <boost/foreach.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <sstream>
 
 using namespace uhd;
 using namespace uhd::usrp;
@@ -50,10 +62,17 @@ namespace asio = boost::asio;
  * print json.loads(f.readline())
  * {u'result': u'true'}
  *
- * #get the value of a tree entry, types can be BOOL, INT, DOUBLE, COMPLEX, SENSOR, RANGE
+ * #get the value of a tree entry, types can be BOOL, INT, DOUBLE, COMPLEX, SENSOR, RANGE, SNAPSHOT
  * s.send(json.dumps(dict(action='GET', path='/mboards/0/sensors/tempA', type='SENSOR'))+'\n')
  * print json.loads(f.readline())
- * {u'result': {u'unit': u'C', u'name': u'TempA', u'value': u'61.625000'}}
+ * {u'result': {u'unit': u'C', u'name': u'TempA', u'value': u'61.625000', u'age': u'0.41'}}
+ * #sensors are sampled in the background (sensor_poll_period in seconds, default 1, 0 disables)
+ * #and 'age' is how old the value is in seconds
+ *
+ * #get all the board sensors sampled together with the host time of the sample
+ * s.send(json.dumps(dict(action='GET', path='/mboards/0/sensor_snapshot', type='SNAPSHOT'))+'\n')
+ * print json.loads(f.readline())
+ * {u'result': {u'time': u'2026-10-14T10:21:05.123456', u'sensors': [{u'unit': u'C', u'name': u'TempA', u'value': u'61.625000'}, ...]}}
  *
  * #set the value of a tree entry, types can be BOOL, INT, DOUBLE, COMPLEX
  * s.send(json.dumps(dict(action='SET', path='/mboards/0/dboards/A/rx_frontends/0/freq/value', type='DOUBLE', value=1e9))+'\n')
@@ -64,114 +83,1151 @@ namespace asio = boost::asio;
  * s.send(json.dumps(dict(action='SET', path='/mboards/0/rx_frontends/A/dc_offset/value', type='COMPLEX', value=[0.1, 0.0]))+'\n')
  * print json.loads(f.readline())
  * {} #empty response means no error
+ *
+ * #get several entries of one type (default SENSOR) in one request, results are in order
+ * s.send(json.dumps(dict(action='GET_MANY', paths=['/mboards/0/sensors/tempA', '/mboards/0/sensors/tempB']))+'\n')
+ * print json.loads(f.readline())
+ * {u'result': [{u'result': {...}}, {u'result': {...}}]}
+ *
+ * #push sampled sensors when they change, no paths subscribes to all of them
+ * s.send(json.dumps(dict(action='SUBSCRIBE', paths=['/mboards/0/sensors/tempA']))+'\n')
+ * print json.loads(f.readline())
+ * {u'result': u'true'}
+ * print json.loads(f.readline()) #after the next sample
+ * {u'event': u'DELTA', u'time': u'...', u'sensors': [{u'path': u'/mboards/0/sensors/tempA', u'name': u'TempA', u'value': u'61.625000', u'unit': u'C'}]}
+ *
+ * #the history of the sampled sensors, a whole window in one request: resolution raw,
+ * #1s or 1m (min, mean and max of each interval), the last seconds (default 300),
+ * #no paths returns every numeric sensor; off with sensor_history=0 in the args
+ * s.send(json.dumps(dict(action='HISTORY', paths=['/mboards/0/sensors/tempA'], resolution='1m', seconds=3600))+'\n')
+ * print json.loads(f.readline())
+ * {u'result': {u'/mboards/0/sensors/tempA': [{u'time': u'1760437200.000', u'min': u'61.5', u'mean': u'61.6', u'max': u'61.75', u'count': u'60'}, ...]}}
+ *
+ * #streaming counters in the Prometheus text format, the same text is
+ * served to a plain HTTP GET of /metrics on the status port for scrapers
+ * s.send(json.dumps(dict(action='METRICS'))+'\n')
+ * print json.loads(f.readline())['result']
+ * umtrx_rx_packets_total{dsp="0"} 123456 ...
+ *
+ * #register access trace, on with trace=<entries> in the args or enable=<entries>
+ * #here (0 stops it), the newest count entries (default 1000), times in ns
+ * s.send(json.dumps(dict(action='TRACE', count=2))+'\n')
+ * print json.loads(f.readline())
+ * {u'result': {u'recorded': u'5821', u'events': [{u'time': u'812345', u'duration': u'41200', u'bus': u'spi', u'dir': u'write', u'slave': u'1', u'addr': u'16', u'data': u'0x00009a12'}, ...]}}
+ *
+ * #where the time of the newest span of a label went, by bus, direction and slave,
+ * #spans are open, open/<startup stage>, rx_tune and tx_tune, no span sums up the whole ring
+ * s.send(json.dumps(dict(action='TRACE_SUMMARY', span='rx_tune'))+'\n')
+ * print json.loads(f.readline())
+ * {u'result': {u'span': u'rx_tune', u'duration': u'1840000', u'rows': [{u'bus': u'spi', u'dir': u'read', u'slave': u'1', u'count': u'74', u'total': u'1510000', u'max': u'23000'}, ...]}}
+ *
+ * Compact binary framing, for clients polling at high rates.
+ * A client starting with a zero byte speaks binary for the whole connection.
+ * Every message is a frame: u32 payload length, then the payload.
+ * All integers and doubles are big endian, a string is a u16 length and bytes.
+ *
+ * request:  u32 seq, u8 action, u8 type, string path, [value for SET]
+ * response: u32 seq, u8 status, then the result on status 0 or a string error on status 1
+ *
+ * actions: 1 GET, 2 SET, 3 HAS (u8 result), 4 LIST (u16 count, strings),
+ *          5 SUBSCRIBE (u16 count, paths, none for all), 6 UNSUBSCRIBE
+ * types and their values:
+ *          1 STRING string, 2 BOOL u8, 3 INT i32, 4 DOUBLE f64, 5 COMPLEX f64 real, f64 imag,
+ *          6 SENSOR string name, string unit, f64 age, u8 sensor type ('b', 'i', 'r', 's'),
+ *            then u8, i32, f64 or string for the typed value,
+ *          7 RANGE u16 count, f64 start, stop, step for each
+ * A subscription push is a frame with seq 0xffffffff and status 2:
+ *          f64 seconds since the epoch, u16 count, then string path and SENSOR value for each.
+ *
+ * import struct
+ * path = '/mboards/0/sensors/tempA'
+ * req = struct.pack('>IBBH', 1, 1, 6, len(path)) + path
+ * s.send(struct.pack('>I', len(req)) + req)
  */
 
+//ring depths of the sensor history: raw samples, 15 minutes of seconds, a day of minutes
+static const size_t SENSOR_HISTORY_RAW = 600;
+static const size_t SENSOR_HISTORY_SECONDS = 900;
+static const size_t SENSOR_HISTORY_MINUTES = 1440;
+
 void umtrx_impl::status_monitor_start(const uhd::device_addr_t &device_addr)
 {
+    const umtrx_thread_placement placement(device_addr, "monitor_cpu", false);
+    if (_sensor_poll_period > 0 and device_addr.cast<int>("sensor_history", 1) != 0)
+    {
+        _sensor_history = umtrx_sensor_history::make(SENSOR_HISTORY_RAW, SENSOR_HISTORY_SECONDS, SENSOR_HISTORY_MINUTES);
+    }
+#ifdef UMTRX_EMBEDDED
+    if (device_addr.has_key("status_port"))
+    {
+        UHD_MSG(warning) << "The TCP monitor is not built in the embedded profile, status_port ignored" << std::endl;
+    }
+#else
     if (device_addr.has_key("status_port"))
     {
         UHD_MSG(status) << "Creating TCP monitor on port " << device_addr.get("status_port") << std::endl;
         _server_query_tcp_acceptor.reset(new asio::ip::tcp::acceptor(
             _server_query_io_service, asio::ip::tcp::endpoint(asio::ip::address::from_string("127.0.0.1"), device_addr.cast<int>("status_port", 0))));
-        _server_query_task = task::make(boost::bind(&umtrx_impl::server_query_handler, this));
+        this->server_query_accept();
+        _server_query_task = task::make(placement.wrap("status query server", boost::bind(&umtrx_impl::server_query_handler, this)));
     }
-    _status_monitor_task = task::make(boost::bind(&umtrx_impl::status_monitor_handler, this));
+#endif
+    _status_monitor_task = task::make(placement.wrap("status monitor", boost::bind(&umtrx_impl::status_monitor_handler, this)));
 }
 
-void umtrx_impl::status_monitor_stop(void)
+//! Join a task, a thread_group joins several side by side
+static void join_task(task::sptr &t)
 {
-    _status_monitor_task.reset();
-    _server_query_task.reset();
+    t.reset();
 }
 
-static bool wait_read_sockfd(const int sockfd, const size_t timeoutMs)
+void umtrx_impl::status_monitor_stop(void)
 {
-    //setup timeval for timeout
-    timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = timeoutMs*1000;
-
-    //setup rset for timeout
-    fd_set rset;
-    FD_ZERO(&rset);
-    FD_SET(sockfd, &rset);
-
-    //call select with timeout on receive socket
-    return ::select(sockfd+1, &rset, NULL, NULL, &tv) > 0;
+    //each task may sit in a timed read, the joins overlap instead of adding up
+    boost::thread_group joins;
+    joins.create_thread(boost::bind(&join_task, boost::ref(_gpsdo_task)));
+    joins.create_thread(boost::bind(&join_task, boost::ref(_status_monitor_task)));
+#ifndef UMTRX_EMBEDDED
+    _server_query_io_service.stop();
+    joins.create_thread(boost::bind(&join_task, boost::ref(_server_query_task)));
+#endif
+    joins.join_all();
 }
 
 void umtrx_impl::status_monitor_handler(void)
 {
-    //TODO read the sensors and react...
-    //read_dc_v, etc...
-    //UHD_MSG(status) << this->read_temp_c("A").to_pp_string() << std::endl;
+    //refresh the sensor cache, property reads are served from it
+    if (_sensor_poll_period > 0)
+    {
+        try
+        {
+            this->update_sensor_cache();
+            boost::shared_ptr<const umtrx_sensor_cache_t> cache = boost::atomic_load(&_sensor_cache);
+            if (_sensor_history) _sensor_history->record(
+                (cache->time - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_microseconds()/1e6, cache->sensors);
+            this->protection_update(*cache);
+            this->power_loop_update(*cache);
+            this->fe_temperature_update(*cache);
+#ifndef UMTRX_EMBEDDED
+            if (_server_query_tcp_acceptor) _server_query_io_service.post(boost::bind(&umtrx_impl::server_push_deltas, this, cache));
+#endif
+        }
+        catch (const std::exception &ex)
+        {
+            UHD_MSG(error) << "Sensor sampling failed: " << ex.what() << std::endl;
+        }
+    }
 
-    //TODO shutdown frontend when temp > thresh
-    //ctrl->set_rx_enabled(false);
-    //ctrl->set_tx_enabled(false);
+    //one readback per period keeps the host time model fitted
+    try
+    {
+        _time_model->get_time_now();
+    }
+    catch (const std::exception &ex)
+    {
+        UHD_MSG(error) << "Time model readback failed: " << ex.what() << std::endl;
+    }
 
     //this sleep defines the polling time between status checks
     //when the handler completes, it will be called again asap
     //if the task is canceled, this sleep in interrupted for exit
-    boost::this_thread::sleep(boost::posix_time::milliseconds(1500));
+    const double period = (_sensor_poll_period > 0)? _sensor_poll_period : 1.5;
+    boost::this_thread::sleep(boost::posix_time::milliseconds(long(period*1000)));
 }
 
-void umtrx_impl::server_query_handler(void)
+/***********************************************************************
+ * GPSDO telemetry:
+ * The firmware pushes a report after every PPS to the last host that sent
+ * a packet to UMTRX_UDP_GPSDO_PORT. The sensors read the latest report,
+ * a board that stops reporting is subscribed again. Each report is also
+ * a PPS event for the umtrx_pps_events callbacks and waiters.
+ **********************************************************************/
+static const double GPSDO_REPORT_TIMEOUT = 3.0; //seconds without a report before it is stale
+
+void umtrx_impl::gpsdo_telemetry_start(const uhd::device_addr_t &device_addr, const fs_path &mb_path)
 {
-    //accept the client socket (timeout is 100 ms, task is called again)
-    if (not wait_read_sockfd(_server_query_tcp_acceptor->native_handle(), 100)) return;
-    boost::shared_ptr<asio::ip::tcp::socket> socket(new asio::ip::tcp::socket(_server_query_io_service));
-    _server_query_tcp_acceptor->accept(*socket);
+    //optional fast acquire, ex: gpsdo_fast_gain=2,gpsdo_fast_threshold=10
+    //P and I gains times 2^gain while the error is above threshold Hz
+    if (device_addr.has_key("gpsdo_fast_gain"))
+    {
+        const boost::uint32_t gain = device_addr.cast<boost::uint32_t>("gpsdo_fast_gain", 0);
+        const boost::uint32_t threshold = device_addr.cast<boost::uint32_t>("gpsdo_fast_threshold", 10);
+        _iface->send_zpu_action(UMTRX_ZPU_REQUEST_SET_GPSDO_FAST_ACQ, (threshold << 8) | (gain & 0xff));
+    }
 
-    //create a new thread to handle the client
-    boost::thread handler(boost::bind(&umtrx_impl::client_query_handle, this, socket));
-    handler.detach();
+    //optional GPS time of day, ex: gps_time=once
+    //the firmware latches the NMEA time into the time registers at the next PPS
+    if (device_addr.has_key("gps_time"))
+    {
+        const std::string mode = device_addr["gps_time"];
+        boost::uint32_t action = 0;
+        if (mode == "off") action = 0;
+        else if (mode == "once") action = 1;
+        else if (mode == "always") action = 2;
+        else throw uhd::value_error("gps_time must be off, once or always, got " + mode);
+        if (_iface->peekfw(U2_FW_REG_VER_MINOR) < UMTRX_FW_GPS_TIME_MINOR)
+            UHD_MSG(warning) << "The firmware does not support gps_time, update it" << std::endl;
+        else _iface->send_zpu_action(UMTRX_ZPU_REQUEST_SET_GPS_TIME, action);
+    }
+
+    std::memset(&_gpsdo_telemetry, 0, sizeof(_gpsdo_telemetry));
+    _gpsdo_time = boost::posix_time::not_a_date_time;
+    _gpsdo_pps_flag = _iface->peekfw(U2_FW_REG_VER_MINOR) >= UMTRX_FW_PPS_EVENT_MINOR;
+    _pps_event_count = 0;
+    _pps_callback_next = 0;
+    create_cached_sensor(mb_path / "sensors" / "gpsdo_locked",
+        boost::bind(&umtrx_impl::get_gpsdo_sensor, this, "locked"));
+    create_cached_sensor(mb_path / "sensors" / "gpsdo_freq_error",
+        boost::bind(&umtrx_impl::get_gpsdo_sensor, this, "freq_error"));
+    create_cached_sensor(mb_path / "sensors" / "gpsdo_dac",
+        boost::bind(&umtrx_impl::get_gpsdo_sensor, this, "dac"));
+    create_cached_sensor(mb_path / "sensors" / "gpsdo_time_set",
+        boost::bind(&umtrx_impl::get_gpsdo_sensor, this, "time_set"));
+
+    _gpsdo_xport = uhd::transport::udp_simple::make_connected(_device_ip_addr, BOOST_STRINGIZE(UMTRX_UDP_GPSDO_PORT));
+    const boost::uint32_t subscribe = htonl(USRP2_FW_COMPAT_NUM);
+    _gpsdo_xport->send(asio::buffer(&subscribe, sizeof(subscribe)));
+    _gpsdo_task = task::make(boost::bind(&umtrx_impl::gpsdo_telemetry_handler, this));
 }
 
-void umtrx_impl::client_query_handle(boost::shared_ptr<boost::asio::ip::tcp::socket> socket)
+void umtrx_impl::gpsdo_telemetry_handler(void)
 {
-    while (not boost::this_thread::interruption_requested())
+    umtrx_gpsdo_telemetry_t report;
+    const size_t len = _gpsdo_xport->recv(asio::buffer(&report, sizeof(report)), 0.5);
+    const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+    if (len < sizeof(report) or ntohl(report.id) != UMTRX_GPSDO_TELEMETRY_ID)
     {
-        boost::property_tree::ptree request, response;
+        //the firmware restarted or dropped the subscription
+        boost::mutex::scoped_lock l(_gpsdo_mutex);
+        if (_gpsdo_time.is_not_a_date_time() or now - _gpsdo_time > boost::posix_time::milliseconds(long(GPSDO_REPORT_TIMEOUT*1000)))
+        {
+            const boost::uint32_t subscribe = htonl(USRP2_FW_COMPAT_NUM);
+            _gpsdo_xport->send(asio::buffer(&subscribe, sizeof(subscribe)));
+        }
+        return;
+    }
+
+    boost::mutex::scoped_lock l(_gpsdo_mutex);
+    _gpsdo_telemetry.seq = ntohl(report.seq);
+    _gpsdo_telemetry.pps_secs = ntohl(report.pps_secs);
+    _gpsdo_telemetry.pps_ticks = ntohl(report.pps_ticks);
+    _gpsdo_telemetry.freq = ntohl(report.freq);
+    _gpsdo_telemetry.freq_lpf = ntohl(report.freq_lpf);
+    _gpsdo_telemetry.freq_error = boost::int32_t(ntohl(boost::uint32_t(report.freq_error)));
+    _gpsdo_telemetry.dac = ntohs(report.dac);
+    _gpsdo_telemetry.flags = ntohs(report.flags);
+    _gpsdo_time = now;
+
+    event_type &event = _pps_event;
+    event.time = time_spec_t(time_t(_gpsdo_telemetry.pps_secs), long(_gpsdo_telemetry.pps_ticks), this->get_master_clock_rate());
+    event.seq = _gpsdo_telemetry.seq;
+    event.measured = (not _gpsdo_pps_flag) or (_gpsdo_telemetry.flags & UMTRX_GPSDO_FLAG_PPS_VALID) != 0;
+    event.gpsdo_locked = (_gpsdo_telemetry.flags & UMTRX_GPSDO_FLAG_LOCKED) != 0;
+    event.gps_time_set = (_gpsdo_telemetry.flags & UMTRX_GPSDO_FLAG_TIME_SET) != 0;
+    event.freq_error = _gpsdo_telemetry.freq_error/8.0;
+    _pps_event_count++;
+    _pps_event_cond.notify_all();
+    const event_type event_copy = event;
+    l.unlock();
 
-        //receive the request in JSON markup
-        boost::asio::streambuf requestBuff;
+    //the callbacks run without the gpsdo mutex, they may read the sensors
+    boost::recursive_mutex::scoped_lock cl(_pps_callbacks_mutex);
+    const std::map<size_t, callback_type> callbacks = _pps_callbacks;
+    typedef std::pair<size_t, callback_type> callback_pair_t;
+    BOOST_FOREACH(const callback_pair_t &callback, callbacks)
+    {
         try
         {
-            boost::asio::read_until(*socket, requestBuff, "\n");
-            std::istream is(&requestBuff);
-            boost::property_tree::read_json(is, request);
+            callback.second(event_copy);
         }
         catch (const std::exception &ex)
         {
-            if (requestBuff.size() == 0) return; //client ended
-            response.put("error", "request parser error: " + std::string(ex.what()));
+            UHD_MSG(error) << "PPS callback: " << ex.what() << std::endl;
+        }
+    }
+}
+
+size_t umtrx_impl::add_pps_callback(const callback_type &callback)
+{
+    boost::recursive_mutex::scoped_lock cl(_pps_callbacks_mutex);
+    _pps_callbacks[_pps_callback_next] = callback;
+    return _pps_callback_next++;
+}
+
+void umtrx_impl::remove_pps_callback(const size_t id)
+{
+    //waits for a dispatch in progress, the reports thread may call it from a callback
+    boost::recursive_mutex::scoped_lock cl(_pps_callbacks_mutex);
+    _pps_callbacks.erase(id);
+}
+
+bool umtrx_impl::recv_pps_event(event_type &event, const double timeout)
+{
+    boost::this_thread::disable_interruption di; //disable because the wait can throw
+    boost::mutex::scoped_lock l(_gpsdo_mutex);
+    const size_t count = _pps_event_count;
+    const boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds(long(timeout*1e6));
+    while (_pps_event_count == count)
+    {
+        if (not _pps_event_cond.timed_wait(l, deadline)) return false;
+    }
+    event = _pps_event;
+    return true;
+}
+
+sensor_value_t umtrx_impl::get_gpsdo_sensor(const std::string &which)
+{
+    boost::mutex::scoped_lock l(_gpsdo_mutex);
+    const bool fresh = not _gpsdo_time.is_not_a_date_time() and
+        boost::posix_time::microsec_clock::universal_time() - _gpsdo_time < boost::posix_time::milliseconds(long(GPSDO_REPORT_TIMEOUT*1000));
+    if (which == "locked") return sensor_value_t("GPSDO", fresh and (_gpsdo_telemetry.flags & UMTRX_GPSDO_FLAG_LOCKED) != 0, "locked", "unlocked");
+    if (which == "time_set") return sensor_value_t("GPS time", fresh and (_gpsdo_telemetry.flags & UMTRX_GPSDO_FLAG_TIME_SET) != 0, "set", "unset");
+    if (which == "freq_error") return sensor_value_t("GPSDO frequency error", _gpsdo_telemetry.freq_error/8.0, "Hz");
+    return sensor_value_t("GPSDO DAC", int(_gpsdo_telemetry.dac), "");
+}
+
+/***********************************************************************
+ * Ethernet MAC counters:
+ * The frame, error and PAUSE counters of the MAC read in one batch,
+ * so the sensors and the metrics of a drop diagnosis cost one control
+ * round trip. A read within ETH_STATS_MAX_AGE reuses the last batch.
+ * Device drops show as rx_overruns, NIC and switch drops as sequence
+ * errors on the host without them.
+ **********************************************************************/
+static const double ETH_STATS_MAX_AGE = 0.05; //seconds
+
+struct eth_stat_t
+{
+    const char *name; //sensor eth_<name> and metric umtrx_eth_<name>
+    boost::uint32_t reg;
+    const char *help;
+};
+
+static const eth_stat_t ETH_STATS[] = {
+    {"rx_frames", U2_REG_ETH_MAC_RX_FRAMES_RB, "Good frames the MAC received"},
+    {"rx_errors", U2_REG_ETH_MAC_RX_ERRORS_RB, "Frames with CRC, length or GMII errors"},
+    {"rx_overruns", U2_REG_ETH_MAC_RX_OVERRUNS_RB, "Frames the MAC dropped on a full rx fifo"},
+    {"tx_frames", U2_REG_ETH_MAC_TX_FRAMES_RB, "Frames the MAC sent"},
+    {"pause_rcvd", U2_REG_ETH_MAC_PAUSE_RCVD_RB, "PAUSE frames the MAC received"},
+    {"pause_sent", U2_REG_ETH_MAC_PAUSE_SENT_RB, "PAUSE frames the MAC sent"},
+};
+static const size_t NUM_ETH_STATS = sizeof(ETH_STATS)/sizeof(ETH_STATS[0]);
+
+void umtrx_impl::eth_stats_start(const fs_path &mb_path)
+{
+    _eth_stats_time = boost::posix_time::ptime(boost::posix_time::min_date_time); //stale, the first read goes to the MAC
+    for (size_t i = 0; i < NUM_ETH_STATS; i++)
+    {
+        create_cached_sensor(mb_path / "sensors" / (std::string("eth_") + ETH_STATS[i].name),
+            boost::bind(&umtrx_impl::get_eth_stat, this, i));
+    }
+}
+
+std::vector<boost::uint32_t> umtrx_impl::read_eth_stats(void)
+{
+    boost::mutex::scoped_lock l(_eth_stats_mutex);
+    if (_eth_stats_time.is_not_a_date_time()) return std::vector<boost::uint32_t>(); //not started: an older FPGA
+    const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+    if (not _eth_stats.empty() and now - _eth_stats_time < boost::posix_time::microseconds(long(ETH_STATS_MAX_AGE*1e6))) return _eth_stats;
+
+    umtrx_ctrl_batch batch;
+    std::vector<size_t> index(NUM_ETH_STATS);
+    for (size_t i = 0; i < NUM_ETH_STATS; i++) index[i] = batch.peek32(ETH_STATS[i].reg);
+    _iface->transact_batch(batch);
+    _eth_stats.resize(NUM_ETH_STATS);
+    for (size_t i = 0; i < NUM_ETH_STATS; i++) _eth_stats[i] = batch.get(index[i]);
+    _eth_stats_time = now;
+    return _eth_stats;
+}
+
+sensor_value_t umtrx_impl::get_eth_stat(const size_t which)
+{
+    const std::vector<boost::uint32_t> stats = this->read_eth_stats();
+    const std::string name = std::string("Ethernet ") + ETH_STATS[which].name;
+    return sensor_value_t(name, stats.empty()? 0.0 : double(stats.at(which)), "frames", "%.0f");
+}
+
+void umtrx_impl::format_eth_metrics(std::ostream &os)
+{
+    const std::vector<boost::uint32_t> stats = this->read_eth_stats();
+    if (stats.empty()) return;
+    for (size_t i = 0; i < NUM_ETH_STATS; i++)
+    {
+        os << "# HELP umtrx_eth_" << ETH_STATS[i].name << " " << ETH_STATS[i].help << "\n";
+        os << "# TYPE umtrx_eth_" << ETH_STATS[i].name << " counter\n";
+        os << "umtrx_eth_" << ETH_STATS[i].name << " " << stats[i] << "\n";
+    }
+}
+
+/***********************************************************************
+ * Sensor cache:
+ * The monitor samples every sensor once per sensor_poll_period seconds
+ * (device arg, 0 disables) and swaps in a new cache. Property reads take
+ * the cached value, or go to the hardware when there is no fresh cache.
+ * A tune expires the cached LO lock of its frontend until the next sample.
+ **********************************************************************/
+void umtrx_impl::create_cached_sensor(const fs_path &path, const boost::function<sensor_value_t(void)> &read)
+{
+    _sensor_readers[path] = read;
+    _tree->create<sensor_value_t>(path)
+        .publish(boost::bind(&umtrx_impl::get_cached_sensor, this, std::string(path)));
+}
+
+void umtrx_impl::update_sensor_cache(void)
+{
+    boost::shared_ptr<umtrx_sensor_cache_t> cache(new umtrx_sensor_cache_t());
+
+    //board sensors come in one request, in slot order
+    this->sensor_sequencer_step();
+    cache->board = this->read_sensor_snapshot();
+    size_t index = 0;
+    for (size_t slot = 0; slot < UMTRX_SENSORS_NUM; slot++)
+    {
+        if ((_sensors_mask & (1 << slot)) == 0) continue;
+        cache->sensors.insert(std::make_pair(_sensor_slot_paths[slot], cache->board.sensors.at(index++)));
+    }
+
+    //the rest (LO lock) one by one
+    typedef std::pair<std::string, boost::function<sensor_value_t(void)> > reader_pair_t;
+    BOOST_FOREACH(const reader_pair_t &reader, _sensor_readers)
+    {
+        if (cache->sensors.count(reader.first) == 0) cache->sensors.insert(std::make_pair(reader.first, reader.second()));
+    }
+
+    cache->time = boost::posix_time::microsec_clock::universal_time();
+    boost::atomic_store(&_sensor_cache, boost::shared_ptr<const umtrx_sensor_cache_t>(cache));
+}
+
+boost::shared_ptr<const umtrx_sensor_cache_t> umtrx_impl::get_sensor_cache(void)
+{
+    boost::shared_ptr<const umtrx_sensor_cache_t> cache = boost::atomic_load(&_sensor_cache);
+    if (not cache or _sensor_poll_period <= 0) return boost::shared_ptr<const umtrx_sensor_cache_t>();
+
+    //a sampler that missed a few periods is stuck, dont serve its values
+    const boost::posix_time::time_duration age = boost::posix_time::microsec_clock::universal_time() - cache->time;
+    if (age > boost::posix_time::milliseconds(long(3*_sensor_poll_period*1000))) return boost::shared_ptr<const umtrx_sensor_cache_t>();
+    return cache;
+}
+
+sensor_value_t umtrx_impl::get_cached_sensor(const std::string &path)
+{
+    boost::shared_ptr<const umtrx_sensor_cache_t> cache = this->get_sensor_cache();
+    if (cache)
+    {
+        std::map<std::string, sensor_value_t>::const_iterator it = cache->sensors.find(path);
+        if (it != cache->sensors.end() and not this->is_sensor_expired(path, cache->time)) return it->second;
+    }
+    std::map<std::string, boost::function<sensor_value_t(void)> >::const_iterator reader = _sensor_readers.find(path);
+    UHD_ASSERT_THROW(reader != _sensor_readers.end());
+    return reader->second();
+}
+
+umtrx_sensor_snapshot_t umtrx_impl::get_cached_snapshot(void)
+{
+    boost::shared_ptr<const umtrx_sensor_cache_t> cache = this->get_sensor_cache();
+    if (cache) return cache->board;
+    return this->read_sensor_snapshot();
+}
+
+void umtrx_impl::expire_cached_sensor(const std::string &path)
+{
+    //ex: a tune makes the cached LO lock meaningless until the next sample
+    boost::mutex::scoped_lock lock(_sensor_expired_mutex);
+    _sensor_expired[path] = boost::posix_time::microsec_clock::universal_time();
+}
+
+bool umtrx_impl::is_sensor_expired(const std::string &path, const boost::posix_time::ptime &cache_time)
+{
+    boost::mutex::scoped_lock lock(_sensor_expired_mutex);
+    std::map<std::string, boost::posix_time::ptime>::const_iterator it = _sensor_expired.find(path);
+    return it != _sensor_expired.end() and it->second > cache_time;
+}
+
+double umtrx_impl::get_sensor_age(const std::string &path)
+{
+    //age of the value a read of path returns now, 0 when read directly
+    boost::shared_ptr<const umtrx_sensor_cache_t> cache = this->get_sensor_cache();
+    if (not cache or cache->sensors.count(path) == 0 or this->is_sensor_expired(path, cache->time)) return 0.0;
+    const boost::posix_time::time_duration age = boost::posix_time::microsec_clock::universal_time() - cache->time;
+    return age.total_microseconds()/1e6;
+}
+
+#ifndef UMTRX_EMBEDDED //the status server from here on
+
+/***********************************************************************
+ * Binary framing helpers
+ **********************************************************************/
+enum
+{
+    WIRE_GET = 1, WIRE_SET = 2, WIRE_HAS = 3, WIRE_LIST = 4,
+    WIRE_SUBSCRIBE = 5, WIRE_UNSUBSCRIBE = 6
+};
+
+enum
+{
+    WIRE_STRING = 1, WIRE_BOOL = 2, WIRE_INT = 3, WIRE_DOUBLE = 4,
+    WIRE_COMPLEX = 5, WIRE_SENSOR = 6, WIRE_RANGE = 7
+};
+
+enum
+{
+    WIRE_OK = 0, WIRE_ERROR = 1, WIRE_EVENT = 2
+};
+
+static const boost::uint32_t WIRE_EVENT_SEQ = 0xffffffff;
+static const size_t WIRE_MAX_FRAME = 1 << 16;
+
+class wire_writer
+{
+public:
+    void put_u8(const boost::uint8_t v)
+    {
+        _out.push_back(char(v));
+    }
+
+    void put_u16(const boost::uint16_t v)
+    {
+        put_u8(v >> 8);
+        put_u8(v & 0xff);
+    }
+
+    void put_u32(const boost::uint32_t v)
+    {
+        put_u16(v >> 16);
+        put_u16(v & 0xffff);
+    }
+
+    void put_f64(const double v)
+    {
+        boost::uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        put_u32(boost::uint32_t(bits >> 32));
+        put_u32(boost::uint32_t(bits & 0xffffffff));
+    }
+
+    void put_str(const std::string &s)
+    {
+        //longer strings are cut, a u16 fits every path and sensor value
+        const size_t len = std::min<size_t>(s.size(), 0xffff);
+        put_u16(boost::uint16_t(len));
+        _out.append(s, 0, len);
+    }
+
+    void put_sensor(const sensor_value_t &sensor, const double age)
+    {
+        put_str(sensor.name);
+        put_str(sensor.unit);
+        put_f64(age);
+        put_u8(boost::uint8_t(sensor.type));
+        switch (sensor.type)
+        {
+        case sensor_value_t::BOOLEAN: put_u8(sensor.to_bool()? 1 : 0); break;
+        case sensor_value_t::INTEGER: put_u32(boost::uint32_t(sensor.to_int())); break;
+        case sensor_value_t::REALNUM: put_f64(sensor.to_real()); break;
+        default: put_str(sensor.value); break;
+        }
+    }
+
+    std::string &str(void)
+    {
+        return _out;
+    }
+
+private:
+    std::string _out;
+};
+
+class wire_reader
+{
+public:
+    wire_reader(const std::string &in):
+        _in(in), _pos(0)
+    {
+        //NOP
+    }
+
+    boost::uint8_t get_u8(void)
+    {
+        this->need(1);
+        return boost::uint8_t(_in[_pos++]);
+    }
+
+    boost::uint16_t get_u16(void)
+    {
+        const boost::uint16_t hi = get_u8();
+        return boost::uint16_t((hi << 8) | get_u8());
+    }
+
+    boost::uint32_t get_u32(void)
+    {
+        const boost::uint32_t hi = get_u16();
+        return (hi << 16) | get_u16();
+    }
+
+    double get_f64(void)
+    {
+        const boost::uint64_t hi = get_u32();
+        const boost::uint64_t bits = (hi << 32) | get_u32();
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+    std::string get_str(void)
+    {
+        const size_t len = get_u16();
+        this->need(len);
+        _pos += len;
+        return _in.substr(_pos - len, len);
+    }
+
+private:
+    void need(const size_t n)
+    {
+        if (_in.size() - _pos < n) throw uhd::value_error("truncated binary request");
+    }
+
+    const std::string &_in;
+    size_t _pos;
+};
+
+/***********************************************************************
+ * Status server:
+ * All clients are served by one asio event loop on the server task.
+ * A session reads newline terminated JSON requests, or binary frames
+ * when the first byte is zero, and queues the responses.
+ * A plain HTTP GET of /metrics is answered once and closed.
+ * Subscription pushes are queued on the same session.
+ **********************************************************************/
+class umtrx_status_session : public boost::enable_shared_from_this<umtrx_status_session>
+{
+public:
+    typedef boost::shared_ptr<umtrx_status_session> sptr;
+    typedef boost::function<void(const boost::property_tree::ptree &, boost::property_tree::ptree &)> handler_type;
+    typedef boost::function<void(const std::string &, std::string &)> binary_handler_type;
+    typedef boost::function<std::string(void)> metrics_handler_type;
+
+    umtrx_status_session(asio::io_service &io_service, const handler_type &handler,
+        const binary_handler_type &binary_handler, const metrics_handler_type &metrics_handler):
+        _io_service(io_service), _socket(io_service), _handler(handler), _binary_handler(binary_handler),
+        _metrics_handler(metrics_handler), _binary(false), _http(false), _close_after_write(false), _subscribe_all(false)
+    {
+        //NOP
+    }
+
+    asio::ip::tcp::socket &socket(void)
+    {
+        return _socket;
+    }
+
+    void start(void)
+    {
+        //the first byte tells the framing apart
+        asio::async_read(_socket, _request_buff, asio::transfer_at_least(1), boost::bind(
+            &umtrx_status_session::handle_detect, shared_from_this(),
+            asio::placeholders::error));
+    }
+
+    //! queue the subscribed sensors that changed since the last push
+    void push_deltas(const umtrx_sensor_cache_t &cache)
+    {
+        if (not _subscribe_all and _subscribed.empty()) return;
+
+        boost::property_tree::ptree sensors;
+        wire_writer binary_sensors;
+        size_t num_sensors = 0;
+        typedef std::pair<std::string, sensor_value_t> sensor_pair_t;
+        BOOST_FOREACH(const sensor_pair_t &sensor, cache.sensors)
+        {
+            std::map<std::string, std::string>::iterator it = _subscribed.find(sensor.first);
+            if (it == _subscribed.end())
+            {
+                if (not _subscribe_all) continue;
+                it = _subscribed.insert(std::make_pair(sensor.first, std::string())).first;
+            }
+            if (it->second == sensor.second.value) continue;
+            it->second = sensor.second.value;
+            num_sensors++;
+
+            if (_binary)
+            {
+                binary_sensors.put_str(sensor.first);
+                binary_sensors.put_sensor(sensor.second, 0.0); //just sampled
+                continue;
+            }
+            boost::property_tree::ptree sensorData;
+            sensorData.put("path", sensor.first);
+            sensorData.put("name", sensor.second.name);
+            sensorData.put("value", sensor.second.value);
+            sensorData.put("unit", sensor.second.unit);
+            sensors.push_back(std::make_pair("", sensorData));
+        }
+        if (num_sensors == 0) return;
+
+        if (_binary)
+        {
+            wire_writer event;
+            event.put_u32(WIRE_EVENT_SEQ);
+            event.put_u8(WIRE_EVENT);
+            event.put_f64((cache.time - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_microseconds()/1e6);
+            event.put_u16(boost::uint16_t(std::min<size_t>(num_sensors, 0xffff)));
+            event.str() += binary_sensors.str();
+            this->send_frame(event.str());
+            return;
+        }
+        boost::property_tree::ptree event;
+        event.put("event", "DELTA");
+        event.put("time", boost::posix_time::to_iso_extended_string(cache.time));
+        event.add_child("sensors", sensors);
+        this->send(event);
+    }
+
+private:
+    void handle_detect(const boost::system::error_code &ec)
+    {
+        if (ec) return;
+        _binary = *asio::buffer_cast<const char *>(_request_buff.data()) == '\0';
+        this->read_next();
+    }
+
+    void read_next(void)
+    {
+        if (not _binary)
+        {
+            asio::async_read_until(_socket, _request_buff, '\n', boost::bind(
+                &umtrx_status_session::handle_read, shared_from_this(),
+                asio::placeholders::error));
+            return;
+        }
+
+        //the header, then the payload, either may already be buffered
+        size_t need = 4;
+        if (_request_buff.size() >= 4)
+        {
+            const std::string header_bytes(asio::buffer_cast<const char *>(_request_buff.data()), 4);
+            wire_reader header(header_bytes);
+            const size_t len = header.get_u32();
+            if (len > WIRE_MAX_FRAME)
+            {
+                UHD_MSG(error) << "status client frame too long, closing the client" << std::endl;
+                boost::system::error_code ignored;
+                _socket.close(ignored);
+                return;
+            }
+            need += len;
+        }
+        if (_request_buff.size() >= need)
+        {
+            //post to not recurse on pipelined requests
+            _io_service.post(boost::bind(&umtrx_status_session::handle_frame, shared_from_this(),
+                boost::system::error_code()));
+            return;
         }
+        asio::async_read(_socket, _request_buff, asio::transfer_at_least(need - _request_buff.size()), boost::bind(
+            &umtrx_status_session::handle_frame, shared_from_this(),
+            asio::placeholders::error));
+    }
+
+    void handle_frame(const boost::system::error_code &ec)
+    {
+        if (ec) return;
 
-        //handle the request
+        //a short read comes back around for the rest
+        std::string payload;
+        if (_request_buff.size() >= 4)
+        {
+            const char *data = asio::buffer_cast<const char *>(_request_buff.data());
+            const std::string header_bytes(data, 4);
+            wire_reader header(header_bytes);
+            const size_t len = header.get_u32();
+            if (_request_buff.size() >= 4 + len)
+            {
+                payload.assign(data + 4, len);
+                _request_buff.consume(4 + len);
+                this->handle_binary(payload);
+            }
+        }
+        this->read_next();
+    }
+
+    void handle_binary(const std::string &payload)
+    {
+        wire_writer response;
+        boost::uint32_t seq = 0;
         try
         {
-            this->client_query_handle1(request, response);
+            wire_reader request(payload);
+            seq = request.get_u32();
+            const boost::uint8_t action = request.get_u8();
+            if (action == WIRE_SUBSCRIBE)
+            {
+                request.get_u8(); //type is not used
+                const size_t num_paths = request.get_u16();
+                _subscribed.clear();
+                for (size_t i = 0; i < num_paths; i++) _subscribed[request.get_str()] = "";
+                _subscribe_all = num_paths == 0;
+            }
+            else if (action == WIRE_UNSUBSCRIBE)
+            {
+                _subscribe_all = false;
+                _subscribed.clear();
+            }
+            else _binary_handler(payload.substr(4), response.str());
         }
         catch (const std::exception &ex)
         {
-            response.put("error", "failed to handle request: " + std::string(ex.what()));
+            response.str().clear();
+            response.put_u8(WIRE_ERROR);
+            response.put_str("failed to handle request: " + std::string(ex.what()));
         }
+        if (response.str().empty()) response.put_u8(WIRE_OK);
+
+        wire_writer frame;
+        frame.put_u32(seq);
+        frame.str() += response.str();
+        this->send_frame(frame.str());
+    }
+
+    void send_frame(const std::string &payload)
+    {
+        wire_writer frame;
+        frame.put_u32(boost::uint32_t(payload.size()));
+        frame.str() += payload;
+        _write_queue.push_back(frame.str());
+        if (_write_queue.size() == 1) this->write_next();
+    }
 
-        //send the response
-        boost::asio::streambuf responseBuff;
-        std::ostream os(&responseBuff);
+    void handle_read(const boost::system::error_code &ec)
+    {
+        if (ec) return; //client ended, the last handler reference goes away
+
+        boost::property_tree::ptree request, response;
+        std::istream is(&_request_buff);
+        std::string line;
+        std::getline(is, line);
+        if (_http or line.compare(0, 4, "GET ") == 0) return this->handle_http(line);
         try
         {
-            boost::property_tree::write_json(os, response, false/*not pretty required*/);
-            boost::asio::write(*socket, responseBuff);
+            std::istringstream iss(line);
+            boost::property_tree::read_json(iss, request);
         }
         catch (const std::exception &ex)
         {
-            UHD_MSG(error) << "client_query_handle send response failed, exit client thread: " << ex.what() << std::endl;
+            response.put("error", "request parser error: " + std::string(ex.what()));
+        }
+
+        //subscriptions belong to the session, the rest to the device
+        const std::string action = request.get("action", "");
+        if (response.count("error") != 0)
+        {
+            //already in error
+        }
+        else if (action == "SUBSCRIBE")
+        {
+            this->subscribe(request);
+            response.put("result", true);
+        }
+        else if (action == "UNSUBSCRIBE")
+        {
+            _subscribe_all = false;
+            _subscribed.clear();
+            response.put("result", true);
+        }
+        else
+        {
+            try
+            {
+                _handler(request, response);
+            }
+            catch (const std::exception &ex)
+            {
+                response.put("error", "failed to handle request: " + std::string(ex.what()));
+            }
+        }
+
+        this->send(response);
+        this->read_next();
+    }
+
+    //! a scraper, reply to one plain HTTP GET and close
+    void handle_http(const std::string &line)
+    {
+        if (not _http)
+        {
+            _http = true;
+            const size_t begin = line.find(' ') + 1;
+            _http_path = line.substr(begin, line.find(' ', begin) - begin);
+        }
+        if (not line.empty() and line != "\r") return this->read_next(); //skip the headers
+
+        std::string status = "200 OK", body;
+        if (_http_path == "/metrics")
+        {
+            try
+            {
+                body = _metrics_handler();
+            }
+            catch (const std::exception &ex)
+            {
+                status = "500 Internal Server Error";
+                body = std::string(ex.what()) + "\n";
+            }
+        }
+        else
+        {
+            status = "404 Not Found";
+            body = "only /metrics is served\n";
+        }
+
+        std::ostringstream os;
+        os << "HTTP/1.0 " << status << "\r\n";
+        os << "Content-Type: text/plain; version=0.0.4\r\n";
+        os << "Content-Length: " << body.size() << "\r\n";
+        os << "Connection: close\r\n\r\n" << body;
+        _close_after_write = true;
+        _write_queue.push_back(os.str());
+        if (_write_queue.size() == 1) this->write_next();
+    }
+
+    void subscribe(const boost::property_tree::ptree &request)
+    {
+        //no paths means every sampled sensor, the first push carries all values
+        boost::optional<const boost::property_tree::ptree &> paths = request.get_child_optional("paths");
+        _subscribed.clear();
+        _subscribe_all = not paths or paths->empty();
+        if (_subscribe_all) return;
+        BOOST_FOREACH(const boost::property_tree::ptree::value_type &path, *paths)
+        {
+            _subscribed[path.second.get_value<std::string>()] = "";
+        }
+    }
+
+    void send(const boost::property_tree::ptree &message)
+    {
+        std::ostringstream os;
+        boost::property_tree::write_json(os, message, false/*not pretty required*/);
+        _write_queue.push_back(os.str());
+        if (_write_queue.size() == 1) this->write_next();
+    }
+
+    void write_next(void)
+    {
+        asio::async_write(_socket, asio::buffer(_write_queue.front()), boost::bind(
+            &umtrx_status_session::handle_write, shared_from_this(),
+            asio::placeholders::error));
+    }
+
+    void handle_write(const boost::system::error_code &ec)
+    {
+        if (ec)
+        {
+            UHD_MSG(error) << "status client send failed, closing the client: " << ec.message() << std::endl;
+            boost::system::error_code ignored;
+            _socket.close(ignored);
             return;
         }
+        _write_queue.pop_front();
+        if (not _write_queue.empty()) this->write_next();
+        else if (_close_after_write)
+        {
+            boost::system::error_code ignored;
+            _socket.shutdown(asio::ip::tcp::socket::shutdown_both, ignored);
+            _socket.close(ignored);
+        }
+    }
+
+    asio::io_service &_io_service;
+    asio::ip::tcp::socket _socket;
+    handler_type _handler;
+    binary_handler_type _binary_handler;
+    metrics_handler_type _metrics_handler;
+    asio::streambuf _request_buff;
+    bool _binary;
+    bool _http;
+    std::string _http_path;
+    bool _close_after_write;
+    std::deque<std::string> _write_queue;
+    std::map<std::string, std::string> _subscribed; //path -> last value pushed
+    bool _subscribe_all;
+};
+
+void umtrx_impl::server_query_handler(void)
+{
+    //runs every client until the server is stopped
+    _server_query_io_service.run();
+    if (_server_query_io_service.stopped()) boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+}
+
+void umtrx_impl::server_query_accept(void)
+{
+    umtrx_status_session::sptr session(new umtrx_status_session(_server_query_io_service,
+        boost::bind(&umtrx_impl::client_query_handle1, this, boost::placeholders::_1, boost::placeholders::_2),
+        boost::bind(&umtrx_impl::client_query_binary, this, boost::placeholders::_1, boost::placeholders::_2),
+        boost::bind(&umtrx_impl::get_stream_metrics, this)));
+    _server_query_tcp_acceptor->async_accept(session->socket(), boost::bind(
+        &umtrx_impl::server_query_accepted, this, session, asio::placeholders::error));
+}
+
+void umtrx_impl::server_query_accepted(umtrx_status_session::sptr session, const boost::system::error_code &ec)
+{
+    if (ec == asio::error::operation_aborted) return;
+    if (ec)
+    {
+        UHD_MSG(error) << "status server accept failed: " << ec.message() << std::endl;
+    }
+    else
+    {
+        session->start();
+        _server_sessions.push_back(session);
+    }
+    this->server_query_accept();
+}
+
+void umtrx_impl::server_push_deltas(boost::shared_ptr<const umtrx_sensor_cache_t> cache)
+{
+    std::list<boost::weak_ptr<umtrx_status_session> >::iterator it = _server_sessions.begin();
+    while (it != _server_sessions.end())
+    {
+        umtrx_status_session::sptr session = it->lock();
+        if (not session)
+        {
+            it = _server_sessions.erase(it);
+            continue;
+        }
+        session->push_deltas(*cache);
+        ++it;
+    }
+}
+
+static const char *trace_bus_name(const boost::uint8_t bus)
+{
+    switch (bus)
+    {
+    case UMTRX_TRACE_WB: return "wb";
+    case UMTRX_TRACE_WB_UDP: return "wb_udp";
+    case UMTRX_TRACE_SPI: return "spi";
+    case UMTRX_TRACE_I2C: return "i2c";
+    case UMTRX_TRACE_SPAN: return "span";
+    default: return "unknown";
+    }
+}
+
+static const char *trace_dir_name(const boost::uint8_t dir)
+{
+    return (dir == UMTRX_TRACE_READ)? "read" : "write";
+}
+
+static void trace_dump(const boost::property_tree::ptree &request, boost::property_tree::ptree &response)
+{
+    umtrx_trace &trace = umtrx_trace::get();
+    if (request.count("enable") != 0)
+    {
+        trace.enable(request.get<size_t>("enable"));
+        response.put("result", true);
+        return;
+    }
+
+    boost::property_tree::ptree result, events;
+    BOOST_FOREACH(const umtrx_trace_event_t &ev, trace.snapshot(request.get<size_t>("count", 1000)))
+    {
+        boost::property_tree::ptree entry;
+        entry.put("time", ev.time_ns);
+        entry.put("duration", ev.duration_ns);
+        entry.put("bus", trace_bus_name(ev.bus));
+        entry.put("dir", trace_dir_name(ev.dir));
+        entry.put("slave", ev.slave);
+        if (ev.bus == UMTRX_TRACE_SPAN) entry.put("addr", trace.label_name(ev.addr));
+        else entry.put("addr", ev.addr);
+        entry.put("data", str(boost::format("0x%08x") % ev.data));
+        events.push_back(std::make_pair("", entry));
+    }
+    result.put("recorded", trace.get_num_recorded());
+    result.add_child("events", events);
+    response.add_child("result", result);
+}
+
+static void history_dump(umtrx_sensor_history::sptr history, const boost::property_tree::ptree &request, boost::property_tree::ptree &response)
+{
+    if (not history)
+    {
+        response.put("error", "no sensor history, sensor_poll_period=0 or sensor_history=0");
+        return;
+    }
+    const std::string resolution_name = request.get("resolution", "1s");
+    umtrx_sensor_history::resolution_type resolution;
+    if (resolution_name == "raw") resolution = umtrx_sensor_history::RESOLUTION_RAW;
+    else if (resolution_name == "1s") resolution = umtrx_sensor_history::RESOLUTION_SECOND;
+    else if (resolution_name == "1m") resolution = umtrx_sensor_history::RESOLUTION_MINUTE;
+    else
+    {
+        response.put("error", "unknown resolution " + resolution_name + ": raw, 1s, 1m");
+        return;
+    }
+    const double since = (boost::posix_time::microsec_clock::universal_time() -
+        boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_microseconds()/1e6 - request.get<double>("seconds", 300);
+
+    std::vector<std::string> paths;
+    BOOST_FOREACH(const boost::property_tree::ptree::value_type &entry, request.get_child("paths", boost::property_tree::ptree()))
+    {
+        paths.push_back(entry.second.get_value<std::string>());
+    }
+    if (request.count("path") != 0) paths.push_back(request.get<std::string>("path"));
+    if (paths.empty()) paths = history->get_paths();
+
+    boost::property_tree::ptree result;
+    BOOST_FOREACH(const std::string &path, paths)
+    {
+        boost::property_tree::ptree entries;
+        BOOST_FOREACH(const umtrx_sensor_history::entry_type &e, history->get_entries(path, resolution, since))
+        {
+            boost::property_tree::ptree entry;
+            entry.put("time", str(boost::format("%.3f") % e.time));
+            if (resolution == umtrx_sensor_history::RESOLUTION_RAW) entry.put("value", str(boost::format("%g") % e.mean));
+            else
+            {
+                entry.put("min", str(boost::format("%g") % e.min));
+                entry.put("mean", str(boost::format("%g") % e.mean));
+                entry.put("max", str(boost::format("%g") % e.max));
+                entry.put("count", e.count);
+            }
+            entries.push_back(std::make_pair("", entry));
+        }
+        //a plain key, put() would parse the property path
+        result.push_back(std::make_pair(path, entries));
     }
+    response.add_child("result", result);
+}
+
+static void trace_summary(const boost::property_tree::ptree &request, boost::property_tree::ptree &response)
+{
+    const std::string span = request.get("span", "");
+    std::vector<umtrx_trace_summary_t> rows;
+    boost::uint64_t span_ns = 0;
+    if (not umtrx_trace::get().summarize(span, rows, span_ns))
+    {
+        response.put("error", "no " + span + " span in the trace");
+        return;
+    }
+
+    boost::property_tree::ptree result, entries;
+    BOOST_FOREACH(const umtrx_trace_summary_t &row, rows)
+    {
+        boost::property_tree::ptree entry;
+        entry.put("bus", trace_bus_name(row.bus));
+        entry.put("dir", trace_dir_name(row.dir));
+        entry.put("slave", row.slave);
+        entry.put("count", row.count);
+        entry.put("total", row.total_ns);
+        entry.put("max", row.max_ns);
+        entries.push_back(std::make_pair("", entry));
+    }
+    if (not span.empty())
+    {
+        result.put("span", span);
+        result.put("duration", span_ns);
+    }
+    result.add_child("rows", entries);
+    response.add_child("result", result);
 }
 
 void umtrx_impl::client_query_handle1(const boost::property_tree::ptree &request, boost::property_tree::ptree &response)
@@ -182,18 +1238,47 @@ void umtrx_impl::client_query_handle1(const boost::property_tree::ptree &request
     {
         //already in error
     }
+    else if (action == "GET_MANY")
+    {
+        //one GET per path, an error only fails its own entry
+        boost::property_tree::ptree result;
+        BOOST_FOREACH(const boost::property_tree::ptree::value_type &entry, request.get_child("paths", boost::property_tree::ptree()))
+        {
+            boost::property_tree::ptree subrequest, subresponse;
+            subrequest.put("action", "GET");
+            subrequest.put("path", entry.second.get_value<std::string>());
+            subrequest.put("type", request.get("type", "SENSOR"));
+            try
+            {
+                this->client_query_handle1(subrequest, subresponse);
+            }
+            catch (const std::exception &ex)
+            {
+                subresponse.put("error", "failed to handle request: " + std::string(ex.what()));
+            }
+            result.push_back(std::make_pair("", subresponse));
+        }
+        response.add_child("result", result);
+    }
+    else if (action == "METRICS")
+    {
+        response.put("result", this->get_stream_metrics());
+    }
+    else if (action == "TRACE") trace_dump(request, response);
+    else if (action == "TRACE_SUMMARY") trace_summary(request, response);
+    else if (action == "HISTORY") history_dump(_sensor_history, request, response);
     else if (path.empty())
     {
         response.put("error", "path field not specified");
     }
     else if (action.empty())
     {
-        response.put("error", "action field not specified: GET, SET, HAS, LIST");
+        response.put("error", "action field not specified: GET, GET_MANY, SET, HAS, LIST, METRICS, TRACE, TRACE_SUMMARY, HISTORY, SUBSCRIBE, UNSUBSCRIBE");
     }
     else if (action == "GET")
     {
         const std::string type = request.get("type", "");
-        if (type.empty()) response.put("error", "type field not specified: STRING, BOOL, INT, DOUBLE, COMPLEX, SENSOR, RANGE");
+        if (type.empty()) response.put("error", "type field not specified: STRING, BOOL, INT, DOUBLE, COMPLEX, SENSOR, RANGE, SNAPSHOT");
         else if (type == "STRING") response.put("result", _tree->access<std::string>(path).get());
         else if (type == "BOOL") response.put("result", _tree->access<bool>(path).get());
         else if (type == "INT") response.put("result", _tree->access<int>(path).get());
@@ -216,6 +1301,23 @@ void umtrx_impl::client_query_handle1(const boost::property_tree::ptree &request
             result.put("name", sensor.name);
             result.put("value", sensor.value);
             result.put("unit", sensor.unit);
+            result.put("age", get_sensor_age(path));
+            response.add_child("result", result);
+        }
+        else if (type == "SNAPSHOT")
+        {
+            boost::property_tree::ptree result, sensors;
+            const umtrx_sensor_snapshot_t snapshot = _tree->access<umtrx_sensor_snapshot_t>(path).get();
+            result.put("time", boost::posix_time::to_iso_extended_string(snapshot.time));
+            BOOST_FOREACH(const sensor_value_t &sensor, snapshot.sensors)
+            {
+                boost::property_tree::ptree sensorData;
+                sensorData.put("name", sensor.name);
+                sensorData.put("value", sensor.value);
+                sensorData.put("unit", sensor.unit);
+                sensors.push_back(std::make_pair("", sensorData));
+            }
+            result.add_child("sensors", sensors);
             response.add_child("result", result);
         }
         else if (type == "RANGE")
@@ -270,3 +1372,72 @@ void umtrx_impl::client_query_handle1(const boost::property_tree::ptree &request
         response.put("error", "unknown action: " + action);
     }
 }
+
+void umtrx_impl::client_query_binary(const std::string &request_payload, std::string &response_payload)
+{
+    wire_reader request(request_payload);
+    wire_writer response;
+    const boost::uint8_t action = request.get_u8();
+    const boost::uint8_t type = request.get_u8();
+    const std::string path = request.get_str();
+    response.put_u8(WIRE_OK);
+
+    if (action == WIRE_GET) switch (type)
+    {
+    case WIRE_STRING: response.put_str(_tree->access<std::string>(path).get()); break;
+    case WIRE_BOOL: response.put_u8(_tree->access<bool>(path).get()? 1 : 0); break;
+    case WIRE_INT: response.put_u32(boost::uint32_t(_tree->access<int>(path).get())); break;
+    case WIRE_DOUBLE: response.put_f64(_tree->access<double>(path).get()); break;
+    case WIRE_COMPLEX:
+    {
+        const std::complex<double> c = _tree->access<std::complex<double> >(path).get();
+        response.put_f64(c.real());
+        response.put_f64(c.imag());
+        break;
+    }
+    case WIRE_SENSOR: response.put_sensor(_tree->access<sensor_value_t>(path).get(), get_sensor_age(path)); break;
+    case WIRE_RANGE:
+    {
+        const meta_range_t ranges = _tree->access<meta_range_t>(path).get();
+        response.put_u16(boost::uint16_t(ranges.size()));
+        BOOST_FOREACH(const range_t &range, ranges)
+        {
+            response.put_f64(range.start());
+            response.put_f64(range.stop());
+            response.put_f64(range.step());
+        }
+        break;
+    }
+    default: throw uhd::value_error(str(boost::format("unknown type: %d") % int(type)));
+    }
+    else if (action == WIRE_SET) switch (type)
+    {
+    case WIRE_STRING: _tree->access<std::string>(path).set(request.get_str()); break;
+    case WIRE_BOOL: _tree->access<bool>(path).set(request.get_u8() != 0); break;
+    case WIRE_INT: _tree->access<int>(path).set(int(request.get_u32())); break;
+    case WIRE_DOUBLE: _tree->access<double>(path).set(request.get_f64()); break;
+    case WIRE_COMPLEX:
+    {
+        const double i = request.get_f64();
+        const double q = request.get_f64();
+        _tree->access<std::complex<double> >(path).set(std::complex<double>(i, q));
+        break;
+    }
+    default: throw uhd::value_error(str(boost::format("unknown type: %d") % int(type)));
+    }
+    else if (action == WIRE_HAS)
+    {
+        response.put_u8(_tree->exists(path)? 1 : 0);
+    }
+    else if (action == WIRE_LIST)
+    {
+        const std::vector<std::string> branches = _tree->list(path);
+        response.put_u16(boost::uint16_t(branches.size()));
+        BOOST_FOREACH(const std::string &branchName, branches) response.put_str(branchName);
+    }
+    else throw uhd::value_error(str(boost::format("unknown action: %d") % int(action)));
+
+    response_payload.swap(response.str());
+}
+
+#endif //UMTRX_EMBEDDED
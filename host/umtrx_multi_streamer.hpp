@@ -0,0 +1,290 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_MULTI_STREAMER_HPP
+#define INCLUDED_UMTRX_MULTI_STREAMER_HPP
+
+#include <uhd/stream.hpp>
+#include <uhd/convert.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/types/metadata.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+/*!
+ * The streams of several UmTRX boards as one, ex: an 8 channel site.
+ *
+ * Every board is its own device with its own streamers, the channels of
+ * the aggregate are those of the boards in the order given. The device
+ * times must be aligned and the RX streams started at one time first,
+ * sync_boards_next_pps() and start_streams_at() of utils/umtrx_multi_sync.hpp.
+ *
+ * recv() aligns the boards the way the packet handler aligns the channels
+ * of one board: the newest timestamp sets the alignment time and the boards
+ * behind it drop samples up to it. Every buffer of a recv() call then holds
+ * the same device times. An overflow of any board is returned as an
+ * overflow, the next call realigns.
+ *
+ * send() gives each board its channels with the same metadata, timed bursts
+ * go out at the same device time on all of them.
+ *
+ * Header only so that applications can use it without linking the module.
+ */
+class umtrx_multi_rx_streamer : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_multi_rx_streamer> sptr;
+
+    /*!
+     * Make an aggregate of the RX streamers of several boards.
+     * \param streams one streamer per board, all at the same rate
+     * \param cpu_format the cpu_format of the streamers, ex: fc32
+     * \param samp_rate the rate of the streamers
+     */
+    static sptr make(const std::vector<uhd::rx_streamer::sptr> &streams, const std::string &cpu_format, const double samp_rate)
+    {
+        return sptr(new umtrx_multi_rx_streamer(streams, cpu_format, samp_rate));
+    }
+
+    //! Stop streaming on all boards, drop what was buffered
+    void stop(void)
+    {
+        const uhd::stream_cmd_t cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+        for (size_t i = 0; i < _boards.size(); i++)
+        {
+            _boards[i].stream->issue_stream_cmd(cmd);
+            _boards[i].count = 0;
+        }
+    }
+
+    //! Channels of all boards together
+    size_t get_num_channels(void) const
+    {
+        return _num_channels;
+    }
+
+    /*!
+     * Receive the next aligned samples of all boards.
+     * \param buffs one buffer per channel of the aggregate
+     * \param nsamps_per_buff the capacity of each buffer
+     * \param metadata the time of the first sample, or the error
+     * \param timeout seconds to wait per board
+     * \return samples per channel, 0 on a timeout or error
+     */
+    size_t recv(const uhd::rx_streamer::buffs_type &buffs, const size_t nsamps_per_buff,
+        uhd::rx_metadata_t &metadata, const double timeout = 0.1)
+    {
+        metadata.reset();
+        UHD_ASSERT_THROW(buffs.size() == _num_channels);
+
+        //loop until every board holds samples at the alignment time
+        long long alignment = 0;
+        for (size_t restarts = 0; ; restarts++)
+        {
+            bool valid = false;
+            for (size_t i = 0; i < _boards.size(); i++)
+            {
+                board_type &board = _boards[i];
+                if (board.count == 0 and not this->fill(board, metadata, timeout)) return 0;
+                if (not valid or board.start > alignment) alignment = board.start;
+                valid = true;
+            }
+
+            //the boards behind drop up to the alignment time
+            bool aligned = true;
+            for (size_t i = 0; i < _boards.size(); i++)
+            {
+                board_type &board = _boards[i];
+                if (board.start == alignment) continue;
+                const size_t drop = size_t(std::min<long long>(board.count, alignment - board.start));
+                board.head += drop;
+                board.count -= drop;
+                board.start += drop;
+                aligned = aligned and board.count != 0;
+            }
+            if (aligned) break;
+            if (restarts > MAX_RESTARTS)
+            {
+                metadata.error_code = uhd::rx_metadata_t::ERROR_CODE_ALIGNMENT;
+                return 0;
+            }
+        }
+
+        //as many samples as every board holds
+        size_t nsamps = nsamps_per_buff;
+        for (size_t i = 0; i < _boards.size(); i++) nsamps = std::min(nsamps, _boards[i].count);
+        size_t chan = 0;
+        for (size_t i = 0; i < _boards.size(); i++)
+        {
+            board_type &board = _boards[i];
+            for (size_t ch = 0; ch < board.fifo.size(); ch++, chan++)
+            {
+                std::memcpy(buffs[chan], &board.fifo[ch][board.head*_bytes_per_samp], nsamps*_bytes_per_samp);
+            }
+            board.head += nsamps;
+            board.count -= nsamps;
+            board.start += nsamps;
+        }
+
+        metadata.has_time_spec = true;
+        metadata.time_spec = uhd::time_spec_t::from_ticks(alignment, _samp_rate);
+        return nsamps;
+    }
+
+private:
+    enum {MAX_RESTARTS = 100};
+
+    struct board_type
+    {
+        uhd::rx_streamer::sptr stream;
+        std::vector<std::vector<char> > fifo; //one packet per channel
+        size_t head, count; //samples
+        long long start; //device time of the head sample, in samples
+    };
+
+    umtrx_multi_rx_streamer(const std::vector<uhd::rx_streamer::sptr> &streams, const std::string &cpu_format, const double samp_rate):
+        _bytes_per_samp(uhd::convert::get_bytes_per_item(cpu_format)), _samp_rate(samp_rate), _num_channels(0)
+    {
+        for (size_t i = 0; i < streams.size(); i++)
+        {
+            board_type board;
+            board.stream = streams[i];
+            board.fifo.resize(streams[i]->get_num_channels(),
+                std::vector<char>(streams[i]->get_max_num_samps()*_bytes_per_samp));
+            board.head = board.count = 0;
+            board.start = 0;
+            _boards.push_back(board);
+            _num_channels += board.fifo.size();
+        }
+    }
+
+    //! Receive the next packet of an empty board, false with the error in metadata
+    bool fill(board_type &board, uhd::rx_metadata_t &metadata, const double timeout)
+    {
+        std::vector<void *> ptrs(board.fifo.size());
+        for (size_t ch = 0; ch < ptrs.size(); ch++) ptrs[ch] = &board.fifo[ch].front();
+        uhd::rx_metadata_t md;
+        const size_t n = board.stream->recv(ptrs, board.fifo.front().size()/_bytes_per_samp, md, timeout);
+        if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE or n == 0)
+        {
+            metadata = md;
+            if (metadata.error_code == uhd::rx_metadata_t::ERROR_CODE_NONE) metadata.error_code = uhd::rx_metadata_t::ERROR_CODE_TIMEOUT;
+            return false;
+        }
+        board.head = 0;
+        board.count = n;
+        board.start = md.time_spec.to_ticks(_samp_rate);
+        return true;
+    }
+
+    const size_t _bytes_per_samp;
+    const double _samp_rate;
+    size_t _num_channels;
+    std::vector<board_type> _boards;
+};
+
+//! The TX side: the channels of several boards as one, see umtrx_multi_rx_streamer
+class umtrx_multi_tx_streamer : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_multi_tx_streamer> sptr;
+
+    //! Make an aggregate of the TX streamers of several boards, the device times aligned
+    static sptr make(const std::vector<uhd::tx_streamer::sptr> &streams, const std::string &cpu_format)
+    {
+        return sptr(new umtrx_multi_tx_streamer(streams, cpu_format));
+    }
+
+    size_t get_num_channels(void) const
+    {
+        return _num_channels;
+    }
+
+    /*!
+     * Send the same samples span on every board.
+     * A board that takes fewer samples is given the rest until the
+     * timeout, so the boards stay in step.
+     * \return samples per channel every board took
+     */
+    size_t send(const uhd::tx_streamer::buffs_type &buffs, const size_t nsamps_per_buff,
+        const uhd::tx_metadata_t &metadata, const double timeout = 0.1)
+    {
+        UHD_ASSERT_THROW(buffs.size() == _num_channels);
+        size_t sent = nsamps_per_buff;
+        size_t chan = 0;
+        for (size_t i = 0; i < _streams.size(); i++)
+        {
+            const size_t nchan = _streams[i]->get_num_channels();
+            std::vector<const void *> ptrs(nchan);
+            uhd::tx_metadata_t md = metadata;
+            size_t done = 0;
+            do
+            {
+                for (size_t ch = 0; ch < nchan; ch++)
+                {
+                    ptrs[ch] = reinterpret_cast<const char *>(buffs[chan + ch]) + done*_bytes_per_samp;
+                }
+                const size_t n = _streams[i]->send(ptrs, nsamps_per_buff - done, md, timeout);
+                if (n == 0 and nsamps_per_buff != 0) break;
+                done += n;
+                md.start_of_burst = false;
+                md.has_time_spec = false;
+            }
+            while (done < nsamps_per_buff);
+            sent = std::min(sent, done);
+            chan += nchan;
+        }
+        return sent;
+    }
+
+    //! The async messages of all boards, the channel numbered in the aggregate
+    bool recv_async_msg(uhd::async_metadata_t &async_metadata, const double timeout = 0.1)
+    {
+        for (size_t i = 0; i < _streams.size(); i++)
+        {
+            const size_t board = (_next_async + i) % _streams.size();
+            if (not _streams[board]->recv_async_msg(async_metadata, (i + 1 == _streams.size())? timeout : 0.0)) continue;
+            async_metadata.channel += _first_channel[board];
+            _next_async = board + 1;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    umtrx_multi_tx_streamer(const std::vector<uhd::tx_streamer::sptr> &streams, const std::string &cpu_format):
+        _bytes_per_samp(uhd::convert::get_bytes_per_item(cpu_format)), _streams(streams), _num_channels(0), _next_async(0)
+    {
+        for (size_t i = 0; i < streams.size(); i++)
+        {
+            _first_channel.push_back(_num_channels);
+            _num_channels += streams[i]->get_num_channels();
+        }
+    }
+
+    const size_t _bytes_per_samp;
+    std::vector<uhd::tx_streamer::sptr> _streams;
+    std::vector<size_t> _first_channel;
+    size_t _num_channels;
+    size_t _next_async;
+};
+
+#endif /* INCLUDED_UMTRX_MULTI_STREAMER_HPP */
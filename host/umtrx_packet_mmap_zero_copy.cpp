@@ -0,0 +1,423 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_packet_mmap_zero_copy.hpp"
+#include "umtrx_frame_pool.hpp"
+#include "umtrx_log_adapter.hpp"
+#include <uhd/config.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/transport/udp_simple.hpp> //mtu
+#include <uhd/transport/bounded_buffer.hpp>
+#include <boost/format.hpp>
+#include <vector>
+#include <cstring>
+
+using namespace uhd;
+using namespace uhd::transport;
+
+#ifdef UHD_PLATFORM_LINUX
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <net/if.h>
+#include <netdb.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+
+#ifndef UMTRX_EMBEDDED
+static const size_t DEFAULT_NUM_RECV_FRAMES = 1024;
+#else
+static const size_t DEFAULT_NUM_RECV_FRAMES = 128;
+#endif
+static const size_t DEFAULT_NUM_SEND_FRAMES = 32;
+static const size_t IP_UDP_HDR_MAX_BYTES = 60 + 8;
+
+static size_t next_pow2(const size_t n)
+{
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static int timeout_to_ms(const double timeout)
+{
+    return (timeout <= 0.0)? 0 : int(timeout*1e3 + 0.999);
+}
+
+static boost::int64_t clock_ns(const clockid_t clock)
+{
+    struct timespec ts;
+    ::clock_gettime(clock, &ts);
+    return boost::int64_t(ts.tv_sec)*1000000000 + ts.tv_nsec;
+}
+
+/***********************************************************************
+ * Managed buffers
+ **********************************************************************/
+class packet_mmap_mrb : public managed_recv_buffer
+{
+public:
+    packet_mmap_mrb(struct tpacket2_hdr *hdr):
+        in_use(false), _hdr(hdr)
+    {
+        //NOP
+    }
+
+    void release(void)
+    {
+        //return the frame to the ring before clearing the flag,
+        //so the consumer never sees a stale user-owned frame
+        _hdr->tp_status = TP_STATUS_KERNEL;
+        __sync_synchronize();
+        in_use = false;
+    }
+
+    UHD_INLINE sptr get_new(void *mem, const size_t len)
+    {
+        in_use = true;
+        return make(this, mem, len);
+    }
+
+    volatile bool in_use;
+
+private:
+    struct tpacket2_hdr *_hdr;
+};
+
+class packet_mmap_msb : public managed_send_buffer
+{
+public:
+    packet_mmap_msb(void *mem, const size_t frame_size, const int sock_fd, bounded_buffer<packet_mmap_msb *> &free_list):
+        _mem(mem), _frame_size(frame_size), _sock_fd(sock_fd), _free_list(free_list)
+    {
+        //NOP
+    }
+
+    void release(void)
+    {
+        if (::send(_sock_fd, _mem, this->size(), 0) != ssize_t(this->size()))
+        {
+            UHD_MSG(error) << "umtrx_packet_mmap_zero_copy: send failed: " << strerror(errno) << std::endl;
+        }
+        _free_list.push_with_haste(this);
+    }
+
+    UHD_INLINE sptr get_new(void)
+    {
+        return make(this, _mem, _frame_size);
+    }
+
+private:
+    void *_mem;
+    const size_t _frame_size;
+    const int _sock_fd;
+    bounded_buffer<packet_mmap_msb *> &_free_list;
+};
+
+/***********************************************************************
+ * Packet ring transport implementation
+ **********************************************************************/
+class umtrx_packet_mmap_zero_copy_impl : public umtrx_packet_mmap_zero_copy
+{
+public:
+    umtrx_packet_mmap_zero_copy_impl(const std::string &addr, const std::string &port, const device_addr_t &hints, stream_stats_t::sptr stats):
+        _recv_frame_size(size_t(hints.cast<double>("recv_frame_size", udp_simple::mtu))),
+        _send_frame_size(size_t(hints.cast<double>("send_frame_size", udp_simple::mtu))),
+        _num_send_frames(size_t(hints.cast<double>("num_send_frames", DEFAULT_NUM_SEND_FRAMES))),
+        _busy_poll(hints.cast<int>("busy_poll", 0) != 0),
+        _stats((_busy_poll or hints.cast<int>("wakeup_latency", 0) != 0)? stats : stream_stats_t::sptr()),
+        _udp_fd(-1),
+        _ring_fd(-1),
+        _ring(NULL),
+        _ring_bytes(0),
+        _index(0),
+        _send_free(_num_send_frames)
+    {
+        UHD_ASSERT_THROW(_num_send_frames > 0);
+        const struct sockaddr_in device_addr = this->open_udp_socket(addr, port);
+        const std::string iface = hints.has_key("xport_iface")? hints["xport_iface"] : umtrx_frame_pool::find_iface(device_addr.sin_addr.s_addr);
+        this->open_ring(iface, size_t(hints.cast<double>("num_recv_frames", DEFAULT_NUM_RECV_FRAMES)), hints.cast<int>("prefault", 0) != 0);
+        if (hints.has_key("busy_poll_usecs"))
+        {
+            //only helps the poll() wait, busy_poll spins on the ring memory
+            const int usecs = hints.cast<int>("busy_poll_usecs", 0);
+            if (::setsockopt(_ring_fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) != 0)
+            {
+                UHD_MSG(warning) << "umtrx_packet_mmap_zero_copy: SO_BUSY_POLL failed (needs CAP_NET_ADMIN to raise): " << strerror(errno) << std::endl;
+            }
+        }
+
+        //the ring is kernel memory, only the send frames come from the pool
+        _send_pool = umtrx_frame_pool::make(_num_send_frames*_send_frame_size, hints, device_addr.sin_addr.s_addr);
+        for (size_t i = 0; i < _num_send_frames; i++)
+        {
+            _msbs.push_back(new packet_mmap_msb(_send_pool->get() + i*_send_frame_size, _send_frame_size, _udp_fd, _send_free));
+            _send_free.push_with_haste(_msbs.back());
+        }
+
+        UHD_MSG(status) << boost::format("umtrx_packet_mmap_zero_copy: %s, %u ring frames of %u bytes%s")
+            % iface % _mrbs.size() % _ring_frame_size % (_busy_poll? ", busy poll" : "") << std::endl;
+    }
+
+    ~umtrx_packet_mmap_zero_copy_impl(void)
+    {
+        if (_ring != NULL) ::munmap(_ring, _ring_bytes);
+        if (_ring_fd >= 0) ::close(_ring_fd);
+        if (_udp_fd >= 0) ::close(_udp_fd);
+        for (size_t i = 0; i < _mrbs.size(); i++) delete _mrbs[i];
+        for (size_t i = 0; i < _msbs.size(); i++) delete _msbs[i];
+    }
+
+    /*******************************************************************
+     * Receive: frames are consumed in ring order
+     ******************************************************************/
+    managed_recv_buffer::sptr get_recv_buff(double timeout)
+    {
+        if (not this->frame_ready() and _busy_poll)
+        {
+            //spin on the frame status until the caller's timeout
+            const boost::int64_t deadline = clock_ns(CLOCK_MONOTONIC) + boost::int64_t(std::max(timeout, 0.0)*1e9);
+            while (not this->frame_ready())
+            {
+                if (clock_ns(CLOCK_MONOTONIC) >= deadline) return managed_recv_buffer::sptr();
+            }
+        }
+        else if (not this->frame_ready())
+        {
+            struct pollfd pfd;
+            pfd.fd = _ring_fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            ::poll(&pfd, 1, timeout_to_ms(timeout));
+            if (not this->frame_ready()) return managed_recv_buffer::sptr();
+        }
+        __sync_synchronize();
+
+        struct tpacket2_hdr *hdr = this->frame(_index);
+        packet_mmap_mrb *mrb = _mrbs[_index];
+        if (_stats)
+        {
+            //the kernel receive timestamp is in the frame header
+            const boost::int64_t ns = clock_ns(CLOCK_REALTIME) - (boost::int64_t(hdr->tp_sec)*1000000000 + hdr->tp_nsec);
+            _stats->wakeup_latency.record(boost::uint64_t(std::max<boost::int64_t>(ns, 0)));
+        }
+        _index = (_index + 1) % _mrbs.size();
+
+        //the socket filter only lets through unfragmented ipv4/udp to our port
+        boost::uint8_t *ip = reinterpret_cast<boost::uint8_t *>(hdr) + hdr->tp_net;
+        const size_t ihl = (ip[0] & 0xf)*4;
+        boost::uint8_t *udp = ip + ihl;
+        const size_t udp_len = ntohs(*reinterpret_cast<boost::uint16_t *>(udp + 4));
+        const size_t len = std::min<size_t>(udp_len, hdr->tp_snaplen - ihl) - 8;
+        return mrb->get_new(udp + 8, len);
+    }
+
+    size_t get_num_recv_frames(void) const
+    {
+        return _mrbs.size();
+    }
+
+    size_t get_recv_frame_size(void) const
+    {
+        return _recv_frame_size;
+    }
+
+    /*******************************************************************
+     * Send: through the connected UDP socket
+     ******************************************************************/
+    managed_send_buffer::sptr get_send_buff(double timeout)
+    {
+        packet_mmap_msb *msb = NULL;
+        if (not _send_free.pop_with_timed_wait(msb, timeout))
+        {
+            return managed_send_buffer::sptr();
+        }
+        return msb->get_new();
+    }
+
+    size_t get_num_send_frames(void) const
+    {
+        return _num_send_frames;
+    }
+
+    size_t get_send_frame_size(void) const
+    {
+        return _send_frame_size;
+    }
+
+private:
+    UHD_INLINE struct tpacket2_hdr *frame(const size_t index) const
+    {
+        return reinterpret_cast<struct tpacket2_hdr *>(_ring + index*_ring_frame_size);
+    }
+
+    UHD_INLINE bool frame_ready(void) const
+    {
+        //a frame still held by the user is also in the user state
+        return (this->frame(_index)->tp_status & TP_STATUS_USER) != 0 and not _mrbs[_index]->in_use;
+    }
+
+    struct sockaddr_in open_udp_socket(const std::string &addr, const std::string &port)
+    {
+        struct addrinfo hints_ai;
+        std::memset(&hints_ai, 0, sizeof(hints_ai));
+        hints_ai.ai_family = AF_INET;
+        hints_ai.ai_socktype = SOCK_DGRAM;
+        struct addrinfo *res = NULL;
+        if (::getaddrinfo(addr.c_str(), port.c_str(), &hints_ai, &res) != 0 or res == NULL)
+        {
+            throw uhd::io_error("umtrx_packet_mmap_zero_copy: cannot resolve " + addr);
+        }
+        struct sockaddr_in device_addr;
+        std::memcpy(&device_addr, res->ai_addr, sizeof(device_addr));
+
+        _udp_fd = ::socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        const bool connected = (_udp_fd >= 0) and (::connect(_udp_fd, res->ai_addr, res->ai_addrlen) == 0);
+        ::freeaddrinfo(res);
+        if (not connected)
+        {
+            if (_udp_fd >= 0) ::close(_udp_fd);
+            throw uhd::io_error(str(boost::format("umtrx_packet_mmap_zero_copy: cannot connect to %s:%s: %s") % addr % port % strerror(errno)));
+        }
+
+        //the ring receives the data, the socket only reserves the port
+        struct sock_filter drop_all[] = {BPF_STMT(BPF_RET | BPF_K, 0)};
+        struct sock_fprog prog = {1, drop_all};
+        ::setsockopt(_udp_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog));
+
+        struct sockaddr_in local;
+        socklen_t local_len = sizeof(local);
+        ::getsockname(_udp_fd, reinterpret_cast<struct sockaddr *>(&local), &local_len);
+        _local_port = ntohs(local.sin_port);
+        return device_addr;
+    }
+
+    void open_ring(const std::string &iface, const size_t num_frames, const bool prefault)
+    {
+        _ring_fd = ::socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_IP));
+        if (_ring_fd < 0)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_mmap_zero_copy: AF_PACKET socket: %s (needs CAP_NET_RAW)") % strerror(errno)));
+        }
+
+        //only unfragmented udp datagrams to our local port make it into the ring
+        struct sock_filter code[] = {
+            BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 9),                 //ip protocol
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 5),
+            BPF_STMT(BPF_LD  | BPF_H   | BPF_ABS, 6),                 //ip flags + fragment offset
+            BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 3, 0),
+            BPF_STMT(BPF_LDX | BPF_B   | BPF_MSH, 0),                 //x = ip header length
+            BPF_STMT(BPF_LD  | BPF_H   | BPF_IND, 2),                 //udp destination port
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, _local_port, 0, 1),
+            BPF_STMT(BPF_RET | BPF_K, 0xffff),
+            BPF_STMT(BPF_RET | BPF_K, 0),
+        };
+        struct sock_fprog prog = {sizeof(code)/sizeof(code[0]), code};
+        if (::setsockopt(_ring_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_mmap_zero_copy: SO_ATTACH_FILTER: %s") % strerror(errno)));
+        }
+
+        int version = TPACKET_V2;
+        if (::setsockopt(_ring_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_mmap_zero_copy: PACKET_VERSION: %s") % strerror(errno)));
+        }
+
+        //power of two frames tile the page aligned blocks exactly
+        _ring_frame_size = next_pow2(TPACKET_ALIGN(TPACKET2_HDRLEN) + IP_UDP_HDR_MAX_BYTES + _recv_frame_size);
+        const size_t block_size = std::max<size_t>(::getpagesize(), _ring_frame_size);
+        const size_t frames_per_block = block_size/_ring_frame_size;
+        struct tpacket_req req;
+        req.tp_block_size = block_size;
+        req.tp_frame_size = _ring_frame_size;
+        req.tp_block_nr = (std::max<size_t>(num_frames, 1) + frames_per_block - 1)/frames_per_block;
+        req.tp_frame_nr = req.tp_block_nr*frames_per_block;
+        if (::setsockopt(_ring_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_mmap_zero_copy: PACKET_RX_RING: %s") % strerror(errno)));
+        }
+
+        _ring_bytes = size_t(req.tp_block_size)*req.tp_block_nr;
+        void *ring = ::mmap(NULL, _ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _ring_fd, 0);
+        if (ring == MAP_FAILED)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_mmap_zero_copy: mmap: %s") % strerror(errno)));
+        }
+        _ring = reinterpret_cast<boost::uint8_t *>(ring);
+        if (prefault and ::mlock(ring, _ring_bytes) != 0)
+        {
+            UHD_MSG(warning) << boost::format("umtrx_packet_mmap_zero_copy: cannot lock the %u byte ring: %s, check ulimit -l") % _ring_bytes % strerror(errno) << std::endl;
+        }
+        for (size_t i = 0; i < req.tp_frame_nr; i++)
+        {
+            _mrbs.push_back(new packet_mmap_mrb(this->frame(i)));
+        }
+
+        struct sockaddr_ll ll;
+        std::memset(&ll, 0, sizeof(ll));
+        ll.sll_family = AF_PACKET;
+        ll.sll_protocol = htons(ETH_P_IP);
+        ll.sll_ifindex = ::if_nametoindex(iface.c_str());
+        if (ll.sll_ifindex == 0 or ::bind(_ring_fd, reinterpret_cast<struct sockaddr *>(&ll), sizeof(ll)) != 0)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_mmap_zero_copy: bind to %s: %s") % iface % strerror(errno)));
+        }
+    }
+
+    const size_t _recv_frame_size, _send_frame_size;
+    const size_t _num_send_frames;
+    const bool _busy_poll;
+    stream_stats_t::sptr _stats; //set when recording the wakeup latency
+    int _udp_fd, _ring_fd;
+    boost::uint16_t _local_port;
+    boost::uint8_t *_ring;
+    size_t _ring_bytes;
+    size_t _ring_frame_size;
+    size_t _index; //next ring frame to consume
+
+    std::vector<packet_mmap_mrb *> _mrbs;
+    umtrx_frame_pool::sptr _send_pool;
+    std::vector<packet_mmap_msb *> _msbs;
+    bounded_buffer<packet_mmap_msb *> _send_free;
+};
+
+zero_copy_if::sptr umtrx_packet_mmap_zero_copy::make(const std::string &addr, const std::string &port, const device_addr_t &hints, stream_stats_t::sptr stats)
+{
+    return zero_copy_if::sptr(new umtrx_packet_mmap_zero_copy_impl(addr, port, hints, stats));
+}
+
+#else //UHD_PLATFORM_LINUX
+
+zero_copy_if::sptr umtrx_packet_mmap_zero_copy::make(const std::string &, const std::string &, const device_addr_t &, stream_stats_t::sptr)
+{
+    throw uhd::not_implemented_error("umtrx_packet_mmap_zero_copy: AF_PACKET rings require linux");
+}
+
+#endif //UHD_PLATFORM_LINUX
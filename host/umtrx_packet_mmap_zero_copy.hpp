@@ -0,0 +1,59 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_PACKET_MMAP_ZERO_COPY_HPP
+#define INCLUDED_UMTRX_PACKET_MMAP_ZERO_COPY_HPP
+
+#include <uhd/transport/zero_copy.hpp>
+#include <uhd/types/device_addr.hpp>
+#include "cores/stream_stats.hpp"
+#include <string>
+
+/*!
+ * A receive transport that reads the sample stream straight out of a
+ * memory mapped AF_PACKET ring (TPACKET_V2), so datagrams are never
+ * copied into a UDP socket buffer. A connected UDP socket owns the
+ * local port and carries the sends. A drop-all socket filter discards
+ * its receive copies.
+ *
+ * Requires CAP_NET_RAW. Transport hints:
+ *  - xport_iface: network interface facing the device (default: auto)
+ *  - recv_frame_size, send_frame_size: frame sizes in bytes
+ *  - num_recv_frames: number of ring frames (default 1024)
+ *  - num_send_frames: number of send frames (default 32)
+ *  - hugepage_size, numa_node: send frame placement, see umtrx_frame_pool
+ *  - prefault: 1 locks the ring and the send frames in memory (default 0)
+ *  - busy_poll: 1 to spin with non-blocking reads up to the get_recv_buff()
+ *    timeout instead of sleeping in poll(), burns a core (default 0)
+ *  - busy_poll_usecs: SO_BUSY_POLL time of the socket, for the kernel side
+ *  - wakeup_latency: 1 to record the kernel arrival to delivery time into
+ *    the stats wakeup histogram, always on with busy_poll (default 0)
+ */
+class umtrx_packet_mmap_zero_copy : public virtual uhd::transport::zero_copy_if
+{
+public:
+    //! Make a new transport, throws on non-linux platforms
+    //! stats (optional) get the wakeup latency histogram
+    static uhd::transport::zero_copy_if::sptr make(
+        const std::string &addr,
+        const std::string &port,
+        const uhd::device_addr_t &hints,
+        stream_stats_t::sptr stats = stream_stats_t::sptr()
+    );
+};
+
+#endif /* INCLUDED_UMTRX_PACKET_MMAP_ZERO_COPY_HPP */
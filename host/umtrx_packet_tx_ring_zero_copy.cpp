@@ -0,0 +1,505 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_packet_tx_ring_zero_copy.hpp"
+#include "umtrx_frame_pool.hpp"
+#include "umtrx_thread_placement.hpp"
+#include "umtrx_log_adapter.hpp"
+#include "umtrx_if_hdr.hpp"
+#include <uhd/config.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/transport/udp_simple.hpp> //mtu
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/bind/bind.hpp>
+#include <vector>
+#include <cstring>
+
+using namespace uhd;
+using namespace uhd::transport;
+
+#ifdef UHD_PLATFORM_LINUX
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+
+static const size_t DEFAULT_NUM_SEND_FRAMES = 32;
+static const size_t DEFAULT_NUM_RECV_FRAMES = 4;
+static const size_t DEFAULT_SEND_BATCH_SIZE = 1;
+static const double DEFAULT_SEND_FLUSH_TIME = 1e-3;
+static const size_t IP_HDR_BYTES = 20;
+static const size_t UDP_HDR_BYTES = 8;
+
+//! the frame data of a V2 TX ring, no PACKET_TX_HAS_OFF
+static const size_t TX_RING_DATA_OFFSET = TPACKET_ALIGN(sizeof(struct tpacket2_hdr));
+
+static size_t next_pow2(const size_t n)
+{
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static int timeout_to_ms(const double timeout)
+{
+    return (timeout <= 0.0)? 0 : int(timeout*1e3 + 0.999);
+}
+
+static boost::uint16_t ip_checksum(const boost::uint8_t *hdr)
+{
+    boost::uint32_t sum = 0;
+    for (size_t i = 0; i < IP_HDR_BYTES; i += 2) sum += (boost::uint32_t(hdr[i]) << 8) | hdr[i+1];
+    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+    return boost::uint16_t(~sum);
+}
+
+/***********************************************************************
+ * Managed buffers
+ **********************************************************************/
+class tx_ring_mrb : public managed_recv_buffer
+{
+public:
+    tx_ring_mrb(void *mem): in_use(false), mem(mem) {}
+
+    void release(void)
+    {
+        in_use = false;
+    }
+
+    UHD_INLINE sptr get_new(const size_t len)
+    {
+        in_use = true;
+        return make(this, mem, len);
+    }
+
+    bool in_use;
+    void *mem;
+};
+
+class tx_ring_msb;
+
+//! Committed frames go back to the transport, which kicks them now or in a batch
+class tx_ring_send_queue
+{
+public:
+    virtual ~tx_ring_send_queue(void){}
+    virtual void commit(tx_ring_msb *msb) = 0;
+};
+
+class tx_ring_msb : public managed_send_buffer
+{
+public:
+    tx_ring_msb(struct tpacket2_hdr *hdr, const size_t frame_size, tx_ring_send_queue &queue):
+        hdr(hdr), len(0), _frame_size(frame_size), _queue(queue)
+    {
+        //NOP
+    }
+
+    void release(void)
+    {
+        len = this->size();
+        _queue.commit(this);
+    }
+
+    UHD_INLINE boost::uint8_t *ip(void) const
+    {
+        return reinterpret_cast<boost::uint8_t *>(hdr) + TX_RING_DATA_OFFSET;
+    }
+
+    UHD_INLINE sptr get_new(void)
+    {
+        return make(this, this->ip() + IP_HDR_BYTES + UDP_HDR_BYTES, _frame_size);
+    }
+
+    struct tpacket2_hdr *hdr;
+    size_t len;
+
+private:
+    const size_t _frame_size;
+    tx_ring_send_queue &_queue;
+};
+
+/***********************************************************************
+ * TX ring transport implementation
+ **********************************************************************/
+class umtrx_packet_tx_ring_zero_copy_impl : public umtrx_packet_tx_ring_zero_copy, public tx_ring_send_queue
+{
+public:
+    umtrx_packet_tx_ring_zero_copy_impl(const std::string &addr, const std::string &port, const device_addr_t &hints):
+        _recv_frame_size(size_t(hints.cast<double>("recv_frame_size", udp_simple::mtu))),
+        _send_frame_size(size_t(hints.cast<double>("send_frame_size", udp_simple::mtu))),
+        _send_batch_size(std::max<size_t>(1, size_t(hints.cast<double>("send_batch_size", DEFAULT_SEND_BATCH_SIZE)))),
+        _send_flush_time(boost::posix_time::microseconds(long(hints.cast<double>("send_flush_time", DEFAULT_SEND_FLUSH_TIME)*1e6))),
+        _send_flusher_placement(hints, "tx_async_cpu", true),
+        _udp_fd(-1),
+        _ring_fd(-1),
+        _ring(NULL),
+        _ring_bytes(0),
+        _index(0),
+        _pending(0),
+        _ip_id(0),
+        _send_done(false)
+    {
+        this->open_udp_socket(addr, port);
+        const std::string iface = hints.has_key("xport_iface")? hints["xport_iface"] : umtrx_frame_pool::find_iface(_device_addr.sin_addr.s_addr);
+        this->lookup_mac(iface);
+        this->open_ring(iface, size_t(hints.cast<double>("num_send_frames", DEFAULT_NUM_SEND_FRAMES)), hints.cast<int>("prefault", 0) != 0);
+
+        _recv_mem.resize(DEFAULT_NUM_RECV_FRAMES*_recv_frame_size);
+        for (size_t i = 0; i < DEFAULT_NUM_RECV_FRAMES; i++)
+        {
+            _mrbs.push_back(new tx_ring_mrb(&_recv_mem[i*_recv_frame_size]));
+        }
+
+        //the flusher kicks a partial batch once its deadline expires
+        if (_send_batch_size > 1)
+        {
+            _send_flusher.reset(new boost::thread(boost::bind(&umtrx_packet_tx_ring_zero_copy_impl::send_flusher_loop, this)));
+        }
+
+        UHD_MSG(status) << boost::format("umtrx_packet_tx_ring_zero_copy: %s, %u ring frames of %u bytes, send batch %u")
+            % iface % _msbs.size() % _ring_frame_size % _send_batch_size << std::endl;
+    }
+
+    ~umtrx_packet_tx_ring_zero_copy_impl(void)
+    {
+        if (_send_flusher)
+        {
+            {
+                boost::mutex::scoped_lock lock(_send_mutex);
+                _send_done = true;
+            }
+            _send_cond.notify_one();
+            _send_flusher->join();
+        }
+        {
+            boost::mutex::scoped_lock lock(_send_mutex);
+            this->kick();
+        }
+        if (_ring != NULL) ::munmap(_ring, _ring_bytes);
+        if (_ring_fd >= 0) ::close(_ring_fd);
+        if (_udp_fd >= 0) ::close(_udp_fd);
+        for (size_t i = 0; i < _mrbs.size(); i++) delete _mrbs[i];
+        for (size_t i = 0; i < _msbs.size(); i++) delete _msbs[i];
+    }
+
+    /*******************************************************************
+     * Receive: through the connected UDP socket
+     ******************************************************************/
+    managed_recv_buffer::sptr get_recv_buff(double timeout)
+    {
+        tx_ring_mrb *mrb = NULL;
+        for (size_t i = 0; i < _mrbs.size() and mrb == NULL; i++)
+        {
+            if (not _mrbs[i]->in_use) mrb = _mrbs[i];
+        }
+        if (mrb == NULL) return managed_recv_buffer::sptr();
+
+        struct pollfd pfd;
+        pfd.fd = _udp_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, timeout_to_ms(timeout)) <= 0) return managed_recv_buffer::sptr();
+        const ssize_t ret = ::recv(_udp_fd, mrb->mem, _recv_frame_size, MSG_DONTWAIT);
+        if (ret <= 0) return managed_recv_buffer::sptr();
+        return mrb->get_new(size_t(ret));
+    }
+
+    size_t get_num_recv_frames(void) const
+    {
+        return _mrbs.size();
+    }
+
+    size_t get_recv_frame_size(void) const
+    {
+        return _recv_frame_size;
+    }
+
+    /*******************************************************************
+     * Send: the frames are taken in ring order once the kernel sent them,
+     * committed frames are kicked when the batch fills, at burst end, or
+     * on the deadline.
+     ******************************************************************/
+    managed_send_buffer::sptr get_send_buff(double timeout)
+    {
+        tx_ring_msb *msb = _msbs[_index];
+        if (not this->frame_free(msb->hdr))
+        {
+            //the frame may be waiting in the batch
+            {
+                boost::mutex::scoped_lock lock(_send_mutex);
+                this->kick();
+            }
+            struct pollfd pfd;
+            pfd.fd = _ring_fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            ::poll(&pfd, 1, timeout_to_ms(timeout));
+            if (not this->frame_free(msb->hdr)) return managed_send_buffer::sptr();
+        }
+        if (msb->hdr->tp_status == TP_STATUS_WRONG_FORMAT)
+        {
+            UHD_MSG(error) << "umtrx_packet_tx_ring_zero_copy: the kernel rejected a frame" << std::endl;
+        }
+        _index = (_index + 1) % _msbs.size();
+        return msb->get_new();
+    }
+
+    void commit(tx_ring_msb *msb)
+    {
+        //headers in front of the payload, no UDP checksum
+        const size_t udp_len = UDP_HDR_BYTES + msb->len;
+        boost::uint8_t *ip = msb->ip();
+        boost::uint16_t *udp = reinterpret_cast<boost::uint16_t *>(ip + IP_HDR_BYTES);
+        *reinterpret_cast<boost::uint16_t *>(ip + 2) = htons(boost::uint16_t(IP_HDR_BYTES + udp_len));
+        *reinterpret_cast<boost::uint16_t *>(ip + 4) = htons(_ip_id++);
+        *reinterpret_cast<boost::uint16_t *>(ip + 10) = 0;
+        *reinterpret_cast<boost::uint16_t *>(ip + 10) = htons(ip_checksum(ip));
+        udp[2] = htons(boost::uint16_t(udp_len));
+        udp[3] = 0;
+        msb->hdr->tp_len = IP_HDR_BYTES + udp_len;
+
+        boost::mutex::scoped_lock lock(_send_mutex);
+        __sync_synchronize();
+        msb->hdr->tp_status = TP_STATUS_SEND_REQUEST;
+        _pending++;
+        if (_pending >= _send_batch_size or not umtrx_tx_is_coalescable(ip + IP_HDR_BYTES + UDP_HDR_BYTES, msb->len))
+        {
+            this->kick();
+        }
+        else if (_pending == 1)
+        {
+            _send_deadline = boost::get_system_time() + _send_flush_time;
+            lock.unlock();
+            _send_cond.notify_one();
+        }
+    }
+
+    size_t get_num_send_frames(void) const
+    {
+        return _msbs.size();
+    }
+
+    size_t get_send_frame_size(void) const
+    {
+        return _send_frame_size;
+    }
+
+private:
+    UHD_INLINE bool frame_free(const struct tpacket2_hdr *hdr) const
+    {
+        const unsigned status = *static_cast<const volatile unsigned *>(&hdr->tp_status);
+        return status == TP_STATUS_AVAILABLE or status == TP_STATUS_WRONG_FORMAT;
+    }
+
+    //! one syscall sends every frame marked for sending, called with the send mutex held
+    void kick(void)
+    {
+        if (_pending == 0) return;
+        _pending = 0;
+        while (::sendto(_ring_fd, NULL, 0, MSG_DONTWAIT, reinterpret_cast<const struct sockaddr *>(&_dest), sizeof(_dest)) < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN and errno != ENOBUFS)
+            {
+                UHD_MSG(error) << "umtrx_packet_tx_ring_zero_copy: send failed: " << strerror(errno) << std::endl;
+            }
+            break; //the marked frames go with the next kick
+        }
+    }
+
+    void send_flusher_loop(void)
+    {
+        _send_flusher_placement.apply("umtrx_packet_tx_ring_zero_copy send flusher");
+        boost::mutex::scoped_lock lock(_send_mutex);
+        while (not _send_done)
+        {
+            if (_pending == 0) _send_cond.wait(lock);
+            else if (boost::get_system_time() >= _send_deadline) this->kick();
+            else _send_cond.timed_wait(lock, _send_deadline);
+        }
+    }
+
+    void open_udp_socket(const std::string &addr, const std::string &port)
+    {
+        struct addrinfo hints_ai;
+        std::memset(&hints_ai, 0, sizeof(hints_ai));
+        hints_ai.ai_family = AF_INET;
+        hints_ai.ai_socktype = SOCK_DGRAM;
+        struct addrinfo *res = NULL;
+        if (::getaddrinfo(addr.c_str(), port.c_str(), &hints_ai, &res) != 0 or res == NULL)
+        {
+            throw uhd::io_error("umtrx_packet_tx_ring_zero_copy: cannot resolve " + addr);
+        }
+        std::memcpy(&_device_addr, res->ai_addr, sizeof(_device_addr));
+
+        _udp_fd = ::socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        const bool connected = (_udp_fd >= 0) and (::connect(_udp_fd, res->ai_addr, res->ai_addrlen) == 0);
+        ::freeaddrinfo(res);
+        if (not connected)
+        {
+            if (_udp_fd >= 0) ::close(_udp_fd);
+            throw uhd::io_error(str(boost::format("umtrx_packet_tx_ring_zero_copy: cannot connect to %s:%s: %s") % addr % port % strerror(errno)));
+        }
+
+        //the ring frames carry the addresses of the connected socket
+        socklen_t local_len = sizeof(_local_addr);
+        ::getsockname(_udp_fd, reinterpret_cast<struct sockaddr *>(&_local_addr), &local_len);
+    }
+
+    void lookup_mac(const std::string &iface)
+    {
+        struct arpreq req;
+        std::memset(&req, 0, sizeof(req));
+        std::memcpy(&req.arp_pa, &_device_addr, sizeof(_device_addr));
+        std::strncpy(req.arp_dev, iface.c_str(), sizeof(req.arp_dev) - 1);
+        if (::ioctl(_udp_fd, SIOCGARP, &req) != 0 or (req.arp_flags & ATF_COM) == 0)
+        {
+            throw uhd::io_error(str(boost::format("umtrx_packet_tx_ring_zero_copy: no ARP entry for %s on %s, the device must be on the local link")
+                % inet_ntoa(_device_addr.sin_addr) % iface));
+        }
+        std::memset(&_dest, 0, sizeof(_dest));
+        _dest.sll_family = AF_PACKET;
+        _dest.sll_protocol = htons(ETH_P_IP);
+        _dest.sll_ifindex = ::if_nametoindex(iface.c_str());
+        _dest.sll_halen = ETH_ALEN;
+        std::memcpy(_dest.sll_addr, req.arp_ha.sa_data, ETH_ALEN);
+    }
+
+    void open_ring(const std::string &iface, const size_t num_frames, const bool prefault)
+    {
+        //protocol 0: the socket sends only, nothing is queued for it
+        _ring_fd = ::socket(AF_PACKET, SOCK_DGRAM, 0);
+        if (_ring_fd < 0)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_tx_ring_zero_copy: AF_PACKET socket: %s (needs CAP_NET_RAW)") % strerror(errno)));
+        }
+
+        int version = TPACKET_V2;
+        if (::setsockopt(_ring_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_tx_ring_zero_copy: PACKET_VERSION: %s") % strerror(errno)));
+        }
+
+        //power of two frames tile the page aligned blocks exactly
+        _ring_frame_size = next_pow2(TX_RING_DATA_OFFSET + IP_HDR_BYTES + UDP_HDR_BYTES + _send_frame_size);
+        const size_t block_size = std::max<size_t>(::getpagesize(), _ring_frame_size);
+        const size_t frames_per_block = block_size/_ring_frame_size;
+        struct tpacket_req req;
+        req.tp_block_size = block_size;
+        req.tp_frame_size = _ring_frame_size;
+        req.tp_block_nr = (std::max<size_t>(num_frames, 1) + frames_per_block - 1)/frames_per_block;
+        req.tp_frame_nr = req.tp_block_nr*frames_per_block;
+        if (::setsockopt(_ring_fd, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) != 0)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_tx_ring_zero_copy: PACKET_TX_RING: %s") % strerror(errno)));
+        }
+
+        _ring_bytes = size_t(req.tp_block_size)*req.tp_block_nr;
+        void *ring = ::mmap(NULL, _ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _ring_fd, 0);
+        if (ring == MAP_FAILED)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_tx_ring_zero_copy: mmap: %s") % strerror(errno)));
+        }
+        _ring = reinterpret_cast<boost::uint8_t *>(ring);
+        if (prefault and ::mlock(ring, _ring_bytes) != 0)
+        {
+            UHD_MSG(warning) << boost::format("umtrx_packet_tx_ring_zero_copy: cannot lock the %u byte ring: %s, check ulimit -l") % _ring_bytes % strerror(errno) << std::endl;
+        }
+
+        //the fixed header fields are written once per frame
+        for (size_t i = 0; i < req.tp_frame_nr; i++)
+        {
+            struct tpacket2_hdr *hdr = reinterpret_cast<struct tpacket2_hdr *>(_ring + i*_ring_frame_size);
+            _msbs.push_back(new tx_ring_msb(hdr, _send_frame_size, *this));
+            boost::uint8_t *ip = _msbs.back()->ip();
+            std::memset(ip, 0, IP_HDR_BYTES + UDP_HDR_BYTES);
+            ip[0] = 0x45; //ipv4, 5 words
+            ip[6] = 0x40; //don't fragment
+            ip[8] = 64; //ttl
+            ip[9] = IPPROTO_UDP;
+            std::memcpy(ip + 12, &_local_addr.sin_addr, 4);
+            std::memcpy(ip + 16, &_device_addr.sin_addr, 4);
+            boost::uint16_t *udp = reinterpret_cast<boost::uint16_t *>(ip + IP_HDR_BYTES);
+            udp[0] = _local_addr.sin_port;
+            udp[1] = _device_addr.sin_port;
+        }
+
+        struct sockaddr_ll ll;
+        std::memset(&ll, 0, sizeof(ll));
+        ll.sll_family = AF_PACKET;
+        ll.sll_protocol = 0;
+        ll.sll_ifindex = _dest.sll_ifindex;
+        if (ll.sll_ifindex == 0 or ::bind(_ring_fd, reinterpret_cast<struct sockaddr *>(&ll), sizeof(ll)) != 0)
+        {
+            throw uhd::os_error(str(boost::format("umtrx_packet_tx_ring_zero_copy: bind to %s: %s") % iface % strerror(errno)));
+        }
+    }
+
+    const size_t _recv_frame_size, _send_frame_size;
+    const size_t _send_batch_size;
+    const boost::posix_time::time_duration _send_flush_time;
+    const umtrx_thread_placement _send_flusher_placement; //follows the tx async threads
+    int _udp_fd, _ring_fd;
+    struct sockaddr_in _device_addr, _local_addr;
+    struct sockaddr_ll _dest;
+    boost::uint8_t *_ring;
+    size_t _ring_bytes;
+    size_t _ring_frame_size;
+    size_t _index; //next ring frame to hand out
+    size_t _pending; //frames marked since the last kick
+    boost::uint16_t _ip_id;
+
+    std::vector<char> _recv_mem;
+    std::vector<tx_ring_mrb *> _mrbs;
+    std::vector<tx_ring_msb *> _msbs;
+
+    boost::mutex _send_mutex;
+    boost::condition_variable _send_cond;
+    boost::system_time _send_deadline;
+    bool _send_done;
+    boost::scoped_ptr<boost::thread> _send_flusher;
+};
+
+zero_copy_if::sptr umtrx_packet_tx_ring_zero_copy::make(const std::string &addr, const std::string &port, const device_addr_t &hints)
+{
+    return zero_copy_if::sptr(new umtrx_packet_tx_ring_zero_copy_impl(addr, port, hints));
+}
+
+#else //UHD_PLATFORM_LINUX
+
+zero_copy_if::sptr umtrx_packet_tx_ring_zero_copy::make(const std::string &, const std::string &, const device_addr_t &)
+{
+    throw uhd::not_implemented_error("umtrx_packet_tx_ring_zero_copy: AF_PACKET rings require linux");
+}
+
+#endif //UHD_PLATFORM_LINUX
@@ -0,0 +1,58 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_PACKET_TX_RING_ZERO_COPY_HPP
+#define INCLUDED_UMTRX_PACKET_TX_RING_ZERO_COPY_HPP
+
+#include <uhd/transport/zero_copy.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <string>
+
+/*!
+ * A send transport that builds the datagrams straight in the frames of a
+ * memory mapped AF_PACKET TX ring (TPACKET_V2), the IP and UDP headers
+ * in front, so the samples are never copied into a socket buffer. One
+ * send() kicks every committed frame of a batch. The kernel hands the
+ * frames back once sent, get_send_buff() takes them in ring order.
+ *
+ * The ring depth follows the flow control window: the host never holds
+ * more packets in flight than the device takes, so a deeper ring would
+ * never fill. A connected UDP socket owns the local port and carries the
+ * receives. The device must be on the local link, its MAC comes from the
+ * ARP table of the interface.
+ *
+ * Requires CAP_NET_RAW. Transport hints:
+ *  - xport_iface: network interface facing the device (default: auto)
+ *  - recv_frame_size, send_frame_size: frame sizes in bytes
+ *  - num_send_frames: number of ring frames (default 32)
+ *  - send_batch_size: committed frames per kick (default 1, no batching)
+ *  - send_flush_time: deadline in seconds for a partial batch (default 1e-3)
+ *  - tx_async_cpu, rt_priority: send flusher placement, see umtrx_thread_placement
+ *  - prefault: 1 locks the ring in memory (default 0)
+ */
+class umtrx_packet_tx_ring_zero_copy : public virtual uhd::transport::zero_copy_if
+{
+public:
+    //! Make a new transport, throws on non-linux platforms
+    static uhd::transport::zero_copy_if::sptr make(
+        const std::string &addr,
+        const std::string &port,
+        const uhd::device_addr_t &hints
+    );
+};
+
+#endif /* INCLUDED_UMTRX_PACKET_TX_RING_ZERO_COPY_HPP */
@@ -0,0 +1,107 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_PPS_EVENTS_HPP
+#define INCLUDED_UMTRX_PPS_EVENTS_HPP
+
+#include <uhd/types/time_spec.hpp>
+#include <boost/function.hpp>
+#include <boost/cstdint.hpp>
+#include <cstddef>
+
+//the module is built with hidden symbols, keep the type info shared for dynamic_cast
+#if defined(__GNUC__)
+#define UMTRX_PPS_EVENTS_API __attribute__((visibility("default")))
+#else
+#define UMTRX_PPS_EVENTS_API
+#endif
+
+/*!
+ * Push notification of the PPS edges.
+ *
+ * The firmware sends a report to the host after every PPS edge, the
+ * UmTRX device implements this interface on top of it and get() finds
+ * it behind the device of multi_usrp. Instead of polling the last PPS
+ * time, an application registers a callback or waits for the next edge.
+ * The report leaves the board a few microseconds after the edge, with
+ * the device time the FPGA latched at the edge.
+ *
+ * Firmware older than UMTRX_FW_PPS_EVENT_MINOR reports only the edges
+ * with a valid GPSDO measurement, with the time read in the interrupt.
+ *
+ * Header only so that applications can use it without linking the module.
+ */
+class UMTRX_PPS_EVENTS_API umtrx_pps_events
+{
+public:
+    struct event_type
+    {
+        //! Device time of the PPS edge
+        uhd::time_spec_t time;
+
+        //! Valid GPSDO measurements since the firmware started
+        boost::uint32_t seq;
+
+        //! The VCTCXO count over the second before this edge was in range
+        bool measured;
+
+        //! State of the GPSDO after this edge
+        bool gpsdo_locked;
+
+        //! The GPS time of day was latched into the device time
+        bool gps_time_set;
+
+        //! Filtered frequency error of the VCTCXO, Hz
+        double freq_error;
+    };
+
+    typedef boost::function<void(const event_type &)> callback_type;
+
+    virtual ~umtrx_pps_events(void) {}
+
+    /*!
+     * Call back on every PPS edge, on the thread that receives the reports.
+     * A callback should return quickly, it delays the ones after it.
+     * \param callback the function to call
+     * \return an id for remove_pps_callback()
+     */
+    virtual size_t add_pps_callback(const callback_type &callback) = 0;
+
+    //! Stop a callback, returns once it is not running
+    virtual void remove_pps_callback(const size_t id) = 0;
+
+    /*!
+     * Wait for the next PPS edge after the call.
+     * \param event the report of the edge
+     * \param timeout seconds to wait
+     * \return false on a timeout, ex: no PPS input
+     */
+    virtual bool recv_pps_event(event_type &event, const double timeout = 1.5) = 0;
+
+    /*!
+     * The PPS interface of a device.
+     * \param device a device sptr of any UHD version, ex: multi_usrp::get_device()
+     * \return the interface, valid with the device, or NULL for other devices
+     */
+    template <typename device_sptr_type>
+    static umtrx_pps_events *get(const device_sptr_type &device)
+    {
+        return dynamic_cast<umtrx_pps_events *>(device.get());
+    }
+};
+
+#endif /* INCLUDED_UMTRX_PPS_EVENTS_HPP */
@@ -0,0 +1,268 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_impl.hpp"
+#include "umtrx_log_adapter.hpp"
+#include "umtrx_async_log.hpp"
+#include <boost/bind/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace uhd;
+using namespace uhd::usrp;
+
+/*!
+ * Thermal and VSWR protection of the PAs.
+ *
+ * Runs in the status monitor right after each sensor sample, so the
+ * response time is bounded by sensor_poll_period. Thresholds come from
+ * the device args, a check is disabled when its threshold is not given:
+ *  - prot_temp_max: degC, back off the PA power above this
+ *  - prot_temp_shutdown: degC, disable the PA above this
+ *  - prot_temp_hyst: degC below a threshold to clear it (default 5)
+ *  - prot_vswr_max: back off the PA power above this VSWR
+ *  - prot_vswr_hyst: VSWR below prot_vswr_max to clear (default 0.5)
+ *  - prot_vswr_min_pf: dBm of forward power below which VSWR is not judged (default 20)
+ *  - prot_backoff: dB of back off added or removed per sample (default 3)
+ *  - vswr_calibration, vswr_coef: detector offset in V and slope in V/dB,
+ *    as in umtrx_vswr.py (defaults 0 and 0.05)
+ *
+ * Both PAs share the DCDC supply, so the power is backed off by the
+ * larger back off of the two sides. A PA shutdown is per side.
+ *
+ * Closed loop Tx power, pa_loop=on, runs in the same pass:
+ * the PA curves are open loop and drift with temperature, the loop
+ * compares the forward detector of the side set last with the power
+ * asked through set_tx_power and trims the PA power, or VGA2 below the
+ * PA range, one step per sample toward it:
+ *  - pa_loop_step: dB of trim per sample at most (default 0.5)
+ *  - pa_loop_deadband: dB of error left alone (default 0.5)
+ *  - pa_loop_max_trim: dB of trim either way at most (default 3)
+ *  - pa_loop_offset: dB from the detector reading to the output power (default 0)
+ *  - pa_loop_min_pf: dBm of forward power below which there is no carrier to measure (default 20)
+ * The loop holds while the protection backs off, and a new set_tx_power
+ * starts it over from no trim.
+ */
+
+static const char *prot_sides[2] = {"A", "B"};
+
+//! VSWR from the forward and reflected detector voltages, as umtrx_vswr.py
+static double vswr_from_detector(const double vpf, const double vpr, const double calibration, const double coef)
+{
+    const double pf = (vpf - calibration)/coef;
+    const double pr = (vpr - calibration)/coef;
+    const double gamma = std::pow(10.0, -(pf - pr)/20.0);
+    if (gamma >= 1.0) return std::numeric_limits<double>::infinity();
+    return (1 + gamma)/(1 - gamma);
+}
+
+//! comparator with hysteresis, returns the new tripped state
+static bool hysteresis(const bool tripped, const double value, const double trip, const double hyst)
+{
+    if (boost::math::isnan(value)) return tripped; //no reading, hold the state
+    if (value > trip) return true;
+    if (value < trip - hyst) return false;
+    return tripped;
+}
+
+static double cached_value(const umtrx_sensor_cache_t &cache, const std::string &path)
+{
+    std::map<std::string, sensor_value_t>::const_iterator it = cache.sensors.find(path);
+    if (it == cache.sensors.end()) return std::numeric_limits<double>::quiet_NaN();
+    return it->second.to_real();
+}
+
+void umtrx_impl::protection_setup(const uhd::device_addr_t &device_addr, const uhd::fs_path &mb_path)
+{
+    const double off = std::numeric_limits<double>::infinity();
+    _prot_temp_max = device_addr.cast<double>("prot_temp_max", off);
+    _prot_temp_shutdown = device_addr.cast<double>("prot_temp_shutdown", off);
+    _prot_temp_hyst = device_addr.cast<double>("prot_temp_hyst", 5.0);
+    _prot_vswr_max = device_addr.cast<double>("prot_vswr_max", off);
+    _prot_vswr_hyst = device_addr.cast<double>("prot_vswr_hyst", 0.5);
+    _prot_vswr_min_pf = device_addr.cast<double>("prot_vswr_min_pf", 20.0);
+    _prot_backoff_step = device_addr.cast<double>("prot_backoff", 3.0);
+    _vswr_calibration = device_addr.cast<double>("vswr_calibration", 0.0);
+    _vswr_coef = device_addr.cast<double>("vswr_coef", 0.05);
+    _prot_enabled = not (boost::math::isinf(_prot_temp_max) and boost::math::isinf(_prot_temp_shutdown) and boost::math::isinf(_prot_vswr_max));
+    _pa_power_requested = std::numeric_limits<double>::quiet_NaN();
+    _pa_power_backoff = 0.0;
+    _pa_loop_enabled = device_addr.get("pa_loop", "off") == "on";
+    _pa_loop_step = device_addr.cast<double>("pa_loop_step", 0.5);
+    _pa_loop_deadband = device_addr.cast<double>("pa_loop_deadband", 0.5);
+    _pa_loop_max_trim = device_addr.cast<double>("pa_loop_max_trim", 3.0);
+    _pa_loop_offset = device_addr.cast<double>("pa_loop_offset", 0.0);
+    _pa_loop_min_pf = device_addr.cast<double>("pa_loop_min_pf", 20.0);
+    _pa_loop_trim = 0.0;
+    _tx_power_target = std::numeric_limits<double>::quiet_NaN();
+    _tx_vga2_base = 0.0;
+    _tree->create<sensor_value_t>(mb_path / "power_loop" / "trim")
+        .publish(boost::bind(&umtrx_impl::get_power_loop_trim, this));
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        _prot_state[i].temp_tripped = false;
+        _prot_state[i].temp_shutdown = false;
+        _prot_state[i].vswr_tripped = false;
+        _prot_state[i].backoff = 0.0;
+        _tree->create<sensor_value_t>(mb_path / "protection" / prot_sides[i] / "state")
+            .publish(boost::bind(&umtrx_impl::get_protection_state, this, i));
+    }
+
+    if (not _prot_enabled and not _pa_loop_enabled) return;
+    if (_sensor_poll_period <= 0)
+    {
+        UHD_MSG(warning) << "PA protection needs the sensor sampler, using sensor_poll_period=1" << std::endl;
+        _sensor_poll_period = 1.0;
+    }
+    if (_prot_enabled) UHD_MSG(status) << boost::format("PA protection: temp max %.1fC shutdown %.1fC, VSWR max %.2f, every %.2fs")
+        % _prot_temp_max % _prot_temp_shutdown % _prot_vswr_max % _sensor_poll_period << std::endl;
+    if (_pa_loop_enabled) UHD_MSG(status) << boost::format("Tx power loop: %.1fdB steps to %.1fdB of trim, deadband %.1fdB, every %.2fs")
+        % _pa_loop_step % _pa_loop_max_trim % _pa_loop_deadband % _sensor_poll_period << std::endl;
+}
+
+void umtrx_impl::protection_update(const umtrx_sensor_cache_t &cache)
+{
+    if (not _prot_enabled) return;
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+
+    double backoff = 0.0;
+    bool shutdown_changed = false;
+    for (size_t i = 0; i < 2; i++)
+    {
+        const std::string which = prot_sides[i];
+        protection_side_t &state = _prot_state[i];
+        const protection_side_t old = state;
+
+        const double temp = cached_value(cache, _sensor_slot_paths[UMTRX_SENSORS_TEMP_A + i]);
+        state.temp_tripped = hysteresis(state.temp_tripped, temp, _prot_temp_max, _prot_temp_hyst);
+        state.temp_shutdown = hysteresis(state.temp_shutdown, temp, _prot_temp_shutdown, _prot_temp_hyst);
+
+        //forward and reflected detectors of this side, judged only with enough forward power
+        const double vpf = cached_value(cache, _sensor_slot_paths[UMTRX_SENSORS_PWR_0 + 2*i + 1]); //PFn
+        const double vpr = cached_value(cache, _sensor_slot_paths[UMTRX_SENSORS_PWR_0 + 2*i]);     //PRn
+        const bool vswr_valid = (vpf - _vswr_calibration)/_vswr_coef >= _prot_vswr_min_pf;
+        const double vswr = vswr_valid ? vswr_from_detector(vpf, vpr, _vswr_calibration, _vswr_coef)
+                                       : std::numeric_limits<double>::quiet_NaN();
+        state.vswr_tripped = hysteresis(state.vswr_tripped, vswr, _prot_vswr_max, _prot_vswr_hyst);
+
+        //step the back off up while tripped and down once cleared
+        if (state.temp_tripped or state.vswr_tripped) state.backoff += _prot_backoff_step;
+        else state.backoff = std::max(0.0, state.backoff - _prot_backoff_step);
+
+        if (state.temp_tripped != old.temp_tripped or state.vswr_tripped != old.vswr_tripped or state.temp_shutdown != old.temp_shutdown)
+        {
+            UMTRX_MSG_ASYNC(warning) << boost::format("PA protection %s: temp %.1fC%s%s, VSWR %.2f%s")
+                % which % temp % (state.temp_tripped ? " HIGH" : "") % (state.temp_shutdown ? " SHUTDOWN" : "")
+                % vswr % (state.vswr_tripped ? " HIGH" : "") << std::endl;
+        }
+        shutdown_changed = shutdown_changed or (state.temp_shutdown != old.temp_shutdown);
+        backoff = std::max(backoff, state.backoff);
+    }
+
+    if (shutdown_changed) commit_pa_state();
+
+    //the PA path only exists with a PA and after the Tx power has been set
+    if (not _pa.has_key("A") or not _pa["A"] or boost::math::isnan(_pa_power_requested)) return;
+    const double max_backoff = std::max(0.0, _pa_power_requested - _pa["A"]->min_power_dBm());
+    backoff = std::min(backoff, max_backoff);
+    for (size_t i = 0; i < 2; i++) _prot_state[i].backoff = std::min(_prot_state[i].backoff, max_backoff);
+    if (backoff == _pa_power_backoff) return;
+
+    _pa_power_backoff = backoff;
+    _pa_loop_trim = 0.0; //the loop starts over once the protection lets go
+    UMTRX_MSG_ASYNC(warning) << "PA protection: backing off PA power by " << backoff << "dB" << std::endl;
+    set_pa_power(_pa_power_requested - backoff, _pa_power_side);
+}
+
+void umtrx_impl::power_loop_update(const umtrx_sensor_cache_t &cache)
+{
+    if (not _pa_loop_enabled) return;
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+    if (not _pa.has_key("A") or not _pa["A"] or boost::math::isnan(_tx_power_target)) return;
+
+    //the protection owns the power while it backs off
+    const size_t i = (_pa_power_side == "B") ? 1 : 0;
+    if (_pa_power_backoff > 0 or _prot_state[i].vswr_tripped or get_pa_shutdown(i)) return;
+
+    //no carrier, ex: between bursts, leaves nothing to compare
+    const double vpf = cached_value(cache, _sensor_slot_paths[UMTRX_SENSORS_PWR_0 + 2*i + 1]); //PFn
+    const double forward = (vpf - _vswr_calibration)/_vswr_coef + _pa_loop_offset;
+    if (boost::math::isnan(forward) or forward < _pa_loop_min_pf) return;
+
+    const double error = _tx_power_target - forward;
+    if (std::abs(error) <= _pa_loop_deadband) return;
+    const double step = std::max(-_pa_loop_step, std::min(_pa_loop_step, error));
+    double trim = std::max(-_pa_loop_max_trim, std::min(_pa_loop_max_trim, _pa_loop_trim + step));
+
+    const std::string which = _pa_power_side;
+    if (_tx_power_target >= _pa[which]->min_power_dBm())
+    {
+        //within the range of the PA curve, a step of dcdc_r
+        const double power = std::max(_pa[which]->min_power_dBm(), std::min(_pa_power_max_dBm, _pa_power_requested + trim));
+        trim = power - _pa_power_requested;
+        if (trim == _pa_loop_trim) return; //at a limit
+        set_pa_power(power, which);
+    }
+    else
+    {
+        //below it VGA2 sets the power, in its 1dB steps
+        const double vga2 = std::max<double>(UMTRX_VGA2_MIN, std::min<double>(_umtrx_vga2_def, _tx_vga2_base + std::floor(trim + 0.5)));
+        trim = vga2 - _tx_vga2_base;
+        if (trim == _pa_loop_trim) return; //at a limit, or the step rounds to none
+        _lms_ctrl[which]->set_tx_gain(vga2, "VGA2");
+    }
+    _pa_loop_trim = trim;
+    UMTRX_MSG_ASYNC(status) << boost::format("Tx power loop %s: forward %.1fdBm, target %.1fdBm, trim %+.1fdB")
+        % which % forward % _tx_power_target % trim << std::endl;
+}
+
+sensor_value_t umtrx_impl::get_power_loop_trim(void)
+{
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+    return sensor_value_t("Tx power trim", _pa_loop_trim, "dB");
+}
+
+double umtrx_impl::set_pa_power_limited(double power, const std::string &which)
+{
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+    _pa_power_requested = power;
+    _pa_power_side = which;
+    const double backoff = std::min(_pa_power_backoff, std::max(0.0, power - _pa[which]->min_power_dBm()));
+    return set_pa_power(power - backoff, which);
+}
+
+bool umtrx_impl::get_pa_shutdown(const size_t side) const
+{
+    return _prot_enabled and _prot_state[side].temp_shutdown;
+}
+
+sensor_value_t umtrx_impl::get_protection_state(const size_t side)
+{
+    boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+    const protection_side_t &state = _prot_state[side];
+    std::string desc = "ok";
+    if (state.temp_shutdown) desc = "shutdown";
+    else if (state.temp_tripped and state.vswr_tripped) desc = "temp,vswr";
+    else if (state.temp_tripped) desc = "temp";
+    else if (state.vswr_tripped) desc = "vswr";
+    else if (state.backoff > 0) desc = "recovering";
+    return sensor_value_t("Protection"+std::string(prot_sides[side]), desc, "");
+}
@@ -45,26 +45,54 @@ localparam SR_BUF_POOL =  16;   // 4
 
 localparam SR_RX_FRONT0 =  20;   // 5
 localparam SR_RX_FRONT1 =  25;   // 5
-localparam SR_RX_CTRL0 =  30;   // 9
-localparam SR_RX_DSP0  =  40;   // 7
-localparam SR_RX_CTRL1 =  50;   // 9
-localparam SR_RX_DSP1  =  60;   // 7
-localparam SR_RX_CTRL2 =  70;   // 9
-localparam SR_RX_DSP2  =  80;   // 7
-localparam SR_RX_CTRL3 =  90;   // 9
-localparam SR_RX_DSP3  =  100;   // 7
+localparam SR_RX_CTRL0 =  30;   // 10
+localparam SR_RX_DSP0  =  40;   // 10
+localparam SR_RX_CTRL1 =  50;   // 10
+localparam SR_RX_DSP1  =  60;   // 10
+localparam SR_RX_CTRL2 =  70;   // 10
+localparam SR_RX_DSP2  =  80;   // 10
+localparam SR_RX_CTRL3 =  90;   // 10
+localparam SR_RX_DSP3  =  100;   // 10
 
 localparam SR_TX_FRONT0 = 110;   // ?
-localparam SR_TX_CTRL0  = 126;   // 6
-localparam SR_TX_DSP0   = 135;   // 5
+localparam SR_TX_CTRL0  = 126;   // 7
+localparam SR_TX_DSP0   = 135;   // 9
 localparam SR_TX_FRONT1 = 145;   // ?
-localparam SR_TX_CTRL1  = 161;   // 6
-localparam SR_TX_DSP1   = 170;   // 5
+localparam SR_TX_CTRL1  = 161;   // 7
+localparam SR_TX_DSP1   = 170;   // 9
 
 localparam SR_DIVSW    = 180;   // 2
 localparam SR_RX_FE_SW = 183;   // 1
 localparam SR_TX_FE_SW = 184;   // 1
 localparam SR_SPI_CORE = 185;   // 3
+localparam SR_SRAM_SPLIT = 188; // 1
+localparam SR_RX_FE_DC0 = 189;  // 1
+localparam SR_RX_FE_DC1 = 190;  // 1
+localparam SR_TX_LOOP = 191;    // 1
+localparam SR_LOOPBACK = 192;   // 1
+localparam SR_LINK_TEST = 193;  // 1
+localparam SR_RX_GATE0 = 194;   // 4
+localparam SR_RX_GATE1 = 198;   // 4
+localparam SR_RX_GATE2 = 202;   // 4
+localparam SR_RX_GATE3 = 206;   // 4
+localparam SR_RX_FIR0 = 210;    // 2
+localparam SR_RX_FIR1 = 212;    // 2
+localparam SR_RX_FIR2 = 214;    // 2
+localparam SR_RX_FIR3 = 216;    // 2
+localparam SR_TX_MOD0 = 218;    // 2
+localparam SR_TX_MOD1 = 220;    // 2
+localparam SR_RX_COMBINE0 = 222; // 3, DSP1 combines DSP0
+localparam SR_RX_COMBINE1 = 225; // 3, DSP3 combines DSP2
+localparam SR_RX_TONE0 = 228;   // 2
+localparam SR_RX_TONE1 = 230;   // 2
+localparam SR_RX_TONE2 = 232;   // 2
+localparam SR_RX_TONE3 = 234;   // 2
+localparam SR_TX_RAMP0 = 236;   // 2
+localparam SR_TX_RAMP1 = 238;   // 2
+localparam SR_RX_AGC0 = 240;    // 6, LMS1
+localparam SR_RX_AGC1 = 246;    // 6, LMS2
+localparam SR_ATR0 = 252;       // 2, LMS1
+localparam SR_ATR1 = 254;       // 2, LMS2
 
 #define U2_REG_SR_ADDR(sr) (SETTING_REGS_BASE + (4 * (sr)))
 
@@ -84,26 +112,77 @@ localparam SR_SPI_CORE = 185;   // 3
 ////////////////////////////////////////////////
 #define U2_REG_MISC_LMS_RES U2_REG_SR_ADDR(0)
 #define U2_REG_MISC_CTRL_SFC_CLEAR U2_REG_SR_ADDR(1)
+#define U2_REG_MISC_CTRL_SRAM_CLEAR U2_REG_SR_ADDR(2)
 #define U2_REG_MISC_CTRL_LEDS U2_REG_SR_ADDR(3)
 #define U2_REG_MISC_CTRL_PHY U2_REG_SR_ADDR(4)
 #define U2_REG_MISC_CTRL_DBG_MUX U2_REG_SR_ADDR(5)
 #define U2_REG_MISC_CTRL_RAM_PAGE U2_REG_SR_ADDR(6)
 #define U2_REG_MISC_CTRL_FLUSH_ICACHE U2_REG_SR_ADDR(7)
+#define U2_REG_SRAM_SPLIT U2_REG_SR_ADDR(SR_SRAM_SPLIT)
+#define U2_REG_TX_LOOP U2_REG_SR_ADDR(SR_TX_LOOP) //{play, load} per TX DSP, TX0 in the low bits
+#define U2_REG_LOOPBACK U2_REG_SR_ADDR(SR_LOOPBACK) //RX DSPs take the TX DSP outputs
+#define U2_REG_LINK_TEST U2_REG_SR_ADDR(SR_LINK_TEST) //[0] RX0 packet source, [1] TX0 packet sink
+#define U2_FLAG_LINK_TEST_SOURCE 0x1
+#define U2_FLAG_LINK_TEST_SINK 0x2
 
 /////////////////////////////////////////////////
 // Readback regs
 ////////////////////////////////////////////////
 #define U2_REG_SPI_RB READBACK_BASE + 4*0
 #define U2_REG_NUM_DDC READBACK_BASE + 4*1
+#define U2_REG_CTRL_QUEUE_RB READBACK_BASE + 4*1 //settings fifo readback only, [31:16] command fifo lines, [15:0] queued
 #define U2_REG_NUM_DUC READBACK_BASE + 4*2
+#define U2_REG_TX_COUNTERS_RB(dsp) (READBACK_BASE + 4*(2 + (dsp))) //settings fifo readback only, [31:16] late, [15:0] underflow packets, free running
+#define U2_REG_RX_BUFFER_RB READBACK_BASE + 4*3 //[31] rx in sram, [28:24] rx fifosize, [18:0] sram split
+#define U2_FLAG_RX_BUFFER_SRAM 0x80000000
+#define U2_REG_RX_POWER_RB(dsp) (READBACK_BASE + 4*(4 + (dsp))) //settings fifo readback only, the tone meter result while it runs
+#define U2_FLAG_RX_TONE_VALID 0x80000000 //tone meter result: a full integration since the last write
+#define U2_REG_LINK_TEST_SENT_RB READBACK_BASE + 4*4 //udp iface readback only, same for the three below
+#define U2_REG_LINK_TEST_TOTAL_RB READBACK_BASE + 4*5
+#define U2_REG_LINK_TEST_CRC_ERR_RB READBACK_BASE + 4*6
+#define U2_REG_LINK_TEST_SEQ_ERR_RB READBACK_BASE + 4*7
 #define U2_REG_STATUS READBACK_BASE + 4*8
+#define U2_REG_RX_CMD_QUEUE_RB READBACK_BASE + 4*8 //settings fifo readback only, [8n+7:8n] stream commands queued in dsp n
+#define U2_REG_TIME64_HI_RB_SNAPSHOT READBACK_BASE + 4*9 //settings fifo readback only, hi word of the last time lo peek
+#define U2_REG_CAPS_RB READBACK_BASE + 4*9 //udp iface readback only, [31] valid, [20:16] tx fifosize, [15:0] features
+#define U2_FLAG_CAPS_VALID 0x80000000
+#define U2_FLAG_CAPS_SC8 (1 << 0)
+#define U2_FLAG_CAPS_RX_POWER (1 << 1)
+#define U2_FLAG_CAPS_RX_GATE (1 << 2)
+#define U2_FLAG_CAPS_RX_FIR (1 << 3)
+#define U2_FLAG_CAPS_TX_GMSK (1 << 4)
+#define U2_FLAG_CAPS_SHARED_DSP (1 << 5)
+#define U2_FLAG_CAPS_LE_FRAMING (1 << 6) //data packets in little-endian words on request
+#define U2_FLAG_CAPS_RX_BFP8 (1 << 7) //block floating point sc8 RX packets
+#define U2_FLAG_CAPS_RX_COMBINE (1 << 8) //diversity combining in RX DSP1 and DSP3
+#define U2_FLAG_CAPS_RX_TONE (1 << 9) //single bin tone meter per RX DSP
+#define U2_FLAG_CAPS_TX_RAMP (1 << 10) //burst edge ramps per TX DSP
+#define U2_FLAG_CAPS_RX_AGC (1 << 11) //RXVGA2 gain loop per LMS, see U2_REG_RX_AGC_RB
+#define U2_FLAG_CAPS_BURST_ATR (1 << 12) //PA enable and diversity switch per LMS follow its bursts
 #define U2_REG_TIME64_HI_RB_IMM READBACK_BASE + 4*10
 #define U2_REG_TIME64_LO_RB_IMM READBACK_BASE + 4*11
 #define U2_REG_COMPAT_NUM_RB READBACK_BASE + 4*12
+#define U2_REG_RX_AGC_RB READBACK_BASE + 4*12 //settings fifo readback only, LMS n in [16n+15:16n]: [15] on, [6] writing, [4:0] RXVGA2 code
 #define U2_REG_IRQ_RB READBACK_BASE + 4*13
 #define U2_REG_TIME64_HI_RB_PPS READBACK_BASE + 4*14
 #define U2_REG_TIME64_LO_RB_PPS READBACK_BASE + 4*15
 
+/////////////////////////////////////////////////
+// Ethernet MAC regs, see eth_mac_regs_t in the firmware
+////////////////////////////////////////////////
+#define U2_REG_ETH_MAC_SETTINGS ETH_BASE + 4*0
+#define U2_FLAG_ETH_MAC_PAUSE_EN (1 << 0) //respect received PAUSE frames
+#define U2_FLAG_ETH_MAC_PAUSE_SEND_EN (1 << 6) //send PAUSE frames when the rx fifo fills
+#define U2_REG_ETH_MAC_PAUSE_TIME ETH_BASE + 4*11 //quanta of 512 bit times asked for
+#define U2_REG_ETH_MAC_PAUSE_THRESH ETH_BASE + 4*12 //free rx fifo lines that trigger a PAUSE
+#define U2_REG_ETH_MAC_PAUSE_RCVD_RB ETH_BASE + 4*13
+#define U2_REG_ETH_MAC_PAUSE_SENT_RB ETH_BASE + 4*14
+#define U2_REG_ETH_MAC_PAUSE_QUANTA_RB ETH_BASE + 4*15 //of the last PAUSE received
+#define U2_REG_ETH_MAC_RX_FRAMES_RB ETH_BASE + 4*16 //good frames received
+#define U2_REG_ETH_MAC_RX_ERRORS_RB ETH_BASE + 4*17 //CRC, length and GMII errors
+#define U2_REG_ETH_MAC_RX_OVERRUNS_RB ETH_BASE + 4*18 //frames cut by a full rx fifo
+#define U2_REG_ETH_MAC_TX_FRAMES_RB ETH_BASE + 4*19
+
 #define AUX_LD1_IRQ_BIT (1 << 14)
 #define AUX_LD2_IRQ_BIT (1 << 15)
 
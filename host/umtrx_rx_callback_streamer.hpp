@@ -0,0 +1,114 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_RX_CALLBACK_STREAMER_HPP
+#define INCLUDED_UMTRX_RX_CALLBACK_STREAMER_HPP
+
+#include <uhd/types/metadata.hpp>
+#include <boost/function.hpp>
+#include <vector>
+
+//the module is built with hidden symbols, keep the type info shared for dynamic_cast
+#if defined(__GNUC__)
+#define UMTRX_RX_CALLBACK_STREAMER_API __attribute__((visibility("default")))
+#else
+#define UMTRX_RX_CALLBACK_STREAMER_API
+#endif
+
+/*!
+ * Push model receive: a thread of the streamer calls back per packet.
+ *
+ * Every UmTRX rx streamer also implements this interface, get() finds it
+ * behind the rx_streamer from multi_usrp. start() runs a dispatch thread
+ * that receives one packet of every channel at a time, converts it to the
+ * cpu_format of the stream args into the next slot of a buffer pool the
+ * application owns, and calls the callback on that thread. There is no
+ * hand off between receiving and the callback.
+ *
+ * The callback gets the slot until it returns. A callback that returns
+ * true keeps the slot, for processing on another thread: the dispatcher
+ * waits for release() before it fills that slot again, stalling the
+ * stream when the application holds every slot.
+ *
+ * Errors other than timeouts reach the callback with no samples and the
+ * error code in the metadata. recv() and recv_packet() may not be called
+ * while the dispatcher runs. The stream commands are up to the
+ * application, as with recv().
+ *
+ * Header only so that applications can use it without linking the module.
+ */
+class UMTRX_RX_CALLBACK_STREAMER_API umtrx_rx_callback_streamer
+{
+public:
+    struct group_type
+    {
+        //! The buffers of the slot, one per channel
+        std::vector<void *> buffs;
+
+        //! Number of samples per channel
+        size_t nsamps;
+
+        //! Same as the metadata of recv()
+        uhd::rx_metadata_t metadata;
+
+        //! Index of the slot in the pool, for release()
+        size_t slot;
+    };
+
+    //! Return true to keep the slot until release()
+    typedef boost::function<bool(const group_type &)> callback_type;
+
+    struct pool_type
+    {
+        pool_type(void): nsamps_per_slot(0) {}
+
+        //! The slots in the order they are filled, each one buffer per channel
+        std::vector<std::vector<void *> > slots;
+
+        //! Capacity of each buffer in samples, get_max_num_samps() fits any packet
+        size_t nsamps_per_slot;
+    };
+
+    virtual ~umtrx_rx_callback_streamer(void) {}
+
+    /*!
+     * Start the dispatch thread, a running one is stopped first.
+     * \param callback called per packet of every channel, on the dispatch thread
+     * \param pool the buffers, owned by the application until stop() returns
+     * \param cpu the CPU to pin the dispatch thread to, negative leaves it
+     */
+    virtual void start(const callback_type &callback, const pool_type &pool, const int cpu = -1) = 0;
+
+    //! Stop the dispatch thread, returns once the last callback returned
+    virtual void stop(void) = 0;
+
+    //! Give back a slot a callback kept, may be called from any thread
+    virtual void release(const size_t slot) = 0;
+
+    /*!
+     * The callback interface of a streamer.
+     * \param stream an rx streamer sptr of any UHD version
+     * \return the interface, valid with the stream, or NULL for other devices
+     */
+    template <typename stream_sptr_type>
+    static umtrx_rx_callback_streamer *get(const stream_sptr_type &stream)
+    {
+        return dynamic_cast<umtrx_rx_callback_streamer *>(stream.get());
+    }
+};
+
+#endif /* INCLUDED_UMTRX_RX_CALLBACK_STREAMER_HPP */
@@ -0,0 +1,252 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_rx_channelizer.hpp"
+#include "umtrx_common.hpp"
+#include <uhd/exception.hpp>
+#include <algorithm>
+#include <complex>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+
+using namespace uhd;
+
+typedef std::complex<float> fc32_t;
+
+class umtrx_rx_channelizer_impl : public rx_streamer
+{
+public:
+    umtrx_rx_channelizer_impl(rx_streamer::sptr stream, const size_t num_chans,
+        const size_t taps_per_chan, const boost::function<double(void)> &get_samp_rate):
+        _stream(stream),
+        _num_chans(num_chans),
+        _num_taps(num_chans*taps_per_chan),
+        _get_samp_rate(get_samp_rate),
+        _branch(num_chans),
+        _scratch(num_chans),
+        _chan_out(num_chans),
+        _has_time(false),
+        _has_error(false)
+    {
+        UHD_ASSERT_THROW(_stream->get_num_channels() == 1);
+        UHD_ASSERT_THROW(num_chans >= 2 and taps_per_chan >= 1);
+        _fft = (num_chans & (num_chans - 1)) == 0;
+
+        //blackman windowed sinc, cutoff at half the channel spacing, unity gain at dc
+        _taps.resize(_num_taps);
+        double sum = 0.0;
+        for (size_t n = 0; n < _num_taps; n++)
+        {
+            const double x = (double(n) - double(_num_taps - 1)/2)/_num_chans;
+            const double sinc = (x == 0.0)? 1.0 : std::sin(M_PI*x)/(M_PI*x);
+            const double w = 0.42 - 0.5*std::cos(2*M_PI*(n + 0.5)/_num_taps) + 0.08*std::cos(4*M_PI*(n + 0.5)/_num_taps);
+            _taps[n] = float(sinc*w);
+            sum += sinc*w;
+        }
+        for (size_t n = 0; n < _num_taps; n++) _taps[n] = float(_taps[n]/sum);
+
+        //e^(j*2*pi*k/N) for the inverse transform
+        _twiddles.resize(_num_chans);
+        for (size_t k = 0; k < _num_chans; k++) _twiddles[k] = std::polar(1.0f, float(2*M_PI*k/_num_chans));
+
+        //history of num_taps-1 samples in front of the new ones
+        const size_t max_in = std::max(_stream->get_max_num_samps(), _num_chans);
+        _buff.resize(_num_taps - 1 + 2*max_in);
+        _fill = _num_taps - 1;
+        _pos = 0;
+    }
+
+    size_t get_num_channels(void) const
+    {
+        return _num_chans;
+    }
+
+    size_t get_max_num_samps(void) const
+    {
+        return std::max<size_t>(_stream->get_max_num_samps()/_num_chans, 1);
+    }
+
+    void issue_stream_cmd(const stream_cmd_t &stream_cmd)
+    {
+        stream_cmd_t cmd = stream_cmd;
+        cmd.num_samps *= _num_chans; //finite bursts count channel samples
+        if (cmd.stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS) this->reset();
+        _stream->issue_stream_cmd(cmd);
+    }
+
+    size_t recv(const buffs_type &buffs, const size_t nsamps_per_buff, rx_metadata_t &md,
+        const double timeout = 0.1, const bool one_packet = false)
+    {
+        if (_has_error)
+        {
+            _has_error = false;
+            md = _error_md;
+            return 0;
+        }
+
+        const double samp_rate = _get_samp_rate();
+        size_t nsamps = 0;
+        md.reset();
+        while (nsamps < nsamps_per_buff)
+        {
+            //drain the blocks that are already buffered
+            const size_t start = nsamps;
+            for (; nsamps < nsamps_per_buff and _fill - _pos >= _num_taps - 1 + _num_chans; nsamps++)
+            {
+                this->filter_block(&_buff[_pos]);
+                for (size_t ch = 0; ch < _num_chans; ch++)
+                {
+                    reinterpret_cast<fc32_t *>(buffs[ch])[nsamps] = _chan_out[ch];
+                }
+                _pos += _num_chans;
+            }
+            if (nsamps != start and not md.has_time_spec)
+            {
+                md.has_time_spec = _has_time;
+                md.time_spec = _time;
+            }
+            if (_has_time) _time += time_spec_t::from_ticks((nsamps - start)*_num_chans, samp_rate);
+            if (nsamps == nsamps_per_buff or md.end_of_burst or (one_packet and nsamps != 0)) break;
+
+            //keep the history and pull one more packet behind it
+            std::memmove(&_buff[0], &_buff[_pos], (_fill - _pos)*sizeof(fc32_t));
+            _fill -= _pos;
+            _pos = 0;
+            rx_metadata_t in_md;
+            const size_t num_rx = _stream->recv(&_buff[_fill], _buff.size() - _fill, in_md, timeout, true);
+            if (in_md.error_code != rx_metadata_t::ERROR_CODE_NONE)
+            {
+                //the filter state is stale after an overflow or a gap
+                if (in_md.error_code != rx_metadata_t::ERROR_CODE_TIMEOUT) this->reset();
+                if (nsamps == 0)
+                {
+                    md = in_md;
+                    return 0;
+                }
+                _error_md = in_md;
+                _has_error = true;
+                break;
+            }
+            if (in_md.has_time_spec)
+            {
+                //time of the first sample of the next block
+                _time = in_md.time_spec - time_spec_t::from_ticks(_fill - (_num_taps - 1), samp_rate);
+                _has_time = true;
+            }
+            _fill += num_rx;
+            if (in_md.end_of_burst) md.end_of_burst = true;
+        }
+        return nsamps;
+    }
+
+private:
+    void reset(void)
+    {
+        std::fill(_buff.begin(), _buff.begin() + _num_taps - 1, fc32_t());
+        _fill = _num_taps - 1;
+        _pos = 0;
+        _has_time = false;
+    }
+
+    /*!
+     * One output sample per channel from num_chans new input samples.
+     * in points num_taps-1 samples before the first new one.
+     * Branch p sums h[p + q*N]*x[m*N - p - q*N], the channels are the
+     * inverse DFT of the branches.
+     */
+    void filter_block(const fc32_t *in)
+    {
+        const fc32_t *newest = in + _num_taps - 1 + _num_chans - 1;
+        for (size_t p = 0; p < _num_chans; p++)
+        {
+            fc32_t acc;
+            for (size_t n = p; n < _num_taps; n += _num_chans) acc += _taps[n]*newest[-ptrdiff_t(n)];
+            _branch[p] = acc;
+        }
+        if (_fft) this->inverse_fft();
+        else this->inverse_dft();
+    }
+
+    void inverse_dft(void)
+    {
+        for (size_t k = 0; k < _num_chans; k++)
+        {
+            fc32_t acc;
+            for (size_t p = 0; p < _num_chans; p++) acc += _branch[p]*_twiddles[(k*p) % _num_chans];
+            _chan_out[this->chan_of_bin(k)] = acc;
+        }
+    }
+
+    //radix-2 decimation in time, bit reversed input
+    void inverse_fft(void)
+    {
+        size_t bits = 0;
+        while ((size_t(1) << bits) < _num_chans) bits++;
+        for (size_t i = 0; i < _num_chans; i++)
+        {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; b++) if (i & (size_t(1) << b)) r |= size_t(1) << (bits - 1 - b);
+            _scratch[r] = _branch[i];
+        }
+        for (size_t len = 2; len <= _num_chans; len <<= 1)
+        {
+            const size_t stride = _num_chans/len;
+            for (size_t i = 0; i < _num_chans; i += len)
+            {
+                for (size_t j = 0; j < len/2; j++)
+                {
+                    const fc32_t a = _scratch[i + j];
+                    const fc32_t b = _scratch[i + j + len/2]*_twiddles[j*stride];
+                    _scratch[i + j] = a + b;
+                    _scratch[i + j + len/2] = a - b;
+                }
+            }
+        }
+        for (size_t k = 0; k < _num_chans; k++) _chan_out[this->chan_of_bin(k)] = _scratch[k];
+    }
+
+    //bin k sits at k*rate/N, channels run from the most negative frequency up
+    size_t chan_of_bin(const size_t k) const
+    {
+        return (k + _num_chans/2) % _num_chans;
+    }
+
+    rx_streamer::sptr _stream;
+    const size_t _num_chans;
+    const size_t _num_taps;
+    const boost::function<double(void)> _get_samp_rate;
+    bool _fft;
+    std::vector<float> _taps;
+    std::vector<fc32_t> _twiddles;
+    std::vector<fc32_t> _branch, _scratch, _chan_out;
+
+    std::vector<fc32_t> _buff;
+    size_t _fill; //end of the buffered samples
+    size_t _pos; //start of the history of the next block
+    bool _has_time;
+    time_spec_t _time; //time of the first new sample of the next block
+    bool _has_error;
+    rx_metadata_t _error_md; //error held back until the samples before it are handed out
+};
+
+rx_streamer::sptr umtrx_rx_channelizer::make(rx_streamer::sptr stream, const size_t num_chans,
+    const size_t taps_per_chan, const boost::function<double(void)> &get_samp_rate)
+{
+    return UMTRX_UHD_PTR_NAMESPACE::make_shared<umtrx_rx_channelizer_impl>(stream, num_chans, taps_per_chan, get_samp_rate);
+}
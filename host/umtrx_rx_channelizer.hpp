@@ -0,0 +1,51 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_RX_CHANNELIZER_HPP
+#define INCLUDED_UMTRX_RX_CHANNELIZER_HPP
+
+#include <uhd/stream.hpp>
+#include <boost/function.hpp>
+
+/*!
+ * Polyphase filterbank channelizer on top of a one channel fc32 rx streamer.
+ *
+ * Splits the wideband stream into num_chans critically sampled channels
+ * spaced by samp_rate/num_chans, presented as the channels of the returned
+ * streamer. Channel i is centered at (i - num_chans/2)*samp_rate/num_chans,
+ * so the middle channel is the DDC center frequency. Each channel runs at
+ * samp_rate/num_chans and the timestamps keep counting in the wideband
+ * samples, without the filter delay.
+ *
+ * Stream args (after channelizer=num_chans):
+ *  - channelizer_taps: prototype filter taps per channel (default 8)
+ */
+class umtrx_rx_channelizer
+{
+public:
+    /*!
+     * Wrap a streamer.
+     * \param stream one channel streamer with an fc32 cpu format
+     * \param num_chans number of channels, a power of two takes the FFT path
+     * \param taps_per_chan prototype filter length per channel
+     * \param get_samp_rate the current wideband sample rate, for the timestamps
+     */
+    static uhd::rx_streamer::sptr make(uhd::rx_streamer::sptr stream, const size_t num_chans,
+        const size_t taps_per_chan, const boost::function<double(void)> &get_samp_rate);
+};
+
+#endif /* INCLUDED_UMTRX_RX_CHANNELIZER_HPP */
@@ -0,0 +1,95 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_RX_GAIN_EVENTS_HPP
+#define INCLUDED_UMTRX_RX_GAIN_EVENTS_HPP
+
+#include <uhd/types/time_spec.hpp>
+#include <boost/cstdint.hpp>
+#include <cstddef>
+
+//the module is built with hidden symbols, keep the type info shared for dynamic_cast
+#if defined(__GNUC__)
+#define UMTRX_RX_GAIN_EVENTS_API __attribute__((visibility("default")))
+#else
+#define UMTRX_RX_GAIN_EVENTS_API
+#endif
+
+/*!
+ * The gain changes of the RX AGC, as the samples carry them.
+ *
+ * With dboards/<A|B>/rx_frontends/0/agc/enable set, the FPGA steps the
+ * RXVGA2 gain of the LMS on the power of an RX DSP, with no host in the
+ * loop. Every change goes in-band to each DSP fed by that LMS as a context
+ * packet between the data packets, with the device time the register write
+ * was out. Every UmTRX rx streamer implements this interface, get() finds
+ * it behind the rx_streamer from multi_usrp: the samples from that time on
+ * are scaled by the new gain, up to the fixed latency of the DDC.
+ *
+ * The reports are taken by any receive call, recv(), recv_packet() or
+ * the callback dispatcher, and wait here until asked for. Only the
+ * changes while the stream runs are sent.
+ *
+ * Header only so that applications can use it without linking the module.
+ */
+class UMTRX_RX_GAIN_EVENTS_API umtrx_rx_gain_events
+{
+public:
+    struct event_type
+    {
+        //! The channel index of the stream args
+        size_t chan;
+
+        //! Device time the new gain was written to the LMS
+        uhd::time_spec_t time;
+
+        //! Changes of the frontend, counting up: a gap tells of a report lost or replaced
+        boost::uint16_t seq;
+
+        //! The LMS, 0 for A and 1 for B
+        size_t frontend;
+
+        //! The new RXVGA2 gain, dB
+        double gain;
+
+        //! The averaged power that caused the step, dBFS
+        double power;
+    };
+
+    virtual ~umtrx_rx_gain_events(void) {}
+
+    /*!
+     * Take the oldest gain change not taken yet, of any channel.
+     * Never blocks, the changes of the latest 256 are kept.
+     * \param event filled in
+     * \return false when there is none
+     */
+    virtual bool recv_gain_event(event_type &event) = 0;
+
+    /*!
+     * The gain interface of a streamer.
+     * \param stream an rx streamer sptr of any UHD version
+     * \return the interface, valid with the stream, or NULL for other devices
+     */
+    template <typename stream_sptr_type>
+    static umtrx_rx_gain_events *get(const stream_sptr_type &stream)
+    {
+        return dynamic_cast<umtrx_rx_gain_events *>(stream.get());
+    }
+};
+
+#endif /* INCLUDED_UMTRX_RX_GAIN_EVENTS_HPP */
@@ -0,0 +1,150 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_RX_PACKET_STREAMER_HPP
+#define INCLUDED_UMTRX_RX_PACKET_STREAMER_HPP
+
+#include <uhd/types/metadata.hpp>
+#include <uhd/transport/zero_copy.hpp>
+#include <vector>
+
+//the module is built with hidden symbols, keep the type info shared for dynamic_cast
+#if defined(__GNUC__)
+#define UMTRX_RX_PACKET_STREAMER_API __attribute__((visibility("default")))
+#else
+#define UMTRX_RX_PACKET_STREAMER_API
+#endif
+
+/*!
+ * Zero copy receive: hand out the wire payload of each packet.
+ *
+ * Every UmTRX rx streamer also implements this interface, get() finds it
+ * behind the rx_streamer from multi_usrp. recv_packet() is an alternative
+ * to recv() on the same streamer: it returns one aligned packet per call,
+ * the payload pointers point straight into the transport frames and the
+ * cpu_format of the stream args is not applied.
+ *
+ * The payload is the otw_format in wire order (item32 big endian): for
+ * sc16 that is interleaved I/Q pairs of big endian 16 bit integers. For
+ * bfp8 it is sc8 mantissas, the sample is the mantissa times 2^exponent.
+ *
+ * A frame is released when its buffer reference is dropped, on the next
+ * recv_packet() into the same packet object, or when the packet is
+ * destroyed. Holding too many packets stalls the transport once it runs
+ * out of frames (num_recv_frames).
+ *
+ * recv_many() is the converting counterpart: several packets per call,
+ * converted to the cpu_format of the stream args one after the other into
+ * the same buffers, each with its own metadata.
+ *
+ * Header only so that applications can use it without linking the module.
+ */
+class UMTRX_RX_PACKET_STREAMER_API umtrx_rx_packet_streamer
+{
+public:
+    struct packet_type
+    {
+        packet_type(void): nsamps(0) {}
+
+        //! The frames holding the payloads, one per channel
+        std::vector<uhd::transport::managed_recv_buffer::sptr> buffs;
+
+        /*!
+         * The payload of each channel, nsamps otw items.
+         * A packet made up by the gap_fill stream arg has no frame behind
+         * it: its buffs entry is null and the payload is only valid until
+         * the next receive call.
+         */
+        std::vector<const void *> payloads;
+
+        //! The shared exponent of each channel with otw_format=bfp8, 0 otherwise
+        std::vector<int> exponents;
+
+        //! Number of samples per channel
+        size_t nsamps;
+
+        //! Same as the metadata of recv(), more_fragments is never set
+        uhd::rx_metadata_t metadata;
+
+        //! Drop the frame references
+        void release(void)
+        {
+            buffs.clear();
+            payloads.clear();
+            exponents.clear();
+            nsamps = 0;
+        }
+    };
+
+    //! One packet of a recv_many() batch
+    struct batch_entry_type
+    {
+        batch_entry_type(void): offset(0), nsamps(0) {}
+
+        //! Where the packet starts in the buffers, in samples
+        size_t offset;
+
+        //! Number of samples per channel
+        size_t nsamps;
+
+        //! The metadata of this packet alone, as recv() with one_packet
+        uhd::rx_metadata_t metadata;
+    };
+
+    virtual ~umtrx_rx_packet_streamer(void) {}
+
+    /*!
+     * Receive the next packet of every channel.
+     * The samples a previous recv() has left in a partly consumed packet
+     * are handed out first.
+     * \param packet filled in, the frames it held before are released
+     * \param timeout seconds to wait for a packet
+     * \return the number of samples per channel, 0 with the metadata error on failure
+     */
+    virtual size_t recv_packet(packet_type &packet, const double timeout = 0.1) = 0;
+
+    /*!
+     * Receive up to max_packets packets of every channel, converted.
+     * The batch ends early when the buffers are full, on a fragment, on a
+     * timeout after the first packet, and on an error: the packet with the
+     * error is the last entry, with no samples. A gap fill never shares a
+     * batch with real samples, as with recv().
+     * \param buffs one buffer per channel, nsamps_per_buff samples of the cpu_format
+     * \param nsamps_per_buff capacity of each buffer in samples
+     * \param entries filled in, one per packet in stream order
+     * \param max_packets longest batch
+     * \param timeout seconds to wait for each packet
+     * \return the number of samples per channel in the buffers
+     */
+    virtual size_t recv_many(
+        const std::vector<void *> &buffs, const size_t nsamps_per_buff,
+        std::vector<batch_entry_type> &entries, const size_t max_packets,
+        const double timeout = 0.1) = 0;
+
+    /*!
+     * The packet interface of a streamer.
+     * \param stream an rx streamer sptr of any UHD version
+     * \return the interface, valid with the stream, or NULL for other devices
+     */
+    template <typename stream_sptr_type>
+    static umtrx_rx_packet_streamer *get(const stream_sptr_type &stream)
+    {
+        return dynamic_cast<umtrx_rx_packet_streamer *>(stream.get());
+    }
+};
+
+#endif /* INCLUDED_UMTRX_RX_PACKET_STREAMER_HPP */
@@ -0,0 +1,226 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_RX_RING_HPP
+#define INCLUDED_UMTRX_RX_RING_HPP
+
+#include <uhd/stream.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/types/metadata.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/bind/bind.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+/*!
+ * Always-on RX capture: read samples by absolute time.
+ *
+ * A background thread keeps calling recv() on the streamer and lays the
+ * samples out in a per-channel ring indexed by the sample number of
+ * their timestamp (time * samp_rate). read_at() then hands out a zero
+ * copy view of any span that is still resident, there is no need to
+ * keep any recv() cadence.
+ *
+ * The ring only holds one contiguous run of samples: a timestamp jump
+ * (overflow, dropped packets) starts a new run and drops the old one.
+ * Use the gap_fill stream arg to keep the run going over lost packets.
+ *
+ * Header only so that applications can use it directly with the
+ * streamer from multi_usrp; the streamer must already be set up and
+ * the stream command is issued by the caller as usual.
+ */
+class umtrx_rx_ring : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_rx_ring> sptr;
+
+    //! A resident span of samples, one pointer per channel
+    struct view_type
+    {
+        std::vector<const void *> buffs;
+        size_t nsamps;
+        boost::uint64_t index; //sample number of the first sample
+    };
+
+    enum read_status_type
+    {
+        READ_OK,          //view is set
+        READ_TIMEOUT,     //the span was not fully received within the timeout
+        READ_OVERWRITTEN, //the span is older than the ring or before the current run
+        READ_TOO_LONG     //more samples than max_read_samps
+    };
+
+    /*!
+     * Start draining the streamer into the ring.
+     * \param stream an rx streamer, every channel is captured
+     * \param samp_rate the stream sample rate, maps time to sample numbers
+     * \param bytes_per_item bytes per sample of the stream cpu format
+     * \param capacity_samps ring size per channel, rounded up to a power of two
+     * \param max_read_samps longest span read_at() returns without a wrap
+     */
+    static sptr make(uhd::rx_streamer::sptr stream, const double samp_rate, const size_t bytes_per_item,
+        const size_t capacity_samps, const size_t max_read_samps)
+    {
+        return sptr(new umtrx_rx_ring(stream, samp_rate, bytes_per_item, capacity_samps, max_read_samps));
+    }
+
+    ~umtrx_rx_ring(void)
+    {
+        _thread.interrupt();
+        _thread.join();
+    }
+
+    //! Sample number of a time
+    boost::uint64_t time_to_index(const uhd::time_spec_t &time) const
+    {
+        return boost::uint64_t(time.to_ticks(_samp_rate));
+    }
+
+    /*!
+     * Get a view of nsamps samples starting at time.
+     * Waits up to timeout seconds for samples that have not arrived yet.
+     * The view points into the ring: check still_valid() after using it.
+     */
+    read_status_type read_at(const uhd::time_spec_t &time, const size_t nsamps, view_type &view, const double timeout)
+    {
+        if (nsamps > _max_read) return READ_TOO_LONG;
+        const boost::uint64_t index = this->time_to_index(time);
+        const boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds(long(timeout*1e6));
+
+        boost::mutex::scoped_lock lock(_mutex);
+        while (_write_index < index + nsamps)
+        {
+            if (index < _valid_start) return READ_OVERWRITTEN;
+            if (not _cond.timed_wait(lock, deadline)) return READ_TIMEOUT;
+        }
+        if (index < _valid_start) return READ_OVERWRITTEN;
+
+        const size_t pos = size_t((index - _base_index) & (_capacity - 1));
+        view.buffs.resize(_rings.size());
+        for (size_t ch = 0; ch < _rings.size(); ch++) view.buffs[ch] = &_rings[ch][pos*_bytes_per_item];
+        view.nsamps = nsamps;
+        view.index = index;
+        return READ_OK;
+    }
+
+    //! True when the samples of the view have not been overwritten since read_at()
+    bool still_valid(const view_type &view)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        return view.index >= _valid_start;
+    }
+
+    //! Sample numbers of the resident run [first, last)
+    void get_resident(boost::uint64_t &first, boost::uint64_t &last)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        first = _valid_start;
+        last = _write_index;
+    }
+
+private:
+    umtrx_rx_ring(uhd::rx_streamer::sptr stream, const double samp_rate, const size_t bytes_per_item,
+        const size_t capacity_samps, const size_t max_read_samps):
+        _stream(stream),
+        _samp_rate(samp_rate),
+        _bytes_per_item(bytes_per_item),
+        _capacity(1),
+        _max_read(max_read_samps),
+        _chunk(stream->get_max_num_samps()),
+        _base_index(0),
+        _valid_start(0),
+        _write_index(0)
+    {
+        while (_capacity < capacity_samps) _capacity <<= 1;
+        UHD_ASSERT_THROW(_max_read + _chunk <= _capacity);
+
+        //the mirror of the ring start after the end keeps every read contiguous
+        _rings.resize(_stream->get_num_channels());
+        for (size_t ch = 0; ch < _rings.size(); ch++) _rings[ch].resize((_capacity + _max_read)*_bytes_per_item);
+        _thread = boost::thread(boost::bind(&umtrx_rx_ring::capture_loop, this));
+    }
+
+    void capture_loop(void)
+    {
+        std::vector<void *> buffs(_rings.size());
+        uhd::rx_metadata_t md;
+        size_t pos = 0;
+        while (not boost::this_thread::interruption_requested())
+        {
+            const size_t nsamps = std::min(_chunk, _capacity - pos);
+
+            //retire the samples about to be overwritten before recv() writes
+            {
+                boost::mutex::scoped_lock lock(_mutex);
+                if (_write_index + nsamps > _valid_start + _capacity) _valid_start = _write_index + nsamps - _capacity;
+            }
+            for (size_t ch = 0; ch < _rings.size(); ch++) buffs[ch] = &_rings[ch][pos*_bytes_per_item];
+            const size_t num_rx = _stream->recv(buffs, nsamps, md, 0.1, true);
+            if (num_rx == 0) continue; //timeouts and errors, the timestamps tell about any gap
+
+            //mirror the ring start
+            if (pos < _max_read)
+            {
+                const size_t n = std::min(num_rx, _max_read - pos);
+                for (size_t ch = 0; ch < _rings.size(); ch++)
+                {
+                    std::memcpy(&_rings[ch][(_capacity + pos)*_bytes_per_item], &_rings[ch][pos*_bytes_per_item], n*_bytes_per_item);
+                }
+            }
+
+            {
+                boost::mutex::scoped_lock lock(_mutex);
+                const boost::uint64_t index = md.has_time_spec? this->time_to_index(md.time_spec) : _write_index;
+                if (index != _write_index)
+                {
+                    //a new run: anchor it to where the samples landed
+                    _base_index = index - pos;
+                    _valid_start = index;
+                }
+                _write_index = index + num_rx;
+            }
+            _cond.notify_all();
+            pos = (pos + num_rx) & (_capacity - 1);
+        }
+    }
+
+    uhd::rx_streamer::sptr _stream;
+    const double _samp_rate;
+    const size_t _bytes_per_item;
+    size_t _capacity; //power of two, so sample numbers map with a mask
+    const size_t _max_read;
+    const size_t _chunk;
+    std::vector<std::vector<char> > _rings;
+
+    //sample numbers, guarded by the mutex
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+    boost::uint64_t _base_index; //sample number at ring position 0
+    boost::uint64_t _valid_start; //first resident sample
+    boost::uint64_t _write_index; //one past the last resident sample
+    boost::thread _thread;
+};
+
+#endif /* INCLUDED_UMTRX_RX_RING_HPP */
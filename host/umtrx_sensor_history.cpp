@@ -0,0 +1,147 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_sensor_history.hpp"
+#include <boost/thread/mutex.hpp>
+#include <boost/foreach.hpp>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+using namespace uhd;
+
+//! Numeric value of a sensor, \return false for strings and unparsable values
+static bool sensor_to_double(const sensor_value_t &sensor, double &value)
+{
+    try
+    {
+        switch (sensor.type)
+        {
+        case sensor_value_t::BOOLEAN: value = sensor.to_bool()? 1.0 : 0.0; return true;
+        case sensor_value_t::INTEGER: value = sensor.to_int(); return true;
+        case sensor_value_t::REALNUM: value = sensor.to_real(); return true;
+        default: return false;
+        }
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+class umtrx_sensor_history_impl : public umtrx_sensor_history
+{
+public:
+    umtrx_sensor_history_impl(const size_t raw_depth, const size_t sec_depth, const size_t min_depth):
+        _raw_depth(raw_depth), _sec_depth(sec_depth), _min_depth(min_depth)
+    {
+        return;
+    }
+
+    void record(const double time, const std::map<std::string, sensor_value_t> &sensors)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        typedef std::pair<std::string, sensor_value_t> sensor_pair_t;
+        BOOST_FOREACH(const sensor_pair_t &sensor, sensors)
+        {
+            double value = 0.0;
+            if (not sensor_to_double(sensor.second, value)) continue;
+            history_type &h = _history[sensor.first];
+
+            entry_type raw;
+            raw.time = time;
+            raw.min = raw.mean = raw.max = value;
+            raw.count = 1;
+            push(h.raw, _raw_depth, raw);
+            accumulate(h.sec, h.secs, _sec_depth, std::floor(time), value);
+            accumulate(h.min, h.mins, _min_depth, 60*std::floor(time/60), value);
+        }
+    }
+
+    std::vector<std::string> get_paths(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        std::vector<std::string> paths;
+        typedef std::pair<std::string, history_type> history_pair_t;
+        BOOST_FOREACH(const history_pair_t &h, _history) paths.push_back(h.first);
+        return paths;
+    }
+
+    std::vector<entry_type> get_entries(const std::string &path, const resolution_type resolution, const double since)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        std::vector<entry_type> entries;
+        std::map<std::string, history_type>::const_iterator it = _history.find(path);
+        if (it == _history.end()) return entries;
+
+        const history_type &h = it->second;
+        const std::deque<entry_type> &ring = (resolution == RESOLUTION_RAW)? h.raw :
+            ((resolution == RESOLUTION_SECOND)? h.secs : h.mins);
+        BOOST_FOREACH(const entry_type &entry, ring)
+        {
+            if (entry.time >= since) entries.push_back(entry);
+        }
+        if (resolution == RESOLUTION_SECOND and h.sec.count != 0) entries.push_back(h.sec);
+        if (resolution == RESOLUTION_MINUTE and h.min.count != 0) entries.push_back(h.min);
+        return entries;
+    }
+
+private:
+    struct history_type
+    {
+        history_type(void){sec.count = min.count = 0;}
+        std::deque<entry_type> raw, secs, mins;
+        entry_type sec, min; //intervals in progress
+    };
+
+    static void push(std::deque<entry_type> &ring, const size_t depth, const entry_type &entry)
+    {
+        if (depth == 0) return;
+        if (ring.size() >= depth) ring.pop_front();
+        ring.push_back(entry);
+    }
+
+    //! Add a value to the interval that starts at start, a new interval closes the last one
+    static void accumulate(entry_type &acc, std::deque<entry_type> &ring, const size_t depth, const double start, const double value)
+    {
+        if (acc.count != 0 and acc.time != start)
+        {
+            push(ring, depth, acc);
+            acc.count = 0;
+        }
+        if (acc.count == 0)
+        {
+            acc.time = start;
+            acc.min = acc.mean = acc.max = value;
+            acc.count = 1;
+            return;
+        }
+        acc.count++;
+        acc.min = std::min(acc.min, value);
+        acc.max = std::max(acc.max, value);
+        acc.mean += (value - acc.mean)/acc.count;
+    }
+
+    const size_t _raw_depth, _sec_depth, _min_depth;
+    boost::mutex _mutex;
+    std::map<std::string, history_type> _history; //keyed by property path
+};
+
+umtrx_sensor_history::sptr umtrx_sensor_history::make(const size_t raw_depth, const size_t sec_depth, const size_t min_depth)
+{
+    return sptr(new umtrx_sensor_history_impl(raw_depth, sec_depth, min_depth));
+}
@@ -0,0 +1,79 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_SENSOR_HISTORY_HPP
+#define INCLUDED_UMTRX_SENSOR_HISTORY_HPP
+
+#include <uhd/types/sensors.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+/*!
+ * History of the sampled sensors.
+ *
+ * The status monitor records every sample of the sensor cache. Each numeric
+ * sensor keeps three fixed size rings: the raw samples, and min, mean and
+ * max over each second and over each minute. A collector fetches a whole
+ * window in one request instead of polling the sensors, the history costs
+ * no bus traffic of its own.
+ */
+class umtrx_sensor_history : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_sensor_history> sptr;
+
+    enum resolution_type
+    {
+        RESOLUTION_RAW,
+        RESOLUTION_SECOND,
+        RESOLUTION_MINUTE
+    };
+
+    //! One entry of a ring, a raw sample has min = mean = max and count 1
+    struct entry_type
+    {
+        double time; //seconds since the epoch, of the sample or the start of the interval
+        double min, mean, max;
+        size_t count;
+    };
+
+    //! Rings of raw_depth samples, sec_depth seconds and min_depth minutes per sensor
+    static sptr make(const size_t raw_depth, const size_t sec_depth, const size_t min_depth);
+
+    /*!
+     * Add one sample of the sensors.
+     * Booleans count as 0 and 1, string sensors are skipped.
+     * \param time seconds since the epoch, increasing
+     * \param sensors values keyed by property path
+     */
+    virtual void record(const double time, const std::map<std::string, uhd::sensor_value_t> &sensors) = 0;
+
+    //! The property paths with a history
+    virtual std::vector<std::string> get_paths(void) = 0;
+
+    /*!
+     * The entries since a time, oldest first.
+     * The interval in progress comes last, with the samples so far.
+     * \return empty for a path without a history
+     */
+    virtual std::vector<entry_type> get_entries(const std::string &path, const resolution_type resolution, const double since) = 0;
+};
+
+#endif /* INCLUDED_UMTRX_SENSOR_HISTORY_HPP */
@@ -0,0 +1,528 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_SHM_RING_HPP
+#define INCLUDED_UMTRX_SHM_RING_HPP
+
+#include <uhd/exception.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/types/metadata.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <complex>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <unistd.h>
+
+/*!
+ * The streams of one device in shared memory, for several processes.
+ *
+ * umtrx_streamd owns the device and writes every RX channel into a ring
+ * laid out like umtrx_rx_ring: indexed by the sample number of the VITA
+ * timestamp (time * rate), with a mirror of the ring start after the end
+ * so every read is contiguous. Any number of clients attach and read on
+ * their own, zero copy: read_at() hands out pointers into the shared
+ * memory and still_valid() tells whether the daemon overwrote them since.
+ * The daemon never waits for a client, the clients poll for new samples.
+ *
+ * One client at a time owns TX: claim_tx() then send(). The bursts go
+ * through a ring of their own that the daemon drains into its streamer.
+ *
+ * The samples are sc16. The layout is in host byte order, for processes
+ * on one machine built with the same version of this header.
+ */
+class umtrx_shm_ring : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_shm_ring> sptr;
+    typedef std::complex<boost::int16_t> item_type;
+
+    //! A resident span of samples, one pointer per RX channel
+    struct view_type
+    {
+        std::vector<const item_type *> buffs;
+        size_t nsamps;
+        boost::uint64_t index; //sample number of the first sample
+        boost::uint64_t run; //base of the run it was read from
+    };
+
+    enum read_status_type
+    {
+        READ_OK,          //view is set
+        READ_TIMEOUT,     //the span was not fully received within the timeout
+        READ_OVERWRITTEN, //the span is older than the ring or before the current run
+        READ_TOO_LONG     //more samples than get_max_read()
+    };
+
+    /*!
+     * Make the segment, for the daemon. A stale one of the same name is replaced.
+     * \param name the shared memory object name
+     * \param num_rx RX channels
+     * \param num_tx TX channels, zero without TX
+     * \param rx_rate RX sample rate, maps time to sample numbers
+     * \param tx_rate TX sample rate
+     * \param capacity_samps RX ring per channel, rounded up to a power of two
+     * \param max_read_samps longest span read_at() returns, at least one recv() of the daemon
+     * \param tx_capacity_samps TX ring per channel, rounded up to a power of two
+     */
+    static sptr create(const std::string &name, const size_t num_rx, const size_t num_tx,
+        const double rx_rate, const double tx_rate,
+        const size_t capacity_samps, const size_t max_read_samps, const size_t tx_capacity_samps)
+    {
+        sptr ring(new umtrx_shm_ring(name));
+        ring->init(num_rx, num_tx, rx_rate, tx_rate, capacity_samps, max_read_samps, tx_capacity_samps);
+        return ring;
+    }
+
+    //! Attach to the segment of a running daemon, for a client
+    static sptr attach(const std::string &name)
+    {
+        sptr ring(new umtrx_shm_ring(name, true));
+        return ring;
+    }
+
+    ~umtrx_shm_ring(void)
+    {
+        this->release_tx();
+        if (_owner) boost::interprocess::shared_memory_object::remove(_name.c_str());
+    }
+
+    size_t get_num_rx_channels(void) const {return _hdr->num_rx;}
+    size_t get_num_tx_channels(void) const {return _hdr->num_tx;}
+    double get_rx_rate(void) const {return _hdr->rx_rate;}
+    double get_tx_rate(void) const {return _hdr->tx_rate;}
+    size_t get_max_read(void) const {return size_t(_hdr->max_read);}
+    size_t get_capacity(void) const {return size_t(_hdr->capacity);}
+
+    //! Times the daemon saw the RX samples jump, overflows and lost packets
+    boost::uint64_t get_num_overflows(void) const
+    {
+        return _hdr->overflows.load(boost::memory_order_relaxed);
+    }
+
+    //! Sample number of a time
+    boost::uint64_t time_to_index(const uhd::time_spec_t &time) const
+    {
+        return boost::uint64_t(time.to_ticks(_hdr->rx_rate));
+    }
+
+    //! Time of a sample number
+    uhd::time_spec_t index_to_time(const boost::uint64_t index) const
+    {
+        return uhd::time_spec_t::from_ticks((long long)(index), _hdr->rx_rate);
+    }
+
+    /*!
+     * Get a view of nsamps samples starting at time.
+     * Waits up to timeout seconds for samples that have not arrived yet.
+     * The view points into the ring: check still_valid() after using it.
+     */
+    read_status_type read_at(const uhd::time_spec_t &time, const size_t nsamps, view_type &view, const double timeout)
+    {
+        return this->read_at_index(this->time_to_index(time), nsamps, view, timeout);
+    }
+
+    //! read_at() by sample number, for readers that follow the stream
+    read_status_type read_at_index(const boost::uint64_t index, const size_t nsamps, view_type &view, const double timeout)
+    {
+        if (nsamps > _hdr->max_read) return READ_TOO_LONG;
+        const boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds(long(timeout*1e6));
+
+        boost::uint64_t base, start, end;
+        while (true)
+        {
+            this->load_run(base, start, end);
+            if (index < start) return READ_OVERWRITTEN;
+            if (end >= index + nsamps) break;
+            if (boost::get_system_time() > deadline) return READ_TIMEOUT;
+            boost::this_thread::sleep(boost::posix_time::microseconds(long(POLL_US)));
+        }
+
+        const size_t pos = size_t((index - base) & (_hdr->capacity - 1));
+        view.buffs.resize(_hdr->num_rx);
+        for (size_t ch = 0; ch < view.buffs.size(); ch++) view.buffs[ch] = this->rx_ring(ch) + pos;
+        view.nsamps = nsamps;
+        view.index = index;
+        view.run = base;
+        return READ_OK;
+    }
+
+    //! True when the samples of the view have not been overwritten since read_at()
+    bool still_valid(const view_type &view) const
+    {
+        boost::uint64_t base, start, end;
+        this->load_run(base, start, end);
+        return base == view.run and view.index >= start;
+    }
+
+    //! Sample numbers of the resident run [first, last)
+    void get_resident(boost::uint64_t &first, boost::uint64_t &last) const
+    {
+        boost::uint64_t base;
+        this->load_run(base, first, last);
+    }
+
+    /*******************************************************************
+     * RX writer, the daemon only
+     ******************************************************************/
+    //! RX ring start of a channel, the daemon recv()s into it
+    item_type *rx_ring(const size_t ch)
+    {
+        return reinterpret_cast<item_type *>(_mem + _hdr->rx_offset) + ch*(_hdr->capacity + _hdr->max_read);
+    }
+
+    //! Retire the samples that nsamps more at the write position overwrite, before writing them
+    void retire(const size_t nsamps)
+    {
+        const boost::uint64_t end = _hdr->write_index.load(boost::memory_order_relaxed);
+        const boost::uint64_t start = _hdr->valid_start.load(boost::memory_order_relaxed);
+        if (end + nsamps <= start + _hdr->capacity) return;
+        this->store_run(_hdr->base_index.load(boost::memory_order_relaxed), end + nsamps - _hdr->capacity, end);
+    }
+
+    /*!
+     * Publish num_rx samples that landed at ring position pos.
+     * \param index sample number of the first, from its time
+     */
+    void commit(const size_t pos, const boost::uint64_t index, const size_t num_rx)
+    {
+        //mirror the ring start
+        if (pos < _hdr->max_read)
+        {
+            const size_t n = std::min<size_t>(num_rx, size_t(_hdr->max_read - pos));
+            for (size_t ch = 0; ch < _hdr->num_rx; ch++)
+            {
+                std::memcpy(this->rx_ring(ch) + _hdr->capacity + pos, this->rx_ring(ch) + pos, n*sizeof(item_type));
+            }
+        }
+
+        const boost::uint64_t end = _hdr->write_index.load(boost::memory_order_relaxed);
+        if (index != end)
+        {
+            //a new run: anchor it to where the samples landed
+            if (end != 0) _hdr->overflows.fetch_add(1, boost::memory_order_relaxed);
+            this->store_run(index - pos, index, index + num_rx);
+        }
+        else this->store_run(_hdr->base_index.load(boost::memory_order_relaxed),
+            _hdr->valid_start.load(boost::memory_order_relaxed), index + num_rx);
+    }
+
+    /*******************************************************************
+     * TX, one client claims it
+     ******************************************************************/
+    //! Take TX for this process, false while another live process has it
+    bool claim_tx(void)
+    {
+        if (_hdr->num_tx == 0) return false;
+        const boost::int32_t self = boost::int32_t(::getpid());
+        boost::int32_t owner = _hdr->tx_owner.load();
+        while (true)
+        {
+            if (owner == self) return true;
+            if (owner != 0 and (::kill(owner, 0) == 0 or errno != ESRCH)) return false;
+            //free, or its owner exited without letting go
+            if (_hdr->tx_owner.compare_exchange_strong(owner, self)) return true;
+        }
+    }
+
+    //! Give TX back, a no-op unless this process has it
+    void release_tx(void)
+    {
+        boost::int32_t self = boost::int32_t(::getpid());
+        if (_hdr != NULL and _hdr->num_tx != 0) _hdr->tx_owner.compare_exchange_strong(self, 0);
+    }
+
+    /*!
+     * Queue a burst, or a part of one, for the daemon to send.
+     * Waits up to timeout seconds for room in the TX ring.
+     * \return the samples queued, fewer only on a timeout
+     */
+    size_t send(const std::vector<const void *> &buffs, const size_t nsamps, const uhd::tx_metadata_t &md, const double timeout)
+    {
+        if (_hdr->tx_owner.load() != boost::int32_t(::getpid())) throw uhd::runtime_error("umtrx_shm_ring: send() without claim_tx()");
+        if (buffs.size() != _hdr->num_tx) throw uhd::value_error("umtrx_shm_ring: send() needs one buffer per TX channel");
+        const boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds(long(timeout*1e6));
+        const size_t max_piece = size_t(_hdr->tx_capacity/2);
+
+        size_t done = 0;
+        do
+        {
+            const size_t n = std::min(nsamps - done, max_piece);
+            const boost::uint64_t head = _hdr->tx_head.load(boost::memory_order_relaxed);
+            const boost::uint64_t samps_head = _hdr->tx_samps_head.load(boost::memory_order_relaxed);
+            while (head - _hdr->tx_tail.load() >= _hdr->tx_slots or
+                samps_head + n - _hdr->tx_samps_tail.load() > _hdr->tx_capacity)
+            {
+                if (boost::get_system_time() > deadline) return done;
+                boost::this_thread::sleep(boost::posix_time::microseconds(long(POLL_US)));
+            }
+
+            for (size_t ch = 0; ch < buffs.size(); ch++)
+            {
+                const item_type *in = reinterpret_cast<const item_type *>(buffs[ch]) + done;
+                const size_t pos = size_t(samps_head & (_hdr->tx_capacity - 1));
+                const size_t n0 = std::min<size_t>(n, size_t(_hdr->tx_capacity - pos));
+                std::memcpy(this->tx_ring(ch) + pos, in, n0*sizeof(item_type));
+                std::memcpy(this->tx_ring(ch), in + n0, (n - n0)*sizeof(item_type));
+            }
+
+            //the time and start only on the first piece, the end only on the last
+            burst_type &b = this->tx_burst(head);
+            b.nsamps = n;
+            b.first = samps_head;
+            b.full_secs = md.time_spec.get_full_secs();
+            b.frac_secs = md.time_spec.get_frac_secs();
+            b.flags = 0;
+            if (done == 0 and md.has_time_spec) b.flags |= TX_HAS_TIME;
+            if (done == 0 and md.start_of_burst) b.flags |= TX_SOB;
+            if (done + n == nsamps and md.end_of_burst) b.flags |= TX_EOB;
+            _hdr->tx_samps_head.store(samps_head + n, boost::memory_order_relaxed);
+            _hdr->tx_head.store(head + 1, boost::memory_order_release);
+            done += n;
+        }
+        while (done < nsamps);
+        return done;
+    }
+
+    /*!
+     * The next contiguous piece of the queued bursts, for the daemon.
+     * Call tx_done() once it is sent.
+     * \return the samples in buffs, zero when the ring is empty
+     */
+    size_t pop_tx(std::vector<const void *> &buffs, uhd::tx_metadata_t &md)
+    {
+        const boost::uint64_t tail = _hdr->tx_tail.load(boost::memory_order_relaxed);
+        if (tail == _hdr->tx_head.load(boost::memory_order_acquire)) return 0;
+        const burst_type &b = this->tx_burst(tail);
+
+        const boost::uint64_t first = b.first + _tx_sent;
+        const size_t pos = size_t(first & (_hdr->tx_capacity - 1));
+        const size_t n = std::min<size_t>(size_t(b.nsamps - _tx_sent), size_t(_hdr->tx_capacity - pos));
+        buffs.resize(_hdr->num_tx);
+        for (size_t ch = 0; ch < buffs.size(); ch++) buffs[ch] = this->tx_ring(ch) + pos;
+        md = uhd::tx_metadata_t();
+        md.has_time_spec = _tx_sent == 0 and (b.flags & TX_HAS_TIME) != 0;
+        md.time_spec = uhd::time_spec_t(time_t(b.full_secs), b.frac_secs);
+        md.start_of_burst = _tx_sent == 0 and (b.flags & TX_SOB) != 0;
+        md.end_of_burst = _tx_sent + n == b.nsamps and (b.flags & TX_EOB) != 0;
+        _tx_piece = n;
+        return n;
+    }
+
+    //! The piece of pop_tx() is sent, its room goes back to the client
+    void tx_done(void)
+    {
+        const boost::uint64_t tail = _hdr->tx_tail.load(boost::memory_order_relaxed);
+        _tx_sent += _tx_piece;
+        _hdr->tx_samps_tail.fetch_add(_tx_piece, boost::memory_order_release);
+        _tx_piece = 0;
+        if (_tx_sent < this->tx_burst(tail).nsamps) return;
+        _tx_sent = 0;
+        _hdr->tx_tail.store(tail + 1, boost::memory_order_release);
+    }
+
+private:
+    enum {VERSION = 1, POLL_US = 200};
+    enum {TX_HAS_TIME = 1 << 0, TX_SOB = 1 << 1, TX_EOB = 1 << 2};
+
+    struct burst_type
+    {
+        boost::uint64_t nsamps;
+        boost::uint64_t first; //TX sample counter of the first sample
+        boost::int64_t full_secs;
+        double frac_secs;
+        boost::uint32_t flags;
+    };
+
+    struct header_type
+    {
+        char magic[8]; //set last, the segment is ready then
+        boost::uint32_t version;
+        boost::uint32_t num_rx, num_tx, tx_slots;
+        boost::uint64_t capacity, max_read, tx_capacity;
+        double rx_rate, tx_rate;
+        boost::uint64_t rx_offset, tx_burst_offset, tx_offset, total_bytes; //from the start of the segment
+
+        //RX run, seqlocked: odd while the daemon changes it
+        boost::atomic<boost::uint64_t> seq;
+        boost::atomic<boost::uint64_t> base_index; //sample number at ring position 0
+        boost::atomic<boost::uint64_t> valid_start; //first resident sample
+        boost::atomic<boost::uint64_t> write_index; //one past the last resident sample
+        boost::atomic<boost::uint64_t> overflows;
+
+        //TX, the owner pushes and the daemon pops
+        boost::atomic<boost::int32_t> tx_owner; //pid, zero when free
+        boost::atomic<boost::uint64_t> tx_head, tx_tail; //bursts
+        boost::atomic<boost::uint64_t> tx_samps_head, tx_samps_tail; //samples per channel
+    };
+
+    static const char *magic(void) {return "UMTRXSHM";}
+
+    static size_t align(const size_t n)
+    {
+        return (n + 63) & ~size_t(63);
+    }
+
+    //! daemon side, init() lays out the segment
+    umtrx_shm_ring(const std::string &name):
+        _name(name), _owner(true), _mem(NULL), _hdr(NULL), _tx_sent(0), _tx_piece(0)
+    {}
+
+    //! client side
+    umtrx_shm_ring(const std::string &name, const bool):
+        _name(name), _owner(false), _mem(NULL), _hdr(NULL), _tx_sent(0), _tx_piece(0)
+    {
+        namespace ipc = boost::interprocess;
+        try
+        {
+            ipc::shared_memory_object shm(ipc::open_only, name.c_str(), ipc::read_write);
+            _region.reset(new ipc::mapped_region(shm, ipc::read_write));
+        }
+        catch (const ipc::interprocess_exception &ex)
+        {
+            throw uhd::runtime_error("umtrx_shm_ring: no stream daemon at " + name + ": " + ex.what());
+        }
+        _mem = static_cast<char *>(_region->get_address());
+        _hdr = reinterpret_cast<header_type *>(_mem);
+        if (_region->get_size() < sizeof(header_type) or std::memcmp(_hdr->magic, magic(), 8) != 0)
+        {
+            _hdr = NULL;
+            throw uhd::runtime_error("umtrx_shm_ring: " + name + " is not ready or not a stream daemon segment");
+        }
+        if (_hdr->version != VERSION or _hdr->total_bytes > _region->get_size())
+        {
+            _hdr = NULL;
+            throw uhd::runtime_error(str(boost::format("umtrx_shm_ring: %s has layout version %u, expected %u")
+                % name % _hdr->version % unsigned(VERSION)));
+        }
+    }
+
+    void init(const size_t num_rx, const size_t num_tx, const double rx_rate, const double tx_rate,
+        const size_t capacity_samps, const size_t max_read_samps, const size_t tx_capacity_samps)
+    {
+        namespace ipc = boost::interprocess;
+        boost::uint64_t capacity = 1, tx_capacity = 1;
+        while (capacity < capacity_samps) capacity <<= 1;
+        while (tx_capacity < tx_capacity_samps) tx_capacity <<= 1;
+        UHD_ASSERT_THROW(max_read_samps <= capacity/2);
+        static const size_t tx_slots = 64;
+
+        //the counters are shared between processes, only lock-free atomics work there
+        boost::atomic<boost::uint64_t> probe(0);
+        if (not probe.is_lock_free()) throw uhd::runtime_error("umtrx_shm_ring: 64 bit atomics are not lock-free here");
+
+        const size_t rx_offset = align(sizeof(header_type));
+        const size_t tx_burst_offset = align(rx_offset + num_rx*size_t(capacity + max_read_samps)*sizeof(item_type));
+        const size_t tx_offset = align(tx_burst_offset + tx_slots*sizeof(burst_type));
+        const size_t total_bytes = tx_offset + num_tx*size_t(tx_capacity)*sizeof(item_type);
+
+        ipc::shared_memory_object::remove(_name.c_str());
+        ipc::shared_memory_object shm(ipc::create_only, _name.c_str(), ipc::read_write);
+        shm.truncate(ipc::offset_t(total_bytes));
+        _region.reset(new ipc::mapped_region(shm, ipc::read_write));
+        _mem = static_cast<char *>(_region->get_address());
+
+        _hdr = new (_mem) header_type();
+        _hdr->version = VERSION;
+        _hdr->num_rx = boost::uint32_t(num_rx);
+        _hdr->num_tx = boost::uint32_t(num_tx);
+        _hdr->tx_slots = tx_slots;
+        _hdr->capacity = capacity;
+        _hdr->max_read = max_read_samps;
+        _hdr->tx_capacity = tx_capacity;
+        _hdr->rx_rate = rx_rate;
+        _hdr->tx_rate = tx_rate;
+        _hdr->rx_offset = rx_offset;
+        _hdr->tx_burst_offset = tx_burst_offset;
+        _hdr->tx_offset = tx_offset;
+        _hdr->total_bytes = total_bytes;
+        _hdr->seq.store(0);
+        _hdr->base_index.store(0);
+        _hdr->valid_start.store(0);
+        _hdr->write_index.store(0);
+        _hdr->overflows.store(0);
+        _hdr->tx_owner.store(0);
+        _hdr->tx_head.store(0);
+        _hdr->tx_tail.store(0);
+        _hdr->tx_samps_head.store(0);
+        _hdr->tx_samps_tail.store(0);
+        boost::atomic_thread_fence(boost::memory_order_release);
+        std::memcpy(_hdr->magic, magic(), 8);
+    }
+
+    void load_run(boost::uint64_t &base, boost::uint64_t &start, boost::uint64_t &end) const
+    {
+        while (true)
+        {
+            const boost::uint64_t seq = _hdr->seq.load(boost::memory_order_acquire);
+            if ((seq & 1) != 0) continue; //the daemon is in the middle of an update
+            base = _hdr->base_index.load(boost::memory_order_relaxed);
+            start = _hdr->valid_start.load(boost::memory_order_relaxed);
+            end = _hdr->write_index.load(boost::memory_order_relaxed);
+            boost::atomic_thread_fence(boost::memory_order_acquire);
+            if (_hdr->seq.load(boost::memory_order_relaxed) == seq) return;
+        }
+    }
+
+    void store_run(const boost::uint64_t base, const boost::uint64_t start, const boost::uint64_t end)
+    {
+        const boost::uint64_t seq = _hdr->seq.load(boost::memory_order_relaxed);
+        _hdr->seq.store(seq + 1, boost::memory_order_relaxed);
+        boost::atomic_thread_fence(boost::memory_order_release);
+        _hdr->base_index.store(base, boost::memory_order_relaxed);
+        _hdr->valid_start.store(start, boost::memory_order_relaxed);
+        _hdr->write_index.store(end, boost::memory_order_relaxed);
+        _hdr->seq.store(seq + 2, boost::memory_order_release);
+    }
+
+    const item_type *rx_ring(const size_t ch) const
+    {
+        return reinterpret_cast<const item_type *>(_mem + _hdr->rx_offset) + ch*(_hdr->capacity + _hdr->max_read);
+    }
+
+    item_type *tx_ring(const size_t ch)
+    {
+        return reinterpret_cast<item_type *>(_mem + _hdr->tx_offset) + ch*_hdr->tx_capacity;
+    }
+
+    burst_type &tx_burst(const boost::uint64_t n)
+    {
+        return reinterpret_cast<burst_type *>(_mem + _hdr->tx_burst_offset)[n % _hdr->tx_slots];
+    }
+
+    const std::string _name;
+    const bool _owner; //the daemon, removes the name when done
+    boost::shared_ptr<boost::interprocess::mapped_region> _region;
+    char *_mem;
+    header_type *_hdr;
+    boost::uint64_t _tx_sent; //daemon, samples of the current burst sent
+    size_t _tx_piece; //daemon, samples of the last pop_tx()
+};
+
+#endif /* INCLUDED_UMTRX_SHM_RING_HPP */
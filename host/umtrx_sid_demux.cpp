@@ -0,0 +1,116 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_sid_demux.hpp"
+#include <uhd/config.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
+#include <deque>
+
+using namespace uhd;
+using namespace uhd::transport;
+
+class umtrx_sid_demux_impl : public umtrx_sid_demux
+{
+public:
+    umtrx_sid_demux_impl(zero_copy_if::sptr xport, const std::vector<boost::uint32_t> &sids, const bool le):
+        _xport(xport),
+        _le(le),
+        _sids(sids),
+        _queues(sids.size()),
+        //leave every SID a fair share of the transport frames
+        _max_depth(std::max<size_t>(1, xport->get_num_recv_frames()/std::max<size_t>(1, sids.size())))
+    {
+        UHD_ASSERT_THROW(not sids.empty());
+    }
+
+    managed_recv_buffer::sptr get_recv_buff(const boost::uint32_t sid, const double timeout)
+    {
+        const size_t index = this->sid_to_index(sid);
+        UHD_ASSERT_THROW(index < _queues.size());
+        if (not _queues[index].empty()) return this->pop(index);
+
+        const boost::posix_time::ptime exit_time = boost::posix_time::microsec_clock::universal_time() +
+            boost::posix_time::microseconds(long(timeout*1e6));
+        double remaining = timeout;
+        while (true)
+        {
+            managed_recv_buffer::sptr buff = _xport->get_recv_buff(remaining);
+            if (not buff) return buff; //timeout
+
+            const size_t which = this->sid_to_index(this->extract_sid(buff));
+            if (which == index) return buff;
+            if (which < _queues.size())
+            {
+                //drop the oldest frame for a lagging SID rather than starving the transport
+                if (_queues[which].size() >= _max_depth) _queues[which].pop_front();
+                _queues[which].push_back(buff);
+            }
+            remaining = std::max(0.0, (exit_time - boost::posix_time::microsec_clock::universal_time()).total_microseconds()/1e6);
+        }
+    }
+
+    zero_copy_if::sptr get_xport(void)
+    {
+        return _xport;
+    }
+
+private:
+    UHD_INLINE size_t sid_to_index(const boost::uint32_t sid) const
+    {
+        for (size_t i = 0; i < _sids.size(); i++)
+        {
+            if (_sids[i] == sid) return i;
+        }
+        return _sids.size();
+    }
+
+    //! Read the SID from a VRT header, ~0 for packets without a stream ID
+    UHD_INLINE boost::uint32_t extract_sid(const managed_recv_buffer::sptr &buff) const
+    {
+        if (buff->size() < 2*sizeof(boost::uint32_t)) return ~0;
+        const boost::uint32_t *vrt_hdr = buff->cast<const boost::uint32_t *>();
+        const boost::uint32_t pkt_type = this->to_host(vrt_hdr[0]) >> 28;
+        const bool has_sid = (pkt_type & 0x1) != 0 or (pkt_type & 0x4) != 0;
+        return has_sid? this->to_host(vrt_hdr[1]) : ~0;
+    }
+
+    UHD_INLINE boost::uint32_t to_host(const boost::uint32_t word) const
+    {
+        return _le? uhd::wtohx(word) : uhd::ntohx(word);
+    }
+
+    UHD_INLINE managed_recv_buffer::sptr pop(const size_t index)
+    {
+        managed_recv_buffer::sptr buff = _queues[index].front();
+        _queues[index].pop_front();
+        return buff;
+    }
+
+    zero_copy_if::sptr _xport;
+    const bool _le;
+    const std::vector<boost::uint32_t> _sids;
+    std::vector<std::deque<managed_recv_buffer::sptr> > _queues;
+    const size_t _max_depth;
+};
+
+umtrx_sid_demux::sptr umtrx_sid_demux::make(zero_copy_if::sptr xport, const std::vector<boost::uint32_t> &sids, const bool le)
+{
+    return sptr(new umtrx_sid_demux_impl(xport, sids, le));
+}
@@ -0,0 +1,50 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_SID_DEMUX_HPP
+#define INCLUDED_UMTRX_SID_DEMUX_HPP
+
+#include <uhd/transport/zero_copy.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <vector>
+
+/*!
+ * Demultiplex VRT packets from one shared transport by stream ID.
+ * Packets for other registered SIDs are parked in per-SID queues,
+ * packets with an unknown SID are dropped.
+ *
+ * There is no locking: all get_recv_buff() calls must come from one
+ * thread, which is how the recv packet handler calls its channels.
+ */
+class umtrx_sid_demux : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_sid_demux> sptr;
+
+    //! Make a new demux for the given transport and stream IDs, le for little-endian framing
+    static sptr make(uhd::transport::zero_copy_if::sptr xport, const std::vector<boost::uint32_t> &sids, const bool le = false);
+
+    //! Get the next buffer for this SID, or null on timeout
+    virtual uhd::transport::managed_recv_buffer::sptr get_recv_buff(const boost::uint32_t sid, const double timeout) = 0;
+
+    //! Get the underlying shared transport
+    virtual uhd::transport::zero_copy_if::sptr get_xport(void) = 0;
+};
+
+#endif /* INCLUDED_UMTRX_SID_DEMUX_HPP */
@@ -0,0 +1,274 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_impl.hpp"
+#include "umtrx_log_adapter.hpp"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <complex>
+#include <fstream>
+#include <sstream>
+
+using namespace uhd;
+using namespace uhd::usrp;
+
+/*!
+ * Device configuration snapshot.
+ *
+ * save_state() writes what a restarted process would otherwise set up or
+ * learn again, restore_state() puts it back:
+ *  - per LMS: the register shadow, the auto-calibration codes and the
+ *    VCOCAP windows of the tunes made so far
+ *  - the frontend and DSP settings of the property tree: LO and DSP
+ *    frequencies, rates, gains, antennas, bandwidths and corrections
+ *  - the PA enables, Vin bypass and DCDC resistor, the TCXO DAC
+ * The LMS registers go out as one SPI burst and the tree is set inside
+ * one FIFO batch. The tree setters write the FPGA settings registers the
+ * same way a fresh setup does; a raw replay of them would also fire the
+ * strobes among them, ex: stream commands and time loads.
+ * With state_file=<path> the state is restored at open when the file
+ * exists, and saved at close.
+ *
+ * The file is text, one item per line:
+ *   umtrx_state 1
+ *   lms <side> reg <addr> <value>
+ *   lms <side> cal <code>...
+ *   lms <side> vcocap <key> <start> <stop>
+ *   node <type> <path> <value>
+ *   pa <en1> <en2> <nlow> <dcdc_r>
+ *   tcxo_dac <value>
+ */
+
+static const std::string STATE_MAGIC = "umtrx_state 1";
+
+//! Tree nodes of the state, in the order they are restored
+static std::vector<std::pair<char, fs_path> > state_nodes(property_tree::sptr tree, const fs_path &mb_path)
+{
+    std::vector<std::pair<char, fs_path> > nodes;
+    const char *dirs[2] = {"rx_dsps", "tx_dsps"};
+    for (size_t d = 0; d < 2; d++)
+    {
+        BOOST_FOREACH(const std::string &name, tree->list(mb_path / dirs[d]))
+        {
+            nodes.push_back(std::make_pair('d', mb_path / dirs[d] / name / "rate" / "value"));
+            nodes.push_back(std::make_pair('d', mb_path / dirs[d] / name / "freq" / "value"));
+        }
+    }
+    for (char side = 'A'; side <= 'B'; side++)
+    {
+        const std::string fe_name(1, side);
+        const fs_path fe_paths[2] = {
+            mb_path / "dboards" / fe_name / "rx_frontends" / "0",
+            mb_path / "dboards" / fe_name / "tx_frontends" / "0"};
+        for (size_t i = 0; i < 2; i++)
+        {
+            nodes.push_back(std::make_pair('d', fe_paths[i] / "freq" / "value"));
+            nodes.push_back(std::make_pair('s', fe_paths[i] / "antenna" / "value"));
+            nodes.push_back(std::make_pair('d', fe_paths[i] / "bandwidth" / "value"));
+            BOOST_FOREACH(const std::string &name, tree->list(fe_paths[i] / "gains"))
+            {
+                nodes.push_back(std::make_pair('d', fe_paths[i] / "gains" / name / "value"));
+            }
+        }
+        //after the LO, a tune applies the planned corrections
+        nodes.push_back(std::make_pair('b', mb_path / "rx_frontends" / fe_name / "dc_offset" / "enable"));
+        nodes.push_back(std::make_pair('c', mb_path / "rx_frontends" / fe_name / "dc_offset" / "value"));
+        nodes.push_back(std::make_pair('c', mb_path / "rx_frontends" / fe_name / "iq_balance" / "value"));
+        nodes.push_back(std::make_pair('c', mb_path / "tx_frontends" / fe_name / "dc_offset" / "value"));
+        nodes.push_back(std::make_pair('c', mb_path / "tx_frontends" / fe_name / "iq_balance" / "value"));
+    }
+    return nodes;
+}
+
+//! The value of a node as text, empty when it has none
+static std::string get_node(property_tree::sptr tree, const char type, const fs_path &path)
+{
+    if (not tree->exists(path)) return "";
+    try
+    {
+        std::ostringstream out;
+        out.precision(17);
+        switch (type)
+        {
+        case 'd': out << tree->access<double>(path).get(); break;
+        case 'b': out << int(tree->access<bool>(path).get()); break;
+        case 's': out << tree->access<std::string>(path).get(); break;
+        case 'c':
+        {
+            const std::complex<double> v = tree->access<std::complex<double> >(path).get();
+            out << v.real() << " " << v.imag();
+            break;
+        }
+        default: return "";
+        }
+        return out.str();
+    }
+    catch (const std::exception &)
+    {
+        return ""; //never set
+    }
+}
+
+static void set_node(property_tree::sptr tree, const char type, const fs_path &path, const std::string &value)
+{
+    std::istringstream in(value);
+    switch (type)
+    {
+    case 'd': { double v = 0; in >> v; tree->access<double>(path).set(v); break; }
+    case 'b': { int v = 0; in >> v; tree->access<bool>(path).set(v != 0); break; }
+    case 's': tree->access<std::string>(path).set(value); break;
+    case 'c': { double re = 0, im = 0; in >> re >> im; tree->access<std::complex<double> >(path).set(std::complex<double>(re, im)); break; }
+    default: throw uhd::value_error(str(boost::format("umtrx state: unknown node type %c") % type));
+    }
+}
+
+void umtrx_impl::save_state(const std::string &path)
+{
+    const fs_path mb_path = "/mboards/0";
+    std::ostringstream out;
+    out << STATE_MAGIC << std::endl;
+
+    BOOST_FOREACH(const std::string &side, _lms_ctrl.keys())
+    {
+        const lms6002d_ctrl::state_t state = _lms_ctrl[side]->get_state();
+        for (std::map<uint8_t, uint8_t>::const_iterator it = state.regs.begin(); it != state.regs.end(); ++it)
+        {
+            out << boost::format("lms %s reg 0x%02x 0x%02x") % side % int(it->first) % int(it->second) << std::endl;
+        }
+        out << "lms " << side << " cal";
+        BOOST_FOREACH(const int code, state.calibration) out << " " << code;
+        out << std::endl;
+        for (std::map<boost::uint32_t, std::pair<int, int> >::const_iterator it = state.vcocap.begin(); it != state.vcocap.end(); ++it)
+        {
+            out << "lms " << side << " vcocap " << it->first << " " << it->second.first << " " << it->second.second << std::endl;
+        }
+    }
+
+    typedef std::pair<char, fs_path> node_t;
+    BOOST_FOREACH(const node_t &node, state_nodes(_tree, mb_path))
+    {
+        const std::string value = get_node(_tree, node.first, node.second);
+        if (not value.empty()) out << "node " << node.first << " " << std::string(node.second) << " " << value << std::endl;
+    }
+
+    {
+        boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+        out << "pa " << int(_pa_en1) << " " << int(_pa_en2) << " " << int(_pa_nlow) << " " << int(_pa_dcdc_r) << std::endl;
+    }
+    out << "tcxo_dac " << this->get_tcxo_dac(_iface) << std::endl;
+
+    //write aside and rename, so a restart never reads a partial file
+    namespace fs = boost::filesystem;
+    const fs::path tmp_path(path + ".tmp");
+    {
+        std::ofstream file(tmp_path.string().c_str());
+        file << out.str();
+        if (not file) throw uhd::io_error("umtrx state: cannot write " + tmp_path.string());
+    }
+    fs::rename(tmp_path, fs::path(path));
+}
+
+void umtrx_impl::restore_state(const std::string &path)
+{
+    std::ifstream file(path.c_str());
+    if (not file) throw uhd::io_error("umtrx state: cannot read " + path);
+    std::string line;
+    std::getline(file, line);
+    if (line != STATE_MAGIC) throw uhd::value_error("umtrx state: " + path + " is not a state file");
+
+    uhd::dict<std::string, lms6002d_ctrl::state_t> lms_states;
+    std::vector<std::pair<std::pair<char, std::string>, std::string> > nodes;
+    int pa[4] = {-1, -1, -1, -1};
+    int tcxo_dac = -1;
+    while (std::getline(file, line))
+    {
+        std::istringstream in(line);
+        std::string key;
+        in >> key;
+        if (key == "lms")
+        {
+            std::string side, what;
+            in >> side >> what;
+            lms6002d_ctrl::state_t &state = lms_states[side];
+            if (what == "reg")
+            {
+                int addr = 0, value = 0;
+                in >> std::hex >> addr >> value;
+                state.regs[uint8_t(addr)] = uint8_t(value);
+            }
+            else if (what == "cal")
+            {
+                int code = 0;
+                while (in >> code) state.calibration.push_back(code);
+            }
+            else if (what == "vcocap")
+            {
+                boost::uint32_t cache_key = 0;
+                int start = 0, stop = 0;
+                in >> cache_key >> start >> stop;
+                state.vcocap[cache_key] = std::make_pair(start, stop);
+            }
+        }
+        else if (key == "node")
+        {
+            char type = 0;
+            std::string node_path, value;
+            in >> type >> node_path;
+            std::getline(in >> std::ws, value);
+            nodes.push_back(std::make_pair(std::make_pair(type, node_path), value));
+        }
+        else if (key == "pa") in >> pa[0] >> pa[1] >> pa[2] >> pa[3];
+        else if (key == "tcxo_dac") in >> tcxo_dac;
+    }
+
+    const boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+    {
+        umtrx_fifo_ctrl_batch batch(_ctrl);
+        BOOST_FOREACH(const std::string &side, lms_states.keys())
+        {
+            if (_lms_ctrl.has_key(side)) _lms_ctrl[side]->set_state(lms_states[side]);
+        }
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            if (not _tree->exists(nodes[i].first.second)) continue;
+            try
+            {
+                set_node(_tree, nodes[i].first.first, nodes[i].first.second, nodes[i].second);
+            }
+            catch (const std::exception &ex)
+            {
+                UHD_MSG(warning) << "umtrx state: cannot restore " << nodes[i].first.second << ": " << ex.what() << std::endl;
+            }
+        }
+    }
+    if (pa[3] >= 0)
+    {
+        boost::recursive_mutex::scoped_lock l(_i2c_mutex);
+        _pa_en1 = pa[0] != 0;
+        _pa_en2 = pa[1] != 0;
+        _pa_nlow = pa[2] != 0;
+        commit_pa_state();
+        set_pa_dcdc_r(uint8_t(pa[3]));
+    }
+    if (tcxo_dac >= 0) _tree->access<uint16_t>("/mboards/0/tcxo_dac/value").set(uint16_t(tcxo_dac));
+    _ctrl->flush();
+
+    UHD_MSG(status) << boost::format("Restored the state of %s in %.3fs") % path
+        % ((boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds()/1e6) << std::endl;
+}
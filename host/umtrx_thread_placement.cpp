@@ -0,0 +1,90 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_thread_placement.hpp"
+#include "umtrx_log_adapter.hpp"
+#include "missing/platform.hpp"
+#include <uhd/exception.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/bind/bind.hpp>
+
+umtrx_thread_placement::umtrx_thread_placement(const uhd::device_addr_t &args, const std::string &cpu_key, const bool realtime):
+    cpu(args.cast<int>(cpu_key, -1)),
+    rt_priority(realtime? args.cast<int>("rt_priority", 0) : 0)
+{
+    if (rt_priority < 0 or rt_priority > 99) throw uhd::value_error("rt_priority must be within 1-99, or 0 for the default");
+}
+
+void umtrx_thread_placement::apply(const std::string &name) const
+{
+    if (not this->is_set()) return;
+    if (cpu >= 0 and not uhd::set_thread_affinity(size_t(cpu)))
+    {
+        UHD_MSG(warning) << name << ": failed to pin to cpu " << cpu << std::endl;
+    }
+    if (rt_priority > 0 and not uhd::set_thread_rt_priority(rt_priority))
+    {
+        UHD_MSG(warning) << name << ": failed to set SCHED_FIFO " << rt_priority
+            << ", check the rtprio limit (ulimit -r) or CAP_SYS_NICE" << std::endl;
+    }
+    UHD_MSG(status) << name << ": " << uhd::get_thread_placement() << std::endl;
+}
+
+static void placed_task_body(const umtrx_thread_placement &placement, const std::string &name,
+    boost::shared_ptr<bool> placed, const boost::function<void(void)> &body)
+{
+    //tasks call their body in a loop, on a single thread
+    if (not *placed)
+    {
+        placement.apply(name);
+        *placed = true;
+    }
+    body();
+}
+
+boost::function<void(void)> umtrx_thread_placement::wrap(const std::string &name, const boost::function<void(void)> &body) const
+{
+    if (not this->is_set()) return body;
+    return boost::bind(&placed_task_body, *this, name, boost::shared_ptr<bool>(new bool(false)), body);
+}
+
+std::vector<int> umtrx_thread_placement::parse_cpus(const std::string &list)
+{
+    std::vector<int> cpus;
+    std::vector<std::string> tokens;
+    boost::split(tokens, list, boost::is_any_of(",:"), boost::token_compress_on);
+    for (size_t i = 0; i < tokens.size(); i++)
+    {
+        const std::string token = boost::trim_copy(tokens[i]);
+        if (token.empty()) continue;
+        const size_t dash = token.find('-');
+        try
+        {
+            const int first = boost::lexical_cast<int>(token.substr(0, dash));
+            const int last = (dash == std::string::npos)? first : boost::lexical_cast<int>(token.substr(dash+1));
+            if (first < 0 or last < first) throw uhd::value_error("");
+            for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        }
+        catch (const std::exception &)
+        {
+            throw uhd::value_error("bad cpu list entry " + token + " in " + list);
+        }
+    }
+    return cpus;
+}
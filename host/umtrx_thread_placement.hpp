@@ -0,0 +1,68 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_THREAD_PLACEMENT_HPP
+#define INCLUDED_UMTRX_THREAD_PLACEMENT_HPP
+
+#include <uhd/types/device_addr.hpp>
+#include <boost/function.hpp>
+#include <string>
+#include <vector>
+
+/*!
+ * CPU and scheduling of a thread created by the module.
+ *
+ * Device args:
+ *  - tx_async_cpu: CPU of the tx async/flow control thread and of the mmsg send flusher
+ *  - monitor_cpu: CPU of the status monitor and the status query server
+ *  - rx_convert_cpus: CPUs of the rx converter workers, ex: 2:3 or 2-5,
+ *    one per worker in order (the convert_cpu stream arg takes precedence)
+ *  - rt_priority: SCHED_FIFO priority 1-99 of the streaming threads,
+ *    tx async and rx converters (default: uhd default priority).
+ *    The monitor threads are only ever pinned, never made real-time.
+ *
+ * Every thread with a placement logs where it actually ended up.
+ */
+struct umtrx_thread_placement
+{
+    umtrx_thread_placement(void):
+        cpu(-1), rt_priority(0)
+    {}
+
+    //! Placement of a thread from its cpu device arg and the rt_priority arg
+    umtrx_thread_placement(const uhd::device_addr_t &args, const std::string &cpu_key, const bool realtime);
+
+    int cpu; //negative leaves the affinity alone
+    int rt_priority; //0 leaves the scheduling alone
+
+    //! True when there is anything to apply
+    bool is_set(void) const
+    {
+        return cpu >= 0 or rt_priority > 0;
+    }
+
+    //! Apply to the calling thread and log the effective placement under name
+    void apply(const std::string &name) const;
+
+    //! A task body that applies the placement on its first call, then runs body
+    boost::function<void(void)> wrap(const std::string &name, const boost::function<void(void)> &body) const;
+
+    //! Parse a CPU list, ex: "1:3" or "2-5" or "0:4-6" (commas also work outside of device args)
+    static std::vector<int> parse_cpus(const std::string &list);
+};
+
+#endif /* INCLUDED_UMTRX_THREAD_PLACEMENT_HPP */
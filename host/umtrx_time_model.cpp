@@ -0,0 +1,199 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_time_model.hpp"
+#include <boost/thread/mutex.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+using namespace uhd;
+
+typedef stream_stats_t::clock_type clock_type;
+
+static const size_t MAX_POINTS = 32;
+//readbacks closer than this replace each other, keeps the fit span long
+static const double MIN_POINT_SPACING = 0.1;
+//shortest span of readbacks the rate is fitted over, the nominal rate before
+static const double MIN_FIT_SPAN = 0.5;
+//rate error of the nominal tick rate, TCXO tolerance
+static const double CLOCK_TOLERANCE = 50e-6;
+//longest it takes a PPS to latch a time set with set_time_next_pps()
+static const double PPS_HOLDOFF = 1.1;
+
+static double host_secs(const clock_type::time_point &t)
+{
+    return boost::chrono::duration<double>(t.time_since_epoch()).count();
+}
+
+class umtrx_time_model_impl : public umtrx_time_model
+{
+public:
+    umtrx_time_model_impl(time64_core_200::sptr time64):
+        _time64(time64),
+        _tick_rate(0.0),
+        _valid_after(0.0)
+    {
+        //NOP
+    }
+
+    void add_rx_stats(stream_stats_t::sptr stats)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _bound_stats.push_back(stats);
+    }
+
+    void add_tx_stats(stream_stats_t::sptr stats)
+    {
+        //an ack leaves the device at its timestamp, the same bound as a sample
+        boost::mutex::scoped_lock lock(_mutex);
+        _bound_stats.push_back(stats);
+    }
+
+    void set_tick_rate(const double rate)
+    {
+        _time64->set_tick_rate(rate);
+        boost::mutex::scoped_lock lock(_mutex);
+        _tick_rate = rate;
+        this->reset(host_secs(clock_type::now()));
+    }
+
+    time_spec_t get_time_now(void)
+    {
+        const clock_type::time_point before = clock_type::now();
+        const time_spec_t time = _time64->get_time_now();
+        const clock_type::time_point after = clock_type::now();
+
+        boost::mutex::scoped_lock lock(_mutex);
+        const double host = (host_secs(before) + host_secs(after))/2;
+        if (_tick_rate <= 0.0 or host_secs(before) < _valid_after) return time;
+
+        //the readback was sampled somewhere within the round trip
+        point_t point;
+        point.host = host;
+        point.ticks = time.to_ticks(_tick_rate);
+        point.uncertainty = (host_secs(after) - host_secs(before))/2;
+        if (not _points.empty() and host - _points.back().host < MIN_POINT_SPACING)
+        {
+            if (point.uncertainty < _points.back().uncertainty) _points.back() = point;
+        }
+        else _points.push_back(point);
+        if (_points.size() > MAX_POINTS) _points.pop_front();
+        return time;
+    }
+
+    void set_time_now(const time_spec_t &time)
+    {
+        _time64->set_time_now(time);
+        boost::mutex::scoped_lock lock(_mutex);
+        this->reset(host_secs(clock_type::now()));
+    }
+
+    void set_time_next_pps(const time_spec_t &time)
+    {
+        _time64->set_time_next_pps(time);
+        boost::mutex::scoped_lock lock(_mutex);
+        this->reset(host_secs(clock_type::now()) + PPS_HOLDOFF);
+    }
+
+    bool estimate_time_now(time_spec_t &time, double &error)
+    {
+        const double now = host_secs(clock_type::now());
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_points.empty()) return false;
+
+        //least squares rate over the readbacks, relative to the oldest
+        const point_t &first = _points.front();
+        const double span = _points.back().host - first.host;
+        double rate = _tick_rate;
+        if (_points.size() >= 2 and span >= MIN_FIT_SPAN)
+        {
+            double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+            for (size_t i = 0; i < _points.size(); i++)
+            {
+                const double x = _points[i].host - first.host;
+                const double y = double(boost::int64_t(_points[i].ticks - first.ticks));
+                sx += x; sy += y; sxx += x*x; sxy += x*y;
+            }
+            const double n = double(_points.size());
+            rate = (n*sxy - sx*sy)/(n*sxx - sx*sx);
+        }
+
+        //offset for that rate, the error covers the worst readback
+        double offset = 0.0, max_uncertainty = 0.0, max_residual = 0.0;
+        for (size_t i = 0; i < _points.size(); i++)
+        {
+            offset += double(boost::int64_t(_points[i].ticks - first.ticks)) - rate*(_points[i].host - first.host);
+        }
+        offset /= _points.size();
+        for (size_t i = 0; i < _points.size(); i++)
+        {
+            const double resid = double(boost::int64_t(_points[i].ticks - first.ticks)) - rate*(_points[i].host - first.host) - offset;
+            max_residual = std::max(max_residual, std::abs(resid)/_tick_rate);
+            max_uncertainty = std::max(max_uncertainty, _points[i].uncertainty);
+        }
+        const double rate_error = (rate == _tick_rate)? CLOCK_TOLERANCE : (max_uncertainty + max_residual)/span;
+        const double age = std::max(0.0, now - _points.back().host);
+        double est = offset + rate*(now - first.host); //ticks since the first readback
+        error = max_uncertainty + max_residual + rate_error*age;
+
+        //a received sample or ack puts the time at least past its timestamp,
+        //a bound above the error window is from before the time was set
+        for (size_t i = 0; i < _bound_stats.size(); i++)
+        {
+            const boost::uint64_t ticks = _bound_stats[i]->last_ticks.load(boost::memory_order_acquire);
+            const double host = _bound_stats[i]->last_ticks_host_ns.load(boost::memory_order_relaxed)/1e9;
+            if (host < _valid_after or host < first.host) continue;
+            const double bound = double(boost::int64_t(ticks - first.ticks)) + (now - host)*rate*(1.0 - rate_error);
+            const double hi = est + error*_tick_rate;
+            if (bound <= est or bound > hi) continue;
+            est = (bound + hi)/2;
+            error = (hi - bound)/2/_tick_rate;
+        }
+
+        time = time_spec_t::from_ticks(first.ticks + boost::int64_t(boost::math::llround(est)), _tick_rate);
+        return true;
+    }
+
+private:
+    struct point_t
+    {
+        double host; //steady clock seconds
+        boost::uint64_t ticks;
+        double uncertainty; //half the round trip in seconds
+    };
+
+    void reset(const double valid_after)
+    {
+        _points.clear();
+        _valid_after = valid_after;
+    }
+
+    time64_core_200::sptr _time64;
+    boost::mutex _mutex;
+    double _tick_rate;
+    double _valid_after; //readbacks and packets before this host time are from the old time
+    std::deque<point_t> _points;
+    std::vector<stream_stats_t::sptr> _bound_stats;
+};
+
+umtrx_time_model::sptr umtrx_time_model::make(time64_core_200::sptr time64)
+{
+    return sptr(new umtrx_time_model_impl(time64));
+}
@@ -0,0 +1,72 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_TIME_MODEL_HPP
+#define INCLUDED_UMTRX_TIME_MODEL_HPP
+
+#include "cores/time64_core_200.hpp"
+#include "cores/stream_stats.hpp"
+#include <uhd/types/time_spec.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+/*!
+ * Host side model of the device clock.
+ *
+ * Wraps the time64 core: every get_time_now() readback is stamped with
+ * the host steady clock and kept for a least squares fit of device ticks
+ * against host time. The timestamps of received data packets and of the
+ * tx flow control acks add lower bounds, neither can reach the host before
+ * the device time passed it.
+ * estimate_time_now() extrapolates the fit without any control traffic.
+ *
+ * Setting the time resets the model, after set_time_next_pps() the
+ * readbacks only count once the next PPS can have latched the new time.
+ */
+class umtrx_time_model : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_time_model> sptr;
+
+    //! Make a model on top of a time core
+    static sptr make(time64_core_200::sptr time64);
+
+    //! Rx channel whose data packet timestamps bound the device time
+    virtual void add_rx_stats(stream_stats_t::sptr stats) = 0;
+
+    //! Tx channel whose flow control ack timestamps bound the device time
+    virtual void add_tx_stats(stream_stats_t::sptr stats) = 0;
+
+    virtual void set_tick_rate(const double rate) = 0;
+
+    //! Read the device time, the readback feeds the fit
+    virtual uhd::time_spec_t get_time_now(void) = 0;
+
+    virtual void set_time_now(const uhd::time_spec_t &time) = 0;
+
+    virtual void set_time_next_pps(const uhd::time_spec_t &time) = 0;
+
+    /*!
+     * Estimate the device time from the fit alone.
+     * \param time the estimated device time now
+     * \param error bound on the estimate error in seconds
+     * \return false when there are no readbacks since the time was set
+     */
+    virtual bool estimate_time_now(uhd::time_spec_t &time, double &error) = 0;
+};
+
+#endif /* INCLUDED_UMTRX_TIME_MODEL_HPP */
@@ -0,0 +1,144 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_trace.hpp"
+#include <algorithm>
+#include <map>
+
+umtrx_trace &umtrx_trace::get(void)
+{
+    static umtrx_trace trace;
+    return trace;
+}
+
+umtrx_trace::umtrx_trace(void):
+    _epoch(clock_type::now()), _enabled(false), _head(0), _size(0)
+{
+}
+
+void umtrx_trace::enable(const size_t capacity)
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    if (capacity == 0)
+    {
+        _enabled.store(false, boost::memory_order_release);
+        return;
+    }
+    if (not _slots)
+    {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        _slots.reset(new slot_type[size]);
+        _size = size;
+    }
+    _enabled.store(true, boost::memory_order_release);
+}
+
+boost::uint32_t umtrx_trace::label(const std::string &name)
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    const std::vector<std::string>::iterator it = std::find(_labels.begin(), _labels.end(), name);
+    if (it != _labels.end()) return boost::uint32_t(it - _labels.begin());
+    _labels.push_back(name);
+    return boost::uint32_t(_labels.size() - 1);
+}
+
+std::string umtrx_trace::label_name(const boost::uint32_t id) const
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    return (id < _labels.size())? _labels[id] : "";
+}
+
+std::vector<umtrx_trace_event_t> umtrx_trace::snapshot(const size_t max_events) const
+{
+    std::vector<umtrx_trace_event_t> events;
+    if (not _slots) return events;
+
+    const boost::uint64_t head = _head.load();
+    const boost::uint64_t num = std::min<boost::uint64_t>(head, std::min<boost::uint64_t>(_size, max_events));
+    events.reserve(size_t(num));
+    for (boost::uint64_t n = head - num; n < head; n++)
+    {
+        const slot_type &s = _slots[size_t(n & (_size - 1))];
+        const boost::uint64_t seq = s.seq.load(boost::memory_order_acquire);
+        if (seq != 2*n + 2) continue; //not in yet or overwritten
+        const umtrx_trace_event_t copy = s.ev;
+        boost::atomic_thread_fence(boost::memory_order_acquire);
+        if (s.seq.load(boost::memory_order_relaxed) != seq) continue;
+        events.push_back(copy);
+    }
+    return events;
+}
+
+static bool summary_more_time(const umtrx_trace_summary_t &a, const umtrx_trace_summary_t &b)
+{
+    return a.total_ns > b.total_ns;
+}
+
+bool umtrx_trace::summarize(const std::string &span, std::vector<umtrx_trace_summary_t> &rows, boost::uint64_t &span_ns) const
+{
+    rows.clear();
+    span_ns = 0;
+    const std::vector<umtrx_trace_event_t> events = this->snapshot(_size);
+
+    //the window of the newest span of the label, the spans record when they end
+    boost::uint64_t begin = 0, end = ~boost::uint64_t(0);
+    if (not span.empty())
+    {
+        bool found = false;
+        for (size_t i = events.size(); i > 0 and not found; i--)
+        {
+            const umtrx_trace_event_t &ev = events[i-1];
+            if (ev.bus != UMTRX_TRACE_SPAN or this->label_name(ev.addr) != span) continue;
+            begin = ev.time_ns;
+            end = ev.time_ns + ev.duration_ns;
+            span_ns = ev.duration_ns;
+            found = true;
+        }
+        if (not found) return false;
+    }
+
+    std::map<boost::uint32_t, umtrx_trace_summary_t> by_key;
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const umtrx_trace_event_t &ev = events[i];
+        if (ev.bus == UMTRX_TRACE_SPAN or ev.time_ns < begin or ev.time_ns > end) continue;
+        const boost::uint32_t key = (boost::uint32_t(ev.bus) << 24) | (boost::uint32_t(ev.dir) << 16) | ev.slave;
+        std::map<boost::uint32_t, umtrx_trace_summary_t>::iterator it = by_key.find(key);
+        if (it == by_key.end())
+        {
+            umtrx_trace_summary_t row;
+            row.bus = ev.bus;
+            row.dir = ev.dir;
+            row.slave = ev.slave;
+            row.count = 0;
+            row.total_ns = 0;
+            row.max_ns = 0;
+            it = by_key.insert(std::make_pair(key, row)).first;
+        }
+        it->second.count++;
+        it->second.total_ns += ev.duration_ns;
+        it->second.max_ns = std::max(it->second.max_ns, ev.duration_ns);
+    }
+
+    for (std::map<boost::uint32_t, umtrx_trace_summary_t>::const_iterator it = by_key.begin(); it != by_key.end(); ++it)
+    {
+        rows.push_back(it->second);
+    }
+    std::sort(rows.begin(), rows.end(), &summary_more_time);
+    return true;
+}
@@ -0,0 +1,237 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_TRACE_HPP
+#define INCLUDED_UMTRX_TRACE_HPP
+
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+#include <boost/chrono.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+//! The bus of a traced access
+enum umtrx_trace_bus_t
+{
+    UMTRX_TRACE_WB = 0,     //!< settings and readback registers over the FIFO control
+    UMTRX_TRACE_WB_UDP = 1, //!< registers over the firmware control packets
+    UMTRX_TRACE_SPI = 2,
+    UMTRX_TRACE_I2C = 3,
+    UMTRX_TRACE_SPAN = 4    //!< a named stretch of time, ex: open or a tune
+};
+
+enum umtrx_trace_dir_t
+{
+    UMTRX_TRACE_WRITE = 0,
+    UMTRX_TRACE_READ = 1
+};
+
+/*!
+ * One traced access.
+ * WB: addr is the register address.
+ * SPI: slave is the slave, addr the number of bits, data the word sent,
+ * or the word read with a readback. A burst is one event, addr is the
+ * number of transactions and data the first word.
+ * I2C: slave is the device address, addr the number of bytes, data the
+ * first four bytes.
+ * SPAN: addr is the label, see umtrx_trace::label_name().
+ */
+struct umtrx_trace_event_t
+{
+    boost::uint64_t time_ns; //start, from the trace epoch
+    boost::uint64_t duration_ns;
+    boost::uint8_t bus;
+    boost::uint8_t dir;
+    boost::uint16_t slave;
+    boost::uint32_t addr;
+    boost::uint32_t data;
+};
+
+//! Time and count of the accesses of one bus, direction and slave
+struct umtrx_trace_summary_t
+{
+    boost::uint8_t bus;
+    boost::uint8_t dir;
+    boost::uint16_t slave;
+    boost::uint64_t count;
+    boost::uint64_t total_ns;
+    boost::uint64_t max_ns;
+};
+
+/*!
+ * Process wide lossy ring of register accesses.
+ *
+ * Off, tracing costs one atomic load per access. On, an access takes a
+ * slot with one atomic increment and writes it under the slot seqlock,
+ * any number of threads record at once and nothing ever waits. The ring
+ * keeps the newest events, the reader copies them out and throws away
+ * slots that were overwritten while it read them.
+ * The ring is allocated by the first enable() and lives as long as the
+ * process, so a recorder never sees it go away.
+ */
+class umtrx_trace : boost::noncopyable
+{
+public:
+    typedef boost::chrono::steady_clock clock_type;
+
+    //! The one trace of this process
+    static umtrx_trace &get(void);
+
+    /*!
+     * Start tracing into a ring of at least capacity events.
+     * The capacity of the first call sticks, zero stops tracing.
+     */
+    void enable(const size_t capacity);
+
+    bool enabled(void) const
+    {
+        return _enabled.load(boost::memory_order_acquire); //orders after the ring allocation
+    }
+
+    //! Nanoseconds from the trace epoch
+    boost::uint64_t now_ns(void) const
+    {
+        return boost::chrono::duration_cast<boost::chrono::nanoseconds>(clock_type::now() - _epoch).count();
+    }
+
+    //! Store an event, from any thread
+    void record(const umtrx_trace_event_t &ev)
+    {
+        if (not this->enabled()) return;
+        const boost::uint64_t n = _head.fetch_add(1, boost::memory_order_relaxed);
+        slot_type &s = _slots[size_t(n & (_size - 1))];
+        s.seq.store(2*n + 1, boost::memory_order_relaxed);
+        boost::atomic_thread_fence(boost::memory_order_release);
+        s.ev = ev;
+        s.seq.store(2*n + 2, boost::memory_order_release);
+    }
+
+    //! Store a span of the named label from begin_ns to now
+    void record_span(const std::string &name, const boost::uint64_t begin_ns)
+    {
+        if (not this->enabled()) return;
+        umtrx_trace_event_t ev;
+        ev.time_ns = begin_ns;
+        ev.duration_ns = this->now_ns() - begin_ns;
+        ev.bus = UMTRX_TRACE_SPAN;
+        ev.dir = UMTRX_TRACE_WRITE;
+        ev.slave = 0;
+        ev.addr = this->label(name);
+        ev.data = 0;
+        this->record(ev);
+    }
+
+    //! The id of a span label, the same name always gets the same id
+    boost::uint32_t label(const std::string &name);
+
+    //! The name of a span label, empty when unknown
+    std::string label_name(const boost::uint32_t id) const;
+
+    //! The newest events still in the ring, at most max_events, oldest first
+    std::vector<umtrx_trace_event_t> snapshot(const size_t max_events) const;
+
+    //! Events recorded over all time, the ring holds the newest of them
+    boost::uint64_t get_num_recorded(void) const
+    {
+        return _head.load(boost::memory_order_relaxed);
+    }
+
+    /*!
+     * Sum up the accesses by bus, direction and slave, most time first.
+     * With a span label, only the accesses within the newest span of
+     * that label count, and its duration comes back in span_ns.
+     * Without, every event in the ring counts.
+     * \return false when there is no span of that label in the ring
+     */
+    bool summarize(const std::string &span, std::vector<umtrx_trace_summary_t> &rows, boost::uint64_t &span_ns) const;
+
+private:
+    struct slot_type
+    {
+        slot_type(void): seq(0){}
+        boost::atomic<boost::uint64_t> seq; //odd while written, 2n+2 once event n is in
+        umtrx_trace_event_t ev;
+    };
+
+    umtrx_trace(void);
+
+    const clock_type::time_point _epoch;
+    boost::atomic<bool> _enabled;
+    boost::atomic<boost::uint64_t> _head;
+    size_t _size;
+    boost::scoped_array<slot_type> _slots;
+    mutable boost::mutex _mutex; //enable and the labels
+    std::vector<std::string> _labels;
+};
+
+/*!
+ * Times one access and records it when it goes out of scope.
+ * Reads fill in the data once they have it.
+ */
+class umtrx_trace_scope : boost::noncopyable
+{
+public:
+    umtrx_trace_scope(const umtrx_trace_bus_t bus, const umtrx_trace_dir_t dir,
+        const boost::uint16_t slave, const boost::uint32_t addr, const boost::uint32_t data = 0):
+        _trace(umtrx_trace::get()), _on(_trace.enabled())
+    {
+        if (not _on) return;
+        _ev.time_ns = _trace.now_ns();
+        _ev.duration_ns = 0;
+        _ev.bus = boost::uint8_t(bus);
+        _ev.dir = boost::uint8_t(dir);
+        _ev.slave = slave;
+        _ev.addr = addr;
+        _ev.data = data;
+    }
+
+    //! A span of the named label
+    umtrx_trace_scope(const std::string &span):
+        _trace(umtrx_trace::get()), _on(_trace.enabled())
+    {
+        if (not _on) return;
+        _ev.time_ns = _trace.now_ns();
+        _ev.duration_ns = 0;
+        _ev.bus = UMTRX_TRACE_SPAN;
+        _ev.dir = UMTRX_TRACE_WRITE;
+        _ev.slave = 0;
+        _ev.addr = _trace.label(span);
+        _ev.data = 0;
+    }
+
+    ~umtrx_trace_scope(void)
+    {
+        if (not _on) return;
+        _ev.duration_ns = _trace.now_ns() - _ev.time_ns;
+        _trace.record(_ev);
+    }
+
+    void set_data(const boost::uint32_t data)
+    {
+        _ev.data = data;
+    }
+
+private:
+    umtrx_trace &_trace;
+    const bool _on;
+    umtrx_trace_event_t _ev;
+};
+
+#endif /* INCLUDED_UMTRX_TRACE_HPP */
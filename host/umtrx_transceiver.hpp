@@ -0,0 +1,225 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_TRANSCEIVER_HPP
+#define INCLUDED_UMTRX_TRANSCEIVER_HPP
+
+#include <uhd/stream.hpp>
+#include <uhd/types/metadata.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+/*!
+ * RX to TX loop with a fixed time advance, ex: a GSM BTS.
+ *
+ * recv() hands out the next RX block with the device time of its first
+ * sample, send() takes the TX block that answers it and transmits it at
+ * that time plus the advance. The TX blocks form one continuous burst as
+ * long as they follow each other, a jump in time starts a new burst.
+ *
+ * The device time is estimated from the last RX block and the host clock
+ * since it arrived. A TX block the device would get later than margin
+ * before its time is not sent: it counts as a missed deadline and the
+ * burst ends cleanly, so the application learns about the late block
+ * instead of the device reporting an underflow. The async messages of the
+ * TX stream are drained on every send() into the same statistics.
+ *
+ * The samples are in the cpu formats of the two streamers, RX and TX at
+ * the same rate. One thread drives the loop.
+ *
+ * Header only so that applications can use it without linking the module.
+ */
+class umtrx_transceiver : boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<umtrx_transceiver> sptr;
+
+    struct stats_type
+    {
+        stats_type(void):
+            rx_blocks(0), tx_blocks(0), overflows(0), rx_errors(0),
+            missed_deadlines(0), underflows(0), late_packets(0), seq_errors(0),
+            min_slack(0.0)
+        {}
+
+        unsigned long long rx_blocks, tx_blocks;
+        unsigned long long overflows, rx_errors; //from recv()
+        unsigned long long missed_deadlines; //TX blocks too late to send
+        unsigned long long underflows, late_packets, seq_errors; //from the device
+        double min_slack; //least time in seconds a sent TX block had before its deadline
+    };
+
+    enum send_status_type
+    {
+        SEND_OK,     //queued for its time
+        SEND_LATE,   //missed its deadline, not sent
+        SEND_FAILED  //the streamer took fewer samples than given
+    };
+
+    /*!
+     * Make a transceiver loop.
+     * \param rx_stream the RX streamer, already started
+     * \param tx_stream the TX streamer
+     * \param samp_rate the rate of both
+     * \param advance TX time minus RX time of the same block
+     * \param margin least time the device needs a block ahead of its time
+     */
+    static sptr make(uhd::rx_streamer::sptr rx_stream, uhd::tx_streamer::sptr tx_stream,
+        const double samp_rate, const uhd::time_spec_t &advance, const double margin = 0.002)
+    {
+        return sptr(new umtrx_transceiver(rx_stream, tx_stream, samp_rate, advance, margin));
+    }
+
+    /*!
+     * Receive the next RX block.
+     * \param buffs one buffer per RX channel
+     * \param nsamps samples per channel, the block length
+     * \param time the device time of the first sample
+     * \param timeout seconds to wait
+     * \return samples per channel, 0 on a timeout or error
+     */
+    size_t recv(const uhd::rx_streamer::buffs_type &buffs, const size_t nsamps,
+        uhd::time_spec_t &time, const double timeout = 0.1)
+    {
+        uhd::rx_metadata_t md;
+        const size_t n = _rx_stream->recv(buffs, nsamps, md, timeout);
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW) _stats.overflows++;
+        else if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE and
+            md.error_code != uhd::rx_metadata_t::ERROR_CODE_TIMEOUT) _stats.rx_errors++;
+        if (n == 0) return 0;
+
+        time = md.time_spec;
+        _rx_end = md.time_spec + uhd::time_spec_t::from_ticks(n, _samp_rate);
+        _rx_host = now();
+        _rx_valid = true;
+        _stats.rx_blocks++;
+        return n;
+    }
+
+    /*!
+     * Send the TX block that answers an RX block.
+     * \param buffs one buffer per TX channel
+     * \param nsamps samples per channel
+     * \param rx_time the time recv() gave for the RX block
+     */
+    send_status_type send(const uhd::tx_streamer::buffs_type &buffs, const size_t nsamps, const uhd::time_spec_t &rx_time)
+    {
+        this->poll_async();
+        const uhd::time_spec_t tx_time = rx_time + _advance;
+        const double slack = (tx_time - this->device_time_now()).get_real_secs() - _margin;
+        if (not _rx_valid or slack < 0)
+        {
+            _stats.missed_deadlines++;
+            this->end_burst();
+            return SEND_LATE;
+        }
+
+        uhd::tx_metadata_t md;
+        md.start_of_burst = not _tx_running or tx_time != _tx_next;
+        if (md.start_of_burst) this->end_burst();
+        md.has_time_spec = md.start_of_burst;
+        md.time_spec = tx_time;
+        const size_t n = _tx_stream->send(buffs, nsamps, md, _margin + slack);
+        _tx_running = true;
+        _tx_next = tx_time + uhd::time_spec_t::from_ticks(n, _samp_rate);
+        if (_stats.tx_blocks == 0 or slack < _stats.min_slack) _stats.min_slack = slack;
+        _stats.tx_blocks++;
+        if (n == nsamps) return SEND_OK;
+        this->end_burst();
+        return SEND_FAILED;
+    }
+
+    //! End the running TX burst, ex: before a pause of the loop
+    void end_burst(void)
+    {
+        if (not _tx_running) return;
+        uhd::tx_metadata_t md;
+        md.end_of_burst = true;
+        _tx_stream->send("", 0, md);
+        _tx_running = false;
+    }
+
+    //! Drain the async messages of the TX stream into the statistics
+    void poll_async(void)
+    {
+        uhd::async_metadata_t md;
+        while (_tx_stream->recv_async_msg(md, 0.0))
+        {
+            switch (md.event_code)
+            {
+            case uhd::async_metadata_t::EVENT_CODE_UNDERFLOW:
+            case uhd::async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET:
+                _stats.underflows++; break;
+            case uhd::async_metadata_t::EVENT_CODE_TIME_ERROR:
+                _stats.late_packets++; break;
+            case uhd::async_metadata_t::EVENT_CODE_SEQ_ERROR:
+            case uhd::async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST:
+                _stats.seq_errors++; break;
+            default: break;
+            }
+        }
+    }
+
+    //! Estimated device time: the end of the last RX block plus the host time since
+    uhd::time_spec_t device_time_now(void) const
+    {
+        const double elapsed = (now() - _rx_host).total_microseconds()/1e6;
+        return _rx_end + uhd::time_spec_t(elapsed);
+    }
+
+    const stats_type &get_stats(void) const
+    {
+        return _stats;
+    }
+
+    ~umtrx_transceiver(void)
+    {
+        try {this->end_burst();} catch (...) {}
+    }
+
+private:
+    umtrx_transceiver(uhd::rx_streamer::sptr rx_stream, uhd::tx_streamer::sptr tx_stream,
+        const double samp_rate, const uhd::time_spec_t &advance, const double margin):
+        _rx_stream(rx_stream), _tx_stream(tx_stream),
+        _samp_rate(samp_rate), _advance(advance), _margin(margin),
+        _rx_valid(false), _tx_running(false)
+    {}
+
+    static boost::posix_time::ptime now(void)
+    {
+        return boost::posix_time::microsec_clock::universal_time();
+    }
+
+    uhd::rx_streamer::sptr _rx_stream;
+    uhd::tx_streamer::sptr _tx_stream;
+    const double _samp_rate;
+    const uhd::time_spec_t _advance;
+    const double _margin;
+
+    uhd::time_spec_t _rx_end; //device time right after the last RX block
+    boost::posix_time::ptime _rx_host; //host time it arrived
+    bool _rx_valid;
+
+    bool _tx_running; //a burst is open
+    uhd::time_spec_t _tx_next; //time of the sample after the last one sent
+
+    stats_type _stats;
+};
+
+#endif /* INCLUDED_UMTRX_TRANSCEIVER_HPP */
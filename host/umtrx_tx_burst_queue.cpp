@@ -0,0 +1,178 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_tx_burst_queue.hpp"
+#include "umtrx_tx_burst_streamer.hpp"
+#include "umtrx_common.hpp"
+#include <uhd/exception.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/bind/bind.hpp>
+#include <vector>
+
+using namespace uhd;
+
+class umtrx_tx_burst_queue_impl : public tx_streamer, public umtrx_tx_burst_streamer
+{
+public:
+    umtrx_tx_burst_queue_impl(tx_streamer::sptr stream, const size_t depth,
+        const size_t bytes_per_samp, const umtrx_thread_placement &placement):
+        _stream(stream),
+        _num_chans(stream->get_num_channels()),
+        _bytes_per_samp(bytes_per_samp),
+        _slots(depth),
+        _head(0),
+        _tail(0)
+    {
+        UHD_ASSERT_THROW(depth >= 1 and bytes_per_samp >= 1);
+        for (size_t i = 0; i < _slots.size(); i++) _slots[i].samps.resize(_num_chans);
+        _task = task::make(placement.wrap("tx burst", boost::bind(&umtrx_tx_burst_queue_impl::run, this)));
+    }
+
+    ~umtrx_tx_burst_queue_impl(void)
+    {
+        _task.reset(); //join before the queue goes
+    }
+
+    size_t get_num_channels(void) const
+    {
+        return _num_chans;
+    }
+
+    size_t get_max_num_samps(void) const
+    {
+        return _stream->get_max_num_samps();
+    }
+
+    size_t send(const buffs_type &buffs, const size_t nsamps_per_buff, const tx_metadata_t &md,
+        const double timeout = 0.1)
+    {
+        boost::mutex::scoped_lock lock(_send_mutex);
+        return _stream->send(buffs, nsamps_per_buff, md, timeout);
+    }
+
+    bool recv_async_msg(async_metadata_t &md, const double timeout = 0.1)
+    {
+        return _stream->recv_async_msg(md, timeout);
+    }
+
+    bool submit_burst(const time_spec_t &time, const buffs_type &buffs, const size_t nsamps)
+    {
+        UHD_ASSERT_THROW(buffs.size() == _num_chans);
+        size_t tail = 0;
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            if (_tail - _head >= _slots.size()) return false;
+            tail = _tail;
+        }
+
+        //the thread does not touch a slot past the tail, copy unlocked
+        burst_type &b = _slots[tail % _slots.size()];
+        b.time = time;
+        b.nsamps = nsamps;
+        for (size_t ch = 0; ch < _num_chans; ch++)
+        {
+            const char *in = reinterpret_cast<const char *>(buffs[ch]);
+            b.samps[ch].assign(in, in + nsamps*_bytes_per_samp);
+        }
+
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _tail++;
+        }
+        _cond.notify_one();
+        return true;
+    }
+
+    size_t get_num_queued(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        return _tail - _head;
+    }
+
+private:
+    struct burst_type
+    {
+        burst_type(void): nsamps(0){}
+        time_spec_t time;
+        size_t nsamps;
+        std::vector<std::vector<char> > samps; //per channel, capacity kept between bursts
+    };
+
+    void run(void)
+    {
+        burst_type *b = NULL;
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            if (_head == _tail)
+            {
+                //the task calls back in, a timeout lets it see the interruption
+                _cond.timed_wait(lock, boost::posix_time::milliseconds(100));
+                return;
+            }
+            b = &_slots[_head % _slots.size()];
+        }
+
+        this->send_burst(*b);
+
+        boost::mutex::scoped_lock lock(_mutex);
+        _head++;
+    }
+
+    void send_burst(const burst_type &b)
+    {
+        boost::mutex::scoped_lock lock(_send_mutex);
+        tx_metadata_t md;
+        md.start_of_burst = true;
+        md.end_of_burst = true;
+        md.has_time_spec = true;
+        md.time_spec = b.time;
+
+        //send blocks on the flow control window, only ever on this thread
+        std::vector<const void *> buffs(_num_chans);
+        size_t sent = 0;
+        while (sent < b.nsamps and not boost::this_thread::interruption_requested())
+        {
+            for (size_t ch = 0; ch < _num_chans; ch++) buffs[ch] = &b.samps[ch][sent*_bytes_per_samp];
+            sent += _stream->send(buffs, b.nsamps - sent, md, 0.1);
+            if (sent != 0)
+            {
+                md.start_of_burst = false;
+                md.has_time_spec = false;
+            }
+        }
+    }
+
+    tx_streamer::sptr _stream;
+    const size_t _num_chans;
+    const size_t _bytes_per_samp;
+    boost::mutex _send_mutex; //one sender on the streamer at a time
+
+    std::vector<burst_type> _slots;
+    size_t _head, _tail; //bursts taken by the thread and submitted so far
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+    task::sptr _task;
+};
+
+tx_streamer::sptr umtrx_tx_burst_queue::make(tx_streamer::sptr stream, const size_t depth,
+    const size_t bytes_per_samp, const umtrx_thread_placement &placement)
+{
+    return UMTRX_UHD_PTR_NAMESPACE::make_shared<umtrx_tx_burst_queue_impl>(stream, depth, bytes_per_samp, placement);
+}
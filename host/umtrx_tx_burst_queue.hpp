@@ -0,0 +1,44 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_TX_BURST_QUEUE_HPP
+#define INCLUDED_UMTRX_TX_BURST_QUEUE_HPP
+
+#include "umtrx_thread_placement.hpp"
+#include <uhd/stream.hpp>
+
+/*!
+ * Burst queue on top of a tx streamer, see umtrx_tx_burst_streamer.
+ *
+ * Stream args (after burst_queue=depth):
+ *  - burst_cpu: CPU of the burst thread, it takes the rt_priority device arg
+ */
+class umtrx_tx_burst_queue
+{
+public:
+    /*!
+     * Wrap a streamer.
+     * \param stream the streamer the bursts are sent on
+     * \param depth bursts the queue holds
+     * \param bytes_per_samp size of a sample of the cpu format
+     * \param placement placement of the burst thread
+     */
+    static uhd::tx_streamer::sptr make(uhd::tx_streamer::sptr stream, const size_t depth,
+        const size_t bytes_per_samp, const umtrx_thread_placement &placement);
+};
+
+#endif /* INCLUDED_UMTRX_TX_BURST_QUEUE_HPP */
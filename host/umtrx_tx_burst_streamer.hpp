@@ -0,0 +1,77 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_TX_BURST_STREAMER_HPP
+#define INCLUDED_UMTRX_TX_BURST_STREAMER_HPP
+
+#include <uhd/stream.hpp>
+#include <uhd/types/time_spec.hpp>
+
+//the module is built with hidden symbols, keep the type info shared for dynamic_cast
+#if defined(__GNUC__)
+#define UMTRX_TX_BURST_STREAMER_API __attribute__((visibility("default")))
+#else
+#define UMTRX_TX_BURST_STREAMER_API
+#endif
+
+/*!
+ * Timed burst transmit, ex: GSM timeslots.
+ *
+ * A tx streamer made with the burst_queue=depth stream arg also
+ * implements this interface, get() finds it behind the tx_streamer from
+ * multi_usrp. submit_burst() copies the samples into the queue and
+ * returns at once, a thread of the streamer sends the bursts in order,
+ * each one as a timed start to end of burst, as far ahead of its time
+ * as the flow control window allows.
+ *
+ * Bursts must be submitted in time order and from one thread at a time.
+ * send() on the same streamer still works, it waits for the burst that
+ * is being sent and goes in between two bursts.
+ *
+ * Header only so that applications can use it without linking the module.
+ */
+class UMTRX_TX_BURST_STREAMER_API umtrx_tx_burst_streamer
+{
+public:
+    virtual ~umtrx_tx_burst_streamer(void) {}
+
+    /*!
+     * Queue a burst.
+     * \param time the device time of the first sample
+     * \param buffs the samples of every channel in the cpu format
+     * \param nsamps number of samples per channel
+     * \return false when the queue is full, nothing is queued then
+     */
+    virtual bool submit_burst(const uhd::time_spec_t &time,
+        const uhd::tx_streamer::buffs_type &buffs, const size_t nsamps) = 0;
+
+    //! Bursts queued and not completely sent yet
+    virtual size_t get_num_queued(void) = 0;
+
+    /*!
+     * The burst interface of a streamer.
+     * \param stream a tx streamer sptr of any UHD version
+     * \return the interface, valid with the stream, or NULL without burst_queue
+     */
+    template <typename stream_sptr_type>
+    static umtrx_tx_burst_streamer *get(const stream_sptr_type &stream)
+    {
+        return dynamic_cast<umtrx_tx_burst_streamer *>(stream.get());
+    }
+};
+
+#endif /* INCLUDED_UMTRX_TX_BURST_STREAMER_HPP */
@@ -0,0 +1,90 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_TX_PACKET_STREAMER_HPP
+#define INCLUDED_UMTRX_TX_PACKET_STREAMER_HPP
+
+#include <uhd/types/metadata.hpp>
+#include <cstddef>
+
+//the module is built with hidden symbols, keep the type info shared for dynamic_cast
+#if defined(__GNUC__)
+#define UMTRX_TX_PACKET_STREAMER_API __attribute__((visibility("default")))
+#else
+#define UMTRX_TX_PACKET_STREAMER_API
+#endif
+
+/*!
+ * Zero copy transmit: write the samples straight into the wire frames.
+ *
+ * Every UmTRX tx streamer also implements this interface, get() finds it
+ * behind the tx_streamer from multi_usrp. A packet is written by taking
+ * the frame of every channel with get_tx_buffer(), filling the payloads
+ * and sending them with commit(), which packs the headers. The cpu_format
+ * of the stream args is not applied.
+ *
+ * The payload is the otw_format in wire order: item32 words in the order
+ * of the otw_endian stream arg, auto resolves to little endian on a little
+ * endian host with a recent image. For sc16 each item is one word with I
+ * in the high half and Q in the low half.
+ *
+ * The room for the header is reserved for a timed packet, a commit without
+ * a time spec moves the payload down by the two time words: timed packets
+ * are the ones without any copy. The metadata is taken as given, there is
+ * no start of burst cache and no burst_len bookkeeping.
+ *
+ * Use it from the thread that calls send(), and not with burst_queue.
+ *
+ * Header only so that applications can use it without linking the module.
+ */
+class UMTRX_TX_PACKET_STREAMER_API umtrx_tx_packet_streamer
+{
+public:
+    virtual ~umtrx_tx_packet_streamer(void) {}
+
+    /*!
+     * The payload of the next packet of a channel.
+     * Waits for the flow control window and a free frame. Every channel
+     * takes the same nsamps, a second call for a channel before the
+     * commit returns the same payload.
+     * \param chan the channel index of the stream args
+     * \param nsamps samples of the packet, up to get_max_num_samps()
+     * \param timeout seconds to wait for the frame
+     * \return room for nsamps otw items, NULL on a timeout
+     */
+    virtual void *get_tx_buffer(const size_t chan, const size_t nsamps, const double timeout = 0.1) = 0;
+
+    /*!
+     * Send the packets of every channel.
+     * \param metadata the time spec and burst flags of the packet
+     * \return the number of samples sent per channel
+     */
+    virtual size_t commit(const uhd::tx_metadata_t &metadata) = 0;
+
+    /*!
+     * The packet interface of a streamer.
+     * \param stream a tx streamer sptr of any UHD version
+     * \return the interface, valid with the stream, or NULL for other devices
+     */
+    template <typename stream_sptr_type>
+    static umtrx_tx_packet_streamer *get(const stream_sptr_type &stream)
+    {
+        return dynamic_cast<umtrx_tx_packet_streamer *>(stream.get());
+    }
+};
+
+#endif /* INCLUDED_UMTRX_TX_PACKET_STREAMER_HPP */
@@ -32,7 +32,7 @@ extern "C" {
 //fpga and firmware compatibility numbers
 #define USRP2_FPGA_COMPAT_NUM 9
 #define USRP2_FW_COMPAT_NUM 12
-#define USRP2_FW_VER_MINOR 3
+#define USRP2_FW_VER_MINOR 15
 
 //used to differentiate control packets over data port
 #define USRP2_INVALID_VRT_HEADER 0
@@ -41,19 +41,36 @@ typedef struct{
     uint32_t sequence;
     uint32_t vrt_hdr;
     uint32_t which;
+    uint32_t qos; //USRP2_STREAM_QOS_*, older hosts do not send it
+    uint32_t dst_addr; //IPv4 address the framer sends to, zero for the sender, older hosts do not send it
+    uint32_t dst_port; //UDP port the framer sends to, zero for the sender port
 } usrp2_stream_ctrl_t;
 
+//qos word of usrp2_stream_ctrl_t: [31] 802.1Q tag, [30:28] PCP, [27:16] VLAN ID, [5:0] IP DSCP
+#define USRP2_STREAM_QOS_VLAN (1u << 31)
+#define USRP2_STREAM_QOS_PCP_SHIFT 28
+#define USRP2_STREAM_QOS_VID_SHIFT 16
+#define USRP2_STREAM_QOS_DSCP_MASK 0x3f
+//firmware minor version taking the qos word, the tag also needs UMTRX_FPGA_VLAN_MINOR
+#define UMTRX_FW_STREAM_QOS_MINOR 12
+//firmware minor version taking dst_addr and dst_port
+#define UMTRX_FW_STREAM_DEST_MINOR 13
+
 // udp ports for the usrp2 communication
 // Dynamic and/or private ports: 49152-65535
 #define USRP2_UDP_CTRL_PORT 49152
 //#define USRP2_UDP_UPDATE_PORT 49154
 #define USRP2_UDP_SERVER_PORT 49156
+#define UMTRX_UDP_GPSDO_PORT 49160 //any packet subscribes its source to the GPSDO telemetry
 #define USRP2_UDP_UART_BASE_PORT 49170
 #define USRP2_UDP_UART_GPS_PORT 49172
 
 // Map for virtual firmware regs (not very big so we can keep it here for now)
 #define U2_FW_REG_LOCK_TIME 0
 #define U2_FW_REG_LOCK_GPID 1
+#define U2_FW_REG_LINK_SPEED 2 //Mb/s, zero while the link is down
+#define U2_FW_REG_CTRL_LATENCY_MAX 3 //worst ctrl response time in us, poke zero to reset
+#define U2_FW_REG_BOOT_TIME 4 //ms from the production FPGA configuration to the main loop
 #define U2_FW_REG_VER_MINOR 7
 #define U2_FW_REG_GIT_HASH 6
 
@@ -102,6 +119,15 @@ typedef enum{
     UMTRX_CTRL_ID_ZPU_REQUEST  = 'z',
     UMTRX_CTRL_ID_ZPU_RESPONSE = 'Z',
 
+    UMTRX_CTRL_ID_SENSORS_REQUEST  = 'q',
+    UMTRX_CTRL_ID_SENSORS_RESPONSE = 'Q',
+
+    UMTRX_CTRL_ID_BATCH_REQUEST  = 'b',
+    UMTRX_CTRL_ID_BATCH_RESPONSE = 'B',
+
+    UMTRX_CTRL_ID_EEPROM_REQUEST  = 'e',
+    UMTRX_CTRL_ID_EEPROM_RESPONSE = 'E',
+
     USRP2_CTRL_ID_PEACE_OUT = '~'
 
 } usrp2_ctrl_id_t;
@@ -132,9 +158,33 @@ typedef enum{
     UMTRX_ZPU_REQUEST_GET_GPSDO_FREQ = 4,
     UMTRX_ZPU_REQUEST_GET_GPSDO_FREQ_LPF = 5,
     UMTRX_ZPU_REQUEST_GET_GPSDO_PPS_SECS = 6,
-    UMTRX_ZPU_REQUEST_SET_GPSDO_PPS_TICKS = 7
+    UMTRX_ZPU_REQUEST_SET_GPSDO_PPS_TICKS = 7,
+    UMTRX_ZPU_REQUEST_SET_GPSDO_FAST_ACQ = 8, //data: [31:8] error threshold in Hz, [7:0] gain shift, 0 disables
+    UMTRX_ZPU_REQUEST_LMS_DC_CALIBRATION = 9, //data: [23:16] LMS SPI slave, [15:8] calibration register base, [7:0] DC addr
+    UMTRX_ZPU_REQUEST_LMS_VCOCAP_SWEEP = 10, //data: [31:24] LMS SPI slave, [23:16] PLL register base, [13:8] last, [5:0] first VCOCAP
+    UMTRX_ZPU_REQUEST_SET_GPS_TIME = 11 //data: 0 off, 1 latch the first fix, 2 every fix
 } umtrx_zpu_action_t;
 
+//reply of UMTRX_ZPU_REQUEST_LMS_DC_CALIBRATION: [7:0] DC_REGVAL, this flag when it does not converge
+#define UMTRX_LMS_DC_CAL_FAILED (1 << 8)
+//firmware minor version with UMTRX_ZPU_REQUEST_LMS_DC_CALIBRATION
+#define UMTRX_FW_LMS_DC_CAL_MINOR 10
+
+//reply of UMTRX_ZPU_REQUEST_LMS_VCOCAP_SWEEP: [15:8] stop, [7:0] start of the window, as int8_t, -1 when not found
+#define UMTRX_LMS_VCOCAP_ERROR (1 << 16) //a comparator reading that should not happen
+//firmware minor version with UMTRX_ZPU_REQUEST_LMS_VCOCAP_SWEEP
+#define UMTRX_FW_LMS_VCOCAP_MINOR 11
+
+//firmware minor version with UMTRX_ZPU_REQUEST_SET_GPS_TIME, the NMEA time latched at the PPS
+#define UMTRX_FW_GPS_TIME_MINOR 14
+
+//sensor snapshot slots, bit n of the mask is values[n]
+#define UMTRX_SENSORS_TEMP_A 0 //TMP102 on side A
+#define UMTRX_SENSORS_TEMP_B 1 //TMP102 on side B
+#define UMTRX_SENSORS_PWR_0  2 //4 inputs of the PA sense ADS1015
+#define UMTRX_SENSORS_DC_0   6 //4 inputs of the DC sense ADS1015
+#define UMTRX_SENSORS_NUM    10
+
 typedef struct{
     uint32_t proto_ver;
     uint32_t id;
@@ -166,9 +216,87 @@ typedef struct{
             uint32_t action;
             uint32_t data;
         } zpu_action;
+        struct {
+            uint16_t mask; //request: sensors to sample, response: sensors sampled
+            //request: [0] PA sense and [1] DC sense ADC config registers
+            //response: raw sensor registers
+            uint16_t values[UMTRX_SENSORS_NUM];
+        } sensors_args;
     } data;
 } usrp2_ctrl_data_t;
 
+//batched control request, the ops run in order and come back with their results
+#define UMTRX_CTRL_BATCH_MAX_OPS 32
+
+typedef enum{
+    UMTRX_BATCH_OP_POKE32    = 1, //fpga register
+    UMTRX_BATCH_OP_PEEK32    = 2,
+    UMTRX_BATCH_OP_FW_POKE32 = 3, //virtual firmware register
+    UMTRX_BATCH_OP_FW_PEEK32 = 4,
+    UMTRX_BATCH_OP_SPI       = 5,
+    UMTRX_BATCH_OP_I2C_WRITE = 6,
+    UMTRX_BATCH_OP_I2C_READ  = 7
+} umtrx_batch_op_type_t;
+
+//spi flags
+#define UMTRX_BATCH_SPI_READBACK  (1 << 0)
+#define UMTRX_BATCH_SPI_MOSI_RISE (1 << 1)
+#define UMTRX_BATCH_SPI_MISO_RISE (1 << 2)
+
+typedef struct{
+    uint8_t type;
+    uint8_t flags;  //spi flags
+    uint8_t len;    //spi bits, i2c bytes (at most 4)
+    uint8_t status; //response: zero when done
+    uint32_t addr;  //register, spi slave or i2c device
+    uint32_t data;  //write data, response: read data, i2c bytes in wire order
+} umtrx_batch_op_t;
+
+typedef struct{
+    uint32_t proto_ver;
+    uint32_t id;
+    uint32_t seq;
+    uint32_t num_ops;
+    umtrx_batch_op_t ops[UMTRX_CTRL_BATCH_MAX_OPS]; //only num_ops are sent
+} umtrx_ctrl_batch_t;
+
+//EEPROM range read, a whole 24LC02 image fits one reply
+#define UMTRX_CTRL_EEPROM_MAX_BYTES 256
+
+typedef struct{
+    uint32_t proto_ver;
+    uint32_t id;
+    uint32_t seq;
+    uint8_t addr;    //i2c device
+    uint8_t ok;      //response: non-zero when the read worked
+    uint16_t offset;
+    uint16_t len;    //at most UMTRX_CTRL_EEPROM_MAX_BYTES
+    uint16_t reserved;
+    uint8_t data[UMTRX_CTRL_EEPROM_MAX_BYTES]; //response only
+} umtrx_ctrl_eeprom_t;
+
+//GPSDO telemetry, pushed to the UMTRX_UDP_GPSDO_PORT subscriber after every PPS
+//older firmware pushes it after valid measurements only, with the interrupt time
+#define UMTRX_FW_PPS_EVENT_MINOR 15
+#define UMTRX_GPSDO_TELEMETRY_ID 'G'
+#define UMTRX_GPSDO_FLAG_LOCKED   (1 << 0)
+#define UMTRX_GPSDO_FLAG_FAST_ACQ (1 << 1) //fast acquire gains in use
+#define UMTRX_GPSDO_FLAG_TIME_SET (1 << 2) //the GPS time was latched into time64
+#define UMTRX_GPSDO_FLAG_PPS_VALID (1 << 3) //the VCTCXO count of this PPS was in range
+
+typedef struct{
+    uint32_t proto_ver;
+    uint32_t id;
+    uint32_t seq;       //valid PPS measurements since the GPSDO init
+    uint32_t pps_secs;  //time64 latched at the PPS
+    uint32_t pps_ticks;
+    uint32_t freq;      //VCTCXO counter over the last second, Hz
+    uint32_t freq_lpf;  //filtered counter, 29.3 fixed point
+    int32_t freq_error; //target minus filtered counter, 29.3 fixed point
+    uint16_t dac;       //VCTCXO DAC value
+    uint16_t flags;
+} umtrx_gpsdo_telemetry_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,360 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_cal_search.hpp"
+#include <uhd/utils/safe_main.hpp>
+#include <boost/ref.hpp>
+#include <boost/program_options.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/scoped_array.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <map>
+
+namespace po = boost::program_options;
+
+/***********************************************************************
+ * Band presets, as umtrx_auto_calibration has them
+ * IQ ranges are split where the LMS VCO changes, a point at the
+ * boundary would be calibrated on the wrong VCO.
+ **********************************************************************/
+struct cal_range_t{double start, stop;};
+
+struct cal_preset_t{
+    std::string name;
+    cal_range_t dc;
+    std::vector<cal_range_t> iq;
+};
+
+static cal_range_t make_range(const double start, const double stop)
+{
+    cal_range_t r;
+    r.start = start;
+    r.stop = stop;
+    return r;
+}
+
+static cal_preset_t get_preset(const std::string &name)
+{
+    cal_preset_t p;
+    p.name = name;
+    if (name == "GSM850"){
+        p.dc = make_range(869e6, 894e6);
+        p.iq.push_back(make_range(869e6, 894e6));
+    }
+    else if (name == "GSM900" or name == "EGSM900"){
+        p.dc = make_range(925e6, 960e6);
+        p.iq.push_back(make_range(925e6, 930e6));
+        p.iq.push_back(make_range(930.001e6, 960e6));
+    }
+    else if (name == "GSM1800" or name == "DCS1800"){
+        p.dc = make_range(1805e6, 1880e6);
+        p.iq.push_back(make_range(1805e6, 1860e6));
+        p.iq.push_back(make_range(1860.001e6, 1880e6));
+    }
+    else if (name == "GSM1900" or name == "PCS1900"){
+        p.dc = make_range(1930e6, 1990e6);
+        p.iq.push_back(make_range(1930e6, 1990e6));
+    }
+    else throw std::runtime_error("Unknown preset: " + name);
+    return p;
+}
+
+//! What to calibrate at one LO
+struct cal_point_t{
+    cal_point_t(void): dc(false), iq(false){}
+    bool dc, iq;
+};
+
+//! The LO points of the presets, the script swept start and stop of each range
+static std::map<double, cal_point_t> get_points(const std::vector<cal_preset_t> &presets)
+{
+    std::map<double, cal_point_t> points;
+    BOOST_FOREACH(const cal_preset_t &p, presets){
+        points[p.dc.start].dc = true;
+        points[p.dc.stop].dc = true;
+        BOOST_FOREACH(const cal_range_t &r, p.iq){
+            points[r.start].iq = true;
+            points[r.stop].iq = true;
+        }
+    }
+    return points;
+}
+
+struct auto_cal_options_t{
+    std::string method;
+    double tx_wave_freq, tx_wave_ampl;
+    double rx_offset;
+    size_t nsamps;
+    size_t retries;
+    double tone_tolerance;
+    int vga1_gain, vga2_gain, rx_gain;
+    int verbose;
+};
+
+struct side_result_t{
+    std::vector<result_t> dc, iq;
+    size_t failed_points;
+    std::string error;
+};
+
+//! One rx stream and one sweep per side, the sides of a board run side by side
+static void calibrate_side(uhd::usrp::multi_usrp::sptr usrp, const std::string &side, const size_t chan,
+                           const std::string &prefix, const std::map<double, cal_point_t> &points,
+                           const auto_cal_options_t &opts, side_result_t &out)
+{
+    out.failed_points = 0;
+    try
+    {
+        uhd::stream_args_t stream_args("fc32"); //complex floats
+        stream_args.channels = std::vector<size_t>(1, chan);
+        uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+
+        uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
+        const uhd::fs_path dc_fe_path = "/mboards/0/dboards/"+side+"/tx_frontends/0";
+        uhd::property<uint8_t> &dc_i_prop = tree->access<uint8_t>(dc_fe_path / "lms6002d/tx_dc_i/value");
+        uhd::property<uint8_t> &dc_q_prop = tree->access<uint8_t>(dc_fe_path / "lms6002d/tx_dc_q/value");
+        uhd::property<std::complex<double> > &iq_prop = tree->access<std::complex<double> >(
+            "/mboards/0/tx_frontends/"+side+"/iq_balance/value");
+
+        std::vector<samp_type> buff;
+        for (std::map<double, cal_point_t>::const_iterator it = points.begin(); it != points.end(); ++it)
+        {
+            const cal_point_t &point = it->second;
+            bool done = false;
+            for (size_t attempt = 0; attempt < opts.retries and not done; attempt++)
+            {
+                try
+                {
+                    //one tune for both steps of the point
+                    iq_prop.set(0.0);
+                    const double tx_lo = tune_rx_and_tx(usrp, it->first, opts.rx_offset, chan);
+                    const double actual_rx_rate = usrp->get_rx_rate(chan);
+                    const double bb_dc_freq = usrp->get_tx_freq(chan) - usrp->get_rx_freq(chan);
+
+                    result_t dc_result;
+                    if (point.dc){
+                        dc_cal_t dc_cal(dc_i_prop, dc_q_prop, rx_stream, opts.nsamps, bb_dc_freq, actual_rx_rate,
+                                        opts.verbose, false, opts.tone_tolerance);
+                        dc_result = (opts.method == "descent")?
+                            calibrate_descent(dc_cal, tx_lo, opts.verbose) :
+                            calibrate_downhill(dc_cal, tx_lo, opts.verbose);
+                        dc_cal.set_dc_i_best();
+                        dc_cal.set_dc_q_best();
+                        print_result(prefix + "DC ", dc_result);
+                    }
+                    else if (not out.dc.empty()){
+                        //the IQ search runs on the last DC correction below this LO
+                        const result_t &near = out.dc.back();
+                        dc_i_prop.set(uint8_t(near.real_corr));
+                        dc_q_prop.set(uint8_t(near.imag_corr));
+                    }
+
+                    result_t iq_result;
+                    bool iq_valid = false;
+                    if (point.iq){
+                        //the uncorrected capture also checks what DC is left after the DC step
+                        const double bb_tone_freq = bb_dc_freq + opts.tx_wave_freq;
+                        const double bb_imag_freq = bb_dc_freq - opts.tx_wave_freq;
+                        tone_detector detectors[3] = {
+                            tone_detector(bb_tone_freq/actual_rx_rate),
+                            tone_detector(bb_imag_freq/actual_rx_rate),
+                            tone_detector(bb_dc_freq/actual_rx_rate)
+                        };
+                        capture_tones(rx_stream, buff, detectors, 3, opts.nsamps, opts.tone_tolerance);
+                        const double initial_suppression = detectors[0].dbrms() - detectors[1].dbrms();
+                        if (opts.verbose) std::cout << prefix << "residual DC " << detectors[2].dbrms() << " dB" << std::endl;
+
+                        double best_suppression = 0;
+                        const std::complex<double> best_correction = calibrate_iq_balance(iq_prop, rx_stream, buff, detectors,
+                            opts.nsamps, opts.tone_tolerance, best_suppression, opts.verbose);
+
+                        iq_result.freq = tx_lo;
+                        iq_result.real_corr = best_correction.real();
+                        iq_result.imag_corr = best_correction.imag();
+                        iq_result.best = best_suppression;
+                        iq_result.delta = best_suppression - initial_suppression;
+                        iq_valid = best_suppression > 30; //most likely valid
+                        std::cout << boost::format("%sIQ %f MHz: best suppression %f dB, corrected %f dB%s")
+                            % prefix % (tx_lo/1e6) % iq_result.best % iq_result.delta % (iq_valid? "" : ", retrying") << std::endl;
+                        if (not iq_valid) continue;
+                    }
+
+                    if (point.dc) out.dc.push_back(dc_result);
+                    if (iq_valid) out.iq.push_back(iq_result);
+                    done = true;
+                }
+                catch (const std::exception &ex)
+                {
+                    std::cout << prefix << (it->first/1e6) << " MHz: " << ex.what() << ", retrying" << std::endl;
+                }
+            }
+            if (not done) out.failed_points++;
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        out.error = ex.what();
+    }
+}
+
+/***********************************************************************
+ * One board: opened once, both sides at once, stored once
+ **********************************************************************/
+static boost::mutex report_mutex;
+
+static void calibrate_board(const std::string &args, const std::string &name,
+                            const std::map<double, cal_point_t> &points,
+                            const auto_cal_options_t &opts, std::string &report, bool &success)
+{
+    static const std::string sides = "AB";
+    success = false;
+    std::string text;
+    try
+    {
+        std::string serial;
+        uhd::usrp::multi_usrp::sptr usrp = setup_usrp_for_cal(args, sides, serial,
+            opts.vga1_gain, opts.vga2_gain, opts.rx_gain, opts.verbose);
+
+        std::atomic<bool> interrupted(false);
+        boost::thread_group tx_threads;
+        for (size_t chan = 0; chan < sides.size(); chan++){
+            tx_threads.create_thread(boost::bind(&tx_thread, usrp, opts.tx_wave_freq, opts.tx_wave_ampl, boost::ref(interrupted), chan));
+        }
+
+        std::vector<side_result_t> results(sides.size());
+        boost::thread_group cal_threads;
+        for (size_t chan = 0; chan < sides.size(); chan++){
+            const std::string side(1, sides[chan]);
+            cal_threads.create_thread(boost::bind(&calibrate_side, usrp, side, chan, "[" + name + side + "] ",
+                boost::cref(points), boost::cref(opts), boost::ref(results[chan])));
+        }
+        cal_threads.join_all();
+
+        interrupted = true;
+        tx_threads.join_all();
+
+        //every table of the board is written at the end, a failed side keeps its old files
+        success = true;
+        for (size_t chan = 0; chan < sides.size(); chan++){
+            const side_result_t &r = results[chan];
+            const bool ok = r.error.empty() and r.failed_points == 0;
+            if (ok){
+                store_results(usrp, r.dc, "tx", "dc", false, chan);
+                store_results(usrp, r.iq, "tx", "iq", false, chan);
+            }
+            text += str(boost::format("Board %s side %c: %s") % name % sides[chan] % (ok? "SUCCESS" : "FAIL"));
+            if (not r.error.empty()) text += " (" + r.error + ")";
+            else if (r.failed_points != 0) text += str(boost::format(" (%u points failed)") % r.failed_points);
+            text += "\n";
+            success = success and ok;
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        text += str(boost::format("Board %s: FAIL (%s)\n") % name % ex.what());
+    }
+
+    boost::mutex::scoped_lock lock(report_mutex);
+    report += text;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    std::vector<std::string> boards, preset_names;
+    auto_cal_options_t opts;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("verbose", "enable some verbose")
+        ("args", po::value<std::vector<std::string> >(&boards), "device address args, once per board to calibrate several at once")
+        ("preset", po::value<std::vector<std::string> >(&preset_names), "GSM850, EGSM900 (GSM900), GSM1800 (DCS1800), GSM1900 (PCS1900)")
+        ("method", po::value<std::string>(&opts.method)->default_value("downhill"), "DC search method: downhill or descent")
+        ("vga1", po::value<int>(&opts.vga1_gain)->default_value(-20), "LMS6002D Tx VGA1 gain [-35 to -4]")
+        ("vga2", po::value<int>(&opts.vga2_gain)->default_value(22), "LMS6002D Tx VGA2 gain [0 to 25]")
+        ("rx_gain", po::value<int>(&opts.rx_gain)->default_value(50), "LMS6002D Rx combined gain [0 to 156]")
+        ("tx_wave_freq", po::value<double>(&opts.tx_wave_freq)->default_value(50e3), "Transmit wave frequency in Hz")
+        ("tx_wave_ampl", po::value<double>(&opts.tx_wave_ampl)->default_value(0.7), "Transmit wave amplitude in counts")
+        ("rx_offset", po::value<double>(&opts.rx_offset)->default_value(300e3), "RX LO offset from the TX LO in Hz")
+        ("nsamps", po::value<size_t>(&opts.nsamps)->default_value(default_num_samps), "Samples per data capture")
+        ("tone_tolerance", po::value<double>(&opts.tone_tolerance)->default_value(0.0), "Stop a capture early once the tone levels are known within this many dB [default = 0, full nsamps]")
+        ("retries", po::value<size_t>(&opts.retries)->default_value(10), "Attempts per LO point")
+    ;
+    po::positional_options_description pos;
+    pos.add("preset", -1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help") or preset_names.empty()){
+        std::cout << boost::format("UmTRX Automatic Calibration %s") % desc << std::endl;
+        std::cout <<
+            "Calibrates TX DC offset and IQ balance of both sides for the given presets (bands).\n"
+            "The result is stored in the calibration directory, $UHD_CONFIG_DIR defaults to /var/lib/umtrx.\n"
+            "Existing calibration files are renamed when a side calibrates successfully.\n"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (opts.method != "downhill" and opts.method != "descent"){
+        throw std::runtime_error("Unknown calibration method: " + opts.method);
+    }
+    opts.verbose = vm.count("verbose");
+
+    std::vector<cal_preset_t> presets;
+    BOOST_FOREACH(const std::string &name, preset_names) presets.push_back(get_preset(name));
+    const std::map<double, cal_point_t> points = get_points(presets);
+
+    if (std::getenv("UHD_CONFIG_DIR") == NULL) setenv("UHD_CONFIG_DIR", "/var/lib/umtrx", 0);
+    fs::create_directories(std::getenv("UHD_CONFIG_DIR"));
+
+    //synchronous control, as the calibration utilities were always run
+    if (boards.empty()) boards.push_back("");
+    BOOST_FOREACH(std::string &args, boards){
+        if (args.find("fifo_ctrl_window") == std::string::npos){
+            args += std::string(args.empty()? "" : ",") + "fifo_ctrl_window=0";
+        }
+    }
+
+    //the boards have nothing in common, each gets its own thread
+    std::string report;
+    boost::scoped_array<bool> success(new bool[boards.size()]);
+    boost::thread_group board_threads;
+    for (size_t i = 0; i < boards.size(); i++){
+        const std::string name = boost::lexical_cast<std::string>(i);
+        board_threads.create_thread(boost::bind(&calibrate_board, boards[i], name,
+            boost::cref(points), boost::cref(opts), boost::ref(report), boost::ref(success[i])));
+    }
+    board_threads.join_all();
+
+    std::cout << std::endl;
+    std::cout << "====================================================================" << std::endl;
+    std::cout << "                               Result" << std::endl;
+    std::cout << "====================================================================" << std::endl;
+    std::cout << report << std::endl;
+
+    for (size_t i = 0; i < boards.size(); i++){
+        if (not success[i]) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
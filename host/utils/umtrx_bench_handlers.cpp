@@ -0,0 +1,362 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+/***********************************************************************
+ * Host only benchmark of the streaming fast path, no device needed.
+ * Synthetic VRT frames in the UmTRX RX framer layout are served by a
+ * mock transport to the real packet handlers and converters.
+ **********************************************************************/
+
+#include "umtrx_if_hdr.hpp"
+#include "cores/super_recv_packet_handler.hpp"
+#include "cores/super_send_packet_handler.hpp"
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/convert.hpp>
+#include <uhd/transport/zero_copy.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/chrono.hpp>
+#include <boost/format.hpp>
+#include <complex>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace po = boost::program_options;
+using namespace uhd::transport;
+
+typedef boost::chrono::steady_clock bench_clock;
+
+static double elapsed_ns(const bench_clock::time_point &start)
+{
+    return double(boost::chrono::duration_cast<boost::chrono::nanoseconds>(bench_clock::now() - start).count());
+}
+
+/***********************************************************************
+ * Synthetic frames and the mock transport
+ **********************************************************************/
+//! an RX data frame as the UmTRX framer sends it: hdr, sid, tsf, payload, trailer
+static std::vector<boost::uint32_t> make_rx_frame(const size_t spp, const boost::uint32_t sid)
+{
+    vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = spp;
+    ifpi.num_payload_bytes = spp*sizeof(boost::uint32_t);
+    ifpi.packet_count = 0;
+    ifpi.sob = false;
+    ifpi.eob = false;
+    ifpi.has_sid = true;
+    ifpi.sid = sid;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = false;
+    ifpi.has_tsf = true;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = true;
+    ifpi.tlr = 0;
+
+    std::vector<boost::uint32_t> frame(vrt::max_if_hdr_words32 + spp + 1);
+    vrt::if_hdr_pack_be(&frame.front(), ifpi);
+    frame.resize(ifpi.num_packet_words32);
+    for (size_t i = 0; i < spp; i++)
+    {
+        //a ramp, the content only matters to the converter
+        const boost::uint16_t v = boost::uint16_t(i*64);
+        frame[ifpi.num_header_words32 + i] = uhd::htonx(boost::uint32_t((v << 16) | boost::uint16_t(~v)));
+    }
+    return frame;
+}
+
+class mock_mrb : public managed_recv_buffer
+{
+public:
+    void release(void)
+    {
+        //NOP, the frame memory belongs to the transport
+    }
+
+    UHD_INLINE sptr get_new(void *mem, const size_t len)
+    {
+        return make(this, mem, len);
+    }
+};
+
+class mock_msb : public managed_send_buffer
+{
+public:
+    void release(void)
+    {
+        //NOP, committed frames are dropped
+    }
+
+    UHD_INLINE sptr get_new(void *mem, const size_t len)
+    {
+        return make(this, mem, len);
+    }
+};
+
+/*!
+ * Receive: hands out the template frame with a running sequence and time,
+ * two frames are rotated because the handler may hold the previous one.
+ * Send: hands out a scratch frame and drops what is committed.
+ */
+class mock_zero_copy : public zero_copy_if
+{
+public:
+    mock_zero_copy(const std::vector<boost::uint32_t> &frame, const size_t spp):
+        _spp(spp), _seq(0), _tsf(0), _index(0)
+    {
+        _frames[0] = frame;
+        _frames[1] = frame;
+        _send_frame.resize(frame.size() + 16);
+    }
+
+    managed_recv_buffer::sptr get_recv_buff(double)
+    {
+        const size_t index = _index;
+        _index ^= 1;
+        std::vector<boost::uint32_t> &frame = _frames[index];
+        const boost::uint32_t hdr = uhd::ntohx(frame[0]);
+        frame[0] = uhd::htonx(boost::uint32_t((hdr & ~0xf0000) | ((_seq++ & 0xf) << 16)));
+        frame[2] = uhd::htonx(boost::uint32_t(_tsf >> 32));
+        frame[3] = uhd::htonx(boost::uint32_t(_tsf & 0xffffffff));
+        _tsf += _spp;
+        return _mrbs[index].get_new(&frame.front(), frame.size()*sizeof(boost::uint32_t));
+    }
+
+    size_t get_num_recv_frames(void) const
+    {
+        return 2;
+    }
+
+    size_t get_recv_frame_size(void) const
+    {
+        return _frames[0].size()*sizeof(boost::uint32_t);
+    }
+
+    managed_send_buffer::sptr get_send_buff(double)
+    {
+        return _msb.get_new(&_send_frame.front(), _send_frame.size()*sizeof(boost::uint32_t));
+    }
+
+    size_t get_num_send_frames(void) const
+    {
+        return 1;
+    }
+
+    size_t get_send_frame_size(void) const
+    {
+        return _send_frame.size()*sizeof(boost::uint32_t);
+    }
+
+private:
+    const size_t _spp;
+    size_t _seq;
+    boost::uint64_t _tsf;
+    size_t _index;
+    std::vector<boost::uint32_t> _frames[2];
+    mock_mrb _mrbs[2];
+    std::vector<boost::uint32_t> _send_frame;
+    mock_msb _msb;
+};
+
+/***********************************************************************
+ * Benchmarks, each returns ns per iteration
+ **********************************************************************/
+static double bench_hdr_parse(const std::vector<boost::uint32_t> &frame, const size_t num, const bool fast)
+{
+    vrt::if_packet_info_t ifpi;
+    volatile boost::uint64_t sink = 0;
+    const bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < num; i++)
+    {
+        ifpi.num_packet_words32 = frame.size();
+        if (fast) umtrx_if_hdr_unpack_be(&frame.front(), ifpi);
+        else vrt::if_hdr_unpack_be(&frame.front(), ifpi);
+        sink = sink + ifpi.tsf + ifpi.num_payload_words32;
+    }
+    return elapsed_ns(start)/num;
+}
+
+static double bench_convert(const std::vector<boost::uint32_t> &frame, const size_t spp, const size_t num)
+{
+    uhd::convert::id_type id;
+    id.input_format = "sc16_item32_be";
+    id.num_inputs = 1;
+    id.output_format = "fc32";
+    id.num_outputs = 1;
+    uhd::convert::converter::sptr converter = uhd::convert::get_converter(id)();
+    converter->set_scalar(1/32767.);
+
+    std::vector<std::complex<float> > out(spp);
+    const void *in = &frame[RX_VRT_HDR_WORDS32];
+    void *outp = &out.front();
+    const bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < num; i++) converter->conv(in, outp, spp);
+    return elapsed_ns(start)/num;
+}
+
+static double bench_recv(const size_t num_chans, const size_t spp, const size_t num)
+{
+    std::vector<zero_copy_if::sptr> xports;
+    sph::recv_packet_streamer streamer(spp);
+    streamer.resize(num_chans);
+    streamer.set_vrt_unpacker(&umtrx_if_hdr_unpack_be);
+    streamer.set_tick_rate(1e6);
+    streamer.set_samp_rate(1e6);
+
+    uhd::convert::id_type id;
+    id.input_format = "sc16_item32_be";
+    id.num_inputs = 1;
+    id.output_format = "fc32";
+    id.num_outputs = 1;
+    streamer.set_converter(id);
+
+    for (size_t i = 0; i < num_chans; i++)
+    {
+        xports.push_back(zero_copy_if::sptr(new mock_zero_copy(make_rx_frame(spp, i), spp)));
+        streamer.set_xport_chan_get_buff(i, boost::bind(&zero_copy_if::get_recv_buff, xports[i], boost::placeholders::_1));
+    }
+
+    std::vector<std::vector<std::complex<float> > > buffs(num_chans, std::vector<std::complex<float> >(spp));
+    std::vector<void *> buff_ptrs;
+    for (size_t i = 0; i < num_chans; i++) buff_ptrs.push_back(&buffs[i].front());
+
+    uhd::rx_metadata_t md;
+    size_t errors = 0;
+    const bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < num; i++)
+    {
+        streamer.recv(buff_ptrs, spp, md, 0.1, true);
+        if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE) errors++;
+    }
+    const double ns = elapsed_ns(start)/num;
+    if (errors) std::cerr << boost::format("recv %u channels: %u errors") % num_chans % errors << std::endl;
+    return ns;
+}
+
+static double bench_send(const size_t num_chans, const size_t spp, const size_t num)
+{
+    std::vector<zero_copy_if::sptr> xports;
+    sph::send_packet_streamer streamer(spp);
+    streamer.resize(num_chans);
+    streamer.set_vrt_packer(&vrt::if_hdr_pack_be, 1/*fc word*/);
+    streamer.set_tick_rate(1e6);
+    streamer.set_samp_rate(1e6);
+
+    uhd::convert::id_type id;
+    id.input_format = "fc32";
+    id.num_inputs = 1;
+    id.output_format = "sc16_item32_be";
+    id.num_outputs = 1;
+    streamer.set_converter(id);
+
+    for (size_t i = 0; i < num_chans; i++)
+    {
+        xports.push_back(zero_copy_if::sptr(new mock_zero_copy(make_rx_frame(spp, i), spp)));
+        streamer.set_xport_chan_get_buff(i, boost::bind(&zero_copy_if::get_send_buff, xports[i], boost::placeholders::_1));
+        streamer.set_xport_chan_sid(i, true, i);
+    }
+
+    const std::vector<std::complex<float> > buff(spp, std::complex<float>(0.5f, -0.5f));
+    std::vector<const void *> buff_ptrs(num_chans, &buff.front());
+
+    uhd::tx_metadata_t md;
+    md.start_of_burst = false;
+    md.end_of_burst = false;
+    md.has_time_spec = false;
+    const bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < num; i++) streamer.send(buff_ptrs, spp, md, 0.1);
+    return elapsed_ns(start)/num;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    size_t num_packets, spp;
+    std::string json_file;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("packets", po::value<size_t>(&num_packets)->default_value(200000), "iterations of each benchmark")
+        ("spp", po::value<size_t>(&spp)->default_value(363), "samples per packet, 363 fills a 1472 byte frame")
+        ("json", po::value<std::string>(&json_file)->default_value(""), "write the results as JSON to this file, - for stdout")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX packet handler benchmark %s") % desc << std::endl;
+        return ~0;
+    }
+
+    //the fast path must agree with the generic parser on the framer layout
+    const std::vector<boost::uint32_t> frame = make_rx_frame(spp, 0);
+    vrt::if_packet_info_t fast, generic;
+    fast.num_packet_words32 = generic.num_packet_words32 = frame.size();
+    umtrx_if_hdr_unpack_be(&frame.front(), fast);
+    vrt::if_hdr_unpack_be(&frame.front(), generic);
+    if (fast.num_header_words32 != generic.num_header_words32 or fast.num_payload_words32 != generic.num_payload_words32
+        or fast.sid != generic.sid or fast.tsf != generic.tsf or fast.packet_count != generic.packet_count)
+    {
+        std::cerr << "the fast header parser disagrees with vrt::if_hdr_unpack_be" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    boost::property_tree::ptree results;
+    std::vector<std::pair<std::string, double> > runs;
+    runs.push_back(std::make_pair("hdr_parse_umtrx", bench_hdr_parse(frame, num_packets, true)));
+    runs.push_back(std::make_pair("hdr_parse_generic", bench_hdr_parse(frame, num_packets, false)));
+    runs.push_back(std::make_pair("convert_sc16_fc32", bench_convert(frame, spp, num_packets)));
+    for (size_t n = 1; n <= 4; n++)
+    {
+        runs.push_back(std::make_pair(str(boost::format("recv_%uch") % n), bench_recv(n, spp, num_packets)));
+    }
+    for (size_t n = 1; n <= 2; n++)
+    {
+        runs.push_back(std::make_pair(str(boost::format("send_%uch") % n), bench_send(n, spp, num_packets)));
+    }
+
+    std::cout << boost::format("%d packets of %d samples") % num_packets % spp << std::endl;
+    std::cout << boost::format("%-20s %12s") % "benchmark" % "ns/packet" << std::endl;
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        std::cout << boost::format("%-20s %12.1f") % runs[i].first % runs[i].second << std::endl;
+        results.put(runs[i].first, runs[i].second);
+    }
+
+    //machine readable results for regression tracking
+    if (not json_file.empty())
+    {
+        boost::property_tree::ptree doc;
+        doc.put("packets", num_packets);
+        doc.put("spp", spp);
+        doc.add_child("ns_per_packet", results);
+        if (json_file == "-") boost::property_tree::write_json(std::cout, doc);
+        else
+        {
+            std::ofstream out(json_file.c_str());
+            boost::property_tree::write_json(out, doc);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
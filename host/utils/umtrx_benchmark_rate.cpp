@@ -0,0 +1,494 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifdef THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread.hpp>
+#else // THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread_priority.hpp>
+#endif // THREAD_PRIORITY_HPP_DEPRECATED
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/convert.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <complex>
+#include <cmath>
+#include <ctime>
+
+namespace po = boost::program_options;
+namespace pt = boost::posix_time;
+
+/***********************************************************************
+ * Counters of one benchmark run, each worker owns its own copy
+ **********************************************************************/
+struct stream_counts_t
+{
+    stream_counts_t(void):
+        samps(0), overflows(0), seq_errors(0), timeouts(0),
+        underflows(0), late(0), other_errors(0)
+    {}
+
+    void add(const stream_counts_t &o)
+    {
+        samps += o.samps; overflows += o.overflows; seq_errors += o.seq_errors;
+        timeouts += o.timeouts; underflows += o.underflows; late += o.late;
+        other_errors += o.other_errors;
+    }
+
+    unsigned long long samps;
+    unsigned long long overflows;
+    unsigned long long seq_errors;
+    unsigned long long timeouts;
+    unsigned long long underflows;
+    unsigned long long late;
+    unsigned long long other_errors;
+};
+
+static std::vector<size_t> parse_counts(const std::string &list)
+{
+    std::vector<std::string> tokens;
+    boost::split(tokens, list, boost::is_any_of(", "), boost::token_compress_on);
+    std::vector<size_t> counts;
+    BOOST_FOREACH(const std::string &token, tokens)
+    {
+        if (not token.empty()) counts.push_back(boost::lexical_cast<size_t>(token));
+    }
+    return counts;
+}
+
+//! every discrete rate of the host rate ranges within the limits
+static std::vector<double> list_rates(const uhd::meta_range_t &ranges, const double min_rate, const double max_rate)
+{
+    std::vector<double> rates;
+    BOOST_FOREACH(const uhd::range_t &range, ranges)
+    {
+        const double step = (range.step() > 0)? range.step() : range.stop() - range.start() + 1;
+        for (double rate = range.start(); rate <= range.stop(); rate += step)
+        {
+            if (rate >= min_rate and rate <= max_rate) rates.push_back(rate);
+        }
+    }
+    std::sort(rates.begin(), rates.end());
+    rates.erase(std::unique(rates.begin(), rates.end()), rates.end());
+    return rates;
+}
+
+/***********************************************************************
+ * Stream workers
+ **********************************************************************/
+static void benchmark_rx(uhd::rx_streamer::sptr rx_stream, const size_t bytes_per_item,
+    boost::atomic<bool> &stop, boost::atomic<unsigned long long> &live_samps, stream_counts_t &counts)
+{
+    uhd::set_thread_priority_safe();
+
+    const size_t spp = rx_stream->get_max_num_samps();
+    std::vector<std::vector<char> > buffs(rx_stream->get_num_channels(), std::vector<char>(spp*bytes_per_item));
+    std::vector<void *> buff_ptrs;
+    for (size_t i = 0; i < buffs.size(); i++) buff_ptrs.push_back(&buffs[i].front());
+
+    uhd::rx_metadata_t md;
+    double timeout = 1.0; //the stream starts in the future
+    while (not stop)
+    {
+        const size_t num_rx_samps = rx_stream->recv(buff_ptrs, spp, md, timeout);
+        timeout = 0.2;
+        switch (md.error_code)
+        {
+        case uhd::rx_metadata_t::ERROR_CODE_NONE:
+            counts.samps += num_rx_samps*buffs.size();
+            live_samps += num_rx_samps*buffs.size();
+            break;
+        case uhd::rx_metadata_t::ERROR_CODE_OVERFLOW:
+            if (md.out_of_sequence) counts.seq_errors++;
+            else counts.overflows++;
+            break;
+        case uhd::rx_metadata_t::ERROR_CODE_TIMEOUT:
+            counts.timeouts++;
+            break;
+        default:
+            counts.other_errors++;
+            break;
+        }
+    }
+}
+
+static void benchmark_tx(uhd::tx_streamer::sptr tx_stream, const size_t bytes_per_item,
+    const uhd::time_spec_t &start_time, boost::atomic<bool> &stop,
+    boost::atomic<unsigned long long> &live_samps, stream_counts_t &counts)
+{
+    uhd::set_thread_priority_safe();
+
+    const size_t spp = tx_stream->get_max_num_samps();
+    std::vector<char> buff(spp*bytes_per_item); //zeros, the content does not matter
+    std::vector<const void *> buff_ptrs(tx_stream->get_num_channels(), &buff.front());
+
+    uhd::tx_metadata_t md;
+    md.start_of_burst = true;
+    md.has_time_spec = true;
+    md.time_spec = start_time;
+    while (not stop)
+    {
+        const size_t num_tx_samps = tx_stream->send(buff_ptrs, spp, md, 1.0);
+        md.start_of_burst = false;
+        md.has_time_spec = false;
+        counts.samps += num_tx_samps*buff_ptrs.size();
+        live_samps += num_tx_samps*buff_ptrs.size();
+        if (num_tx_samps < spp) counts.timeouts++;
+    }
+
+    md.end_of_burst = true;
+    tx_stream->send("", 0, md);
+}
+
+static void benchmark_tx_async(uhd::tx_streamer::sptr tx_stream, boost::atomic<bool> &stop, stream_counts_t &counts)
+{
+    uhd::async_metadata_t async_md;
+    while (not stop)
+    {
+        if (not tx_stream->recv_async_msg(async_md, 0.1)) continue;
+        switch (async_md.event_code)
+        {
+        case uhd::async_metadata_t::EVENT_CODE_BURST_ACK:
+            break;
+        case uhd::async_metadata_t::EVENT_CODE_UNDERFLOW:
+        case uhd::async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET:
+            counts.underflows++;
+            break;
+        case uhd::async_metadata_t::EVENT_CODE_SEQ_ERROR:
+        case uhd::async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST:
+            counts.seq_errors++;
+            break;
+        case uhd::async_metadata_t::EVENT_CODE_TIME_ERROR:
+            counts.late++;
+            break;
+        default:
+            counts.other_errors++;
+            break;
+        }
+    }
+}
+
+/***********************************************************************
+ * One throughput run at a rate with a number of RX and TX channels
+ **********************************************************************/
+static boost::property_tree::ptree benchmark_run(
+    uhd::usrp::multi_usrp::sptr usrp,
+    const double rate, const size_t num_rx, const size_t num_tx,
+    const std::string &cpu_format, const std::string &otw_format,
+    const double duration)
+{
+    uhd::stream_args_t stream_args(cpu_format, otw_format);
+    const size_t bytes_per_item = uhd::convert::get_bytes_per_item(cpu_format);
+    if (num_rx > 0) usrp->set_rx_rate(rate);
+    if (num_tx > 0) usrp->set_tx_rate(rate);
+
+    uhd::rx_streamer::sptr rx_stream;
+    uhd::tx_streamer::sptr tx_stream;
+    if (num_rx > 0)
+    {
+        for (size_t i = 0; i < num_rx; i++) stream_args.channels.push_back(i);
+        rx_stream = usrp->get_rx_stream(stream_args);
+    }
+    if (num_tx > 0)
+    {
+        stream_args.channels.clear();
+        for (size_t i = 0; i < num_tx; i++) stream_args.channels.push_back(i);
+        tx_stream = usrp->get_tx_stream(stream_args);
+    }
+
+    //start all the streams together a little in the future
+    const uhd::time_spec_t start_time = usrp->get_time_now() + uhd::time_spec_t(0.2);
+    boost::atomic<bool> stop(false);
+    boost::atomic<unsigned long long> rx_live(0), tx_live(0); //read while streaming
+    stream_counts_t rx_counts, tx_counts, async_counts;
+    boost::thread_group threads;
+    if (rx_stream)
+    {
+        uhd::stream_cmd_t stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+        stream_cmd.stream_now = false;
+        stream_cmd.time_spec = start_time;
+        rx_stream->issue_stream_cmd(stream_cmd);
+        threads.create_thread(boost::bind(&benchmark_rx, rx_stream, bytes_per_item, boost::ref(stop), boost::ref(rx_live), boost::ref(rx_counts)));
+    }
+    if (tx_stream)
+    {
+        threads.create_thread(boost::bind(&benchmark_tx, tx_stream, bytes_per_item, start_time, boost::ref(stop), boost::ref(tx_live), boost::ref(tx_counts)));
+        threads.create_thread(boost::bind(&benchmark_tx_async, tx_stream, boost::ref(stop), boost::ref(async_counts)));
+    }
+
+    //measure from the stream start
+    boost::this_thread::sleep(pt::milliseconds(200));
+    const std::clock_t cpu_start = std::clock();
+    const pt::ptime wall_start = pt::microsec_clock::universal_time();
+    const unsigned long long rx_start = rx_live, tx_start = tx_live;
+    boost::this_thread::sleep(pt::microseconds(long(duration*1e6)));
+    const double cpu_secs = double(std::clock() - cpu_start)/CLOCKS_PER_SEC;
+    const double wall_secs = (pt::microsec_clock::universal_time() - wall_start).total_microseconds()/1e6;
+    const unsigned long long rx_window = rx_live - rx_start, tx_window = tx_live - tx_start;
+
+    if (rx_stream) rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    stop = true;
+    threads.join_all();
+    tx_counts.add(async_counts);
+
+    //error counts cover the whole run, the throughput only the measured window
+    const double rx_rate = num_rx? usrp->get_rx_rate() : 0.0;
+    const double tx_rate = num_tx? usrp->get_tx_rate() : 0.0;
+    const double rx_msps = rx_window/wall_secs/1e6;
+    const double tx_msps = tx_window/wall_secs/1e6;
+    const double total_msps = rx_rate*num_rx/1e6 + tx_rate*num_tx/1e6;
+
+    boost::property_tree::ptree result;
+    result.put("rate", rate);
+    result.put("rx_channels", num_rx);
+    result.put("tx_channels", num_tx);
+    result.put("rx_rate", rx_rate);
+    result.put("tx_rate", tx_rate);
+    result.put("seconds", wall_secs);
+    result.put("rx_samps", rx_counts.samps);
+    result.put("rx_msps", rx_msps);
+    result.put("rx_overflows", rx_counts.overflows);
+    result.put("rx_seq_errors", rx_counts.seq_errors);
+    result.put("rx_timeouts", rx_counts.timeouts);
+    result.put("rx_errors", rx_counts.other_errors);
+    result.put("tx_samps", tx_counts.samps);
+    result.put("tx_msps", tx_msps);
+    result.put("tx_underflows", tx_counts.underflows);
+    result.put("tx_seq_errors", tx_counts.seq_errors);
+    result.put("tx_late", tx_counts.late);
+    result.put("tx_timeouts", tx_counts.timeouts);
+    result.put("tx_errors", tx_counts.other_errors);
+    result.put("cpu_load", cpu_secs/wall_secs);
+    result.put("cpu_per_msps", (total_msps > 0)? cpu_secs/wall_secs/total_msps : 0.0);
+    return result;
+}
+
+/***********************************************************************
+ * TX to RX latency through the LMS RF loopback
+ **********************************************************************/
+//! index of the first sample above the threshold, or -1
+static long find_pulse(const std::vector<std::complex<float> > &buff, const size_t num_samps, const float threshold)
+{
+    for (size_t i = 0; i < num_samps; i++)
+    {
+        if (std::abs(buff[i]) > threshold) return long(i);
+    }
+    return -1;
+}
+
+static boost::property_tree::ptree benchmark_latency(
+    uhd::usrp::multi_usrp::sptr usrp, const double rate,
+    const float ampl, const float threshold, const std::string &otw_format)
+{
+    usrp->set_rx_rate(rate);
+    usrp->set_tx_rate(rate);
+    uhd::stream_args_t stream_args("fc32", otw_format);
+    uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+    uhd::tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args);
+
+    const size_t spp = std::min(rx_stream->get_max_num_samps(), tx_stream->get_max_num_samps());
+    std::vector<std::complex<float> > rx_buff(rx_stream->get_max_num_samps());
+    const std::vector<std::complex<float> > pulse(spp, std::complex<float>(ampl, 0));
+
+    uhd::stream_cmd_t stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    stream_cmd.stream_now = false;
+    stream_cmd.time_spec = usrp->get_time_now() + uhd::time_spec_t(0.1);
+    rx_stream->issue_stream_cmd(stream_cmd);
+
+    //a timed pulse gives the device latency, an untimed one the host round trip
+    boost::property_tree::ptree result;
+    result.put("rate", usrp->get_rx_rate());
+    for (int timed = 1; timed >= 0; timed--)
+    {
+        uhd::tx_metadata_t tx_md;
+        tx_md.start_of_burst = true;
+        tx_md.end_of_burst = true;
+        tx_md.has_time_spec = timed != 0;
+        tx_md.time_spec = usrp->get_time_now() + uhd::time_spec_t(0.2);
+        const pt::ptime sent = pt::microsec_clock::universal_time();
+        tx_stream->send(&pulse.front(), pulse.size(), tx_md, 1.0);
+
+        //give up half a second after the pulse
+        uhd::rx_metadata_t rx_md;
+        double latency = -1;
+        const pt::ptime deadline = sent + pt::milliseconds(timed? 700 : 500);
+        while (latency < 0 and pt::microsec_clock::universal_time() < deadline)
+        {
+            const size_t num_rx_samps = rx_stream->recv(&rx_buff.front(), rx_buff.size(), rx_md, 0.5);
+            if (rx_md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE) continue;
+            if (timed and rx_md.time_spec < tx_md.time_spec - uhd::time_spec_t(0.01)) continue;
+            const long index = find_pulse(rx_buff, num_rx_samps, threshold);
+            if (index < 0) continue;
+            if (timed) latency = (rx_md.time_spec + uhd::time_spec_t(index/usrp->get_rx_rate()) - tx_md.time_spec).get_real_secs();
+            else latency = (pt::microsec_clock::universal_time() - sent).total_microseconds()/1e6;
+        }
+        result.put(timed? "device_latency" : "host_round_trip", latency);
+        boost::this_thread::sleep(pt::milliseconds(100)); //let the pulse pass
+    }
+
+    rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    uhd::rx_metadata_t rx_md;
+    while (rx_stream->recv(&rx_buff.front(), rx_buff.size(), rx_md, 0.1)){} //drain
+    return result;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    uhd::set_thread_priority_safe();
+
+    std::string args, rx_list, tx_list, cpu_format, otw_format, json_file, rates_list;
+    double duration, min_rate, max_rate, freq;
+    float ampl, threshold;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "single uhd device address args")
+        ("duration", po::value<double>(&duration)->default_value(2.0), "seconds measured per run")
+        ("rates", po::value<std::string>(&rates_list)->default_value(""), "comma separated rates, default every supported host rate")
+        ("min_rate", po::value<double>(&min_rate)->default_value(0.0), "skip host rates below this")
+        ("max_rate", po::value<double>(&max_rate)->default_value(1e100), "skip host rates above this")
+        ("rx_channels", po::value<std::string>(&rx_list)->default_value("0,1,2,3,4"), "RX channel counts to run")
+        ("tx_channels", po::value<std::string>(&tx_list)->default_value("0,1,2"), "TX channel counts to run")
+        ("cpu", po::value<std::string>(&cpu_format)->default_value("fc32"), "host sample format")
+        ("otw", po::value<std::string>(&otw_format)->default_value("sc16"), "over the wire sample format")
+        ("latency", "measure the TX to RX latency through the RF loopback on channel 0")
+        ("digital", "loop TX back to RX inside the FPGA for the latency test, no RF involved")
+        ("freq", po::value<double>(&freq)->default_value(900e6), "RX and TX LO for the latency test")
+        ("ampl", po::value<float>(&ampl)->default_value(float(0.7)), "amplitude of the latency test pulse")
+        ("threshold", po::value<float>(&threshold)->default_value(float(0.05)), "RX amplitude detecting the pulse")
+        ("json", po::value<std::string>(&json_file)->default_value(""), "write the results as JSON to this file, - for stdout")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX benchmark rate %s") % desc << std::endl;
+        return ~0;
+    }
+
+    std::cout << std::endl;
+    std::cout << boost::format("Creating the usrp device with: %s...") % args << std::endl;
+    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(args);
+    std::cout << boost::format("Using Device: %s") % usrp->get_pp_string() << std::endl;
+    usrp->set_time_now(uhd::time_spec_t(0.0));
+
+    std::vector<double> rates;
+    if (rates_list.empty()) rates = list_rates(usrp->get_rx_rates(), min_rate, max_rate);
+    else
+    {
+        std::vector<std::string> tokens;
+        boost::split(tokens, rates_list, boost::is_any_of(", "), boost::token_compress_on);
+        BOOST_FOREACH(const std::string &token, tokens)
+        {
+            if (not token.empty()) rates.push_back(boost::lexical_cast<double>(token));
+        }
+    }
+
+    const size_t max_rx = std::min<size_t>(4, usrp->get_rx_num_channels());
+    const size_t max_tx = std::min<size_t>(2, usrp->get_tx_num_channels());
+    boost::property_tree::ptree runs;
+    std::cout << boost::format("%12s %3s %3s %10s %10s %6s %6s %6s %6s %6s %8s")
+        % "rate" % "rx" % "tx" % "rx Msps" % "tx Msps" % "O" % "D" % "U" % "S" % "L" % "CPU/Msps" << std::endl;
+    BOOST_FOREACH(const double rate, rates)
+    {
+        BOOST_FOREACH(const size_t num_rx, parse_counts(rx_list))
+        {
+            BOOST_FOREACH(const size_t num_tx, parse_counts(tx_list))
+            {
+                if (num_rx == 0 and num_tx == 0) continue;
+                if (num_rx > max_rx or num_tx > max_tx) continue;
+                const boost::property_tree::ptree result = benchmark_run(
+                    usrp, rate, num_rx, num_tx, cpu_format, otw_format, duration);
+                std::cout << boost::format("%12.0f %3u %3u %10.3f %10.3f %6u %6u %6u %6u %6u %8.4f")
+                    % rate % num_rx % num_tx
+                    % result.get<double>("rx_msps") % result.get<double>("tx_msps")
+                    % result.get<unsigned long long>("rx_overflows") % result.get<unsigned long long>("rx_seq_errors")
+                    % result.get<unsigned long long>("tx_underflows") % result.get<unsigned long long>("tx_seq_errors")
+                    % result.get<unsigned long long>("tx_late") % result.get<double>("cpu_per_msps") << std::endl;
+                runs.push_back(std::make_pair("", result));
+            }
+        }
+    }
+
+    boost::property_tree::ptree latencies;
+    if (vm.count("latency") and max_rx > 0 and max_tx > 0)
+    {
+        //the CAL antenna switches the LMS into RF loopback, the digital one bypasses the LMS
+        const uhd::fs_path loopback_path = "/mboards/0/loopback";
+        uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
+        const bool digital = vm.count("digital") != 0;
+        if (digital and not tree->exists(loopback_path)) throw std::runtime_error("This FPGA image has no digital loopback");
+        const std::string old_ant = usrp->get_rx_antenna(0);
+        if (digital) tree->access<bool>(loopback_path).set(true);
+        else
+        {
+            usrp->set_rx_freq(freq, 0);
+            usrp->set_tx_freq(freq, 0);
+            usrp->set_rx_antenna("CAL", 0);
+        }
+        std::cout << std::endl << boost::format("%12s %16s %16s") % "rate" % "device latency" % "host round trip" << std::endl;
+        BOOST_FOREACH(const double rate, rates)
+        {
+            const boost::property_tree::ptree result = benchmark_latency(usrp, rate, ampl, threshold, otw_format);
+            std::cout << boost::format("%12.0f %14.1fus %14.1fus") % rate
+                % (result.get<double>("device_latency")*1e6) % (result.get<double>("host_round_trip")*1e6) << std::endl;
+            latencies.push_back(std::make_pair("", result));
+        }
+        if (digital) tree->access<bool>(loopback_path).set(false);
+        else usrp->set_rx_antenna(old_ant, 0);
+    }
+
+    //machine readable results for regression tracking
+    if (not json_file.empty())
+    {
+        boost::property_tree::ptree doc;
+        doc.put("device", usrp->get_mboard_name());
+        doc.put("time", pt::to_iso_extended_string(pt::second_clock::universal_time()));
+        doc.put("cpu", cpu_format);
+        doc.put("otw", otw_format);
+        doc.add_child("runs", runs);
+        if (not latencies.empty()) doc.add_child("latency", latencies);
+        if (json_file == "-") boost::property_tree::write_json(std::cout, doc);
+        else
+        {
+            std::ofstream out(json_file.c_str());
+            boost::property_tree::write_json(out, doc);
+        }
+    }
+
+    std::cout << std::endl << "Done!" << std::endl << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,462 @@
+//
+// Copyright 2010 Ettus Research LLC
+// Copyright 2012-2015 Fairwaves, Inc
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_CAL_SEARCH_HPP
+#define INCLUDED_UMTRX_CAL_SEARCH_HPP
+
+#include "usrp_cal_utils.hpp"
+#include <boost/format.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <iostream>
+#include <complex>
+#include <cmath>
+#include <limits>
+#include <map>
+
+/***********************************************************************
+ * Calibration utility class
+ **********************************************************************/
+class dc_cal_t {
+public:
+    dc_cal_t(uhd::property<uint8_t> &dc_i_prop, uhd::property<uint8_t> &dc_q_prop,
+             uhd::rx_streamer::sptr rx_stream,
+             const size_t nsamps,
+             double bb_dc_freq,
+             double rx_rate,
+             int verbose,
+             bool debug_raw_data,
+             double tone_tolerance,
+             int init_dc_i=128, int init_dc_q=128);
+
+    double init();
+    void run_q(int dc_q);
+    void run_i(int dc_i);
+    void run_iq(int dc_i, int dc_q);
+
+    //! DC tone level at a point, each point is only captured once
+    double measure(int dc_i, int dc_q);
+
+    void set_dc_i(double i) {prop_set_check(_dc_i_prop, i);}
+    void set_dc_q(double q) {prop_set_check(_dc_q_prop, q);}
+    void set_dc_i_best() {set_dc_i(_best_dc_i);}
+    void set_dc_q_best() {set_dc_q(_best_dc_q);}
+
+    double get_lowest_offset() const {return _lowest_offset;}
+    int get_best_dc_i() const {return _best_dc_i;}
+    int get_best_dc_q() const {return _best_dc_q;}
+
+    //! measure with the FPGA tone meter instead of streaming, NULL streams
+    void set_tone_meter(hw_tone_meter *meter) {_tone_meter = meter;}
+
+protected:
+    double _lowest_offset;
+    int _best_dc_i;
+    int _best_dc_q;
+    uhd::property<uint8_t> &_dc_i_prop;
+    uhd::property<uint8_t> &_dc_q_prop;
+    int _dc_i, _dc_q; //currently set values, -1 when unknown
+    std::map<std::pair<int, int>, double> _measured;
+
+    uhd::rx_streamer::sptr _rx_stream;
+    std::vector<samp_type> _buff;
+    const size_t _nsamps;
+    double _bb_dc_freq;
+    double _rx_rate;
+    int _verbose;
+    bool _debug_raw_data;
+    double _tone_tolerance;
+    hw_tone_meter *_tone_meter;
+
+    void prop_set_check(uhd::property<uint8_t> &prop, uint8_t val);
+
+    double get_dbrms();
+    bool run_x(int dc_i, int dc_q);
+};
+
+dc_cal_t::dc_cal_t(uhd::property<uint8_t> &dc_i_prop, uhd::property<uint8_t> &dc_q_prop,
+                   uhd::rx_streamer::sptr rx_stream,
+                   const size_t nsamps,
+                   double bb_dc_freq,
+                   double rx_rate,
+                   int verbose,
+                   bool debug_raw_data,
+                   double tone_tolerance,
+                   int init_dc_i,
+                   int init_dc_q)
+    : _best_dc_i(init_dc_i), _best_dc_q(init_dc_q)
+    , _dc_i_prop(dc_i_prop), _dc_q_prop(dc_q_prop)
+    , _dc_i(-1), _dc_q(-1)
+    , _rx_stream(rx_stream)
+    , _nsamps(nsamps)
+    , _bb_dc_freq(bb_dc_freq)
+    , _rx_rate(rx_rate)
+    , _verbose(verbose)
+    , _debug_raw_data(debug_raw_data)
+    , _tone_tolerance(tone_tolerance)
+    , _tone_meter(NULL)
+{
+}
+
+double dc_cal_t::init()
+{
+    //get the DC offset tone size
+    _lowest_offset = std::numeric_limits<double>::infinity();
+    measure(_best_dc_i, _best_dc_q);
+
+    if (_verbose) printf("initial_dc_dbrms = %2.0f dB\n", _lowest_offset);
+    if (_debug_raw_data) write_samples_to_file(_buff, "initial_samples.dat");
+
+    return _lowest_offset;
+}
+
+void dc_cal_t::run_q(int dc_q)
+{
+    if (_verbose) printf("      dc_q = %d", dc_q);
+    run_x(_best_dc_i, dc_q);
+}
+
+void dc_cal_t::run_i(int dc_i)
+{
+    if (_verbose) printf("      dc_i = %d", dc_i);
+    run_x(dc_i, _best_dc_q);
+}
+
+void dc_cal_t::run_iq(int dc_i, int dc_q)
+{
+    if (_verbose) printf("      dc_i = %d dc_q = %d", dc_i, dc_q);
+    run_x(dc_i, dc_q);
+}
+
+double dc_cal_t::measure(int dc_i, int dc_q)
+{
+    //the search methods revisit points, reuse the earlier capture
+    const std::pair<int, int> key(dc_i, dc_q);
+    const std::map<std::pair<int, int>, double>::const_iterator it = _measured.find(key);
+    if (it != _measured.end()) return it->second;
+
+    if (dc_i != _dc_i) set_dc_i(dc_i);
+    if (dc_q != _dc_q) set_dc_q(dc_q);
+    _dc_i = dc_i;
+    _dc_q = dc_q;
+    const double dc_dbrms = get_dbrms();
+    _measured[key] = dc_dbrms;
+
+    if (dc_dbrms < _lowest_offset){
+        _lowest_offset = dc_dbrms;
+        _best_dc_i = dc_i;
+        _best_dc_q = dc_q;
+        if (_debug_raw_data) write_samples_to_file(_buff, "best_samples.dat");
+    }
+    return dc_dbrms;
+}
+
+void dc_cal_t::prop_set_check(uhd::property<uint8_t> &prop, uint8_t val)
+{
+    prop.set(val);
+    uint8_t val_read = prop.get();
+    if (val_read != val)
+        throw std::runtime_error(
+            str(boost::format("Calibration property sets incorrectly. Requested %d, read back %d")
+                          % int(val) % int(val_read)));
+}
+
+double dc_cal_t::get_dbrms()
+{
+    if (_tone_meter != NULL) return _tone_meter->dbrms(_bb_dc_freq);
+
+    //the raw capture is only kept around to be written out
+    if (_debug_raw_data)
+    {
+        capture_samples(_rx_stream, _buff, _nsamps);
+        return compute_tone_dbrms(_buff, _bb_dc_freq/_rx_rate);
+    }
+
+    //detect the tone while receiving, stop once it has settled
+    tone_detector detector(_bb_dc_freq/_rx_rate);
+    capture_tones(_rx_stream, _buff, &detector, 1, _nsamps, _tone_tolerance);
+    return detector.dbrms();
+}
+
+bool dc_cal_t::run_x(int dc_i, int dc_q)
+{
+    //get the DC offset tone size
+    const double lowest_offset = _lowest_offset;
+    const double dc_dbrms = measure(dc_i, dc_q);
+    if (_verbose) printf("    dc_dbrms = %2.0f dB", dc_dbrms);
+
+    const bool better = dc_dbrms < lowest_offset;
+    if (_verbose and better) printf("    *");
+    if (_verbose) printf("\n");
+
+    return better;
+}
+
+/***********************************************************************
+ * Calibration method: Downhill
+ **********************************************************************/
+static result_t calibrate_downhill(dc_cal_t &dc_cal,
+                                   double tx_lo,
+                                   int verbose)
+{
+    //bounds and results from searching
+    int dc_i_start, dc_i_stop, dc_i_step;
+    int dc_q_start, dc_q_stop, dc_q_step;
+
+    //capture initial uncorrected value
+    const double initial_dc_dbrms = dc_cal.init();
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        if (verbose) printf("  iteration %ld  best_i = %d  best_q = %d\n", i, dc_cal.get_best_dc_i(), dc_cal.get_best_dc_q());
+
+        switch (i) {
+        case 0:
+            dc_i_start = 0;
+            dc_i_stop  = 256;
+            dc_q_start = 0;
+            dc_q_stop  = 256;
+            dc_i_step = 10;
+            dc_q_step = 10;
+            break;
+        case 1:
+            dc_i_start = dc_cal.get_best_dc_i() - 15;
+            dc_i_stop  = dc_cal.get_best_dc_i() + 15;
+            dc_q_start = dc_cal.get_best_dc_q() - 15;
+            dc_q_stop  = dc_cal.get_best_dc_q() + 15;
+            dc_i_step = 1;
+            dc_q_step = 1;
+            break;
+        case 2:
+        case 3:
+            dc_i_start = dc_cal.get_best_dc_i() - 3;
+            dc_i_stop  = dc_cal.get_best_dc_i() + 3;
+            dc_q_start = dc_cal.get_best_dc_q() - 3;
+            dc_q_stop  = dc_cal.get_best_dc_q() + 3;
+            dc_i_step = 1;
+            dc_q_step = 1;
+            break;
+        default:
+            dc_i_start = dc_cal.get_best_dc_i() - 1;
+            dc_i_stop  = dc_cal.get_best_dc_i() + 1;
+            dc_q_start = dc_cal.get_best_dc_q() - 1;
+            dc_q_stop  = dc_cal.get_best_dc_q() + 1;
+            dc_i_step = 1;
+            dc_q_step = 1;
+            break;
+        };
+
+        if (i <= 2) {
+            // Itereate through I and Q sequentially
+
+            if (verbose) printf("    I in [%d; %d] step %d Q = %d\n",
+                                            dc_i_start, dc_i_stop, dc_i_step, dc_cal.get_best_dc_q());
+            dc_cal.set_dc_q_best();
+            for (int dc_i = dc_i_start; dc_i <= dc_i_stop; dc_i += dc_i_step){
+                dc_cal.run_i(dc_i);
+            }
+
+            if (verbose) printf("    I = %d Q in [%d; %d] step %d\n",
+                                            dc_cal.get_best_dc_i(), dc_q_start, dc_q_stop, dc_q_step);
+            dc_cal.set_dc_i_best();
+            for (int dc_q = dc_q_start; dc_q <= dc_q_stop; dc_q += dc_q_step){
+                dc_cal.run_q(dc_q);
+            }
+        } else {
+            // Itereate through all combinations of I and Q
+
+            if (verbose) printf("    I in [%d; %d] step %d Q in [%d; %d] step %d\n",
+                                dc_i_start, dc_i_stop, dc_i_step,
+                                dc_q_start, dc_q_stop, dc_q_step);
+            for (int dc_i = dc_i_start; dc_i <= dc_i_stop; dc_i += dc_i_step) {
+                for (int dc_q = dc_q_start; dc_q <= dc_q_stop; dc_q += dc_q_step) {
+                    dc_cal.run_iq(dc_i, dc_q);
+                }
+            }
+        }
+
+    }
+
+    // Calibration result
+    result_t result;
+    result.freq = tx_lo;
+    result.real_corr = dc_cal.get_best_dc_i();
+    result.imag_corr = dc_cal.get_best_dc_q();
+    result.best = dc_cal.get_lowest_offset();
+    result.delta = initial_dc_dbrms - result.best;
+
+    return result;
+}
+
+/***********************************************************************
+ * Calibration method: Coordinate descent
+ **********************************************************************/
+static double measure_axis(dc_cal_t &dc_cal, const bool axis_i, const int other, const int x)
+{
+    return axis_i? dc_cal.measure(x, other) : dc_cal.measure(other, x);
+}
+
+//! Golden-section search for the best code in [lo, hi] along one axis
+static int golden_section_search(dc_cal_t &dc_cal, const bool axis_i, const int other, int lo, int hi)
+{
+    static const double inv_phi = 0.6180339887498949;
+    lo = std::max(lo, 0);
+    hi = std::min(hi, 255);
+
+    //one probe of a step is usually the next step's probe, so it is not captured again
+    while (hi - lo > 4)
+    {
+        const int span = hi - lo;
+        const int c = hi - boost::math::iround(inv_phi*span);
+        const int d = lo + boost::math::iround(inv_phi*span);
+        if (measure_axis(dc_cal, axis_i, other, c) < measure_axis(dc_cal, axis_i, other, d)) hi = d;
+        else lo = c;
+    }
+
+    //finish the small bracket with a scan
+    int best = lo;
+    for (int x = lo+1; x <= hi; x++)
+    {
+        if (measure_axis(dc_cal, axis_i, other, x) < measure_axis(dc_cal, axis_i, other, best)) best = x;
+    }
+    return best;
+}
+
+static result_t calibrate_descent(dc_cal_t &dc_cal,
+                                  double tx_lo,
+                                  int verbose)
+{
+    //capture initial uncorrected value
+    const double initial_dc_dbrms = dc_cal.init();
+
+    //alternate I and Q line searches, narrowing the window around the best point
+    int best_i = dc_cal.get_best_dc_i();
+    int best_q = dc_cal.get_best_dc_q();
+    int window = 128;
+    for (size_t i = 0; i < 8; i++)
+    {
+        const int prev_i = best_i, prev_q = best_q;
+        best_i = golden_section_search(dc_cal, true, best_q, best_i - window, best_i + window);
+        best_q = golden_section_search(dc_cal, false, best_i, best_q - window, best_q + window);
+        if (verbose) printf("  iteration %ld  window = %d  best_i = %d  best_q = %d  dc_dbrms = %2.1f dB\n",
+                            i, window, best_i, best_q, dc_cal.measure(best_i, best_q));
+
+        //early exit once a round no longer moves the point
+        if (i > 0 and best_i == prev_i and best_q == prev_q) break;
+        window = std::max(4, window/4);
+    }
+
+    // Calibration result
+    result_t result;
+    result.freq = tx_lo;
+    result.real_corr = dc_cal.get_best_dc_i();
+    result.imag_corr = dc_cal.get_best_dc_q();
+    result.best = dc_cal.get_lowest_offset();
+    result.delta = initial_dc_dbrms - result.best;
+
+    return result;
+}
+
+static void print_result(const std::string &prefix, const result_t &result)
+{
+    std::cout
+        << prefix
+        << result.freq/1e6 << " MHz "
+        << "I/Q = " << result.real_corr << "/" << result.imag_corr << " "
+        << "(" << dc_offset_int2double(result.real_corr) << "/"
+        <<  dc_offset_int2double(result.imag_corr) << ") "
+        << "leakage = " << result.best << " dB, "
+        << "improvement = " << result.delta << " dB\n"
+        << std::flush
+    ;
+}
+
+
+/***********************************************************************
+ * IQ balance search
+ * detectors are the tone and its image, the best correction is left set
+ **********************************************************************/
+static const size_t num_search_steps = 5;
+static const size_t num_search_iters = 7;
+
+static std::complex<double> calibrate_iq_balance(
+    uhd::property<std::complex<double> > &iq_prop,
+    uhd::rx_streamer::sptr rx_stream,
+    std::vector<samp_type> &buff,
+    tone_detector *detectors,
+    const size_t nsamps,
+    const double tone_tolerance,
+    double &best_suppression,
+    int verbose,
+    hw_tone_meter *tone_meter = NULL, //measures the tone then the image at these freqs in Hz instead
+    const double tone_freq = 0.0,
+    const double imag_freq = 0.0
+){
+    //bounds and results from searching
+    std::complex<double> best_correction;
+    double phase_corr_start = -.3, phase_corr_stop = .3, phase_corr_step;
+    double ampl_corr_start = -.3, ampl_corr_stop = .3, ampl_corr_step;
+    double best_phase_corr = 0, best_ampl_corr = 0;
+    best_suppression = 0;
+
+    for (size_t i = 0; i < num_search_iters; i++){
+
+        phase_corr_step = (phase_corr_stop - phase_corr_start)/(num_search_steps-1);
+        ampl_corr_step = (ampl_corr_stop - ampl_corr_start)/(num_search_steps-1);
+
+        for (double phase_corr = phase_corr_start; phase_corr <= phase_corr_stop + phase_corr_step/2; phase_corr += phase_corr_step){
+        for (double ampl_corr = ampl_corr_start; ampl_corr <= ampl_corr_stop + ampl_corr_step/2; ampl_corr += ampl_corr_step){
+
+            const std::complex<double> correction(ampl_corr, phase_corr);
+            iq_prop.set(correction);
+
+            //receive some samples, both tones are detected on the fly,
+            //the FPGA meter has one bin and takes them one after the other
+            double suppression = 0.0;
+            if (tone_meter != NULL){
+                const double tone_dbrms = tone_meter->dbrms(tone_freq);
+                suppression = tone_dbrms - tone_meter->dbrms(imag_freq);
+            }
+            else{
+                capture_tones(rx_stream, buff, detectors, 2, nsamps, tone_tolerance);
+                suppression = detectors[0].dbrms() - detectors[1].dbrms();
+            }
+
+            if (suppression > best_suppression){
+                best_correction = correction;
+                best_suppression = suppression;
+                best_phase_corr = phase_corr;
+                best_ampl_corr = ampl_corr;
+            }
+
+        }}
+
+        if (verbose) std::cout << "best_phase_corr " << best_phase_corr << std::endl;
+        if (verbose) std::cout << "best_ampl_corr " << best_ampl_corr << std::endl;
+        if (verbose) std::cout << "best_suppression " << best_suppression << std::endl;
+
+        phase_corr_start = best_phase_corr - phase_corr_step;
+        phase_corr_stop = best_phase_corr + phase_corr_step;
+        ampl_corr_start = best_ampl_corr - ampl_corr_step;
+        ampl_corr_stop = best_ampl_corr + ampl_corr_step;
+    }
+
+    iq_prop.set(best_correction);
+    return best_correction;
+}
+
+#endif /* INCLUDED_UMTRX_CAL_SEARCH_HPP */
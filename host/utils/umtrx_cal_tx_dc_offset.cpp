@@ -16,271 +16,108 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
-#include "usrp_cal_utils.hpp"
+#include "umtrx_cal_search.hpp"
 #include <uhd/utils/safe_main.hpp>
 #include <boost/ref.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/program_options.hpp>
-#include <boost/format.hpp>
-#include <boost/math/special_functions/round.hpp>
 #include <iostream>
-#include <complex>
-#include <cmath>
 #include <ctime>
 
 namespace po = boost::program_options;
 
 /***********************************************************************
- * Calibration utility class
+ * Calibration of one side
  **********************************************************************/
-class dc_cal_t {
-public:
-    dc_cal_t(uhd::property<uint8_t> &dc_i_prop, uhd::property<uint8_t> &dc_q_prop,
-             uhd::rx_streamer::sptr rx_stream,
-             const size_t nsamps,
-             double bb_dc_freq,
-             double rx_rate,
-             int verbose,
-             bool debug_raw_data,
-             int init_dc_i=128, int init_dc_q=128);
-
-    double init();
-    void run_q(int dc_q);
-    void run_i(int dc_i);
-    void run_iq(int dc_i, int dc_q);
-
-    void set_dc_i(double i) {prop_set_check(_dc_i_prop, i);}
-    void set_dc_q(double q) {prop_set_check(_dc_q_prop, q);}
-    void set_dc_i_best() {set_dc_i(_best_dc_i);}
-    void set_dc_q_best() {set_dc_q(_best_dc_q);}
-
-    double get_lowest_offset() const {return _lowest_offset;}
-    int get_best_dc_i() const {return _best_dc_i;}
-    int get_best_dc_q() const {return _best_dc_q;}
-
-protected:
-    double _lowest_offset;
-    int _best_dc_i;
-    int _best_dc_q;
-    uhd::property<uint8_t> &_dc_i_prop;
-    uhd::property<uint8_t> &_dc_q_prop;
-
-    uhd::rx_streamer::sptr _rx_stream;
-    std::vector<samp_type> _buff;
-    const size_t _nsamps;
-    double _bb_dc_freq;
-    double _rx_rate;
-    int _verbose;
-    bool _debug_raw_data;
-
-    void prop_set_check(uhd::property<uint8_t> &prop, uint8_t val);
-
-    double get_dbrms();
-    bool run_x();
+struct cal_options_t{
+    std::string method;
+    std::string measure;
+    double freq_start, freq_stop, freq_step;
+    double rx_offset;
+    size_t nsamps;
+    size_t ntrials;
+    bool single_test;
+    int single_test_i, single_test_q;
+    bool debug_raw_data;
+    double tone_tolerance;
+    int verbose;
 };
 
-dc_cal_t::dc_cal_t(uhd::property<uint8_t> &dc_i_prop, uhd::property<uint8_t> &dc_q_prop,
-                   uhd::rx_streamer::sptr rx_stream,
-                   const size_t nsamps,
-                   double bb_dc_freq,
-                   double rx_rate,
-                   int verbose,
-                   bool debug_raw_data,
-                   int init_dc_i,
-                   int init_dc_q)
-    : _best_dc_i(init_dc_i), _best_dc_q(init_dc_q)
-    , _dc_i_prop(dc_i_prop), _dc_q_prop(dc_q_prop)
-    , _rx_stream(rx_stream)
-    , _nsamps(nsamps)
-    , _bb_dc_freq(bb_dc_freq)
-    , _rx_rate(rx_rate)
-    , _verbose(verbose)
-    , _debug_raw_data(debug_raw_data)
-{
-}
-
-double dc_cal_t::init()
-{
-    set_dc_i_best();
-    set_dc_q_best();
-
-    //get the DC offset tone size
-    _lowest_offset = get_dbrms();
-
-    if (_verbose) printf("initial_dc_dbrms = %2.0f dB\n", _lowest_offset);
-    if (_debug_raw_data) write_samples_to_file(_buff, "initial_samples.dat");
-
-    return _lowest_offset;
-}
-
-void dc_cal_t::run_q(int dc_q)
-{
-    if (_verbose) printf("      dc_q = %d", dc_q);
-    set_dc_q(dc_q);
-    if (run_x())
-        _best_dc_q = dc_q;
-}
-
-void dc_cal_t::run_i(int dc_i)
-{
-    if (_verbose) printf("      dc_i = %d", dc_i);
-    set_dc_i(dc_i);
-    if (run_x())
-        _best_dc_i = dc_i;
-}
-
-void dc_cal_t::run_iq(int dc_i, int dc_q)
-{
-    if (_verbose) printf("      dc_i = %d dc_q = %d", dc_i, dc_q);
-    set_dc_i(dc_i);
-    set_dc_q(dc_q);
-    if (run_x()) {
-        _best_dc_i = dc_i;
-        _best_dc_q = dc_q;
-    }
-}
-
-void dc_cal_t::prop_set_check(uhd::property<uint8_t> &prop, uint8_t val)
-{
-    prop.set(val);
-    uint8_t val_read = prop.get();
-    if (val_read != val)
-        throw std::runtime_error(
-            str(boost::format("Calibration property sets incorrectly. Requested %d, read back %d")
-                          % int(val) % int(val_read)));
-}
-
-double dc_cal_t::get_dbrms()
-{
-    //receive some samples
-    capture_samples(_rx_stream, _buff, _nsamps);
-    //calculate dB rms
-    return compute_tone_dbrms(_buff, _bb_dc_freq/_rx_rate);
-}
-
-bool dc_cal_t::run_x()
+static void calibrate_side(uhd::usrp::multi_usrp::sptr usrp, const std::string &which, const size_t chan,
+                           const std::string &prefix, const cal_options_t &opts,
+                           std::vector<result_t> &results, std::string &error)
 {
-    bool better = false;
-
-    //get the DC offset tone size
-    const double dc_dbrms = get_dbrms();
-    if (_verbose) printf("    dc_dbrms = %2.0f dB", dc_dbrms);
-
-    if (dc_dbrms < _lowest_offset){
-        _lowest_offset = dc_dbrms;
-        better = true;
-        if (_verbose) printf("    *");
-        if (_debug_raw_data) write_samples_to_file(_buff, "best_samples.dat");
-    }
-    if (_verbose) printf("\n");
-
-    return better;
-}
-
-/***********************************************************************
- * Calibration method: Downhill
- **********************************************************************/
-static result_t calibrate_downhill(dc_cal_t &dc_cal,
-                                   double tx_lo,
-                                   int verbose)
-{
-    //bounds and results from searching
-    int dc_i_start, dc_i_stop, dc_i_step;
-    int dc_q_start, dc_q_stop, dc_q_step;
-
-    //capture initial uncorrected value
-    const double initial_dc_dbrms = dc_cal.init();
-
-    for (size_t i = 0; i < 6; i++)
+    try
     {
-        if (verbose) printf("  iteration %ld  best_i = %d  best_q = %d\n", i, dc_cal.get_best_dc_i(), dc_cal.get_best_dc_q());
-
-        switch (i) {
-        case 0:
-            dc_i_start = 0;
-            dc_i_stop  = 256;
-            dc_q_start = 0;
-            dc_q_stop  = 256;
-            dc_i_step = 10;
-            dc_q_step = 10;
-            break;
-        case 1:
-            dc_i_start = dc_cal.get_best_dc_i() - 15;
-            dc_i_stop  = dc_cal.get_best_dc_i() + 15;
-            dc_q_start = dc_cal.get_best_dc_q() - 15;
-            dc_q_stop  = dc_cal.get_best_dc_q() + 15;
-            dc_i_step = 1;
-            dc_q_step = 1;
-            break;
-        case 2:
-        case 3:
-            dc_i_start = dc_cal.get_best_dc_i() - 3;
-            dc_i_stop  = dc_cal.get_best_dc_i() + 3;
-            dc_q_start = dc_cal.get_best_dc_q() - 3;
-            dc_q_stop  = dc_cal.get_best_dc_q() + 3;
-            dc_i_step = 1;
-            dc_q_step = 1;
-            break;
-        default:
-            dc_i_start = dc_cal.get_best_dc_i() - 1;
-            dc_i_stop  = dc_cal.get_best_dc_i() + 1;
-            dc_q_start = dc_cal.get_best_dc_q() - 1;
-            dc_q_stop  = dc_cal.get_best_dc_q() + 1;
-            dc_i_step = 1;
-            dc_q_step = 1;
-            break;
-        };
-
-        if (i <= 2) {
-            // Itereate through I and Q sequentially
-
-            if (verbose) printf("    I in [%d; %d] step %d Q = %d\n",
-                                            dc_i_start, dc_i_stop, dc_i_step, dc_cal.get_best_dc_q());
-            dc_cal.set_dc_q_best();
-            for (int dc_i = dc_i_start; dc_i <= dc_i_stop; dc_i += dc_i_step){
-                dc_cal.run_i(dc_i);
-            }
-
-            if (verbose) printf("    I = %d Q in [%d; %d] step %d\n",
-                                            dc_cal.get_best_dc_i(), dc_q_start, dc_q_stop, dc_q_step);
-            dc_cal.set_dc_i_best();
-            for (int dc_q = dc_q_start; dc_q <= dc_q_stop; dc_q += dc_q_step){
-                dc_cal.run_q(dc_q);
-            }
-        } else {
-            // Itereate through all combinations of I and Q
-
-            if (verbose) printf("    I in [%d; %d] step %d Q in [%d; %d] step %d\n",
-                                dc_i_start, dc_i_stop, dc_i_step,
-                                dc_q_start, dc_q_stop, dc_q_step);
-            for (int dc_i = dc_i_start; dc_i <= dc_i_stop; dc_i += dc_i_step) {
-                for (int dc_q = dc_q_start; dc_q <= dc_q_stop; dc_q += dc_q_step) {
-                    dc_cal.run_iq(dc_i, dc_q);
+        //create a receive streamer
+        uhd::stream_args_t stream_args("fc32"); //complex floats
+        stream_args.channels = std::vector<size_t>(1, chan);
+        uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+
+        uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
+        const uhd::fs_path tx_fe_path = "/mboards/0/dboards/"+which+"/tx_frontends/0";
+        uhd::property<uint8_t> &dc_i_prop = tree->access<uint8_t>(tx_fe_path / "lms6002d/tx_dc_i/value");
+        uhd::property<uint8_t> &dc_q_prop = tree->access<uint8_t>(tx_fe_path / "lms6002d/tx_dc_q/value");
+
+        //the FPGA meter sums nsamps rounded up to a power of two after each correction
+        boost::scoped_ptr<hw_tone_meter> tone_meter;
+        if (opts.measure == "hw") tone_meter.reset(new hw_tone_meter(usrp, chan, opts.nsamps));
+
+        for (double tx_lo_i = opts.freq_start; tx_lo_i <= opts.freq_stop; tx_lo_i += opts.freq_step){
+            const double tx_lo = tune_rx_and_tx(usrp, tx_lo_i, opts.rx_offset, chan);
+
+            //frequency constants for this tune event
+            const double actual_rx_rate = usrp->get_rx_rate(chan);
+            const double actual_tx_freq = usrp->get_tx_freq(chan);
+            const double actual_rx_freq = usrp->get_rx_freq(chan);
+            const double bb_dc_freq = actual_tx_freq - actual_rx_freq;
+            if (opts.verbose) printf("actual_rx_rate = %0.2f MHz\n", actual_rx_rate/1e6);
+            if (opts.verbose) printf("actual_tx_freq = %0.2f MHz\n", actual_tx_freq/1e6);
+            if (opts.verbose) printf("actual_rx_freq = %0.2f MHz\n", actual_rx_freq/1e6);
+            if (opts.verbose) printf("bb_dc_freq = %0.2f MHz\n", bb_dc_freq/1e6);
+
+            for (size_t trial_no = 0; trial_no < opts.ntrials; trial_no++)
+            {
+                if (opts.single_test)
+                {
+                    dc_cal_t dc_cal(dc_i_prop, dc_q_prop,
+                                    rx_stream,
+                                    opts.nsamps,
+                                    bb_dc_freq,
+                                    actual_rx_rate,
+                                    opts.verbose,
+                                    opts.debug_raw_data,
+                                    opts.tone_tolerance,
+                                    opts.single_test_i, opts.single_test_q);
+                    dc_cal.set_tone_meter(tone_meter.get());
+
+                    const double dc_dbrms = dc_cal.init();;
+                    printf("%sI = %d Q = %d ", prefix.c_str(), opts.single_test_i, opts.single_test_q);
+                    printf("dc_dbrms = %2.1f dB\n", dc_dbrms);
+                } else {
+                    dc_cal_t dc_cal(dc_i_prop, dc_q_prop,
+                                    rx_stream,
+                                    opts.nsamps,
+                                    bb_dc_freq,
+                                    actual_rx_rate,
+                                    opts.verbose,
+                                    opts.debug_raw_data,
+                                    opts.tone_tolerance);
+                    dc_cal.set_tone_meter(tone_meter.get());
+                    // Perform normal calibration
+                    const result_t result = (opts.method == "descent")?
+                        calibrate_descent(dc_cal, tx_lo, opts.verbose) :
+                        calibrate_downhill(dc_cal, tx_lo, opts.verbose);
+                    print_result(prefix, result);
+                    results.push_back(result);
                 }
             }
         }
-
     }
-
-    // Calibration result
-    result_t result;
-    result.freq = tx_lo;
-    result.real_corr = dc_cal.get_best_dc_i();
-    result.imag_corr = dc_cal.get_best_dc_q();
-    result.best = dc_cal.get_lowest_offset();
-    result.delta = initial_dc_dbrms - result.best;
-
-    // Output to console
-    std::cout
-        << result.freq/1e6 << " MHz "
-        << "I/Q = " << result.real_corr << "/" << result.imag_corr << " "
-        << "(" << dc_offset_int2double(result.real_corr) << "/"
-        <<  dc_offset_int2double(result.imag_corr) << ") "
-        << "leakage = " << result.best << " dB, "
-        << "improvement = " << result.delta << " dB\n"
-        << std::flush
-    ;
-
-    return result;
+    catch (const std::exception &ex)
+    {
+        error = ex.what();
+    }
 }
 
 /***********************************************************************
@@ -288,13 +125,9 @@ static result_t calibrate_downhill(dc_cal_t &dc_cal,
  **********************************************************************/
 int UHD_SAFE_MAIN(int argc, char *argv[]){
     std::string args, which, serial;
-    int verbose;
     int vga1_gain, vga2_gain, rx_gain;
-    double tx_wave_freq, tx_wave_ampl, rx_offset;
-    double freq_start, freq_stop, freq_step;
-    size_t nsamps;
-    size_t ntrials;
-    int single_test_i, single_test_q;
+    double tx_wave_freq, tx_wave_ampl;
+    cal_options_t opts;
 
     po::options_description desc("Allowed options");
     desc.add_options()
@@ -302,21 +135,24 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         ("verbose", "enable some verbose")
         ("debug_raw_data", "save raw captured signals to files")
         ("args", po::value<std::string>(&args)->default_value(""), "device address args [default = \"\"]")
-        ("which", po::value<std::string>(&which)->default_value("A"), "Which chain A or B?")
+        ("which", po::value<std::string>(&which)->default_value("A"), "Which chain A or B? AB calibrates both concurrently")
+        ("method", po::value<std::string>(&opts.method)->default_value("downhill"), "Search method: downhill (grid refinement) or descent (coordinate descent with golden-section line search)")
+        ("measure", po::value<std::string>(&opts.measure)->default_value("host"), "Tone measurement: host (stream the samples) or hw (FPGA tone meter, no streaming)")
         ("vga1", po::value<int>(&vga1_gain)->default_value(-20), "LMS6002D Tx VGA1 gain [-35 to -4]")
         ("vga2", po::value<int>(&vga2_gain)->default_value(22), "LMS6002D Tx VGA2 gain [0 to 25]")
         ("rx_gain", po::value<int>(&rx_gain)->default_value(50), "LMS6002D Rx combined gain [0 to 156]")
         ("tx_wave_freq", po::value<double>(&tx_wave_freq)->default_value(50e3), "Transmit wave frequency in Hz")
         ("tx_wave_ampl", po::value<double>(&tx_wave_ampl)->default_value(0.7), "Transmit wave amplitude in counts")
-        ("rx_offset", po::value<double>(&rx_offset)->default_value(300e3), "RX LO offset from the TX LO in Hz")
-        ("freq_start", po::value<double>(&freq_start), "Frequency start in Hz (do not specify for default)")
-        ("freq_stop", po::value<double>(&freq_stop), "Frequency stop in Hz (do not specify for default)")
-        ("freq_step", po::value<double>(&freq_step)->default_value(default_freq_step), "Step size for LO sweep in Hz")
-        ("nsamps", po::value<size_t>(&nsamps)->default_value(default_num_samps), "Samples per data capture")
-        ("ntrials", po::value<size_t>(&ntrials)->default_value(1), "Num trials per TX LO")
+        ("rx_offset", po::value<double>(&opts.rx_offset)->default_value(300e3), "RX LO offset from the TX LO in Hz")
+        ("freq_start", po::value<double>(&opts.freq_start), "Frequency start in Hz (do not specify for default)")
+        ("freq_stop", po::value<double>(&opts.freq_stop), "Frequency stop in Hz (do not specify for default)")
+        ("freq_step", po::value<double>(&opts.freq_step)->default_value(default_freq_step), "Step size for LO sweep in Hz")
+        ("nsamps", po::value<size_t>(&opts.nsamps)->default_value(default_num_samps), "Samples per data capture")
+        ("tone_tolerance", po::value<double>(&opts.tone_tolerance)->default_value(0.0), "Stop a capture early once the tone level is known within this many dB [default = 0, full nsamps]")
+        ("ntrials", po::value<size_t>(&opts.ntrials)->default_value(1), "Num trials per TX LO")
         ("single_test", "Perform a single measurement and exit (freq = freq_start, I = single_test_i, Q = single_test_q]")
-        ("single_test_i", po::value<int>(&single_test_i)->default_value(128), "Only in the single test mode! I channel calibration value [0 to 255]")
-        ("single_test_q", po::value<int>(&single_test_q)->default_value(128), "Only in the single test mode! Q channel calibration value [0 to 255]")
+        ("single_test_i", po::value<int>(&opts.single_test_i)->default_value(128), "Only in the single test mode! I channel calibration value [0 to 255]")
+        ("single_test_q", po::value<int>(&opts.single_test_q)->default_value(128), "Only in the single test mode! Q channel calibration value [0 to 255]")
         ("append", "Append measurements to the calibratoin file instead of rewriting [default=overwrite]")
     ;
 
@@ -333,83 +169,64 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         return EXIT_FAILURE;
     }
 
-    verbose = vm.count("verbose");
-
-    // Create a USRP device
-    uhd::usrp::multi_usrp::sptr usrp = setup_usrp_for_cal(args, which, serial, vga1_gain, vga2_gain, rx_gain, verbose);
+    if (opts.method != "downhill" and opts.method != "descent"){
+        throw std::runtime_error("Unknown calibration method: " + opts.method);
+    }
+    if (opts.measure != "host" and opts.measure != "hw"){
+        throw std::runtime_error("Unknown measurement: " + opts.measure);
+    }
+    if (opts.measure == "hw" and vm.count("debug_raw_data")){
+        throw std::runtime_error("debug_raw_data needs the samples, measure on the host");
+    }
+    if (which.empty() or which.find_first_not_of("AB") != std::string::npos){
+        throw std::runtime_error("Unknown chain: " + which);
+    }
+    opts.verbose = vm.count("verbose");
+    opts.single_test = vm.count("single_test") != 0;
+    opts.debug_raw_data = vm.count("debug_raw_data") != 0;
 
-    //create a receive streamer
-    uhd::stream_args_t stream_args("fc32"); //complex floats
-    uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+    // Create a USRP device, one channel per chain
+    uhd::usrp::multi_usrp::sptr usrp = setup_usrp_for_cal(args, which, serial, vga1_gain, vga2_gain, rx_gain, opts.verbose);
 
-    //create a transmitter thread
+    //create a transmitter thread per chain
     std::atomic<bool> interrupted(false);
     boost::thread_group threads;
-    threads.create_thread(boost::bind(&tx_thread, usrp, tx_wave_freq, tx_wave_ampl, boost::ref(interrupted)));
-
-    //store the results here
-    std::vector<result_t> results;
-
-    uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
-    const uhd::fs_path tx_fe_path = "/mboards/0/dboards/"+which+"/tx_frontends/0";
-    uhd::property<uint8_t> &dc_i_prop = tree->access<uint8_t>(tx_fe_path / "lms6002d/tx_dc_i/value");
-    uhd::property<uint8_t> &dc_q_prop = tree->access<uint8_t>(tx_fe_path / "lms6002d/tx_dc_q/value");
+    for (size_t chan = 0; chan < which.size(); chan++){
+        threads.create_thread(boost::bind(&tx_thread, usrp, tx_wave_freq, tx_wave_ampl, boost::ref(interrupted), chan));
+    }
 
-    if (not vm.count("freq_start")) freq_start = usrp->get_tx_freq_range().start() + 50e6;
-    if (not vm.count("freq_stop")) freq_stop = usrp->get_tx_freq_range().stop() - 50e6;
+    if (not vm.count("freq_start")) opts.freq_start = usrp->get_tx_freq_range().start() + 50e6;
+    if (not vm.count("freq_stop")) opts.freq_stop = usrp->get_tx_freq_range().stop() - 50e6;
     UHD_MSG(status) << boost::format("Calibration frequency type: DC offset") << std::endl;
-    UHD_MSG(status) << boost::format("Calibration frequency range: %d MHz -> %d MHz") % (freq_start/1e6) % (freq_stop/1e6) << std::endl;
-
-    for (double tx_lo_i = freq_start; tx_lo_i <= freq_stop; tx_lo_i += freq_step){
-        const double tx_lo = tune_rx_and_tx(usrp, tx_lo_i, rx_offset);
-
-        //frequency constants for this tune event
-        const double actual_rx_rate = usrp->get_rx_rate();
-        const double actual_tx_freq = usrp->get_tx_freq();
-        const double actual_rx_freq = usrp->get_rx_freq();
-        const double bb_dc_freq = actual_tx_freq - actual_rx_freq;
-        if (verbose) printf("actual_rx_rate = %0.2f MHz\n", actual_rx_rate/1e6);
-        if (verbose) printf("actual_tx_freq = %0.2f MHz\n", actual_tx_freq/1e6);
-        if (verbose) printf("actual_rx_freq = %0.2f MHz\n", actual_rx_freq/1e6);
-        if (verbose) printf("bb_dc_freq = %0.2f MHz\n", bb_dc_freq/1e6);
-
-        for (size_t trial_no = 0; trial_no < ntrials; trial_no++)
-        {
-            if (vm.count("single_test"))
-            {
-                dc_cal_t dc_cal(dc_i_prop, dc_q_prop,
-                                rx_stream,
-                                nsamps,
-                                bb_dc_freq,
-                                actual_rx_rate,
-                                verbose,
-                                vm.count("debug_raw_data"),
-                                single_test_i, single_test_q);
-
-                const double dc_dbrms = dc_cal.init();;
-                printf("I = %d Q = %d ", single_test_i, single_test_q);
-                printf("dc_dbrms = %2.1f dB\n", dc_dbrms);
-            } else {
-                dc_cal_t dc_cal(dc_i_prop, dc_q_prop,
-                                rx_stream,
-                                nsamps,
-                                bb_dc_freq,
-                                actual_rx_rate,
-                                verbose,
-                                vm.count("debug_raw_data"));
-                // Perform normal calibration
-                results.push_back(calibrate_downhill(dc_cal, tx_lo, verbose));
-            }
-        }
+    UHD_MSG(status) << boost::format("Calibration frequency range: %d MHz -> %d MHz") % (opts.freq_start/1e6) % (opts.freq_stop/1e6) << std::endl;
+
+    //the chains only share the control path, so their sweeps run side by side
+    //and the tune settle of one overlaps the captures of the other
+    std::vector<std::vector<result_t> > results(which.size());
+    std::vector<std::string> errors(which.size());
+    boost::thread_group cal_threads;
+    for (size_t chan = 0; chan < which.size(); chan++){
+        const std::string side(1, which[chan]);
+        const std::string prefix = (which.size() > 1)? "[" + side + "] " : "";
+        cal_threads.create_thread(boost::bind(&calibrate_side, usrp, side, chan, prefix, boost::cref(opts),
+            boost::ref(results[chan]), boost::ref(errors[chan])));
     }
+    cal_threads.join_all();
     std::cout << std::endl;
 
     //stop the transmitter
     interrupted = true;
     threads.join_all();
 
-    if (not vm.count("single_test"))
-        store_results(usrp, results, "tx", "dc", vm.count("append"));
+    for (size_t chan = 0; chan < which.size(); chan++){
+        if (not errors[chan].empty()) throw std::runtime_error(std::string(1, which[chan]) + ": " + errors[chan]);
+    }
+
+    if (not vm.count("single_test")){
+        for (size_t chan = 0; chan < which.size(); chan++){
+            store_results(usrp, results[chan], "tx", "dc", vm.count("append"), chan);
+        }
+    }
 
     return EXIT_SUCCESS;
 }
@@ -16,31 +16,125 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
-#include "usrp_cal_utils.hpp"
+#include "umtrx_cal_search.hpp"
 #include <uhd/utils/safe_main.hpp>
 #include <boost/ref.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/program_options.hpp>
 #include <boost/math/special_functions/round.hpp>
+#include <boost/foreach.hpp>
 #include <iostream>
 #include <complex>
 #include <ctime>
 #include <cstdlib>
+#include <deque>
+#include <map>
 
 namespace po = boost::program_options;
 
-static const size_t num_search_steps = 5;
-static const size_t num_search_iters = 7;
+/***********************************************************************
+ * IQ balance of one LO
+ **********************************************************************/
+class iq_cal_t{
+public:
+    iq_cal_t(uhd::usrp::multi_usrp::sptr usrp, uhd::rx_streamer::sptr rx_stream,
+             uhd::property<std::complex<double> > &iq_prop,
+             const double tx_wave_freq, const double rx_offset,
+             const size_t nsamps, const double tone_tolerance, const int verbose,
+             hw_tone_meter *tone_meter = NULL):
+        _usrp(usrp), _rx_stream(rx_stream), _iq_prop(iq_prop),
+        _tx_wave_freq(tx_wave_freq), _rx_offset(rx_offset),
+        _nsamps(nsamps), _tone_tolerance(tone_tolerance), _verbose(verbose),
+        _tone_meter(tone_meter), _bb_tone_freq(0.0), _bb_imag_freq(0.0)
+    {}
+
+    //! Search the best correction at an LO, false when the result is not trustworthy
+    bool calibrate(const double tx_lo_i, result_t &result){
+        const double tx_lo = this->tune(tx_lo_i);
+
+        //capture initial uncorrected value
+        const double initial_suppression = this->measure(0.0);
+
+        double best_suppression = 0;
+        const std::complex<double> best_correction = calibrate_iq_balance(_iq_prop, _rx_stream, _buff, _detectors,
+            _nsamps, _tone_tolerance, best_suppression, _verbose, _tone_meter, _bb_tone_freq, _bb_imag_freq);
+
+        result.freq = tx_lo;
+        result.real_corr = best_correction.real();
+        result.imag_corr = best_correction.imag();
+        result.best = best_suppression;
+        result.delta = best_suppression - initial_suppression;
+        if (_verbose){
+            std::cout << boost::format("TX IQ: %f MHz: best suppression %f dB, corrected %f dB") % (tx_lo/1e6) % result.best % result.delta << std::endl;
+        }
+        return best_suppression > 30; //most likely valid
+    }
+
+    //! Suppression at an LO with a given correction, tunes first
+    double check(const double tx_lo_i, const std::complex<double> &correction){
+        this->tune(tx_lo_i);
+        return this->measure(correction);
+    }
+
+private:
+    double tune(const double tx_lo_i){
+        const double tx_lo = tune_rx_and_tx(_usrp, tx_lo_i, _rx_offset);
+
+        //frequency constants for this tune event
+        const double actual_rx_rate = _usrp->get_rx_rate();
+        const double actual_tx_freq = _usrp->get_tx_freq();
+        const double actual_rx_freq = _usrp->get_rx_freq();
+        _bb_tone_freq = actual_tx_freq + _tx_wave_freq - actual_rx_freq;
+        _bb_imag_freq = actual_tx_freq - _tx_wave_freq - actual_rx_freq;
+        _detectors[0] = tone_detector(_bb_tone_freq/actual_rx_rate);
+        _detectors[1] = tone_detector(_bb_imag_freq/actual_rx_rate);
+        return tx_lo;
+    }
+
+    double measure(const std::complex<double> &correction){
+        _iq_prop.set(correction);
+        if (_tone_meter != NULL){
+            const double tone_dbrms = _tone_meter->dbrms(_bb_tone_freq);
+            return tone_dbrms - _tone_meter->dbrms(_bb_imag_freq);
+        }
+        capture_tones(_rx_stream, _buff, _detectors, 2, _nsamps, _tone_tolerance);
+        return _detectors[0].dbrms() - _detectors[1].dbrms();
+    }
+
+    uhd::usrp::multi_usrp::sptr _usrp;
+    uhd::rx_streamer::sptr _rx_stream;
+    uhd::property<std::complex<double> > &_iq_prop;
+    const double _tx_wave_freq, _rx_offset;
+    const size_t _nsamps;
+    const double _tone_tolerance;
+    const int _verbose;
+    hw_tone_meter *_tone_meter; //NULL streams the samples
+    double _bb_tone_freq, _bb_imag_freq;
+    std::vector<samp_type> _buff; //re-usable buffer for samples
+    tone_detector _detectors[2]; //the tone and its image
+};
+
+//! The correction at freq as the cal table loader interpolates it between a and b
+static std::complex<double> interp_correction(const result_t &a, const result_t &b, const double freq)
+{
+    const double x = (freq - a.freq)/(b.freq - a.freq);
+    return std::complex<double>(
+        a.real_corr + x*(b.real_corr - a.real_corr),
+        a.imag_corr + x*(b.imag_corr - a.imag_corr));
+}
 
 /***********************************************************************
  * Main
  **********************************************************************/
 int UHD_SAFE_MAIN(int argc, char *argv[]){
-    std::string args, which, serial;
+    std::string args, which, serial, measure;
     int verbose;
     int vga1_gain, vga2_gain, rx_gain;
     double tx_wave_freq, tx_wave_ampl, rx_offset;
     double freq_start, freq_stop, freq_step;
     size_t nsamps;
+    double tone_tolerance;
+    double coarse_step, adaptive_threshold;
 
     po::options_description desc("Allowed options");
     desc.add_options()
@@ -48,6 +142,7 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         ("verbose", "enable some verbose")
         ("args", po::value<std::string>(&args)->default_value(""), "device address args [default = \"\"]")
         ("which", po::value<std::string>(&which)->default_value("A"), "Which chain A or B?")
+        ("measure", po::value<std::string>(&measure)->default_value("host"), "Tone measurement: host (stream the samples) or hw (FPGA tone meter, no streaming)")
         ("vga1", po::value<int>(&vga1_gain)->default_value(-20), "LMS6002D Tx VGA1 gain [-35 to -4]")
         ("vga2", po::value<int>(&vga2_gain)->default_value(22), "LMS6002D Tx VGA2 gain [0 to 25]")
         ("rx_gain", po::value<int>(&rx_gain)->default_value(50), "LMS6002D Rx combined gain [0 to 156]")
@@ -58,6 +153,10 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         ("freq_stop", po::value<double>(&freq_stop), "Frequency stop in Hz (do not specify for default)")
         ("freq_step", po::value<double>(&freq_step)->default_value(default_freq_step), "Step size for LO sweep in Hz")
         ("nsamps", po::value<size_t>(&nsamps)->default_value(default_num_samps), "Samples per data capture")
+        ("tone_tolerance", po::value<double>(&tone_tolerance)->default_value(0.0), "Stop a capture early once both tone levels are known within this many dB [default = 0, full nsamps]")
+        ("adaptive", "Search a coarse LO grid and only add points where the interpolated correction falls short")
+        ("coarse_step", po::value<double>(&coarse_step)->default_value(10e6), "Only in the adaptive mode! Coarse LO step in Hz")
+        ("adaptive_threshold", po::value<double>(&adaptive_threshold)->default_value(40.0), "Only in the adaptive mode! Least image suppression in dB between points")
         ("append", "Append measurements to the calibratoin file instead of rewriting [default=overwrite]")
     ;
 
@@ -75,6 +174,9 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
     }
 
     verbose = vm.count("verbose");
+    if (measure != "host" and measure != "hw"){
+        throw std::runtime_error("Unknown measurement: " + measure);
+    }
 
     // Create a USRP device
     uhd::usrp::multi_usrp::sptr usrp = setup_usrp_for_cal(args, which, serial, vga1_gain, vga2_gain, rx_gain, verbose);
@@ -86,10 +188,7 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
     //create a transmitter thread
     std::atomic<bool> interrupted(false);
     boost::thread_group threads;
-    threads.create_thread(boost::bind(&tx_thread, usrp, tx_wave_freq, tx_wave_ampl, boost::ref(interrupted)));
-
-    //re-usable buffer for samples
-    std::vector<samp_type> buff;
+    threads.create_thread(boost::bind(&tx_thread, usrp, tx_wave_freq, tx_wave_ampl, boost::ref(interrupted), 0));
 
     //store the results here
     std::vector<result_t> results;
@@ -97,84 +196,69 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
     uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
     const uhd::fs_path tx_fe_path = "/mboards/0/tx_frontends/"+which;
     uhd::property<std::complex<double> > &iq_prop = tree->access<std::complex<double> >(tx_fe_path / "iq_balance" / "value");
+    boost::scoped_ptr<hw_tone_meter> tone_meter;
+    if (measure == "hw") tone_meter.reset(new hw_tone_meter(usrp, 0, nsamps));
+    iq_cal_t iq_cal(usrp, rx_stream, iq_prop, tx_wave_freq, rx_offset, nsamps, tone_tolerance, verbose, tone_meter.get());
 
     if (not vm.count("freq_start")) freq_start = usrp->get_tx_freq_range().start() + 50e6;
     if (not vm.count("freq_stop")) freq_stop = usrp->get_tx_freq_range().stop() - 50e6;
     UHD_MSG(status) << boost::format("Calibration frequency type: IQ balance") << std::endl;
     UHD_MSG(status) << boost::format("Calibration frequency range: %d MHz -> %d MHz") % (freq_start/1e6) % (freq_stop/1e6) << std::endl;
 
-    for (double tx_lo_i = freq_start; tx_lo_i <= freq_stop; tx_lo_i += freq_step){
-        const double tx_lo = tune_rx_and_tx(usrp, tx_lo_i, rx_offset);
-
-        //frequency constants for this tune event
-        const double actual_rx_rate = usrp->get_rx_rate();
-        const double actual_tx_freq = usrp->get_tx_freq();
-        const double actual_rx_freq = usrp->get_rx_freq();
-        const double bb_tone_freq = actual_tx_freq + tx_wave_freq - actual_rx_freq;
-        const double bb_imag_freq = actual_tx_freq - tx_wave_freq - actual_rx_freq;
-
-        //capture initial uncorrected value
-        iq_prop.set(0.0);
-        capture_samples(rx_stream, buff, nsamps);
-        const double initial_suppression = compute_tone_dbrms(buff, bb_tone_freq/actual_rx_rate) - compute_tone_dbrms(buff, bb_imag_freq/actual_rx_rate);
-
-        //bounds and results from searching
-        std::complex<double> best_correction;
-        double phase_corr_start = -.3, phase_corr_stop = .3, phase_corr_step;
-        double ampl_corr_start = -.3, ampl_corr_stop = .3, ampl_corr_step;
-        double best_suppression = 0, best_phase_corr = 0, best_ampl_corr = 0;
-
-        for (size_t i = 0; i < num_search_iters; i++){
-
-            phase_corr_step = (phase_corr_stop - phase_corr_start)/(num_search_steps-1);
-            ampl_corr_step = (ampl_corr_stop - ampl_corr_start)/(num_search_steps-1);
-
-            for (double phase_corr = phase_corr_start; phase_corr <= phase_corr_stop + phase_corr_step/2; phase_corr += phase_corr_step){
-            for (double ampl_corr = ampl_corr_start; ampl_corr <= ampl_corr_stop + ampl_corr_step/2; ampl_corr += ampl_corr_step){
-
-                const std::complex<double> correction(ampl_corr, phase_corr);
-                iq_prop.set(correction);
-
-                //receive some samples
-                capture_samples(rx_stream, buff, nsamps);
-
-                const double tone_dbrms = compute_tone_dbrms(buff, bb_tone_freq/actual_rx_rate);
-                const double imag_dbrms = compute_tone_dbrms(buff, bb_imag_freq/actual_rx_rate);
-                const double suppression = tone_dbrms - imag_dbrms;
-
-                if (suppression > best_suppression){
-                    best_correction = correction;
-                    best_suppression = suppression;
-                    best_phase_corr = phase_corr;
-                    best_ampl_corr = ampl_corr;
-                }
-
-            }}
-
-            if (verbose) std::cout << "best_phase_corr " << best_phase_corr << std::endl;
-            if (verbose) std::cout << "best_ampl_corr " << best_ampl_corr << std::endl;
-            if (verbose) std::cout << "best_suppression " << best_suppression << std::endl;
+    if (not vm.count("adaptive")){
+        for (double tx_lo_i = freq_start; tx_lo_i <= freq_stop; tx_lo_i += freq_step){
+            result_t result;
+            if (iq_cal.calibrate(tx_lo_i, result)){
+                results.push_back(result);
+                if (not verbose) std::cout << "." << std::flush;
+            }
+        }
+    }
+    else{
+        //search the coarse grid, the band edges always included
+        std::map<double, result_t> found;
+        std::vector<double> coarse;
+        for (double tx_lo_i = freq_start; tx_lo_i < freq_stop; tx_lo_i += coarse_step) coarse.push_back(tx_lo_i);
+        coarse.push_back(freq_stop);
+        BOOST_FOREACH(const double tx_lo_i, coarse){
+            result_t result;
+            if (iq_cal.calibrate(tx_lo_i, result)) found[tx_lo_i] = result;
+            if (not verbose) std::cout << "." << std::flush;
+        }
 
-            phase_corr_start = best_phase_corr - phase_corr_step;
-            phase_corr_stop = best_phase_corr + phase_corr_step;
-            ampl_corr_start = best_ampl_corr - ampl_corr_step;
-            ampl_corr_stop = best_ampl_corr + ampl_corr_step;
+        //check the middle of each interval with the interpolated correction,
+        //where the image comes back search the middle and split the interval
+        std::deque<std::pair<double, double> > intervals;
+        for (std::map<double, result_t>::const_iterator it = found.begin(); it != found.end(); ++it){
+            std::map<double, result_t>::const_iterator next = it; ++next;
+            if (next != found.end()) intervals.push_back(std::make_pair(it->first, next->first));
         }
+        size_t num_checked = 0, num_added = 0;
+        while (not intervals.empty()){
+            const double lo = intervals.front().first, hi = intervals.front().second;
+            intervals.pop_front();
+            if (hi - lo < 2*freq_step) continue; //as dense as a full sweep
+
+            const double mid = (lo + hi)/2;
+            const std::complex<double> correction = interp_correction(found[lo], found[hi], mid);
+            const double suppression = iq_cal.check(mid, correction);
+            num_checked++;
+            if (verbose) std::cout << boost::format("TX IQ: %f MHz: interpolated suppression %f dB") % (mid/1e6) % suppression << std::endl;
+            if (suppression >= adaptive_threshold) continue;
 
-        if (best_suppression > 30){ //most likely valid, keep result
             result_t result;
-            result.freq = tx_lo;
-            result.real_corr = best_correction.real();
-            result.imag_corr = best_correction.imag();
-            result.best = best_suppression;
-            result.delta = best_suppression - initial_suppression;
-            results.push_back(result);
-            if (verbose){
-                std::cout << boost::format("TX IQ: %f MHz: best suppression %f dB, corrected %f dB") % (tx_lo/1e6) % result.best % result.delta << std::endl;
-            }
-            else std::cout << "." << std::flush;
+            if (not iq_cal.calibrate(mid, result)) continue;
+            found[mid] = result;
+            num_added++;
+            intervals.push_back(std::make_pair(lo, mid));
+            intervals.push_back(std::make_pair(mid, hi));
+            if (not verbose) std::cout << "+" << std::flush;
         }
-
+        for (std::map<double, result_t>::const_iterator it = found.begin(); it != found.end(); ++it){
+            results.push_back(it->second);
+        }
+        std::cout << std::endl;
+        UHD_MSG(status) << boost::format("Adaptive sweep: %u coarse points, %u checked, %u added") % coarse.size() % num_checked % num_added << std::endl;
     }
     std::cout << std::endl;
 
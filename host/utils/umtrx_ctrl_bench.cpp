@@ -0,0 +1,396 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_iface.hpp"
+#include "umtrx_fifo_ctrl.hpp"
+#include "umtrx_regs.hpp"
+#include "usrp2/fw_common.h"
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/exception.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/assign/list_of.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/chrono.hpp>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+namespace po = boost::program_options;
+namespace pt = boost::posix_time;
+
+/*!
+ * Control plane benchmark.
+ *
+ * Times single operations on both control paths of the UmTRX:
+ *  - the FIFO ctrl (settings FIFO over the ctrl framer), per window size,
+ *    which carries the LMS SPI and the timed register writes
+ *  - the UDP iface (firmware request/response), which carries the
+ *    firmware registers and I2C
+ * Latency is the round trip of one operation, throughput the rate of
+ * back to back operations with the window kept full.
+ *
+ * Every write puts back a value that is harmless for a running device:
+ * the unused debug mux, a read only LMS register, the lock owner and the
+ * EEPROM address pointer.
+ *
+ * With --load the timings are taken while RX and/or TX stream on both
+ * channels, which shows what the control lane of the router buys under
+ * data traffic (FPGA 9.18 and later).
+ */
+
+typedef boost::chrono::steady_clock bench_clock;
+
+static double elapsed_us(const bench_clock::time_point &start)
+{
+    return boost::chrono::duration_cast<boost::chrono::nanoseconds>(bench_clock::now() - start).count()/1e3;
+}
+
+static const int LMS_TEST_REG = 0x04; //chip version, read only
+
+/***********************************************************************
+ * Latency samples of one operation
+ **********************************************************************/
+struct op_result_t
+{
+    op_result_t(const std::string &name, const size_t window):
+        name(name), window(window), ops_per_sec(0)
+    {}
+
+    double percentile(const double p) const
+    {
+        if (samples.empty()) return 0;
+        const size_t i = std::min(samples.size()-1, size_t(p*samples.size()));
+        return samples[i];
+    }
+
+    boost::property_tree::ptree to_ptree(void) const
+    {
+        boost::property_tree::ptree result;
+        result.put("op", name);
+        if (window) result.put("window", window);
+        result.put("samples", samples.size());
+        result.put("p50_us", percentile(0.50));
+        result.put("p99_us", percentile(0.99));
+        result.put("max_us", samples.empty()? 0 : samples.back());
+        result.put("ops_per_sec", ops_per_sec);
+        return result;
+    }
+
+    void print(void) const
+    {
+        std::cout << boost::format("%-22s %6s %9.1f %9.1f %9.1f %12.0f")
+            % name % (window? boost::lexical_cast<std::string>(window) : std::string("-"))
+            % percentile(0.50) % percentile(0.99) % (samples.empty()? 0 : samples.back()) % ops_per_sec << std::endl;
+    }
+
+    std::string name;
+    size_t window;
+    std::vector<double> samples; //us, sorted once complete
+    double ops_per_sec;
+};
+
+//! time iters calls of op one by one, then iters back to back calls followed by sync
+template <typename Op, typename Sync>
+static op_result_t bench_op(const std::string &name, const size_t window, const size_t iters, Op op, Sync sync)
+{
+    op_result_t result(name, window);
+    result.samples.reserve(iters);
+    for (size_t i = 0; i < iters; i++)
+    {
+        const bench_clock::time_point start = bench_clock::now();
+        op(); sync();
+        result.samples.push_back(elapsed_us(start));
+    }
+    std::sort(result.samples.begin(), result.samples.end());
+
+    const bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < iters; i++) op();
+    sync();
+    result.ops_per_sec = iters/(elapsed_us(start)/1e6);
+    result.print();
+    return result;
+}
+
+static void no_sync(void){}
+
+/***********************************************************************
+ * Streaming load on both channels while the operations are timed
+ **********************************************************************/
+class stream_load_t
+{
+public:
+    stream_load_t(uhd::usrp::multi_usrp::sptr usrp, const std::string &mode, const double rate):
+        _stop(false)
+    {
+        if (mode == "none") return;
+        uhd::stream_args_t stream_args("sc16", "sc16");
+        for (size_t i = 0; i < usrp->get_rx_num_channels(); i++) stream_args.channels.push_back(i);
+        if (mode == "rx" or mode == "both")
+        {
+            usrp->set_rx_rate(rate);
+            _rx_stream = usrp->get_rx_stream(stream_args);
+            _rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+            _threads.create_thread(boost::bind(&stream_load_t::rx_loop, this));
+        }
+        if (mode == "tx" or mode == "both")
+        {
+            usrp->set_tx_rate(rate);
+            _tx_stream = usrp->get_tx_stream(stream_args);
+            _threads.create_thread(boost::bind(&stream_load_t::tx_loop, this));
+        }
+        boost::this_thread::sleep(pt::milliseconds(200)); //let the streams settle
+    }
+
+    ~stream_load_t(void)
+    {
+        if (_rx_stream) _rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+        _stop = true;
+        _threads.join_all();
+    }
+
+private:
+    void rx_loop(void)
+    {
+        const size_t spp = _rx_stream->get_max_num_samps();
+        std::vector<std::vector<boost::uint32_t> > buffs(_rx_stream->get_num_channels(), std::vector<boost::uint32_t>(spp));
+        std::vector<void *> buff_ptrs;
+        for (size_t i = 0; i < buffs.size(); i++) buff_ptrs.push_back(&buffs[i].front());
+        uhd::rx_metadata_t md;
+        while (not _stop) _rx_stream->recv(buff_ptrs, spp, md, 0.2);
+    }
+
+    void tx_loop(void)
+    {
+        const size_t spp = _tx_stream->get_max_num_samps();
+        std::vector<boost::uint32_t> buff(spp);
+        std::vector<const void *> buff_ptrs(_tx_stream->get_num_channels(), &buff.front());
+        uhd::tx_metadata_t md;
+        md.start_of_burst = true;
+        while (not _stop)
+        {
+            _tx_stream->send(buff_ptrs, spp, md, 1.0);
+            md.start_of_burst = false;
+        }
+        md.end_of_burst = true;
+        _tx_stream->send("", 0, md);
+    }
+
+    boost::atomic<bool> _stop;
+    uhd::rx_streamer::sptr _rx_stream;
+    uhd::tx_streamer::sptr _tx_stream;
+    boost::thread_group _threads;
+};
+
+/***********************************************************************
+ * FIFO ctrl operations
+ **********************************************************************/
+struct fifo_ops_t
+{
+    fifo_ops_t(umtrx_fifo_ctrl::sptr ctrl, const size_t burst):
+        ctrl(ctrl), config(uhd::spi_config_t::EDGE_RISE)
+    {
+        umtrx_fifo_ctrl::spi_transaction_t read;
+        read.which_slave = SPI_SS_LMS1;
+        read.config = config;
+        read.data = LMS_TEST_REG << 8;
+        read.num_bits = 16;
+        read.readback = true;
+        reads.resize(burst, read);
+    }
+
+    void poke32(void){ctrl->poke32(U2_REG_MISC_CTRL_DBG_MUX, 0);}
+    void peek32(void){ctrl->peek32(U2_REG_COMPAT_NUM_RB);}
+    void peek32_async(void){futures.push_back(ctrl->peek32_async(U2_REG_COMPAT_NUM_RB));}
+    void write_spi(void){ctrl->write_spi(SPI_SS_LMS1, config, ((0x80 | LMS_TEST_REG) << 8) | 0x00, 16);}
+    void read_spi(void){ctrl->read_spi(SPI_SS_LMS1, config, LMS_TEST_REG << 8, 16);}
+    void spi_burst(void){ctrl->transact_spi_burst(reads);}
+    void flush(void){ctrl->flush();}
+    void collect(void)
+    {
+        BOOST_FOREACH(umtrx_fifo_ctrl::peek_future::sptr future, futures) future->get();
+        futures.clear();
+    }
+
+    umtrx_fifo_ctrl::sptr ctrl;
+    uhd::spi_config_t config;
+    std::vector<umtrx_fifo_ctrl::spi_transaction_t> reads;
+    std::vector<umtrx_fifo_ctrl::peek_future::sptr> futures;
+};
+
+static void bench_fifo_ctrl(umtrx_fifo_ctrl::sptr ctrl, const size_t window, const size_t iters,
+    const size_t burst, boost::property_tree::ptree &results)
+{
+    fifo_ops_t ops(ctrl, burst);
+    std::vector<op_result_t> runs;
+    runs.push_back(bench_op("fifo poke32", window, iters,
+        boost::bind(&fifo_ops_t::poke32, &ops), boost::bind(&fifo_ops_t::flush, &ops)));
+    runs.push_back(bench_op("fifo peek32", window, iters,
+        boost::bind(&fifo_ops_t::peek32, &ops), no_sync));
+    runs.push_back(bench_op("fifo peek32_async", window, iters,
+        boost::bind(&fifo_ops_t::peek32_async, &ops), boost::bind(&fifo_ops_t::collect, &ops)));
+    runs.push_back(bench_op("fifo write_spi", window, iters,
+        boost::bind(&fifo_ops_t::write_spi, &ops), boost::bind(&fifo_ops_t::flush, &ops)));
+    runs.push_back(bench_op("fifo read_spi", window, iters,
+        boost::bind(&fifo_ops_t::read_spi, &ops), no_sync));
+    op_result_t burst_run = bench_op(str(boost::format("fifo spi_burst x%u") % burst), window, iters/burst + 1,
+        boost::bind(&fifo_ops_t::spi_burst, &ops), no_sync);
+    burst_run.ops_per_sec *= burst; //per transaction
+    runs.push_back(burst_run);
+    BOOST_FOREACH(const op_result_t &run, runs) results.push_back(std::make_pair("", run.to_ptree()));
+}
+
+/***********************************************************************
+ * UDP iface operations
+ **********************************************************************/
+struct iface_ops_t
+{
+    iface_ops_t(umtrx_iface::sptr iface, const boost::uint16_t i2c_addr):
+        iface(iface), i2c_addr(i2c_addr),
+        gpid(iface->peekfw(U2_FW_REG_LOCK_GPID))
+    {}
+
+    void peek32(void){iface->peek32(U2_REG_COMPAT_NUM_RB);}
+    void poke32(void){iface->poke32(U2_REG_MISC_CTRL_DBG_MUX, 0);}
+    void peekfw(void){iface->peekfw(U2_FW_REG_VER_MINOR);}
+    void pokefw(void){iface->pokefw(U2_FW_REG_LOCK_GPID, gpid);}
+    void write_i2c(void){iface->write_i2c(i2c_addr, boost::assign::list_of(0));}
+    void read_i2c(void){iface->read_i2c(i2c_addr, 1);}
+
+    umtrx_iface::sptr iface;
+    const boost::uint16_t i2c_addr;
+    const boost::uint32_t gpid;
+};
+
+static void bench_iface(umtrx_iface::sptr iface, const size_t iters, const boost::uint16_t i2c_addr,
+    boost::property_tree::ptree &results)
+{
+    iface_ops_t ops(iface, i2c_addr);
+    std::vector<op_result_t> runs;
+    runs.push_back(bench_op("udp peek32", 0, iters, boost::bind(&iface_ops_t::peek32, &ops), no_sync));
+    runs.push_back(bench_op("udp poke32", 0, iters, boost::bind(&iface_ops_t::poke32, &ops), no_sync));
+    runs.push_back(bench_op("udp peekfw", 0, iters, boost::bind(&iface_ops_t::peekfw, &ops), no_sync));
+    runs.push_back(bench_op("udp pokefw", 0, iters, boost::bind(&iface_ops_t::pokefw, &ops), no_sync));
+    runs.push_back(bench_op("i2c write", 0, iters, boost::bind(&iface_ops_t::write_i2c, &ops), no_sync));
+    runs.push_back(bench_op("i2c read", 0, iters, boost::bind(&iface_ops_t::read_i2c, &ops), no_sync));
+    BOOST_FOREACH(const op_result_t &run, runs) results.push_back(std::make_pair("", run.to_ptree()));
+}
+
+static std::vector<size_t> parse_windows(const std::string &list)
+{
+    std::vector<std::string> tokens;
+    boost::split(tokens, list, boost::is_any_of(", "), boost::token_compress_on);
+    std::vector<size_t> windows;
+    BOOST_FOREACH(const std::string &token, tokens)
+    {
+        if (not token.empty()) windows.push_back(boost::lexical_cast<size_t>(token));
+    }
+    return windows;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    std::string args, windows_list, json_file, load;
+    size_t iters, burst;
+    double load_rate;
+    unsigned i2c_addr;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help,h", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "device address args [default = \"\"]")
+        ("windows", po::value<std::string>(&windows_list)->default_value("1,4,16,64,1024"), "FIFO ctrl window sizes to run, the device is reopened for each")
+        ("iters", po::value<size_t>(&iters)->default_value(2000), "operations per measurement")
+        ("burst", po::value<size_t>(&burst)->default_value(32), "SPI transactions per transact_spi_burst")
+        ("i2c-addr", po::value<unsigned>(&i2c_addr)->default_value(USRP2_I2C_ADDR_MBOARD), "I2C device to read, the mboard EEPROM by default")
+        ("load", po::value<std::string>(&load)->default_value("none"), "stream on both channels while timing: none, rx, tx or both")
+        ("load-rate", po::value<double>(&load_rate)->default_value(6.5e6), "sample rate of the load streams")
+        ("json", po::value<std::string>(&json_file)->default_value(""), "write the results as JSON to this file, - for stdout")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX control plane benchmark %s") % desc << std::endl;
+        return ~0;
+    }
+    UHD_ASSERT_THROW(iters > 0 and burst > 0);
+    if (load != "none" and load != "rx" and load != "tx" and load != "both")
+    {
+        throw std::runtime_error("--load must be none, rx, tx or both");
+    }
+
+    boost::property_tree::ptree results;
+    std::string device_name, fpga_version;
+    std::cout << boost::format("%-22s %6s %9s %9s %9s %12s")
+        % "operation" % "window" % "p50 us" % "p99 us" % "max us" % "ops/s" << std::endl;
+
+    const std::vector<size_t> windows = parse_windows(windows_list);
+    for (size_t i = 0; i < windows.size(); i++)
+    {
+        //the window is fixed when the FIFO ctrl is made, so reopen the device
+        const std::string dev_args = str(boost::format("%s%sfifo_ctrl_window=%u")
+            % args % (args.empty()? "" : ",") % windows[i]);
+        uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(dev_args);
+        uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
+        const uhd::fs_path mb_path = "/mboards/0";
+        device_name = usrp->get_mboard_name();
+        fpga_version = tree->access<std::string>(mb_path / "fpga_version").get();
+        stream_load_t stream_load(usrp, load, load_rate);
+
+        bench_fifo_ctrl(tree->access<umtrx_fifo_ctrl::sptr>(mb_path / "fifo_ctrl").get(),
+            windows[i], iters, burst, results);
+
+        //the UDP iface has no window, run it once
+        if (i == 0) bench_iface(tree->access<umtrx_iface::sptr>(mb_path / "umtrx_iface").get(),
+            iters, boost::uint16_t(i2c_addr), results);
+    }
+
+    if (not json_file.empty())
+    {
+        boost::property_tree::ptree doc;
+        doc.put("device", device_name);
+        doc.put("time", pt::to_iso_extended_string(pt::second_clock::universal_time()));
+        doc.put("fpga_version", fpga_version);
+        doc.put("iters", iters);
+        doc.put("load", load);
+        if (load != "none") doc.put("load_rate", load_rate);
+        doc.add_child("results", results);
+        if (json_file == "-") boost::property_tree::write_json(std::cout, doc);
+        else
+        {
+            std::ofstream out(json_file.c_str());
+            boost::property_tree::write_json(out, doc);
+        }
+    }
+
+    std::cout << std::endl << "Done!" << std::endl << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,436 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/exception.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/assign/list_of.hpp>
+#include <boost/format.hpp>
+#include <boost/chrono.hpp>
+#include <boost/math/constants/constants.hpp>
+#include <algorithm>
+#include <complex>
+#include <iostream>
+#include <fstream>
+
+namespace po = boost::program_options;
+namespace pt = boost::posix_time;
+
+/*!
+ * Retune cost benchmark.
+ *
+ * Runs a sequence of hops per operation and times each:
+ *  - wall: the host time the call takes
+ *  - settle: the device time from the command until the RX stream shows
+ *    a stable tone at the frequency the hop should give, measured on
+ *    consecutive blocks with a phase difference estimator
+ *
+ * Operations, each alternating between two settings:
+ *  - rx_lms, tx_lms: tune the LMS PLL, the DSP stays at 0 Hz
+ *  - rx_cordic, tx_cordic: tune the DSP only, the LO stays
+ *  - rx_umsel: tune the UmSEL2 of front end A, open the device with
+ *    umsel=on and optionally umsel_pingpong=on
+ *  - rx_gain, tx_gain, rx_iq, rx_dc, tx_iq, tx_dc: wall time only
+ *
+ * The tone comes from TX channel 0 looped back into RX channel 0 by
+ * default, a constant between the two RX settings. With --tone-freq an
+ * external tone is used instead and the TX hops are timed wall only.
+ *
+ * With --timed the commands are timed --lead ahead and the settle time
+ * counts from the command time, which shows what timed hops buy.
+ */
+
+typedef boost::chrono::steady_clock bench_clock;
+
+static double elapsed_us(const bench_clock::time_point &start)
+{
+    return boost::chrono::duration_cast<boost::chrono::nanoseconds>(bench_clock::now() - start).count()/1e3;
+}
+
+/***********************************************************************
+ * Distribution of one measure
+ **********************************************************************/
+struct distribution_t
+{
+    double percentile(const double p) const
+    {
+        if (samples.empty()) return 0;
+        const size_t i = std::min(samples.size()-1, size_t(p*samples.size()));
+        return samples[i];
+    }
+
+    void sort(void)
+    {
+        std::sort(samples.begin(), samples.end());
+    }
+
+    void put(boost::property_tree::ptree &result, const std::string &name) const
+    {
+        result.put(name + "_p50_us", percentile(0.50));
+        result.put(name + "_p90_us", percentile(0.90));
+        result.put(name + "_p99_us", percentile(0.99));
+        result.put(name + "_max_us", samples.empty()? 0 : samples.back());
+    }
+
+    std::vector<double> samples; //us
+};
+
+struct hop_result_t
+{
+    hop_result_t(const std::string &name): name(name), unsettled(0) {}
+
+    void print(void) const
+    {
+        std::cout << boost::format("%-10s %9.1f %9.1f %9.1f")
+            % name % wall.percentile(0.50) % wall.percentile(0.99) % (wall.samples.empty()? 0 : wall.samples.back());
+        if (settle.samples.empty() and unsettled == 0) std::cout << "         -         -         -      -";
+        else std::cout << boost::format(" %9.1f %9.1f %9.1f %6u")
+            % settle.percentile(0.50) % settle.percentile(0.99) % (settle.samples.empty()? 0 : settle.samples.back()) % unsettled;
+        std::cout << std::endl;
+    }
+
+    boost::property_tree::ptree to_ptree(void) const
+    {
+        boost::property_tree::ptree result;
+        result.put("op", name);
+        result.put("hops", wall.samples.size());
+        wall.put(result, "wall");
+        if (not settle.samples.empty() or unsettled != 0)
+        {
+            settle.put(result, "settle");
+            result.put("unsettled", unsettled);
+        }
+        return result;
+    }
+
+    std::string name;
+    distribution_t wall, settle;
+    size_t unsettled; //hops without a stable tone before the timeout
+};
+
+/***********************************************************************
+ * Constant TX tone for the loopback
+ **********************************************************************/
+class tx_tone_t
+{
+public:
+    tx_tone_t(uhd::usrp::multi_usrp::sptr usrp, const double ampl):
+        _stop(false)
+    {
+        uhd::stream_args_t stream_args("fc32");
+        _tx_stream = usrp->get_tx_stream(stream_args);
+        _buff.assign(_tx_stream->get_max_num_samps(), std::complex<float>(float(ampl), 0));
+        _thread = boost::thread(boost::bind(&tx_tone_t::loop, this));
+    }
+
+    ~tx_tone_t(void)
+    {
+        _stop = true;
+        _thread.join();
+    }
+
+private:
+    void loop(void)
+    {
+        uhd::tx_metadata_t md;
+        md.start_of_burst = true;
+        while (not _stop)
+        {
+            _tx_stream->send(&_buff.front(), _buff.size(), md, 1.0);
+            md.start_of_burst = false;
+        }
+        md.end_of_burst = true;
+        _tx_stream->send("", 0, md);
+    }
+
+    boost::atomic<bool> _stop;
+    uhd::tx_streamer::sptr _tx_stream;
+    std::vector<std::complex<float> > _buff;
+    boost::thread _thread;
+};
+
+/***********************************************************************
+ * Settling on the RX stream
+ **********************************************************************/
+class settle_meter_t
+{
+public:
+    settle_meter_t(uhd::usrp::multi_usrp::sptr usrp, const double rate, const size_t block,
+        const size_t stable_blocks, const double tol, const double min_power):
+        _rate(rate), _block(block), _stable_blocks(stable_blocks), _tol(tol), _min_power(min_power),
+        _buff(block)
+    {
+        uhd::stream_args_t stream_args("fc32");
+        _rx_stream = usrp->get_rx_stream(stream_args);
+        _rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    }
+
+    ~settle_meter_t(void)
+    {
+        _rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    }
+
+    /*!
+     * Wait for the tone at offset from the RX center.
+     * \param since device time of the command
+     * \param timeout device seconds after since to give up
+     * \return the settle time in seconds, negative on a timeout
+     */
+    double measure(const uhd::time_spec_t &since, const double offset, const double timeout)
+    {
+        size_t stable = 0;
+        uhd::time_spec_t stable_since;
+        for (;;)
+        {
+            uhd::rx_metadata_t md;
+            const size_t n = _rx_stream->recv(&_buff.front(), _block, md, 1.0);
+            if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW) {stable = 0; continue;}
+            if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE) throw std::runtime_error(str(boost::format("Receive error code 0x%x") % int(md.error_code)));
+            if (n < 2 or md.time_spec < since) continue;
+            if ((md.time_spec - since).get_real_secs() > timeout) return -1;
+
+            std::complex<double> acc;
+            for (size_t i = 1; i < n; i++)
+            {
+                acc += std::complex<double>(_buff[i])*std::conj(std::complex<double>(_buff[i-1]));
+            }
+            const double freq = std::arg(acc)*_rate/(2*boost::math::constants::pi<double>());
+            const bool good = std::abs(acc)/(n-1) > _min_power and std::abs(freq - offset) < _tol;
+            if (not good) {stable = 0; continue;}
+            if (stable++ == 0) stable_since = md.time_spec;
+            if (stable == _stable_blocks) return (stable_since - since).get_real_secs();
+        }
+    }
+
+private:
+    const double _rate;
+    const size_t _block, _stable_blocks;
+    const double _tol, _min_power;
+    uhd::rx_streamer::sptr _rx_stream;
+    std::vector<std::complex<float> > _buff;
+};
+
+/***********************************************************************
+ * The hops
+ **********************************************************************/
+struct hop_config_t
+{
+    double freq, step, lead, timeout;
+    double gain_a, gain_b;
+    bool timed, loopback;
+    double tone_freq; //external tone, without loopback
+};
+
+static uhd::tune_request_t cordic_request(const double freq)
+{
+    uhd::tune_request_t request(freq);
+    request.rf_freq_policy = uhd::tune_request_t::POLICY_NONE;
+    return request;
+}
+
+static uhd::tune_request_t lms_request(const double freq)
+{
+    uhd::tune_request_t request(freq);
+    request.dsp_freq_policy = uhd::tune_request_t::POLICY_MANUAL;
+    request.dsp_freq = 0;
+    return request;
+}
+
+/*!
+ * Run the hops of one operation.
+ * The setting alternates between a and b, a is set once before timing.
+ */
+static hop_result_t run_op(uhd::usrp::multi_usrp::sptr usrp, settle_meter_t *meter,
+    const std::string &op, const hop_config_t &config, const size_t iters)
+{
+    uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
+    const uhd::fs_path mb_path = "/mboards/0";
+    const double fa = config.freq, fb = config.freq + config.step;
+    const double mid = config.freq + config.step/2;
+    const bool rx_hop = op == "rx_lms" or op == "rx_cordic" or op == "rx_umsel";
+    const bool tx_hop = op == "tx_lms" or op == "tx_cordic";
+
+    //the fixed side of a hop sits between the two settings of the other
+    if (rx_hop and config.loopback) usrp->set_tx_freq(lms_request(mid));
+    if (tx_hop) usrp->set_rx_freq(lms_request(mid));
+    const double tone = config.loopback? mid : config.tone_freq;
+    const bool measured = meter != NULL and (rx_hop or (tx_hop and config.loopback));
+
+    hop_result_t result(op);
+    for (size_t i = 0; i <= iters; i++)
+    {
+        const bool b = (i % 2) == 1;
+        const double f = b? fb : fa;
+        uhd::time_spec_t since = usrp->get_time_now();
+        if (config.timed)
+        {
+            since += uhd::time_spec_t(config.lead);
+            usrp->set_command_time(since);
+        }
+
+        const bench_clock::time_point start = bench_clock::now();
+        if (op == "rx_lms" or op == "rx_umsel") usrp->set_rx_freq(lms_request(f));
+        else if (op == "rx_cordic") usrp->set_rx_freq(cordic_request(f));
+        else if (op == "tx_lms") usrp->set_tx_freq(lms_request(f));
+        else if (op == "tx_cordic") usrp->set_tx_freq(cordic_request(f));
+        else if (op == "rx_gain") usrp->set_rx_gain(b? config.gain_b : config.gain_a);
+        else if (op == "tx_gain") usrp->set_tx_gain(b? config.gain_b : config.gain_a);
+        else
+        {
+            //the corrections through the tree, a small value and back to none
+            const std::string dir = op.substr(0, 2) == "rx"? "rx_frontends" : "tx_frontends";
+            const std::string which = op.substr(3) == "iq"? "iq_balance" : "dc_offset";
+            tree->access<std::complex<double> >(mb_path / dir / "A" / which / "value")
+                .set(b? std::complex<double>(0.01, -0.01) : std::complex<double>(0, 0));
+        }
+        const double wall = elapsed_us(start);
+        if (config.timed) usrp->clear_command_time();
+        if (i == 0) continue; //the first one only sets a
+
+        result.wall.samples.push_back(wall);
+        if (not measured) continue;
+        const double offset = rx_hop? tone - f : f - mid;
+        const double settle = meter->measure(since, offset, config.timeout);
+        if (settle < 0) result.unsettled++;
+        else result.settle.samples.push_back(settle*1e6);
+    }
+    result.wall.sort();
+    result.settle.sort();
+    result.print();
+    return result;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    std::string args, ops_list, json_file;
+    size_t iters, block, stable_blocks;
+    double rate, tol, min_power, ampl;
+    hop_config_t config;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help,h", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "device address args [default = \"\"]")
+        ("ops", po::value<std::string>(&ops_list)->default_value("rx_lms,rx_cordic,tx_lms,tx_cordic,rx_gain,tx_gain,rx_iq,rx_dc,tx_iq,tx_dc"), "operations to run, also rx_umsel")
+        ("iters", po::value<size_t>(&iters)->default_value(200), "hops per operation")
+        ("rate", po::value<double>(&rate)->default_value(4e6), "RX and TX sample rate")
+        ("freq", po::value<double>(&config.freq)->default_value(900e6), "first frequency of the hops")
+        ("step", po::value<double>(&config.step)->default_value(1e6), "hop distance, under the rate")
+        ("gain-a", po::value<double>(&config.gain_a)->default_value(10), "first gain of the gain hops")
+        ("gain-b", po::value<double>(&config.gain_b)->default_value(20), "second gain of the gain hops")
+        ("tone-freq", po::value<double>(&config.tone_freq), "an external RX tone, instead of the TX loopback")
+        ("ampl", po::value<double>(&ampl)->default_value(0.3), "amplitude of the loopback tone")
+        ("block", po::value<size_t>(&block)->default_value(256), "samples per settle estimate")
+        ("stable-blocks", po::value<size_t>(&stable_blocks)->default_value(4), "consecutive good blocks for a stable tone")
+        ("tol", po::value<double>(&tol)->default_value(2e3), "tone frequency tolerance in Hz")
+        ("min-power", po::value<double>(&min_power)->default_value(1e-5), "least tone power, full scale 1")
+        ("settle-timeout", po::value<double>(&config.timeout)->default_value(0.1), "device seconds until a hop counts as unsettled")
+        ("timed", "time the commands ahead, the settle time counts from the command time")
+        ("lead", po::value<double>(&config.lead)->default_value(0.005), "how far ahead the timed commands are")
+        ("no-settle", "time the calls only, no RX stream")
+        ("json", po::value<std::string>(&json_file)->default_value(""), "write the results as JSON to this file, - for stdout")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX frequency hop benchmark %s") % desc << std::endl;
+        return ~0;
+    }
+    UHD_ASSERT_THROW(iters > 0 and block > 1 and stable_blocks > 0);
+    if (config.step <= 0 or config.step >= rate) throw std::runtime_error("--step must be positive and under the rate");
+    config.timed = vm.count("timed") != 0;
+    config.loopback = vm.count("tone-freq") == 0;
+
+    const std::vector<std::string> known_ops = boost::assign::list_of
+        ("rx_lms")("rx_cordic")("rx_umsel")("tx_lms")("tx_cordic")
+        ("rx_gain")("tx_gain")("rx_iq")("rx_dc")("tx_iq")("tx_dc");
+    std::vector<std::string> ops;
+    boost::split(ops, ops_list, boost::is_any_of(", "), boost::token_compress_on);
+    BOOST_FOREACH(const std::string &op, ops)
+    {
+        if (not op.empty() and std::find(known_ops.begin(), known_ops.end(), op) == known_ops.end())
+        {
+            throw std::runtime_error("unknown operation " + op);
+        }
+    }
+
+    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(args);
+    usrp->set_rx_rate(rate);
+    usrp->set_tx_rate(rate);
+    usrp->set_rx_freq(lms_request(config.freq));
+    usrp->set_tx_freq(lms_request(config.freq + config.step/2));
+    if (std::find(ops.begin(), ops.end(), "rx_umsel") != ops.end() and
+        not usrp->get_device()->get_tree()->exists("/mboards/0/dboards/A/rx_frontends/0/sensors/aux_lo_locked"))
+    {
+        throw std::runtime_error("rx_umsel needs an UmSEL2, open the device with umsel=on");
+    }
+
+    boost::scoped_ptr<tx_tone_t> tx_tone;
+    boost::scoped_ptr<settle_meter_t> meter;
+    if (not vm.count("no-settle"))
+    {
+        if (config.loopback) tx_tone.reset(new tx_tone_t(usrp, ampl));
+        meter.reset(new settle_meter_t(usrp, usrp->get_rx_rate(), block, stable_blocks, tol, min_power));
+    }
+
+    std::cout << boost::format("%-10s %9s %9s %9s %9s %9s %9s %6s")
+        % "operation" % "wall p50" % "p99" % "max" % "settle" % "p99" % "max" % "fail" << std::endl;
+    boost::property_tree::ptree results;
+    BOOST_FOREACH(const std::string &op, ops)
+    {
+        if (op.empty()) continue;
+        const hop_result_t result = run_op(usrp, meter.get(), op, config, iters);
+        results.push_back(std::make_pair("", result.to_ptree()));
+    }
+
+    if (not json_file.empty())
+    {
+        boost::property_tree::ptree doc;
+        doc.put("device", usrp->get_mboard_name());
+        doc.put("time", pt::to_iso_extended_string(pt::second_clock::universal_time()));
+        doc.put("rate", usrp->get_rx_rate());
+        doc.put("freq", config.freq);
+        doc.put("step", config.step);
+        doc.put("timed", config.timed);
+        doc.put("tone", config.loopback? "loopback" : "external");
+        doc.add_child("results", results);
+        if (json_file == "-") boost::property_tree::write_json(std::cout, doc);
+        else
+        {
+            std::ofstream out(json_file.c_str());
+            boost::property_tree::write_json(out, doc);
+        }
+    }
+
+    std::cout << std::endl << "Done!" << std::endl << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_host_check.hpp"
+#include "umtrx_frame_pool.hpp"
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <uhd/exception.hpp>
+#include <boost/program_options.hpp>
+#include <boost/asio/ip/address_v4.hpp>
+#include <boost/format.hpp>
+#include <boost/chrono.hpp>
+#include <iostream>
+#include <complex>
+#include <cstring>
+#include <vector>
+
+namespace po = boost::program_options;
+
+/*!
+ * Host preflight.
+ *
+ * Checks the host settings an UmTRX stream depends on and prints the
+ * command that fixes each one that would drop samples: socket buffer
+ * limits, MTU and RX ring of the interface, IRQ affinity against the
+ * streaming CPU and the CPU governor. With a device and a rate it then
+ * streams for a few seconds and counts the overflows.
+ */
+
+typedef boost::chrono::steady_clock check_clock;
+
+//! RX at the rate for the duration, \return true without overflows or timeouts
+static bool run_stream_test(const std::string &args, const double rate, const double duration,
+    const size_t recv_buff_size, const int cpu)
+{
+    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(args);
+    usrp->set_rx_rate(rate);
+    const double actual_rate = usrp->get_rx_rate();
+
+    uhd::stream_args_t stream_args("sc16", "sc16");
+    stream_args.args["recv_buff_size"] = str(boost::format("%u") % recv_buff_size);
+    if (cpu >= 0) stream_args.args["convert_cpu"] = str(boost::format("%d") % cpu);
+    uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+
+    std::vector<std::complex<short> > buff(rx_stream->get_max_num_samps());
+    uhd::rx_metadata_t md;
+    uhd::stream_cmd_t stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    stream_cmd.stream_now = true;
+    rx_stream->issue_stream_cmd(stream_cmd);
+
+    size_t overflows = 0, timeouts = 0, errors = 0;
+    boost::uint64_t num_samps = 0;
+    const check_clock::time_point start = check_clock::now();
+    while (boost::chrono::duration_cast<boost::chrono::milliseconds>(check_clock::now() - start).count() < duration*1000)
+    {
+        num_samps += rx_stream->recv(&buff.front(), buff.size(), md, 0.5);
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_NONE) continue;
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW) overflows++;
+        else if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_TIMEOUT) timeouts++;
+        else errors++;
+    }
+    rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+
+    const bool ok = overflows == 0 and timeouts == 0 and errors == 0;
+    std::cout << boost::format("[%s] RX stream at %.3f Msps: %u samples in %.1f s, %u overflows, %u timeouts, %u errors")
+        % (ok? " ok " : "FAIL") % (actual_rate/1e6) % num_samps % duration % overflows % timeouts % errors << std::endl;
+    if (not ok) std::cout << "       fix: the settings above first, then pin the stream with convert_cpu "
+        "to a CPU without NIC interrupts" << std::endl;
+    return ok;
+}
+
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    std::string args, iface;
+    double recv_buff_size, send_buff_size, rate, duration;
+    size_t frame_size;
+    int cpu;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help,h", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "device address args, addr=... finds the interface [default = \"\"]")
+        ("iface", po::value<std::string>(&iface)->default_value(""), "network interface of the device, ex: eth1")
+        ("recv_buff_size", po::value<double>(&recv_buff_size)->default_value(50e6), "socket receive buffer bytes the streams use")
+        ("send_buff_size", po::value<double>(&send_buff_size)->default_value(1e6), "socket send buffer bytes the streams use")
+        ("frame_size", po::value<size_t>(&frame_size)->default_value(1472), "UDP payload bytes of the data frames")
+        ("cpu", po::value<int>(&cpu)->default_value(-1), "CPU the streaming thread is pinned to, -1 when not pinned")
+        ("rate", po::value<double>(&rate)->default_value(0), "RX rate of the stream test in samples/s, 0 skips it")
+        ("duration", po::value<double>(&duration)->default_value(3.0), "seconds of the stream test")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX host check %s") % desc << std::endl;
+        return ~0;
+    }
+
+    //the interface that faces the device
+    const uhd::device_addr_t dev_addr(args);
+    if (iface.empty() and dev_addr.has_key("addr"))
+    {
+        const boost::asio::ip::address_v4::bytes_type ip = boost::asio::ip::address_v4::from_string(dev_addr["addr"]).to_bytes();
+        boost::uint32_t addr;
+        std::memcpy(&addr, &ip[0], sizeof(addr));
+        iface = umtrx_frame_pool::find_iface(addr);
+    }
+    if (iface.empty()) std::cout << "No --iface or addr= given, only the host wide settings are checked" << std::endl;
+    else std::cout << "Checking the host for streams over " << iface << std::endl;
+
+    umtrx_host_check::requirements_t req;
+    req.recv_buff_size = size_t(recv_buff_size);
+    req.send_buff_size = size_t(send_buff_size);
+    req.frame_size = frame_size;
+    req.stream_cpu = cpu;
+    bool ok = umtrx_host_check::print(umtrx_host_check::run(iface, req), std::cout);
+
+    if (rate > 0) ok = run_stream_test(args, rate, duration, size_t(recv_buff_size), cpu) and ok;
+
+    std::cout << std::endl << (ok? "The host is ready" : "Fix the settings above before deployment") << std::endl << std::endl;
+    return ok? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,264 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_impl.hpp"
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/transport/zero_copy.hpp>
+#include <uhd/exception.hpp>
+#include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/format.hpp>
+#include <boost/chrono.hpp>
+#include <boost/crc.hpp>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+namespace po = boost::program_options;
+using namespace uhd::transport;
+
+/*!
+ * Network link test.
+ *
+ * Qualifies the path between the host and the UmTRX, NIC and switches
+ * included, with the packet generator and verifier in the FPGA:
+ *  - source: the FPGA sends packets to the host as fast as it makes them,
+ *    the host checks their sequence numbers and checksums
+ *  - sink: the host sends packets at the given rate, the FPGA checks
+ *    their sequence numbers and CRCs
+ * Both directions run on the DSP0 ports, so no stream may be open.
+ * The FPGA side makes or checks one byte per clock, about 800 Mb/s.
+ */
+
+typedef boost::chrono::steady_clock link_clock;
+
+static double elapsed_s(const link_clock::time_point &start)
+{
+    return boost::chrono::duration_cast<boost::chrono::microseconds>(link_clock::now() - start).count()/1e6;
+}
+
+static boost::uint32_t get_be32(const boost::uint8_t *p)
+{
+    boost::uint32_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return uhd::ntohx(word);
+}
+
+static void put_be32(boost::uint8_t *p, const boost::uint32_t word)
+{
+    const boost::uint32_t be = uhd::htonx(word);
+    std::memcpy(p, &be, sizeof(be));
+}
+
+/***********************************************************************
+ * Sequence number bookkeeping, one per direction
+ **********************************************************************/
+struct link_stats_t
+{
+    link_stats_t(void): packets(0), bytes(0), lost(0), reordered(0), bad(0), next_seq(0){}
+
+    void update(const boost::uint32_t seq)
+    {
+        packets++;
+        const boost::uint32_t ahead = seq - next_seq;
+        if (ahead < 0x80000000)
+        {
+            lost += ahead;
+            next_seq = seq + 1;
+        }
+        else
+        {
+            //came after a later one, it was counted lost then
+            reordered++;
+            if (lost > 0) lost--;
+        }
+    }
+
+    boost::uint64_t packets, bytes, lost, reordered, bad;
+    boost::uint32_t next_seq;
+};
+
+static void print_stats(const std::string &name, const link_stats_t &stats, const double secs,
+    const boost::uint64_t other_end)
+{
+    std::cout << boost::format("%s: %u packets in %.1f s, %.1f Mb/s")
+        % name % stats.packets % secs % (secs > 0? stats.bytes*8/secs/1e6 : 0.0) << std::endl;
+    std::cout << boost::format("  lost %u, reordered %u, corrupted %u, other end counted %u")
+        % stats.lost % stats.reordered % stats.bad % other_end << std::endl;
+}
+
+/***********************************************************************
+ * FPGA to host
+ **********************************************************************/
+static bool run_source(uhd::property_tree::sptr tree, const uhd::fs_path &link_path, const double duration)
+{
+    zero_copy_if::sptr xport = tree->access<zero_copy_if::sptr>(link_path / "rx_xport").get();
+    link_stats_t stats;
+    tree->access<std::string>(link_path / "mode").set("source");
+
+    //the clock starts at the first packet, the packets in flight are drained after the stop
+    link_clock::time_point start = link_clock::now();
+    bool started = false, on = true;
+    double secs = 0;
+    while (true)
+    {
+        if (on and started and elapsed_s(start) >= duration)
+        {
+            secs = elapsed_s(start);
+            tree->access<std::string>(link_path / "mode").set("off");
+            on = false;
+        }
+        managed_recv_buffer::sptr buff = xport->get_recv_buff(on? 1.0 : 0.1);
+        if (not buff) break;
+        if (not started)
+        {
+            start = link_clock::now();
+            started = true;
+        }
+
+        //length, sequence number, header and ramp, then the byte sum of them
+        const boost::uint8_t *p = buff->cast<const boost::uint8_t *>();
+        const size_t size = buff->size();
+        stats.bytes += size;
+        const boost::uint32_t len = (size >= 8)? get_be32(p) : 0;
+        if (size < 12 or len + 4 != size)
+        {
+            stats.bad++;
+            continue;
+        }
+        boost::uint32_t sum = 0;
+        for (size_t i = 0; i < len; i++) sum += p[i];
+        if (sum != get_be32(p + len)) stats.bad++;
+        else stats.update(get_be32(p + 4));
+    }
+    tree->access<std::string>(link_path / "mode").set("off");
+
+    const boost::uint32_t sent = tree->access<boost::uint32_t>(link_path / "sent").get();
+    if (sent > stats.packets + stats.bad) stats.lost = sent - stats.packets - stats.bad;
+    print_stats("source (FPGA -> host)", stats, secs, sent);
+    return stats.packets != 0 and stats.lost == 0 and stats.bad == 0;
+}
+
+/***********************************************************************
+ * Host to FPGA
+ **********************************************************************/
+static bool run_sink(uhd::property_tree::sptr tree, const uhd::fs_path &link_path, const double duration,
+    const double rate, size_t size)
+{
+    zero_copy_if::sptr xport = tree->access<zero_copy_if::sptr>(link_path / "tx_xport").get();
+    size = std::min(size, xport->get_send_frame_size()) & ~size_t(3);
+    UHD_ASSERT_THROW(size >= 24);
+    link_stats_t stats;
+    tree->access<std::string>(link_path / "mode").set("sink");
+
+    //transport word, VRT header and SID for the dispatcher, then what the FPGA checks:
+    //length, sequence number, ramp and the CRC32 of them, little endian
+    const size_t len = size - 12 - 4;
+    std::vector<boost::uint8_t> packet(size);
+    put_be32(&packet[0], 0);
+    put_be32(&packet[4], (0x1 << 28) | boost::uint32_t(size/4 - 1));
+    put_be32(&packet[8], UMTRX_DSP_TX0_SID);
+    put_be32(&packet[12], boost::uint32_t(len));
+    for (size_t i = 8; i < len; i++) packet[12 + i] = boost::uint8_t(i);
+
+    const double packet_period = (rate > 0)? size*8/rate : 0;
+    const link_clock::time_point start = link_clock::now();
+    double secs = 0;
+    while ((secs = elapsed_s(start)) < duration)
+    {
+        //pace against the start time, so a late packet goes out the sooner after
+        if (packet_period > 0 and stats.packets*packet_period > secs)
+        {
+            if (stats.packets*packet_period - secs > 1e-3) boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+            continue;
+        }
+        managed_send_buffer::sptr buff = xport->get_send_buff(0.1);
+        if (not buff) continue;
+
+        put_be32(&packet[16], boost::uint32_t(stats.packets));
+        boost::crc_32_type crc;
+        crc.process_bytes(&packet[12], len);
+        const boost::uint32_t fcs = crc.checksum();
+        for (size_t i = 0; i < 4; i++) packet[12 + len + i] = boost::uint8_t(fcs >> (8*i));
+
+        std::memcpy(buff->cast<void *>(), &packet[0], size);
+        buff->commit(size);
+        stats.packets++;
+        stats.bytes += size;
+    }
+
+    //let the last packets reach the verifier before the counters are read
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    tree->access<std::string>(link_path / "mode").set("off");
+    const boost::uint32_t received = tree->access<boost::uint32_t>(link_path / "received").get();
+    const boost::uint32_t crc_errors = tree->access<boost::uint32_t>(link_path / "crc_errors").get();
+    const boost::uint32_t seq_errors = tree->access<boost::uint32_t>(link_path / "seq_errors").get();
+
+    //the verifier resyncs on every gap or late packet, it cannot tell the two apart
+    stats.lost = (stats.packets > received)? stats.packets - received : 0;
+    stats.reordered = seq_errors;
+    stats.bad = crc_errors;
+    print_stats("sink (host -> FPGA)", stats, secs, received);
+    return stats.lost == 0 and seq_errors == 0 and crc_errors == 0;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    std::string args, mode;
+    double duration, rate;
+    size_t size;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help,h", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "device address args [default = \"\"]")
+        ("mode", po::value<std::string>(&mode)->default_value("both"), "direction to test: source (FPGA to host), sink (host to FPGA) or both")
+        ("duration", po::value<double>(&duration)->default_value(10.0), "seconds per direction")
+        ("rate", po::value<double>(&rate)->default_value(700e6), "sink rate in bits/s of UDP payload, 0 for as fast as the host sends")
+        ("size", po::value<size_t>(&size)->default_value(1472), "sink UDP payload bytes, limited by the send frame size")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX network link test %s") % desc << std::endl;
+        return ~0;
+    }
+    if (mode != "source" and mode != "sink" and mode != "both")
+    {
+        throw std::runtime_error("--mode must be source, sink or both");
+    }
+
+    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(args);
+    uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
+    const uhd::fs_path link_path = "/mboards/0/link_test";
+    if (not tree->exists(link_path)) throw std::runtime_error("This FPGA image has no link test");
+
+    bool ok = true;
+    if (mode != "sink") ok = run_source(tree, link_path, duration) and ok;
+    if (mode != "source") ok = run_sink(tree, link_path, duration, rate, size) and ok;
+
+    std::cout << std::endl << (ok? "The link is clean" : "The link lost or damaged packets") << std::endl << std::endl;
+    return ok? EXIT_SUCCESS : EXIT_FAILURE;
+}
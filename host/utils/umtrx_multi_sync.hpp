@@ -0,0 +1,150 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UMTRX_MULTI_SYNC_HPP
+#define INCLUDED_UMTRX_MULTI_SYNC_HPP
+
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/format.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+/***********************************************************************
+ * Time alignment of several boards, each a device of its own.
+ * The latches of all boards are armed from one thread per board right
+ * after a PPS edge, so every board takes the time on the same next edge
+ * no matter how long the control round trips are. The last PPS time of
+ * every board is read back once that edge passed: all must match.
+ **********************************************************************/
+typedef std::vector<uhd::usrp::multi_usrp::sptr> usrp_list_t;
+
+//! longest an armed latch may take: the edge after the arming PPS
+static const double MULTI_SYNC_ARM_BUDGET = 0.5;
+
+static boost::posix_time::ptime multi_sync_now(void)
+{
+    return boost::posix_time::microsec_clock::universal_time();
+}
+
+//! block until board 0 sees a new PPS, false after two seconds without one
+static bool wait_pps_edge(uhd::usrp::multi_usrp::sptr usrp)
+{
+    const uhd::time_spec_t last = usrp->get_time_last_pps();
+    const boost::posix_time::ptime deadline = multi_sync_now() + boost::posix_time::seconds(2);
+    while (multi_sync_now() < deadline)
+    {
+        if (usrp->get_time_last_pps() != last) return true;
+        boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+    }
+    return false;
+}
+
+static void arm_time_next_pps(uhd::usrp::multi_usrp::sptr usrp, const uhd::time_spec_t &time, std::string &error)
+{
+    try
+    {
+        usrp->set_time_next_pps(time);
+    }
+    catch (const std::exception &ex)
+    {
+        error = ex.what();
+    }
+}
+
+/*!
+ * Set the time of all boards on the same PPS edge, verified.
+ * \param usrps one per board, all on the same PPS
+ * \param time the time the boards take at the edge
+ * \param attempts tries before giving up when the readback disagrees
+ * \return the time the boards took, throws when they cannot agree
+ */
+static uhd::time_spec_t sync_boards_next_pps(const usrp_list_t &usrps, uhd::time_spec_t time, const size_t attempts = 3)
+{
+    if (usrps.empty()) throw std::runtime_error("no boards to sync");
+    for (size_t attempt = 0; attempt < attempts; attempt++)
+    {
+        //the whole period up to the next edge for the arming
+        if (not wait_pps_edge(usrps.front())) throw std::runtime_error("no PPS on the first board");
+        const boost::posix_time::ptime edge = multi_sync_now();
+
+        std::vector<std::string> errors(usrps.size());
+        boost::thread_group arms;
+        for (size_t i = 0; i < usrps.size(); i++)
+        {
+            arms.create_thread(boost::bind(&arm_time_next_pps, usrps[i], time, boost::ref(errors[i])));
+        }
+        arms.join_all();
+        for (size_t i = 0; i < usrps.size(); i++)
+        {
+            if (not errors[i].empty()) throw std::runtime_error(str(boost::format("board %u: %s") % i % errors[i]));
+        }
+        const double armed = (multi_sync_now() - edge).total_microseconds()/1e6;
+        if (armed > MULTI_SYNC_ARM_BUDGET)
+        {
+            std::cerr << boost::format("Arming took %.3f s, too close to the next PPS, trying again") % armed << std::endl;
+            time += uhd::time_spec_t(2.0);
+            continue;
+        }
+
+        //the armed edge, then the readback of the time it latched
+        if (not wait_pps_edge(usrps.front())) throw std::runtime_error("no PPS on the first board");
+        bool agree = true;
+        for (size_t i = 0; i < usrps.size(); i++)
+        {
+            const uhd::time_spec_t pps = usrps[i]->get_time_last_pps();
+            if (pps != time)
+            {
+                std::cerr << boost::format("Board %u latched %.6f s instead of %.6f s") % i % pps.get_real_secs() % time.get_real_secs() << std::endl;
+                agree = false;
+            }
+        }
+        if (agree) return time;
+        time = usrps.front()->get_time_last_pps() + uhd::time_spec_t(2.0);
+    }
+    throw std::runtime_error("the boards did not latch the same PPS time");
+}
+
+static void issue_timed_cmd(uhd::rx_streamer::sptr stream, const uhd::stream_cmd_t &cmd)
+{
+    stream->issue_stream_cmd(cmd);
+}
+
+/*!
+ * Start the RX streams of all boards at one device time.
+ * The commands go out in parallel, the time must be far enough ahead for
+ * the slowest board to receive its command.
+ */
+static void start_streams_at(const std::vector<uhd::rx_streamer::sptr> &streams, const uhd::time_spec_t &time)
+{
+    uhd::stream_cmd_t cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    cmd.stream_now = false;
+    cmd.time_spec = time;
+    boost::thread_group starts;
+    for (size_t i = 0; i < streams.size(); i++)
+    {
+        starts.create_thread(boost::bind(&issue_timed_cmd, streams[i], cmd));
+    }
+    starts.join_all();
+}
+
+#endif /* INCLUDED_UMTRX_MULTI_SYNC_HPP */
@@ -0,0 +1,436 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifdef THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread.hpp>
+#else // THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread_priority.hpp>
+#endif // THREAD_PRIORITY_HPP_DEPRECATED
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/convert.hpp>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/cstdint.hpp>
+#include <deque>
+#include <iostream>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace po = boost::program_options;
+namespace pt = boost::posix_time;
+
+/***********************************************************************
+ * The capture file is a sequence of blocks of block_bytes each, so block
+ * n starts at n*block_bytes and a reader finds a time by bisecting the
+ * block headers. Every block starts with the header below, in host byte
+ * order, followed by the samples of each channel one after the other,
+ * capacity samples per channel of which num_samps are valid.
+ * A block ends early when the stream breaks, so the first sample of each
+ * block is at the time of its header.
+ **********************************************************************/
+static const char BLOCK_MAGIC[8] = {'U', 'M', 'T', 'R', 'X', 'R', 'X', '1'};
+static const size_t HEADER_BYTES = 128;
+static const size_t DIRECT_ALIGN = 4096;
+
+//! the stream overflowed right before the first sample
+static const boost::uint32_t BLOCK_FLAG_OVERFLOW = 1 << 0;
+//! the time does not follow the block before, lost_samps tells how far
+static const boost::uint32_t BLOCK_FLAG_DISCONTINUITY = 1 << 1;
+
+struct block_header_t
+{
+    char magic[8];
+    boost::uint32_t header_bytes;
+    boost::uint32_t block_bytes;
+    boost::uint64_t block_index;
+    boost::uint32_t num_channels;
+    boost::uint32_t bytes_per_samp;
+    boost::uint32_t capacity; //samples per channel
+    boost::uint32_t num_samps; //valid samples per channel
+    boost::int64_t time_full_secs; //device time of the first sample
+    double time_frac_secs;
+    double rate;
+    boost::uint32_t flags;
+    boost::uint32_t reserved;
+    boost::uint64_t lost_samps; //missing before the first sample, from the time
+};
+
+struct block_t
+{
+    char *mem; //block_bytes, aligned for O_DIRECT
+    boost::uint64_t index;
+};
+
+/***********************************************************************
+ * Pool of aligned blocks between the receive thread and the writers
+ **********************************************************************/
+class block_pool
+{
+public:
+    block_pool(const size_t num_blocks, const size_t block_bytes):
+        _done(false), stalls(0)
+    {
+        for (size_t i = 0; i < num_blocks; i++)
+        {
+            void *mem = NULL;
+            if (posix_memalign(&mem, DIRECT_ALIGN, block_bytes) != 0) throw std::bad_alloc();
+            std::memset(mem, 0, block_bytes);
+            block_t block;
+            block.mem = static_cast<char *>(mem);
+            block.index = 0;
+            _free.push_back(block);
+            _all.push_back(block.mem);
+        }
+    }
+
+    ~block_pool(void)
+    {
+        BOOST_FOREACH(char *mem, _all) std::free(mem);
+    }
+
+    //! an empty block for the receiver, waits when the writers are behind
+    block_t get_free(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_free.empty()) stalls++;
+        while (_free.empty()) _cond.wait(lock);
+        const block_t block = _free.front();
+        _free.pop_front();
+        return block;
+    }
+
+    void put_full(const block_t &block)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _full.push_back(block);
+        lock.unlock();
+        _cond.notify_all();
+    }
+
+    //! a block to write, false once done and drained
+    bool get_full(block_t &block)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        while (_full.empty() and not _done) _cond.wait(lock);
+        if (_full.empty()) return false;
+        block = _full.front();
+        _full.pop_front();
+        return true;
+    }
+
+    void put_free(const block_t &block)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _free.push_back(block);
+        lock.unlock();
+        _cond.notify_all();
+    }
+
+    void done(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _done = true;
+        lock.unlock();
+        _cond.notify_all();
+    }
+
+private:
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+    std::deque<block_t> _free, _full;
+    std::vector<char *> _all;
+    bool _done;
+
+public:
+    unsigned long long stalls; //the receiver found no free block
+};
+
+static void writer_loop(block_pool &pool, const int fd, const size_t block_bytes, boost::atomic<bool> &failed)
+{
+    block_t block;
+    while (pool.get_full(block))
+    {
+        const off_t offset = off_t(block.index*block_bytes);
+        size_t done = 0;
+        while (done < block_bytes and not failed)
+        {
+            const ssize_t r = ::pwrite(fd, block.mem + done, block_bytes - done, offset + off_t(done));
+            if (r < 0 and errno == EINTR) continue;
+            if (r <= 0)
+            {
+                std::cerr << "write failed: " << std::strerror(errno) << std::endl;
+                failed = true;
+                break;
+            }
+            done += size_t(r);
+        }
+        pool.put_free(block);
+    }
+}
+
+static boost::atomic<bool> stop_signal_called(false);
+static void sig_int_handler(int)
+{
+    stop_signal_called = true;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    uhd::set_thread_priority_safe();
+
+    std::string args, file, channel_list, cpu_format, otw_format, ant, subdev;
+    double rate, freq, gain, duration, buffer_mb, block_kb;
+    size_t num_writers;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "single uhd device address args")
+        ("file", po::value<std::string>(&file)->default_value("umtrx_rx.dat"), "capture file")
+        ("channels", po::value<std::string>(&channel_list)->default_value("0"), "comma separated RX channels, up to 4")
+        ("rate", po::value<double>(&rate)->default_value(1e6), "RX rate")
+        ("freq", po::value<double>(&freq), "RX LO, default leaves it")
+        ("gain", po::value<double>(&gain), "RX gain, default leaves it")
+        ("ant", po::value<std::string>(&ant), "RX antenna")
+        ("subdev", po::value<std::string>(&subdev), "RX subdevice spec")
+        ("duration", po::value<double>(&duration)->default_value(0.0), "seconds to record, 0 until ctrl+c")
+        ("cpu", po::value<std::string>(&cpu_format)->default_value("sc16"), "sample format in the file")
+        ("otw", po::value<std::string>(&otw_format)->default_value("sc16"), "over the wire sample format")
+        ("block_kb", po::value<double>(&block_kb)->default_value(1024), "block size in KiB, a multiple of 4")
+        ("buffer_mb", po::value<double>(&buffer_mb)->default_value(256), "memory for the blocks on their way to the disk")
+        ("writers", po::value<size_t>(&num_writers)->default_value(2), "writer threads")
+        ("buffered", "write through the page cache instead of O_DIRECT")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX RX to file %s") % desc << std::endl;
+        std::cout << "Records RX channels into blocks with the device time of their first sample" << std::endl;
+        return ~0;
+    }
+
+    const size_t block_bytes = size_t(block_kb*1024) & ~(DIRECT_ALIGN - 1);
+    if (block_bytes < 2*HEADER_BYTES) throw std::runtime_error("block_kb is too small");
+
+    std::vector<std::string> tokens;
+    boost::split(tokens, channel_list, boost::is_any_of(", "), boost::token_compress_on);
+    std::vector<size_t> channels;
+    BOOST_FOREACH(const std::string &token, tokens)
+    {
+        if (not token.empty()) channels.push_back(boost::lexical_cast<size_t>(token));
+    }
+    if (channels.empty() or channels.size() > 4) throw std::runtime_error("record 1 to 4 channels");
+
+    std::cout << std::endl;
+    std::cout << boost::format("Creating the usrp device with: %s...") % args << std::endl;
+    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(args);
+    if (vm.count("subdev")) usrp->set_rx_subdev_spec(subdev);
+    std::cout << boost::format("Using Device: %s") % usrp->get_pp_string() << std::endl;
+
+    usrp->set_rx_rate(rate);
+    BOOST_FOREACH(const size_t chan, channels)
+    {
+        if (vm.count("freq")) usrp->set_rx_freq(uhd::tune_request_t(freq), chan);
+        if (vm.count("gain")) usrp->set_rx_gain(gain, chan);
+        if (vm.count("ant")) usrp->set_rx_antenna(ant, chan);
+    }
+    const double actual_rate = usrp->get_rx_rate(channels.front());
+    std::cout << boost::format("RX rate: %f Msps on %u channels") % (actual_rate/1e6) % channels.size() << std::endl;
+
+    //the stream is sized after the rate
+    uhd::stream_args_t stream_args(cpu_format, otw_format);
+    stream_args.channels = channels;
+    uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+
+    const size_t bytes_per_samp = uhd::convert::get_bytes_per_item(cpu_format);
+    const size_t capacity = (block_bytes - HEADER_BYTES)/(bytes_per_samp*channels.size());
+    const size_t num_blocks = std::max<size_t>(4, size_t(buffer_mb*1024*1024/block_bytes));
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+    if (not vm.count("buffered")) flags |= O_DIRECT;
+#endif
+    int fd = ::open(file.c_str(), flags, 0644);
+#ifdef O_DIRECT
+    if (fd < 0 and errno == EINVAL and (flags & O_DIRECT) != 0)
+    {
+        std::cout << "The file system takes no O_DIRECT, writing through the page cache" << std::endl;
+        fd = ::open(file.c_str(), flags & ~O_DIRECT, 0644);
+    }
+#endif
+    if (fd < 0) throw std::runtime_error("cannot open " + file + ": " + std::strerror(errno));
+
+    block_pool pool(num_blocks, block_bytes);
+    boost::atomic<bool> failed(false);
+    boost::thread_group writers;
+    for (size_t i = 0; i < std::max<size_t>(1, num_writers); i++)
+    {
+        writers.create_thread(boost::bind(&writer_loop, boost::ref(pool), fd, block_bytes, boost::ref(failed)));
+    }
+
+    std::signal(SIGINT, &sig_int_handler);
+    if (duration <= 0) std::cout << "Press Ctrl + C to stop recording..." << std::endl;
+
+    uhd::stream_cmd_t stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    stream_cmd.stream_now = false;
+    stream_cmd.time_spec = usrp->get_time_now() + uhd::time_spec_t(0.1);
+    rx_stream->issue_stream_cmd(stream_cmd);
+
+    //receive straight into the blocks, one channel after the other
+    unsigned long long total_samps = 0, overflows = 0, lost_samps = 0, num_out = 0;
+    boost::uint64_t next_index = 0;
+    block_t block = pool.get_free();
+    block_header_t header = block_header_t();
+    size_t filled = 0;
+    bool force_break = false; //an overflow ends the block even without a time gap
+    boost::uint32_t pending_flags = 0;
+    boost::uint64_t pending_lost = 0;
+    uhd::time_spec_t next_time;
+    bool next_time_valid = false;
+    std::vector<void *> buff_ptrs(channels.size());
+    uhd::rx_metadata_t md;
+    double timeout = 1.0; //the stream starts in the future
+    const pt::ptime deadline = pt::microsec_clock::universal_time() + pt::microseconds(long(duration*1e6));
+
+    while (not stop_signal_called and not failed)
+    {
+        if (duration > 0 and pt::microsec_clock::universal_time() > deadline) break;
+
+        for (size_t ch = 0; ch < channels.size(); ch++)
+        {
+            buff_ptrs[ch] = block.mem + HEADER_BYTES + (ch*capacity + filled)*bytes_per_samp;
+        }
+        const size_t num_rx_samps = rx_stream->recv(buff_ptrs, capacity - filled, md, timeout);
+        timeout = 0.2;
+
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_TIMEOUT) continue;
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW)
+        {
+            overflows++;
+            pending_flags |= BLOCK_FLAG_OVERFLOW;
+            force_break = true;
+        }
+        else if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE)
+        {
+            std::cerr << boost::format("Receive error code 0x%x") % int(md.error_code) << std::endl;
+            continue;
+        }
+        if (num_rx_samps == 0) continue;
+
+        //a break in the time starts a new block, the gap goes in its header
+        const bool continues = next_time_valid and
+            std::abs((md.time_spec - next_time).get_real_secs()) < 0.5/actual_rate;
+        if (filled != 0 and (force_break or not continues))
+        {
+            //move the samples of the break to the start of a fresh block
+            block_t fresh = pool.get_free();
+            for (size_t ch = 0; ch < channels.size(); ch++)
+            {
+                std::memcpy(fresh.mem + HEADER_BYTES + ch*capacity*bytes_per_samp,
+                    static_cast<char *>(buff_ptrs[ch]), num_rx_samps*bytes_per_samp);
+            }
+            header.num_samps = boost::uint32_t(filled);
+            std::memcpy(block.mem, &header, sizeof(header));
+            block.index = next_index++;
+            pool.put_full(block);
+            num_out++;
+            block = fresh;
+            filled = 0;
+        }
+        if (filled == 0)
+        {
+            if (next_time_valid and not continues)
+            {
+                pending_flags |= BLOCK_FLAG_DISCONTINUITY;
+                const double gap = (md.time_spec - next_time).get_real_secs()*actual_rate;
+                pending_lost = boost::uint64_t(std::max(0.0, std::floor(gap + 0.5)));
+                lost_samps += pending_lost;
+            }
+            header = block_header_t();
+            std::memcpy(header.magic, BLOCK_MAGIC, sizeof(header.magic));
+            header.header_bytes = HEADER_BYTES;
+            header.block_bytes = boost::uint32_t(block_bytes);
+            header.block_index = next_index;
+            header.num_channels = boost::uint32_t(channels.size());
+            header.bytes_per_samp = boost::uint32_t(bytes_per_samp);
+            header.capacity = boost::uint32_t(capacity);
+            header.time_full_secs = md.time_spec.get_full_secs();
+            header.time_frac_secs = md.time_spec.get_frac_secs();
+            header.rate = actual_rate;
+            header.flags = pending_flags;
+            header.lost_samps = pending_lost;
+            pending_flags = 0;
+            pending_lost = 0;
+        }
+        force_break = false;
+        filled += num_rx_samps;
+        total_samps += num_rx_samps;
+        next_time = md.time_spec + uhd::time_spec_t::from_ticks(num_rx_samps, actual_rate);
+        next_time_valid = true;
+
+        if (filled == capacity)
+        {
+            header.num_samps = boost::uint32_t(filled);
+            std::memcpy(block.mem, &header, sizeof(header));
+            block.index = next_index++;
+            pool.put_full(block);
+            num_out++;
+            block = pool.get_free();
+            filled = 0;
+        }
+    }
+
+    rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    if (filled != 0)
+    {
+        header.num_samps = boost::uint32_t(filled);
+        std::memcpy(block.mem, &header, sizeof(header));
+        block.index = next_index++;
+        pool.put_full(block);
+        num_out++;
+    }
+    else pool.put_free(block);
+    pool.done();
+    writers.join_all();
+    ::close(fd);
+
+    std::cout << std::endl;
+    std::cout << boost::format("Recorded %u samples per channel in %u blocks to %s") % total_samps % num_out % file << std::endl;
+    std::cout << boost::format("Overflows: %u, samples lost: %u, waits for the disk: %u") % overflows % lost_samps % pool.stalls << std::endl;
+    return failed? EXIT_FAILURE : EXIT_SUCCESS;
+}
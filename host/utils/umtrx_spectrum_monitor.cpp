@@ -0,0 +1,512 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifdef THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread.hpp>
+#else // THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread_priority.hpp>
+#endif // THREAD_PRIORITY_HPP_DEPRECATED
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/asio.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/shared_ptr.hpp>
+#include <complex>
+#include <deque>
+#include <iostream>
+#include <sstream>
+#include <csignal>
+#include <cstdlib>
+#include <cmath>
+
+namespace po = boost::program_options;
+namespace pt = boost::posix_time;
+namespace asio = boost::asio;
+
+typedef std::complex<float> fc32_t;
+typedef std::vector<fc32_t> frame_t;
+
+/***********************************************************************
+ * Forward FFT, radix-2 decimation in time over a power of two size
+ **********************************************************************/
+class fft_engine
+{
+public:
+    fft_engine(const size_t size):
+        _size(size), _twiddles(size/2), _reversed(size), _scratch(size)
+    {
+        size_t bits = 0;
+        while ((size_t(1) << bits) < _size) bits++;
+        for (size_t i = 0; i < _size; i++)
+        {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; b++) if (i & (size_t(1) << b)) r |= size_t(1) << (bits - 1 - b);
+            _reversed[i] = r;
+        }
+        for (size_t k = 0; k < _size/2; k++) _twiddles[k] = std::polar(1.0f, float(-2*M_PI*k/_size));
+    }
+
+    //! transform in into the scratch buffer, returns it
+    const frame_t &run(const frame_t &in)
+    {
+        for (size_t i = 0; i < _size; i++) _scratch[_reversed[i]] = in[i];
+        for (size_t len = 2; len <= _size; len <<= 1)
+        {
+            const size_t stride = _size/len;
+            for (size_t i = 0; i < _size; i += len)
+            {
+                for (size_t j = 0; j < len/2; j++)
+                {
+                    const fc32_t a = _scratch[i + j];
+                    const fc32_t b = _scratch[i + j + len/2]*_twiddles[j*stride];
+                    _scratch[i + j] = a + b;
+                    _scratch[i + j + len/2] = a - b;
+                }
+            }
+        }
+        return _scratch;
+    }
+
+private:
+    const size_t _size;
+    std::vector<fc32_t> _twiddles;
+    std::vector<size_t> _reversed;
+    frame_t _scratch;
+};
+
+static std::vector<float> make_window(const std::string &name, const size_t size)
+{
+    std::vector<float> w(size, 1.0f);
+    for (size_t n = 0; n < size; n++)
+    {
+        const double x = 2*M_PI*n/size;
+        if (name == "hann") w[n] = float(0.5 - 0.5*std::cos(x));
+        else if (name == "blackman") w[n] = float(0.42 - 0.5*std::cos(x) + 0.08*std::cos(2*x));
+        else if (name != "rect") throw std::runtime_error("unknown window " + name);
+    }
+    return w;
+}
+
+/***********************************************************************
+ * Frames between the receive thread and the FFT worker of a channel.
+ * Interference hunting can miss a frame, so the receiver never waits:
+ * without a free frame the samples are dropped and counted.
+ **********************************************************************/
+class frame_queue
+{
+public:
+    frame_queue(const size_t num_frames, const size_t frame_size):
+        _done(false)
+    {
+        for (size_t i = 0; i < num_frames; i++) _free.push_back(frame_t(frame_size));
+    }
+
+    bool try_get_free(frame_t &frame)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_free.empty()) return false;
+        frame.swap(_free.front());
+        _free.pop_front();
+        return true;
+    }
+
+    void put_free(frame_t &frame)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _free.push_back(frame_t());
+        _free.back().swap(frame);
+    }
+
+    void put_full(frame_t &frame)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _full.push_back(frame_t());
+        _full.back().swap(frame);
+        lock.unlock();
+        _cond.notify_one();
+    }
+
+    //! a frame to transform, false once done and drained
+    bool get_full(frame_t &frame)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        while (_full.empty() and not _done) _cond.wait(lock);
+        if (_full.empty()) return false;
+        frame.swap(_full.front());
+        _full.pop_front();
+        return true;
+    }
+
+    void done(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _done = true;
+        lock.unlock();
+        _cond.notify_all();
+    }
+
+private:
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+    std::deque<frame_t> _free, _full;
+    bool _done;
+};
+
+/***********************************************************************
+ * Reports go to the console and, when asked, one JSON datagram each
+ **********************************************************************/
+struct band_t
+{
+    double offset, bw; //Hz from the LO
+};
+
+class report_publisher
+{
+public:
+    report_publisher(const std::string &udp_addr, const bool quiet):
+        _quiet(quiet)
+    {
+        if (udp_addr.empty()) return;
+        const size_t colon = udp_addr.rfind(':');
+        if (colon == std::string::npos) throw std::runtime_error("udp wants host:port");
+        asio::ip::udp::resolver resolver(_io_service);
+        asio::ip::udp::resolver::query query(asio::ip::udp::v4(), udp_addr.substr(0, colon), udp_addr.substr(colon + 1));
+        _endpoint = *resolver.resolve(query);
+        _socket.reset(new asio::ip::udp::socket(_io_service));
+        _socket->open(asio::ip::udp::v4());
+    }
+
+    void publish(const size_t chan, const double lo_freq, const double rate,
+        const std::vector<float> &spectrum_db, const std::vector<band_t> &bands,
+        const std::vector<double> &band_db, const unsigned long long dropped)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        if (not _quiet)
+        {
+            std::cout << boost::format("ch%u LO %.3f MHz:") % chan % (lo_freq/1e6);
+            for (size_t i = 0; i < bands.size(); i++)
+            {
+                std::cout << boost::format(" [%+.3f MHz] %.1f dBFS") % (bands[i].offset/1e6) % band_db[i];
+            }
+            if (dropped) std::cout << boost::format(" (%u frames dropped)") % dropped;
+            std::cout << std::endl;
+        }
+        if (not _socket) return;
+
+        std::ostringstream json;
+        json << "{\"channel\":" << chan << ",\"lo_freq\":" << lo_freq << ",\"rate\":" << rate;
+        json << ",\"time\":\"" << pt::to_iso_extended_string(pt::microsec_clock::universal_time()) << "\"";
+        json << ",\"dropped\":" << dropped << ",\"bands\":[";
+        for (size_t i = 0; i < bands.size(); i++)
+        {
+            if (i) json << ",";
+            json << boost::format("{\"offset\":%g,\"bw\":%g,\"power\":%.2f}") % bands[i].offset % bands[i].bw % band_db[i];
+        }
+        json << "],\"spectrum\":[";
+        for (size_t i = 0; i < spectrum_db.size(); i++)
+        {
+            if (i) json << ",";
+            json << boost::format("%.2f") % spectrum_db[i];
+        }
+        json << "]}";
+        const std::string msg = json.str();
+        boost::system::error_code ec;
+        _socket->send_to(asio::buffer(msg), _endpoint, 0, ec);
+        if (ec) std::cerr << "UDP report failed: " << ec.message() << std::endl;
+    }
+
+private:
+    const bool _quiet;
+    boost::mutex _mutex;
+    asio::io_service _io_service;
+    asio::ip::udp::endpoint _endpoint;
+    boost::shared_ptr<asio::ip::udp::socket> _socket;
+};
+
+/***********************************************************************
+ * FFT worker, one per channel
+ **********************************************************************/
+struct worker_args_t
+{
+    size_t index, chan;
+    double lo_freq, rate;
+    size_t fft_size, num_averages;
+    std::vector<float> window;
+    std::vector<band_t> bands;
+};
+
+static boost::atomic<unsigned long long> frames_dropped[4];
+
+static void fft_worker(const worker_args_t &args, frame_queue &queue, report_publisher &publisher)
+{
+    const size_t n = args.fft_size;
+    fft_engine fft(n);
+    frame_t frame;
+    std::vector<double> power(n, 0.0);
+    std::vector<float> spectrum_db(n);
+    std::vector<double> band_db(args.bands.size());
+    size_t num_frames = 0;
+    unsigned long long last_dropped = 0;
+
+    //full scale sine in one bin reads 0 dBFS
+    double window_sum = 0, window_power = 0;
+    BOOST_FOREACH(const float w, args.window)
+    {
+        window_sum += w;
+        window_power += w*w;
+    }
+    const double norm = 1.0/(window_sum*window_sum);
+    //a band sums the bins, each bin sees the noise of the window bandwidth
+    const double enbw = n*window_power/(window_sum*window_sum);
+    const double bin_bw = args.rate/n;
+
+    while (queue.get_full(frame))
+    {
+        for (size_t i = 0; i < n; i++) frame[i] *= args.window[i];
+        const frame_t &bins = fft.run(frame);
+        for (size_t k = 0; k < n; k++) power[k] += std::norm(bins[k]);
+        queue.put_free(frame);
+        if (++num_frames < args.num_averages) continue;
+
+        //bin k sits at k*rate/n, the report runs from the most negative frequency up
+        for (size_t k = 0; k < n; k++)
+        {
+            const double p = power[(k + n/2) % n]*norm/num_frames;
+            spectrum_db[k] = float(10*std::log10(p + 1e-20));
+        }
+        for (size_t b = 0; b < args.bands.size(); b++)
+        {
+            const double lo = args.bands[b].offset - args.bands[b].bw/2;
+            const double hi = args.bands[b].offset + args.bands[b].bw/2;
+            double sum = 0;
+            for (size_t k = 0; k < n; k++)
+            {
+                const double f = (double(k) - double(n/2))*bin_bw;
+                if (f >= lo and f < hi) sum += std::pow(10.0, spectrum_db[k]/10);
+            }
+            band_db[b] = 10*std::log10(sum/enbw + 1e-20);
+        }
+
+        const unsigned long long dropped = frames_dropped[args.index].load();
+        publisher.publish(args.chan, args.lo_freq, args.rate, spectrum_db, args.bands, band_db, dropped - last_dropped);
+        last_dropped = dropped;
+        std::fill(power.begin(), power.end(), 0.0);
+        num_frames = 0;
+    }
+}
+
+static boost::atomic<bool> stop_signal_called(false);
+static void sig_int_handler(int)
+{
+    stop_signal_called = true;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    uhd::set_thread_priority_safe();
+
+    std::string args, channel_list, band_list, window_name, ant, subdev, udp_addr;
+    double rate, freq, gain, interval, duration;
+    size_t fft_size, queue_frames;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "single uhd device address args")
+        ("channels", po::value<std::string>(&channel_list)->default_value("0"), "comma separated RX channels, up to 4")
+        ("rate", po::value<double>(&rate)->default_value(1e6), "RX rate")
+        ("freq", po::value<double>(&freq), "RX LO, default leaves it")
+        ("gain", po::value<double>(&gain), "RX gain, default leaves it")
+        ("ant", po::value<std::string>(&ant), "RX antenna")
+        ("subdev", po::value<std::string>(&subdev), "RX subdevice spec")
+        ("fft_size", po::value<size_t>(&fft_size)->default_value(1024), "FFT bins, a power of two")
+        ("window", po::value<std::string>(&window_name)->default_value("blackman"), "FFT window: rect, hann or blackman")
+        ("interval", po::value<double>(&interval)->default_value(0.5), "seconds of spectra averaged per report")
+        ("bands", po::value<std::string>(&band_list)->default_value(""), "channel powers to report, comma separated offset:bw in Hz from the LO, default the whole band")
+        ("udp", po::value<std::string>(&udp_addr)->default_value(""), "send every report as a JSON datagram to host:port")
+        ("quiet", "no reports on the console")
+        ("duration", po::value<double>(&duration)->default_value(0.0), "seconds to run, 0 until ctrl+c")
+        ("queue_frames", po::value<size_t>(&queue_frames)->default_value(64), "frames in flight per channel")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX spectrum monitor %s") % desc << std::endl;
+        std::cout << "Averages windowed FFTs of RX channels and reports spectra and channel powers" << std::endl;
+        return ~0;
+    }
+
+    if (fft_size < 16 or (fft_size & (fft_size - 1)) != 0) throw std::runtime_error("fft_size must be a power of two, 16 or more");
+
+    std::vector<std::string> tokens;
+    boost::split(tokens, channel_list, boost::is_any_of(", "), boost::token_compress_on);
+    std::vector<size_t> channels;
+    BOOST_FOREACH(const std::string &token, tokens)
+    {
+        if (not token.empty()) channels.push_back(boost::lexical_cast<size_t>(token));
+    }
+    if (channels.empty() or channels.size() > 4) throw std::runtime_error("monitor 1 to 4 channels");
+
+    std::cout << std::endl;
+    std::cout << boost::format("Creating the usrp device with: %s...") % args << std::endl;
+    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(args);
+    if (vm.count("subdev")) usrp->set_rx_subdev_spec(subdev);
+    std::cout << boost::format("Using Device: %s") % usrp->get_pp_string() << std::endl;
+
+    usrp->set_rx_rate(rate);
+    BOOST_FOREACH(const size_t chan, channels)
+    {
+        if (vm.count("freq")) usrp->set_rx_freq(uhd::tune_request_t(freq), chan);
+        if (vm.count("gain")) usrp->set_rx_gain(gain, chan);
+        if (vm.count("ant")) usrp->set_rx_antenna(ant, chan);
+    }
+    const double actual_rate = usrp->get_rx_rate(channels.front());
+    std::cout << boost::format("RX rate: %f Msps on %u channels, %.1f Hz per bin") % (actual_rate/1e6) % channels.size() % (actual_rate/fft_size) << std::endl;
+
+    std::vector<band_t> bands;
+    tokens.clear();
+    boost::split(tokens, band_list, boost::is_any_of(", "), boost::token_compress_on);
+    BOOST_FOREACH(const std::string &token, tokens)
+    {
+        if (token.empty()) continue;
+        std::vector<std::string> parts;
+        boost::split(parts, token, boost::is_any_of(":"));
+        if (parts.size() != 2) throw std::runtime_error("bands wants offset:bw, got " + token);
+        band_t band;
+        band.offset = boost::lexical_cast<double>(parts[0]);
+        band.bw = boost::lexical_cast<double>(parts[1]);
+        bands.push_back(band);
+    }
+    if (bands.empty())
+    {
+        band_t band;
+        band.offset = 0;
+        band.bw = actual_rate;
+        bands.push_back(band);
+    }
+
+    uhd::stream_args_t stream_args("fc32", "sc16");
+    stream_args.channels = channels;
+    uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+
+    //the workers, one per channel so the channels transform in parallel
+    report_publisher publisher(udp_addr, vm.count("quiet") != 0);
+    std::vector<boost::shared_ptr<frame_queue> > queues;
+    boost::thread_group workers;
+    for (size_t ch = 0; ch < channels.size(); ch++)
+    {
+        worker_args_t wa;
+        wa.index = ch;
+        wa.chan = channels[ch];
+        wa.lo_freq = usrp->get_rx_freq(channels[ch]);
+        wa.rate = actual_rate;
+        wa.fft_size = fft_size;
+        wa.num_averages = std::max<size_t>(1, size_t(interval*actual_rate/fft_size));
+        wa.window = make_window(window_name, fft_size);
+        wa.bands = bands;
+        frames_dropped[ch] = 0;
+        queues.push_back(boost::shared_ptr<frame_queue>(new frame_queue(std::max<size_t>(2, queue_frames), fft_size)));
+        workers.create_thread(boost::bind(&fft_worker, wa, boost::ref(*queues.back()), boost::ref(publisher)));
+    }
+
+    std::signal(SIGINT, &sig_int_handler);
+    if (duration <= 0) std::cout << "Press Ctrl + C to stop..." << std::endl;
+
+    uhd::stream_cmd_t stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    stream_cmd.stream_now = false;
+    stream_cmd.time_spec = usrp->get_time_now() + uhd::time_spec_t(0.1);
+    rx_stream->issue_stream_cmd(stream_cmd);
+
+    //fill one frame of every channel at a time, straight from the streamer
+    std::vector<frame_t> frames(channels.size());
+    std::vector<bool> have_frame(channels.size(), false);
+    frame_t scratch(fft_size);
+    std::vector<void *> buff_ptrs(channels.size());
+    size_t filled = 0;
+    unsigned long long overflows = 0;
+    uhd::rx_metadata_t md;
+    double timeout = 1.0; //the stream starts in the future
+    const pt::ptime deadline = pt::microsec_clock::universal_time() + pt::microseconds(long(duration*1e6));
+
+    while (not stop_signal_called)
+    {
+        if (duration > 0 and pt::microsec_clock::universal_time() > deadline) break;
+
+        if (filled == 0) for (size_t ch = 0; ch < channels.size(); ch++)
+        {
+            if (not have_frame[ch]) have_frame[ch] = queues[ch]->try_get_free(frames[ch]);
+        }
+        for (size_t ch = 0; ch < channels.size(); ch++)
+        {
+            buff_ptrs[ch] = (have_frame[ch]? &frames[ch].front() : &scratch.front()) + filled;
+        }
+        const size_t num_rx_samps = rx_stream->recv(buff_ptrs, fft_size - filled, md, timeout);
+        timeout = 0.2;
+
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_TIMEOUT) continue;
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW)
+        {
+            //a frame across the gap is no spectrum, start over
+            overflows++;
+            filled = 0;
+            continue;
+        }
+        if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE)
+        {
+            std::cerr << boost::format("Receive error code 0x%x") % int(md.error_code) << std::endl;
+            continue;
+        }
+
+        filled += num_rx_samps;
+        if (filled < fft_size) continue;
+        for (size_t ch = 0; ch < channels.size(); ch++)
+        {
+            if (have_frame[ch]) queues[ch]->put_full(frames[ch]);
+            else frames_dropped[ch]++;
+            have_frame[ch] = false;
+        }
+        filled = 0;
+    }
+
+    rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    BOOST_FOREACH(boost::shared_ptr<frame_queue> &queue, queues) queue->done();
+    workers.join_all();
+
+    std::cout << std::endl;
+    std::cout << boost::format("Overflows: %u") % overflows << std::endl;
+    for (size_t ch = 0; ch < channels.size(); ch++)
+    {
+        std::cout << boost::format("ch%u frames dropped: %u") % channels[ch] % frames_dropped[ch].load() << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
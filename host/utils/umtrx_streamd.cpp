@@ -0,0 +1,231 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_shm_ring.hpp"
+#ifdef THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread.hpp>
+#else // THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread_priority.hpp>
+#endif // THREAD_PRIORITY_HPP_DEPRECATED
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <iostream>
+#include <csignal>
+#include <cstdlib>
+
+namespace po = boost::program_options;
+namespace pt = boost::posix_time;
+
+static boost::atomic<bool> stop_signal_called(false);
+static void sig_int_handler(int)
+{
+    stop_signal_called = true;
+}
+
+static std::vector<size_t> parse_channels(const std::string &list)
+{
+    std::vector<std::string> tokens;
+    boost::split(tokens, list, boost::is_any_of(", "), boost::token_compress_on);
+    std::vector<size_t> channels;
+    BOOST_FOREACH(const std::string &token, tokens)
+    {
+        if (not token.empty()) channels.push_back(boost::lexical_cast<size_t>(token));
+    }
+    return channels;
+}
+
+/***********************************************************************
+ * TX: the bursts of the client that claimed TX, in the order queued
+ **********************************************************************/
+static void tx_loop(umtrx_shm_ring::sptr ring, uhd::tx_streamer::sptr tx_stream)
+{
+    uhd::set_thread_priority_safe();
+    std::vector<const void *> buffs;
+    uhd::tx_metadata_t md;
+    while (not stop_signal_called)
+    {
+        const size_t n = ring->pop_tx(buffs, md);
+        if (n == 0)
+        {
+            boost::this_thread::sleep(pt::microseconds(200));
+            continue;
+        }
+        size_t done = 0;
+        while (done < n and not stop_signal_called)
+        {
+            std::vector<const void *> ptrs(buffs.size());
+            for (size_t ch = 0; ch < buffs.size(); ch++)
+            {
+                ptrs[ch] = static_cast<const umtrx_shm_ring::item_type *>(buffs[ch]) + done;
+            }
+            done += tx_stream->send(ptrs, n - done, md, 1.0);
+            md.has_time_spec = false;
+            md.start_of_burst = false;
+        }
+        ring->tx_done();
+    }
+}
+
+/***********************************************************************
+ * Main
+ * One process owns the device, the others attach to its shared memory
+ * with umtrx_shm_ring: every RX channel for anyone, TX for one at a time.
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    uhd::set_thread_priority_safe();
+
+    std::string args, name, rx_list, tx_list, otw_format, subdev;
+    double rate, rx_freq, tx_freq, rx_gain, tx_gain, ring_secs, tx_ring_secs;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "single uhd device address args")
+        ("name", po::value<std::string>(&name)->default_value("/umtrx_streamd"), "shared memory name the clients attach to")
+        ("rx_channels", po::value<std::string>(&rx_list)->default_value("0"), "comma separated RX channels")
+        ("tx_channels", po::value<std::string>(&tx_list)->default_value(""), "comma separated TX channels, none without TX")
+        ("rate", po::value<double>(&rate)->default_value(1e6), "RX and TX rate")
+        ("rx_freq", po::value<double>(&rx_freq), "RX LO, default leaves it")
+        ("tx_freq", po::value<double>(&tx_freq), "TX LO, default leaves it")
+        ("rx_gain", po::value<double>(&rx_gain), "RX gain, default leaves it")
+        ("tx_gain", po::value<double>(&tx_gain), "TX gain, default leaves it")
+        ("subdev", po::value<std::string>(&subdev), "RX subdevice spec")
+        ("otw", po::value<std::string>(&otw_format)->default_value("sc16"), "over the wire sample format")
+        ("ring_secs", po::value<double>(&ring_secs)->default_value(1.0), "RX history kept for the clients")
+        ("tx_ring_secs", po::value<double>(&tx_ring_secs)->default_value(0.1), "TX samples queued ahead at most")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX stream daemon %s") % desc << std::endl;
+        std::cout << "Shares the streams of one device with several processes through shared memory" << std::endl;
+        return ~0;
+    }
+
+    const std::vector<size_t> rx_channels = parse_channels(rx_list);
+    const std::vector<size_t> tx_channels = parse_channels(tx_list);
+    if (rx_channels.empty()) throw std::runtime_error("share at least one RX channel");
+
+    std::cout << std::endl;
+    std::cout << boost::format("Creating the usrp device with: %s...") % args << std::endl;
+    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(args);
+    if (vm.count("subdev")) usrp->set_rx_subdev_spec(subdev);
+    std::cout << boost::format("Using Device: %s") % usrp->get_pp_string() << std::endl;
+
+    usrp->set_rx_rate(rate);
+    BOOST_FOREACH(const size_t chan, rx_channels)
+    {
+        if (vm.count("rx_freq")) usrp->set_rx_freq(uhd::tune_request_t(rx_freq), chan);
+        if (vm.count("rx_gain")) usrp->set_rx_gain(rx_gain, chan);
+    }
+    const double actual_rate = usrp->get_rx_rate(rx_channels.front());
+    double actual_tx_rate = 0.0;
+    if (not tx_channels.empty())
+    {
+        usrp->set_tx_rate(rate);
+        BOOST_FOREACH(const size_t chan, tx_channels)
+        {
+            if (vm.count("tx_freq")) usrp->set_tx_freq(uhd::tune_request_t(tx_freq), chan);
+            if (vm.count("tx_gain")) usrp->set_tx_gain(tx_gain, chan);
+        }
+        actual_tx_rate = usrp->get_tx_rate(tx_channels.front());
+    }
+
+    //the clients get sc16 as it lands, no conversion on their side
+    uhd::stream_args_t rx_args("sc16", otw_format);
+    rx_args.channels = rx_channels;
+    uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(rx_args);
+    uhd::tx_streamer::sptr tx_stream;
+    if (not tx_channels.empty())
+    {
+        uhd::stream_args_t tx_args("sc16", otw_format);
+        tx_args.channels = tx_channels;
+        tx_stream = usrp->get_tx_stream(tx_args);
+    }
+
+    //a recv() never crosses the ring end, the mirror covers the longest read
+    const size_t max_read = std::max<size_t>(rx_stream->get_max_num_samps(), 1 << 14);
+    const size_t capacity = std::max<size_t>(2*max_read, size_t(ring_secs*actual_rate));
+    umtrx_shm_ring::sptr ring = umtrx_shm_ring::create(name, rx_channels.size(), tx_channels.size(),
+        actual_rate, actual_tx_rate, capacity, max_read, std::max<size_t>(2*max_read, size_t(tx_ring_secs*actual_tx_rate)));
+    std::cout << boost::format("Sharing %u RX and %u TX channels at %f Msps as %s") %
+        rx_channels.size() % tx_channels.size() % (actual_rate/1e6) % name << std::endl;
+
+    std::signal(SIGINT, &sig_int_handler);
+    std::signal(SIGTERM, &sig_int_handler);
+    std::cout << "Press Ctrl + C to stop streaming..." << std::endl;
+
+    boost::thread_group tx_thread;
+    if (tx_stream) tx_thread.create_thread(boost::bind(&tx_loop, ring, tx_stream));
+
+    uhd::stream_cmd_t stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    stream_cmd.stream_now = false;
+    stream_cmd.time_spec = usrp->get_time_now() + uhd::time_spec_t(0.1);
+    rx_stream->issue_stream_cmd(stream_cmd);
+
+    //receive straight into the ring, the position follows the write index
+    const size_t ring_mask = ring->get_capacity() - 1;
+    size_t pos = 0;
+    std::vector<void *> buff_ptrs(rx_channels.size());
+    uhd::rx_metadata_t md;
+    double timeout = 1.0; //the stream starts in the future
+    unsigned long long overflows = 0;
+    pt::ptime next_report = pt::microsec_clock::universal_time() + pt::seconds(10);
+
+    while (not stop_signal_called)
+    {
+        const size_t n = std::min(max_read, ring_mask + 1 - pos);
+        ring->retire(n);
+        for (size_t ch = 0; ch < rx_channels.size(); ch++) buff_ptrs[ch] = ring->rx_ring(ch) + pos;
+        const size_t num_rx_samps = rx_stream->recv(buff_ptrs, n, md, timeout);
+        timeout = 0.2;
+
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW) overflows++;
+        else if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE and
+            md.error_code != uhd::rx_metadata_t::ERROR_CODE_TIMEOUT)
+        {
+            std::cerr << boost::format("Receive error code 0x%x") % int(md.error_code) << std::endl;
+        }
+        if (num_rx_samps != 0)
+        {
+            ring->commit(pos, ring->time_to_index(md.time_spec), num_rx_samps);
+            pos = (pos + num_rx_samps) & ring_mask;
+        }
+
+        if (pt::microsec_clock::universal_time() > next_report)
+        {
+            std::cout << boost::format("%u overflows, %u breaks in the shared stream") % overflows % ring->get_num_overflows() << std::endl;
+            next_report += pt::seconds(10);
+        }
+    }
+
+    rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    tx_thread.join_all();
+    std::cout << std::endl << "Done!" << std::endl << std::endl;
+    return EXIT_SUCCESS;
+}
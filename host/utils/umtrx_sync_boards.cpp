@@ -0,0 +1,108 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "umtrx_multi_sync.hpp"
+#include <uhd/utils/safe_main.hpp>
+#include <boost/program_options.hpp>
+#include <boost/foreach.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <ctime>
+#include <complex>
+
+namespace po = boost::program_options;
+
+/***********************************************************************
+ * Main
+ * The board time keeps counting after the process exits, so boards
+ * aligned here stay aligned for the application that opens them next.
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    std::vector<std::string> boards;
+    std::string time_source;
+    double time_now, verify_rate;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("args", po::value<std::vector<std::string> >(&boards), "device address args, once per board")
+        ("time_source", po::value<std::string>(&time_source)->default_value("external"), "PPS source of every board: external or gpsdo")
+        ("time", po::value<double>(&time_now)->default_value(0.0), "time the boards take on the PPS edge")
+        ("host_time", "take the host UTC seconds instead of --time, for NTP or GPS disciplined hosts")
+        ("verify_rate", po::value<double>(&verify_rate)->default_value(0.0), "start RX on every board together at this rate and compare the first sample times, 0 skips")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help") or boards.empty()){
+        std::cout << boost::format("UmTRX sync boards %s") % desc << std::endl;
+        std::cout << "Aligns the time of several boards on one PPS edge" << std::endl;
+        return ~0;
+    }
+
+    usrp_list_t usrps;
+    BOOST_FOREACH(const std::string &board, boards)
+    {
+        std::cout << boost::format("Creating the usrp device with: %s...") % board << std::endl;
+        usrps.push_back(uhd::usrp::multi_usrp::make(board));
+    }
+    BOOST_FOREACH(uhd::usrp::multi_usrp::sptr usrp, usrps) usrp->set_time_source(time_source);
+
+    uhd::time_spec_t time(time_now);
+    if (vm.count("host_time"))
+    {
+        //the arming edge comes first, the boards take the second after it
+        time = uhd::time_spec_t(double(std::time(NULL) + 2));
+    }
+    const uhd::time_spec_t latched = sync_boards_next_pps(usrps, time);
+    std::cout << boost::format("%u boards took %.6f s on the same PPS") % usrps.size() % latched.get_real_secs() << std::endl;
+
+    if (verify_rate <= 0) return EXIT_SUCCESS;
+
+    //one RX stream per board, all started at one device time
+    std::vector<uhd::rx_streamer::sptr> streams;
+    BOOST_FOREACH(uhd::usrp::multi_usrp::sptr usrp, usrps)
+    {
+        usrp->set_rx_rate(verify_rate);
+        streams.push_back(usrp->get_rx_stream(uhd::stream_args_t("fc32", "sc16")));
+    }
+    const uhd::time_spec_t start = usrps.front()->get_time_now() + uhd::time_spec_t(0.5);
+    start_streams_at(streams, start);
+
+    bool aligned = true;
+    std::vector<std::complex<float> > buff(streams.front()->get_max_num_samps());
+    for (size_t i = 0; i < streams.size(); i++)
+    {
+        uhd::rx_metadata_t md;
+        streams[i]->recv(&buff.front(), buff.size(), md, 2.0);
+        if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE)
+        {
+            std::cerr << boost::format("Board %u: receive error code 0x%x") % i % int(md.error_code) << std::endl;
+            aligned = false;
+        }
+        else if (md.time_spec != start)
+        {
+            std::cerr << boost::format("Board %u: first sample at %.9f s, asked for %.9f s") % i % md.time_spec.get_real_secs() % start.get_real_secs() << std::endl;
+            aligned = false;
+        }
+        streams[i]->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    }
+    std::cout << (aligned? "All boards started on the same sample" : "The boards did not start together") << std::endl;
+    return aligned? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -25,10 +25,18 @@
 #include <boost/thread/thread.hpp>
 #include <boost/math/special_functions/round.hpp>
 #include <boost/random.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/atomic.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <iostream>
+#include <fstream>
 #include <complex>
 #include <cmath>
 #include <ctime>
+#include <limits>
 
 namespace po = boost::program_options;
 
@@ -41,17 +49,148 @@ static size_t failCount = 0;
     std::cout << "Check: " << #expr << " == " << #expected << "\t\t\t" << ((ok)?"OK":"FAIL") << std::endl; \
     if (not ok) std::cout << "\t FAIL: actual = " << actual << std::endl; }
 
+/***********************************************************************
+ * Gain sweep:
+ * Walks the overall gain of every channel together, one batched LMS write
+ * per channel and step, and reads the power from the FPGA RX DSP instead
+ * of capturing samples. A TX sweep transmits a tone and measures it on the
+ * RX of the same channel, through an external loop on the factory jig.
+ **********************************************************************/
+struct sweep_point_t
+{
+    size_t chan;
+    double gain, power;
+};
+
+static void tx_tone_loop(uhd::tx_streamer::sptr tx_stream, const size_t num_chans,
+    const double offset, const double rate, boost::atomic<bool> &running)
+{
+    //one whole number of tone periods ahead of every send
+    const size_t n = tx_stream->get_max_num_samps();
+    const size_t period = std::max<size_t>(1, size_t(rate/std::abs(offset) + 0.5));
+    std::vector<std::complex<float> > buff(period + n);
+    for (size_t i = 0; i < buff.size(); i++){
+        buff[i] = std::polar(0.5f, float(2*M_PI*i/period)*(offset < 0? -1 : 1));
+    }
+    std::vector<const void *> buffs(num_chans);
+    uhd::tx_metadata_t md;
+    md.start_of_burst = true;
+    size_t index = 0;
+    while (running){
+        for (size_t ch = 0; ch < num_chans; ch++) buffs[ch] = &buff[index];
+        tx_stream->send(buffs, n, md);
+        index = (index + n) % period;
+        md.start_of_burst = false;
+    }
+    md.end_of_burst = true;
+    tx_stream->send("", 0, md);
+}
+
+static int run_gain_sweep(uhd::usrp::multi_usrp::sptr usrp, const std::string &dir,
+    const double step, const double settle, const double tone_offset, const std::string &table)
+{
+    uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
+    const uhd::fs_path mb_path = "/mboards/0";
+    const bool is_tx = (dir == "tx");
+    if (not is_tx and dir != "rx") throw std::runtime_error("sweep is rx or tx");
+
+    std::vector<size_t> channels;
+    std::vector<uhd::fs_path> gain_paths, power_paths;
+    const uhd::usrp::subdev_spec_t subdev_spec = usrp->get_rx_subdev_spec();
+    for (size_t ch = 0; ch < usrp->get_rx_num_channels(); ch++){
+        const uhd::fs_path power_path = mb_path / "rx_dsps" / boost::lexical_cast<std::string>(ch) / "sensors" / "power";
+        if (not tree->exists(power_path)) throw std::runtime_error("no RX power readback, the FPGA image is too old for --sweep");
+        channels.push_back(ch);
+        power_paths.push_back(power_path);
+        gain_paths.push_back(mb_path / "dboards" / subdev_spec[ch].db_name / (is_tx? "tx_frontends" : "rx_frontends") / "0" / "gain_total" / "value");
+    }
+    const uhd::meta_range_t range = tree->access<uhd::meta_range_t>(gain_paths.front().branch_path() / "range").get();
+
+    //the readback averages rx_power_avg samples, 1024 by default: let a whole window pass
+    const double rate = usrp->get_rx_rate(channels.front());
+    const double dwell = settle + 2*1024/rate;
+
+    uhd::tx_streamer::sptr tx_stream;
+    boost::atomic<bool> running(true);
+    boost::thread_group tone;
+    if (is_tx){
+        uhd::stream_args_t stream_args("fc32", "sc16");
+        stream_args.channels = channels;
+        tx_stream = usrp->get_tx_stream(stream_args);
+        if (tone_offset == 0) throw std::runtime_error("the TX sweep tone needs an offset from the LO leakage");
+        tone.create_thread(boost::bind(&tx_tone_loop, tx_stream, channels.size(), tone_offset, usrp->get_tx_rate(channels.front()), boost::ref(running)));
+    }
+
+    std::vector<sweep_point_t> points;
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for (double gain = range.start(); gain <= range.stop() + 1e-6; gain += step){
+        std::vector<double> actual(channels.size());
+        for (size_t i = 0; i < channels.size(); i++){
+            tree->access<double>(gain_paths[i]).set(gain);
+            actual[i] = tree->access<double>(gain_paths[i]).get();
+        }
+        boost::this_thread::sleep(boost::posix_time::microseconds(long(dwell*1e6)));
+        for (size_t i = 0; i < channels.size(); i++){
+            sweep_point_t p;
+            p.chan = channels[i];
+            p.gain = actual[i];
+            p.power = tree->access<uhd::sensor_value_t>(power_paths[i]).get().to_real();
+            points.push_back(p);
+        }
+    }
+    const double elapsed = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds()/1e6;
+    running = false;
+    tone.join_all();
+
+    //linearity against a unity slope through the mean of the channel
+    std::ofstream file;
+    if (not table.empty()) file.open(table.c_str());
+    std::ostream &out = table.empty()? std::cout : file;
+    out << "channel, direction, gain, power_dbfs, step_db, linearity_error_db" << std::endl;
+    size_t worst_chan = 0;
+    double worst_error = 0;
+    BOOST_FOREACH(const size_t ch, channels){
+        double offset = 0;
+        size_t num = 0;
+        BOOST_FOREACH(const sweep_point_t &p, points) if (p.chan == ch){
+            offset += p.power - p.gain;
+            num++;
+        }
+        offset /= std::max<size_t>(1, num);
+        double last = std::numeric_limits<double>::quiet_NaN();
+        BOOST_FOREACH(const sweep_point_t &p, points) if (p.chan == ch){
+            const double error = p.power - p.gain - offset;
+            out << boost::format("%u, %s, %.2f, %.2f, %.2f, %.2f") % ch % dir % p.gain % p.power % (p.power - last) % error << std::endl;
+            last = p.power;
+            if (std::abs(error) > std::abs(worst_error)){
+                worst_error = error;
+                worst_chan = ch;
+            }
+        }
+    }
+    std::cout << boost::format("Swept %u %s gains on %u channels in %.2f s, worst linearity error %.2f dB on channel %u")
+        % (points.size()/channels.size()) % dir % channels.size() % elapsed % worst_error % worst_chan << std::endl;
+    if (not table.empty()) std::cout << "wrote gain table to " << table << std::endl;
+    return EXIT_SUCCESS;
+}
+
 /***********************************************************************
  * Main
  **********************************************************************/
 int UHD_SAFE_MAIN(int argc, char *argv[])
 {
-    std::string args;
+    std::string args, sweep, table;
+    double step, settle, tone_offset;
 
     po::options_description desc("Allowed options");
     desc.add_options()
         ("help,h", "help message")
         ("args", po::value<std::string>(&args)->default_value(""), "device address args [default = \"\"]")
+        ("sweep", po::value<std::string>(&sweep), "characterize instead of checking: rx or tx gain against the FPGA power readback")
+        ("step", po::value<double>(&step)->default_value(1.0), "sweep gain step in dB")
+        ("settle", po::value<double>(&settle)->default_value(1e-3), "sweep seconds after a gain change before the readback window")
+        ("tone_offset", po::value<double>(&tone_offset)->default_value(100e3), "TX sweep tone offset from the LO in Hz")
+        ("table", po::value<std::string>(&table)->default_value(""), "sweep CSV output file, default the console")
     ;
 
     po::variables_map vm;
@@ -68,6 +207,8 @@ int UHD_SAFE_MAIN(int argc, char *argv[])
     std::cout << std::endl;
     std::cout << boost::format("Creating the usrp device with: %s...") % args << std::endl;
     uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(args);
+    if (vm.count("sweep")) return run_gain_sweep(usrp, sweep, step, settle, tone_offset, table);
+
     uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
     const uhd::fs_path mb_path = "/mboards/0";
 
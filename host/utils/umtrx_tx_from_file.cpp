@@ -0,0 +1,306 @@
+//
+// Copyright 2026 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifdef THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread.hpp>
+#else // THREAD_PRIORITY_HPP_DEPRECATED
+#  include <uhd/utils/thread_priority.hpp>
+#endif // THREAD_PRIORITY_HPP_DEPRECATED
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/cstdint.hpp>
+#include <iostream>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace po = boost::program_options;
+
+/***********************************************************************
+ * The block header of umtrx_rx_to_file, see there for the layout
+ **********************************************************************/
+static const char BLOCK_MAGIC[8] = {'U', 'M', 'T', 'R', 'X', 'R', 'X', '1'};
+
+static const boost::uint32_t BLOCK_FLAG_DISCONTINUITY = 1 << 1;
+
+struct block_header_t
+{
+    char magic[8];
+    boost::uint32_t header_bytes;
+    boost::uint32_t block_bytes;
+    boost::uint64_t block_index;
+    boost::uint32_t num_channels;
+    boost::uint32_t bytes_per_samp;
+    boost::uint32_t capacity;
+    boost::uint32_t num_samps;
+    boost::int64_t time_full_secs;
+    double time_frac_secs;
+    double rate;
+    boost::uint32_t flags;
+    boost::uint32_t reserved;
+    boost::uint64_t lost_samps;
+};
+
+//! One stretch of samples to send, pointers into the mapping
+struct segment_t
+{
+    std::vector<const void *> buffs; //per TX channel
+    size_t num_samps;
+    bool new_burst; //the recording broke before it
+    uhd::time_spec_t offset; //from the first sample of the recording
+};
+
+static boost::atomic<bool> stop_signal_called(false);
+static void sig_int_handler(int)
+{
+    stop_signal_called = true;
+}
+
+static void tx_async_loop(uhd::tx_streamer::sptr tx_stream, boost::atomic<bool> &stop,
+    boost::atomic<unsigned long long> &underflows, boost::atomic<unsigned long long> &late)
+{
+    uhd::async_metadata_t async_md;
+    while (not stop)
+    {
+        if (not tx_stream->recv_async_msg(async_md, 0.1)) continue;
+        switch (async_md.event_code)
+        {
+        case uhd::async_metadata_t::EVENT_CODE_UNDERFLOW:
+        case uhd::async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET:
+            underflows++;
+            break;
+        case uhd::async_metadata_t::EVENT_CODE_TIME_ERROR:
+            late++;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    uhd::set_thread_priority_safe();
+
+    std::string args, file, channel_list, otw_format, ant, subdev;
+    double rate, freq, gain, start;
+    size_t repeat;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "single uhd device address args")
+        ("file", po::value<std::string>(&file)->default_value("umtrx_rx.dat"), "a umtrx_rx_to_file capture or raw sc16")
+        ("channels", po::value<std::string>(&channel_list)->default_value("0"), "TX channels for the recorded channels in order")
+        ("rate", po::value<double>(&rate), "TX rate, default the rate of the capture, needed for raw files")
+        ("freq", po::value<double>(&freq), "TX LO, default leaves it")
+        ("gain", po::value<double>(&gain), "TX gain, default leaves it")
+        ("ant", po::value<std::string>(&ant), "TX antenna")
+        ("subdev", po::value<std::string>(&subdev), "TX subdevice spec")
+        ("start", po::value<double>(&start)->default_value(0.5), "seconds from now to the first sample")
+        ("repeat", po::value<size_t>(&repeat)->default_value(1), "times to play the file, 0 until ctrl+c")
+        ("otw", po::value<std::string>(&otw_format)->default_value("sc16"), "over the wire sample format")
+        ("keep_gaps", "replay the time breaks of the capture as gaps between bursts")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UmTRX TX from file %s") % desc << std::endl;
+        std::cout << "Sends a capture straight from its memory mapping" << std::endl;
+        return ~0;
+    }
+
+    std::vector<std::string> tokens;
+    boost::split(tokens, channel_list, boost::is_any_of(", "), boost::token_compress_on);
+    std::vector<size_t> channels;
+    BOOST_FOREACH(const std::string &token, tokens)
+    {
+        if (not token.empty()) channels.push_back(boost::lexical_cast<size_t>(token));
+    }
+    if (channels.empty()) throw std::runtime_error("no TX channels");
+
+    //map the whole file, the kernel reads ahead of the sender
+    const int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("cannot open " + file + ": " + std::strerror(errno));
+    struct stat st;
+    if (::fstat(fd, &st) != 0 or st.st_size == 0) throw std::runtime_error("cannot size " + file);
+    const size_t file_bytes = size_t(st.st_size);
+    void *map = ::mmap(NULL, file_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) throw std::runtime_error("cannot map " + file + ": " + std::strerror(errno));
+    ::madvise(map, file_bytes, MADV_SEQUENTIAL);
+    const char *base = static_cast<const char *>(map);
+
+    //split the file into segments, a capture has one per block
+    std::vector<segment_t> segments;
+    std::string cpu_format = "sc16";
+    double file_rate = 0;
+    block_header_t first;
+    const bool is_capture = file_bytes >= sizeof(first) and std::memcmp(base, BLOCK_MAGIC, sizeof(BLOCK_MAGIC)) == 0;
+    if (is_capture)
+    {
+        std::memcpy(&first, base, sizeof(first));
+        file_rate = first.rate;
+        if (first.bytes_per_samp == 8) cpu_format = "fc32";
+        else if (first.bytes_per_samp != 4) throw std::runtime_error("capture samples are neither sc16 nor fc32");
+        const uhd::time_spec_t t0(time_t(first.time_full_secs), first.time_frac_secs);
+        for (size_t offset = 0; offset + first.block_bytes <= file_bytes; offset += first.block_bytes)
+        {
+            block_header_t header;
+            std::memcpy(&header, base + offset, sizeof(header));
+            if (std::memcmp(header.magic, BLOCK_MAGIC, sizeof(BLOCK_MAGIC)) != 0 or header.num_samps == 0) continue;
+            segment_t seg;
+            for (size_t i = 0; i < channels.size(); i++)
+            {
+                //fewer recorded channels than TX ones repeat the last
+                const size_t ch = std::min<size_t>(i, header.num_channels - 1);
+                seg.buffs.push_back(base + offset + header.header_bytes + ch*header.capacity*header.bytes_per_samp);
+            }
+            seg.num_samps = header.num_samps;
+            seg.new_burst = (header.flags & BLOCK_FLAG_DISCONTINUITY) != 0;
+            seg.offset = uhd::time_spec_t(time_t(header.time_full_secs), header.time_frac_secs) - t0;
+            segments.push_back(seg);
+        }
+    }
+    else
+    {
+        //raw sc16 of one channel, sent on every TX channel
+        segment_t seg;
+        seg.buffs.assign(channels.size(), base);
+        seg.num_samps = file_bytes/4;
+        seg.new_burst = false;
+        segments.push_back(seg);
+    }
+    if (segments.empty()) throw std::runtime_error("no samples in " + file);
+    if (not vm.count("rate"))
+    {
+        if (file_rate <= 0) throw std::runtime_error("a raw file needs --rate");
+        rate = file_rate;
+    }
+
+    std::cout << std::endl;
+    std::cout << boost::format("Creating the usrp device with: %s...") % args << std::endl;
+    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(args);
+    if (vm.count("subdev")) usrp->set_tx_subdev_spec(subdev);
+    std::cout << boost::format("Using Device: %s") % usrp->get_pp_string() << std::endl;
+
+    usrp->set_tx_rate(rate);
+    BOOST_FOREACH(const size_t chan, channels)
+    {
+        if (vm.count("freq")) usrp->set_tx_freq(uhd::tune_request_t(freq), chan);
+        if (vm.count("gain")) usrp->set_tx_gain(gain, chan);
+        if (vm.count("ant")) usrp->set_tx_antenna(ant, chan);
+    }
+    const double actual_rate = usrp->get_tx_rate(channels.front());
+    if (file_rate > 0 and std::abs(actual_rate - file_rate) > 1.0) std::cout << boost::format(
+        "Warning: the capture is at %f Msps, sending at %f Msps") % (file_rate/1e6) % (actual_rate/1e6) << std::endl;
+
+    //the cpu format of the file, so the sender reads the mapping as it is
+    uhd::stream_args_t stream_args(cpu_format, otw_format);
+    stream_args.channels = channels;
+    uhd::tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args);
+
+    boost::atomic<bool> stop(false);
+    boost::atomic<unsigned long long> underflows(0), late(0);
+    boost::thread async_thread(boost::bind(&tx_async_loop, tx_stream, boost::ref(stop), boost::ref(underflows), boost::ref(late)));
+    std::signal(SIGINT, &sig_int_handler);
+
+    const bool keep_gaps = vm.count("keep_gaps") != 0;
+    unsigned long long total_samps = 0;
+    uhd::time_spec_t pass_time = usrp->get_time_now() + uhd::time_spec_t(start);
+    uhd::tx_metadata_t md;
+    for (size_t pass = 0; (repeat == 0 or pass < repeat) and not stop_signal_called; pass++)
+    {
+        //every pass is a burst, or one per unbroken stretch with keep_gaps
+        md.start_of_burst = true;
+        md.end_of_burst = false;
+        md.has_time_spec = true;
+        md.time_spec = pass_time;
+        uhd::time_spec_t next_time = pass_time;
+        for (size_t i = 0; i < segments.size() and not stop_signal_called; i++)
+        {
+            const segment_t &seg = segments[i];
+            if (keep_gaps and seg.new_burst and i != 0)
+            {
+                md.end_of_burst = true;
+                tx_stream->send(std::vector<const void *>(channels.size(), seg.buffs.front()), 0, md);
+                md.start_of_burst = true;
+                md.end_of_burst = false;
+                md.has_time_spec = true;
+                md.time_spec = pass_time + seg.offset;
+            }
+            md.end_of_burst = (i + 1 == segments.size());
+            size_t sent = 0;
+            while (sent < seg.num_samps and not stop_signal_called)
+            {
+                std::vector<const void *> buffs(seg.buffs.size());
+                for (size_t ch = 0; ch < buffs.size(); ch++)
+                {
+                    buffs[ch] = static_cast<const char *>(seg.buffs[ch]) + sent*((cpu_format == "fc32")? 8 : 4);
+                }
+                const size_t n = tx_stream->send(buffs, seg.num_samps - sent, md, 1.0);
+                sent += n;
+                total_samps += n;
+                if (n != 0)
+                {
+                    md.start_of_burst = false;
+                    md.has_time_spec = false;
+                }
+            }
+            next_time = (keep_gaps? pass_time + seg.offset : next_time) + uhd::time_spec_t::from_ticks(seg.num_samps, actual_rate);
+        }
+        pass_time = next_time + uhd::time_spec_t(0.001); //a short gap between passes
+    }
+    if (stop_signal_called)
+    {
+        md.start_of_burst = false;
+        md.end_of_burst = true;
+        md.has_time_spec = false;
+        tx_stream->send(std::vector<const void *>(channels.size(), base), 0, md);
+    }
+
+    //let the last burst leave the device before reporting
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+    stop = true;
+    async_thread.join();
+    ::munmap(map, file_bytes);
+    ::close(fd);
+
+    std::cout << std::endl;
+    std::cout << boost::format("Sent %u samples per channel from %s") % total_samps % file << std::endl;
+    std::cout << boost::format("Underflows: %u, late: %u") % underflows.load() % late.load() << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -26,9 +26,12 @@
 #include <uhd/property_tree.hpp>
 #include <uhd/usrp/multi_usrp.hpp>
 #include <uhd/usrp/dboard_eeprom.hpp>
+#include <uhd/types/sensors.hpp>
 #include <uhd/version.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/format.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/math/special_functions/round.hpp>
 #include <iostream>
@@ -37,6 +40,8 @@
 #include <cmath>
 #include <fstream>
 #include <atomic>
+#include <limits>
+#include <algorithm>
 
 namespace fs = boost::filesystem;
 
@@ -89,6 +94,115 @@ static inline double compute_tone_dbrms(
     return 20*std::log10(std::abs(average/float(samples.size())));
 }
 
+/***********************************************************************
+ * Streaming power of a tone
+ **********************************************************************/
+/*!
+ * Single bin DFT (Goertzel style) accumulated over received buffers in place.
+ * The samples are split into blocks; the spread of the block estimates
+ * tells how settled the tone level is, so a capture can stop early.
+ */
+class tone_detector{
+public:
+    tone_detector(const double freq = 0.0, const size_t block_len = 1000):
+        _rot(std::polar(1.0, -freq*tau)),
+        _block_len(block_len)
+    {
+        this->reset();
+    }
+
+    //! forget the accumulated samples, the frequency is kept
+    void reset(void){
+        _phasor = 1.0;
+        _sum = _block_sum = _blocks_sum = 0.0;
+        _blocks_sqsum = 0.0;
+        _count = _block_count = _num_blocks = 0;
+    }
+
+    void update(const samp_type *samps, const size_t nsamps){
+        for (size_t i = 0; i < nsamps; i++){
+            _block_sum += _phasor * std::complex<double>(samps[i]);
+            _phasor *= _rot;
+            if (++_block_count == _block_len) this->end_block();
+        }
+        _count += nsamps;
+    }
+
+    //! tone level in dB rms over every sample seen, as compute_tone_dbrms()
+    double dbrms(void) const{
+        const std::complex<double> sum = _sum + _block_sum;
+        return 20*std::log10(std::abs(sum/double(_count)));
+    }
+
+    //! standard error of the level in dB, infinite until a few blocks are in
+    double error_db(void) const{
+        if (_num_blocks < 4) return std::numeric_limits<double>::infinity();
+        const double k = double(_num_blocks);
+        const std::complex<double> mean = _blocks_sum/k;
+        const double var = std::max(0.0, (_blocks_sqsum - k*std::norm(mean))/(k - 1));
+        const double rel = std::sqrt(var/k)/std::abs(mean);
+        return 20*std::log10(1 + rel);
+    }
+
+    size_t count(void) const{
+        return _count;
+    }
+
+private:
+    void end_block(void){
+        const std::complex<double> block_mean = _block_sum/double(_block_len);
+        _blocks_sum += block_mean;
+        _blocks_sqsum += std::norm(block_mean);
+        _num_blocks++;
+        _sum += _block_sum;
+        _block_sum = 0.0;
+        _block_count = 0;
+        _phasor /= std::abs(_phasor); //keep the recursive rotation from drifting
+    }
+
+    std::complex<double> _rot, _phasor;
+    std::complex<double> _sum, _block_sum, _blocks_sum;
+    double _blocks_sqsum;
+    size_t _block_len;
+    size_t _count, _block_count, _num_blocks;
+};
+
+/***********************************************************************
+ * Power of a tone measured by the FPGA
+ **********************************************************************/
+/*!
+ * The single bin tone meter of an RX DSP: no streaming, the device sums
+ * the bin and the host only reads the result. Needs the rx_tone FPGA
+ * capability. The DSP of a calibration channel is the one of its index.
+ */
+class hw_tone_meter{
+public:
+    hw_tone_meter(uhd::usrp::multi_usrp::sptr usrp, const size_t chan, const size_t nsamps):
+        _tree(usrp->get_device()->get_tree()),
+        _path(str(boost::format("/mboards/0/rx_dsps/%u") % chan))
+    {
+        if (not _tree->exists(_path / "tone" / "length")) throw std::runtime_error(
+            "this FPGA image has no tone meter, measure on the host instead");
+        _tree->access<size_t>(_path / "tone" / "length").set(nsamps);
+    }
+
+    ~hw_tone_meter(void){
+        try{_tree->access<size_t>(_path / "tone" / "length").set(0);}
+        catch(...){}
+    }
+
+    //! tone level at freq (Hz of the rx rate) in dB rms, as compute_tone_dbrms(),
+    //! restarts the meter so that only samples after the last setting count
+    double dbrms(const double freq){
+        _tree->access<double>(_path / "tone" / "freq").set(freq);
+        return _tree->access<uhd::sensor_value_t>(_path / "sensors" / "tone").get().to_real();
+    }
+
+private:
+    uhd::property_tree::sptr _tree;
+    const uhd::fs_path _path;
+};
+
 /***********************************************************************
  * Write a dat file
  **********************************************************************/
@@ -105,16 +219,31 @@ static inline void write_samples_to_file(
  **********************************************************************/
 static std::string get_serial(
     uhd::usrp::multi_usrp::sptr usrp,
-    const std::string &tx_rx
+    const std::string &tx_rx,
+    const size_t chan = 0
 ){
     uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
-    // Will work on 1st subdev, top-level must make sure it's the right one
+    // Will work on the chan's subdev, top-level must make sure it's the right one
     uhd::usrp::subdev_spec_t subdev_spec = usrp->get_rx_subdev_spec();
-    const uhd::fs_path db_path = "/mboards/0/dboards/" + subdev_spec[0].db_name + "/" + tx_rx + "_eeprom";
+    const uhd::fs_path db_path = "/mboards/0/dboards/" + subdev_spec[chan].db_name + "/" + tx_rx + "_eeprom";
     const uhd::usrp::dboard_eeprom_t db_eeprom = tree->access<uhd::usrp::dboard_eeprom_t>(db_path).get();
     return db_eeprom.serial;
 }
 
+/***********************************************************************
+ * Retrieve d'board temperature, NaN without a sensor
+ **********************************************************************/
+static double get_temperature(
+    uhd::usrp::multi_usrp::sptr usrp,
+    const size_t chan = 0
+){
+    uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
+    uhd::usrp::subdev_spec_t subdev_spec = usrp->get_rx_subdev_spec();
+    const uhd::fs_path temp_path = "/mboards/0/sensors/temp" + subdev_spec[chan].db_name;
+    if (not tree->exists(temp_path)) return std::numeric_limits<double>::quiet_NaN();
+    return tree->access<uhd::sensor_value_t>(temp_path).get().to_real();
+}
+
 /***********************************************************************
  * Convert integer calibration values to floats
  **********************************************************************/
@@ -131,12 +260,14 @@ static void store_results(
     const std::vector<result_t> &results,
     const std::string &rx_tx, // "tx" or "rx"
     const std::string &what,  // Type of test, e.g. "iq"
-    bool append
+    bool append,
+    const size_t chan = 0
 ){
     std::ofstream cal_data;
     bool write_header=true;
     std::string rx_tx_upper = boost::to_upper_copy(rx_tx);
-    std::string serial = get_serial(usrp, rx_tx);
+    std::string serial = get_serial(usrp, rx_tx, chan);
+    const double temperature = get_temperature(usrp, chan); //the corrections are indexed by it too
 
     //make the calibration file path
     //UHD4 deprecated get_app_path and uses designated calibration path (introduced earlier)
@@ -169,9 +300,9 @@ static void store_results(
         cal_data << boost::format("DATA STARTS HERE\n");
         // For DC calibration we also store LMS6002D integer values
         if (what == "dc")
-            cal_data << "lo_frequency, correction_real, correction_imag, measured, delta, int_i, int_q\n";
+            cal_data << "lo_frequency, correction_real, correction_imag, measured, delta, int_i, int_q, temperature\n";
         else
-            cal_data << "lo_frequency, correction_real, correction_imag, measured, delta\n";
+            cal_data << "lo_frequency, correction_real, correction_imag, measured, delta, temperature\n";
     }
 
     for (size_t i = 0; i < results.size(); i++){
@@ -190,6 +321,7 @@ static void store_results(
             cal_data << ", " << results[i].real_corr;
             cal_data << ", " << results[i].imag_corr;
         }
+        cal_data << ", " << temperature;
         cal_data << "\n";
     }
 
@@ -236,14 +368,76 @@ static void capture_samples(
     }
 }
 
+/***********************************************************************
+ * Streaming capture into tone detectors
+ * The buffer is only scratch space for recv and keeps its size between
+ * calls. With a non-zero tolerance (dB) the capture stops as soon as
+ * every detector has settled, otherwise nsamps_requested are used.
+ **********************************************************************/
+static void capture_tones(
+    uhd::rx_streamer::sptr rx_stream,
+    std::vector<samp_type > &buff,
+    tone_detector *detectors,
+    const size_t num_detectors,
+    const size_t nsamps_requested,
+    const double tolerance_db = 0.0
+){
+    if (buff.size() < 8*rx_stream->get_max_num_samps()) buff.resize(8*rx_stream->get_max_num_samps());
+    uhd::rx_metadata_t md;
+
+    for (int i=0; i<10; i++) {
+        for (size_t j = 0; j < num_detectors; j++) detectors[j].reset();
+
+        uhd::stream_cmd_t stream_cmd(uhd::stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE);
+        stream_cmd.num_samps = nsamps_requested;
+        stream_cmd.stream_now = true;
+        rx_stream->issue_stream_cmd(stream_cmd);
+
+        size_t num_rx_samps = 0;
+        bool settled = false;
+        while (num_rx_samps < nsamps_requested){
+            const size_t n = rx_stream->recv(&buff.front(), std::min(buff.size(), nsamps_requested - num_rx_samps), md);
+            if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_TIMEOUT) break;
+            if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE
+             && md.error_code != uhd::rx_metadata_t::ERROR_CODE_OVERFLOW){
+                throw std::runtime_error(str(boost::format(
+                    "Unexpected error code 0x%x"
+                ) % md.error_code));
+            }
+            for (size_t j = 0; j < num_detectors; j++) detectors[j].update(&buff.front(), n);
+            num_rx_samps += n;
+            if (md.end_of_burst) break;
+
+            settled = tolerance_db > 0.0;
+            for (size_t j = 0; j < num_detectors and settled; j++){
+                settled = detectors[j].error_db() < tolerance_db;
+            }
+            if (settled) break;
+        }
+
+        //cut the rest of the burst short, so it does not leak into the next capture
+        if (settled){
+            rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+            while (rx_stream->recv(&buff.front(), buff.size(), md, 0.1) > 0 and not md.end_of_burst){}
+            return;
+        }
+
+        //we can live if all the data didnt come in
+        if (num_rx_samps > nsamps_requested/2) return;
+    }
+
+    throw std::runtime_error("did not get all the samples requested");
+}
+
 /***********************************************************************
  * Transmit thread
  **********************************************************************/
-static void tx_thread(uhd::usrp::multi_usrp::sptr usrp, const double tx_wave_freq, const double tx_wave_ampl, std::atomic<bool> &interrupted){
+static void tx_thread(uhd::usrp::multi_usrp::sptr usrp, const double tx_wave_freq, const double tx_wave_ampl, std::atomic<bool> &interrupted, const size_t chan){
     uhd::set_thread_priority_safe();
 
     //create a transmit streamer
     uhd::stream_args_t stream_args("fc32"); //complex floats
+    stream_args.channels = std::vector<size_t>(1, chan);
     uhd::tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args);
 
     //setup variables and allocate buffer
@@ -253,10 +447,30 @@ static void tx_thread(uhd::usrp::multi_usrp::sptr usrp, const double tx_wave_fre
 
     //values for the wave table lookup
     size_t index = 0;
-    const double tx_rate = usrp->get_tx_rate();
+    const double tx_rate = usrp->get_tx_rate(chan);
     const size_t step = boost::math::iround(wave_table_len * tx_wave_freq/tx_rate);
     wave_table table(tx_wave_ampl);
 
+    //one table length is a whole number of periods, the device can repeat it from the SRAM
+    uhd::property_tree::sptr tree = usrp->get_device()->get_tree();
+    const uhd::fs_path loop_path = "/mboards/0/tx_dsps/" + boost::lexical_cast<std::string>(chan) + "/loop";
+    if (tree->exists(loop_path)){
+        tree->access<std::string>(loop_path).set("load");
+        std::vector<samp_type> wave(wave_table_len);
+        for (size_t i = 0; i < wave.size(); i++){
+            wave[i] = table(index += step);
+        }
+        tx_stream->send(&wave.front(), wave.size(), md, 1.0);
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10)); //the last packets reach the SRAM
+        tree->access<std::string>(loop_path).set("play");
+
+        while (not interrupted){
+            boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+        }
+        tree->access<std::string>(loop_path).set("off");
+        return;
+    }
+
     //fill buff and send until interrupted
     while (not interrupted){
         for (size_t i = 0; i < buff.size(); i++){
@@ -270,25 +484,47 @@ static void tx_thread(uhd::usrp::multi_usrp::sptr usrp, const double tx_wave_fre
     tx_stream->send("", 0, md);
 }
 
+/***********************************************************************
+ * Wait for the RX and TX LO of a channel to lock
+ * Falls back to a fixed settle time without the lo_locked sensors.
+ **********************************************************************/
+static const long lo_settle_ms = 10;
+static const long lo_lock_timeout_ms = 100;
+
+static bool wait_lo_locked(uhd::usrp::multi_usrp::sptr usrp, const size_t chan = 0){
+    if (not uhd::has(usrp->get_rx_sensor_names(chan), "lo_locked") or not uhd::has(usrp->get_tx_sensor_names(chan), "lo_locked")){
+        boost::this_thread::sleep(boost::posix_time::milliseconds(lo_settle_ms));
+        return true;
+    }
+
+    for (long i = 0; i < lo_lock_timeout_ms; i++){
+        if (usrp->get_rx_sensor("lo_locked", chan).to_bool() and usrp->get_tx_sensor("lo_locked", chan).to_bool()) return true;
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    UHD_MSG(warning) << boost::format("LO of channel %u did not lock at %f MHz") % chan % (usrp->get_tx_freq(chan)/1e6) << std::endl;
+    return false;
+}
+
 /***********************************************************************
  * Tune RX and TX routine
  **********************************************************************/
-static double tune_rx_and_tx(uhd::usrp::multi_usrp::sptr usrp, const double tx_lo_freq, const double rx_offset){
+static double tune_rx_and_tx(uhd::usrp::multi_usrp::sptr usrp, const double tx_lo_freq, const double rx_offset, const size_t chan = 0){
     //tune the transmitter with no cordic
     uhd::tune_request_t tx_tune_req(tx_lo_freq);
     tx_tune_req.dsp_freq_policy = uhd::tune_request_t::POLICY_MANUAL;
     tx_tune_req.dsp_freq = 0;
-    usrp->set_tx_freq(tx_tune_req);
+    usrp->set_tx_freq(tx_tune_req, chan);
 
     //tune the receiver
-    usrp->set_rx_freq(uhd::tune_request_t(usrp->get_tx_freq(), rx_offset));
+    usrp->set_rx_freq(uhd::tune_request_t(usrp->get_tx_freq(chan), rx_offset), chan);
 
-    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
-    return usrp->get_tx_freq();
+    wait_lo_locked(usrp, chan);
+    return usrp->get_tx_freq(chan);
 }
 
 /***********************************************************************
  * Setup function
+ * which is a side ("A" or "B") or several of them ("AB"), one channel each
  **********************************************************************/
 static uhd::usrp::multi_usrp::sptr setup_usrp_for_cal(const std::string &args, const std::string &which, std::string &serial,
                                                       int vga1_gain, int vga2_gain, int rx_gain, int verbose)
@@ -306,34 +542,42 @@ static uhd::usrp::multi_usrp::sptr setup_usrp_for_cal(const std::string &args, c
     }
 
     //set subdev spec
-    usrp->set_rx_subdev_spec(which+":0");
-    usrp->set_tx_subdev_spec(which+":0");
-
-    UHD_MSG(status) << "Running calibration for " << usrp->get_tx_subdev_name(0) << std::endl;
-    serial = get_serial(usrp, "tx");
-    UHD_MSG(status) << "Daughterboard serial: " << serial << std::endl;
+    std::string subdev;
+    for (size_t chan = 0; chan < which.size(); chan++){
+        subdev += std::string(chan? " " : "") + which[chan] + ":0";
+    }
+    usrp->set_rx_subdev_spec(subdev);
+    usrp->set_tx_subdev_spec(subdev);
 
-    //set the antennas to cal
-    if (not uhd::has(usrp->get_rx_antennas(), "CAL") or not uhd::has(usrp->get_tx_antennas(), "CAL")){
-        throw std::runtime_error("This board does not have the CAL antenna option, cannot self-calibrate.");
+    for (size_t chan = 0; chan < which.size(); chan++)
+    {
+        UHD_MSG(status) << "Running calibration for " << usrp->get_tx_subdev_name(chan) << std::endl;
+        const std::string chan_serial = get_serial(usrp, "tx", chan);
+        if (chan == 0) serial = chan_serial;
+        UHD_MSG(status) << "Daughterboard serial: " << chan_serial << std::endl;
+
+        //set the antennas to cal
+        if (not uhd::has(usrp->get_rx_antennas(chan), "CAL") or not uhd::has(usrp->get_tx_antennas(chan), "CAL")){
+            throw std::runtime_error("This board does not have the CAL antenna option, cannot self-calibrate.");
+        }
+        usrp->set_rx_antenna("CAL", chan);
+        usrp->set_tx_antenna("CAL", chan);
+
+        //set optimum defaults
+        //  GSM symbol rate * 4
+        usrp->set_tx_rate(13e6/12, chan);
+        usrp->set_rx_rate(13e6/12, chan);
+        //  500kHz LPF
+        usrp->set_tx_bandwidth(1e6, chan);
+        usrp->set_rx_bandwidth(1e6, chan);
+        // Our recommended VGA1/VGA2
+        usrp->set_tx_gain(vga1_gain, "VGA1", chan);
+        usrp->set_tx_gain(vga2_gain, "VGA2", chan);
+        usrp->set_rx_gain(rx_gain, chan);
+        if (verbose) printf("actual Tx VGA1 gain = %.0f dB\n", usrp->get_tx_gain("VGA1", chan));
+        if (verbose) printf("actual Tx VGA2 gain = %.0f dB\n", usrp->get_tx_gain("VGA2", chan));
+        if (verbose) printf("actual Rx gain = %.0f dB\n", usrp->get_rx_gain(chan));
     }
-    usrp->set_rx_antenna("CAL");
-    usrp->set_tx_antenna("CAL");
-
-    //set optimum defaults
-    //  GSM symbol rate * 4
-    usrp->set_tx_rate(13e6/12);
-    usrp->set_rx_rate(13e6/12);
-    //  500kHz LPF
-    usrp->set_tx_bandwidth(1e6);
-    usrp->set_rx_bandwidth(1e6);
-    // Our recommended VGA1/VGA2
-    usrp->set_tx_gain(vga1_gain, "VGA1");
-    usrp->set_tx_gain(vga2_gain, "VGA2");
-    usrp->set_rx_gain(rx_gain);
-    if (verbose) printf("actual Tx VGA1 gain = %.0f dB\n", usrp->get_tx_gain("VGA1"));
-    if (verbose) printf("actual Tx VGA2 gain = %.0f dB\n", usrp->get_tx_gain("VGA2"));
-    if (verbose) printf("actual Rx gain = %.0f dB\n", usrp->get_rx_gain());
 
     return usrp;
 }
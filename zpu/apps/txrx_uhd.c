@@ -20,10 +20,15 @@
 #include "umtrx_init.h"
 #include "spi.h"
 #include "i2c.h"
+#include "i2c_async.h"
+#include "umtrx_sensors.h"
+#include "lms6002d.h"
 #include "hal_io.h"
 #include "pic.h"
+#include "memory_map.h"
 #ifdef UMTRX
 #  include "gpsdo.h"
+#  include "gps_time.h"
 #endif
 
 //printf headers
@@ -51,6 +56,12 @@
 //virtual registers in the firmware to store persistent values
 static uint32_t fw_regs[8];
 
+//set by the ctrl port handler, the main loop times the response
+static bool ctrl_pkt_handled;
+
+//packets handled before the main loop runs the next background job
+#define MAX_PKTS_PER_PASS 4
+
 static void handle_udp_data_packet(
     struct socket_address src, struct socket_address dst,
     unsigned char *payload, int payload_len
@@ -59,6 +70,8 @@ static void handle_udp_data_packet(
     //shut all systems down that could send packets to the host
     if (payload == NULL)
     {
+        arp_cache_unpin(&src.addr);
+
         //clear the tx SRAM (both channels)
         output_regs->sram_clear = 1;
 
@@ -90,22 +103,309 @@ static void handle_udp_data_packet(
     }
 
     //handle an incoming UDP packet
-    if (payload_len < sizeof(usrp2_stream_ctrl_t)) return;
+    if (payload_len < offsetof(usrp2_stream_ctrl_t, qos)) return;
     const usrp2_stream_ctrl_t *stream_ctrl = (const usrp2_stream_ctrl_t *)payload;
     const size_t which = stream_ctrl->which;
+    const uint32_t qos = (payload_len < offsetof(usrp2_stream_ctrl_t, dst_addr))? 0 : stream_ctrl->qos;
 
+    //the stream host stays in the cache however many others talk to us
     eth_mac_addr_t eth_mac_host; arp_cache_lookup_mac(&src.addr, &eth_mac_host);
-    setup_framer(eth_mac_host, *ethernet_mac_addr(), src, dst, which);
+    arp_cache_pin(&src.addr, &eth_mac_host);
+
+    //another port, host or multicast group than the sender, zero keeps the sender's
+    if (payload_len >= sizeof(usrp2_stream_ctrl_t) && (stream_ctrl->dst_addr != 0 || stream_ctrl->dst_port != 0)){
+        struct socket_address stream_dst = src;
+        if (stream_ctrl->dst_addr != 0) stream_dst.addr.addr = stream_ctrl->dst_addr;
+        if (stream_ctrl->dst_port != 0) stream_dst.port = stream_ctrl->dst_port;
+        setup_framer_to(stream_dst, dst, which, qos);
+        return;
+    }
+    setup_framer(eth_mac_host, *ethernet_mac_addr(), src, dst, which, qos);
 }
 
 #define OTW_GPIO_BANK_TO_NUM(bank) \
     (((bank) == USRP2_DIR_RX)? (GPIO_RX_BANK) : (GPIO_TX_BANK))
 
+/*
+ * Replies to the last control requests. The host sends a request again
+ * with the same seq when its reply is late, a repeat gets the reply again
+ * instead of running twice. The host keeps up to 4 requests in flight.
+ * Batch and EEPROM replies stay in their own buffers, only the newest
+ * of each kind can be sent again.
+ */
+#define CTRL_REPLY_SLOTS 4
+
+typedef struct{
+    struct socket_address dst;
+    uint32_t seq;
+    uint32_t hash; //of the request, a new request may reuse a seq
+    const void *buff; //the reply, NULL when the slot is free
+    size_t len;
+    usrp2_ctrl_data_t data; //plain replies are copied here
+} ctrl_reply_t;
+
+static ctrl_reply_t ctrl_replies[CTRL_REPLY_SLOTS];
+static int ctrl_reply_next;
+static uint32_t ctrl_request_seq, ctrl_request_hash; //of the request being handled
+
+static uint32_t ctrl_hash(const unsigned char *payload, int payload_len){
+    const uint32_t *words = (const uint32_t *)payload;
+    uint32_t hash = payload_len;
+    for (int i = 0; i < payload_len/4; i++) hash = ((hash << 5) | (hash >> 27)) ^ words[i];
+    return hash;
+}
+
+static bool ctrl_reply_resend(struct socket_address src){
+    for (int i = 0; i < CTRL_REPLY_SLOTS; i++){
+        const ctrl_reply_t *r = &ctrl_replies[i];
+        if (r->buff == NULL || r->seq != ctrl_request_seq || r->hash != ctrl_request_hash) continue;
+        if (r->dst.port != src.port || r->dst.addr.addr != src.addr.addr) continue;
+        send_udp_pkt(USRP2_UDP_CTRL_PORT, src, r->buff, r->len);
+        return true;
+    }
+    return false;
+}
+
+static void send_ctrl_reply(struct socket_address dst, const void *buff, size_t len){
+    send_udp_pkt(USRP2_UDP_CTRL_PORT, dst, buff, len);
+
+    //a shared buffer only holds the newest reply
+    for (int i = 0; i < CTRL_REPLY_SLOTS; i++){
+        if (ctrl_replies[i].buff == buff) ctrl_replies[i].buff = NULL;
+    }
+    ctrl_reply_t *r = &ctrl_replies[ctrl_reply_next];
+    ctrl_reply_next = (ctrl_reply_next + 1) % CTRL_REPLY_SLOTS;
+    r->dst = dst;
+    r->seq = ctrl_request_seq;
+    r->hash = ctrl_request_hash;
+    r->len = len;
+    if (len <= sizeof(r->data)){
+        memcpy(&r->data, buff, len);
+        r->buff = &r->data;
+    }
+    else r->buff = buff;
+}
+
+//the bootloader keeps the small blocking I2C only
+#if !defined(NO_SPI_I2C) && !defined(BOOTLOADER)
+#define I2C_CTRL_ASYNC
+#endif
+
+#ifdef I2C_CTRL_ASYNC
+/*
+ * Host I2C requests run on the interrupt driven engine and return to the
+ * main loop, the reply goes out from the completion. One transaction at
+ * a time: blocking I2C users and the next request wait for it first.
+ * Transfers beyond the engine buffer stay blocking.
+ */
+static struct{
+    volatile bool busy;
+    struct socket_address src;
+    uint32_t seq, hash; //of the request, for the reply cache
+    usrp2_ctrl_data_t reply;
+} i2c_ctrl;
+
+static void i2c_ctrl_done(void){
+    if (!i2c_ctrl.busy) return; //an error outside a host transaction
+    if (i2c_ctrl.reply.id == USRP2_CTRL_ID_HERES_THE_I2C_DATA_DUDE && !i2c_async_failed()){
+        i2c_async_data_ready(i2c_ctrl.reply.data.i2c_args.data);
+    }
+    //the reply belongs to the queued request, not the one being handled
+    const uint32_t seq = ctrl_request_seq, hash = ctrl_request_hash;
+    ctrl_request_seq = i2c_ctrl.seq;
+    ctrl_request_hash = i2c_ctrl.hash;
+    send_ctrl_reply(i2c_ctrl.src, &i2c_ctrl.reply, sizeof(i2c_ctrl.reply));
+    ctrl_request_seq = seq;
+    ctrl_request_hash = hash;
+    i2c_ctrl.busy = false;
+}
+
+//! Let a queued host transaction finish before the bus is used otherwise
+static void i2c_ctrl_wait(void){
+    const uint32_t start = router_status->time64_ticks_rb;
+    while (i2c_ctrl.busy){
+        pic_interrupt_handler();
+        //a hung bus: reply anyway, the engine stays busy and the requests run blocking
+        if ((router_status->time64_ticks_rb - start) > TIME64_CLK_RATE/10){
+            printf("I2C transaction timed out\n");
+            i2c_ctrl_done();
+        }
+    }
+}
+
+//! Queue a host I2C request, false when it must run blocking
+static bool i2c_ctrl_start(struct socket_address src, const usrp2_ctrl_data_t *ctrl_data_in, const usrp2_ctrl_data_t *reply){
+    //a repeat of the transaction in flight, its reply is on the way
+    if (i2c_ctrl.busy && i2c_ctrl.seq == ctrl_request_seq && i2c_ctrl.hash == ctrl_request_hash
+        && i2c_ctrl.src.port == src.port && i2c_ctrl.src.addr.addr == src.addr.addr) return true;
+    i2c_ctrl_wait();
+
+    const uint8_t addr = ctrl_data_in->data.i2c_args.addr;
+    const uint8_t num_bytes = ctrl_data_in->data.i2c_args.bytes;
+    if (num_bytes == 0) return false;
+    memcpy(&i2c_ctrl.reply, reply, sizeof(i2c_ctrl.reply));
+    const bool queued = (reply->id == USRP2_CTRL_ID_HERES_THE_I2C_DATA_DUDE)?
+        i2c_async_read(addr, num_bytes) : i2c_async_write(addr, ctrl_data_in->data.i2c_args.data, num_bytes);
+    if (!queued) return false;
+    i2c_ctrl.src = src;
+    i2c_ctrl.seq = ctrl_request_seq;
+    i2c_ctrl.hash = ctrl_request_hash;
+    i2c_ctrl.busy = true;
+    return true;
+}
+#else
+static void i2c_ctrl_wait(void){}
+static bool i2c_ctrl_start(struct socket_address src, const usrp2_ctrl_data_t *ctrl_data_in, const usrp2_ctrl_data_t *reply){
+    return false;
+}
+#endif
+
+#ifdef UMTRX
+/*
+ * Run the ops of a batch request in order and send them back with their
+ * results in one reply. A failed op sets its status, the rest still run.
+ */
+static umtrx_ctrl_batch_t batch_out;
+
+static void handle_ctrl_batch(struct socket_address src, const umtrx_ctrl_batch_t *batch_in, int payload_len){
+    int num_ops = (payload_len - (int)offsetof(umtrx_ctrl_batch_t, ops))/(int)sizeof(umtrx_batch_op_t);
+    if (num_ops > (int)batch_in->num_ops) num_ops = batch_in->num_ops;
+    if (num_ops > UMTRX_CTRL_BATCH_MAX_OPS) num_ops = UMTRX_CTRL_BATCH_MAX_OPS;
+    if (num_ops < 0) num_ops = 0;
+
+    batch_out.proto_ver = USRP2_FW_COMPAT_NUM;
+    batch_out.id = UMTRX_CTRL_ID_BATCH_RESPONSE;
+    batch_out.seq = batch_in->seq;
+    batch_out.num_ops = num_ops;
+
+    for (int i = 0; i < num_ops; i++){
+        umtrx_batch_op_t *op = &batch_out.ops[i];
+        memcpy(op, &batch_in->ops[i], sizeof(*op));
+        op->status = 0;
+        switch(op->type){
+        case UMTRX_BATCH_OP_POKE32:
+            *((uint32_t *) op->addr) = op->data;
+            break;
+
+        case UMTRX_BATCH_OP_PEEK32:
+            op->data = *((uint32_t *) op->addr);
+            break;
+
+        case UMTRX_BATCH_OP_FW_POKE32:
+            if (op->addr < sizeof(fw_regs)/sizeof(fw_regs[0])) fw_regs[op->addr] = op->data;
+            else op->status = 1;
+            break;
+
+        case UMTRX_BATCH_OP_FW_PEEK32:
+            if (op->addr < sizeof(fw_regs)/sizeof(fw_regs[0])) op->data = fw_regs[op->addr];
+            else op->status = 1;
+            break;
+
+#ifndef NO_SPI_I2C
+        case UMTRX_BATCH_OP_SPI:
+            op->data = spi_transact(
+                (op->flags & UMTRX_BATCH_SPI_READBACK)? SPI_TXRX : SPI_TXONLY,
+                op->addr, op->data, op->len,
+                ((op->flags & UMTRX_BATCH_SPI_MOSI_RISE)? SPI_PUSH_FALL : SPI_PUSH_RISE) |
+                ((op->flags & UMTRX_BATCH_SPI_MISO_RISE)? SPI_LATCH_RISE : SPI_LATCH_FALL)
+            );
+            break;
+
+        case UMTRX_BATCH_OP_I2C_WRITE:
+            i2c_ctrl_wait();
+            if (op->len > sizeof(op->data) || !i2c_write(op->addr, (unsigned char *)&op->data, op->len)) op->status = 1;
+            break;
+
+        case UMTRX_BATCH_OP_I2C_READ:
+            i2c_ctrl_wait();
+            if (op->len > sizeof(op->data) || !i2c_read(op->addr, (unsigned char *)&op->data, op->len)) op->status = 1;
+            break;
+#endif
+
+        default:
+            op->status = 1;
+        }
+    }
+
+    //never shorter than a plain control packet, hosts expect at least that
+    size_t len = offsetof(umtrx_ctrl_batch_t, ops) + num_ops*sizeof(umtrx_batch_op_t);
+    if (len < sizeof(usrp2_ctrl_data_t)) len = sizeof(usrp2_ctrl_data_t);
+    send_ctrl_reply(src, &batch_out, len);
+}
+#endif
+
+#if defined(UMTRX) && !defined(NO_EEPROM)
+/*
+ * Read an EEPROM range into one reply, the host loads the whole image at open.
+ */
+static umtrx_ctrl_eeprom_t eeprom_out;
+
+static void handle_ctrl_eeprom(struct socket_address src, const umtrx_ctrl_eeprom_t *eeprom_in){
+    int len = eeprom_in->len;
+    if (len > UMTRX_CTRL_EEPROM_MAX_BYTES) len = UMTRX_CTRL_EEPROM_MAX_BYTES;
+
+    eeprom_out.proto_ver = USRP2_FW_COMPAT_NUM;
+    eeprom_out.id = UMTRX_CTRL_ID_EEPROM_RESPONSE;
+    eeprom_out.seq = eeprom_in->seq;
+    eeprom_out.addr = eeprom_in->addr;
+    eeprom_out.offset = eeprom_in->offset;
+    eeprom_out.len = len;
+    i2c_ctrl_wait();
+    eeprom_out.ok = eeprom_read(eeprom_in->addr, eeprom_in->offset, eeprom_out.data, len)? 1 : 0;
+
+    size_t pkt_len = offsetof(umtrx_ctrl_eeprom_t, data) + len;
+    if (pkt_len < sizeof(usrp2_ctrl_data_t)) pkt_len = sizeof(usrp2_ctrl_data_t);
+    send_ctrl_reply(src, &eeprom_out, pkt_len);
+}
+#endif
+
+#ifdef UMTRX
+/*
+ * GPSDO telemetry: any packet to the port subscribes its source,
+ * the main loop pushes one report per PPS edge.
+ */
+static struct socket_address gpsdo_telemetry_dst;
+static uint32_t gpsdo_telemetry_edges;
+
+static void handle_udp_gpsdo_packet(
+    struct socket_address src, struct socket_address dst,
+    unsigned char *payload, int payload_len
+){
+    //ICMP destination unreachable, the subscriber is gone
+    if (payload == NULL) gpsdo_telemetry_dst.port = 0;
+    else gpsdo_telemetry_dst = src;
+}
+
+static void gpsdo_telemetry_poll(void){
+    const uint32_t edges = gpsdo_get_pps_edges();
+    if (edges == gpsdo_telemetry_edges) return;
+    gpsdo_telemetry_edges = edges;
+    if (gpsdo_telemetry_dst.port == 0) return;
+
+    umtrx_gpsdo_telemetry_t report;
+    report.proto_ver = USRP2_FW_COMPAT_NUM;
+    report.id = UMTRX_GPSDO_TELEMETRY_ID;
+    report.seq = gpsdo_get_pps_count();
+    report.pps_secs = gpsdo_get_last_pps_secs();
+    report.pps_ticks = gpsdo_get_last_pps_ticks();
+    report.freq = gpsdo_get_last_freq();
+    report.freq_lpf = gpsdo_get_lpf_freq();
+    report.freq_error = gpsdo_get_freq_error();
+    report.dac = gpsdo_get_dac();
+    report.flags = (gpsdo_is_locked()? UMTRX_GPSDO_FLAG_LOCKED : 0)
+        | (gpsdo_is_fast_acquire()? UMTRX_GPSDO_FLAG_FAST_ACQ : 0)
+        | (gps_time_is_set()? UMTRX_GPSDO_FLAG_TIME_SET : 0)
+        | (gpsdo_is_pps_valid()? UMTRX_GPSDO_FLAG_PPS_VALID : 0);
+    send_udp_pkt(UMTRX_UDP_GPSDO_PORT, gpsdo_telemetry_dst, &report, sizeof(report));
+}
+#endif
+
 static void handle_udp_ctrl_packet(
     struct socket_address src, struct socket_address dst,
     unsigned char *payload, int payload_len
 ){
     //printf("Got ctrl packet #words: %d\n", (int)payload_len);
+    ctrl_pkt_handled = true;
     const usrp2_ctrl_data_t *ctrl_data_in = (usrp2_ctrl_data_t *)payload;
     uint32_t ctrl_data_in_id = ctrl_data_in->id;
 
@@ -129,6 +429,11 @@ static void handle_udp_ctrl_packet(
         ctrl_data_in_id = USRP2_CTRL_ID_HUH_WHAT;
     }
 
+    //a repeated request, its reply was late or lost
+    ctrl_request_seq = ctrl_data_in->seq;
+    ctrl_request_hash = ctrl_hash(payload, payload_len);
+    if (ctrl_data_in_id != USRP2_CTRL_ID_HUH_WHAT && ctrl_reply_resend(src)) return;
+
     //setup the output data
     usrp2_ctrl_data_t ctrl_data_out;
     ctrl_data_out.proto_ver = USRP2_FW_COMPAT_NUM;
@@ -182,6 +487,26 @@ static void handle_udp_ctrl_packet(
             case UMTRX_ZPU_REQUEST_SET_GPSDO_PPS_TICKS:
                 ctrl_data_out.data.zpu_action.data = gpsdo_get_last_pps_ticks();
                 break;
+            case UMTRX_ZPU_REQUEST_SET_GPSDO_FAST_ACQ:
+                gpsdo_set_fast_acquire(ctrl_data_in->data.zpu_action.data & 0xff,
+                                       ctrl_data_in->data.zpu_action.data >> 8);
+                break;
+            case UMTRX_ZPU_REQUEST_LMS_DC_CALIBRATION:
+                ctrl_data_out.data.zpu_action.data = lms_dc_calibration(
+                    (ctrl_data_in->data.zpu_action.data >> 16) & 0xff,
+                    ctrl_data_in->data.zpu_action.data & 0xff,
+                    (ctrl_data_in->data.zpu_action.data >> 8) & 0xff);
+                break;
+            case UMTRX_ZPU_REQUEST_LMS_VCOCAP_SWEEP:
+                ctrl_data_out.data.zpu_action.data = lms_vcocap_sweep(
+                    (ctrl_data_in->data.zpu_action.data >> 24) & 0xff,
+                    (ctrl_data_in->data.zpu_action.data >> 16) & 0xff,
+                    ctrl_data_in->data.zpu_action.data & 0x3f,
+                    (ctrl_data_in->data.zpu_action.data >> 8) & 0x3f);
+                break;
+            case UMTRX_ZPU_REQUEST_SET_GPS_TIME:
+                gps_time_set_mode((uint8_t)ctrl_data_in->data.zpu_action.data);
+                break;
             }
         }
         break;
@@ -213,27 +538,61 @@ static void handle_udp_ctrl_packet(
      ******************************************************************/
     case USRP2_CTRL_ID_DO_AN_I2C_READ_FOR_ME_BRO:{
             uint8_t num_bytes = ctrl_data_in->data.i2c_args.bytes;
+            ctrl_data_out.id = USRP2_CTRL_ID_HERES_THE_I2C_DATA_DUDE;
+            ctrl_data_out.data.i2c_args.bytes = num_bytes;
+            memset(ctrl_data_out.data.i2c_args.data, 0, sizeof(ctrl_data_out.data.i2c_args.data));
+            if (i2c_ctrl_start(src, ctrl_data_in, &ctrl_data_out)) return;
             i2c_read(
                 ctrl_data_in->data.i2c_args.addr,
                 ctrl_data_out.data.i2c_args.data,
                 num_bytes
             );
-            ctrl_data_out.id = USRP2_CTRL_ID_HERES_THE_I2C_DATA_DUDE;
-            ctrl_data_out.data.i2c_args.bytes = num_bytes;
         }
         break;
 
     case USRP2_CTRL_ID_WRITE_THESE_I2C_VALUES_BRO:{
             uint8_t num_bytes = ctrl_data_in->data.i2c_args.bytes;
+            ctrl_data_out.id = USRP2_CTRL_ID_COOL_IM_DONE_I2C_WRITE_DUDE;
+            ctrl_data_out.data.i2c_args.bytes = num_bytes;
+            if (i2c_ctrl_start(src, ctrl_data_in, &ctrl_data_out)) return;
             i2c_write(
                 ctrl_data_in->data.i2c_args.addr,
                 ctrl_data_in->data.i2c_args.data,
                 num_bytes
             );
-            ctrl_data_out.id = USRP2_CTRL_ID_COOL_IM_DONE_I2C_WRITE_DUDE;
-            ctrl_data_out.data.i2c_args.bytes = num_bytes;
         }
         break;
+
+#ifdef UMTRX
+    /*******************************************************************
+     * Sensor snapshot
+     ******************************************************************/
+    case UMTRX_CTRL_ID_SENSORS_REQUEST:
+        i2c_ctrl_wait();
+        ctrl_data_out.data.sensors_args.mask = umtrx_sensors_snapshot(
+            ctrl_data_in->data.sensors_args.mask,
+            ctrl_data_in->data.sensors_args.values[0],
+            ctrl_data_in->data.sensors_args.values[1],
+            ctrl_data_out.data.sensors_args.values
+        );
+        ctrl_data_out.id = UMTRX_CTRL_ID_SENSORS_RESPONSE;
+        break;
+#endif
+#endif
+
+#ifdef UMTRX
+    /*******************************************************************
+     * Batched operations
+     ******************************************************************/
+    case UMTRX_CTRL_ID_BATCH_REQUEST:
+        handle_ctrl_batch(src, (const umtrx_ctrl_batch_t *)payload, payload_len);
+        return;
+#endif
+
+#if defined(UMTRX) && !defined(NO_EEPROM)
+    case UMTRX_CTRL_ID_EEPROM_REQUEST:
+        handle_ctrl_eeprom(src, (const umtrx_ctrl_eeprom_t *)payload);
+        return;
 #endif
 
     /*******************************************************************
@@ -281,7 +640,7 @@ static void handle_udp_ctrl_packet(
     default:
         ctrl_data_out.id = USRP2_CTRL_ID_HUH_WHAT;
     }
-    send_udp_pkt(USRP2_UDP_CTRL_PORT, src, &ctrl_data_out, sizeof(ctrl_data_out));
+    send_ctrl_reply(src, &ctrl_data_out, sizeof(ctrl_data_out));
 }
 
 #include <net/padded_eth_hdr.h>
@@ -298,6 +657,7 @@ static void handle_inp_packet(uint32_t *buff, size_t num_lines){
   recovery_packet_t *recovery_packet = (recovery_packet_t *)buff;
   if (recovery_packet->eth_hdr.ethertype == 0xbeee && strncmp(recovery_packet->code, "addr", 4) == 0){
       printf("Got ip recovery packet: "); print_ip_addr(&recovery_packet->data.ip_addr); newline();
+      i2c_ctrl_wait(); //the address goes to the EEPROM
       set_ip_addr(&recovery_packet->data.ip_addr);
       return;
   }
@@ -311,14 +671,34 @@ static void handle_inp_packet(uint32_t *buff, size_t num_lines){
 /*
  * Called when eth phy state changes (w/ interrupts disabled)
  */
+/*
+ * Repeat the gratuitous ARP after link up, the first one can be lost
+ * while the switch port is still coming up.
+ */
+#define ARP_ANNOUNCE_REPEATS 2
+static int arp_announce_count;
+static uint32_t arp_announce_ticks;
+
+static void arp_announce_poll(void){
+    if (arp_announce_count == 0) return;
+    if ((router_status->time64_ticks_rb - arp_announce_ticks) < TIME64_CLK_RATE) return;
+    arp_announce_ticks = router_status->time64_ticks_rb;
+    arp_announce_count--;
+    send_gratuitous_arp();
+}
+
 void link_changed_callback(int speed){
     printf("\neth link changed: speed = %d\n", speed);
+    fw_regs[U2_FW_REG_LINK_SPEED] = speed;
     if (speed != 0){
         char led = speed==1000?LED_RJ45_ORANGE:LED_RJ45_GREEN;
         hal_set_leds(led, led);
         send_gratuitous_arp();
+        arp_announce_count = ARP_ANNOUNCE_REPEATS;
+        arp_announce_ticks = router_status->time64_ticks_rb;
     }
     else{
+        arp_announce_count = 0;
         hal_set_leds(0x0, LED_RJ45_ORANGE);
         hal_set_leds(0x0, LED_RJ45_GREEN);
     }
@@ -362,10 +742,18 @@ main(void)
   register_addrs(ethernet_mac_addr(), get_ip_addr());
   pkt_ctrl_program_inspector(get_ip_addr(), USRP2_UDP_SERVER_PORT);
 
+#ifdef I2C_CTRL_ASYNC
+  i2c_register_handler();
+  i2c_register_callback(i2c_ctrl_done);
+#endif
+
   //2) register callbacks for udp ports we service
   init_udp_listeners();
   register_udp_listener(USRP2_UDP_CTRL_PORT, handle_udp_ctrl_packet);
   register_udp_listener(USRP2_UDP_SERVER_PORT, handle_udp_data_packet);
+#ifdef UMTRX
+  register_udp_listener(UMTRX_UDP_GPSDO_PORT, handle_udp_gpsdo_packet);
+#endif
 
 #ifdef USRP2P
 #ifndef NO_FLASH
@@ -374,6 +762,9 @@ main(void)
 #endif
 
   udp_uart_init(USRP2_UDP_UART_BASE_PORT); //setup uart messaging
+#ifdef UMTRX
+  udp_uart_set_rx_hook(UART_GPS, gps_time_putc); //NMEA time of day
+#endif
 
   //3) init input state
   pkt_ctrl_release_incoming_buffer();
@@ -384,18 +775,45 @@ main(void)
 
   printf("Init is done\n");
 
+  //the time counter starts with the FPGA, so this covers the bootloader stage too
+  fw_regs[U2_FW_REG_BOOT_TIME] = router_status->time64_ticks_rb/(TIME64_CLK_RATE/1000);
+
+  //background jobs run one per pass so a packet never waits on all of them
+  static void (*const background_jobs[])(void) = {
+    udp_uart_poll, //uart message handling
+#ifdef UMTRX
+    gpsdo_telemetry_poll, //push the report of a new PPS
+#endif
+    pic_interrupt_handler, //one pending interrupt per call
+    arp_announce_poll, //gratuitous ARP repeats after link up
+  };
+  static const size_t num_background_jobs = sizeof(background_jobs)/sizeof(background_jobs[0]);
+  size_t next_job = 0;
+  uint32_t idle_ticks = router_status->time64_ticks_rb;
+
   while(true){
 
-    size_t num_lines;
-    void *buff = pkt_ctrl_claim_incoming_buffer(&num_lines);
-    if (buff != NULL){
-        handle_inp_packet((uint32_t *)buff, num_lines);
-        pkt_ctrl_release_incoming_buffer();
+    //packets come first, a bounded burst keeps the background jobs running
+    for (size_t i = 0; i < MAX_PKTS_PER_PASS; i++){
+      size_t num_lines;
+      void *buff = pkt_ctrl_claim_incoming_buffer(&num_lines);
+      if (buff == NULL){
+        idle_ticks = router_status->time64_ticks_rb;
+        break;
+      }
+      ctrl_pkt_handled = false;
+      handle_inp_packet((uint32_t *)buff, num_lines);
+      pkt_ctrl_release_incoming_buffer();
+
+      //a ctrl packet arrived after the last empty check, bound the response time from there
+      if (ctrl_pkt_handled){
+        const uint32_t usecs = (router_status->time64_ticks_rb - idle_ticks)/(TIME64_CLK_RATE/1000000);
+        if (usecs > fw_regs[U2_FW_REG_CTRL_LATENCY_MAX]) fw_regs[U2_FW_REG_CTRL_LATENCY_MAX] = usecs;
+      }
     }
 
-    udp_uart_poll(); //uart message handling
-
-    pic_interrupt_handler();
+    background_jobs[next_job]();
+    if (++next_job == num_background_jobs) next_job = 0;
     /*
     int pending = pic_regs->pending;		// poll for under or overrun
 
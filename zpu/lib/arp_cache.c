@@ -24,6 +24,7 @@
 typedef struct {
   struct ip_addr	ip;
   eth_mac_addr_t	mac;
+  bool			pinned;
 } arp_cache_t;
 
 #define	NENTRIES 8	// power-of-2
@@ -54,11 +55,20 @@ arp_cache_lookup(const struct ip_addr *ip)
 static int
 arp_cache_alloc(void)
 {
-  if (nentries < NENTRIES)
+  if (nentries < NENTRIES){
+    cache[nentries].pinned = false;
     return nentries++;
+  }
 
-  int i = victim;
-  victim = (victim + 1) % NENTRIES;
+  // skip the pinned entries, unless all of them are
+  int i, n;
+  for (n = 0; n < NENTRIES; n++){
+    i = victim;
+    victim = (victim + 1) % NENTRIES;
+    if (!cache[i].pinned)
+      break;
+  }
+  cache[i].pinned = false;
   return i;
 }
 
@@ -77,6 +87,31 @@ arp_cache_update(const struct ip_addr *ip,
   }
 }
 
+void
+arp_cache_refresh(const struct ip_addr *ip,
+		  const eth_mac_addr_t *mac)
+{
+  int i = arp_cache_lookup(ip);
+  if (i >= 0)
+    cache[i].mac = *mac;
+}
+
+void
+arp_cache_pin(const struct ip_addr *ip,
+	      const eth_mac_addr_t *mac)
+{
+  arp_cache_update(ip, mac);
+  cache[arp_cache_lookup(ip)].pinned = true;
+}
+
+void
+arp_cache_unpin(const struct ip_addr *ip)
+{
+  int i = arp_cache_lookup(ip);
+  if (i >= 0)
+    cache[i].pinned = false;
+}
+
 bool
 arp_cache_lookup_mac(const struct ip_addr *ip,
 		     eth_mac_addr_t *mac)
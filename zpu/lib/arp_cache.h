@@ -30,4 +30,17 @@ void arp_cache_update(const struct ip_addr *ip,
 bool arp_cache_lookup_mac(const struct ip_addr *ip,
 			  eth_mac_addr_t *mac);
 
+/*!
+ * Insert or refresh an entry that is never the victim of a new one,
+ * for the host the framers stream to. Updates still change its mac.
+ */
+void arp_cache_pin(const struct ip_addr *ip,
+		   const eth_mac_addr_t *mac);
+
+void arp_cache_unpin(const struct ip_addr *ip);
+
+//update the mac of an entry already in the cache, no new entry
+void arp_cache_refresh(const struct ip_addr *ip,
+		       const eth_mac_addr_t *mac);
+
 #endif /* INCLUDED_ARP_CACHE_H */
@@ -47,10 +47,11 @@ eth_mac_init(const eth_mac_addr_t *src)
   eth_mac->miimoder = 25;	// divider from CPU clock (50MHz/25 = 2MHz)
 
   eth_mac_set_addr(src);
-  eth_mac->settings = MAC_SET_PAUSE_EN | MAC_SET_PASS_BCAST | MAC_SET_PASS_UCAST | MAC_SET_PAUSE_SEND_EN | MAC_SET_PASS_ALL;
+  // respect PAUSE frames, sending them is left to the host (eth_pause device arg)
+  eth_mac->settings = MAC_SET_PAUSE_EN | MAC_SET_PASS_BCAST | MAC_SET_PASS_UCAST | MAC_SET_PASS_ALL;
 
-  eth_mac->pause_time = 38;
-  eth_mac->pause_thresh = 1200;
+  eth_mac->pause_time = 38;	// quanta of 512 bit times, a bit more than 1 max frame
+  eth_mac->pause_thresh = 1200;	// free lines in the rx fifo before we ask for a pause
 
   // set rx flow control high and low water marks
   // unsigned int lwmark = (2*2048 + 64)/4; // 2 * 2048-byte frames + 1 * 64-byte pause frame
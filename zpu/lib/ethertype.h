@@ -22,6 +22,7 @@
 
 #define	ETHERTYPE_IPV4	0x0800
 #define	ETHERTYPE_ARP	0x0806
+#define	ETHERTYPE_VLAN	0x8100
 
 
 #endif /* INCLUDED_ETHERTYPE_H */
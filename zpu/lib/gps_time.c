@@ -0,0 +1,178 @@
+/*
+ * Copyright 2026 Fairwaves LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gps_time.h"
+#include "memory_map.h"
+
+/* printf headers */
+#include "nonstdio.h"
+
+/* standard headers */
+#include <stddef.h>
+
+/* NMEA sentences are at most 82 characters */
+#define NMEA_MAX_LEN 96
+
+/* time64 flags: the GPS PPS on the rising edge of the SMA input */
+#define TIME64_FLAGS_PPS_SMA_POSEDGE 1
+
+static uint8_t g_mode = GPS_TIME_OFF;
+static bool g_set = false;
+static uint32_t g_last_secs = 0;
+
+static char g_line[NMEA_MAX_LEN];
+static size_t g_len = 0;
+
+static bool g_have_fix = false;
+static uint32_t g_fix_secs = 0;
+
+static int
+_hex_value(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+static bool
+_digits(const char *s, size_t n, uint32_t *value)
+{
+  uint32_t v = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (s[i] < '0' || s[i] > '9') return false;
+    v = v*10 + (s[i] - '0');
+  }
+  *value = v;
+  return true;
+}
+
+/* Days from 1970-01-01 to a date of the proleptic Gregorian calendar */
+static uint32_t
+_days_from_civil(uint32_t y, uint32_t m, uint32_t d)
+{
+  y -= m <= 2;
+  const uint32_t era = y / 400;
+  const uint32_t yoe = y - era * 400;
+  const uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+/* UTC seconds of a valid $G?RMC sentence with a good checksum */
+static bool
+_parse_rmc(const char *line, size_t len, uint32_t *secs)
+{
+  if (len < 7 || line[0] != '$' || line[1] != 'G'
+      || line[3] != 'R' || line[4] != 'M' || line[5] != 'C' || line[6] != ',')
+    return false;
+
+  /* XOR of everything between $ and * */
+  uint8_t sum = 0;
+  size_t star = 1;
+  while (star < len && line[star] != '*') sum ^= (uint8_t)line[star++];
+  if (star + 2 >= len) return false;
+  const int hi = _hex_value(line[star + 1]), lo = _hex_value(line[star + 2]);
+  if (hi < 0 || lo < 0 || sum != (uint8_t)(hi << 4 | lo)) return false;
+
+  /* the fields after the address: 0 hhmmss.ss, 1 status, 8 ddmmyy */
+  const char *field[9];
+  size_t num = 0;
+  for (size_t i = 0; i < star && num < 9; i++) {
+    if (line[i] == ',') field[num++] = &line[i + 1];
+  }
+  if (num < 9 || field[1][0] != 'A') return false;
+
+  uint32_t hh, mm, ss, day, mon, yy;
+  if (!_digits(field[0], 2, &hh) || !_digits(field[0] + 2, 2, &mm) || !_digits(field[0] + 4, 2, &ss))
+    return false;
+  if (!_digits(field[8], 2, &day) || !_digits(field[8] + 2, 2, &mon) || !_digits(field[8] + 4, 2, &yy))
+    return false;
+  if (hh > 23 || mm > 59 || ss > 60 || mon < 1 || mon > 12 || day < 1 || day > 31)
+    return false;
+
+  *secs = _days_from_civil(2000 + yy, mon, day) * 86400 + hh * 3600 + mm * 60 + ss;
+  return true;
+}
+
+/* Latch secs at the next PPS, the high word write arms it */
+static void
+_arm_next_pps(uint32_t secs)
+{
+  const uint64_t ticks = (uint64_t)secs * TIME64_CLK_RATE;
+  sr_time64->flags = TIME64_FLAGS_PPS_SMA_POSEDGE;
+  sr_time64->ticks = (uint32_t)ticks;
+  sr_time64->imm = 0;
+  sr_time64->secs = (uint32_t)(ticks >> 32);
+  g_last_secs = secs;
+  g_set = true;
+}
+
+static void
+_handle_line(const char *line, size_t len)
+{
+  uint32_t secs;
+  if (!_parse_rmc(line, len, &secs)) return;
+
+  /* the receiver sends the sentence after the PPS of its second */
+  const bool confirmed = g_have_fix && secs == g_fix_secs + 1;
+  g_have_fix = true;
+  g_fix_secs = secs;
+  if (!confirmed) return;
+
+  if (g_mode == GPS_TIME_ALWAYS || (g_mode == GPS_TIME_ONCE && !g_set)) {
+#ifndef BOOTLOADER
+    if (!g_set) printf("GPS time: %u at the next PPS\n", secs + 1);
+#endif
+    _arm_next_pps(secs + 1);
+  }
+}
+
+void
+gps_time_set_mode(uint8_t mode)
+{
+  g_mode = mode;
+  g_set = false;
+  g_have_fix = false;
+}
+
+void
+gps_time_putc(int ch)
+{
+  if (g_mode == GPS_TIME_OFF) return;
+
+  if (ch == '$') g_len = 0;
+  if (ch == '\r' || ch == '\n') {
+    if (g_len > 0) _handle_line(g_line, g_len);
+    g_len = 0;
+    return;
+  }
+  if (g_len < NMEA_MAX_LEN) g_line[g_len++] = (char)ch;
+  else g_len = 0; /* too long, not NMEA */
+}
+
+bool
+gps_time_is_set(void)
+{
+  return g_set;
+}
+
+uint32_t
+gps_time_get_last_secs(void)
+{
+  return g_last_secs;
+}
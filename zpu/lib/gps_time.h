@@ -0,0 +1,44 @@
+/*
+ * Copyright 2026 Fairwaves LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_GPS_TIME_H
+#define INCLUDED_GPS_TIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Time of day from the NMEA RMC sentences of the GPS, latched into time64
+ * at the PPS after the sentence. Two sentences one second apart confirm a
+ * fix before the time is armed, the time is UTC seconds since 1970. */
+
+#define GPS_TIME_OFF    0 /* leave time64 alone */
+#define GPS_TIME_ONCE   1 /* latch the first confirmed fix */
+#define GPS_TIME_ALWAYS 2 /* latch every confirmed fix */
+
+/* Set the mode, a new mode latches again */
+void gps_time_set_mode(uint8_t mode);
+
+/* Feed a character received from the GPS UART */
+void gps_time_putc(int ch);
+
+/* True once a fix was armed since the mode was set */
+bool gps_time_is_set(void);
+
+/* Seconds armed for the last latch, 0 before the first */
+uint32_t gps_time_get_last_secs(void);
+
+#endif /* INCLUDED_GPS_TIME_H */
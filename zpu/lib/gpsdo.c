@@ -100,6 +100,17 @@ typedef struct {
 
 static pid_data_t g_pid;
 
+/* Fast acquire: P and I gains times 2^g_fast_shift while the error is
+ * above g_fast_threshold Hz, the integrator keeps its sum when it ends */
+static uint8_t g_fast_shift = 0;
+static int32_t g_fast_threshold = 0;
+static bool g_fast_active = false;
+
+/* Lock: the filtered error within GPSDO_LOCK_ERR Hz for GPSDO_LOCK_COUNT PPS */
+#define GPSDO_LOCK_ERR   1
+#define GPSDO_LOCK_COUNT 10
+static uint8_t g_lock_count = 0;
+
 static void
 _gpsdo_pid_init(int32_t init_val)
 {
@@ -135,11 +146,20 @@ _gpsdo_pid_step(int32_t val)
   else if (error < -PID_MAX_ERR)
     error = -PID_MAX_ERR;
 
+  /* Lock detect */
+  if (abs(error) <= GPSDO_LOCK_ERR) {
+    if (g_lock_count < GPSDO_LOCK_COUNT) g_lock_count++;
+  } else {
+    g_lock_count = 0;
+  }
+
   /* Compute P term */
+  g_fast_active = g_fast_shift != 0 && abs(error) > g_fast_threshold;
   p_term = error * G_PID_PK;
+  if (g_fast_active) p_term <<= g_fast_shift;
 
   /* Compute I term */
-  g_pid.err_sum += error;
+  g_pid.err_sum += g_fast_active ? (error << g_fast_shift) : error;
   i_term = g_pid.err_sum * G_PID_IK;
 
   /* Compute D term */
@@ -184,6 +204,9 @@ static uint32_t g_val_lpf = VAL_LPF_INIT_VALUE;
 static uint32_t g_prev_secs = 0;
 static uint32_t g_prev_ticks = 0;
 static uint32_t g_last_calc_freq = 0; /* Last calculated VCTCXO frequency */
+static uint32_t g_pps_count = 0; /* Valid counter readings since init */
+static uint32_t g_pps_edges = 0; /* PPS edges since init */
+static bool g_pps_valid = false; /* The last edge gave a valid counter reading */
 
 static void
 _gpsdo_irq_handler(unsigned irq)
@@ -192,9 +215,9 @@ _gpsdo_irq_handler(unsigned irq)
   {
     /* Counter value */
     uint32_t val = gpsdo_regs->cnt;
-    /* Read the current wall time */
-    uint32_t cur_secs, cur_ticks;
-    time64_read(&cur_secs, &cur_ticks);
+    /* Wall time of the PPS edge, latched by the FPGA */
+    uint32_t cur_secs = readback_mux->time64_secs_rb_pps;
+    uint32_t cur_ticks = readback_mux->time64_ticks_rb_pps;
 
     /* Next request */
     gpsdo_regs->csr = GPSDO_CSR_REQ;
@@ -202,10 +225,13 @@ _gpsdo_irq_handler(unsigned irq)
     if (gpsdo_debug) printf("GPSDO: Counter = %u @ %u sec %u ticks\n", val, cur_secs, cur_ticks);
 #endif
     /* Check validity of value */
-    if (abs(val - PID_TARGET) < 100000)
+    g_pps_edges++;
+    g_pps_valid = abs(val - PID_TARGET) < 100000;
+    if (g_pps_valid)
     {
       /* Save calculated frequency */
       g_last_calc_freq = val;
+      g_pps_count++;
       
       if (g_skip_on_first_run > 0) {
         g_skip_on_first_run--;
@@ -219,7 +245,10 @@ _gpsdo_irq_handler(unsigned irq)
         /* LPF the value */
         /* Integer overlow warning! */
         /* This works for val ~= 52M, but don't try to use it with much larger values - it will overflow */
-        g_val_lpf = (g_val_lpf * 7 + (val<<VAL_LPF_PRECISION) + 4) >> 3;
+        if (g_fast_active)
+          g_val_lpf = (g_val_lpf + (val<<VAL_LPF_PRECISION) + 1) >> 1; /* less lag while acquiring */
+        else
+          g_val_lpf = (g_val_lpf * 7 + (val<<VAL_LPF_PRECISION) + 4) >> 3;
 #ifndef BOOTLOADER
         if (gpsdo_debug) printf("GPSDO: Filtered counter = %u + %u/8\n",
                                 (g_val_lpf>>VAL_LPF_PRECISION), (g_val_lpf&((1<<VAL_LPF_PRECISION)-1)));
@@ -256,6 +285,7 @@ gpsdo_init(void)
 
   /* Set last saved freq to an invalid value */
   g_last_calc_freq = 0;
+  g_lock_count = 0;
   
   /* Set the DAC to initial value */
   _set_vctcxo_dac( tcxo_dac );
@@ -285,6 +315,7 @@ void gpsdo_set_dac(uint16_t v)
   _gpsdo_pid_init(v);
   /* Reset GPSDO */
   g_skip_on_first_run = SKIP_ON_FIRST_RUN_VAL;
+  g_lock_count = 0;
   /* Set the DAC value */
   _set_vctcxo_dac(v);
 }
@@ -313,3 +344,39 @@ uint32_t gpsdo_get_last_pps_ticks(void)
 {
   return g_prev_ticks;
 }
+
+int32_t gpsdo_get_freq_error(void)
+{
+  return (int32_t)(VAL_LPF_INIT_VALUE - g_val_lpf);
+}
+
+uint32_t gpsdo_get_pps_count(void)
+{
+  return g_pps_count;
+}
+
+uint32_t gpsdo_get_pps_edges(void)
+{
+  return g_pps_edges;
+}
+
+bool gpsdo_is_pps_valid(void)
+{
+  return g_pps_valid;
+}
+
+bool gpsdo_is_locked(void)
+{
+  return g_lock_count >= GPSDO_LOCK_COUNT;
+}
+
+void gpsdo_set_fast_acquire(uint8_t shift, int32_t threshold)
+{
+  g_fast_shift = shift > 4 ? 4 : shift; /* keeps the sums within 32 bits */
+  g_fast_threshold = threshold;
+}
+
+bool gpsdo_is_fast_acquire(void)
+{
+  return g_fast_active;
+}
@@ -19,6 +19,9 @@
 #ifndef INCLUDED_GPSDO_H
 #define INCLUDED_GPSDO_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
 
 void gpsdo_init(void);
 
@@ -37,10 +40,31 @@ uint32_t gpsdo_get_last_freq(void);
 /* Get the last alpha/8 filtered VCTCXO frequency (29.3 fixed point) */
 uint32_t gpsdo_get_lpf_freq(void);
 
-/* Get time (seconds part) of the last PPS pulse  */
+/* Get time (seconds part) of the last PPS pulse, as latched by the FPGA */
 uint32_t gpsdo_get_last_pps_secs(void);
 
 /* Get time (ticks part) of the last PPS pulse  */
 uint32_t gpsdo_get_last_pps_ticks(void);
 
+/* Get the target minus the filtered frequency (29.3 fixed point) */
+int32_t gpsdo_get_freq_error(void);
+
+/* Get the number of valid PPS measurements since init */
+uint32_t gpsdo_get_pps_count(void);
+
+/* Get the number of PPS edges since init, valid or not */
+uint32_t gpsdo_get_pps_edges(void);
+
+/* True when the last PPS edge gave a valid measurement */
+bool gpsdo_is_pps_valid(void);
+
+/* True when the filtered error stayed within 1 Hz for the last 10 PPS */
+bool gpsdo_is_locked(void);
+
+/* Multiply the P and I gains by 2^shift while the error is above threshold Hz, shift 0 disables */
+void gpsdo_set_fast_acquire(uint8_t shift, int32_t threshold);
+
+/* True while the fast acquire gains are in use */
+bool gpsdo_is_fast_acquire(void);
+
 #endif /* INCLUDED_GPSDO_H */
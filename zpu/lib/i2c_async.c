@@ -35,6 +35,7 @@ volatile uint8_t *volatile i2c_bufptr = i2c_buf; //ptr to current position
 volatile uint8_t i2c_len = 0; //length remaining in current transfer
 volatile i2c_state_t i2c_state = I2C_STATE_IDLE; //current I2C transfer state
 i2c_dir_t i2c_dir; //I2C transfer direction
+static volatile bool i2c_failed; //the last transfer was NACK'd or lost arbitration
 
 void  (*volatile i2c_callback)(void); //function pointer to i2c callback to be called when transaction is complete
 static void i2c_irq_handler(unsigned irq);
@@ -49,22 +50,22 @@ static void i2c_irq_handler(unsigned irq) {
 //i2c state machine.
 
   //printf("I2C irq handler\n");
-  //first let's make sure nothing is f'ed up
-  //TODO: uncomment this error checking when we have some way to handle errors
-//  if(((i2c_regs->cmd_status & I2C_ST_RXACK) != 0) && i2c_dir == I2C_DIR_WRITE) { //we got a NACK and we didn't send it
-//    printf("\tNACK received\n");
-//    i2c_async_err();
-//    return;
-//  }// else printf("\tACK received, proceeding\n");
+  if(i2c_regs->cmd_status & I2C_ST_TIP) {
+    //printf("\tI2C still busy in interrupt\n");
+    return;
+  }
 
-  if(i2c_regs->cmd_status & I2C_ST_AL) { 
-    printf("\tArbitration lost!\n");
+  //first let's make sure nothing is f'ed up:
+  //a NACK of the address or of a written byte, we only NACK the last byte read ourselves
+  if(((i2c_regs->cmd_status & I2C_ST_RXACK) != 0) &&
+     (i2c_dir == I2C_DIR_WRITE || i2c_state == I2C_STATE_CONTROL_BYTE_SENT)) {
     i2c_async_err();
     return;
   }
 
-  if(i2c_regs->cmd_status & I2C_ST_TIP) {
-    //printf("\tI2C still busy in interrupt\n");
+  if(i2c_regs->cmd_status & I2C_ST_AL) { 
+    printf("\tArbitration lost!\n");
+    i2c_async_err();
     return;
   }
 
@@ -142,8 +143,14 @@ inline void i2c_async_err(void) {
   i2c_state = I2C_STATE_IDLE;
   i2c_regs->ctrl &= ~I2C_CTRL_IE;
   printf("I2C error\n");
-//TODO: set an error flag instead of just dropping things on the floor
+  i2c_failed = true;
   i2c_regs->cmd_status = I2C_CMD_STOP;
+  //the transfer is over all the same
+  if(i2c_callback) i2c_callback();
+}
+
+bool i2c_async_failed(void) {
+  return i2c_failed;
 }
 
 bool i2c_async_read(uint8_t addr, unsigned int len) {
@@ -156,6 +163,7 @@ bool i2c_async_read(uint8_t addr, unsigned int len) {
   i2c_regs->ctrl &= ~I2C_CTRL_IE;
   i2c_regs->cmd_status |= I2C_CMD_IACK;
 
+  i2c_failed = false;
   i2c_len = len;
   i2c_dir = I2C_DIR_READ;
   i2c_bufptr = i2c_buf;
@@ -180,6 +188,7 @@ bool i2c_async_write(uint8_t addr, const uint8_t *buf, unsigned int len) {
   //copy the buffer into our own if writing
   memcpy((void *)i2c_buf, buf, len);
 
+  i2c_failed = false;
   i2c_len = len;
   i2c_dir = I2C_DIR_WRITE;
   i2c_bufptr = i2c_buf;
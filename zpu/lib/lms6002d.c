@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026 Fairwaves LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lms6002d.h"
+#include "spi.h"
+#include "mdelay.h"
+#include "usrp2/fw_common.h"
+
+//same framing and edges as the host side LMS driver
+#define LMS_SPI_FLAGS (SPI_PUSH_FALL | SPI_LATCH_RISE)
+
+static void lms_write(int slave, uint8_t addr, uint8_t data)
+{
+    spi_transact(SPI_TXONLY, slave, ((0x80 | addr) << 8) | data, 16, LMS_SPI_FLAGS);
+}
+
+static uint8_t lms_read(int slave, uint8_t addr)
+{
+    return spi_transact(SPI_TXRX, slave, addr << 8, 16, LMS_SPI_FLAGS) & 0xff;
+}
+
+//Programming and Calibration Guide: 4.1 General DC Calibration Procedure
+static uint8_t lms_dc_calibration_loop(int slave, uint8_t dc_addr, uint8_t base)
+{
+    uint8_t DC_REGVAL = 0;
+
+    //DC_ADDR := ADDR, then pulse DC_START_CLBR
+    uint8_t reg_val = (lms_read(slave, base+0x03) & 0xf8) | dc_addr;
+    lms_write(slave, base+0x03, reg_val);
+    lms_write(slave, base+0x03, reg_val | (1 << 5));
+    lms_write(slave, base+0x03, reg_val);
+
+    for (int try_cnt = 0; try_cnt < 10; try_cnt++)
+    {
+        udelay(7);
+
+        //DC_CLBR_DONE == 1 means still running
+        if ((lms_read(slave, base+0x01) >> 1) & 0x1) continue;
+
+        const int DC_LOCK = (lms_read(slave, base+0x01) >> 2) & 0x7;
+        DC_REGVAL = lms_read(slave, base+0x00);
+        if (DC_LOCK != 0 && DC_LOCK != 7) break;
+    }
+    return DC_REGVAL;
+}
+
+uint32_t lms_dc_calibration(int slave, uint8_t dc_addr, uint8_t calibration_reg_base)
+{
+    //power up DC comparators
+    lms_write(slave, 0x6E, lms_read(slave, 0x6E) & ~(0x3 << 6));
+    lms_write(slave, 0x5F, lms_read(slave, 0x5F) & ~(0x1 << 7));
+
+    lms_write(slave, calibration_reg_base+0x00, 31);
+    uint32_t result = lms_dc_calibration_loop(slave, dc_addr, calibration_reg_base);
+
+    //'31' is either a failure or the best value, re-check from 0 (FAQ 4.7)
+    if (result == 31)
+    {
+        lms_write(slave, calibration_reg_base+0x00, 0);
+        result = lms_dc_calibration_loop(slave, dc_addr, calibration_reg_base);
+        if (result == 0) return UMTRX_LMS_DC_CAL_FAILED;
+    }
+
+    //power down DC comparators to improve the receiver linearity (FAQ 5.26)
+    lms_write(slave, 0x6E, lms_read(slave, 0x6E) | (0x3 << 6));
+    lms_write(slave, 0x5F, lms_read(slave, 0x5F) | (0x1 << 7));
+    return result;
+}
+
+uint32_t lms_vcocap_sweep(int slave, uint8_t reg, int first, int last)
+{
+    enum { VCO_HIGH, VCO_NORM, VCO_LOW } state = VCO_HIGH;
+    int start_i = -1;
+    int stop_i = -1;
+    const uint8_t reg9 = lms_read(slave, reg+0x09) & ~0x3f;
+    for (int i = first; i <= last; i++)
+    {
+        lms_write(slave, reg+0x09, reg9 | i);
+        udelay(50);
+
+        switch (lms_read(slave, reg+0x0a) >> 6)
+        {
+        case 0x02: //HIGH
+            break;
+        case 0x01: //LOW
+            if (state == VCO_NORM)
+            {
+                stop_i = i - 1;
+                state = VCO_LOW;
+            }
+            break;
+        case 0x00: //NORMAL
+            if (state == VCO_HIGH)
+            {
+                start_i = i;
+                state = VCO_NORM;
+            }
+            break;
+        default:
+            return UMTRX_LMS_VCOCAP_ERROR;
+        }
+        //nothing more to learn once the window is closed
+        if (state == VCO_LOW) break;
+    }
+    if (state == VCO_NORM) stop_i = last;
+    return ((stop_i & 0xff) << 8) | (start_i & 0xff);
+}
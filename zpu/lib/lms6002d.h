@@ -0,0 +1,40 @@
+/*
+ * Copyright 2026 Fairwaves LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_LMS6002D_H
+#define INCLUDED_LMS6002D_H
+
+#include "stdint.h"
+
+/*
+ * Run the LMS6002D general DC calibration of one DC addr of a calibration
+ * register bank, the FAQ 4.7 re-check of a '31' result included, so the
+ * host only waits for the result instead of polling every register.
+ * The DC comparators are powered down again when done.
+ * Returns DC_REGVAL, or UMTRX_LMS_DC_CAL_FAILED when it does not converge.
+ */
+uint32_t lms_dc_calibration(int slave, uint8_t dc_addr, uint8_t calibration_reg_base);
+
+/*
+ * Sweep VCOCAP of the PLL at reg (0x10 TX, 0x20 RX) over [first, last] and
+ * find the window where VTUNE is normal, 50 us of settling per step.
+ * NINT, NFRAC and FREQSEL must be programmed already. VCOCAP is left at the
+ * last value tried. Returns the window as for UMTRX_ZPU_REQUEST_LMS_VCOCAP_SWEEP.
+ */
+uint32_t lms_vcocap_sweep(int slave, uint8_t reg, int first, int last);
+
+#endif /* INCLUDED_LMS6002D_H */
@@ -29,3 +29,12 @@ void mdelay(int ms){
     }
   }
 }
+
+void udelay(int us){
+  if (hwconfig_simulation_p()) return;
+  const uint32_t num_ticks = us*(TIME64_CLK_RATE/1000000);
+  const uint32_t ticks_begin = router_status->time64_ticks_rb;
+  while((router_status->time64_ticks_rb - ticks_begin) < num_ticks){
+    /*NOP*/
+  }
+}
@@ -26,4 +26,9 @@
  */
 void mdelay(int ms);
 
+/*!
+ * \brief Delay about us microseconds, meant for short hardware settling
+ */
+void udelay(int us);
+
 #endif /* INCLUDED_MDELAY_H */
@@ -165,6 +165,8 @@ typedef struct {
   volatile uint32_t time64_ticks_rb;
   volatile uint32_t compat_num;
   volatile uint32_t irqs;
+  volatile uint32_t time64_secs_rb_pps;  // time64 latched at the last PPS
+  volatile uint32_t time64_ticks_rb_pps;
 } router_status_t;
 
 #define SPI_READY_IRQ (1 << 12)
@@ -209,6 +211,13 @@ typedef struct {
   volatile int miirx_data;
   volatile int pause_time;
   volatile int pause_thresh;
+  volatile int pause_rcvd;        // read only, PAUSE frames received
+  volatile int pause_sent;        // read only, PAUSE frames sent
+  volatile int pause_quanta_rcvd; // read only, quanta of the last one received
+  volatile int rx_frames;         // read only, good frames received
+  volatile int rx_errors;         // read only, CRC, length and GMII errors
+  volatile int rx_overruns;       // read only, frames cut by a full rx fifo
+  volatile int tx_frames;         // read only, frames sent
 } eth_mac_regs_t;
 
 // settings register
@@ -35,6 +35,7 @@
 #include <ethertype.h>
 #include <string.h>
 #include "pkt_ctrl.h"
+#include "usrp2/fw_common.h"
 
 /***********************************************************************
  * Constants + Globals
@@ -123,7 +124,8 @@ void setup_framer(
     eth_mac_addr_t eth_src,
     struct socket_address sock_dst,
     struct socket_address sock_src,
-    size_t which
+    size_t which,
+    uint32_t qos
 ){
     struct {
         padded_eth_hdr_t eth;
@@ -136,8 +138,17 @@ void setup_framer(
     frame.eth.src = eth_src;
     frame.eth.ethertype = ETHERTYPE_IPV4;
 
+    //-- the 802.1Q tag goes in word 13, the framer sends it after the MACs --//
+    uint32_t vlan_tag = 0;
+    if (qos & USRP2_STREAM_QOS_VLAN){
+        frame.eth.ethertype = ETHERTYPE_VLAN;
+        const uint32_t pcp = (qos >> USRP2_STREAM_QOS_PCP_SHIFT) & 0x7;
+        const uint32_t vid = (qos >> USRP2_STREAM_QOS_VID_SHIFT) & 0xfff;
+        vlan_tag = ((pcp << 13) | vid) << 16 | ETHERTYPE_IPV4;
+    }
+
     //-- load IPv4 header --//
-    IPH_VHLTOS_SET(&frame.ip, 4, 5, 0);
+    IPH_VHLTOS_SET(&frame.ip, 4, 5, (qos & USRP2_STREAM_QOS_DSCP_MASK) << 2);
     IPH_LEN_SET(&frame.ip, 0);
     IPH_ID_SET(&frame.ip, 0);
     IPH_OFFSET_SET(&frame.ip, IP_DF); // don't fragment
@@ -159,6 +170,61 @@ void setup_framer(
 
     //copy into the framer table registers
     memcpy_wa((void *)(sr_proto_framer_regs->table[which].entry + 1), &frame, sizeof(frame));
+    sr_proto_framer_regs->table[which].entry[13] = vlan_tag;
+}
+
+/***********************************************************************
+ * Framer destinations other than the stream host
+ **********************************************************************/
+static struct {
+    bool pending;
+    struct socket_address dst;
+    struct socket_address src;
+    uint32_t qos;
+} framer_arp_wait[8]; //framer table entries waiting for the mac of their destination
+
+static void send_arp_request(const struct ip_addr *ip);
+
+void setup_framer_to(
+    struct socket_address sock_dst,
+    struct socket_address sock_src,
+    size_t which,
+    uint32_t qos
+){
+    eth_mac_addr_t mac;
+    framer_arp_wait[which].pending = false;
+
+    //IPv4 multicast: 01:00:5e and the low 23 bits of the group
+    if ((sock_dst.addr.addr >> 28) == 0xe){
+        mac.addr[0] = 0x01; mac.addr[1] = 0x00; mac.addr[2] = 0x5e;
+        mac.addr[3] = (sock_dst.addr.addr >> 16) & 0x7f;
+        mac.addr[4] = (sock_dst.addr.addr >> 8) & 0xff;
+        mac.addr[5] = (sock_dst.addr.addr >> 0) & 0xff;
+        setup_framer(mac, _local_mac_addr, sock_dst, sock_src, which, qos);
+        return;
+    }
+
+    if (arp_cache_lookup_mac(&sock_dst.addr, &mac)){
+        arp_cache_pin(&sock_dst.addr, &mac);
+        setup_framer(mac, _local_mac_addr, sock_dst, sock_src, which, qos);
+        return;
+    }
+
+    //the reply sets up the framer, see handle_arp_packet
+    framer_arp_wait[which].dst = sock_dst;
+    framer_arp_wait[which].src = sock_src;
+    framer_arp_wait[which].qos = qos;
+    framer_arp_wait[which].pending = true;
+    send_arp_request(&sock_dst.addr);
+}
+
+static void framer_arp_resolved(const struct ip_addr *ip, const eth_mac_addr_t *mac){
+    for (size_t i = 0; i < sizeof(framer_arp_wait)/sizeof(framer_arp_wait[0]); i++){
+        if (!framer_arp_wait[i].pending || framer_arp_wait[i].dst.addr.addr != ip->addr) continue;
+        framer_arp_wait[i].pending = false;
+        arp_cache_pin(ip, mac);
+        setup_framer(*mac, _local_mac_addr, framer_arp_wait[i].dst, framer_arp_wait[i].src, i, framer_arp_wait[i].qos);
+    }
 }
 
 /***********************************************************************
@@ -175,13 +241,15 @@ void setup_framer(
  * \param len1 length of second part of data
  * \param buf2 third part of data
  * \param len2 length of third part of data
+ * \param chksum checksums for the FPGA to fill in
  */
 static void
 send_pkt(
     eth_mac_addr_t dst, int ethertype,
     const void *buf0, size_t len0,
     const void *buf1, size_t len1,
-    const void *buf2, size_t len2
+    const void *buf2, size_t len2,
+    int chksum
 ){
 
     //control word for framed data
@@ -217,7 +285,7 @@ send_pkt(
     //ensure that minimum length requirements are met
     if (total_len < 64) total_len = 64; //60 + ctrl word
 
-    pkt_ctrl_commit_outgoing_buffer(total_len/sizeof(uint32_t));
+    pkt_ctrl_commit_outgoing_buffer(total_len/sizeof(uint32_t), chksum);
     if (debug) printf("sent %d bytes\n", (int)total_len);
 }
 
@@ -237,7 +305,13 @@ send_ip_pkt(struct ip_addr dst, int protocol,
   ip.src = _local_ip_addr;
   ip.dest = dst;
 
-  IPH_CHKSUM_SET(&ip, ~chksum_buffer(
+  //the FPGA sums the frame on the way out, the UDP checksum comes with it
+  int chksum = 0;
+  if (pkt_ctrl_has_chksum()){
+    chksum = PKT_CTRL_CHKSUM_IP;
+    if (protocol == IP_PROTO_UDP) chksum |= PKT_CTRL_CHKSUM_UDP;
+  }
+  else IPH_CHKSUM_SET(&ip, ~chksum_buffer(
     (unsigned short *) &ip, sizeof(ip)/sizeof(short), 0
   ));
 
@@ -251,7 +325,7 @@ send_ip_pkt(struct ip_addr dst, int protocol,
   }
 
   send_pkt(dst_mac, ETHERTYPE_IPV4,
-	   &ip, sizeof(ip), buf0, len0, buf1, len1);
+	   &ip, sizeof(ip), buf0, len0, buf1, len1, chksum);
 }
 
 void 
@@ -371,10 +445,10 @@ send_arp_reply(struct arp_eth_ipv4 *req, eth_mac_addr_t our_mac)
 
   eth_mac_addr_t t;
   memcpy(t.addr, reply.ar_tha, 6);
-  send_pkt(t, ETHERTYPE_ARP, &reply, sizeof(reply), 0, 0, 0, 0);
+  send_pkt(t, ETHERTYPE_ARP, &reply, sizeof(reply), 0, 0, 0, 0, 0);
 }
 
-void send_gratuitous_arp(void){
+static void send_arp_request(const struct ip_addr *ip){
   struct arp_eth_ipv4 req _AL4;
   req.ar_hrd = ARPHRD_ETHER;
   req.ar_pro = ETHERTYPE_IPV4;
@@ -384,10 +458,14 @@ void send_gratuitous_arp(void){
   memcpy(req.ar_sha, ethernet_mac_addr(), sizeof(eth_mac_addr_t));
   memcpy(req.ar_sip, get_ip_addr(),       sizeof(struct ip_addr));
   memset(req.ar_tha, 0x00,                sizeof(eth_mac_addr_t));
-  memcpy(req.ar_tip, get_ip_addr(),       sizeof(struct ip_addr));
+  memcpy(req.ar_tip, ip,                  sizeof(struct ip_addr));
 
   //send the request with a broadcast ethernet mac address
-  send_pkt(BCAST_MAC_ADDR, ETHERTYPE_ARP, &req, sizeof(req), 0, 0, 0, 0);
+  send_pkt(BCAST_MAC_ADDR, ETHERTYPE_ARP, &req, sizeof(req), 0, 0, 0, 0, 0);
+}
+
+void send_gratuitous_arp(void){
+  send_arp_request(get_ip_addr());
 }
 
 static void
@@ -416,15 +494,21 @@ handle_arp_packet(struct arp_eth_ipv4 *p, size_t size)
       || p->ar_pln != 4)
     return;
   
-  if (p->ar_op != ARPOP_REQUEST)
-    return;
-
   struct ip_addr sip;
   struct ip_addr tip;
 
   sip.addr = get_int32(p->ar_sip);
   tip.addr = get_int32(p->ar_tip);
 
+  // a host that moved (or announced itself) keeps its entry current
+  eth_mac_addr_t sha;
+  memcpy(sha.addr, p->ar_sha, sizeof(sha));
+  arp_cache_refresh(&sip, &sha);
+  framer_arp_resolved(&sip, &sha);
+
+  if (p->ar_op != ARPOP_REQUEST)
+    return;
+
   if (memcmp(&tip, &_local_ip_addr, sizeof(_local_ip_addr)) == 0){	// They're looking for us...
     send_arp_reply(p, _local_mac_addr);
   }
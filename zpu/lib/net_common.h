@@ -30,13 +30,32 @@
  * \param sock_dst udp/ip socket destination
  * \param sock_src udp/ip socket source
  * \param which the index into the table
+ * \param qos USRP2_STREAM_QOS_* word: the 802.1Q tag and IP DSCP
  */
 void setup_framer(
     eth_mac_addr_t eth_dst,
     eth_mac_addr_t eth_src,
     struct socket_address sock_dst,
     struct socket_address sock_src,
-    size_t which
+    size_t which,
+    uint32_t qos
+);
+
+/*!
+ * Setup an entry in the protocol framer for a destination other than the
+ * host that asked for it: a multicast group or a host on the same subnet.
+ * The entry is set up once the ARP reply of a unicast host comes in.
+ *
+ * \param sock_dst udp/ip socket destination
+ * \param sock_src udp/ip socket source
+ * \param which the index into the table
+ * \param qos USRP2_STREAM_QOS_* word: the 802.1Q tag and IP DSCP
+ */
+void setup_framer_to(
+    struct socket_address sock_dst,
+    struct socket_address sock_src,
+    size_t which,
+    uint32_t qos
 );
 
 typedef void (*udp_receiver_t)(struct socket_address src, struct socket_address dst,
@@ -28,6 +28,7 @@
 #define CPU_STAT_WR_DONE (1 << 4)
 #define CPU_STAT_WR_EROR (1 << 5)
 #define CPU_STAT_WR_IDLE (1 << 6)
+#define CPU_STAT_WR_CHKSUM (1 << 7)
 
 //control signals from WB into PR
 #define CPU_CTRL_RD_CLEAR (1 << 0)
@@ -82,9 +83,14 @@ void *pkt_ctrl_claim_outgoing_buffer(void){
     return ((uint32_t *) ROUTER_RAM_BASE);
 }
 
-void pkt_ctrl_commit_outgoing_buffer(size_t num_lines){
+bool pkt_ctrl_has_chksum(void){
+    return (router_status->status & CPU_STAT_WR_CHKSUM) != 0;
+}
+
+void pkt_ctrl_commit_outgoing_buffer(size_t num_lines, int chksum){
     //start a new write with the given length
-    router_ctrl->iface_ctrl = ((num_lines & 0xffff) << 16) | CPU_CTRL_WR_START;
+    router_ctrl->iface_ctrl = ((num_lines & 0xffff) << 16) | CPU_CTRL_WR_START
+        | (chksum & (PKT_CTRL_CHKSUM_IP | PKT_CTRL_CHKSUM_UDP));
     //wait for the write to become done
     cpu_stat_wait_for(CPU_STAT_WR_DONE);
     router_ctrl->iface_ctrl = CPU_CTRL_WR_CLEAR;
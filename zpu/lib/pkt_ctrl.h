@@ -46,10 +46,18 @@ void pkt_ctrl_release_incoming_buffer(void);
  */
 void *pkt_ctrl_claim_outgoing_buffer(void);
 
+//! Checksums the FPGA fills in when it sends an outgoing IPv4 frame
+#define PKT_CTRL_CHKSUM_IP  (1 << 4) //the IP header
+#define PKT_CTRL_CHKSUM_UDP (1 << 5) //the UDP header, after a 20 byte IP header
+
+//! Does the FPGA fill in the checksums, see pkt_ctrl_commit_outgoing_buffer
+bool pkt_ctrl_has_chksum(void);
+
 /*!
  * Commit the outgoing buffer.
  * \param num_lines how many lines written.
+ * \param chksum PKT_CTRL_CHKSUM_* flags, 0 without pkt_ctrl_has_chksum
  */
-void pkt_ctrl_commit_outgoing_buffer(size_t num_lines);
+void pkt_ctrl_commit_outgoing_buffer(size_t num_lines, int chksum);
 
 #endif /* INCLUDED_PKT_CTRL_H */
@@ -21,24 +21,17 @@
 #endif
 
 #include "print_rmon_regs.h"
-#include "eth_mac.h"
+#include "memory_map.h"
 #include "nonstdio.h"
 
+// simple_gemac has no RMON block, these are its frame counters
 void
 print_rmon_regs(void)
 {
-  int i;
-  for (i=0; i <= 0x10; i++){
-    putstr("RMON[0x");
-    puthex8(i);
-    putstr("] = ");
-    printf("%d\n", eth_mac_read_rmon(i));
-  }
-
-  for (i=0x20; i <= 0x30; i++){
-    putstr("RMON[0x");
-    puthex8(i);
-    putstr("] = ");
-    printf("%d\n", eth_mac_read_rmon(i));
-  }
+  printf("rx_frames   = %d\n", eth_mac->rx_frames);
+  printf("rx_errors   = %d\n", eth_mac->rx_errors);
+  printf("rx_overruns = %d\n", eth_mac->rx_overruns);
+  printf("tx_frames   = %d\n", eth_mac->tx_frames);
+  printf("pause_rcvd  = %d\n", eth_mac->pause_rcvd);
+  printf("pause_sent  = %d\n", eth_mac->pause_sent);
 }
@@ -48,6 +48,15 @@ typedef enum {
   USRP2_FW_UPDATE_ID_I_CAN_HAS_HW_REV_LOL = 'v',
   USRP2_FW_UPDATE_ID_HERES_TEH_HW_REV_OMG = 'V',
 
+  //windowed write: blocks in address order from the last erase start,
+  //the reply acks every block below flash_addr
+  USRP2_FW_UPDATE_ID_STREAM_TEH_FLASHES_LOL = 'p',
+  USRP2_FW_UPDATE_ID_STREAMED_TEH_FLASHES_OMG = 'P',
+
+  //crc32 (zlib) of a flash range, for verify without the read back
+  USRP2_FW_UPDATE_ID_CRC_TEH_FLASHES_LOL = 'c',
+  USRP2_FW_UPDATE_ID_HERES_TEH_CRC_OMG = 'C',
+
   USRP2_FW_UPDATE_ID_KTHXBAI = '~'
 
 } usrp2_fw_update_id_t;
@@ -68,6 +77,11 @@ typedef struct {
       uint32_t sector_size_bytes;
       uint32_t memory_size_bytes;
     } flash_info_args;
+    struct {
+      uint32_t flash_addr;
+      uint32_t length;
+      uint32_t crc;
+    } crc_args;
   } data;
 } usrp2_fw_update_data_t;
 
@@ -38,6 +38,7 @@ static const size_t num_idle_cyc_b4_flush = 250; //small but lucky number
  **********************************************************************/
 static uint16_t _base_port;
 static int8_t _storage_map[MAX_NUM_UARTS];
+static void (*_rx_hooks[MAX_NUM_UARTS])(int ch);
 
 #ifdef BOOTLOADER
 #define UART_BUF_SZ 16
@@ -108,6 +109,14 @@ void udp_uart_init(const uint16_t base_port){
     }
 }
 
+/***********************************************************************
+ * Public hook function
+ **********************************************************************/
+void udp_uart_set_rx_hook(const int uart, void (*hook)(int ch)){
+    if (uart < 0 || uart >= MAX_NUM_UARTS) return;
+    _rx_hooks[uart] = hook;
+}
+
 /***********************************************************************
  * Public poll function
  **********************************************************************/
@@ -124,6 +133,7 @@ void udp_uart_poll(void){
             int ret = hal_uart_getc_noblock((hal_uart_name_t)i);
             if (ret == -1) break;
             char ch = (char) ret;
+            if (_rx_hooks[i] != NULL) _rx_hooks[i](ret);
             if (ch == '\n' || ch == '\r') newline = true;
             state->buf[j] = ch;
             state->len++;
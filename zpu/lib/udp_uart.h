@@ -33,4 +33,12 @@ void udp_uart_init(const uint16_t base_port);
  */
 void udp_uart_poll(void);
 
+/*!
+ * Set a hook called with each character received on a UART,
+ * the characters are still sent over UDP. NULL removes it.
+ * \param uart the UART number
+ * \param hook the function to call per character
+ */
+void udp_uart_set_rx_hook(const int uart, void (*hook)(int ch));
+
 #endif /* INCLUDED_UDP_UART_H */
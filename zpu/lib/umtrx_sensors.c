@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 Fairwaves LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "umtrx_sensors.h"
+#include "i2c.h"
+#include "usrp2/fw_common.h"
+#include <stdbool.h>
+
+//I2C addresses, same as the host side drivers
+#define TMP102_ADDR_A     0x4A
+#define TMP102_ADDR_B     0x4B
+#define ADS1015_ADDR_PWR  0x49
+#define ADS1015_ADDR_DC   0x48
+
+#define SENSOR_REG_TEMP       0 //TMP102
+#define SENSOR_REG_CONVERSION 0 //ADS1015
+#define SENSOR_REG_CONFIG     1 //ADS1015
+
+#define ADS1015_CONF_OS       (1 << 15)
+#define ADS1015_CONF_MUX_OFFS 12
+#define ADS1015_CONF_MUX_MASK (0x7 << ADS1015_CONF_MUX_OFFS)
+#define ADS1015_CONF_MODE     (1 << 8)
+#define ADS1015_CONF_AIN0_GND 4
+#define ADS1015_POLL_RDY_WATCHDOG 1000
+
+static bool sensor_get_reg(uint8_t addr, uint8_t reg, uint16_t *value)
+{
+    unsigned char buf[2];
+    if (!i2c_write(addr, &reg, 1)) return false;
+    if (!i2c_read(addr, buf, 2)) return false;
+    *value = ((uint16_t)buf[0] << 8) | buf[1];
+    return true;
+}
+
+static bool sensor_set_reg(uint8_t addr, uint8_t reg, uint16_t value)
+{
+    unsigned char buf[3] = {reg, value >> 8, value & 0xFF};
+    return i2c_write(addr, buf, 3);
+}
+
+static bool ads1015_sample(uint8_t addr, uint16_t config, int input, uint16_t *value)
+{
+    config = (config & ~ADS1015_CONF_MUX_MASK) |
+             ((ADS1015_CONF_AIN0_GND + input) << ADS1015_CONF_MUX_OFFS);
+
+    if (config & ADS1015_CONF_MODE) {
+        // Power-down mode, start conversion and wait for it
+        if (!sensor_set_reg(addr, SENSOR_REG_CONFIG, config | ADS1015_CONF_OS)) return false;
+        int i;
+        for (i = 0; i < ADS1015_POLL_RDY_WATCHDOG; i++) {
+            uint16_t status;
+            if (!sensor_get_reg(addr, SENSOR_REG_CONFIG, &status)) return false;
+            if (status & ADS1015_CONF_OS) break;
+        }
+        if (i == ADS1015_POLL_RDY_WATCHDOG) return false;
+    } else {
+        if (!sensor_set_reg(addr, SENSOR_REG_CONFIG, config)) return false;
+    }
+
+    return sensor_get_reg(addr, SENSOR_REG_CONVERSION, value);
+}
+
+uint16_t umtrx_sensors_snapshot(uint16_t mask, uint16_t pwr_config, uint16_t dc_config, uint16_t *values)
+{
+    uint16_t sampled = 0;
+    int i;
+
+    // The temperature sensors run in continuous conversion mode
+    if ((mask & (1 << UMTRX_SENSORS_TEMP_A)) &&
+        sensor_get_reg(TMP102_ADDR_A, SENSOR_REG_TEMP, &values[UMTRX_SENSORS_TEMP_A]))
+        sampled |= 1 << UMTRX_SENSORS_TEMP_A;
+    if ((mask & (1 << UMTRX_SENSORS_TEMP_B)) &&
+        sensor_get_reg(TMP102_ADDR_B, SENSOR_REG_TEMP, &values[UMTRX_SENSORS_TEMP_B]))
+        sampled |= 1 << UMTRX_SENSORS_TEMP_B;
+
+    for (i = 0; i < 4; i++) {
+        const int pwr = UMTRX_SENSORS_PWR_0 + i;
+        const int dc = UMTRX_SENSORS_DC_0 + i;
+        if ((mask & (1 << pwr)) && ads1015_sample(ADS1015_ADDR_PWR, pwr_config, i, &values[pwr]))
+            sampled |= 1 << pwr;
+        if ((mask & (1 << dc)) && ads1015_sample(ADS1015_ADDR_DC, dc_config, i, &values[dc]))
+            sampled |= 1 << dc;
+    }
+
+    return sampled;
+}
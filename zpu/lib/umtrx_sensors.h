@@ -0,0 +1,31 @@
+/*
+ * Copyright 2026 Fairwaves LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_UMTRX_SENSORS_H
+#define INCLUDED_UMTRX_SENSORS_H
+
+#include "stdint.h"
+
+/*
+ * Sample the board sensors selected by mask (UMTRX_SENSORS_* bits) in one go.
+ * The ADCs are programmed from the given config registers, only the input
+ * mux is changed. Raw register values are stored in values[].
+ * Returns the mask of the sensors that answered.
+ */
+uint16_t umtrx_sensors_snapshot(uint16_t mask, uint16_t pwr_config, uint16_t dc_config, uint16_t *values);
+
+#endif /* INCLUDED_UMTRX_SENSORS_H */
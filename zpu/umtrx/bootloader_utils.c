@@ -76,7 +76,7 @@ void do_the_bootload_thing(void) {
 		if(is_valid_fpga_image(PROD_FPGA_IMAGE_LOCATION_ADDR)) {
 			puts("Valid production FPGA image found, booting..");
 			set_safe_booted_flag(1);
-			mdelay(300); //so serial output can finish
+			mdelay(20); //so serial output can finish, 230 chars at 115200
 #ifdef SPARTAN6
 			icap_s6_reload_fpga(PROD_FPGA_IMAGE_LOCATION_ADDR, SAFE_FPGA_IMAGE_LOCATION_ADDR);
 #else
@@ -90,7 +90,7 @@ void do_the_bootload_thing(void) {
 		puts("Valid production firmware found. Loading...");
 		spi_flash_read(PROD_FW_IMAGE_LOCATION_ADDR, FW_IMAGE_SIZE_BYTES, (void *)RAM_BASE);
 		puts("Starting image...");
-		mdelay(300);
+		mdelay(20);
 		start_program();
 		puts("ERROR: Return from main!");
 		//if this happens, though, the safest thing to do is reboot the whole FPGA and start over.
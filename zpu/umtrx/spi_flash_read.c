@@ -105,13 +105,23 @@ spi_flash_read(uint32_t flash_addr,  size_t nbytes, void *buf)
     spif_regs->ctrl = FLAGS | LEN(16 * 8) | SPI_CTRL_GO_BSY;
     spif_wait();
 
+    m = min(nbytes - n, 16);
+    if (m == 16 && ((uint32_t) dst & 3) == 0){	// whole words straight out, the firmware load path
+      uint32_t *wdst = (uint32_t *) dst;
+      wdst[0] = spif_regs->txrx3;	// txrx3 has first bits in it
+      wdst[1] = spif_regs->txrx2;
+      wdst[2] = spif_regs->txrx1;
+      wdst[3] = spif_regs->txrx0;
+      dst += 16;
+      continue;
+    }
+
     uint32_t w[4];
     w[0] = spif_regs->txrx3;	// txrx3 has first bits in it
     w[1] = spif_regs->txrx2;
     w[2] = spif_regs->txrx1;
     w[3] = spif_regs->txrx0;
     unsigned char *src = (unsigned char *) &w[0];
-    m = min(nbytes - n, 16);
     for (size_t i = 0; i < m; i++)
       *(dst++) = src[i];
   }
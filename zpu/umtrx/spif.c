@@ -33,7 +33,7 @@ spif_init(void)
   /*
    * f_sclk = f_wb / ((div + 1) * 2)
    */
-  spif_regs->div = 1;  // 0 = Div by 2 (31.25 MHz); 1 = Div-by-4 (15.625 MHz)
+  spif_regs->div = 0;  // 0 = Div by 2 (31.25 MHz); 1 = Div-by-4 (15.625 MHz), reads use FAST_READ (50 MHz max)
 
   // run dummy transaction to work around invalid initial clock state
   spif_transact(SPI_TXONLY, 0, 0, 8, SPIF_PUSH_FALL | SPIF_LATCH_RISE);
@@ -46,6 +46,30 @@ uint16_t get_hw_rev(void) {
 
 spi_flash_async_state_t spi_flash_async_state;
 
+//next address of the windowed write, set by the erase start
+static uint32_t stream_next_addr;
+
+static uint32_t flash_crc32(uint32_t flash_addr, size_t nbytes) {
+  static const uint32_t nibble_table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+  };
+  uint8_t buf[SPI_FLASH_PAGE_SIZE];
+  uint32_t crc = 0xffffffff;
+  while (nbytes > 0) {
+    const size_t n = (nbytes < sizeof(buf))? nbytes : sizeof(buf);
+    spi_flash_read(flash_addr, n, buf);
+    for (size_t i = 0; i < n; i++) {
+      crc ^= buf[i];
+      crc = (crc >> 4) ^ nibble_table[crc & 0xf];
+      crc = (crc >> 4) ^ nibble_table[crc & 0xf];
+    }
+    flash_addr += n;
+    nbytes -= n;
+  }
+  return ~crc;
+}
+
 //Firmware update packet handler
 void handle_udp_fw_update_packet(struct socket_address src, struct socket_address dst,
                                  unsigned char *payload, int payload_len) {
@@ -90,6 +114,7 @@ void handle_udp_fw_update_packet(struct socket_address src, struct socket_addres
 
   case USRP2_FW_UPDATE_ID_ERASE_TEH_FLASHES_LOL: //out with the old
     spi_flash_async_erase_start(&spi_flash_async_state, update_data_in->data.flash_args.flash_addr, update_data_in->data.flash_args.length);
+    stream_next_addr = update_data_in->data.flash_args.flash_addr;
     update_data_out.id = USRP2_FW_UPDATE_ID_ERASING_TEH_FLASHES_OMG;
     break;
 
@@ -107,7 +132,27 @@ void handle_udp_fw_update_packet(struct socket_address src, struct socket_addres
     update_data_out.id = USRP2_FW_UPDATE_ID_WROTE_TEH_FLASHES_OMG;
     break;
 
+  case USRP2_FW_UPDATE_ID_STREAM_TEH_FLASHES_LOL:
+    //one page per block, the program runs while the next block comes in.
+    //out of order blocks are dropped and the host resends from the ack
+    if (update_data_in->data.flash_args.flash_addr == stream_next_addr &&
+        spi_flash_page_program_start(stream_next_addr, update_data_in->data.flash_args.length, update_data_in->data.flash_args.data)) {
+      stream_next_addr += update_data_in->data.flash_args.length;
+    }
+    update_data_out.data.flash_args.flash_addr = stream_next_addr;
+    update_data_out.id = USRP2_FW_UPDATE_ID_STREAMED_TEH_FLASHES_OMG;
+    break;
+
+  case USRP2_FW_UPDATE_ID_CRC_TEH_FLASHES_LOL:
+    spi_flash_wait(); //the last streamed page
+    update_data_out.data.crc_args.flash_addr = update_data_in->data.crc_args.flash_addr;
+    update_data_out.data.crc_args.length = update_data_in->data.crc_args.length;
+    update_data_out.data.crc_args.crc = flash_crc32(update_data_in->data.crc_args.flash_addr, update_data_in->data.crc_args.length);
+    update_data_out.id = USRP2_FW_UPDATE_ID_HERES_TEH_CRC_OMG;
+    break;
+
   case USRP2_FW_UPDATE_ID_READ_TEH_FLASHES_LOL: //for verify
+    spi_flash_wait(); //the last streamed page
     spi_flash_read(update_data_in->data.flash_args.flash_addr,  update_data_in->data.flash_args.length, update_data_out.data.flash_args.data);
     update_data_out.id = USRP2_FW_UPDATE_ID_KK_READ_TEH_FLASHES_OMG;
     break;
@@ -53,7 +53,7 @@ static inline void
 wr_icap(uint16_t x)
 {
     icap_regs->icap = swap16(x);
-    mdelay(10);
+    mdelay(1); //the icap fifo is 16 deep and drains at 6.5 MHz, this is plenty
 }
 
 static inline uint16_t